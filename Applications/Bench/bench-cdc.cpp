@@ -0,0 +1,371 @@
+/**
+ *******************************************************************************
+ * @file    bench-cdc.cpp
+ * @brief   the USB CDC link benchmark, device side
+ *******************************************************************************
+ * @attention
+ *
+ * The task sleeps on a thread flag raised by the CDC receive interrupt, so an
+ * echo is sent back without waiting for a tick: the measured round trip is
+ * the one of the USB link, not the one of the scheduler.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * See bench-intf.h for the protocol.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/4
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define BENCH_PORT          CDC_PORT_DATA
+#define BENCH_CHUNK         512U
+#define BENCH_FLAG_RX       0x0001U
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "bench-intf.h"
+#include "../app-intf.h"
+#include "../Update/update-intf.h"
+#include "cmsis_os.h"
+#include "stm32h7xx_hal.h"
+#include "usbd_cdc_if.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static osThreadId_t s_bench_task;
+
+static const osThreadAttr_t s_bench_attr = {
+    .name       = "bench",
+    .stack_size = 1536,
+    .priority   = (osPriority_t)osPriorityBelowNormal,
+};
+
+static uint8_t s_rx[BENCH_CHUNK];
+static uint32_t s_rx_len = 0;
+static uint32_t s_rx_pos = 0;
+static uint32_t s_tx[BENCH_CHUNK / 4U];
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief CDC receive hook, runs in the USB interrupt
+ */
+static void bench_rx_notify(uint8_t port)
+{
+    (void)port;
+    (void)osThreadFlagsSet(s_bench_task, BENCH_FLAG_RX);
+}
+
+
+/**
+ * @brief make sure received bytes are buffered
+ * @param timeout ticks to wait for the host
+ * @return number of buffered bytes, 0 on timeout
+ */
+static uint32_t bench_fill(uint32_t timeout)
+{
+    if (s_rx_pos < s_rx_len)
+    {
+        return s_rx_len - s_rx_pos;
+    }
+    for (;;)
+    {
+        const uint32_t n = CDC_Read_HS(BENCH_PORT, s_rx, sizeof(s_rx));
+        if (n != 0U)
+        {
+            s_rx_pos = 0;
+            s_rx_len = n;
+            return n;
+        }
+        /* a flag raised after the read above makes this return at once */
+        if ((osThreadFlagsWait(BENCH_FLAG_RX, osFlagsWaitAny, timeout) & osFlagsError) != 0U)
+        {
+            return 0;
+        }
+    }
+}
+
+
+/**
+ * @brief queue bytes for the host, waiting for room in the transmit ring
+ * @note  never waits for a host that closed the port, or stopped reading for
+ *        BENCH_IDLE_MS: the port parks the rest, or counts it as dropped
+ */
+static void bench_send(const void *buf, uint32_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(buf);
+    uint32_t t0      = HAL_GetTick();
+    while (len != 0U)
+    {
+        uint32_t room = CDC_TxFree_HS(BENCH_PORT);
+        if (CDC_HostOpen_HS(BENCH_PORT) == 0U or (HAL_GetTick() - t0) >= BENCH_IDLE_MS)
+        {
+            (void)CDC_Write_HS(BENCH_PORT, p, len);
+            return;
+        }
+        if (room == 0U)
+        {
+            osDelay(1);
+            continue;
+        }
+        room = room < len ? room : len;
+        room = CDC_Write_HS(BENCH_PORT, p, room);
+        p += room;
+        len -= room;
+        t0 = HAL_GetTick();
+    }
+}
+
+
+/**
+ * @brief send one status line
+ */
+static void bench_reply(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void bench_reply(const char *fmt, ...)
+{
+    char line[BENCH_LINE_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(line, sizeof(line) - 2U, fmt, ap);
+    va_end(ap);
+    if (n < 0)
+    {
+        return;
+    }
+    n = n < static_cast<int>(sizeof(line) - 2U) ? n : static_cast<int>(sizeof(line) - 3U);
+    line[n++] = '\r';
+    line[n++] = '\n';
+    bench_send(line, static_cast<uint32_t>(n));
+}
+
+
+/**
+ * @brief read one command line, '\r' is ignored
+ * @return false when the line was too long (it is discarded)
+ */
+static bool bench_read_line(char *line)
+{
+    uint32_t n    = 0;
+    bool overflow = false;
+    for (;;)
+    {
+        (void)bench_fill(osWaitForever);
+        while (s_rx_pos < s_rx_len)
+        {
+            const char c = static_cast<char>(s_rx[s_rx_pos++]);
+            if (c == '\n')
+            {
+                line[n] = '\0';
+                return not overflow;
+            }
+            if (c == '\r')
+            {
+                continue;
+            }
+            if (n < BENCH_LINE_MAX - 1U)
+            {
+                line[n++] = c;
+            }
+            else
+            {
+                overflow = true;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief device to host stream of a 32-bit counter
+ */
+static void bench_tx(uint32_t bytes)
+{
+    const uint32_t t0 = HAL_GetTick();
+    uint32_t seq      = 0;
+    uint32_t left     = bytes & ~3U;
+    while (left != 0U)
+    {
+        const uint32_t n = left < sizeof(s_tx) ? left : sizeof(s_tx);
+        for (uint32_t i = 0; i < n / 4U; i++)
+        {
+            s_tx[i] = seq++;
+        }
+        bench_send(s_tx, n);
+        left -= n;
+    }
+    bench_reply("ok tx %lu %lu", static_cast<unsigned long>(bytes & ~3U),
+                static_cast<unsigned long>(HAL_GetTick() - t0));
+}
+
+
+/**
+ * @brief host to device sink
+ */
+static void bench_rx(uint32_t bytes)
+{
+    uint32_t t0   = 0;
+    uint32_t left = bytes;
+    while (left != 0U)
+    {
+        const uint32_t n = bench_fill(BENCH_IDLE_MS);
+        if (n == 0U)
+        {
+            bench_reply("err timeout rx %lu", static_cast<unsigned long>(bytes - left));
+            return;
+        }
+        if (left == bytes)
+        {
+            t0 = HAL_GetTick(); // from the first byte, the host owns the latency
+        }
+        const uint32_t take = n < left ? n : left;
+        s_rx_pos += take;
+        left -= take;
+    }
+    bench_reply("ok rx %lu %lu", static_cast<unsigned long>(bytes), static_cast<unsigned long>(HAL_GetTick() - t0));
+}
+
+
+/**
+ * @brief send back every byte of `count` frames of `size` bytes
+ */
+static void bench_echo(uint32_t count, uint32_t size)
+{
+    uint64_t left = static_cast<uint64_t>(count) * size;
+    while (left != 0U)
+    {
+        const uint32_t n = bench_fill(BENCH_IDLE_MS);
+        if (n == 0U)
+        {
+            bench_reply("err timeout echo");
+            return;
+        }
+        const uint32_t take = n < left ? n : static_cast<uint32_t>(left);
+        bench_send(&s_rx[s_rx_pos], take);
+        s_rx_pos += take;
+        left -= take;
+    }
+    bench_reply("ok echo %lu", static_cast<unsigned long>(count));
+}
+
+
+/**
+ * @brief update link read: bytes left over by the command line first
+ */
+static uint32_t bench_link_read(uint8_t *buf, uint32_t len, uint32_t timeout)
+{
+    const uint32_t n    = bench_fill(timeout);
+    const uint32_t take = n < len ? n : len;
+    memcpy(buf, &s_rx[s_rx_pos], take);
+    s_rx_pos += take;
+    return take;
+}
+
+
+/**
+ * @brief receive a firmware image, boot it when it checks
+ */
+static void bench_update(uint32_t size, uint32_t crc)
+{
+    static const UpdateLinkTypeDef link = {bench_link_read, bench_send};
+
+    if (update_receive(&link, size, crc) != 0)
+    {
+        return;
+    }
+
+    // let the DONE reply leave before the USB goes down with the reset
+    const uint32_t t0 = HAL_GetTick();
+    while (CDC_TxFree_HS(BENCH_PORT) < APP_DATA_TX_SIZE and (HAL_GetTick() - t0) < BENCH_IDLE_MS)
+    {
+        osDelay(1);
+    }
+    osDelay(10);
+    update_apply();
+}
+
+
+/**
+ * @brief benchmark task: one command at a time
+ */
+static void bench_task(void *argument)
+{
+    (void)argument;
+    char line[BENCH_LINE_MAX];
+
+    CDC_SetRxNotify_HS(BENCH_PORT, bench_rx_notify);
+    for (;;)
+    {
+        if (not bench_read_line(line))
+        {
+            bench_reply("err line too long");
+            continue;
+        }
+
+        char *arg         = strchr(line, ' ');
+        const size_t verb = arg != nullptr ? static_cast<size_t>(arg - line) : strlen(line);
+        const uint32_t a  = arg != nullptr ? strtoul(arg, &arg, 0) : 0U;
+        const uint32_t b  = arg != nullptr ? strtoul(arg, &arg, 0) : 0U;
+
+        if (verb == 0U)
+        {
+            continue;
+        }
+        else if (verb == 5U and strncmp(line, "hello", 5) == 0)
+        {
+            bench_reply("bench %u", BENCH_PROTO_VERSION);
+        }
+        else if (verb == 2U and strncmp(line, "tx", 2) == 0)
+        {
+            bench_tx(a);
+        }
+        else if (verb == 2U and strncmp(line, "rx", 2) == 0)
+        {
+            bench_rx(a);
+        }
+        else if (verb == 4U and strncmp(line, "echo", 4) == 0 and a != 0U and b != 0U)
+        {
+            bench_echo(a, b);
+        }
+        else if (verb == 6U and strncmp(line, "update", 6) == 0)
+        {
+            bench_update(a, b);
+        }
+        else
+        {
+            bench_reply("err unknown command");
+        }
+    }
+}
+
+
+/**
+ * @brief create the benchmark task
+ */
+extern "C" void bench_init(void)
+{
+    s_bench_task = osThreadNew(bench_task, nullptr, &s_bench_attr);
+}
+
+APP_REGISTER(30, bench, bench_init);
@@ -0,0 +1,76 @@
+/**
+ *******************************************************************************
+ * @file    bench-intf.h
+ * @brief   the interface of the USB CDC link benchmark
+ *******************************************************************************
+ * @attention
+ *
+ * The benchmark owns the data CDC port (CDC_PORT_DATA): nothing else may read
+ * or write it while the benchmark task runs.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The host drives the benchmark with text command lines, every command ends
+ * with one status line from the device:
+ *
+ *   hello                  ->  "bench 1"
+ *   tx <bytes>             ->  <bytes> of little-endian uint32 counter
+ *                              (0, 1, 2, ...), then "ok tx <bytes> <ms>"
+ *   rx <bytes>             ->  the host sends <bytes> of any content,
+ *                              then "ok rx <bytes> <ms>"
+ *   echo <count> <size>    ->  every byte of <count> frames of <size> bytes
+ *                              is sent back as soon as it arrives,
+ *                              then "ok echo <count>"
+ *   update <bytes> <crc>   ->  firmware update, binary until DONE or FAIL
+ *                              (Applications/Update/fwu-proto.hpp), then
+ *                              the device boots the new image
+ *
+ * Errors are reported as "err <reason>". <ms> is measured on the device with
+ * the HAL tick. The host side is Tools/usb-bench/cdc-bench.c, and
+ * Tools/fwu/fwu-host.cpp for update.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/4
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define BENCH_PROTO_VERSION 1U
+#define BENCH_LINE_MAX      64U     // command line, terminator included
+#define BENCH_IDLE_MS       2000U   // rx / echo give up after this much silence
+
+
+
+
+/*-------- 3. function prototypes --------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief create the benchmark task on the data CDC port
+ */
+void bench_init(void);
+
+#ifdef __cplusplus
+}
+#endif
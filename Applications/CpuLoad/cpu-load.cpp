@@ -0,0 +1,202 @@
+/**
+ *******************************************************************************
+ * @file    cpu-load.cpp
+ * @brief   the CPU time accounting of the tasks and of the measured interrupts
+ *******************************************************************************
+ * @attention
+ *
+ * cpu_load_switch_in() runs in PendSV with the kernel interrupts masked,
+ * the measured interrupts are at or below configMAX_SYSCALL_INTERRUPT_PRIORITY:
+ * none of them lands inside it. The interrupts update the shared counters
+ * under a short PRIMASK section, a nested one cannot split an update.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * `stolen` counts every measured interrupt cycle since the start. A task's
+ * slice is the time since it was switched in less what `stolen` grew by
+ * meanwhile; an interrupt's own time is its length less what `stolen` grew
+ * by during it, the interrupts nested in it.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/17
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "cpu-load.h"
+#include "../../Drivers/Peripheral/DWT/dwt-cycle.h"
+#include "stm32h7xx_hal.h"
+
+
+
+
+/* ------- class prototypes---------------------------------------------------*/
+
+/**
+ * @brief what the switch hook touches, together for one base register
+ */
+struct CpuLoadState
+{
+    CpuLoadTaskTypeDef *running;
+    uint32_t stamp;         // the running task was switched in
+    uint32_t stolenAt;      // `stolen` at that time
+    uint32_t stolen;        // measured interrupt cycles, wrapping
+    uint32_t born;          // records given so far
+};
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static CpuLoadTaskTypeDef s_tasks[CPU_LOAD_TASKS];
+static CpuLoadTaskTypeDef s_other;
+static CpuLoadTaskTypeDef s_boot;   // main() before the scheduler, never shown
+static CpuLoadIsrTypeDef s_isr[CPU_ISR_NUM];
+
+static CpuLoadState s_state = {&s_boot, 0, 0, 0, 0};
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief a record for a task seen for the first time
+ */
+static CpuLoadTaskTypeDef *cpu_load_adopt(void *task, void **slot)
+{
+    CpuLoadTaskTypeDef *rec = &s_other;
+    for (CpuLoadTaskTypeDef &t : s_tasks)
+    {
+        if (t.task == nullptr)
+        {
+            t.task     = task;
+            t.born     = ++s_state.born;
+            t.switches = 0;
+            t.cycles   = 0;
+            rec        = &t;
+            break;
+        }
+    }
+    *slot = rec;
+    return rec;
+}
+
+
+/**
+ * @brief start the counter, the time before belongs to nobody
+ */
+extern "C" void cpu_load_start(void)
+{
+    dwt_cycle_init();
+    s_state.stamp    = dwt_cycle_now();
+    s_state.stolenAt = s_state.stolen;
+}
+
+
+/**
+ * @brief close the slice of the running task, open the one of `task`
+ */
+extern "C" void cpu_load_switch_in(void *task, void **slot)
+{
+    const uint32_t now    = dwt_cycle_now();
+    const uint32_t stolen = s_state.stolen;
+    s_state.running->cycles += now - s_state.stamp - (stolen - s_state.stolenAt);
+    s_state.stamp    = now;
+    s_state.stolenAt = stolen;
+
+    auto *next = static_cast<CpuLoadTaskTypeDef *>(*slot);
+    if (next == s_state.running)
+    {
+        return;
+    }
+    if (next == nullptr)
+    {
+        next = cpu_load_adopt(task, slot);
+    }
+    next->switches++;
+    s_state.running = next;
+}
+
+
+/**
+ * @brief free the record of a deleted task, kernel critical section
+ * @note  a task deleting itself still runs until the next switch, which
+ *        charges its last slice to the freed record, then adopts afresh
+ */
+extern "C" void cpu_load_task_delete(void *record)
+{
+    auto *rec = static_cast<CpuLoadTaskTypeDef *>(record);
+    if (rec != nullptr and rec != &s_other)
+    {
+        rec->task = nullptr;
+    }
+}
+
+
+/**
+ * @brief stamp the entry of an interrupt
+ */
+extern "C" void cpu_isr_enter(CpuIsrFrameTypeDef *frame)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    frame->stamp  = dwt_cycle_now();
+    frame->stolen = s_state.stolen;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief account the interrupt, less the ones nested in it
+ */
+extern "C" void cpu_isr_exit(const CpuIsrFrameTypeDef *frame, CpuIsrGroupEnum group)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t own = dwt_cycle_now() - frame->stamp - (s_state.stolen - frame->stolen);
+    s_state.stolen += own;
+    s_isr[group].calls++;
+    s_isr[group].cycles += own;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief copy the counters, as if the running task was switched out now
+ */
+extern "C" void cpu_load_snapshot(CpuLoadSnapshotTypeDef *snap)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t now = dwt_cycle_now();
+    for (uint32_t i = 0; i < CPU_LOAD_TASKS; i++)
+    {
+        snap->tasks[i] = s_tasks[i];
+    }
+    snap->other = s_other;
+    for (uint32_t i = 0; i < CPU_ISR_NUM; i++)
+    {
+        snap->isr[i] = s_isr[i];
+    }
+    const CpuLoadTaskTypeDef *running = s_state.running;
+    const uint64_t slice              = now - s_state.stamp - (s_state.stolen - s_state.stolenAt);
+    if (running == &s_other)
+    {
+        snap->other.cycles += slice;
+    }
+    else if (running != &s_boot)
+    {
+        snap->tasks[running - s_tasks].cycles += slice;
+    }
+    snap->stamp = now;
+    __set_PRIMASK(primask);
+}
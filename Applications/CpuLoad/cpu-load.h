@@ -0,0 +1,159 @@
+/**
+ *******************************************************************************
+ * @file    cpu-load.h
+ * @brief   the interface of the CPU time accounting: tasks and interrupt groups, in DWT cycles
+ *******************************************************************************
+ * @attention
+ *
+ * The kernel calls in through FreeRTOSConfig.h: cpu_load_start() when the
+ * scheduler starts, cpu_load_switch_in() after every task selection (PendSV,
+ * kernel critical section), cpu_load_task_delete() when a task goes away.
+ * The interrupts measured call cpu_isr_enter() and cpu_isr_exit() around
+ * their body; their time is taken out of the task they interrupted.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Each task owns a record of the table, found through its thread local
+ * storage pointer CPU_LOAD_TLS: a switch is one counter read, a 64-bit add
+ * on the task leaving and one increment on the task coming in.
+ *
+ *      |--- task A ---|usb|--- task A ---|PendSV|--- task B ---
+ *      stamp          enter exit          switch_in(B): A += slice - usb
+ *
+ * The counters only grow: `top` takes two snapshots and shows the
+ * differences, so the 32-bit DWT counter only has to be read at least once
+ * per wrap (7.8 s at 550 MHz), which every switch and every snapshot does.
+ *
+ * The kernel's own configGENERATE_RUN_TIME_STATS stays off: its 32-bit
+ * counters wrap after 7.8 s of CPU time at this clock and charge the
+ * interrupts to the task they land on.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/17
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define CPU_LOAD_TASKS      24U     // tasks with a record of their own, the others share one
+#define CPU_LOAD_TLS        0       // thread local storage index of the record, see FreeRTOSConfig.h
+
+
+
+
+/*-------- 3. typedef --------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief the interrupts measured, one counter each
+ */
+typedef enum
+{
+    CPU_ISR_USB = 0,        // OTG_HS
+    CPU_ISR_OS_TICK,        // SysTick, the kernel tick
+    CPU_ISR_HAL_TICK,       // TIM1, the HAL time base
+    CPU_ISR_NUM,
+} CpuIsrGroupEnum;
+
+/**
+ * @brief what an interrupt keeps on its stack between enter and exit
+ */
+typedef struct
+{
+    uint32_t stamp;
+    uint32_t stolen;        // interrupt cycles counted before, nested ones are taken out
+} CpuIsrFrameTypeDef;
+
+/**
+ * @brief the counters of one task
+ */
+typedef struct
+{
+    void *task;             // TaskHandle_t, NULL: a free record
+    uint32_t born;          // the record was given to this task at the born-th adoption
+    uint32_t switches;      // times switched in
+    uint64_t cycles;        // interrupts left out
+} CpuLoadTaskTypeDef;
+
+/**
+ * @brief the counters of one interrupt group
+ */
+typedef struct
+{
+    uint32_t calls;
+    uint64_t cycles;        // nested interrupts of other groups left out
+} CpuLoadIsrTypeDef;
+
+/**
+ * @brief every counter at one instant
+ */
+typedef struct
+{
+    CpuLoadTaskTypeDef tasks[CPU_LOAD_TASKS];
+    CpuLoadTaskTypeDef other;               // the tasks that found the table full
+    CpuLoadIsrTypeDef isr[CPU_ISR_NUM];
+    uint32_t stamp;                         // dwt_cycle_now() of the snapshot
+} CpuLoadSnapshotTypeDef;
+
+
+
+
+/*-------- 4. function prototypes --------------------------------------------*/
+
+/**
+ * @brief start the cycle counter and the accounting, from vTaskStartScheduler()
+ */
+void cpu_load_start(void);
+
+/**
+ * @brief the kernel selected `task` to run
+ * @param slot the task's thread local storage pointer CPU_LOAD_TLS
+ * @note  kernel context, a few dozen cycles
+ */
+void cpu_load_switch_in(void *task, void **slot);
+
+/**
+ * @brief a task is deleted, its record is free again
+ * @param record the task's thread local storage pointer CPU_LOAD_TLS
+ */
+void cpu_load_task_delete(void *record);
+
+/**
+ * @brief first thing of a measured interrupt
+ */
+void cpu_isr_enter(CpuIsrFrameTypeDef *frame);
+
+/**
+ * @brief last thing of a measured interrupt
+ */
+void cpu_isr_exit(const CpuIsrFrameTypeDef *frame, CpuIsrGroupEnum group);
+
+/**
+ * @brief copy every counter, the running task's slice included
+ * @note  masks the interrupts for the copy, about a microsecond
+ */
+void cpu_load_snapshot(CpuLoadSnapshotTypeDef *snap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,266 @@
+/**
+ *******************************************************************************
+ * @file    fast-path.cpp
+ * @brief   the real-time command fast path of the shell port
+ *******************************************************************************
+ * @attention
+ *
+ * The parser and the dispatch run in the USB interrupt only. Registration
+ * comes from tasks and rewrites a table entry under a short PRIMASK section,
+ * so the interrupt never sees half an entry.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Packets without 0xFE, the normal shell traffic, cost one memchr() while no
+ * frame is pending. Frame bytes are cut out of the packet by moving the text
+ * bytes down in place, the receive ring then sees plain text only.
+ *
+ * A frame with an unknown opcode or a length out of range is still consumed
+ * whole, so the stream stays in step with the host's framing.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/9
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "fast-path.h"
+#include "../../Drivers/Peripheral/DWT/dwt-cycle.h"
+#include "stm32h7xx_hal.h"
+#include <cstring>
+
+
+
+
+/* ------- class prototypes---------------------------------------------------*/
+
+/**
+ * @brief one opcode of the dispatch table
+ */
+struct FastPathEntry
+{
+    FastPathHandlerTypeDef handler;
+    void *ctx;
+    uint32_t budget;
+    uint8_t minLen;
+    uint8_t maxLen;
+    uint8_t strikes;    // consecutive overruns
+    FastPathStatsTypeDef stats;
+};
+
+/**
+ * @brief where the parser is in the byte stream
+ */
+enum class FastPathState : uint8_t
+{
+    TEXT,       // shell bytes, looking for FAST_PATH_SOF
+    OPCODE,
+    LENGTH,
+    PAYLOAD,
+};
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static FastPathEntry s_table[FAST_PATH_OPCODES];
+static FastPathStatsTypeDef s_unknown; // frames with an opcode beyond the table
+
+static uint32_t s_entry_stamp = 0;
+
+static FastPathState s_state = FastPathState::TEXT;
+static uint8_t s_opcode      = 0;
+static uint8_t s_len         = 0;
+static uint8_t s_have        = 0;
+static uint8_t s_payload[FAST_PATH_MAX_PAYLOAD];
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief register the handler of an opcode, replacing the previous one
+ */
+extern "C" int32_t fast_path_register(uint8_t opcode, FastPathHandlerTypeDef handler, void *ctx, uint8_t minLen,
+                                      uint8_t maxLen, uint32_t budget)
+{
+    if (opcode >= FAST_PATH_OPCODES or handler == nullptr or minLen > maxLen or maxLen > FAST_PATH_MAX_PAYLOAD or
+        budget == 0U or budget > FAST_PATH_MAX_BUDGET)
+    {
+        return -1;
+    }
+
+    dwt_cycle_init();
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    FastPathEntry &e = s_table[opcode];
+    e.handler        = handler;
+    e.ctx            = ctx;
+    e.budget         = budget;
+    e.minLen         = minLen;
+    e.maxLen         = maxLen;
+    e.strikes        = 0;
+    e.stats          = {};
+    e.stats.latencyMin = UINT32_MAX;
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+
+/**
+ * @brief remove the handler of an opcode
+ */
+extern "C" void fast_path_unregister(uint8_t opcode)
+{
+    if (opcode < FAST_PATH_OPCODES)
+    {
+        s_table[opcode].handler = nullptr; // a single word, the interrupt sees it or not
+    }
+}
+
+
+/**
+ * @brief stamp the USB interrupt entry
+ */
+extern "C" void fast_path_irq_entry(void)
+{
+    s_entry_stamp = dwt_cycle_now();
+}
+
+
+/**
+ * @brief call the handler of the complete frame and account for it
+ */
+static void fast_path_dispatch(uint8_t opcode, const uint8_t *payload, uint8_t len, bool fits)
+{
+    if (opcode >= FAST_PATH_OPCODES)
+    {
+        s_unknown.refused++;
+        return;
+    }
+
+    FastPathEntry &e                     = s_table[opcode];
+    const FastPathHandlerTypeDef handler = e.handler;
+    if (handler == nullptr or not fits or len < e.minLen or len > e.maxLen)
+    {
+        e.stats.refused++;
+        return;
+    }
+
+    const uint32_t t0 = dwt_cycle_now();
+    handler(payload, len, e.ctx);
+    const uint32_t t1 = dwt_cycle_now();
+
+    const uint32_t latency = t0 - s_entry_stamp;
+    const uint32_t cycles  = t1 - t0;
+    FastPathStatsTypeDef &st = e.stats;
+    st.calls++;
+    st.latencySum += latency;
+    st.latencyMin = latency < st.latencyMin ? latency : st.latencyMin;
+    st.latencyMax = latency > st.latencyMax ? latency : st.latencyMax;
+    st.cyclesMax  = cycles > st.cyclesMax ? cycles : st.cyclesMax;
+
+    if (cycles <= e.budget)
+    {
+        e.strikes = 0;
+        return;
+    }
+    st.overruns++;
+    if (++e.strikes >= FAST_PATH_STRIKES)
+    {
+        e.handler = nullptr; // out of budget too often, stop trusting it
+    }
+}
+
+
+/**
+ * @brief run the fast frames of a received packet and cut them out
+ */
+extern "C" uint32_t fast_path_filter(uint8_t *buf, uint32_t len)
+{
+    if (s_state == FastPathState::TEXT and memchr(buf, FAST_PATH_SOF, len) == nullptr)
+    {
+        return len;
+    }
+
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        const uint8_t b = buf[i];
+        switch (s_state)
+        {
+        case FastPathState::TEXT:
+            if (b == FAST_PATH_SOF)
+            {
+                s_state = FastPathState::OPCODE;
+            }
+            else
+            {
+                buf[out++] = b;
+            }
+            break;
+
+        case FastPathState::OPCODE:
+            s_opcode = b;
+            s_state  = FastPathState::LENGTH;
+            break;
+
+        case FastPathState::LENGTH:
+            s_len  = b;
+            s_have = 0;
+            if (s_len == 0U)
+            {
+                fast_path_dispatch(s_opcode, s_payload, 0U, true);
+                s_state = FastPathState::TEXT;
+            }
+            else
+            {
+                s_state = FastPathState::PAYLOAD;
+            }
+            break;
+
+        case FastPathState::PAYLOAD:
+            if (s_have < FAST_PATH_MAX_PAYLOAD)
+            {
+                s_payload[s_have] = b;
+            }
+            if (++s_have == s_len)
+            {
+                fast_path_dispatch(s_opcode, s_payload, s_len, s_len <= FAST_PATH_MAX_PAYLOAD);
+                s_state = FastPathState::TEXT;
+            }
+            break;
+        }
+    }
+    return out;
+}
+
+
+/**
+ * @brief snapshot of the counters of an opcode
+ * @note  an opcode beyond the table gives the frames no entry could take
+ */
+extern "C" void fast_path_get_stats(uint8_t opcode, FastPathStatsTypeDef *stats)
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = opcode < FAST_PATH_OPCODES ? s_table[opcode].stats : s_unknown;
+    __set_PRIMASK(primask);
+    if (stats->calls == 0U)
+    {
+        stats->latencyMin = 0;
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ *******************************************************************************
+ * @file    fast-path.h
+ * @brief   the interface of the real-time command fast path of the shell port
+ *******************************************************************************
+ * @attention
+ *
+ * Only built in when USBD_FAST_PATH is 1 in usbd_conf.h. Handlers run in the
+ * USB interrupt, right where the OUT packet is received: they may only use
+ * FromISR services, must not block, and must finish within the cycle budget
+ * given at registration. A handler that overruns its budget FAST_PATH_STRIKES
+ * times in a row is unregistered and its frames are counted as refused.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * A fast frame is binary and may sit anywhere in the shell byte stream:
+ *
+ *      +------+--------+-----+----------------+
+ *      | 0xFE | opcode | len | payload[len]   |
+ *      +------+--------+-----+----------------+
+ *
+ * 0xFE never occurs in UTF-8 text, so it cannot collide with a command line.
+ * The frames are cut out of every received packet before it reaches the
+ * receive ring, the rest of the packet goes on to the shell unchanged. A
+ * frame may straddle two packets; the USB data CRC protects its content.
+ *
+ * Dispatch is a table indexed by the opcode: one load and one bounds check
+ * between the last byte of the frame and the call. The receive-to-action
+ * latency of each opcode is measured from the entry of the USB interrupt
+ * that delivered the last byte (fast_path_irq_entry()) to the call of the
+ * handler, in DWT cycles.
+ *
+ *      OTG_HS_IRQHandler
+ *          fast_path_irq_entry();              // stamps the interrupt
+ *          HAL_PCD_IRQHandler()
+ *              -> CDC_Receive_HS()
+ *                  -> fast_path_filter()       // calls the handlers
+ *                  -> receive ring             // the rest, for the shell
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/9
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define FAST_PATH_SOF           0xFEU   // start of a fast frame
+#define FAST_PATH_OPCODES       32U     // opcodes 0 to 31
+#define FAST_PATH_MAX_PAYLOAD   60U     // a frame fits one full speed packet
+#define FAST_PATH_MAX_BUDGET    27500U  // cycles, 50 us at 550 MHz
+#define FAST_PATH_STRIKES       3U      // consecutive overruns before removal
+
+
+
+
+/*-------- 3. typedef --------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief handler of one opcode, USB interrupt context
+ * @param payload bytes after the length, valid during the call only
+ * @param len     payload length, within the registered range
+ * @param ctx     pointer given at registration
+ */
+typedef void (*FastPathHandlerTypeDef)(const uint8_t *payload, uint8_t len, void *ctx);
+
+/**
+ * @brief counters of one opcode, times in DWT cycles
+ */
+typedef struct
+{
+    uint32_t calls;
+    uint32_t refused;           // frames for no handler or out of range lengths
+    uint32_t overruns;          // calls longer than the budget
+    uint32_t cyclesMax;         // longest call
+    uint32_t latencyMin;        // interrupt entry to handler call
+    uint32_t latencyMax;
+    uint64_t latencySum;        // for the average: latencySum / calls
+} FastPathStatsTypeDef;
+
+
+
+
+/*-------- 4. function prototypes --------------------------------------------*/
+
+/**
+ * @brief register the handler of an opcode, replacing the previous one
+ * @param minLen, maxLen accepted payload lengths, others are refused
+ * @param budget cycles the handler may take, at most FAST_PATH_MAX_BUDGET
+ * @return 0 on success, -1 for a bad opcode, range or budget
+ */
+int32_t fast_path_register(uint8_t opcode, FastPathHandlerTypeDef handler, void *ctx, uint8_t minLen,
+                           uint8_t maxLen, uint32_t budget);
+
+/**
+ * @brief remove the handler of an opcode, its frames are refused from now on
+ */
+void fast_path_unregister(uint8_t opcode);
+
+/**
+ * @brief stamp the USB interrupt entry, call early in OTG_HS_IRQHandler
+ */
+void fast_path_irq_entry(void);
+
+/**
+ * @brief run the fast frames of a received packet and cut them out
+ * @note  USB interrupt context
+ * @param buf packet, compacted in place
+ * @param len packet length
+ * @return bytes left in buf for the receive ring
+ */
+uint32_t fast_path_filter(uint8_t *buf, uint32_t len);
+
+/**
+ * @brief snapshot of the counters of an opcode
+ * @note  an opcode from FAST_PATH_OPCODES up gives the frames refused for
+ *        having an opcode beyond the table
+ */
+void fast_path_get_stats(uint8_t opcode, FastPathStatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
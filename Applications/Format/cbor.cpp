@@ -0,0 +1,140 @@
+/**
+ *******************************************************************************
+ * @file    cbor.cpp
+ * @brief   the parts of the CBOR encoder that are not inlined: long heads, floating point, spilling
+ *******************************************************************************
+ * @attention
+ *
+ * Pure code over a caller's buffer: no HAL, no RTOS, no heap, no libm. The
+ * same file builds into the host benchmark,
+ * Tools/shell-host/shell-cbor-bench.cpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/21
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "cbor.hpp"
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @return bytes of the head at h, CBOR_HEAD_MAX at most; big endian
+ */
+uint32_t CborOut::head_to(uint8_t *h, uint8_t major, uint64_t v)
+{
+    uint32_t n;
+    if (v < 24U)
+    {
+        h[0] = static_cast<uint8_t>(major | v);
+        return 1U;
+    }
+    else if (v <= 0xFFU)
+    {
+        h[0] = major | 24U;
+        n    = 1U;
+    }
+    else if (v <= 0xFFFFU)
+    {
+        h[0] = major | 25U;
+        n    = 2U;
+    }
+    else if (v <= 0xFFFFFFFFU)
+    {
+        h[0] = major | 26U;
+        n    = 4U;
+    }
+    else
+    {
+        h[0] = major | 27U;
+        n    = 8U;
+    }
+    for (uint32_t i = n; i != 0U; i--)
+    {
+        h[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+    return n + 1U;
+}
+
+
+/**
+ * @note  a NaN is never equal to itself: it takes float32 like the values
+ *        that convert exactly, the RFC's preferred form
+ */
+void CborOut::real(double v)
+{
+    const float f = static_cast<float>(v);
+    uint8_t h[CBOR_HEAD_MAX];
+    uint64_t bits;
+    uint32_t n;
+    if (static_cast<double>(f) == v or v != v)
+    {
+        uint32_t b32;
+        memcpy(&b32, &f, sizeof(b32));
+        bits = b32;
+        n    = 4U;
+        h[0] = CBOR_FLOAT32;
+    }
+    else
+    {
+        memcpy(&bits, &v, sizeof(bits));
+        n    = 8U;
+        h[0] = CBOR_FLOAT64;
+    }
+    for (uint32_t i = n; i != 0U; i--)
+    {
+        h[i] = static_cast<uint8_t>(bits);
+        bits >>= 8;
+    }
+    put(h, n + 1U);
+}
+
+
+void CborOut::flush()
+{
+    if (_spill != nullptr and _len != 0U)
+    {
+        _spill->spill(_buf, _len);
+        _spilled += _len;
+        _len = 0;
+    }
+}
+
+
+/**
+ * @brief what does not fit: fill the buffer, spill it, go on
+ */
+void CborOut::put_slow(const uint8_t *p, uint32_t n)
+{
+    if (_spill == nullptr)
+    {
+        const uint32_t k = _size - _len;
+        memcpy(&_buf[_len], p, k);
+        _len += k;
+        _dropped += n - k;
+        return;
+    }
+    while (n != 0U)
+    {
+        if (_len == _size)
+        {
+            flush();
+        }
+        const uint32_t k = n < _size - _len ? n : _size - _len;
+        memcpy(&_buf[_len], p, k);
+        _len += k;
+        p += k;
+        n -= k;
+    }
+}
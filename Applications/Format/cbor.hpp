@@ -0,0 +1,396 @@
+/**
+ *******************************************************************************
+ * @file    cbor.hpp
+ * @brief   streaming CBOR (RFC 8949) encoder into a bounded buffer that spills when full
+ *******************************************************************************
+ * @attention
+ *
+ * No heap, no recursion, no state beyond the buffer: each call appends the
+ * encoding of one item, or the head of a container whose items follow.
+ * When the buffer is full its bytes go to the CborSpill and it starts over,
+ * so an item of any size streams through a buffer of any size; the spill
+ * sees a byte stream cut anywhere, an item may straddle two spills. Without
+ * a spill what does not fit is dropped and dropped_getter() tells.
+ *
+ *      CborOut out(frame, sizeof(frame), &link);
+ *      out.map(2);
+ *      out.uinteger(0);  out.text("adc");
+ *      out.uinteger(1);  out.open_array();  out.real(3.3);  out.close();
+ *      out.flush();
+ *
+ * The shell's machine mode writes every reply with it (shell-engine.hpp),
+ * Tools/shell-host/shell-cbor-bench checks it against the vectors of the
+ * RFC and decodes it back with Tools/shell-client/shell-cbor.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Integers take the shortest head, floating point values float32 when it
+ * holds them exactly, float64 otherwise. Maps and arrays of unknown size
+ * are opened with open_map() / open_array() and ended with close(), byte
+ * and text strings of unknown size likewise with definite chunks inside.
+ * Nothing checks that the items make a well formed whole: that is the
+ * caller's.
+ *
+ * cbor_format() is format_to() for machines: the same FMT("...") and the
+ * same arguments, checked the same way at compile time, encoded as an
+ * array of typed values instead of text. The literal text and the widths
+ * are left out, %c is a text of one character, a pointer an unsigned.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/21
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "format.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint8_t CBOR_UINT   = 0x00U;  // major types, in the top three bits
+constexpr uint8_t CBOR_NINT   = 0x20U;
+constexpr uint8_t CBOR_BYTES  = 0x40U;
+constexpr uint8_t CBOR_TEXT   = 0x60U;
+constexpr uint8_t CBOR_ARRAY  = 0x80U;
+constexpr uint8_t CBOR_MAP    = 0xA0U;
+constexpr uint8_t CBOR_TAG    = 0xC0U;
+constexpr uint8_t CBOR_SIMPLE = 0xE0U;
+
+constexpr uint8_t CBOR_FALSE   = 0xF4U;
+constexpr uint8_t CBOR_TRUE    = 0xF5U;
+constexpr uint8_t CBOR_NULL    = 0xF6U;
+constexpr uint8_t CBOR_FLOAT32 = 0xFAU;
+constexpr uint8_t CBOR_FLOAT64 = 0xFBU;
+constexpr uint8_t CBOR_BREAK   = 0xFFU;
+constexpr uint8_t CBOR_OPEN    = 0x1FU;  // additional information of an item of unknown size
+
+constexpr uint32_t CBOR_HEAD_MAX = 9U;   // bytes of the longest head
+
+
+
+
+/*-------- 3. encoder --------------------------------------------------------*/
+
+/**
+ * @brief where a full buffer goes
+ */
+class CborSpill
+{
+  public:
+    /**
+     * @brief the next len bytes of the stream, the buffer is reused on return
+     */
+    virtual void spill(const uint8_t *buf, uint32_t len) = 0;
+
+    virtual ~CborSpill() = default;
+};
+
+/**
+ * @brief appends items to a buffer, spilling it when full
+ */
+class CborOut
+{
+  public:
+    /**
+     * @param spill nullptr: what does not fit is dropped
+     */
+    CborOut(uint8_t *buf, uint32_t size, CborSpill *spill = nullptr) : _buf(buf), _size(size), _spill(spill)
+    {
+    }
+
+    void uinteger(uint64_t v)
+    {
+        head(CBOR_UINT, v);
+    }
+
+    void integer(int64_t v)
+    {
+        if (v < 0)
+        {
+            head(CBOR_NINT, ~static_cast<uint64_t>(v)); // -1 - v
+        }
+        else
+        {
+            head(CBOR_UINT, static_cast<uint64_t>(v));
+        }
+    }
+
+    void bytes(const void *p, uint32_t n)
+    {
+        head(CBOR_BYTES, n);
+        put(static_cast<const uint8_t *>(p), n);
+    }
+
+    void text(std::string_view s)
+    {
+        head(CBOR_TEXT, s.size());
+        put(reinterpret_cast<const uint8_t *>(s.data()), static_cast<uint32_t>(s.size()));
+    }
+
+    /**
+     * @brief an array of n items, the items follow
+     */
+    void array(uint32_t n)
+    {
+        head(CBOR_ARRAY, n);
+    }
+
+    /**
+     * @brief a map of n pairs, key and value follow for each
+     */
+    void map(uint32_t n)
+    {
+        head(CBOR_MAP, n);
+    }
+
+    /**
+     * @brief an array, a map, a byte or a text string of unknown size, up to close()
+     * @note  the chunks of a string of unknown size are bytes() or text()
+     */
+    void open_array()
+    {
+        byte(CBOR_ARRAY | CBOR_OPEN);
+    }
+
+    void open_map()
+    {
+        byte(CBOR_MAP | CBOR_OPEN);
+    }
+
+    void open_bytes()
+    {
+        byte(CBOR_BYTES | CBOR_OPEN);
+    }
+
+    void open_text()
+    {
+        byte(CBOR_TEXT | CBOR_OPEN);
+    }
+
+    void close()
+    {
+        byte(CBOR_BREAK);
+    }
+
+    void boolean(bool v)
+    {
+        byte(v ? CBOR_TRUE : CBOR_FALSE);
+    }
+
+    void null()
+    {
+        byte(CBOR_NULL);
+    }
+
+    /**
+     * @brief float32 when it holds v exactly, NaN included, float64 otherwise
+     */
+    void real(double v);
+
+    /**
+     * @brief hand what the buffer holds to the spill
+     */
+    void flush();
+
+    /**
+     * @brief the head of an item: major type and argument, shortest form
+     */
+    void head(uint8_t major, uint64_t v)
+    {
+        if (v < 24U and _len < _size)
+        {
+            _buf[_len++] = static_cast<uint8_t>(major | v);
+            return;
+        }
+        uint8_t h[CBOR_HEAD_MAX];
+        put(h, head_to(h, major, v));
+    }
+
+    /****************** setter & getter *******************/
+
+    /**
+     * @brief bytes in the buffer, not spilled yet
+     */
+    [[nodiscard]] uint32_t len_getter() const
+    {
+        return _len;
+    }
+
+    /**
+     * @brief bytes of the stream so far, spilled or not
+     */
+    [[nodiscard]] uint64_t total_getter() const
+    {
+        return _spilled + _len;
+    }
+
+    /**
+     * @brief bytes lost for want of room, without a spill
+     */
+    [[nodiscard]] uint32_t dropped_getter() const
+    {
+        return _dropped;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    static uint32_t head_to(uint8_t *h, uint8_t major, uint64_t v);
+
+    void byte(uint8_t b)
+    {
+        if (_len < _size)
+        {
+            _buf[_len++] = b;
+            return;
+        }
+        put(&b, 1U);
+    }
+
+    void put(const uint8_t *p, uint32_t n)
+    {
+        if (n <= _size - _len)
+        {
+            memcpy(&_buf[_len], p, n);
+            _len += n;
+            return;
+        }
+        put_slow(p, n);
+    }
+
+    void put_slow(const uint8_t *p, uint32_t n);
+
+    uint8_t *_buf;
+    uint32_t _size;
+    CborSpill *_spill;
+    uint32_t _len      = 0;
+    uint32_t _dropped  = 0;
+    uint64_t _spilled  = 0;
+};
+
+
+
+
+/*-------- 4. format arguments -----------------------------------------------*/
+
+namespace cbor_detail
+{
+
+/**
+ * @brief the conversion of argument A in the format F
+ */
+template <typename F> constexpr char conv_of(int32_t a)
+{
+    for (const FormatItem &it : format_detail::Plan<F>::ITEMS)
+    {
+        if (it.arg == a)
+        {
+            return it.spec.conv;
+        }
+    }
+    return 0;
+}
+
+template <typename F, int32_t A, typename T> inline void value(CborOut &out, const T &v)
+{
+    using U                     = std::remove_cv_t<std::remove_reference_t<T>>;
+    constexpr char conv         = conv_of<F>(A);
+    constexpr FormatKindEnum kd = format_detail::kind_of<U>();
+    static_assert(format_detail::accepts(kd, conv), "an argument does not fit its conversion");
+
+    if constexpr (not format_detail::accepts(kd, conv))
+    {
+        (void)out;
+        (void)v;
+    }
+    else if constexpr (kd == FormatKindEnum::TEXT and conv == 's')
+    {
+        const char *s = nullptr;
+        uint32_t n    = 0;
+        format_detail::text_of(v, s, n);
+        out.text(std::string_view(s, n));
+    }
+    else if constexpr (kd == FormatKindEnum::TEXT or kd == FormatKindEnum::POINTER)
+    {
+        const void *a;
+        if constexpr (std::is_same_v<U, std::string_view>)
+        {
+            a = v.data();
+        }
+        else
+        {
+            a = v;
+        }
+        out.uinteger(reinterpret_cast<uintptr_t>(a));
+    }
+    else if constexpr (kd == FormatKindEnum::FLOATING)
+    {
+        out.real(static_cast<double>(v));
+    }
+    else if constexpr (conv == 'c')
+    {
+        const char c = static_cast<char>(v);
+        out.text(std::string_view(&c, 1U));
+    }
+    else if constexpr (std::is_same_v<U, bool>)
+    {
+        out.boolean(v);
+    }
+    else
+    {
+        using I = std::conditional_t<std::is_enum_v<U>, std::underlying_type<U>, std::common_type<U>>;
+        using N = typename I::type;
+        if constexpr (conv == 'f' or conv == 'F' or conv == 'e' or conv == 'E' or conv == 'g' or conv == 'G')
+        {
+            out.real(static_cast<double>(static_cast<N>(v)));
+        }
+        else if constexpr (std::is_signed_v<N>)
+        {
+            out.integer(static_cast<int64_t>(static_cast<N>(v)));
+        }
+        else
+        {
+            out.uinteger(static_cast<uint64_t>(static_cast<N>(v)));
+        }
+    }
+}
+
+template <typename F, typename Tuple, std::size_t... A>
+inline void values(CborOut &out, const Tuple &args, std::index_sequence<A...>)
+{
+    (value<F, static_cast<int32_t>(A)>(out, std::get<A>(args)), ...);
+}
+
+} // namespace cbor_detail
+
+/**
+ * @brief the arguments of a format as an array of typed values
+ * @param fmt FMT("..."), checked as format_to() checks it
+ */
+template <typename F, typename... Args> inline void cbor_format(CborOut &out, F fmt, const Args &...args)
+{
+    using Plan = format_detail::Plan<F>;
+    static_assert(Plan::VALID, "a conversion of the format string does not parse");
+    static_assert(Plan::ARGS == static_cast<int32_t>(sizeof...(Args)),
+                  "the format string takes another number of arguments");
+    (void)fmt;
+    out.array(sizeof...(Args));
+    cbor_detail::values<F>(out, std::forward_as_tuple(args...), std::index_sequence_for<Args...>{});
+}
@@ -0,0 +1,132 @@
+/**
+ *******************************************************************************
+ * @file    encode.cpp
+ * @brief   the hexadecimal and base64 encoders of encode.hpp
+ *******************************************************************************
+ * @attention
+ *
+ * See encode.hpp. The loads and stores go through memcpy(): the source
+ * and the destination may sit at any byte address, the compiler makes it
+ * one word access where the core allows unaligned ones. The characters are
+ * put in the word in little endian order, like the target.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/19
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "encode.hpp"
+#include <array>
+#include <cstring>
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+/**
+ * @brief the two digits of every byte, the high one in the low byte
+ */
+static constexpr std::array<uint16_t, 256> encode_hex_pairs()
+{
+    std::array<uint16_t, 256> t{};
+    const char digits[] = "0123456789abcdef";
+    for (uint32_t b = 0; b < 256U; b++)
+    {
+        t[b] = static_cast<uint16_t>(digits[b >> 4] | (digits[b & 0xFU] << 8));
+    }
+    return t;
+}
+
+static constexpr std::array<uint16_t, 256> s_hex_pairs = encode_hex_pairs();
+
+static constexpr char s_b64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+void encode_hex(char *out, const uint8_t *in, uint32_t len)
+{
+    while (len >= 4U)
+    {
+        uint32_t w;
+        memcpy(&w, in, 4);
+        const uint32_t lo = s_hex_pairs[w & 0xFFU] | (static_cast<uint32_t>(s_hex_pairs[(w >> 8) & 0xFFU]) << 16);
+        const uint32_t hi = s_hex_pairs[(w >> 16) & 0xFFU] | (static_cast<uint32_t>(s_hex_pairs[w >> 24]) << 16);
+        memcpy(out, &lo, 4);
+        memcpy(out + 4, &hi, 4);
+        in += 4;
+        out += 8;
+        len -= 4U;
+    }
+    while (len-- != 0U)
+    {
+        memcpy(out, &s_hex_pairs[*in++], 2);
+        out += 2;
+    }
+}
+
+
+void encode_hex_word(char *out, uint32_t v)
+{
+    const uint32_t lo = s_hex_pairs[v >> 24] | (static_cast<uint32_t>(s_hex_pairs[(v >> 16) & 0xFFU]) << 16);
+    const uint32_t hi = s_hex_pairs[(v >> 8) & 0xFFU] | (static_cast<uint32_t>(s_hex_pairs[v & 0xFFU]) << 16);
+    memcpy(out, &lo, 4);
+    memcpy(out + 4, &hi, 4);
+}
+
+
+/**
+ * @brief the four characters of the 24 bits of x, the first in the low byte
+ */
+static inline uint32_t encode_b64_quad(uint32_t x)
+{
+    return static_cast<uint32_t>(static_cast<uint8_t>(s_b64_digits[x >> 18])) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(s_b64_digits[(x >> 12) & 0x3FU])) << 8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(s_b64_digits[(x >> 6) & 0x3FU])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(s_b64_digits[x & 0x3FU])) << 24);
+}
+
+
+uint32_t encode_base64(char *out, const uint8_t *in, uint32_t len)
+{
+    const uint32_t total = encode_base64_len(len);
+
+    // a word load takes one byte more than the group: not for the last group
+    while (len > 3U)
+    {
+        uint32_t w;
+        memcpy(&w, in, 4);
+        const uint32_t c = encode_b64_quad(__builtin_bswap32(w) >> 8);
+        memcpy(out, &c, 4);
+        in += 3;
+        out += 4;
+        len -= 3U;
+    }
+    if (len != 0U)
+    {
+        uint32_t x = static_cast<uint32_t>(in[0]) << 16;
+        x |= len > 1U ? static_cast<uint32_t>(in[1]) << 8 : 0U;
+        x |= len > 2U ? in[2] : 0U;
+        const uint32_t c = encode_b64_quad(x);
+        memcpy(out, &c, 4);
+        if (len < 3U)
+        {
+            out[3] = ENCODE_BASE64_PAD;
+        }
+        if (len < 2U)
+        {
+            out[2] = ENCODE_BASE64_PAD;
+        }
+    }
+    return total;
+}
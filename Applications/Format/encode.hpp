@@ -0,0 +1,78 @@
+/**
+ *******************************************************************************
+ * @file    encode.hpp
+ * @brief   binary to text at line rate: hexadecimal and base64, a word at a time
+ *******************************************************************************
+ * @attention
+ *
+ * Pure code, no HAL, no RTOS, no heap: the shell's `dump` writes with it
+ * straight into the transmit queue, Tools/shell-host/shell-dump-bench
+ * checks it against plain byte at a time encoders and times it. The output
+ * is not terminated.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The M7 has no vector unit; its 32-bit lanes (SWAR arithmetic, or the
+ * UADD8 / SEL of the DSP extension) take about twice the cycles of a table
+ * lookup per character, the pipeline model of the core and the host agree.
+ * The encoders are word-wide instead: one load for four bytes in (three
+ * for base64), one lookup per byte in a 512-byte table of digit pairs or
+ * one per sextet, one store per four characters out.
+ *
+ *      hex     4 bytes  -> ldr, 4 x ldrh, 2 x str
+ *      base64  3 bytes  -> ldr, rev, 4 x ldrb, str
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/19
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <cstdint>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr char ENCODE_BASE64_PAD = '=';
+
+/**
+ * @brief characters of the base64 of len bytes, padding included
+ */
+constexpr uint32_t encode_base64_len(uint32_t len)
+{
+    return (len + 2U) / 3U * 4U;
+}
+
+
+
+
+/*-------- 3. function prototypes --------------------------------------------*/
+
+/**
+ * @brief 2 * len lower case hexadecimal digits, the first byte first
+ */
+void encode_hex(char *out, const uint8_t *in, uint32_t len);
+
+/**
+ * @brief the 8 digits of a word, most significant first
+ */
+void encode_hex_word(char *out, uint32_t v);
+
+/**
+ * @brief base64 (RFC 4648) with '=' padding
+ * @return characters written, encode_base64_len(len)
+ */
+uint32_t encode_base64(char *out, const uint8_t *in, uint32_t len);
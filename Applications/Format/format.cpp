@@ -0,0 +1,328 @@
+/**
+ *******************************************************************************
+ * @file    format.cpp
+ * @brief   the conversions of format.hpp that are not inlined: padded integers, floating point
+ *******************************************************************************
+ * @attention
+ *
+ * Pure code over a FormatOut: no HAL, no RTOS, no heap, no libm. The same
+ * file builds into the host benchmark, Tools/format-bench/format-bench.cpp.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Decimal digits go two at a time from FORMAT_PAIRS; a 64-bit value is cut
+ * in 9-digit pieces so that only the pieces above 32 bits take a 64-bit
+ * division.
+ *
+ * A double is scaled to [1, 10) by the exact powers of ten of s_pow10, one
+ * division per 16 decades, then rounded to nearest, ties to even, at the
+ * last digit asked for. That is snprintf()'s output but where the scaling
+ * itself rounds onto the other side of a tie: a value within a few ulps of
+ * one (1e22 / 3 with %.3e), never in %f of a value below 2^53 / 10^prec.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/18
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "format.hpp"
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static const double s_pow10[16] = {1e0, 1e1, 1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                   1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief the decimal digits of v ending at end, none for 0
+ * @return how many were written, before end
+ */
+static uint32_t format_dec_digits(char *end, uint64_t v)
+{
+    uint32_t n = 0;
+    while ((v >> 32) != 0U)
+    {
+        const uint32_t low = static_cast<uint32_t>(v % 1000000000U);
+        v /= 1000000000U;
+        const uint32_t k = format_u32_digits(end - n, low);
+        memset(end - n - 9, '0', 9U - k);
+        n += 9U;
+    }
+    if (v != 0U)
+    {
+        n += format_u32_digits(end - n, static_cast<uint32_t>(v));
+    }
+    return n;
+}
+
+
+/**
+ * @brief the digits of v in base 8 or 16 ending at end, none for 0
+ */
+static uint32_t format_pow2_digits(char *end, uint64_t v, uint32_t shift, bool upper)
+{
+    const char *digits  = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    const uint32_t mask = (1U << shift) - 1U;
+    uint32_t n          = 0;
+    while (v != 0U)
+    {
+        *(end - ++n) = digits[v & mask];
+        v >>= shift;
+    }
+    return n;
+}
+
+
+void format_dec64(FormatOut &out, uint64_t v)
+{
+    char tmp[20];
+    const uint32_t n = format_dec_digits(&tmp[sizeof(tmp)], v);
+    out.put(&tmp[sizeof(tmp) - n], n);
+}
+
+
+void format_int(FormatOut &out, const FormatSpec &sp, uint64_t mag, bool neg, uint32_t base, bool upper)
+{
+    char tmp[24];
+    char *const end = &tmp[sizeof(tmp)];
+    int32_t n       = static_cast<int32_t>(base == 10U ? format_dec_digits(end, mag)
+                                                       : format_pow2_digits(end, mag, base == 8U ? 3U : 4U, upper));
+    if (n == 0 and sp.prec != 0)
+    {
+        *(end - ++n) = '0';
+    }
+
+    char sign = 0;
+    if (neg)
+    {
+        sign = '-';
+    }
+    else if (sp.plus and (sp.conv == 'd' or sp.conv == 'i'))
+    {
+        sign = '+';
+    }
+    else if (sp.space and (sp.conv == 'd' or sp.conv == 'i'))
+    {
+        sign = ' ';
+    }
+
+    const char *prefix = "";
+    if (sp.alt and base == 16U and mag != 0U)
+    {
+        prefix = upper ? "0X" : "0x";
+    }
+    else if (sp.alt and base == 8U and (n == 0 or *(end - n) != '0') and sp.prec <= n)
+    {
+        prefix = "0";
+    }
+    const int32_t prefix_len = static_cast<int32_t>(strlen(prefix));
+    const int32_t pre_len    = prefix_len + (sign != 0 ? 1 : 0);
+
+    const int32_t zeros = sp.prec > n ? sp.prec - n : 0;
+    const int32_t fill  = sp.width - pre_len - zeros - n;
+    const bool zero_pad = sp.zero and not sp.left and sp.prec < 0;
+
+    if (not sp.left and not zero_pad)
+    {
+        out.pad(' ', fill);
+    }
+    if (sign != 0)
+    {
+        out.put(sign);
+    }
+    out.put(prefix, static_cast<uint32_t>(prefix_len));
+    if (zero_pad)
+    {
+        out.pad('0', fill);
+    }
+    out.pad('0', zeros);
+    out.put(end - n, static_cast<uint32_t>(n));
+    if (sp.left)
+    {
+        out.pad(' ', fill);
+    }
+}
+
+
+/**
+ * @brief scale v > 0 to [1, 10)
+ * @param exp its decimal exponent
+ */
+static double format_scale(double v, int32_t &exp)
+{
+    exp = 0;
+    while (v >= 1e16)
+    {
+        v /= 1e16;
+        exp += 16;
+    }
+    while (v < 1.0)
+    {
+        v *= 1e16;
+        exp -= 16;
+    }
+    int32_t k = 15;
+    while (v < s_pow10[k])
+    {
+        k--;
+    }
+    v /= s_pow10[k];
+    exp += k;
+    if (v >= 10.0)
+    {
+        v /= 10.0;
+        exp++;
+    }
+    return v;
+}
+
+
+void format_double(FormatOut &out, FormatSpec sp, double v)
+{
+    char tmp[48];
+    FormatOut body(tmp, sizeof(tmp));
+
+    const bool neg = v < 0.0 or (v == 0.0 and 1.0 / v < 0.0);
+    if (neg)
+    {
+        v = -v;
+    }
+
+    const bool upper = sp.conv == 'F' or sp.conv == 'E' or sp.conv == 'G';
+    if (v != v or v > 1.7976931348623157e308)
+    {
+        body.put(v != v ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf"), 3);
+        sp.zero = false;
+    }
+    else
+    {
+        int32_t prec = sp.prec < 0 ? 6 : (sp.prec > FORMAT_PREC_MAX ? FORMAT_PREC_MAX : sp.prec);
+        char conv    = sp.conv;
+
+        int32_t exp = 0;
+        double m    = v != 0.0 ? format_scale(v, exp) : 0.0;
+
+        bool strip = false;
+        if (conv == 'g' or conv == 'G')
+        {
+            const int32_t p = prec == 0 ? 1 : prec;
+            strip           = not sp.alt;
+            int32_t x       = exp; // 9.9999996 at 6 digits is 10.0000: decide on the rounded exponent
+            if (static_cast<uint64_t>(m * s_pow10[p - 1] + 0.5) >= static_cast<uint64_t>(s_pow10[p]))
+            {
+                x++;
+            }
+            if (x < -4 or x >= p)
+            {
+                conv = conv == 'g' ? 'e' : 'E';
+                prec = p - 1;
+            }
+            else
+            {
+                conv = 'f';
+                prec = p - 1 - x; // up to FORMAT_PREC_MAX + 3 digits for 1e-4
+            }
+        }
+        if ((conv == 'f' or conv == 'F') and v >= 1.8e19)
+        {
+            conv = upper ? 'E' : 'e'; // integer part does not fit 64 bits
+        }
+
+        const bool sci       = conv == 'e' or conv == 'E';
+        const uint64_t scale = static_cast<uint64_t>(s_pow10[prec]);
+        const double x       = sci ? m : v;
+        uint64_t ip          = static_cast<uint64_t>(x);
+        const double t       = (x - static_cast<double>(ip)) * static_cast<double>(scale);
+        uint64_t frac        = static_cast<uint64_t>(t);
+        const double rest    = t - static_cast<double>(frac);
+        if (rest > 0.5 or (rest == 0.5 and ((prec != 0 ? frac : ip) & 1U) != 0U))
+        {
+            frac++;
+        }
+        if (frac >= scale)
+        {
+            frac -= scale;
+            ip++;
+            if (sci and ip >= 10U)
+            {
+                ip = 1U;
+                exp++;
+            }
+        }
+
+        char digits[20];
+        const uint32_t n = ip != 0U ? format_dec_digits(&digits[sizeof(digits)], ip) : 0U;
+        if (n == 0U)
+        {
+            body.put('0');
+        }
+        body.put(&digits[sizeof(digits) - n], n);
+
+        if (prec > 0 or sp.alt)
+        {
+            char fd[16];
+            for (int32_t i = prec - 1; i >= 0; i--)
+            {
+                fd[i] = static_cast<char>('0' + frac % 10U);
+                frac /= 10U;
+            }
+            int32_t keep = prec;
+            while (strip and keep > 0 and fd[keep - 1] == '0')
+            {
+                keep--;
+            }
+            if (keep > 0 or sp.alt)
+            {
+                body.put('.');
+            }
+            body.put(fd, static_cast<uint32_t>(keep));
+        }
+
+        if (sci)
+        {
+            body.put(conv);
+            body.put(exp < 0 ? '-' : '+');
+            const uint32_t e = static_cast<uint32_t>(exp < 0 ? -exp : exp);
+            if (e >= 100U)
+            {
+                body.put(static_cast<char>('0' + e / 100U));
+            }
+            body.put(&FORMAT_PAIRS[(e % 100U) * 2U], 2);
+        }
+    }
+
+    const char sign    = neg ? '-' : (sp.plus ? '+' : (sp.space ? ' ' : 0));
+    const int32_t fill = sp.width - static_cast<int32_t>(body.len()) - (sign != 0 ? 1 : 0);
+    if (not sp.left and not sp.zero)
+    {
+        out.pad(' ', fill);
+    }
+    if (sign != 0)
+    {
+        out.put(sign);
+    }
+    if (not sp.left and sp.zero)
+    {
+        out.pad('0', fill);
+    }
+    out.put(tmp, body.len());
+    if (sp.left)
+    {
+        out.pad(' ', fill);
+    }
+}
@@ -0,0 +1,673 @@
+/**
+ *******************************************************************************
+ * @file    format.hpp
+ * @brief   printf-style formatting checked at compile time, straight into a bounded buffer
+ *******************************************************************************
+ * @attention
+ *
+ * No heap, no locale, no reentrancy lock, no va_list: the format string is
+ * parsed by the compiler, each argument is converted by the function its
+ * type and its conversion select. A format string that does not parse, or
+ * that does not fit its arguments, does not compile:
+ *
+ *      format_to(out, FMT("%-8s %5u %08x %.3f"), name, count, crc, volts);
+ *      format_to(out, FMT("%d items"));        // error: takes 1 argument
+ *      format_to(out, FMT("%s"), 42);          // error: %s of an int
+ *
+ * The output is cut at the end of the buffer, never overrun. Host code and
+ * firmware alike: Tools/format-bench/format-bench.cpp checks it against
+ * snprintf() and times both.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The conversions are printf's: %d %i %u %x %X %o %c %s %p %f %F %e %E %g
+ * %G and %%, with the flags - 0 + space #, a width and a precision (no *).
+ * Length modifiers (l, ll, h, z, ...) are accepted and ignored: the type of
+ * the argument decides its size. So:
+ *
+ *      - %d, %i and %u print the value of any integer, signed as its type is
+ *      - %x and %o print its bits, in the width of its type
+ *      - %f, %e and %g take floating point and integers, at most
+ *        FORMAT_PREC_MAX digits after the point
+ *      - %s takes const char * (nullptr prints "(null)"), char arrays and
+ *        std::string_view; %p any pointer
+ *
+ * The common plain cases (%u, %d, %x, %08x, %s) expand inline to a digit
+ * loop, the others call format.cpp. The deferred logger parses its format
+ * strings at drain time with the same format_parse() and converts with the
+ * same functions (log-drain.cpp).
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/18
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr int32_t FORMAT_PREC_MAX = 9; // digits after the point of %f %e %g
+
+/**
+ * @brief a format string checked at compile time: FMT("x=%u")
+ * @note  each use is its own type, holding the text in a constexpr function
+ */
+#define FMT(s)                                                                                                         \
+    [] {                                                                                                               \
+        struct FormatText                                                                                              \
+        {                                                                                                              \
+            static constexpr std::string_view text()                                                                   \
+            {                                                                                                          \
+                return s;                                                                                              \
+            }                                                                                                          \
+        };                                                                                                             \
+        return FormatText{};                                                                                           \
+    }()
+
+/**
+ * @brief one conversion specification
+ */
+struct FormatSpec
+{
+    bool left     = false;
+    bool zero     = false;
+    bool plus     = false;
+    bool space    = false;
+    bool alt      = false;
+    int32_t width = 0;
+    int32_t prec  = -1;     // -1: none given
+    char conv     = 0;
+};
+
+/**
+ * @brief one piece of a parsed format string
+ */
+struct FormatItem
+{
+    uint32_t at  = 0;       // literal: first byte in the text
+    uint32_t len = 0;       // literal: bytes
+    int32_t arg  = -1;      // conversion: index of its argument, -1 for a literal
+    FormatSpec spec;
+};
+
+/**
+ * @brief what an argument is, for the conversions it accepts
+ */
+enum class FormatKindEnum
+{
+    INTEGER,
+    FLOATING,
+    TEXT,
+    POINTER,
+    OTHER,
+};
+
+
+
+
+/*-------- 3. output ---------------------------------------------------------*/
+
+/**
+ * @brief a bounded buffer: what does not fit is dropped
+ */
+class FormatOut
+{
+  public:
+    FormatOut(char *buf, uint32_t cap) : _buf(buf), _cap(cap)
+    {
+    }
+
+    void put(char c)
+    {
+        if (_len < _cap)
+        {
+            _buf[_len++] = c;
+        }
+    }
+
+    void put(const char *s, uint32_t n)
+    {
+        n = n < _cap - _len ? n : _cap - _len;
+        memcpy(&_buf[_len], s, n);
+        _len += n;
+    }
+
+    void pad(char c, int32_t n)
+    {
+        if (n > 0)
+        {
+            const uint32_t k = static_cast<uint32_t>(n) < _cap - _len ? static_cast<uint32_t>(n) : _cap - _len;
+            memset(&_buf[_len], c, k);
+            _len += k;
+        }
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t len() const
+    {
+        return _len;
+    }
+
+    [[nodiscard]] const char *data() const
+    {
+        return _buf;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    char *_buf;
+    uint32_t _cap;
+    uint32_t _len = 0;
+};
+
+
+
+
+/*-------- 4. conversions ----------------------------------------------------*/
+
+/**
+ * @brief general integer: sign, prefix, precision, width
+ * @param mag  the magnitude, neg tells its sign
+ * @param base 8, 10 or 16
+ */
+void format_int(FormatOut &out, const FormatSpec &sp, uint64_t mag, bool neg, uint32_t base, bool upper);
+
+/**
+ * @brief %f %e %g of a double, sign, flags and width included
+ * @note  at most FORMAT_PREC_MAX digits after the point; %f of 1.8e19 and
+ *        more prints as %e, its integer part not fitting 64 bits
+ */
+void format_double(FormatOut &out, FormatSpec sp, double v);
+
+/**
+ * @brief decimal of a 64-bit value beyond 32 bits, no padding
+ */
+void format_dec64(FormatOut &out, uint64_t v);
+
+/**
+ * @brief "00" to "99"
+ */
+inline constexpr char FORMAT_PAIRS[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                       "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                       "8081828384858687888990919293949596979899";
+
+/**
+ * @brief the digits of v ending at end, two at a time
+ * @return how many were written, before end
+ */
+inline uint32_t format_u32_digits(char *end, uint32_t v)
+{
+    char *p = end;
+    while (v >= 100U)
+    {
+        const uint32_t r = v % 100U;
+        v /= 100U;
+        p -= 2;
+        memcpy(p, &FORMAT_PAIRS[r * 2U], 2);
+    }
+    if (v >= 10U)
+    {
+        p -= 2;
+        memcpy(p, &FORMAT_PAIRS[v * 2U], 2);
+    }
+    else
+    {
+        *--p = static_cast<char>('0' + v);
+    }
+    return static_cast<uint32_t>(end - p);
+}
+
+/**
+ * @brief plain %u of any unsigned value
+ */
+inline void format_dec(FormatOut &out, uint64_t v)
+{
+    if ((v >> 32) != 0U)
+    {
+        format_dec64(out, v);
+        return;
+    }
+    char tmp[10];
+    const uint32_t n = format_u32_digits(&tmp[sizeof(tmp)], static_cast<uint32_t>(v));
+    out.put(&tmp[sizeof(tmp) - n], n);
+}
+
+/**
+ * @brief plain %x, or zero padded to width digits (%08x), width at most 16
+ */
+inline void format_hex(FormatOut &out, uint64_t v, uint32_t width, bool upper)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char tmp[16];
+    uint32_t n = 0;
+    do
+    {
+        tmp[15U - n++] = digits[v & 0xFU];
+        v >>= 4;
+    } while (v != 0U);
+    while (n < width)
+    {
+        tmp[15U - n++] = '0';
+    }
+    out.put(&tmp[16U - n], n);
+}
+
+/**
+ * @brief %s and %c: precision cuts, width pads
+ */
+inline void format_text(FormatOut &out, const FormatSpec &sp, const char *s, uint32_t n)
+{
+    if (sp.prec >= 0 and static_cast<uint32_t>(sp.prec) < n)
+    {
+        n = static_cast<uint32_t>(sp.prec);
+    }
+    const int32_t fill = sp.width - static_cast<int32_t>(n);
+    if (not sp.left)
+    {
+        out.pad(' ', fill);
+    }
+    out.put(s, n);
+    if (sp.left)
+    {
+        out.pad(' ', fill);
+    }
+}
+
+
+
+
+/*-------- 5. parsing --------------------------------------------------------*/
+
+/**
+ * @brief one conversion, p just after its '%'; at compile time and at run time
+ * @param end one past the last byte of the text
+ * @return false when the conversion is missing or unknown; p is past it
+ *         and sp.conv holds it either way (0 when missing)
+ */
+constexpr bool format_parse(const char *&p, const char *end, FormatSpec &sp)
+{
+    for (; p != end; p++)
+    {
+        if (*p == '-')
+            sp.left = true;
+        else if (*p == '0')
+            sp.zero = true;
+        else if (*p == '+')
+            sp.plus = true;
+        else if (*p == ' ')
+            sp.space = true;
+        else if (*p == '#')
+            sp.alt = true;
+        else
+            break;
+    }
+    while (p != end and *p >= '0' and *p <= '9')
+    {
+        sp.width = sp.width * 10 + (*p++ - '0');
+    }
+    if (p != end and *p == '.')
+    {
+        p++;
+        sp.prec = 0;
+        while (p != end and *p >= '0' and *p <= '9')
+        {
+            sp.prec = sp.prec * 10 + (*p++ - '0');
+        }
+    }
+    while (p != end and (*p == 'h' or *p == 'l' or *p == 'z' or *p == 'j' or *p == 't' or *p == 'L'))
+    {
+        p++;
+    }
+    if (p == end)
+    {
+        sp.conv = 0;
+        return false;
+    }
+    sp.conv = *p++;
+    return std::string_view("diuxXocspfFeEgG").find(sp.conv) != std::string_view::npos;
+}
+
+namespace format_detail
+{
+
+/**
+ * @brief split text into literals and conversions, each handed to sink
+ * @return false on a conversion that does not parse
+ */
+template <typename Sink> constexpr bool walk(std::string_view text, Sink &&sink)
+{
+    const char *const begin = text.data();
+    const char *const end   = begin + text.size();
+    const char *p           = begin;
+    const char *lit         = begin;
+    int32_t arg             = 0;
+    while (p != end)
+    {
+        if (*p != '%')
+        {
+            p++;
+            continue;
+        }
+        if (p != lit)
+        {
+            sink(FormatItem{static_cast<uint32_t>(lit - begin), static_cast<uint32_t>(p - lit), -1, {}});
+        }
+        if (p + 1 != end and p[1] == '%')
+        {
+            sink(FormatItem{static_cast<uint32_t>(p - begin), 1U, -1, {}});
+            p += 2;
+            lit = p;
+            continue;
+        }
+        p++;
+        FormatSpec sp;
+        if (not format_parse(p, end, sp))
+        {
+            return false;
+        }
+        sink(FormatItem{0U, 0U, arg++, sp});
+        lit = p;
+    }
+    if (p != lit)
+    {
+        sink(FormatItem{static_cast<uint32_t>(lit - begin), static_cast<uint32_t>(p - lit), -1, {}});
+    }
+    return true;
+}
+
+template <typename F> constexpr uint32_t count_items()
+{
+    uint32_t n = 0;
+    (void)walk(F::text(), [&](const FormatItem &) { n++; });
+    return n;
+}
+
+template <typename F> constexpr int32_t count_args()
+{
+    int32_t n = 0;
+    (void)walk(F::text(), [&](const FormatItem &item) { n += item.arg >= 0 ? 1 : 0; });
+    return n;
+}
+
+/**
+ * @brief the parsed format string of F, a constant
+ */
+template <typename F> struct Plan
+{
+    static constexpr bool VALID     = walk(F::text(), [](const FormatItem &) {});
+    static constexpr uint32_t COUNT = count_items<F>();
+    static constexpr int32_t ARGS   = count_args<F>();
+
+    static constexpr std::array<FormatItem, COUNT> items()
+    {
+        std::array<FormatItem, COUNT> a{};
+        uint32_t i = 0;
+        (void)walk(F::text(), [&](const FormatItem &item) { a[i++] = item; });
+        return a;
+    }
+
+    static constexpr std::array<FormatItem, COUNT> ITEMS = items();
+};
+
+template <typename T> constexpr FormatKindEnum kind_of()
+{
+    using U = std::remove_cv_t<std::remove_reference_t<T>>;
+    if constexpr (std::is_array_v<U>)
+    {
+        return std::is_same_v<std::remove_cv_t<std::remove_extent_t<U>>, char> ? FormatKindEnum::TEXT
+                                                                               : FormatKindEnum::OTHER;
+    }
+    else if constexpr (std::is_same_v<U, std::string_view> or std::is_same_v<U, const char *> or
+                       std::is_same_v<U, char *>)
+    {
+        return FormatKindEnum::TEXT;
+    }
+    else if constexpr (std::is_pointer_v<U> or std::is_null_pointer_v<U>)
+    {
+        return FormatKindEnum::POINTER;
+    }
+    else if constexpr (std::is_integral_v<U> or std::is_enum_v<U>)
+    {
+        return FormatKindEnum::INTEGER;
+    }
+    else if constexpr (std::is_floating_point_v<U>)
+    {
+        return FormatKindEnum::FLOATING;
+    }
+    else
+    {
+        return FormatKindEnum::OTHER;
+    }
+}
+
+constexpr bool accepts(FormatKindEnum kind, char conv)
+{
+    switch (conv)
+    {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c': return kind == FormatKindEnum::INTEGER;
+    case 's': return kind == FormatKindEnum::TEXT;
+    case 'p': return kind == FormatKindEnum::POINTER or kind == FormatKindEnum::TEXT;
+    default: return kind == FormatKindEnum::FLOATING or kind == FormatKindEnum::INTEGER;
+    }
+}
+
+constexpr bool plain(const FormatSpec &sp)
+{
+    return not sp.left and not sp.zero and not sp.plus and not sp.space and not sp.alt and sp.width == 0 and
+           sp.prec < 0;
+}
+
+/**
+ * @brief %08x and the like: zeros, a width that fits the digits
+ */
+constexpr bool zero_padded(const FormatSpec &sp)
+{
+    return sp.zero and not sp.left and not sp.plus and not sp.space and not sp.alt and sp.width <= 16 and
+           sp.prec < 0;
+}
+
+template <typename U> inline void text_of(const U &v, const char *&s, uint32_t &n)
+{
+    if constexpr (std::is_array_v<U>)
+    {
+        const void *nul = memchr(v, '\0', sizeof(U));
+        s               = v;
+        n               = nul != nullptr ? static_cast<uint32_t>(static_cast<const char *>(nul) - v) : sizeof(U);
+    }
+    else if constexpr (std::is_same_v<U, std::string_view>)
+    {
+        s = v.data();
+        n = static_cast<uint32_t>(v.size());
+    }
+    else
+    {
+        s = v != nullptr ? v : "(null)";
+        n = static_cast<uint32_t>(strlen(s));
+    }
+}
+
+/**
+ * @brief the conversion of item I of F, for its argument v
+ */
+template <typename F, std::size_t I, typename T> inline void convert(FormatOut &out, const T &v)
+{
+    using U                     = std::remove_cv_t<std::remove_reference_t<T>>;
+    constexpr FormatSpec sp     = Plan<F>::ITEMS[I].spec;
+    constexpr FormatKindEnum kd = kind_of<U>();
+    static_assert(accepts(kd, sp.conv), "an argument does not fit its conversion");
+
+    if constexpr (not accepts(kd, sp.conv))
+    {
+        (void)out;
+        (void)v;
+    }
+    else if constexpr (sp.conv == 's')
+    {
+        const char *s = nullptr;
+        uint32_t n    = 0;
+        text_of(v, s, n);
+        format_text(out, sp, s, n);
+    }
+    else if constexpr (sp.conv == 'p')
+    {
+        FormatSpec p = sp;
+        p.alt        = true;
+        p.prec       = p.prec < 0 ? 8 : p.prec;
+        const void *a;
+        if constexpr (std::is_same_v<U, std::string_view>)
+        {
+            a = v.data();
+        }
+        else
+        {
+            a = v;
+        }
+        format_int(out, p, reinterpret_cast<uintptr_t>(a), false, 16U, false);
+    }
+    else if constexpr (kd == FormatKindEnum::FLOATING or sp.conv == 'f' or sp.conv == 'F' or sp.conv == 'e' or
+                       sp.conv == 'E' or sp.conv == 'g' or sp.conv == 'G')
+    {
+        format_double(out, sp, static_cast<double>(v));
+    }
+    else if constexpr (sp.conv == 'c')
+    {
+        const char c = static_cast<char>(v);
+        format_text(out, sp, &c, 1U);
+    }
+    else
+    {
+        using I64 = std::conditional_t<std::is_enum_v<U>, std::underlying_type<U>, std::common_type<U>>;
+        using N   = typename I64::type;
+        using M   = std::make_unsigned_t<std::conditional_t<std::is_same_v<N, bool>, unsigned char, N>>;
+        if constexpr (sp.conv == 'x' or sp.conv == 'X' or sp.conv == 'o')
+        {
+            const uint64_t bits = static_cast<M>(v);
+            if constexpr (sp.conv != 'o' and plain(sp))
+            {
+                format_hex(out, bits, 0U, sp.conv == 'X');
+            }
+            else if constexpr (sp.conv != 'o' and zero_padded(sp))
+            {
+                format_hex(out, bits, static_cast<uint32_t>(sp.width), sp.conv == 'X');
+            }
+            else
+            {
+                format_int(out, sp, bits, false, sp.conv == 'o' ? 8U : 16U, sp.conv == 'X');
+            }
+        }
+        else
+        {
+            const N n      = static_cast<N>(v);
+            const bool neg = std::is_signed_v<N> and n < N{};
+            const uint64_t mag =
+                neg ? 0U - static_cast<uint64_t>(static_cast<int64_t>(n)) : static_cast<uint64_t>(static_cast<M>(n));
+            if constexpr (plain(sp))
+            {
+                if (neg)
+                {
+                    out.put('-');
+                }
+                format_dec(out, mag);
+            }
+            else
+            {
+                format_int(out, sp, mag, neg, 10U, false);
+            }
+        }
+    }
+}
+
+template <typename F, std::size_t I, typename Tuple> inline void item(FormatOut &out, const Tuple &args)
+{
+    constexpr FormatItem it = Plan<F>::ITEMS[I];
+    if constexpr (it.arg < 0)
+    {
+        if constexpr (it.len == 1U)
+        {
+            out.put(F::text()[it.at]);
+        }
+        else
+        {
+            out.put(F::text().data() + it.at, it.len);
+        }
+    }
+    else
+    {
+        convert<F, I>(out, std::get<it.arg>(args));
+    }
+}
+
+template <typename F, typename Tuple, std::size_t... I>
+inline void items(FormatOut &out, const Tuple &args, std::index_sequence<I...>)
+{
+    (item<F, I>(out, args), ...);
+}
+
+} // namespace format_detail
+
+
+
+
+/*-------- 6. front end ------------------------------------------------------*/
+
+/**
+ * @brief append to out, cut at its end
+ * @param fmt FMT("...")
+ */
+template <typename F, typename... Args> inline void format_to(FormatOut &out, F fmt, const Args &...args)
+{
+    using Plan = format_detail::Plan<F>;
+    static_assert(Plan::VALID, "a conversion of the format string does not parse");
+    static_assert(Plan::ARGS == static_cast<int32_t>(sizeof...(Args)),
+                  "the format string takes another number of arguments");
+    (void)fmt;
+    format_detail::items<F>(out, std::forward_as_tuple(args...), std::make_index_sequence<Plan::COUNT>{});
+}
+
+/**
+ * @brief like snprintf(): at most size - 1 bytes and a '\0'
+ * @return the bytes written, without the '\0': the cut length, not the
+ *         length it would have had
+ */
+template <typename F, typename... Args>
+inline uint32_t format_to(char *buf, uint32_t size, F fmt, const Args &...args)
+{
+    if (size == 0U)
+    {
+        return 0U;
+    }
+    FormatOut out(buf, size - 1U);
+    format_to(out, fmt, args...);
+    buf[out.len()] = '\0';
+    return out.len();
+}
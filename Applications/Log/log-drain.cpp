@@ -0,0 +1,414 @@
+/**
+ *******************************************************************************
+ * @file    log-drain.cpp
+ * @brief   the consumer of the deferred logger: formatter and drain task
+ *******************************************************************************
+ * @attention
+ *
+ * The drain task runs at osPriorityLow and holds records in the ring while
+ * no host listens on the CDC port (not configured, or no terminal has it
+ * open), and replays them once one does. While parked, the ring keeps the
+ * newest records: beyond LOG_PARK_LIMIT bytes the oldest are discarded and
+ * counted, so producers keep room and the drain never waits on the link.
+ * Lines go out through the transmit scheduler as telemetry (txq-intf.h).
+ *
+ *******************************************************************************
+ * @note
+ *
+ * newlib-nano's printf has neither floating point nor 64-bit support, hence
+ * the conversions of format.hpp. The format string of a record is only known
+ * at drain time: log_format() parses it with format_parse() and converts the
+ * tagged arguments one by one; length modifiers are accepted and ignored
+ * since every argument carries its own type tag.
+ *
+ * For C callers (log_write_fmt) every argument is a 32-bit word: %s then
+ * dereferences the pointer at drain time, so it must point to a string that
+ * outlives the record, typically a literal.
+ *
+ * Every LOG_STATS_PERIOD_MS the task prints the producer statistics when
+ * records were dropped since the last report.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/2
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#ifndef LOG_CDC_PORT
+#define LOG_CDC_PORT        CDC_PORT_SHELL
+#endif
+
+#define LOG_DRAIN_PERIOD_MS 5U      // idle poll period
+#define LOG_STATS_PERIOD_MS 5000U   // drop report period
+#define LOG_LINE_MAX        512U    // one rendered record, \n expanded
+#define LOG_PARK_LIMIT      (LOG_RING_SIZE / 2U) // parked bytes kept, the rest is room for bursts
+#define LOG_SEND_WAIT_MS    100U    // a host that opened the port but does not read
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "log-intf.h"
+#include "../Format/format.hpp"
+#include "../TxSched/txq-intf.h"
+#include "cmsis_os.h"
+#include "stm32h7xx_hal.h"
+#include "usbd_cdc_if.h"
+#include <cstdarg>
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static const osThreadAttr_t s_drain_attr = {
+    .name       = "logDrain",
+    .stack_size = 2048,
+    .priority   = (osPriority_t)osPriorityLow,
+};
+
+static const char s_level_letter[4] = {'D', 'I', 'W', 'E'};
+
+static uint32_t s_parked_dropped       = 0; // records discarded while no host listened
+static uint32_t s_parked_dropped_bytes = 0;
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief expand a format string against the tagged arguments of a record
+ * @param out  destination
+ * @param fmt  format string
+ * @param tags one nibble per argument, LOG_ARG_xxx
+ * @param arg  first argument word
+ * @param end  one past the last word of the record
+ */
+static void log_format(FormatOut &out, const char *fmt, uint32_t tags, const uint32_t *arg, const uint32_t *end)
+{
+    const char *const stop = fmt + strlen(fmt);
+    while (*fmt != '\0')
+    {
+        if (*fmt != '%')
+        {
+            const void *pct   = memchr(fmt, '%', static_cast<size_t>(stop - fmt));
+            const char *after = pct != nullptr ? static_cast<const char *>(pct) : stop;
+            out.put(fmt, static_cast<uint32_t>(after - fmt));
+            fmt = after;
+            continue;
+        }
+        fmt++;
+        if (*fmt == '%')
+        {
+            out.put(*fmt++);
+            continue;
+        }
+
+        FormatSpec sp;
+        (void)format_parse(fmt, stop, sp);
+        if (sp.conv == '\0')
+        {
+            break;
+        }
+
+        const uint32_t tag = tags & 0xFU;
+        tags >>= 4;
+        if (tag == 0U or arg >= end)
+        {
+            out.put("%?", 2); // more conversions than arguments
+            continue;
+        }
+
+        /* fetch the argument */
+        uint64_t raw   = arg[0];
+        double dbl     = 0.0;
+        const char *str = nullptr;
+        uint32_t str_len = 0;
+        switch (tag)
+        {
+        case LOG_ARG_I32:
+            raw = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(arg[0])));
+            arg += 1;
+            break;
+        case LOG_ARG_U64:
+        case LOG_ARG_I64:
+            raw = static_cast<uint64_t>(arg[0]) | (static_cast<uint64_t>(arg[1]) << 32);
+            arg += 2;
+            break;
+        case LOG_ARG_F64:
+            memcpy(&dbl, arg, 8);
+            arg += 2;
+            break;
+        case LOG_ARG_STR:
+            str_len = arg[0];
+            str     = reinterpret_cast<const char *>(arg + 1);
+            arg += 1U + ((str_len + 3U) >> 2);
+            break;
+        default:
+            arg += 1;
+            break;
+        }
+
+        switch (sp.conv)
+        {
+        case 'd':
+        case 'i': {
+            int64_t s = static_cast<int64_t>(raw);
+            if (tag == LOG_ARG_U32 or tag == LOG_ARG_PTR)
+            {
+                s = static_cast<int32_t>(raw); // C callers pass every value as a word
+            }
+            if (tag == LOG_ARG_F64)
+            {
+                s = static_cast<int64_t>(dbl);
+            }
+            const bool neg = s < 0;
+            format_int(out, sp, neg ? 0U - static_cast<uint64_t>(s) : static_cast<uint64_t>(s), neg, 10U, false);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o': {
+            if (tag == LOG_ARG_I32)
+            {
+                raw &= 0xFFFFFFFFU;
+            }
+            const uint32_t base = sp.conv == 'u' ? 10U : (sp.conv == 'o' ? 8U : 16U);
+            format_int(out, sp, raw, false, base, sp.conv == 'X');
+            break;
+        }
+        case 'p':
+            sp.alt = true;
+            if (sp.prec < 0)
+            {
+                sp.prec = 8;
+            }
+            format_int(out, sp, raw & 0xFFFFFFFFU, false, 16U, false);
+            break;
+        case 'c': {
+            const char c = static_cast<char>(raw);
+            format_text(out, sp, &c, 1U);
+            break;
+        }
+        case 's':
+            if (tag == LOG_ARG_STR)
+            {
+                format_text(out, sp, str, str_len);
+            }
+            else
+            {
+                str = reinterpret_cast<const char *>(static_cast<uintptr_t>(raw));
+                str = str != nullptr ? str : "(null)";
+                format_text(out, sp, str, static_cast<uint32_t>(strlen(str)));
+            }
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            if (tag != LOG_ARG_F64)
+            {
+                dbl = tag == LOG_ARG_I32 or tag == LOG_ARG_I64 ? static_cast<double>(static_cast<int64_t>(raw))
+                                                              : static_cast<double>(raw);
+            }
+            format_double(out, sp, dbl);
+            break;
+        default:
+            out.put('%');
+            out.put(sp.conv);
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief render one record as text
+ * @return number of bytes in `buf`
+ */
+static uint32_t log_render(const uint32_t *rec, char *buf, uint32_t cap)
+{
+    FormatOut out(buf, cap - 2U); // room for the line end
+    const uint32_t header = rec[0];
+    const uint32_t *end   = rec + LOG_HDR_SIZE(header) / 4U;
+
+    if (LOG_HDR_TYPE(header) == LOG_REC_TEXT)
+    {
+        const char *s = reinterpret_cast<const char *>(&rec[LOG_HDR_WORDS + 1U]);
+        for (uint32_t i = 0; i < rec[LOG_HDR_WORDS]; i++)
+        {
+            if (s[i] == '\n' and (i == 0U or s[i - 1U] != '\r'))
+            {
+                out.put('\r');
+            }
+            out.put(s[i]);
+        }
+        return out.len();
+    }
+
+    const uint32_t ms = rec[1];
+    format_to(out, FMT("[%5u.%03u] %c "), ms / 1000U, ms % 1000U, s_level_letter[LOG_HDR_LEVEL(header) & 3U]);
+
+    const char *fmt = reinterpret_cast<const char *>(static_cast<uintptr_t>(rec[LOG_HDR_WORDS]));
+    log_format(out, fmt, rec[LOG_HDR_WORDS + 1U], &rec[LOG_HDR_WORDS + 2U], end);
+
+    const uint32_t n = out.len();
+    buf[n]           = '\r';
+    buf[n + 1U]      = '\n';
+    return n + 2U;
+}
+
+
+/**
+ * @brief queue a whole line as telemetry, waiting a little for room
+ * @note  if the host goes away, or stops reading, the line is written
+ *        anyway: the scheduler keeps what fits and counts the rest
+ */
+static void log_send(const char *buf, uint32_t len)
+{
+    const uint32_t t0 = HAL_GetTick();
+    while (txq_free(TXQ_TELEMETRY) < len and CDC_HostOpen_HS(LOG_CDC_PORT) != 0U and
+           (HAL_GetTick() - t0) < LOG_SEND_WAIT_MS)
+    {
+        osDelay(1);
+    }
+    (void)txq_write(TXQ_TELEMETRY, reinterpret_cast<const uint8_t *>(buf), len);
+}
+
+
+/**
+ * @brief nobody listens: keep the newest LOG_PARK_LIMIT bytes of records
+ */
+static void log_park()
+{
+    while (log_pending() > LOG_PARK_LIMIT)
+    {
+        const uint32_t *rec = log_peek();
+        if (rec == nullptr)
+        {
+            return;
+        }
+        s_parked_dropped++;
+        s_parked_dropped_bytes += LOG_HDR_SIZE(rec[0]);
+        log_release(rec);
+    }
+}
+
+
+/**
+ * @brief tell the host what was discarded while it was away
+ */
+static void log_report_parked(char *line, uint32_t cap)
+{
+    if (s_parked_dropped == 0U)
+    {
+        return;
+    }
+
+    static const char fmt[] = "log: %lu records (%lu bytes) discarded while no host listened";
+    const uint32_t rec[LOG_HDR_WORDS + 2U + 2U] = {
+        LOG_MK_HDR((LOG_HDR_WORDS + 2U + 2U) * 4U, LOG_REC_FMT, LOG_LEVEL_WARN),
+        HAL_GetTick(),
+        dwt_cycle_now(),
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fmt)),
+        0x11U,
+        s_parked_dropped,
+        s_parked_dropped_bytes,
+    };
+    s_parked_dropped       = 0;
+    s_parked_dropped_bytes = 0;
+    log_send(line, log_render(rec, line, cap));
+}
+
+
+/**
+ * @brief print the producer statistics if records were lost
+ */
+static void log_report(char *line, uint32_t cap, uint32_t &last_dropped)
+{
+    LogStatsTypeDef st;
+    log_get_stats(&st);
+    if (st.dropped == last_dropped)
+    {
+        return;
+    }
+    last_dropped = st.dropped;
+
+    /* built as a record on the stack, so it bypasses a possibly full ring */
+    static const char fmt[] =
+        "log: %lu records, %lu dropped (%lu bytes), cost avg %lu max %lu cycles, high water %lu bytes";
+    const uint64_t calls = static_cast<uint64_t>(st.records) + st.dropped;
+    const uint32_t rec[LOG_HDR_WORDS + 2U + 6U] = {
+        LOG_MK_HDR((LOG_HDR_WORDS + 2U + 6U) * 4U, LOG_REC_FMT, LOG_LEVEL_WARN),
+        HAL_GetTick(),
+        dwt_cycle_now(),
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fmt)),
+        0x111111U,
+        st.records,
+        st.dropped,
+        st.droppedBytes,
+        calls != 0U ? static_cast<uint32_t>(st.cyclesSum / calls) : 0U,
+        st.cyclesMax,
+        st.highWater,
+    };
+    log_send(line, log_render(rec, line, cap));
+}
+
+
+/**
+ * @brief drain task: render the oldest record while a host listens
+ */
+static void log_drain_task(void *argument)
+{
+    (void)argument;
+    static char line[LOG_LINE_MAX];
+    uint32_t last_dropped = 0;
+    uint32_t last_report  = 0;
+
+    for (;;)
+    {
+        const uint32_t now = HAL_GetTick();
+        if (CDC_HostOpen_HS(LOG_CDC_PORT) == 0U)
+        {
+            log_park();
+            osDelay(LOG_DRAIN_PERIOD_MS);
+            continue;
+        }
+        log_report_parked(line, sizeof(line));
+        if (now - last_report >= LOG_STATS_PERIOD_MS)
+        {
+            last_report = now;
+            log_report(line, sizeof(line), last_dropped);
+        }
+
+        const uint32_t *rec = log_peek();
+        if (rec == nullptr)
+        {
+            osDelay(LOG_DRAIN_PERIOD_MS);
+            continue;
+        }
+        const uint32_t len = log_render(rec, line, sizeof(line));
+        log_release(rec);
+        log_send(line, len);
+    }
+}
+
+
+/**
+ * @brief create the drain task
+ */
+extern "C" void log_drain_start(void)
+{
+    (void)osThreadNew(log_drain_task, nullptr, &s_drain_attr);
+}
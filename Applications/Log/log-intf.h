@@ -0,0 +1,369 @@
+/**
+ *******************************************************************************
+ * @file    log-intf.h
+ * @brief   the interface of the deferred logger
+ *******************************************************************************
+ * @attention
+ *
+ * Producers never block and never format: a call reserves a record in a
+ * lock-free ring, copies the format pointer and the raw arguments, and
+ * returns. The format string must therefore live as long as the firmware
+ * (a string literal); string arguments are copied, truncated to
+ * LOG_MAX_STR_ARG bytes.
+ *
+ * Every function here is safe from any task and from any interrupt priority,
+ * including priorities above configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The logger is made of three parts:
+ *
+ * +---------------------------------------------------------------------------+
+ * |        producers: LOG_xxx() / log_write_fmt() / log_write_text() / printf |
+ * +---------------------------------------------------------------------------+
+ *                                      | reserve (CAS) + commit
+ * +---------------------------------------------------------------------------+
+ * |        log-ring.cpp: multi-producer / single-consumer ring in AXI SRAM    |
+ * +---------------------------------------------------------------------------+
+ *                                      | drain task, lowest priority
+ * +---------------------------------------------------------------------------+
+ * |        log-drain.cpp: formats records and writes them to the USB CDC port |
+ * +---------------------------------------------------------------------------+
+ *
+ * A record is a sequence of 32-bit words, the first one being its header
+ * (size | type | level). Producers write the payload first and the header
+ * last, the consumer stops at the first header still equal to zero, so a
+ * producer interrupted between reserve and commit only delays the drain.
+ *
+ * newlib's _write() is retargeted into the ring as text records, which makes
+ * printf() non-blocking (printf itself is still not interrupt safe).
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/2
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../../Drivers/Peripheral/DWT/dwt-cycle.h"
+
+#ifdef __cplusplus
+#include <type_traits>
+#endif
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define LOG_RING_SIZE       32768U  // bytes, power of two, placed in AXI SRAM
+#define LOG_MAX_RECORD      256U    // bytes, header included
+#define LOG_MAX_ARGS        8U      // one tag nibble per argument in one word
+#define LOG_MAX_STR_ARG     48U     // bytes copied for a string argument
+
+/* record types */
+#define LOG_REC_PAD         0x01U   // filler up to the end of the ring
+#define LOG_REC_FMT         0x02U   // format pointer + tagged arguments
+#define LOG_REC_TEXT        0x03U   // raw bytes, no prefix (printf)
+
+/* argument tags, one nibble each */
+#define LOG_ARG_U32         0x1U
+#define LOG_ARG_I32         0x2U
+#define LOG_ARG_U64         0x3U
+#define LOG_ARG_I64         0x4U
+#define LOG_ARG_F64         0x5U
+#define LOG_ARG_PTR         0x6U
+#define LOG_ARG_STR         0x7U    // length word + bytes, padded to a word
+
+/* words in front of every record: header, tick (ms), cycle stamp */
+#define LOG_HDR_WORDS       3U
+
+#define LOG_MK_HDR(size, type, level) \
+    ((uint32_t)(size) | ((uint32_t)(type) << 16) | ((uint32_t)(level) << 24))
+#define LOG_HDR_SIZE(h)     ((h) & 0xFFFFU)
+#define LOG_HDR_TYPE(h)     (((h) >> 16) & 0xFFU)
+#define LOG_HDR_LEVEL(h)    (((h) >> 24) & 0xFFU)
+
+
+
+
+/*-------- 3. typedef --------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief log levels, the drain prints them as one letter
+ */
+typedef enum
+{
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO  = 1,
+    LOG_LEVEL_WARN  = 2,
+    LOG_LEVEL_ERROR = 3,
+} LogLevelEnum;
+
+/**
+ * @brief counters of the producer side
+ */
+typedef struct
+{
+    uint32_t records;       // committed records
+    uint32_t dropped;       // records refused, ring full or record too large
+    uint32_t droppedBytes;  // payload bytes of the refused records
+    uint32_t cyclesMax;     // worst producer call, in core cycles
+    uint32_t cyclesLast;    // last producer call, in core cycles
+    uint64_t cyclesSum;     // for the average: cyclesSum / (records + dropped)
+    uint32_t highWater;     // largest ring fill seen by a producer, bytes
+} LogStatsTypeDef;
+
+
+
+
+/*-------- 4. function prototypes --------------------------------------------*/
+
+/**
+ * @brief clear the ring and start the drain task, call once before the
+ *        scheduler starts; records written before are dropped
+ */
+void log_init(void);
+
+/**
+ * @brief low level: reserve a record of `bytes` (multiple of 4, header
+ *        included), returns NULL when it does not fit
+ */
+uint32_t *log_reserve(uint32_t bytes);
+
+/**
+ * @brief low level: publish a reserved record by writing its header
+ */
+void log_commit(uint32_t *rec, uint32_t header);
+
+/**
+ * @brief account one producer call in the statistics
+ */
+void log_account(uint32_t cycles, uint32_t ok, uint32_t bytes);
+
+/**
+ * @brief deferred printf with 32-bit arguments, for C callers
+ * @param level LogLevelEnum
+ * @param fmt   string literal
+ * @param nargs number of following uint32_t arguments (max LOG_MAX_ARGS)
+ */
+void log_write_fmt(uint8_t level, const char *fmt, uint32_t nargs, ...);
+
+/**
+ * @brief copy raw text into the ring, written as is by the drain
+ * @note  long text is split into several records
+ * @return number of bytes accepted, the rest is counted as dropped
+ */
+int log_write_text(const char *buf, int len);
+
+/**
+ * @brief snapshot of the producer counters
+ */
+void log_get_stats(LogStatsTypeDef *stats);
+
+/**
+ * @brief bytes currently waiting in the ring
+ */
+uint32_t log_pending(void);
+
+/* consumer side, used by log-drain.cpp only */
+
+/**
+ * @brief oldest committed record, NULL when the ring is empty or the oldest
+ *        record is still being written; PAD records are skipped
+ */
+const uint32_t *log_peek(void);
+
+/**
+ * @brief give the record returned by log_peek() back to the producers
+ */
+void log_release(const uint32_t *rec);
+
+/**
+ * @brief create the drain task, called by log_init()
+ */
+void log_drain_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+
+/*-------- 5. C++ front end --------------------------------------------------*/
+
+#ifdef __cplusplus
+
+namespace log_detail
+{
+
+/**
+ * @brief tag of one argument, resolved at compile time
+ */
+template <typename T> constexpr uint32_t tag_of()
+{
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, const char *> or std::is_same_v<U, char *>)
+    {
+        return LOG_ARG_STR;
+    }
+    else if constexpr (std::is_pointer_v<U>)
+    {
+        return LOG_ARG_PTR;
+    }
+    else if constexpr (std::is_floating_point_v<U>)
+    {
+        return LOG_ARG_F64;
+    }
+    else if constexpr (std::is_enum_v<U>)
+    {
+        return sizeof(U) > 4 ? LOG_ARG_U64 : LOG_ARG_U32;
+    }
+    else
+    {
+        static_assert(std::is_integral_v<U>, "log argument must be integral, floating, pointer or string");
+        if constexpr (sizeof(U) > 4)
+        {
+            return std::is_signed_v<U> ? LOG_ARG_I64 : LOG_ARG_U64;
+        }
+        else
+        {
+            return std::is_signed_v<U> ? LOG_ARG_I32 : LOG_ARG_U32;
+        }
+    }
+}
+
+inline uint32_t bounded_strlen(const char *s)
+{
+    uint32_t n = 0;
+    if (s == nullptr)
+    {
+        return 0;
+    }
+    while (n < LOG_MAX_STR_ARG and s[n] != '\0')
+    {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief payload size of one argument, in bytes
+ */
+template <typename T> inline uint32_t arg_size(const T &v)
+{
+    constexpr uint32_t tag = tag_of<T>();
+    if constexpr (tag == LOG_ARG_STR)
+    {
+        return 4U + ((bounded_strlen(v) + 3U) & ~3U);
+    }
+    else if constexpr (tag == LOG_ARG_U64 or tag == LOG_ARG_I64 or tag == LOG_ARG_F64)
+    {
+        return 8U;
+    }
+    else
+    {
+        return 4U;
+    }
+}
+
+/**
+ * @brief store one argument, returns the next free word
+ */
+template <typename T> inline uint32_t *arg_put(uint32_t *p, const T &v)
+{
+    constexpr uint32_t tag = tag_of<T>();
+    if constexpr (tag == LOG_ARG_STR)
+    {
+        uint32_t n = bounded_strlen(v);
+        *p++ = n;
+        if (n != 0U)
+        {
+            memcpy(p, v, n);
+        }
+        return p + ((n + 3U) >> 2);
+    }
+    else if constexpr (tag == LOG_ARG_F64)
+    {
+        double d = static_cast<double>(v);
+        memcpy(p, &d, 8);
+        return p + 2;
+    }
+    else if constexpr (tag == LOG_ARG_U64 or tag == LOG_ARG_I64)
+    {
+        uint64_t u = static_cast<uint64_t>(v);
+        p[0] = static_cast<uint32_t>(u);
+        p[1] = static_cast<uint32_t>(u >> 32);
+        return p + 2;
+    }
+    else if constexpr (tag == LOG_ARG_PTR)
+    {
+        *p++ = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(v));
+        return p;
+    }
+    else
+    {
+        *p++ = static_cast<uint32_t>(v);
+        return p;
+    }
+}
+
+} // namespace log_detail
+
+
+/**
+ * @brief deferred, type tagged printf
+ * @note  costs a CAS, a few stores per argument and a memcpy per string
+ */
+template <typename... Args>
+inline void log_emit(LogLevelEnum level, const char *fmt, const Args &...args)
+{
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+
+    const uint32_t t0 = dwt_cycle_now();
+    uint32_t tags     = 0;
+    uint32_t shift    = 0;
+    ((tags |= log_detail::tag_of<Args>() << shift, shift += 4), ...);
+    (void)shift;
+
+    const uint32_t bytes = (LOG_HDR_WORDS + 2U) * 4U + (0U + ... + log_detail::arg_size(args));
+    uint32_t *rec        = log_reserve(bytes);
+    if (rec == nullptr)
+    {
+        log_account(dwt_cycle_now() - t0, 0U, bytes);
+        return;
+    }
+
+    uint32_t *p = rec + LOG_HDR_WORDS;
+    *p++        = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fmt));
+    *p++        = tags;
+    ((p = log_detail::arg_put(p, args)), ...);
+
+    log_commit(rec, LOG_MK_HDR(bytes, LOG_REC_FMT, level));
+    log_account(dwt_cycle_now() - t0, 1U, bytes);
+}
+
+#define LOG_DEBUG(fmt, ...) log_emit(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  log_emit(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  log_emit(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) log_emit(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+#endif /* __cplusplus */
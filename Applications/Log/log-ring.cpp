@@ -0,0 +1,331 @@
+/**
+ *******************************************************************************
+ * @file    log-ring.cpp
+ * @brief   the multi-producer ring of the deferred logger
+ *******************************************************************************
+ * @attention
+ *
+ * The ring lives in AXI SRAM (section .axi_sram, RAM_D1) which is not touched
+ * by the startup code: log_init() clears it, until then every producer call
+ * is refused.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The write index is claimed with a compare-and-swap (LDREX/STREX), so tasks
+ * and interrupts of any priority can produce concurrently without masking
+ * interrupts. A record never wraps: when the end of the ring is too close the
+ * producer claims the tail of the ring too and fills it with a PAD record.
+ *
+ * The drain task is the only consumer. It zeroes what it has consumed before
+ * moving the read index, which keeps the invariant "header == 0 means not
+ * committed yet" for every byte a producer can claim.
+ *
+ * Only the statistics are updated under a short PRIMASK section, since the
+ * 64-bit cycle sum has no lock-free atomic on the Cortex-M7.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/2
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define LOG_RING_MASK       (LOG_RING_SIZE - 1U)
+#define LOG_TEXT_CHUNK      (LOG_MAX_RECORD - (LOG_HDR_WORDS + 1U) * 4U)
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "log-intf.h"
+#include "../app-intf.h"
+#include "stm32h7xx_hal.h"
+#include <atomic>
+#include <cstdarg>
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static uint32_t s_ring[LOG_RING_SIZE / 4U] __attribute__((section(".axi_sram"), aligned(32)));
+
+static std::atomic<uint32_t> s_head{0}; // free running byte index, producers
+static std::atomic<uint32_t> s_tail{0}; // free running byte index, drain task
+static std::atomic<bool> s_ready{false};
+
+static LogStatsTypeDef s_stats = {};
+
+static_assert((LOG_RING_SIZE & LOG_RING_MASK) == 0U, "LOG_RING_SIZE must be a power of two");
+static_assert(LOG_MAX_RECORD <= 0xFFFFU and (LOG_MAX_RECORD % 4U) == 0U, "bad LOG_MAX_RECORD");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the ring needs lock-free 32-bit atomics");
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief clear the ring and start the drain task
+ */
+extern "C" void log_init(void)
+{
+    dwt_cycle_init();
+    memset(s_ring, 0, sizeof(s_ring));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_head.store(0U, std::memory_order_relaxed);
+    s_tail.store(0U, std::memory_order_relaxed);
+    s_ready.store(true, std::memory_order_release);
+    log_drain_start();
+}
+
+APP_REGISTER(20, log, log_init); // its drain transmits through txq
+
+
+/**
+ * @brief claim `bytes` contiguous bytes, padding the end of the ring if needed
+ * @param bytes record size, multiple of 4, header included
+ * @return the record, stamped but not committed, or nullptr
+ */
+extern "C" uint32_t *log_reserve(uint32_t bytes)
+{
+    if (not s_ready.load(std::memory_order_acquire) or bytes > LOG_MAX_RECORD or (bytes & 3U) != 0U or
+        bytes < LOG_HDR_WORDS * 4U)
+    {
+        return nullptr;
+    }
+
+    uint32_t head = s_head.load(std::memory_order_relaxed);
+    uint32_t pad;
+    uint32_t used;
+    do
+    {
+        const uint32_t offset     = head & LOG_RING_MASK;
+        const uint32_t contiguous = LOG_RING_SIZE - offset;
+        pad                       = contiguous < bytes ? contiguous : 0U;
+        used                      = head + pad + bytes - s_tail.load(std::memory_order_acquire);
+        if (used > LOG_RING_SIZE)
+        {
+            return nullptr;
+        }
+    } while (not s_head.compare_exchange_weak(head, head + pad + bytes, std::memory_order_acquire,
+                                              std::memory_order_relaxed));
+
+    if (used > s_stats.highWater)
+    {
+        s_stats.highWater = used; // racy on purpose, only a hint
+    }
+
+    if (pad != 0U)
+    {
+        __atomic_store_n(&s_ring[(head & LOG_RING_MASK) / 4U], LOG_MK_HDR(pad, LOG_REC_PAD, 0U), __ATOMIC_RELEASE);
+    }
+
+    uint32_t *rec = &s_ring[((head + pad) & LOG_RING_MASK) / 4U];
+    rec[1]        = HAL_GetTick();
+    rec[2]        = dwt_cycle_now();
+    return rec;
+}
+
+
+/**
+ * @brief publish a record: every payload store is ordered before the header
+ */
+extern "C" void log_commit(uint32_t *rec, uint32_t header)
+{
+    __atomic_store_n(rec, header, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * @brief account one producer call
+ * @param cycles cost of the call
+ * @param ok     1 when the record was committed
+ * @param bytes  size of the record
+ */
+extern "C" void log_account(uint32_t cycles, uint32_t ok, uint32_t bytes)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (ok != 0U)
+    {
+        s_stats.records++;
+    }
+    else
+    {
+        s_stats.dropped++;
+        s_stats.droppedBytes += bytes;
+    }
+    s_stats.cyclesLast = cycles;
+    s_stats.cyclesSum += cycles;
+    if (cycles > s_stats.cyclesMax)
+    {
+        s_stats.cyclesMax = cycles;
+    }
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief deferred printf for C code, every argument is a 32-bit word
+ */
+extern "C" void log_write_fmt(uint8_t level, const char *fmt, uint32_t nargs, ...)
+{
+    const uint32_t t0 = dwt_cycle_now();
+    if (nargs > LOG_MAX_ARGS)
+    {
+        nargs = LOG_MAX_ARGS;
+    }
+
+    const uint32_t bytes = (LOG_HDR_WORDS + 2U + nargs) * 4U;
+    uint32_t *rec        = log_reserve(bytes);
+    if (rec == nullptr)
+    {
+        log_account(dwt_cycle_now() - t0, 0U, bytes);
+        return;
+    }
+
+    uint32_t *p = rec + LOG_HDR_WORDS;
+    *p++        = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fmt));
+    uint32_t tags = 0U;
+    for (uint32_t i = 0; i < nargs; i++)
+    {
+        tags |= LOG_ARG_U32 << (i * 4U);
+    }
+    *p++ = tags;
+
+    va_list ap;
+    va_start(ap, nargs);
+    for (uint32_t i = 0; i < nargs; i++)
+    {
+        *p++ = va_arg(ap, uint32_t);
+    }
+    va_end(ap);
+
+    log_commit(rec, LOG_MK_HDR(bytes, LOG_REC_FMT, level));
+    log_account(dwt_cycle_now() - t0, 1U, bytes);
+}
+
+
+/**
+ * @brief copy raw text into the ring
+ */
+extern "C" int log_write_text(const char *buf, int len)
+{
+    int done = 0;
+    while (done < len)
+    {
+        const uint32_t t0    = dwt_cycle_now();
+        const uint32_t n     = static_cast<uint32_t>(len - done) < LOG_TEXT_CHUNK
+                                   ? static_cast<uint32_t>(len - done)
+                                   : LOG_TEXT_CHUNK;
+        const uint32_t bytes = (LOG_HDR_WORDS + 1U) * 4U + ((n + 3U) & ~3U);
+        uint32_t *rec        = log_reserve(bytes);
+        if (rec == nullptr)
+        {
+            log_account(dwt_cycle_now() - t0, 0U, static_cast<uint32_t>(len - done));
+            break;
+        }
+        rec[LOG_HDR_WORDS] = n;
+        memcpy(&rec[LOG_HDR_WORDS + 1U], buf + done, n);
+        log_commit(rec, LOG_MK_HDR(bytes, LOG_REC_TEXT, LOG_LEVEL_INFO));
+        log_account(dwt_cycle_now() - t0, 1U, bytes);
+        done += static_cast<int>(n);
+    }
+    return done;
+}
+
+
+/**
+ * @brief snapshot of the producer counters
+ */
+extern "C" void log_get_stats(LogStatsTypeDef *stats)
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = s_stats;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief bytes claimed and not consumed yet
+ */
+extern "C" uint32_t log_pending(void)
+{
+    return s_head.load(std::memory_order_acquire) - s_tail.load(std::memory_order_relaxed);
+}
+
+
+/**
+ * @brief oldest committed record, skipping padding
+ */
+extern "C" const uint32_t *log_peek(void)
+{
+    for (;;)
+    {
+        const uint32_t tail = s_tail.load(std::memory_order_relaxed);
+        if (tail == s_head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        uint32_t *rec         = &s_ring[(tail & LOG_RING_MASK) / 4U];
+        const uint32_t header = __atomic_load_n(rec, __ATOMIC_ACQUIRE);
+        if (header == 0U)
+        {
+            return nullptr; // claimed, not committed yet
+        }
+        if (LOG_HDR_TYPE(header) != LOG_REC_PAD)
+        {
+            return rec;
+        }
+        log_release(rec);
+    }
+}
+
+
+/**
+ * @brief zero the record then hand its bytes back to the producers
+ */
+extern "C" void log_release(const uint32_t *rec)
+{
+    const uint32_t size = LOG_HDR_SIZE(*rec);
+    memset(const_cast<uint32_t *>(rec), 0, size);
+    s_tail.fetch_add(size, std::memory_order_release);
+}
+
+
+/**
+ * @brief newlib output hook: printf() and friends end up in the ring
+ * @note  always reports the whole buffer as written, losses are counted as
+ *        drops instead of making newlib retry forever on a full ring
+ */
+extern "C" int _write(int file, char *ptr, int len)
+{
+    (void)file;
+    (void)log_write_text(ptr, len);
+    return len;
+}
+
+
+/**
+ * @brief picolibc output hook, one character per call
+ */
+extern "C" int __io_putchar(int ch)
+{
+    const char c = static_cast<char>(ch);
+    (void)log_write_text(&c, 1);
+    return ch;
+}
@@ -0,0 +1,357 @@
+/**
+ *******************************************************************************
+ * @file    shell-args.cpp
+ * @brief   the words of a command line, split in place, and typed arguments
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-args.hpp.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The parsers are written for words of a command line: short, ASCII, no
+ * locale, no errno, no leading spaces to skip (the tokenizer removed them),
+ * and they refuse what strtol() would silently accept: trailing garbage,
+ * overflow, an empty word.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/12
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-args.hpp"
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief value of a hex digit, 16 for anything else
+ */
+static uint32_t hex_digit(char c)
+{
+    if (c >= '0' and c <= '9')
+    {
+        return static_cast<uint32_t>(c - '0');
+    }
+    c = static_cast<char>(c | 0x20); // lower case
+    return c >= 'a' and c <= 'f' ? static_cast<uint32_t>(c - 'a' + 10) : 16U;
+}
+
+
+/**
+ * @brief quotes and escapes are removed by moving the bytes down: the write
+ *        position never passes the read position, so one buffer is enough
+ */
+const char *shell_tokenize(char *line, uint32_t len, ShellArgv &out)
+{
+    uint32_t r = 0;
+    uint32_t w = 0;
+    out.argc   = 0;
+    for (;;)
+    {
+        while (r < len and (line[r] == ' ' or line[r] == '\t'))
+        {
+            r++;
+        }
+        if (r == len)
+        {
+            return nullptr;
+        }
+        if (out.argc == SHELL_ARGC_MAX)
+        {
+            return "too many words";
+        }
+
+        const uint32_t start = w;
+        char quote           = 0;
+        while (r < len)
+        {
+            char c = line[r];
+            if (quote == 0 and (c == ' ' or c == '\t'))
+            {
+                break;
+            }
+            r++;
+            if (c == quote or (quote == 0 and (c == '"' or c == '\'')))
+            {
+                quote = quote == 0 ? c : 0;
+                continue;
+            }
+            if (c == '\\' and quote != '\'')
+            {
+                if (r == len)
+                {
+                    return "bad escape";
+                }
+                c = line[r++];
+                if (c == 'n')
+                {
+                    c = '\n';
+                }
+                else if (c == 't')
+                {
+                    c = '\t';
+                }
+                else if (c == 'x')
+                {
+                    const uint32_t hi = r < len ? hex_digit(line[r]) : 16U;
+                    const uint32_t lo = r + 1U < len ? hex_digit(line[r + 1U]) : 16U;
+                    if (hi > 15U or lo > 15U)
+                    {
+                        return "bad escape";
+                    }
+                    c = static_cast<char>(hi << 4 | lo);
+                    r += 2U;
+                }
+            }
+            line[w++] = c;
+        }
+        if (quote != 0)
+        {
+            return "unterminated quote";
+        }
+
+        // the separator that ended the word, if any, is consumed before the
+        // terminator takes a byte: w < r, or w <= r == len < SHELL_LINE_MAX
+        r += r < len ? 1U : 0U;
+        out.argv[out.argc++] = std::string_view(&line[start], w - start);
+        line[w++]            = '\0';
+    }
+}
+
+
+/**
+ * @brief decimal digits only, refused on overflow
+ */
+static bool parse_dec(std::string_view s, uint32_t &out)
+{
+    if (s.empty())
+    {
+        return false;
+    }
+    uint32_t v = 0;
+    for (const char c : s)
+    {
+        const uint32_t d = static_cast<uint32_t>(c - '0');
+        if (d > 9U or v > (UINT32_MAX - d) / 10U)
+        {
+            return false;
+        }
+        v = v * 10U + d;
+    }
+    out = v;
+    return true;
+}
+
+
+bool shell_parse_uint(std::string_view s, uint32_t &out)
+{
+    if (s.size() > 2U and s[0] == '0' and (s[1] == 'x' or s[1] == 'X'))
+    {
+        return shell_parse_hex(s, out);
+    }
+    return parse_dec(s, out);
+}
+
+
+bool shell_parse_int(std::string_view s, int32_t &out)
+{
+    const bool neg = not s.empty() and s[0] == '-';
+    if (not s.empty() and (s[0] == '-' or s[0] == '+'))
+    {
+        s.remove_prefix(1);
+    }
+    uint32_t v = 0;
+    if (not parse_dec(s, v) or v > (neg ? 0x80000000U : 0x7FFFFFFFU))
+    {
+        return false;
+    }
+    out = neg ? static_cast<int32_t>(0U - v) : static_cast<int32_t>(v);
+    return true;
+}
+
+
+bool shell_parse_hex(std::string_view s, uint32_t &out)
+{
+    if (s.size() > 2U and s[0] == '0' and (s[1] == 'x' or s[1] == 'X'))
+    {
+        s.remove_prefix(2);
+    }
+    if (s.empty() or s.size() > 8U)
+    {
+        return false;
+    }
+    uint32_t v = 0;
+    for (const char c : s)
+    {
+        const uint32_t d = hex_digit(c);
+        if (d > 15U)
+        {
+            return false;
+        }
+        v = v << 4 | d;
+    }
+    out = v;
+    return true;
+}
+
+
+/**
+ * @brief decimal mantissa scaled by a power of ten, in double: exact for the
+ *        short words of a command line, rounded once to float
+ */
+bool shell_parse_float(std::string_view s, float &out)
+{
+    static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    size_t i       = 0;
+    const bool neg = i < s.size() and s[i] == '-';
+    i += i < s.size() and (s[i] == '-' or s[i] == '+') ? 1U : 0U;
+
+    uint64_t mant  = 0;
+    int32_t exp10  = 0;
+    uint32_t seen  = 0;
+    bool dot       = false;
+    for (; i < s.size(); i++)
+    {
+        const char c = s[i];
+        if (c == '.' and not dot)
+        {
+            dot = true;
+            continue;
+        }
+        const uint32_t d = static_cast<uint32_t>(c - '0');
+        if (d > 9U)
+        {
+            break;
+        }
+        seen++;
+        if (mant < 100000000000000000ULL)
+        {
+            mant = mant * 10U + d;
+            exp10 -= dot ? 1 : 0;
+        }
+        else
+        {
+            exp10 += dot ? 0 : 1; // digits beyond what a float can show
+        }
+    }
+    if (seen == 0U)
+    {
+        return false;
+    }
+
+    if (i < s.size() and (s[i] == 'e' or s[i] == 'E'))
+    {
+        int32_t e = 0;
+        if (not shell_parse_int(s.substr(i + 1U), e) or e > 99 or e < -99)
+        {
+            return false;
+        }
+        exp10 += e;
+        i = s.size();
+    }
+    if (i != s.size())
+    {
+        return false;
+    }
+
+    double v = static_cast<double>(mant);
+    for (; exp10 > 22; exp10 -= 22)
+    {
+        v *= 1e22;
+    }
+    for (; exp10 < -22; exp10 += 22)
+    {
+        v /= 1e22;
+    }
+    v = exp10 >= 0 ? v * pow10[exp10] : v / pow10[-exp10];
+    if (v > 3.4028234663852886e38)
+    {
+        return false;
+    }
+    out = static_cast<float>(neg ? -v : v);
+    return true;
+}
+
+
+bool shell_parse_bool(std::string_view s, bool &out)
+{
+    if (s == "on" or s == "1" or s == "true")
+    {
+        out = true;
+        return true;
+    }
+    if (s == "off" or s == "0" or s == "false")
+    {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+
+bool shell_parse_pin(std::string_view s, ShellPin &out)
+{
+    if (s.size() < 3U or s.size() > 4U or (s[0] | 0x20) != 'p')
+    {
+        return false;
+    }
+    const uint32_t port = static_cast<uint32_t>((s[1] | 0x20) - 'a');
+    uint32_t pin        = 0;
+    if (port > static_cast<uint32_t>(GpioPortEnum::GPIO_PORT_H) - 1U or (s.size() == 4U and s[2] == '0') or
+        not parse_dec(s.substr(2), pin) or pin > 15U)
+    {
+        return false;
+    }
+    out.port = static_cast<GpioPortEnum>(port + 1U); // NONE comes first in both enums
+    out.pin  = static_cast<GpioPinEnum>(pin + 1U);
+    return true;
+}
+
+
+/**
+ * @brief the name and the arguments, nothing after the name for a handler
+ *        that takes the words itself
+ */
+uint32_t shell_format_usage(const ShellCommand &cmd, char *buf, uint32_t size)
+{
+    uint32_t n = 0;
+    auto put   = [&](std::string_view s) {
+        for (const char c : s)
+        {
+            if (n + 1U < size)
+            {
+                buf[n++] = c;
+            }
+        }
+    };
+
+    put(cmd.name);
+    for (uint32_t i = 0; i < cmd.paramCount; i++)
+    {
+        put(i < cmd.required ? " <" : " [");
+        put(cmd.params[i]);
+        put(i < cmd.required ? ">" : "]");
+    }
+    return n;
+}
+
+
+void shell_print_usage(ShellEngine &sh, const ShellCommand &cmd)
+{
+    char buf[SHELL_REPLY_MAX];
+    const uint32_t n = shell_format_usage(cmd, buf, sizeof(buf));
+    sh.format(FMT("usage: %s"), std::string_view(buf, n));
+}
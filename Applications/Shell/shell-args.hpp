@@ -0,0 +1,678 @@
+/**
+ *******************************************************************************
+ * @file    shell-args.hpp
+ * @brief   the words of a command line, split in place, and typed arguments
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap, nothing copied: the tokenizer rewrites the line
+ * buffer of the engine and hands out views into it, the parsers read those
+ * views. Builds on the host like the engine (Tools/shell-host).
+ *
+ *******************************************************************************
+ * @note
+ *
+ * A handler declares the arguments it wants, and shell_command() derives
+ * the parsing from that declaration at compile time:
+ *
+ *      static const char *cmd_mw(ShellEngine &sh, ShellHex addr, uint32_t value,
+ *                                std::optional<uint32_t> count);
+ *
+ *      shell_command<cmd_mw>("mw", "write words")
+ *
+ * or registers it where the handler is, for the table the linker builds
+ * (shell-table.hpp):
+ *
+ *      SHELL_COMMAND(mw, cmd_mw, "write words");
+ *
+ *      "mw 24000000 0x10"  ->  argv: "mw" "24000000" "0x10"
+ *                          ->  cmd_mw(sh, {0x24000000}, 16, std::nullopt)
+ *
+ * A wrong count or a word that does not parse never reaches the handler:
+ * the command fails with "bad argument" after a line naming the argument,
+ * `help` shows "mw <hex> <uint> [uint]". Types without a ShellArg
+ * specialisation do not compile. Pins, on|off and enum arguments also
+ * carry their words, sorted by the compiler, for Tab (shell-complete.hpp).
+ *
+ * A compiled script (shell-script.hpp) parses the words once: the typed
+ * arguments are packed into bytes by the command's `pack`, and its `run`
+ * calls the handler on them, without a word left to parse.
+ *
+ * Words are separated by spaces or tabs. "..." groups with the escapes \\,
+ * \", \n, \t, \xHH; '...' groups with no escape; a backslash outside quotes
+ * escapes the next character.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/12
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-engine.hpp"
+#include "shell-table.hpp"
+#include "../../Drivers/Peripheral/GPIO/gpio-intf.hpp"
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_ARGC_MAX = 16U;
+
+/**
+ * @brief the words of a line, argv[0] is the command name
+ * @note  every view is also '\0' terminated, in the line buffer
+ */
+struct ShellArgv
+{
+    std::string_view argv[SHELL_ARGC_MAX];
+    uint32_t argc;
+};
+
+/**
+ * @brief the packed arguments of one command: a slot per argument, then
+ *        the texts the slots point to
+ */
+struct ShellPacked
+{
+    uint8_t *buf;
+    uint32_t size;      // room in buf
+    uint32_t len;       // bytes used
+};
+
+/**
+ * @brief a number written in hexadecimal, with or without 0x
+ */
+struct ShellHex
+{
+    uint32_t value;
+};
+
+/**
+ * @brief a pin name: PC1, pa15, port A to H
+ */
+struct ShellPin
+{
+    GpioPortEnum port;
+    GpioPinEnum pin;
+};
+
+/**
+ * @brief a word an enum argument accepts
+ */
+template <typename E>
+struct ShellEnumWord
+{
+    std::string_view word;
+    E value;
+};
+
+/**
+ * @brief specialise to make E an argument type:
+ *
+ *      template <> struct ShellEnumWords<PinActionEnum>
+ *      {
+ *          static constexpr std::string_view name = "set|reset|toggle";
+ *          static constexpr ShellEnumWord<PinActionEnum> list[] = {...};
+ *      };
+ */
+template <typename E>
+struct ShellEnumWords;
+
+/**
+ * @brief the 128 pin names in ShellWords order, PA0 PA1 PA10 .. PA15 PA2 .. PH9,
+ *        five bytes each in text
+ */
+struct ShellPinText
+{
+    char text[8U * 16U * 5U];
+};
+
+struct ShellPinNames
+{
+    std::string_view list[8U * 16U];
+};
+
+/**
+ * @brief a word list sorted by the compiler
+ */
+template <size_t N>
+struct ShellSortedWords
+{
+    std::string_view list[N];
+};
+
+
+
+
+/*-------- 3. function prototypes --------------------------------------------*/
+
+/**
+ * @brief split a line in place
+ * @return nullptr, or the reason: "unterminated quote", "bad escape",
+ *         "too many words"
+ */
+const char *shell_tokenize(char *line, uint32_t len, ShellArgv &out);
+
+/**
+ * @brief the word parsers, the whole word must be used
+ */
+bool shell_parse_int(std::string_view s, int32_t &out);     // [+-]decimal
+bool shell_parse_uint(std::string_view s, uint32_t &out);   // decimal, or hex with 0x
+bool shell_parse_hex(std::string_view s, uint32_t &out);    // hex, 0x optional
+bool shell_parse_float(std::string_view s, float &out);     // [+-]digits[.digits][e[+-]digits]
+bool shell_parse_bool(std::string_view s, bool &out);       // on off 1 0 true false
+bool shell_parse_pin(std::string_view s, ShellPin &out);
+
+/**
+ * @brief "name <p1> <p2> [p3]" into buf, truncated to size - 1
+ * @return bytes written, no terminator
+ */
+uint32_t shell_format_usage(const ShellCommand &cmd, char *buf, uint32_t size);
+
+/**
+ * @brief print "usage: name <p1> <p2> [p3]" as a body line
+ */
+void shell_print_usage(ShellEngine &sh, const ShellCommand &cmd);
+
+
+
+
+/*-------- 4. completion words -----------------------------------------------*/
+
+constexpr ShellPinText shell_pin_text()
+{
+    constexpr uint32_t order[16] = {0, 1, 10, 11, 12, 13, 14, 15, 2, 3, 4, 5, 6, 7, 8, 9}; // as strings sort
+    ShellPinText t{};
+    for (uint32_t port = 0; port < 8U; port++)
+    {
+        for (uint32_t i = 0; i < 16U; i++)
+        {
+            char *p = &t.text[(port * 16U + i) * 5U];
+            p[0]    = 'P';
+            p[1]    = static_cast<char>('A' + port);
+            p[2]    = static_cast<char>(order[i] < 10U ? '0' + order[i] : '1');
+            p[3]    = static_cast<char>(order[i] < 10U ? '\0' : '0' + order[i] - 10U);
+        }
+    }
+    return t;
+}
+
+inline constexpr ShellPinText SHELL_PIN_TEXT = shell_pin_text();
+
+constexpr ShellPinNames shell_pin_names(const char *text)
+{
+    ShellPinNames n{};
+    for (uint32_t i = 0; i < 8U * 16U; i++)
+    {
+        n.list[i] = std::string_view(&text[i * 5U], text[i * 5U + 3U] == '\0' ? 3U : 4U);
+    }
+    return n;
+}
+
+inline constexpr ShellPinNames SHELL_PIN_NAMES = shell_pin_names(SHELL_PIN_TEXT.text);
+
+inline constexpr std::string_view SHELL_BOOL_WORDS[] = {"0", "1", "false", "off", "on", "true"};
+
+template <typename E>
+constexpr auto shell_enum_sorted()
+{
+    constexpr size_t n = sizeof(ShellEnumWords<E>::list) / sizeof(ShellEnumWords<E>::list[0]);
+    ShellSortedWords<n> w{};
+    for (size_t i = 0; i < n; i++)
+    {
+        w.list[i] = ShellEnumWords<E>::list[i].word;
+    }
+    shell_words_sort(w.list, n);
+    return w;
+}
+
+template <typename E>
+inline constexpr auto SHELL_ENUM_SORTED = shell_enum_sorted<E>();
+
+
+
+
+/*-------- 5. argument types -------------------------------------------------*/
+
+/**
+ * @brief the parser and the name of an argument type
+ */
+template <typename T, typename = void>
+struct ShellArg
+{
+    static_assert(sizeof(T) == 0U, "no ShellArg parser for this argument type");
+};
+
+/**
+ * @brief the words an argument type completes to, none unless its ShellArg has a list
+ */
+template <typename T, typename = void>
+struct ShellArgWords
+{
+    static constexpr ShellWords value = {};
+};
+
+template <typename T>
+struct ShellArgWords<T, std::void_t<decltype(ShellArg<T>::words)>>
+{
+    static constexpr ShellWords value = ShellArg<T>::words;
+};
+
+template <>
+struct ShellArg<int32_t>
+{
+    static constexpr std::string_view name = "int";
+    static bool parse(std::string_view s, int32_t &out)
+    {
+        return shell_parse_int(s, out);
+    }
+};
+
+template <>
+struct ShellArg<uint32_t>
+{
+    static constexpr std::string_view name = "uint";
+    static bool parse(std::string_view s, uint32_t &out)
+    {
+        return shell_parse_uint(s, out);
+    }
+};
+
+template <>
+struct ShellArg<ShellHex>
+{
+    static constexpr std::string_view name = "hex";
+    static bool parse(std::string_view s, ShellHex &out)
+    {
+        return shell_parse_hex(s, out.value);
+    }
+};
+
+template <>
+struct ShellArg<float>
+{
+    static constexpr std::string_view name = "float";
+    static bool parse(std::string_view s, float &out)
+    {
+        return shell_parse_float(s, out);
+    }
+};
+
+template <>
+struct ShellArg<bool>
+{
+    static constexpr std::string_view name = "on|off";
+    static constexpr ShellWords words      = {SHELL_BOOL_WORDS, 6U};
+    static bool parse(std::string_view s, bool &out)
+    {
+        return shell_parse_bool(s, out);
+    }
+};
+
+template <>
+struct ShellArg<ShellPin>
+{
+    static constexpr std::string_view name = "pin";
+    static constexpr ShellWords words      = {SHELL_PIN_NAMES.list, 8U * 16U};
+    static bool parse(std::string_view s, ShellPin &out)
+    {
+        return shell_parse_pin(s, out);
+    }
+};
+
+template <>
+struct ShellArg<std::string_view>
+{
+    static constexpr std::string_view name = "text";
+    static bool parse(std::string_view s, std::string_view &out)
+    {
+        out = s;
+        return true;
+    }
+};
+
+template <typename E>
+struct ShellArg<E, std::void_t<decltype(ShellEnumWords<E>::list)>>
+{
+    static constexpr std::string_view name = ShellEnumWords<E>::name;
+    static constexpr ShellWords words      = {SHELL_ENUM_SORTED<E>.list,
+                                              static_cast<uint32_t>(std::size(SHELL_ENUM_SORTED<E>.list))};
+    static bool parse(std::string_view s, E &out)
+    {
+        for (const ShellEnumWord<E> &w : ShellEnumWords<E>::list)
+        {
+            if (w.word == s)
+            {
+                out = w.value;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief optional argument, only at the end of the list
+ */
+template <typename T>
+struct ShellArg<std::optional<T>>
+{
+    static constexpr std::string_view name = ShellArg<T>::name;
+    static constexpr ShellWords words      = ShellArgWords<T>::value;
+    static bool parse(std::string_view s, std::optional<T> &out)
+    {
+        T v{};
+        if (not ShellArg<T>::parse(s, v))
+        {
+            return false;
+        }
+        out = v;
+        return true;
+    }
+};
+
+template <typename T>
+constexpr bool shell_arg_optional = false;
+
+template <typename T>
+constexpr bool shell_arg_optional<std::optional<T>> = true;
+
+
+
+
+/*-------- 6. packed arguments ----------------------------------------------*/
+
+/**
+ * @brief the slot of an argument type in ShellPacked: the value itself,
+ *        a multiple of 4 bytes
+ */
+template <typename T, typename = void>
+struct ShellPack
+{
+    static_assert(std::is_trivially_copyable_v<T>, "no ShellPack for this argument type");
+    static constexpr uint32_t SIZE = (sizeof(T) + 3U) & ~3U;
+
+    static bool pack(const T &v, uint8_t *slot, ShellPacked &out)
+    {
+        (void)out;
+        memcpy(slot, &v, sizeof(T));
+        return true;
+    }
+
+    static void unpack(const uint8_t *slot, const uint8_t *packed, T &out)
+    {
+        (void)packed;
+        memcpy(&out, slot, sizeof(T));
+    }
+};
+
+/**
+ * @brief offset and length of the text, '\0' terminated after the slots
+ */
+template <>
+struct ShellPack<std::string_view>
+{
+    static constexpr uint32_t SIZE = 4U;
+
+    static bool pack(std::string_view v, uint8_t *slot, ShellPacked &out)
+    {
+        if (v.size() >= out.size - out.len or out.len > 0xFFFFU)
+        {
+            return false;
+        }
+        const uint16_t at[2] = {static_cast<uint16_t>(out.len), static_cast<uint16_t>(v.size())};
+        memcpy(slot, at, sizeof(at));
+        memcpy(&out.buf[out.len], v.data(), v.size());
+        out.buf[out.len + v.size()] = 0;
+        out.len += static_cast<uint32_t>(v.size()) + 1U;
+        return true;
+    }
+
+    static void unpack(const uint8_t *slot, const uint8_t *packed, std::string_view &out)
+    {
+        uint16_t at[2];
+        memcpy(at, slot, sizeof(at));
+        out = std::string_view(reinterpret_cast<const char *>(&packed[at[0]]), at[1]);
+    }
+};
+
+/**
+ * @brief a presence byte, then the slot of T
+ */
+template <typename T>
+struct ShellPack<std::optional<T>>
+{
+    static constexpr uint32_t SIZE = 4U + ShellPack<T>::SIZE;
+
+    static bool pack(const std::optional<T> &v, uint8_t *slot, ShellPacked &out)
+    {
+        slot[0] = v.has_value() ? 1U : 0U;
+        return not v.has_value() or ShellPack<T>::pack(*v, &slot[4], out);
+    }
+
+    static void unpack(const uint8_t *slot, const uint8_t *packed, std::optional<T> &out)
+    {
+        if (slot[0] == 0U)
+        {
+            out.reset();
+            return;
+        }
+        T v{};
+        ShellPack<T>::unpack(&slot[4], packed, v);
+        out = v;
+    }
+};
+
+
+
+
+/*-------- 7. typed handlers -------------------------------------------------*/
+
+/**
+ * @brief the ShellHandler of a handler declared with typed arguments
+ */
+template <auto F>
+struct ShellTyped;
+
+template <typename... A, const char *(*F)(ShellEngine &, A...)>
+struct ShellTyped<F>
+{
+    static constexpr uint32_t COUNT = sizeof...(A);
+    static constexpr std::string_view PARAMS[COUNT + 1U] = {ShellArg<std::decay_t<A>>::name..., ""};
+    static constexpr ShellWords VALUES[COUNT + 1U]       = {ShellArgWords<std::decay_t<A>>::value..., ShellWords{}};
+
+    /**
+     * @brief number of leading arguments that are not optional, the others must all be
+     */
+    static constexpr uint32_t required()
+    {
+        constexpr bool opt[COUNT + 1U] = {shell_arg_optional<std::decay_t<A>>..., true};
+        uint32_t n                     = 0;
+        while (n < COUNT and not opt[n])
+        {
+            n++;
+        }
+        for (uint32_t i = n; i < COUNT; i++)
+        {
+            if (not opt[i])
+            {
+                return SHELL_ARGC_MAX; // caught below
+            }
+        }
+        return n;
+    }
+
+    static constexpr uint32_t REQUIRED = required();
+    static_assert(REQUIRED <= COUNT, "optional arguments must come last");
+    static_assert(COUNT < SHELL_ARGC_MAX, "more arguments than words in a line");
+
+    static const char *call(ShellEngine &sh, const ShellArgv &args)
+    {
+        Values v{};
+        uint32_t bad    = 0;
+        const char *err = parse(args, v, bad, std::index_sequence_for<A...>{});
+        if (err == nullptr)
+        {
+            return std::apply([&sh](auto &...a) { return F(sh, a...); }, v);
+        }
+        if (bad < COUNT and args.argc > bad + 1U)
+        {
+            const std::string_view word = args.argv[bad + 1U];
+            sh.format(FMT("argument %u <%s>: \"%s\""), bad + 1U, PARAMS[bad], word);
+        }
+        else
+        {
+            print_usage(sh, args);
+        }
+        return err;
+    }
+
+    /**
+     * @brief the ShellPacker: parse, then one slot per argument, PACKED bytes, then the texts
+     */
+    static const char *pack(const ShellArgv &args, ShellPacked &out, uint32_t &bad)
+    {
+        Values v{};
+        const char *err = parse(args, v, bad, std::index_sequence_for<A...>{});
+        if (err != nullptr)
+        {
+            return err;
+        }
+        if (PACKED > out.size)
+        {
+            return "arguments too long";
+        }
+        memset(out.buf, 0, PACKED);
+        out.len = PACKED;
+        return pack_all(v, out, std::index_sequence_for<A...>{}) ? nullptr : "arguments too long";
+    }
+
+    /**
+     * @brief the ShellRunner: the handler on what pack() wrote
+     */
+    static const char *run(ShellEngine &sh, const uint8_t *packed)
+    {
+        Values v{};
+        unpack_all(packed, v, std::index_sequence_for<A...>{});
+        return std::apply([&sh](auto &...a) { return F(sh, a...); }, v);
+    }
+
+  private:
+    using Values = std::tuple<std::decay_t<A>...>;
+
+    static constexpr uint32_t SIZES[COUNT + 1U] = {ShellPack<std::decay_t<A>>::SIZE..., 0U};
+
+    static constexpr uint32_t offset(uint32_t i)
+    {
+        uint32_t at = 0;
+        for (uint32_t k = 0; k < i; k++)
+        {
+            at += SIZES[k];
+        }
+        return at;
+    }
+
+    static constexpr uint32_t PACKED = offset(COUNT);
+
+    /**
+     * @param bad the argument that did not parse; COUNT for a wrong count
+     */
+    template <size_t... I>
+    static const char *parse(const ShellArgv &args, Values &v, uint32_t &bad, std::index_sequence<I...>)
+    {
+        const uint32_t given = args.argc - 1U;
+        bad                  = COUNT;
+        if (given < REQUIRED or given > COUNT)
+        {
+            return given < REQUIRED ? "missing argument" : "too many arguments";
+        }
+        const bool ok = (parse_one<I>(args, std::get<I>(v), bad) and ...);
+        (void)v;
+        return ok ? nullptr : "bad argument";
+    }
+
+    template <size_t I, typename T>
+    static bool parse_one(const ShellArgv &args, T &out, uint32_t &bad)
+    {
+        if (I + 1U >= args.argc)
+        {
+            return true; // an optional argument left out
+        }
+        bad = static_cast<uint32_t>(I);
+        return ShellArg<T>::parse(args.argv[I + 1U], out);
+    }
+
+    template <size_t... I>
+    static bool pack_all(const Values &v, ShellPacked &out, std::index_sequence<I...>)
+    {
+        (void)v;
+        (void)out;
+        return (ShellPack<std::decay_t<A>>::pack(std::get<I>(v), &out.buf[offset(I)], out) and ...);
+    }
+
+    template <size_t... I>
+    static void unpack_all(const uint8_t *packed, Values &v, std::index_sequence<I...>)
+    {
+        (void)packed;
+        (void)v;
+        (ShellPack<std::decay_t<A>>::unpack(&packed[offset(I)], packed, std::get<I>(v)), ...);
+    }
+
+    static void print_usage(ShellEngine &sh, const ShellArgv &args)
+    {
+        ShellCommand cmd{};
+        cmd.name       = args.argv[0];
+        cmd.params     = PARAMS;
+        cmd.paramCount = static_cast<uint8_t>(COUNT);
+        cmd.required   = static_cast<uint8_t>(REQUIRED);
+        shell_print_usage(sh, cmd);
+    }
+};
+
+/**
+ * @brief an entry of the command table
+ * @param F a ShellHandler, or a handler with typed arguments
+ */
+template <auto F>
+constexpr ShellCommand shell_command(std::string_view name, std::string_view help)
+{
+    if constexpr (std::is_same_v<decltype(F), ShellHandler>)
+    {
+        return {name, F, help};
+    }
+    else
+    {
+        using T = ShellTyped<F>;
+        return {name, &T::call, help, T::PARAMS, T::VALUES, static_cast<uint8_t>(T::COUNT),
+                static_cast<uint8_t>(T::REQUIRED), &T::pack, &T::run};
+    }
+}
+
+/**
+ * @brief register a command in the module of its handler, for shell_registered_index()
+ * @param name a word in lower case, unquoted: the descriptors are shell_cmds_<name>
+ *        and shell_names_<name>, the sections sort as the names do
+ */
+#define SHELL_COMMAND(name, handler, help)                                                                             \
+    static_assert(shell_registrable(#name), "a registered command name is in lower case");                          \
+    APP_DESCRIPTOR(shell_names, name, std::string_view) = #name;                                                     \
+    APP_DESCRIPTOR(shell_cmds, name, ShellCommand)      = shell_command<handler>(#name, help)
@@ -0,0 +1,104 @@
+/**
+ *******************************************************************************
+ * @file    shell-builtins.cpp
+ * @brief   the built-in commands that need no board: help, echo, jobs, kill, fg
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS: the firmware and the host tools link the same handlers.
+ * The commands of the board are in shell-cmds.cpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/21
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-args.hpp"
+#include "shell-jobs.hpp"
+#include <cstring>
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief one line per command, by name
+ */
+static const char *cmd_help(ShellEngine &sh)
+{
+    const ShellIndex &idx = sh.index_getter();
+    for (uint32_t i = 0; i < idx.count; i++)
+    {
+        char usage[48];
+        const uint32_t n = shell_format_usage(idx.cmds[i], usage, sizeof(usage));
+        sh.format(FMT("%-28s %s"), std::string_view(usage, n), idx.cmds[i].help);
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief print the words back, one space between them
+ */
+static const char *cmd_echo(ShellEngine &sh, const ShellArgv &args)
+{
+    char buf[SHELL_REPLY_MAX];
+    uint32_t n = 0;
+    for (uint32_t i = 1; i < args.argc; i++)
+    {
+        const std::string_view w = args.argv[i];
+        const uint32_t room      = sizeof(buf) - n - 1U;
+        const uint32_t take      = w.size() < room ? static_cast<uint32_t>(w.size()) : room;
+        memcpy(&buf[n], w.data(), take);
+        n += take;
+        buf[n] = ' ';
+        n += i + 1U < args.argc and n < sizeof(buf) - 1U ? 1U : 0U;
+    }
+    sh.line(std::string_view(buf, n));
+    return nullptr;
+}
+
+
+static const char *cmd_jobs(ShellEngine &sh)
+{
+    if (sh.jobs_getter() == nullptr)
+    {
+        return "no background jobs";
+    }
+    sh.jobs_getter()->list(sh);
+    return nullptr;
+}
+
+
+static const char *cmd_kill(ShellEngine &sh, uint32_t job)
+{
+    return sh.jobs_getter() != nullptr ? sh.jobs_getter()->kill(job) : "no background jobs";
+}
+
+
+/**
+ * @brief the output of a job until it ends, the newest when left out
+ */
+static const char *cmd_fg(ShellEngine &sh, std::optional<uint32_t> job)
+{
+    return sh.jobs_getter() != nullptr ? sh.jobs_getter()->foreground(sh, job.value_or(0U)) : "no background jobs";
+}
+
+
+
+
+/* ------- registration ------------------------------------------------------*/
+
+SHELL_COMMAND(help, cmd_help, "list the commands");
+SHELL_COMMAND(echo, cmd_echo, "print the words back");
+SHELL_COMMAND(jobs, cmd_jobs, "background jobs, \"cmd &\" starts one");
+SHELL_COMMAND(kill, cmd_kill, "stop a background job");
+SHELL_COMMAND(fg, cmd_fg, "output of a background job until it ends");
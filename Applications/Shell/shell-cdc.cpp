@@ -0,0 +1,339 @@
+/**
+ *******************************************************************************
+ * @file    shell-cdc.cpp
+ * @brief   the shell sessions and their tasks, the transport of the shell CDC port
+ *******************************************************************************
+ * @attention
+ *
+ * Each session of s_sessions (shell-session.hpp) has a task of its own and
+ * SHELL_SESSION_WORKERS worker tasks below its priority for "cmd &" and the
+ * stages of a pipeline but the last, all created with static stacks and
+ * control blocks: the FreeRTOS heap is not touched. The sessions do not
+ * wait on each other, a `dump` on one does not hold the prompt of another.
+ *
+ * Like the benchmark, a session task sleeps on a thread flag raised by the
+ * receive interrupt of its link: a command runs as soon as its line end
+ * arrives, not at the next tick. A task waiting on a job sleeps on a thread
+ * flag. While a session task waits on a job (`fg`, the last stage), it
+ * keeps reading its link: ^C stops the job, other keys are held for the
+ * editor.
+ *
+ * The shell CDC port is the one link of the board: its replies go to the
+ * interactive class of the transmit scheduler, `dump` encodes into the
+ * bulk class in place (txq_reserve()); the one message per lap of the ring
+ * that would cross its end is staged and copied. The end line of the dump
+ * waits for the bulk queue to empty, the interactive class would overtake
+ * it. Another link (a UART on a debug header: the board has none wired,
+ * VGT6-ShellTest.ioc) is a ShellTransport whose receive interrupt calls
+ * ShellRtosSession::notify(), and one more entry of s_sessions.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * See shell-intf.h.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/11
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define SHELL_PORT          CDC_PORT_SHELL
+#define SHELL_FLAG_RX       0x0001U
+#define SHELL_FLAG_JOB      0x0002U
+#define SHELL_TASK_STACK    2048U   // bytes
+#define SHELL_WORKER_STACK  2048U   // bytes
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-intf.h"
+#include "../app-intf.h"
+#include "shell-memory.hpp"
+#include "shell-session.hpp"
+#include "../TxSched/txq-intf.h"
+#include "cmsis_os.h"
+#include "FreeRTOS.h"
+#include "stm32h7xx_hal.h"
+#include "usbd_cdc_if.h"
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static_assert(SHELL_REPLY_MAX <= TXQ_INTERACTIVE_SIZE, "a reply line must fit the interactive queue");
+static_assert(SHELL_BULK_MAX <= TXQ_UNIT, "a bulk message must reach the host uncut");
+static_assert(SHELL_FRAME_MAX <= TXQ_INTERACTIVE_SIZE and SHELL_FRAME_MAX <= TXQ_UNIT,
+              "a frame of machine mode goes as a reply, uncut");
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief the shell CDC port: replies to the interactive class, one line or
+ *        one frame per message; dumps to the bulk class, written in place
+ */
+class ShellCdcTransport : public ShellTransport
+{
+  public:
+    uint32_t read(uint8_t *buf, uint32_t len) override
+    {
+        return CDC_Read_HS(SHELL_PORT, buf, len);
+    }
+
+    /**
+     * @brief queue a whole line or frame, waiting for room while a host reads
+     * @note  a line is never split: it goes whole or is dropped and counted
+     */
+    void write(const char *buf, uint32_t len) override
+    {
+        const uint32_t t0 = HAL_GetTick();
+        while (txq_free(TXQ_INTERACTIVE) < len and CDC_HostOpen_HS(SHELL_PORT) != 0U and
+               (HAL_GetTick() - t0) < SHELL_IDLE_MS)
+        {
+            osDelay(1);
+        }
+        (void)txq_write(TXQ_INTERACTIVE, reinterpret_cast<const uint8_t *>(buf), len);
+    }
+
+    /**
+     * @brief room in the bulk queue, waiting for it while a host reads
+     * @note  where the ring of the queue ends inside the room, the message
+     *        is staged and copied by bulk_commit(), once per lap
+     */
+    uint8_t *bulk_reserve(uint32_t len) override
+    {
+        const uint32_t t0 = HAL_GetTick();
+        while (len <= SHELL_BULK_MAX and CDC_HostOpen_HS(SHELL_PORT) != 0U and (HAL_GetTick() - t0) < SHELL_IDLE_MS)
+        {
+            uint8_t *p = txq_reserve(TXQ_BULK, len);
+            _staged    = p == nullptr and txq_free(TXQ_BULK) >= len;
+            if (p != nullptr or _staged)
+            {
+                return _staged ? _stage : p;
+            }
+            osDelay(1);
+        }
+        return nullptr;
+    }
+
+    void bulk_commit(uint32_t len) override
+    {
+        if (_staged)
+        {
+            (void)txq_write(TXQ_BULK, _stage, len);
+        }
+        else
+        {
+            (void)txq_commit(TXQ_BULK, len);
+        }
+    }
+
+    /**
+     * @brief wait for the bulk queue to empty, the end line goes after it
+     */
+    void bulk_drain() override
+    {
+        const uint32_t t0 = HAL_GetTick();
+        while (txq_queued(TXQ_BULK) != 0U and CDC_HostOpen_HS(SHELL_PORT) != 0U and
+               (HAL_GetTick() - t0) < SHELL_IDLE_MS)
+        {
+            osDelay(1);
+        }
+    }
+
+  private:
+    uint8_t _stage[SHELL_BULK_MAX]; // a bulk message across the end of the queue's ring
+    bool _staged = false;
+};
+
+
+/**
+ * @brief a session and its tasks: its own, its workers and their semaphore
+ */
+class ShellRtosSession : public ShellJobPort
+{
+  public:
+    ShellRtosSession(std::string_view name, ShellTransport &link) : _session(name, shell_builtin_index(), link, *this)
+    {
+    }
+
+    /**
+     * @brief create the tasks, names static
+     */
+    void start(const char *name, const char *const workers[SHELL_SESSION_WORKERS])
+    {
+        const osSemaphoreAttr_t semAttr = {
+            .name    = "shell-jobs",
+            .cb_mem  = &_semCb,
+            .cb_size = sizeof(_semCb),
+        };
+        _sem = osSemaphoreNew(SHELL_JOB_MAX, 0U, &semAttr);
+
+        osThreadAttr_t attr = {};
+        attr.name           = name;
+        attr.cb_mem         = &_taskCb;
+        attr.cb_size        = sizeof(_taskCb);
+        attr.stack_mem      = _stack;
+        attr.stack_size     = sizeof(_stack);
+        attr.priority       = osPriorityNormal;
+        _task               = osThreadNew(run, this, &attr);
+
+        for (uint32_t i = 0; i < SHELL_SESSION_WORKERS; i++)
+        {
+            _workers[i].owner  = this;
+            _workers[i].worker = &_session.worker_getter(i);
+            attr.name          = workers[i];
+            attr.cb_mem        = &_workers[i].cb;
+            attr.cb_size       = sizeof(_workers[i].cb);
+            attr.stack_mem     = _workers[i].stack;
+            attr.stack_size    = sizeof(_workers[i].stack);
+            attr.priority      = osPriorityBelowNormal;
+            (void)osThreadNew(work, &_workers[i], &attr);
+        }
+    }
+
+    /**
+     * @brief bytes arrived on the link, from its receive interrupt
+     */
+    void notify()
+    {
+        (void)osThreadFlagsSet(_task, SHELL_FLAG_RX);
+    }
+
+    void post() override
+    {
+        (void)osSemaphoreRelease(_sem);
+    }
+
+    void *self() override
+    {
+        return osThreadGetId();
+    }
+
+    void wake(void *task) override
+    {
+        (void)osThreadFlagsSet(static_cast<osThreadId_t>(task), SHELL_FLAG_JOB);
+    }
+
+    /**
+     * @brief sleep until woken, a key or the timeout; the session task keeps the keys
+     */
+    bool wait(uint32_t ms) override
+    {
+        if (osThreadGetId() != _task)
+        {
+            (void)osThreadFlagsWait(SHELL_FLAG_JOB, osFlagsWaitAny, ms);
+            return false;
+        }
+        (void)osThreadFlagsWait(SHELL_FLAG_RX | SHELL_FLAG_JOB, osFlagsWaitAny, ms);
+        return _session.hold();
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] ShellSession &session_getter()
+    {
+        return _session;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    struct Worker
+    {
+        ShellRtosSession *owner;
+        ShellWorker *worker;
+        StaticTask_t cb;
+        uint64_t stack[SHELL_WORKER_STACK / 8U];
+    };
+
+    /**
+     * @brief session task: run what arrives, sleep in between
+     */
+    static void run(void *argument)
+    {
+        ShellSession &session = static_cast<ShellRtosSession *>(argument)->_session;
+        for (;;)
+        {
+            if (not session.poll())
+            {
+                /* a flag raised after the read of poll() makes this return at once */
+                (void)osThreadFlagsWait(SHELL_FLAG_RX, osFlagsWaitAny, osWaitForever);
+            }
+        }
+    }
+
+    /**
+     * @brief worker task: run the queued jobs, sleep on the semaphore between
+     */
+    static void work(void *argument)
+    {
+        Worker *w = static_cast<Worker *>(argument);
+        for (;;)
+        {
+            (void)osSemaphoreAcquire(w->owner->_sem, osWaitForever);
+            (void)w->worker->run();
+        }
+    }
+
+    ShellSession _session;
+    osThreadId_t _task   = nullptr;
+    osSemaphoreId_t _sem = nullptr;
+    StaticSemaphore_t _semCb;
+    StaticTask_t _taskCb;
+    uint64_t _stack[SHELL_TASK_STACK / 8U];
+    Worker _workers[SHELL_SESSION_WORKERS];
+};
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static ShellCdcTransport s_cdc_link;
+static ShellRtosSession s_cdc("usb", s_cdc_link);
+
+static ShellSession *const s_sessions[] = {&s_cdc.session_getter()};
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief CDC receive hook, runs in the USB interrupt
+ */
+static void shell_cdc_notify(uint8_t port)
+{
+    (void)port;
+    s_cdc.notify();
+}
+
+
+/**
+ * @brief create the tasks of the sessions
+ */
+extern "C" void shell_init(void)
+{
+    static const char *const workers[SHELL_SESSION_WORKERS] = {"shell-job0", "shell-job1", "shell-job2"};
+
+    shell_memory_bind(&shell_board_memory());
+    shell_sessions_bind(s_sessions, sizeof(s_sessions) / sizeof(s_sessions[0]));
+
+    s_cdc.start("shell", workers);
+    CDC_SetRxNotify_HS(SHELL_PORT, shell_cdc_notify);
+}
+
+APP_REGISTER(50, shell, shell_init);
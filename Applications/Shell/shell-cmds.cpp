@@ -0,0 +1,671 @@
+/**
+ *******************************************************************************
+ * @file    shell-cmds.cpp
+ * @brief   the built-in commands of the shell
+ *******************************************************************************
+ * @attention
+ *
+ * The handlers run in the shell task. They print with sh.format(), one call
+ * per line, its format string checked against the arguments at compile time
+ * (format.hpp), and return nullptr or the reason of their failure. A handler
+ * declares its arguments with their types (shell-args.hpp), it is only
+ * called once they all parsed.
+ *
+ * "cmd &" runs a handler in a worker task instead (shell-jobs.hpp): a
+ * handler that takes long looks at sh.cancelled() between its steps. In
+ * "a | b", b reads the lines of a with sh.read(); the filters are in
+ * shell-filters.cpp.
+ *
+ * `script` keeps compiled scripts (shell-script.hpp) in the top
+ * STORAGE_RESERVED_TOP bytes of the OSPI flash, once the storage task has
+ * brought the flash up.
+ *
+ * md, mw and dump (shell-memory.hpp) see the memories of the part through
+ * s_regions; md and mw reach any other address with the bus faults
+ * ignored, a hole answers "bus fault" instead of locking the core up.
+ *
+ * `top` shows what the CPU did between two snapshots of the accounting
+ * (cpu-load.h), one frame per period: "top 1000 0 &" then `fg` keeps it
+ * going until ^C.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Each command is registered next to its handler with SHELL_COMMAND()
+ * (shell-args.hpp): the ones of the board here; help, echo, jobs, kill and
+ * fg in shell-builtins.cpp, which the host tools link too; the filters,
+ * md/mw/dump, set/unset and sessions/mode in their modules. The compiler derives the
+ * argument parsing, the linker gathers the descriptors sorted by name into
+ * flash (app-intf.h) and refuses a duplicate name.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/11
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-intf.h"
+#include "shell-args.hpp"
+#include "shell-env.hpp"
+#include "shell-filters.hpp"
+#include "shell-jobs.hpp"
+#include "shell-memory.hpp"
+#include "shell-script.hpp"
+#include "shell-session.hpp"
+#include "../CpuLoad/cpu-load.h"
+#include "../Log/log-intf.h"
+#include "../Storage/storage-intf.h"
+#include "../TxSched/txq-intf.h"
+#include "../../Drivers/Peripheral/Flash/flash-intf.hpp"
+#include "../../Drivers/Peripheral/GPIO/gpio-intf.hpp"
+#include "stm32h7xx_hal.h"
+#include "usbd_cdc_if.h"
+#include "usbd_conf.h"
+#include "cmsis_os.h"
+#include "task.h"
+#include <atomic>
+#include <new>
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define SHELL_SLEEP_STEP_MS 10U    // `sleep` looks for a kill this often
+#define SHELL_TOP_MS        1000U  // `top` period when left out
+#define SHELL_TOP_MS_MAX    5000U  // well within a DWT wrap, 7.8 s at 550 MHz
+#define SHELL_TOP_ROWS      (CPU_LOAD_TASKS + 1U + CPU_ISR_NUM)
+
+
+
+
+/**
+ * @brief what `pin` does to a pin, reading it when left out
+ */
+enum class ShellPinActionEnum
+{
+    SET,
+    RESET,
+    TOGGLE,
+};
+
+template <>
+struct ShellEnumWords<ShellPinActionEnum>
+{
+    static constexpr std::string_view name = "set|reset|toggle";
+    static constexpr ShellEnumWord<ShellPinActionEnum> list[] = {
+        {"set", ShellPinActionEnum::SET},
+        {"reset", ShellPinActionEnum::RESET},
+        {"toggle", ShellPinActionEnum::TOGGLE},
+    };
+};
+
+/**
+ * @brief what `script` does
+ */
+enum class ShellScriptActionEnum
+{
+    LOAD,
+    RUN,
+    LIST,
+    RM,
+};
+
+template <>
+struct ShellEnumWords<ShellScriptActionEnum>
+{
+    static constexpr std::string_view name = "load|run|list|rm";
+    static constexpr ShellEnumWord<ShellScriptActionEnum> list[] = {
+        {"load", ShellScriptActionEnum::LOAD},
+        {"run", ShellScriptActionEnum::RUN},
+        {"list", ShellScriptActionEnum::LIST},
+        {"rm", ShellScriptActionEnum::RM},
+    };
+};
+
+
+
+/**
+ * @brief a range of the address space that reads as plain memory
+ */
+struct ShellRegion
+{
+    uint32_t base;
+    uint32_t size;
+};
+
+/**
+ * @brief the memories of the part, and a bus fault tolerant access to the rest
+ */
+class ShellBoardMemory : public ShellMemory
+{
+  public:
+    const uint8_t *map(uint32_t addr, uint32_t len) override;
+    bool read(uint32_t addr, uint32_t &word) override;
+    bool write(uint32_t addr, uint32_t word) override;
+
+  private:
+    static bool probe(uint32_t addr, uint32_t &word, bool store);
+};
+
+/**
+ * @brief one line of `top`
+ */
+struct ShellTopRow
+{
+    char name[configMAX_TASK_NAME_LEN + 4U];
+    uint64_t cycles;
+    uint32_t count;     // switches in, or calls of an interrupt
+    uint32_t stack;     // bytes never used, 0 for an interrupt
+};
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static GpioIntf *s_pins[8][16] = {}; // produced on first use, ports A to H
+
+/* the backup SRAM and the OSPI window are left out: unclocked or unmapped, they fault;
+   the ITCM too, at address 0 its pointer would be nullptr: md reads it */
+static const ShellRegion s_regions[] = {
+    {D1_DTCMRAM_BASE, 128U * 1024U},
+    {D1_AXISRAM_BASE, 320U * 1024U},
+    {D2_AHBSRAM_BASE, 32U * 1024U},
+    {D3_SRAM_BASE, 16U * 1024U},
+    {FLASH_BANK1_BASE, 1024U * 1024U},
+};
+static ShellBoardMemory s_memory;
+
+static CpuLoadSnapshotTypeDef s_top_snap[2]; // `top`: the frame before and this one
+static TaskStatus_t s_top_tasks[CPU_LOAD_TASKS];
+static ShellTopRow s_top_rows[SHELL_TOP_ROWS];
+static std::atomic<bool> s_top_busy{false};
+
+static uint8_t s_script_code[SHELL_SCRIPT_CODE_MAX] __attribute__((section(".axi_sram"), aligned(32)));
+
+alignas(ShellScriptStore) static uint8_t s_script_store_mem[sizeof(ShellScriptStore)];
+alignas(ShellScriptLoader) static uint8_t s_script_loader_mem[sizeof(ShellScriptLoader)];
+static std::atomic<ShellScriptStore *> s_script_store{nullptr}; // published once the loader is made
+static std::atomic<bool> s_script_opening{false};
+static ShellScriptLoader *s_script_loader = nullptr;
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+static const char *cmd_script(ShellEngine &sh, ShellScriptActionEnum action, std::optional<std::string_view> name);
+
+
+static const char *cmd_version(ShellEngine &sh)
+{
+    sh.line("H7-shell " SHELL_VERSION " " __DATE__ " " __TIME__);
+    return nullptr;
+}
+
+
+static const char *cmd_uptime(ShellEngine &sh)
+{
+    const uint32_t ms = HAL_GetTick();
+    sh.format(FMT("%u.%03u s"), ms / 1000U, ms % 1000U);
+    return nullptr;
+}
+
+
+/**
+ * @brief counters of the transmit scheduler, one line per class
+ */
+static const char *cmd_txq(ShellEngine &sh)
+{
+    static const char *const name[TXQ_CLASS_NUM] = {"interactive", "telemetry", "bulk"};
+    for (uint32_t c = 0; c < TXQ_CLASS_NUM; c++)
+    {
+        TxqStatsTypeDef s;
+        txq_get_stats(static_cast<TxqClassEnum>(c), &s);
+        sh.format(FMT("%-11s %8u KiB %6u msg %6u drop %5u queued %7u B/s delay avg %u max %u p99 %u us"), name[c],
+                  s.bytes >> 10, s.messages, s.dropped, s.queued, s.rateBps, s.delayAvgUs, s.delayMaxUs, s.delayP99Us);
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief counters of the deferred logger
+ */
+static const char *cmd_log(ShellEngine &sh)
+{
+    LogStatsTypeDef s;
+    log_get_stats(&s);
+    const uint32_t calls = s.records + s.dropped;
+    sh.format(FMT("records %u dropped %u (%u B) pending %u B high water %u B"), s.records, s.dropped, s.droppedBytes,
+              log_pending(), s.highWater);
+    sh.format(FMT("cycles per call avg %u max %u"), calls != 0U ? s.cyclesSum / calls : 0U, s.cyclesMax);
+    return nullptr;
+}
+
+
+/**
+ * @brief counters of the CDC ports and of the USB class handle pools
+ */
+static const char *cmd_usb(ShellEngine &sh)
+{
+    for (uint8_t port = 0; port < CDC_PORT_NUM; port++)
+    {
+        CDC_PortStatsTypeDef s;
+        CDC_GetStats_HS(port, &s);
+        sh.format(FMT("cdc%u rx %u B %u pkt held %u  tx %u B %u xfer dropped %u overwritten %u  opens %u"), port,
+                  s.RxBytes, s.RxPackets, s.RxHeld, s.TxBytes, s.TxTransfers, s.TxDropped, s.TxOverwritten,
+                  s.HostOpens);
+    }
+
+    USBD_StaticPoolStatsTypeDef pool[4];
+    const uint32_t n = USBD_static_pool_stats(pool, 4U);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sh.format(FMT("pool %-6s %5u B %u/%u used, peak %u, %u allocs"), pool[i].Name, pool[i].Size, pool[i].InUse,
+                  pool[i].Capacity, pool[i].Peak, pool[i].Allocs);
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief counters of the sector cache behind the MSC disk
+ */
+static const char *cmd_storage(ShellEngine &sh)
+{
+    if (storage_ready() == 0U)
+    {
+        return "storage not ready";
+    }
+    StorageStatsTypeDef s;
+    storage_get_stats(&s);
+    sh.format(FMT("%u blocks  read %u write %u  hits %u misses %u prefetches %u"), storage_block_count(),
+              s.readBlocks, s.writeBlocks, s.hits, s.misses, s.prefetches);
+    sh.format(FMT("flushes %u erases %u programs %u erase skips %u"), s.flushes, s.erases, s.programs, s.eraseSkips);
+    return nullptr;
+}
+
+
+/**
+ * @brief drive or read a pin: "pin PC1 toggle", "pin PE3"
+ * @note  a pin the shell never drove is read as an input, one it drives
+ *        stays an output
+ */
+static const char *cmd_pin(ShellEngine &sh, ShellPin pin, std::optional<ShellPinActionEnum> action)
+{
+    GpioIntf *&g = s_pins[static_cast<uint32_t>(pin.port) - 1U][static_cast<uint32_t>(pin.pin) - 1U];
+    const GpioModeEnum mode = action ? GpioModeEnum::GPIO_MODE_OUTPUT_PP_ : GpioModeEnum::GPIO_MODE_INPUT_;
+    if (g == nullptr)
+    {
+        auto r = p_gpio_lib_fcty->produce(pin.port, pin.pin, mode);
+        if (not std::holds_alternative<GpioIntf *>(r))
+        {
+            return "no pin object";
+        }
+        g = std::get<GpioIntf *>(r);
+    }
+    if (not g->enable_getter() or (action and g->mode_getter() != mode))
+    {
+        g->mode_setter(mode);
+        if (g->enable() != GpioErrCode::GPIO_SUCCESS)
+        {
+            return "gpio error";
+        }
+    }
+
+    GpioErrCode err = GpioErrCode::GPIO_SUCCESS;
+    if (action == ShellPinActionEnum::SET)
+    {
+        err = g->set();
+    }
+    else if (action == ShellPinActionEnum::RESET)
+    {
+        err = g->reset();
+    }
+    else if (action == ShellPinActionEnum::TOGGLE)
+    {
+        err = g->toggle();
+    }
+    auto level = g->read();
+    if (err != GpioErrCode::GPIO_SUCCESS or not std::holds_alternative<GpioStateEnum>(level))
+    {
+        return "gpio error";
+    }
+    sh.format(FMT("P%c%u %s"), static_cast<char>('A' + static_cast<int>(pin.port) - 1),
+              static_cast<uint32_t>(pin.pin) - 1U,
+              std::get<GpioStateEnum>(level) == GpioStateEnum::GPIO_STATE_SET ? "high" : "low");
+    return nullptr;
+}
+
+
+
+
+/**
+ * @brief wait, as long as the job is not killed
+ */
+static const char *cmd_sleep(ShellEngine &sh, uint32_t ms)
+{
+    const uint32_t t0 = osKernelGetTickCount();
+    while (osKernelGetTickCount() - t0 < ms)
+    {
+        if (sh.cancelled())
+        {
+            return "killed";
+        }
+        osDelay(SHELL_SLEEP_STEP_MS);
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief one `top` frame: the differences between two snapshots, busiest first
+ */
+static void top_frame(ShellEngine &sh, const CpuLoadSnapshotTypeDef &was, const CpuLoadSnapshotTypeDef &now)
+{
+    static const char *const isrName[CPU_ISR_NUM] = {"isr usb", "isr os tick", "isr hal tick"};
+    const UBaseType_t known = uxTaskGetSystemState(s_top_tasks, CPU_LOAD_TASKS, nullptr);
+    uint32_t rows           = 0;
+    uint64_t total          = 0;
+    uint64_t idle           = 0;
+    uint64_t isr            = 0;
+    uint32_t switches       = 0;
+
+    auto add = [&](const char *name, uint64_t cycles, uint32_t count, uint32_t stack) {
+        ShellTopRow &r = s_top_rows[rows++];
+        (void)format_to(r.name, sizeof(r.name), FMT("%s"), name);
+        r.cycles = cycles;
+        r.count  = count;
+        r.stack  = stack;
+        total += cycles;
+    };
+    for (uint32_t i = 0; i < CPU_LOAD_TASKS; i++)
+    {
+        const CpuLoadTaskTypeDef &t = now.tasks[i];
+        if (t.task == nullptr)
+        {
+            continue;
+        }
+        const bool same  = was.tasks[i].task == t.task and was.tasks[i].born == t.born;
+        const uint64_t c = t.cycles - (same ? was.tasks[i].cycles : 0U);
+        const uint32_t n = t.switches - (same ? was.tasks[i].switches : 0U);
+        const char *name = "?";
+        uint32_t stack   = 0;
+        for (UBaseType_t k = 0; k < known; k++)
+        {
+            if (s_top_tasks[k].xHandle == t.task)
+            {
+                name  = s_top_tasks[k].pcTaskName;
+                stack = s_top_tasks[k].usStackHighWaterMark * sizeof(StackType_t);
+            }
+        }
+        if (t.task == xTaskGetIdleTaskHandle())
+        {
+            idle += c;
+        }
+        switches += n;
+        add(name, c, n, stack);
+    }
+    if (now.other.cycles != was.other.cycles)
+    {
+        switches += now.other.switches - was.other.switches;
+        add("(others)", now.other.cycles - was.other.cycles, now.other.switches - was.other.switches, 0U);
+    }
+    for (uint32_t g = 0; g < CPU_ISR_NUM; g++)
+    {
+        isr += now.isr[g].cycles - was.isr[g].cycles;
+        add(isrName[g], now.isr[g].cycles - was.isr[g].cycles, now.isr[g].calls - was.isr[g].calls, 0U);
+    }
+
+    for (uint32_t i = 1; i < rows; i++) // a handful of rows: insertion sort
+    {
+        const ShellTopRow r = s_top_rows[i];
+        uint32_t j          = i;
+        for (; j > 0U and s_top_rows[j - 1U].cycles < r.cycles; j--)
+        {
+            s_top_rows[j] = s_top_rows[j - 1U];
+        }
+        s_top_rows[j] = r;
+    }
+
+    const uint32_t elapsed = now.stamp - was.stamp;
+    auto permille          = [&](uint64_t c) {
+        return static_cast<uint32_t>(total != 0U ? c * 1000U / total : 0U);
+    };
+    auto per_second = [&](uint32_t n) {
+        return static_cast<uint32_t>(elapsed != 0U ? static_cast<uint64_t>(n) * SystemCoreClock / elapsed : 0U);
+    };
+    const uint32_t busy = permille(total - idle);
+    const uint32_t irq  = permille(isr);
+    sh.format(FMT("cpu %u.%u%% busy over %u ms, interrupts %u.%u%%, %u switches/s"), busy / 10U, busy % 10U,
+              static_cast<uint64_t>(elapsed) * 1000U / SystemCoreClock, irq / 10U, irq % 10U, per_second(switches));
+    sh.format(FMT("%-19s %5s %8s %10s"), "name", "cpu%", "/s", "stack free");
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        const ShellTopRow &r = s_top_rows[i];
+        const uint32_t p     = permille(r.cycles);
+        if (r.stack != 0U)
+        {
+            sh.format(FMT("%-19s %3u.%u %8u %8u B"), r.name, p / 10U, p % 10U, per_second(r.count), r.stack);
+        }
+        else
+        {
+            sh.format(FMT("%-19s %3u.%u %8u %10s"), r.name, p / 10U, p % 10U, per_second(r.count), "-");
+        }
+    }
+    if (known == 0U)
+    {
+        sh.format(FMT("more than %u tasks: no names"), CPU_LOAD_TASKS);
+    }
+}
+
+
+/**
+ * @brief CPU per task and per interrupt, a frame per period: "top", "top 500 10"
+ * @param frames 1 when left out, 0: until the job is killed
+ */
+static const char *cmd_top(ShellEngine &sh, std::optional<uint32_t> ms, std::optional<uint32_t> frames)
+{
+    const uint32_t period = ms.value_or(SHELL_TOP_MS);
+    if (period < SHELL_SLEEP_STEP_MS or period > SHELL_TOP_MS_MAX)
+    {
+        return "period out of range";
+    }
+    if (s_top_busy.exchange(true))
+    {
+        return "top runs already";
+    }
+    cpu_load_snapshot(&s_top_snap[0]);
+    const uint32_t count = frames.value_or(1U);
+    const char *err      = nullptr;
+    for (uint32_t f = 0; err == nullptr and (count == 0U or f < count); f++)
+    {
+        err = cmd_sleep(sh, period);
+        if (err == nullptr)
+        {
+            cpu_load_snapshot(&s_top_snap[(f + 1U) & 1U]);
+            if (f != 0U)
+            {
+                sh.line(std::string_view());
+            }
+            top_frame(sh, s_top_snap[f & 1U], s_top_snap[(f + 1U) & 1U]);
+        }
+    }
+    s_top_busy.store(false);
+    return err;
+}
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+SHELL_COMMAND(version, cmd_version, "firmware version and build date");
+SHELL_COMMAND(uptime, cmd_uptime, "time since boot");
+SHELL_COMMAND(txq, cmd_txq, "transmit scheduler counters");
+SHELL_COMMAND(log, cmd_log, "logger counters");
+SHELL_COMMAND(usb, cmd_usb, "CDC port and class pool counters");
+SHELL_COMMAND(storage, cmd_storage, "sector cache counters");
+SHELL_COMMAND(pin, cmd_pin, "drive or read a pin");
+SHELL_COMMAND(sleep, cmd_sleep, "wait some milliseconds");
+SHELL_COMMAND(top, cmd_top, "CPU per task and interrupt, stack free");
+SHELL_COMMAND(script, cmd_script, "compiled scripts in the OSPI flash");
+
+static const ShellIndex s_index = shell_registered_index();
+
+static ShellScriptCompiler s_script_compiler(s_index, s_script_code, sizeof(s_script_code));
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief the store over the reserved top of the OSPI flash, once the
+ *        storage task enabled it
+ * @note  the first session to get here makes it, one asking meanwhile
+ *        hears "flash not ready"
+ */
+static ShellScriptStore *script_open()
+{
+    ShellScriptStore *store = s_script_store.load(std::memory_order_acquire);
+    if (store != nullptr or s_script_opening.exchange(true, std::memory_order_acquire))
+    {
+        return store;
+    }
+    auto product = p_flash_ospi_fcty->produce();
+    FlashIntf *flash =
+        std::holds_alternative<FlashIntf *>(product) ? std::get<FlashIntf *>(product) : nullptr;
+    const uint32_t size = flash != nullptr ? flash->geometry_getter().size : 0U;
+    if (flash == nullptr or not flash->enable_getter() or size <= STORAGE_RESERVED_TOP)
+    {
+        s_script_opening.store(false, std::memory_order_release);
+        return nullptr;
+    }
+    store = new (s_script_store_mem) ShellScriptStore(*flash, size - STORAGE_RESERVED_TOP, STORAGE_RESERVED_TOP);
+    s_script_loader = new (s_script_loader_mem) ShellScriptLoader(s_script_compiler, *store);
+    s_script_store.store(store, std::memory_order_release);
+    return store;
+}
+
+
+/**
+ * @brief "script load blink", the lines up to "." are its source;
+ *        "script run blink", "script list", "script rm blink"
+ */
+static const char *cmd_script(ShellEngine &sh, ShellScriptActionEnum action, std::optional<std::string_view> name)
+{
+    ShellScriptStore *store = script_open();
+    if (store == nullptr)
+    {
+        return "flash not ready";
+    }
+    if (action == ShellScriptActionEnum::LIST)
+    {
+        store->list(sh);
+        return nullptr;
+    }
+    if (not name)
+    {
+        return "missing script name";
+    }
+    switch (action)
+    {
+    case ShellScriptActionEnum::LOAD:
+        return s_script_loader->begin(sh, *name);
+    case ShellScriptActionEnum::RUN:
+        return store->run(sh, *name);
+    default:
+        return store->remove(*name);
+    }
+}
+
+
+/**
+ * @brief the region holding all of [addr, addr + len)
+ */
+const uint8_t *ShellBoardMemory::map(uint32_t addr, uint32_t len)
+{
+    for (const ShellRegion &r : s_regions)
+    {
+        if (addr - r.base < r.size and len <= r.size - (addr - r.base))
+        {
+            return reinterpret_cast<const uint8_t *>(static_cast<uintptr_t>(addr));
+        }
+    }
+    return nullptr;
+}
+
+
+bool ShellBoardMemory::read(uint32_t addr, uint32_t &word)
+{
+    return probe(addr, word, false);
+}
+
+
+bool ShellBoardMemory::write(uint32_t addr, uint32_t word)
+{
+    return probe(addr, word, true);
+}
+
+
+/**
+ * @brief one word access with the bus faults ignored, then looked at
+ * @note  FAULTMASK runs it at priority -1, where BFHFNMIGN lets a faulting
+ *        load or store complete instead of locking up; the DSB waits for a
+ *        buffered store to get its answer before the fault status is read
+ */
+bool ShellBoardMemory::probe(uint32_t addr, uint32_t &word, bool store)
+{
+    const uint32_t faultmask = __get_FAULTMASK();
+    __set_FAULTMASK(1U);
+    SCB->CFSR = SCB_CFSR_BUSFAULTSR_Msk; // write one to clear
+    SCB->CCR |= SCB_CCR_BFHFNMIGN_Msk;
+    __DSB();
+    __ISB();
+
+    volatile uint32_t *const reg = reinterpret_cast<volatile uint32_t *>(static_cast<uintptr_t>(addr));
+    if (store)
+    {
+        *reg = word;
+    }
+    else
+    {
+        word = *reg;
+    }
+    __DSB();
+
+    const bool fault = (SCB->CFSR & (SCB_CFSR_PRECISERR_Msk | SCB_CFSR_IMPRECISERR_Msk)) != 0U;
+    SCB->CFSR        = SCB_CFSR_BUSFAULTSR_Msk;
+    SCB->CCR &= ~SCB_CCR_BFHFNMIGN_Msk;
+    __DSB();
+    __ISB();
+    __set_FAULTMASK(faultmask);
+    return not fault;
+}
+
+
+/**
+ * @brief the commands every module registered
+ */
+const ShellIndex &shell_builtin_index()
+{
+    return s_index;
+}
+
+
+/**
+ * @brief the address space of md, mw and dump
+ */
+ShellMemory &shell_board_memory()
+{
+    return s_memory;
+}
@@ -0,0 +1,101 @@
+/**
+ *******************************************************************************
+ * @file    shell-complete.cpp
+ * @brief   Tab completion of command names and argument words
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-complete.hpp.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The line is only read: the words before the cursor are found by scanning
+ * for blanks, the command by its hash.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/14
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-complete.hpp"
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+static bool blank(char c)
+{
+    return c == ' ' or c == '\t';
+}
+
+
+bool shell_complete(const ShellIndex &index, std::string_view line, ShellCompletion &out)
+{
+    uint32_t start = static_cast<uint32_t>(line.size());
+    while (start != 0U and not blank(line[start - 1U]))
+    {
+        start--;
+    }
+
+    // the command and the place of the word after it
+    uint32_t word = 0;
+    std::string_view name;
+    for (uint32_t i = 0; i < start;)
+    {
+        while (i < start and blank(line[i]))
+        {
+            i++;
+        }
+        const uint32_t w = i;
+        while (i < start and not blank(line[i]))
+        {
+            i++;
+        }
+        if (i != w)
+        {
+            name = word == 0U ? line.substr(w, i - w) : name;
+            word++;
+        }
+    }
+
+    if (word == 0U)
+    {
+        out.words = index.names;
+    }
+    else
+    {
+        const ShellCommand *cmd = index.find(name);
+        if (cmd == nullptr or cmd->values == nullptr or word > cmd->paramCount or cmd->values[word - 1U].count == 0U)
+        {
+            return false;
+        }
+        out.words = cmd->values[word - 1U];
+    }
+
+    const std::string_view typed = line.substr(start);
+    out.start                    = start;
+    out.typed                    = static_cast<uint32_t>(typed.size());
+    out.range                    = shell_words_range(out.words, typed);
+    out.common                   = out.typed;
+    if (out.range.first != out.range.last)
+    {
+        const std::string_view a = out.words.list[out.range.first];
+        const std::string_view b = out.words.list[out.range.last - 1U];
+        uint32_t n               = 0;
+        while (n < a.size() and n < b.size() and shell_fold(a[n]) == shell_fold(b[n]))
+        {
+            n++;
+        }
+        out.common = n;
+    }
+    return true;
+}
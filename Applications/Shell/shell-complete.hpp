@@ -0,0 +1,76 @@
+/**
+ *******************************************************************************
+ * @file    shell-complete.hpp
+ * @brief   Tab completion of command names and argument words
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap: the word lists are the sorted ShellWords the
+ * compiler built with the command table (shell-table.hpp) and with the
+ * argument types (shell-args.hpp). Builds on the host (Tools/shell-host).
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The word under the cursor is completed from a list chosen by its place
+ * in the line: the first word from the command names, the next ones from
+ * the words of the command's arguments (pin names, on|off, enum words).
+ *
+ *      "u"             names      -> range "uptime" "usb"         common "u"
+ *      "pin pc1"       pin names  -> range "PC1" "PC10" .. "PC15" common "PC1"
+ *      "pin PC1 to"    set|reset|toggle -> "toggle", unique
+ *
+ * Two binary searches find the range, the longest common prefix of a
+ * sorted range is the one of its first and last word: a completion costs
+ * O(log n) comparisons whatever the size of the list. Matching is ASCII
+ * case folded, the words are split on spaces and tabs only.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/14
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-table.hpp"
+#include <cstdint>
+#include <string_view>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+/**
+ * @brief the candidates for one word
+ */
+struct ShellCompletion
+{
+    ShellWords words;   // the list the word is completed from
+    ShellRange range;   // the candidates in it, empty when none
+    uint32_t start;     // of the word in the line
+    uint32_t typed;     // bytes of the word before the cursor
+    uint32_t common;    // bytes the candidates share, typed or more when there is one
+};
+
+
+
+
+/*-------- 3. function prototypes --------------------------------------------*/
+
+/**
+ * @brief the candidates for the word that ends the line
+ * @param line the line up to the cursor
+ * @return false when that word has no list: unknown command, an argument
+ *         taking any text or number, more words than arguments
+ */
+bool shell_complete(const ShellIndex &index, std::string_view line, ShellCompletion &out);
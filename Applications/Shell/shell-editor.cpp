@@ -0,0 +1,871 @@
+/**
+ *******************************************************************************
+ * @file    shell-editor.cpp
+ * @brief   the line editor in front of the shell engine: VT100 keys, history, search
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-editor.hpp.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The escape sequences sent are the VT100 ones every terminal knows:
+ * ESC[nC, ESC[nD, ESC[K, and ESC[H ESC[2J for ^L. No insert or delete
+ * character sequence (VT102), the tail of the line is written again.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/13
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-editor.hpp"
+#include <cstring>
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define KEY_CTRL(c)         static_cast<uint8_t>((c) & 0x1F)
+#define KEY_ESC             0x1BU
+#define KEY_DEL             0x7FU
+
+constexpr std::string_view SEARCH_LABEL = "(search)'";
+constexpr std::string_view FAILED_LABEL = "(failed search)'";
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+static bool printable(uint8_t c)
+{
+    return c >= 0x20U and c < KEY_DEL;
+}
+
+
+/**
+ * @brief bytes of ESC[nC or ESC[nD
+ */
+static uint32_t csi_cost(uint32_t n)
+{
+    return n == 1U ? 3U : n < 10U ? 4U : n < 100U ? 5U : 6U;
+}
+
+
+/**
+ * @brief bytes of the cheapest cursor move on the line, see ShellEditor::move()
+ */
+static uint32_t move_cost(uint32_t from, uint32_t to)
+{
+    if (to >= from)
+    {
+        const uint32_t n = to - from;
+        return n <= csi_cost(n) ? n : csi_cost(n);
+    }
+    const uint32_t n  = from - to;
+    const uint32_t cr = 1U + static_cast<uint32_t>(SHELL_PROMPT.size()) + to;
+    const uint32_t c  = n < csi_cost(n) ? n : csi_cost(n);
+    return cr < c ? cr : c;
+}
+
+
+void ShellHistory::push(std::string_view line)
+{
+    const uint32_t n = static_cast<uint32_t>(line.size());
+    if (n == 0U or n > 0xFFU)
+    {
+        return;
+    }
+    const uint32_t last = newest();
+    if (last != SHELL_HIST_NONE and at(last) == n)
+    {
+        uint32_t i = 0;
+        while (i < n and _arena[(last + 1U + i) & MASK] == line[i])
+        {
+            i++;
+        }
+        if (i == n)
+        {
+            return; // the same line again
+        }
+    }
+
+    const uint32_t need = n + 2U;
+    while (SHELL_HISTORY_BYTES - _used < need)
+    {
+        _used -= at(_head - _used) + 2U;
+        _count--;
+    }
+    _arena[_head] = static_cast<char>(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        _arena[(_head + 1U + i) & MASK] = line[i];
+    }
+    _arena[(_head + 1U + n) & MASK] = static_cast<char>(n);
+    _head                           = (_head + need) & MASK;
+    _used += need;
+    _count++;
+}
+
+
+uint32_t ShellHistory::newest() const
+{
+    return _count == 0U ? SHELL_HIST_NONE : (_head - at(_head - 1U) - 2U) & MASK;
+}
+
+
+uint32_t ShellHistory::older(uint32_t pos) const
+{
+    if (pos == ((_head - _used) & MASK))
+    {
+        return SHELL_HIST_NONE;
+    }
+    return (pos - at(pos - 1U) - 2U) & MASK;
+}
+
+
+uint32_t ShellHistory::newer(uint32_t pos) const
+{
+    const uint32_t next = (pos + at(pos) + 2U) & MASK;
+    return next == _head ? SHELL_HIST_NONE : next;
+}
+
+
+uint32_t ShellHistory::copy(uint32_t pos, char *buf) const
+{
+    const uint32_t n = at(pos);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        buf[i] = _arena[(pos + 1U + i) & MASK];
+    }
+    return n;
+}
+
+
+uint32_t ShellHistory::search(std::string_view word, uint32_t pos) const
+{
+    char buf[SHELL_LINE_MAX];
+    for (; pos != SHELL_HIST_NONE; pos = older(pos))
+    {
+        if (std::string_view(buf, copy(pos, buf)).find(word) != std::string_view::npos)
+        {
+            return pos;
+        }
+    }
+    return SHELL_HIST_NONE;
+}
+
+
+/**
+ * @brief split the chunk in runs: a tagged line, printable bytes, one key
+ */
+void ShellEditor::feed(const uint8_t *buf, uint32_t len)
+{
+    uint32_t i = 0;
+    while (i < len)
+    {
+        const uint8_t c = buf[i];
+        if (_afterCr and c == '\n')
+        {
+            _afterCr = false;
+            i++;
+            continue;
+        }
+        _afterCr = false;
+
+        if (not _program and _len == 0U and not _searching and _esc == EscEnum::NONE and c == SHELL_TAG_MARK)
+        {
+            update();
+            flush(); // the echo before the replies
+            _program = true;
+        }
+        if (_program)
+        {
+            uint32_t n = 0;
+            while (i + n < len and buf[i + n] != '\r' and buf[i + n] != '\n')
+            {
+                n++;
+            }
+            if (i + n < len)
+            {
+                _afterCr = buf[i + n] == '\r';
+                _program = false;
+                n++;
+            }
+            _engine.feed(&buf[i], n);
+            i += n;
+            continue;
+        }
+
+        if (not _prompted)
+        {
+            prompt();
+        }
+        if (printable(c) and not _searching and _esc == EscEnum::NONE)
+        {
+            i += paste(&buf[i], len - i);
+        }
+        else
+        {
+            key(c);
+            i++;
+        }
+    }
+    update();
+    flush();
+}
+
+
+/**
+ * @brief a run of printable bytes, inserted with one copy
+ * @return bytes used
+ */
+uint32_t ShellEditor::paste(const uint8_t *buf, uint32_t len)
+{
+    uint32_t n = 1;
+    while (n < len and printable(buf[n]))
+    {
+        n++;
+    }
+    insert(reinterpret_cast<const char *>(buf), n);
+    _tabs = 0;
+    if (n >= SHELL_PASTE_MIN)
+    {
+        _stats.pasted += n;
+    }
+    else
+    {
+        _stats.keys += n;
+    }
+    return n;
+}
+
+
+/**
+ * @brief one byte that is not part of a printable run
+ */
+void ShellEditor::key(uint8_t c)
+{
+    if (_esc != EscEnum::NONE)
+    {
+        escape(c);
+        return;
+    }
+    _stats.keys++;
+    if (_searching)
+    {
+        search_key(c);
+        return;
+    }
+    if (c == KEY_CTRL('I'))
+    {
+        complete();
+        return;
+    }
+    _tabs = 0;
+
+    switch (c)
+    {
+    case KEY_ESC: _esc = EscEnum::ESC; break;
+    case '\r': _afterCr = true; enter(); break;
+    case '\n': enter(); break;
+    case KEY_CTRL('A'): edit(KeyEnum::HOME); break;
+    case KEY_CTRL('B'): edit(KeyEnum::LEFT); break;
+    case KEY_CTRL('C'): cancel(); break;
+    case KEY_CTRL('D'): edit(KeyEnum::DELETE); break;
+    case KEY_CTRL('E'): edit(KeyEnum::END); break;
+    case KEY_CTRL('F'): edit(KeyEnum::RIGHT); break;
+    case KEY_CTRL('K'): erase(_cur, _len); break;
+    case KEY_CTRL('L'): redraw(); break;
+    case KEY_CTRL('N'): edit(KeyEnum::DOWN); break;
+    case KEY_CTRL('P'): edit(KeyEnum::UP); break;
+    case KEY_CTRL('U'): erase(0, _cur); break;
+    case KEY_CTRL('H'):
+    case KEY_DEL:
+        if (_cur != 0U)
+        {
+            erase(_cur - 1U, _cur);
+        }
+        break;
+    case KEY_CTRL('W'):
+    {
+        uint32_t w = _cur;
+        while (w != 0U and _line[w - 1U] == ' ')
+        {
+            w--;
+        }
+        while (w != 0U and _line[w - 1U] != ' ')
+        {
+            w--;
+        }
+        erase(w, _cur);
+        break;
+    }
+    case KEY_CTRL('R'):
+        memcpy(_saved, _line, _len);
+        _savedLen  = _len;
+        _histPos   = SHELL_HIST_NONE;
+        _searching = true;
+        _found     = true;
+        _queryLen  = 0;
+        _matchAt   = _cur;
+        _dirty     = true;
+        break;
+    default: break; // other control bytes, and the bytes above 0x7E
+    }
+}
+
+
+/**
+ * @brief the bytes after ESC: ESC [ digits [; digits] final, or ESC O final
+ */
+void ShellEditor::escape(uint8_t c)
+{
+    if (_esc == EscEnum::ESC)
+    {
+        _esc    = c == '[' ? EscEnum::CSI : c == 'O' ? EscEnum::SS3 : EscEnum::NONE; // alt + key is dropped
+        _escArg = 0;
+        return;
+    }
+    if (_esc == EscEnum::CSI and c >= '0' and c <= '9')
+    {
+        _escArg = _escArg < 100U ? _escArg * 10U + (c - '0') : _escArg;
+        return;
+    }
+    if (_esc == EscEnum::CSI and c == ';')
+    {
+        _escArg += 100U; // a modifier follows, the key is in the first number
+        return;
+    }
+    if (c < 0x40U or c > 0x7EU)
+    {
+        return; // intermediate bytes
+    }
+
+    _esc       = EscEnum::NONE;
+    KeyEnum k  = KeyEnum::OTHER;
+    switch (c)
+    {
+    case 'A': k = KeyEnum::UP; break;
+    case 'B': k = KeyEnum::DOWN; break;
+    case 'C': k = KeyEnum::RIGHT; break;
+    case 'D': k = KeyEnum::LEFT; break;
+    case 'H': k = KeyEnum::HOME; break;
+    case 'F': k = KeyEnum::END; break;
+    case '~':
+    {
+        const uint32_t n = _escArg % 100U;
+        k                = n == 1U or n == 7U ? KeyEnum::HOME
+                         : n == 4U or n == 8U ? KeyEnum::END
+                         : n == 3U            ? KeyEnum::DELETE
+                                              : KeyEnum::OTHER;
+        break;
+    }
+    default: break;
+    }
+    _tabs = 0;
+    edit(k);
+}
+
+
+/**
+ * @brief cursor, delete and history keys
+ */
+void ShellEditor::edit(KeyEnum k)
+{
+    switch (k)
+    {
+    case KeyEnum::LEFT: _cur -= _cur != 0U ? 1U : 0U; break;
+    case KeyEnum::RIGHT: _cur += _cur < _len ? 1U : 0U; break;
+    case KeyEnum::HOME: _cur = 0; break;
+    case KeyEnum::END: _cur = _len; break;
+    case KeyEnum::DELETE:
+        if (_cur < _len)
+        {
+            erase(_cur, _cur + 1U);
+        }
+        break;
+    case KeyEnum::UP:
+    {
+        const uint32_t pos = _histPos == SHELL_HIST_NONE ? _history.newest() : _history.older(_histPos);
+        if (pos == SHELL_HIST_NONE)
+        {
+            _bell = true;
+            break;
+        }
+        if (_histPos == SHELL_HIST_NONE)
+        {
+            memcpy(_saved, _line, _len);
+            _savedLen = _len;
+        }
+        recall(pos);
+        break;
+    }
+    case KeyEnum::DOWN:
+        if (_histPos == SHELL_HIST_NONE)
+        {
+            break;
+        }
+        if (_history.newer(_histPos) != SHELL_HIST_NONE)
+        {
+            recall(_history.newer(_histPos));
+            break;
+        }
+        memcpy(_line, _saved, _savedLen); // past the newest: the own line again
+        _len     = _savedLen;
+        _cur     = _len;
+        _histPos = SHELL_HIST_NONE;
+        break;
+    case KeyEnum::OTHER: break;
+    }
+    _dirty = true;
+}
+
+
+/**
+ * @brief a key while searching: printable bytes extend the search, ^R goes
+ *        further back, any other key takes the line found and is applied
+ */
+void ShellEditor::search_key(uint8_t c)
+{
+    _dirty = true;
+    if (printable(c))
+    {
+        if (_queryLen == SHELL_QUERY_MAX)
+        {
+            _bell = true;
+            return;
+        }
+        _query[_queryLen++] = static_cast<char>(c);
+        search_step(_histPos == SHELL_HIST_NONE ? _history.newest() : _histPos);
+        return;
+    }
+
+    switch (c)
+    {
+    case KEY_CTRL('R'):
+        if (_queryLen != 0U and _histPos != SHELL_HIST_NONE)
+        {
+            search_step(_history.older(_histPos));
+        }
+        break;
+    case KEY_CTRL('H'):
+    case KEY_DEL:
+        if (_queryLen != 0U)
+        {
+            _queryLen--;
+            search_step(_history.newest());
+        }
+        break;
+    case KEY_CTRL('C'):
+    case KEY_CTRL('G'): search_end(false); break;
+    case KEY_ESC:
+        search_end(true);
+        _esc = EscEnum::ESC;
+        break;
+    default:
+        search_end(true);
+        _stats.keys--; // counted once, by key()
+        key(c);
+        break;
+    }
+}
+
+
+/**
+ * @brief the first line from pos on, going older, with the query in it
+ */
+void ShellEditor::search_step(uint32_t pos)
+{
+    if (_queryLen == 0U)
+    {
+        _found = true;
+        return;
+    }
+    const std::string_view q(_query, _queryLen);
+    pos = pos == SHELL_HIST_NONE ? pos : _history.search(q, pos);
+    if (pos == SHELL_HIST_NONE)
+    {
+        _found = false;
+        _bell  = true;
+        return;
+    }
+    _found   = true;
+    _histPos = pos;
+    _len     = _history.copy(pos, _line);
+    _matchAt = static_cast<uint32_t>(std::string_view(_line, _len).find(q));
+    _cur     = _matchAt;
+}
+
+
+/**
+ * @brief leave the search with the line found, or with the line before it
+ */
+void ShellEditor::search_end(bool keep)
+{
+    _searching = false;
+    _histPos   = SHELL_HIST_NONE;
+    _dirty     = true;
+    if (not keep)
+    {
+        memcpy(_line, _saved, _savedLen);
+        _len = _savedLen;
+        _cur = _len;
+    }
+}
+
+
+void ShellEditor::insert(const char *s, uint32_t n)
+{
+    const uint32_t room = SHELL_LINE_MAX - 1U - _len;
+    if (n > room)
+    {
+        n     = room;
+        _bell = true;
+    }
+    memmove(&_line[_cur + n], &_line[_cur], _len - _cur);
+    memcpy(&_line[_cur], s, n);
+    _len += n;
+    _cur += n;
+    _dirty = true;
+}
+
+
+void ShellEditor::erase(uint32_t from, uint32_t to)
+{
+    memmove(&_line[from], &_line[to], _len - to);
+    _len -= to - from;
+    _cur   = from;
+    _dirty = true;
+}
+
+
+void ShellEditor::recall(uint32_t pos)
+{
+    _histPos = pos;
+    _len     = _history.copy(pos, _line);
+    _cur     = _len;
+    _dirty   = true;
+}
+
+
+/**
+ * @brief tab: insert what all candidates share, or list them on the second
+ *        tab that adds nothing
+ */
+void ShellEditor::complete()
+{
+    ShellCompletion c;
+    if (not shell_complete(_engine.index_getter(), std::string_view(_line, _cur), c) or c.range.first == c.range.last)
+    {
+        _bell = true;
+        return;
+    }
+    const std::string_view first = c.words.list[c.range.first];
+    if (c.common > c.typed)
+    {
+        insert(&first[c.typed], c.common - c.typed);
+    }
+    if (c.range.last - c.range.first == 1U)
+    {
+        if (_cur == _len or _line[_cur] != ' ')
+        {
+            insert(" ", 1U); // unique: on to the next word
+        }
+        _tabs = 0;
+        return;
+    }
+    if (c.common > c.typed)
+    {
+        _tabs = 0;
+        return;
+    }
+    if (_tabs++ == 0U)
+    {
+        _bell = true;
+        return;
+    }
+    list(c);
+}
+
+
+/**
+ * @brief the candidates under the line, then the prompt and the line again
+ */
+void ShellEditor::list(const ShellCompletion &c)
+{
+    update();
+    put("\r\n");
+    const uint32_t n    = c.range.last - c.range.first;
+    const uint32_t show = n < SHELL_LIST_MAX ? n : SHELL_LIST_MAX;
+    uint32_t col        = 0;
+    for (uint32_t i = 0; i < show; i++)
+    {
+        const std::string_view w = c.words.list[c.range.first + i];
+        if (col != 0U and col + 2U + w.size() > SHELL_LIST_COLS)
+        {
+            put("\r\n");
+            col = 0;
+        }
+        if (col != 0U)
+        {
+            put("  ");
+            col += 2U;
+        }
+        put(w);
+        col += static_cast<uint32_t>(w.size());
+    }
+    if (show < n)
+    {
+        char more[24];
+        uint32_t k = 0;
+        for (uint32_t v = n - show, d = v >= 100U ? 100U : v >= 10U ? 10U : 1U; d != 0U; d /= 10U)
+        {
+            more[k++] = static_cast<char>('0' + v / d % 10U);
+        }
+        put("  (");
+        put(more, k);
+        put(" more)");
+    }
+    put("\r\n");
+    prompt();
+    _dirty = true;
+}
+
+
+/**
+ * @brief run the line: the screen shows it whole first
+ */
+void ShellEditor::enter()
+{
+    update();
+    put("\r\n");
+    const uint32_t len = _len;
+    _history.push(line_getter());
+    _len     = 0;
+    _cur     = 0;
+    _histPos = SHELL_HIST_NONE;
+    if (len != 0U or _engine.collecting_getter())
+    {
+        _stats.lines++;
+        flush(); // the echo before the replies
+        _engine.execute(_line, len);
+    }
+    prompt();
+}
+
+
+void ShellEditor::cancel()
+{
+    update();
+    put("^C\r\n");
+    _len     = 0;
+    _cur     = 0;
+    _histPos = SHELL_HIST_NONE;
+    prompt();
+}
+
+
+void ShellEditor::redraw()
+{
+    put("\x1b[H\x1b[2J");
+    prompt();
+    _dirty = true;
+}
+
+
+/**
+ * @brief bring the screen to the line, or to the search
+ */
+void ShellEditor::update()
+{
+    if (_dirty)
+    {
+        _dirty = false;
+        _stats.updates++;
+        if (not _searching)
+        {
+            render(_line, _len, _cur);
+        }
+        else
+        {
+            const std::string_view label = _found ? SEARCH_LABEL : FAILED_LABEL;
+            uint32_t n                   = 0;
+            auto add                     = [&](const char *s, uint32_t k) {
+                memcpy(&_view[n], s, k);
+                n += k;
+            };
+            add(label.data(), static_cast<uint32_t>(label.size()));
+            add(_query, _queryLen);
+            add("': ", 3U);
+            const uint32_t at = n;
+            add(_line, _len);
+            render(_view, n, at + (_queryLen != 0U ? _matchAt : _cur));
+        }
+    }
+    if (_bell)
+    {
+        _bell = false;
+        put("\a");
+    }
+}
+
+
+/**
+ * @brief send the difference between the shown text and want, leave the
+ *        cursor at col
+ */
+void ShellEditor::render(const char *want, uint32_t len, uint32_t col)
+{
+    const uint32_t common = len < _shownLen ? len : _shownLen;
+    uint32_t p            = 0;
+    while (p < common and want[p] == _shown[p])
+    {
+        p++;
+    }
+
+    if (p < len or _shownLen > len)
+    {
+        uint32_t end = len;
+        if (len == _shownLen)
+        {
+            while (end > p and want[end - 1U] == _shown[end - 1U])
+            {
+                end--; // a change in the middle: the same tail is left alone
+            }
+        }
+        move(want, p);
+        put(&want[p], end - p);
+        _col = end;
+
+        if (_shownLen > len)
+        {
+            // blanks cost a byte each and a longer way back, ESC[K three bytes
+            const uint32_t gone = _shownLen - len;
+            if (gone + move_cost(len + gone, col) < 3U + move_cost(len, col))
+            {
+                for (uint32_t i = 0; i < gone; i++)
+                {
+                    put(" ");
+                }
+                _col = len + gone;
+            }
+            else
+            {
+                put("\x1b[K");
+            }
+        }
+        memcpy(_shown, want, len);
+        _shownLen = len;
+    }
+    move(want, col);
+}
+
+
+/**
+ * @brief the cheapest way to column to: backspaces, ESC[nD, or a carriage
+ *        return and the prompt going left; the shown bytes or ESC[nC going
+ *        right
+ * @param want the text on the screen up to the cursor and to
+ */
+void ShellEditor::move(const char *want, uint32_t to)
+{
+    if (to == _col)
+    {
+        return;
+    }
+
+    char csi[8];
+    const uint32_t n = to > _col ? to - _col : _col - to;
+    uint32_t k       = 0;
+    csi[k++]         = '\x1b';
+    csi[k++]         = '[';
+    if (n > 1U)
+    {
+        for (uint32_t d = n >= 100U ? 100U : n >= 10U ? 10U : 1U; d != 0U; d /= 10U)
+        {
+            csi[k++] = static_cast<char>('0' + n / d % 10U);
+        }
+    }
+    csi[k++] = to > _col ? 'C' : 'D';
+
+    if (to > _col)
+    {
+        if (n <= k)
+        {
+            put(&want[_col], n);
+        }
+        else
+        {
+            put(csi, k);
+        }
+    }
+    else if (1U + SHELL_PROMPT.size() + to < (n < k ? n : k))
+    {
+        put("\r");
+        put(SHELL_PROMPT);
+        put(want, to);
+    }
+    else if (n < k)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            put("\b");
+        }
+    }
+    else
+    {
+        put(csi, k);
+    }
+    _col = to;
+}
+
+
+void ShellEditor::put(const char *s, uint32_t n)
+{
+    _stats.echoed += n;
+    while (n != 0U)
+    {
+        if (_echoLen == SHELL_ECHO_CHUNK)
+        {
+            flush();
+        }
+        const uint32_t room = SHELL_ECHO_CHUNK - _echoLen;
+        const uint32_t k    = n < room ? n : room;
+        memcpy(&_echo[_echoLen], s, k);
+        _echoLen += k;
+        s += k;
+        n -= k;
+    }
+}
+
+
+/**
+ * @brief a new prompt on an empty line
+ */
+void ShellEditor::prompt()
+{
+    put(SHELL_PROMPT);
+    _shownLen = 0;
+    _col      = 0;
+    _prompted = true;
+}
+
+
+void ShellEditor::flush()
+{
+    if (_echoLen != 0U)
+    {
+        _out.write(_echo, _echoLen);
+        _echoLen = 0;
+    }
+}
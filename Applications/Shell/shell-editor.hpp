@@ -0,0 +1,288 @@
+/**
+ *******************************************************************************
+ * @file    shell-editor.hpp
+ * @brief   the line editor in front of the shell engine: VT100 keys, history, search
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap, like the engine: the owner feeds the received
+ * bytes to the editor instead of the engine, the editor echoes through the
+ * same ShellOutput and hands every accepted line to ShellEngine::execute().
+ * Tools/shell-host drives it with scripted keys and checks the screen.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The editor keeps what the terminal shows after the prompt. A key only
+ * changes the line; before the echo leaves, the new line is compared with
+ * the shown one and only the difference is sent, with the cheapest cursor
+ * move (backspaces, ESC[nC/ESC[nD, or a carriage return and the prompt):
+ *
+ *      shown  "md 2400000 16"   cursor after "240000"
+ *      key    '0'
+ *      echo   "00 16" "\b\b\b\b"       not the line, not per character
+ *
+ * The screen is brought up to date once per received chunk and before a
+ * line runs, so the keys of one USB packet cost one echo; a paste is
+ * copied into the line run by run, without looking at each byte, and its
+ * lines run one after the other.
+ *
+ * A line starting with SHELL_TAG_MARK comes from a program (shell-proto.hpp):
+ * it is passed to ShellEngine::feed() untouched, without echo or history.
+ *
+ *      keys    left right home end (also ^B ^F ^A ^E), backspace, delete
+ *              (also ^D), ^K ^U ^W cut, up down (also ^P ^N) history,
+ *              ^R search back, ^C drop the line, ^L redraw, tab completes
+ *              (shell-complete.hpp): the common part of the candidates,
+ *              the list of them on a second tab
+ *
+ * The line is ASCII and fits the terminal width: bytes above 0x7E are
+ * ignored, a line wrapped by the terminal is not followed by the cursor
+ * moves.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/13
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-complete.hpp"
+#include "shell-engine.hpp"
+#include <cstdint>
+#include <string_view>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr std::string_view SHELL_PROMPT = "> ";
+constexpr uint32_t SHELL_HISTORY_BYTES  = 1024U;    // arena of the history ring, a power of two
+constexpr uint32_t SHELL_QUERY_MAX      = 32U;      // search words
+constexpr uint32_t SHELL_VIEW_MAX       = SHELL_LINE_MAX + SHELL_QUERY_MAX + 16U;
+constexpr uint32_t SHELL_ECHO_CHUNK     = 128U;     // echo bytes gathered before a write
+constexpr uint32_t SHELL_PASTE_MIN      = 8U;       // printable bytes in one run: not typed
+constexpr uint32_t SHELL_LIST_COLS      = 80U;      // width of a candidate list
+constexpr uint32_t SHELL_LIST_MAX       = 64U;      // candidates listed, the others counted
+constexpr uint32_t SHELL_HIST_NONE      = 0xFFFFFFFFU;
+
+
+
+
+/*-------- 3. history --------------------------------------------------------*/
+
+/**
+ * @brief the last lines run, in a ring of bytes: the oldest lines make room
+ * @note  an entry is its length, its bytes and its length again, so the
+ *        ring is walked both ways without an index:
+ *
+ *            ... | 4 e c h o 4 | 7 v e r s i o n 7 | <- head
+ *                  ^ older()      ^ newest()
+ */
+class ShellHistory
+{
+  public:
+    static_assert((SHELL_HISTORY_BYTES & (SHELL_HISTORY_BYTES - 1U)) == 0U, "a power of two");
+    static_assert(SHELL_LINE_MAX - 1U <= 0xFFU, "a length fits one byte");
+
+    /**
+     * @brief keep a line, unless empty or the same as the newest
+     */
+    void push(std::string_view line);
+
+    /**
+     * @brief positions of entries, SHELL_HIST_NONE past either end
+     */
+    [[nodiscard]] uint32_t newest() const;
+    [[nodiscard]] uint32_t older(uint32_t pos) const;
+    [[nodiscard]] uint32_t newer(uint32_t pos) const;
+
+    /**
+     * @brief copy the entry at pos into buf, SHELL_LINE_MAX bytes
+     * @return its length
+     */
+    uint32_t copy(uint32_t pos, char *buf) const;
+
+    /**
+     * @brief the first entry from pos on, going older, that contains word
+     */
+    [[nodiscard]] uint32_t search(std::string_view word, uint32_t pos) const;
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t count_getter() const
+    {
+        return _count;
+    }
+
+    [[nodiscard]] uint32_t used_getter() const
+    {
+        return _used;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    static constexpr uint32_t MASK = SHELL_HISTORY_BYTES - 1U;
+
+    [[nodiscard]] uint8_t at(uint32_t pos) const
+    {
+        return static_cast<uint8_t>(_arena[pos & MASK]);
+    }
+
+    char _arena[SHELL_HISTORY_BYTES];
+    uint32_t _head  = 0;    // where the next entry goes
+    uint32_t _used  = 0;
+    uint32_t _count = 0;
+};
+
+
+
+
+/*-------- 4. editor ---------------------------------------------------------*/
+
+/**
+ * @brief the keys of a person, in front of a ShellEngine
+ */
+class ShellEditor
+{
+  public:
+    /**
+     * @brief counters, for the shell and the host benchmark
+     */
+    struct Stats
+    {
+        uint32_t keys;          // key bytes and escape sequences handled one by one
+        uint32_t pasted;        // bytes copied in by runs of SHELL_PASTE_MIN or more
+        uint32_t lines;         // lines handed to the engine
+        uint32_t updates;       // screen updates
+        uint32_t echoed;        // bytes of echo, prompt included
+    };
+
+    ShellEditor(ShellEngine &engine, ShellOutput &out) : _engine(engine), _out(out)
+    {
+    }
+
+    /**
+     * @brief received bytes: keys are applied, accepted lines are run
+     */
+    void feed(const uint8_t *buf, uint32_t len);
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] std::string_view line_getter() const
+    {
+        return std::string_view(_line, _len);
+    }
+
+    [[nodiscard]] uint32_t cursor_getter() const
+    {
+        return _cur;
+    }
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    [[nodiscard]] ShellHistory &history_getter()
+    {
+        return _history;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    enum class EscEnum : uint8_t
+    {
+        NONE,
+        ESC,    // ESC seen
+        CSI,    // ESC [ and digits
+        SS3,    // ESC O
+    };
+
+    enum class KeyEnum : uint8_t
+    {
+        LEFT,
+        RIGHT,
+        HOME,
+        END,
+        UP,
+        DOWN,
+        DELETE,
+        OTHER,
+    };
+
+    uint32_t paste(const uint8_t *buf, uint32_t len);
+    void key(uint8_t c);
+    void escape(uint8_t c);
+    void edit(KeyEnum k);
+    void search_key(uint8_t c);
+    void search_step(uint32_t from);
+    void search_end(bool keep);
+    void insert(const char *s, uint32_t n);
+    void erase(uint32_t from, uint32_t to);
+    void recall(uint32_t pos);
+    void complete();
+    void list(const ShellCompletion &c);
+    void enter();
+    void cancel();
+    void redraw();
+
+    void update();
+    void render(const char *want, uint32_t len, uint32_t col);
+    void move(const char *want, uint32_t to);
+    void put(const char *s, uint32_t n);
+    void put(std::string_view s)
+    {
+        put(s.data(), static_cast<uint32_t>(s.size()));
+    }
+    void prompt();
+    void flush();
+
+    ShellEngine &_engine;
+    ShellOutput &_out;
+    ShellHistory _history;
+
+    char _line[SHELL_LINE_MAX];         // the line being edited
+    uint32_t _len = 0;
+    uint32_t _cur = 0;
+
+    char _saved[SHELL_LINE_MAX];        // the own line while browsing or searching
+    uint32_t _savedLen = 0;
+    uint32_t _histPos  = SHELL_HIST_NONE;
+
+    char _query[SHELL_QUERY_MAX];
+    uint32_t _queryLen = 0;
+    uint32_t _matchAt  = 0;             // of the query in the line
+    bool _searching    = false;
+    bool _found        = true;
+
+    char _shown[SHELL_VIEW_MAX];        // on the terminal after the prompt
+    uint32_t _shownLen = 0;
+    uint32_t _col      = 0;             // cursor on the terminal, after the prompt
+    char _view[SHELL_VIEW_MAX];         // what a search shows
+
+    char _echo[SHELL_ECHO_CHUNK];
+    uint32_t _echoLen = 0;
+
+    EscEnum _esc      = EscEnum::NONE;
+    uint32_t _escArg  = 0;
+    bool _program     = false;          // passing a tagged line to the engine
+    bool _afterCr     = false;          // a '\n' right after '\r' is the same line end
+    bool _prompted    = false;
+    bool _dirty       = false;
+    bool _bell        = false;
+    uint8_t _tabs     = 0;              // tabs in a row without a completion
+    Stats _stats      = {};
+};
@@ -0,0 +1,500 @@
+/**
+ *******************************************************************************
+ * @file    shell-engine.cpp
+ * @brief   the shell core: command lines in, dispatch through the table, replies out
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-engine.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/11
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-engine.hpp"
+#include "shell-args.hpp"
+#include "shell-env.hpp"
+#include "shell-jobs.hpp"
+#include "../Update/fwu-proto.hpp"
+#include <cstring>
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief collect lines, '\r', '\n' or both end a line
+ */
+void ShellEngine::feed(const uint8_t *buf, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        const char c = static_cast<char>(buf[i]);
+        if (c == '\r' or c == '\n')
+        {
+            // the start of a long line is kept: a tagged request still gets its end line;
+            // a sink counts the empty lines too, "\r\n" being one line end
+            if (_len != 0U or (_sink != nullptr and not (c == '\n' and _afterCr)))
+            {
+                _stats.overlong += _overflow ? 1U : 0U;
+                execute(_line, _len);
+            }
+            _len      = 0;
+            _overflow = false;
+        }
+        else if (_len < SHELL_LINE_MAX - 1U)
+        {
+            _line[_len++] = c;
+        }
+        else
+        {
+            _overflow = true;
+        }
+        _afterCr = c == '\r';
+    }
+}
+
+
+/**
+ * @brief split the tag and the words, run the command or the batch, end the reply
+ */
+void ShellEngine::execute(char *line, uint32_t len)
+{
+    if (_sink != nullptr)
+    {
+        take(line, len);
+        return;
+    }
+
+    ShellTagged t{};
+    _tagged = shell_parse_tagged(std::string_view(line, len), t) and t.kind == ' ';
+    _tag    = t.tag;
+    if (_tagged)
+    {
+        line += t.rest.data() - line; // the command after the tag, in place
+        len = static_cast<uint32_t>(t.rest.size());
+    }
+
+    ShellArgv args;
+    const char *err = shell_tokenize(line, len, args);
+    if (args.argc == 0U and err == nullptr and not _tagged)
+    {
+        return;
+    }
+    begin();
+    if (_overflow)
+    {
+        finish("line too long");
+        return;
+    }
+    if (err != nullptr)
+    {
+        finish(err);
+        return;
+    }
+
+    for (uint32_t i = 0; i < args.argc; i++)
+    {
+        if (args.argv[i] == SHELL_BATCH_MARK)
+        {
+            batch(args);
+            return;
+        }
+    }
+    finish(run(args));
+}
+
+
+/**
+ * @brief one command of a line: its variables, then a job, a pipeline or the handler
+ */
+const char *ShellEngine::run(ShellArgv &args)
+{
+    const char *err = _env != nullptr ? _env->expand(args) : nullptr;
+    if (err != nullptr)
+    {
+        return err;
+    }
+
+    const bool background = args.argc > 1U and args.argv[args.argc - 1U] == SHELL_JOB_MARK;
+    args.argc -= background ? 1U : 0U;
+    bool piped = false;
+    for (uint32_t i = 0; i < args.argc; i++)
+    {
+        piped = piped or args.argv[i] == SHELL_PIPE_MARK;
+    }
+    if (background or piped)
+    {
+        return spawn(args, background);
+    }
+    return dispatch(args);
+}
+
+
+/**
+ * @brief "a ; b ; c": each command in turn, its words moved to the front
+ * @note  a command changes the words it is given only, those after it wait
+ *        in place; an empty command fails, a last ";" is ignored
+ */
+void ShellEngine::batch(ShellArgv &args)
+{
+    const char *first = nullptr;
+    uint32_t rest     = args.argc;
+    while (rest != 0U)
+    {
+        uint32_t n = 0;
+        while (n < rest and args.argv[n] != SHELL_BATCH_MARK)
+        {
+            n++;
+        }
+        args.argc       = n;
+        const char *err = n != 0U ? run(args) : "empty command";
+        end(err);
+        first = first == nullptr ? err : first;
+
+        rest -= n < rest ? n + 1U : n;
+        for (uint32_t i = 0; i < rest; i++)
+        {
+            args.argv[i] = args.argv[n + 1U + i];
+        }
+    }
+    close(first);
+}
+
+
+const char *ShellEngine::dispatch(const ShellArgv &args)
+{
+    const ShellCommand *cmd = _index.find(args.argc != 0U ? args.argv[0] : std::string_view());
+    if (cmd == nullptr)
+    {
+        _stats.unknown++;
+        return "unknown command";
+    }
+    _stats.commands++;
+    return cmd->handler(*this, args);
+}
+
+
+/**
+ * @brief "a | b | c", "a | b &", "cmd &": the stages before the last as
+ *        jobs, the last one here or as a job too
+ * @note  the command names are checked here, their arguments by the stages;
+ *        a pipeline needs a worker for each of its jobs at once
+ */
+const char *ShellEngine::spawn(ShellArgv &args, bool background)
+{
+    uint32_t first[SHELL_PIPE_MAX + 1U];
+    uint32_t stages = 1;
+    first[0]        = 0;
+    for (uint32_t i = 0; i < args.argc; i++)
+    {
+        if (args.argv[i] == SHELL_PIPE_MARK)
+        {
+            if (stages == SHELL_PIPE_MAX)
+            {
+                return "too many stages";
+            }
+            first[stages++] = i + 1U;
+        }
+    }
+    first[stages] = args.argc + 1U;
+    for (uint32_t k = 0; k < stages; k++)
+    {
+        if (first[k + 1U] - first[k] < 2U)
+        {
+            return "empty stage";
+        }
+        if (_index.find(args.argv[first[k]]) == nullptr)
+        {
+            _stats.unknown++;
+            return "unknown command";
+        }
+    }
+
+    const uint32_t jobs = background ? stages : stages - 1U;
+    if (_jobs == nullptr)
+    {
+        return "no background jobs";
+    }
+    if (jobs > _jobs->workers_getter())
+    {
+        return "more stages than workers";
+    }
+    if (not background and jobs > _jobs->idle_getter())
+    {
+        return "workers busy";     // the stages run together or not at all
+    }
+    if (jobs > _jobs->free_getter())
+    {
+        return "job table full";
+    }
+
+    ShellJob *source = nullptr;
+    for (uint32_t k = 0; k < jobs; k++)
+    {
+        source = _jobs->submit(&args.argv[first[k]], first[k + 1U] - first[k] - 1U, source, k + 1U < stages);
+    }
+    if (background)
+    {
+        _stats.commands++;
+        format(FMT("[%u]"), _jobs->number_getter(*source));
+        return nullptr;
+    }
+
+    // the last stage here: its words to the front, the stage before as input
+    const uint32_t last = first[stages - 1U];
+    args.argc -= last;
+    for (uint32_t i = 0; i < args.argc; i++)
+    {
+        args.argv[i] = args.argv[last + i];
+    }
+    ShellCancel cancel;
+    ShellCancel *saved = _cancel;
+    _cancel            = &cancel;
+    input_setter(_jobs, source);
+    const char *err = dispatch(args);
+    input_setter(nullptr, nullptr);
+    _cancel = saved;
+    _jobs->detach(*source);
+    return cancel.requested() ? "interrupted" : err;
+}
+
+
+bool ShellEngine::read(char *buf, uint32_t &len)
+{
+    return _in != nullptr and _inJobs->read(*_in, _cancel, buf, len);
+}
+
+
+bool ShellEngine::collect(ShellLineSink *sink)
+{
+    if (_cancel != nullptr)
+    {
+        return false;
+    }
+    _sink    = sink;
+    _sinkCut = false;
+    return true;
+}
+
+
+/**
+ * @brief a line after collect(): to the sink, or the end of the text
+ */
+void ShellEngine::take(char *line, uint32_t len)
+{
+    ShellTagged t{};
+    const bool tagged = shell_parse_tagged(std::string_view(line, len), t) and t.kind == ' ';
+    if ((tagged ? t.rest : std::string_view(line, len)) != SHELL_TEXT_END)
+    {
+        _sinkCut = _sinkCut or _overflow;
+        _sink->line(line, len);
+        return;
+    }
+
+    ShellLineSink *sink = _sink;
+    _sink               = nullptr;
+    _tagged             = tagged;
+    _tag                = t.tag;
+    begin();
+    finish(sink->end(*this, _sinkCut));
+}
+
+
+/**
+ * @brief "!<tag><kind>" in front of a tagged reply, nothing for a person
+ * @return bytes written at buf, 12 at most
+ */
+uint32_t ShellEngine::mark(char *buf, char kind) const
+{
+    if (not _tagged)
+    {
+        return 0;
+    }
+    char digits[10];
+    uint32_t n   = 0;
+    uint32_t tag = _tag;
+    do
+    {
+        digits[n++] = static_cast<char>('0' + tag % 10U);
+        tag /= 10U;
+    } while (tag != 0U);
+
+    uint32_t p = 0;
+    buf[p++]   = SHELL_TAG_MARK;
+    while (n != 0U)
+    {
+        buf[p++] = digits[--n];
+    }
+    buf[p++] = kind;
+    return p;
+}
+
+
+/**
+ * @brief the mark of a reply at the start of _reply
+ */
+uint32_t ShellEngine::prefix(char kind)
+{
+    return mark(_reply, kind);
+}
+
+
+/**
+ * @brief close the line in _reply and hand it over in one piece
+ */
+void ShellEngine::emit(uint32_t len)
+{
+    _reply[len++] = '\r';
+    _reply[len++] = '\n';
+    _out.write(_reply, len);
+}
+
+
+void ShellEngine::line(std::string_view text)
+{
+    if (_machine)
+    {
+        record()->text(text);
+        return;
+    }
+    const uint32_t p   = prefix(SHELL_BODY_MARK);
+    const uint32_t cap = SHELL_REPLY_MAX - p - 2U;
+    const uint32_t n   = text.size() < cap ? static_cast<uint32_t>(text.size()) : cap;
+    memcpy(&_reply[p], text.data(), n);
+    emit(p + n);
+}
+
+
+/**
+ * @brief a line starts: the mode it runs in, a new stream of frames
+ */
+void ShellEngine::begin()
+{
+    _machine   = _mode == ShellModeEnum::CBOR and _frame != nullptr;
+    _recording = false;
+    _step      = 0;
+    if (_machine)
+    {
+        _cbor = CborOut(&_frame[sizeof(ShellFrameHdr)], SHELL_FRAME_DATA, this);
+    }
+}
+
+
+/**
+ * @brief the body of the running command, its record opened by the first item
+ */
+CborOut *ShellEngine::record()
+{
+    if (not _recording)
+    {
+        _recording = true;
+        _cbor.map(4U);
+        _cbor.uinteger(0U);
+        _cbor.uinteger(tag_getter());
+        _cbor.uinteger(1U);
+        _cbor.uinteger(_step);
+        _cbor.uinteger(2U);
+        _cbor.open_array();
+    }
+    return &_cbor;
+}
+
+
+/**
+ * @brief a frame of the record stream: the header in front of the payload, in place
+ * @note  addr is where the payload starts in the stream of the line, the
+ *        host puts the frames of a tag back together and sees a lost one
+ */
+void ShellEngine::spill(const uint8_t *buf, uint32_t len)
+{
+    const ShellFrameHdr hdr = {SHELL_FRAME_MARK,
+                               SHELL_FRAME_CBOR,
+                               static_cast<uint16_t>(len),
+                               tag_getter(),
+                               static_cast<uint32_t>(_cbor.total_getter() - len),
+                               fwu_crc32(0, buf, len)};
+    memcpy(_frame, &hdr, sizeof(hdr));
+    _out.write(reinterpret_cast<const char *>(_frame), sizeof(hdr) + len);
+}
+
+
+/**
+ * @brief one command of the line ended: its record, or "err <reason>" for a person
+ */
+void ShellEngine::end(const char *err)
+{
+    if (err != nullptr)
+    {
+        _stats.failed++;
+    }
+    if (_machine)
+    {
+        record()->close();
+        _recording = false;
+        _cbor.uinteger(3U);
+        if (err != nullptr)
+        {
+            _cbor.text(err);
+        }
+        else
+        {
+            _cbor.null();
+        }
+    }
+    else if (not _tagged and err != nullptr)
+    {
+        FormatOut out(_reply, SHELL_REPLY_MAX - 2U);
+        format_to(out, FMT("err %s"), err);
+        emit(out.len());
+    }
+    _step++;
+}
+
+
+/**
+ * @brief the line ended: its last frame, then "=ok" or "=err <reason>" for a program
+ */
+void ShellEngine::close(const char *err)
+{
+    if (_machine)
+    {
+        _cbor.flush();
+        _machine = false;
+    }
+    if (not _tagged)
+    {
+        return;
+    }
+
+    const uint32_t p = prefix(SHELL_END_MARK);
+    FormatOut out(&_reply[p], SHELL_REPLY_MAX - p - 2U);
+    if (err != nullptr)
+    {
+        format_to(out, FMT("err %s"), err);
+    }
+    else
+    {
+        out.put("ok", 2U);
+    }
+    emit(p + out.len());
+}
+
+
+/**
+ * @brief a line of one command
+ */
+void ShellEngine::finish(const char *err)
+{
+    end(err);
+    close(err);
+}
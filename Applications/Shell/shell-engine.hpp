@@ -0,0 +1,459 @@
+/**
+ *******************************************************************************
+ * @file    shell-engine.hpp
+ * @brief   the shell core: command lines in, dispatch through the table, replies out
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap, like the table: the owner feeds the bytes it
+ * receives and gives a ShellOutput for the replies, the engine knows
+ * nothing of the link. shell-cdc.cpp runs it on the shell CDC port,
+ * Tools/shell-host runs it on Linux. One engine is used by one task.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Lines follow shell-proto.hpp. The words of a line are split in place
+ * (shell-args.hpp) and the handler found by the first one gets them all.
+ * A tagged request gets tagged body lines and
+ * one end line; a line typed by a person gets its body lines as they are,
+ * and "err <reason>" when the command fails.
+ *
+ * Every reply line is formatted whole in the engine and handed to the
+ * output in one write(), so a line is one message of the transmit scheduler
+ * and is never cut by a log line.
+ *
+ * A line ending with the word "&" is handed to the job table (shell-jobs.hpp)
+ * instead: the engine only answers "[<job>]", a worker task runs the command
+ * on its own engine, whose output is the job's buffer. A line with the word
+ * "|" is a pipeline: each stage but the last is a job, and a stage reads
+ * the lines of the one before with read().
+ *
+ * A word "$name" is replaced by the value of the variable before the line
+ * runs, when the engine has variables (shell-env.hpp, those of its session).
+ *
+ * The word ";" makes a batch: the commands between run one after the
+ * other, each to its end whatever the others did. A person gets "err
+ * <reason>" for each that fails, a program one end line for the whole
+ * line, carrying the first failure.
+ *
+ * In machine mode (`mode cbor`, an engine given a frame buffer) the body of
+ * a command is CBOR instead of lines (cbor.hpp): format() writes the array
+ * of its arguments, line() a text string, a command may also
+ * write items of its own to cbor(). Each command of a line is one record,
+ *
+ *      {0: tag, 1: index in the batch, 2: [_ body items], 3: null or reason}
+ *
+ * streamed through frames of shell-proto.hpp (SHELL_FRAME_CBOR) handed to
+ * write() like reply lines, so a log line never cuts one; the end line of
+ * a tagged request follows its last frame. A mode takes effect from the
+ * next line on.
+ *
+ * A command can also take the lines that follow it (`script load`): after
+ * collect() the engine hands every line to the sink as it is, without a
+ * reply, up to a line holding only "."; that line gets the reply of the
+ * sink, tagged when it is.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/11
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-proto.hpp"
+#include "shell-table.hpp"
+#include "../Format/cbor.hpp"
+#include "../Format/format.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+class ShellEnv;
+class ShellJobs;
+struct ShellJob;
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_REPLY_MAX = 256U;  // one reply line, tag and line end included
+constexpr std::string_view SHELL_JOB_MARK  = "&";  // last word of a line run in the background
+constexpr std::string_view SHELL_PIPE_MARK = "|";  // word between the stages of a pipeline
+constexpr uint32_t SHELL_PIPE_MAX          = 4U;   // stages of a pipeline
+constexpr std::string_view SHELL_TEXT_END  = ".";  // the line ending what collect() takes
+constexpr std::string_view SHELL_BATCH_MARK = ";"; // word between the commands of a batch
+constexpr uint32_t SHELL_BULK_MAX          = SHELL_FRAME_MAX; // one bulk message, lines or a frame
+
+
+
+
+/*-------- 3. engine ---------------------------------------------------------*/
+
+/**
+ * @brief what the body of a command is made of
+ */
+enum class ShellModeEnum
+{
+    TEXT,   // lines, for a person or a program
+    CBOR,   // records in frames, for a program
+};
+
+/**
+ * @brief where the replies go
+ */
+class ShellOutput
+{
+  public:
+    /**
+     * @brief one whole reply line, line end included, one whole frame, or
+     *        the echo of the line editor for the keys of one received chunk
+     */
+    virtual void write(const char *buf, uint32_t len) = 0;
+
+    /**
+     * @brief room for one message of the bulk channel beside the replies,
+     *        written in place, len at most SHELL_BULK_MAX
+     * @return nullptr when there is no bulk channel (a job, a stage) or
+     *         when the host stopped reading
+     */
+    virtual uint8_t *bulk_reserve(uint32_t len)
+    {
+        (void)len;
+        return nullptr;
+    }
+
+    /**
+     * @brief send the first len bytes written at the last bulk_reserve()
+     */
+    virtual void bulk_commit(uint32_t len)
+    {
+        (void)len;
+    }
+
+    /**
+     * @brief wait for the bulk bytes to leave: the next reply may not overtake them
+     */
+    virtual void bulk_drain()
+    {
+    }
+
+    virtual ~ShellOutput() = default;
+};
+
+/**
+ * @brief the request to stop a running command, set by another task
+ * @note  cooperative: a long command looks at ShellEngine::cancelled()
+ *        between its steps and returns
+ */
+class ShellCancel
+{
+  public:
+    void request()
+    {
+        _flag.store(true, std::memory_order_release);
+    }
+
+    void clear()
+    {
+        _flag.store(false, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool requested() const
+    {
+        return _flag.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::atomic<bool> _flag{false};
+};
+
+/**
+ * @brief where the lines go after collect()
+ */
+class ShellLineSink
+{
+  public:
+    /**
+     * @brief one line, without its line end, split in place if need be
+     */
+    virtual void line(char *text, uint32_t len) = 0;
+
+    /**
+     * @brief the "." line
+     * @param cut a line was longer than SHELL_LINE_MAX, the text misses its end
+     * @return the reply to the "." line: nullptr, or the reason of the failure
+     */
+    virtual const char *end(ShellEngine &sh, bool cut) = 0;
+
+    virtual ~ShellLineSink() = default;
+};
+
+/**
+ * @brief line assembly and dispatch of one shell session
+ * @note  the CborSpill is its own: the frames of machine mode
+ */
+class ShellEngine : private CborSpill
+{
+  public:
+    /**
+     * @brief counters, for the shell itself and the host benchmark
+     */
+    struct Stats
+    {
+        uint32_t commands;      // lines dispatched to a handler
+        uint32_t unknown;       // no such command
+        uint32_t failed;        // ended with an error, unknown and overlong included
+        uint32_t overlong;      // lines longer than SHELL_LINE_MAX, refused
+    };
+
+    ShellEngine(const ShellIndex &index, ShellOutput &out) : _index(index), _out(out), _cbor(nullptr, 0U, this)
+    {
+    }
+
+    /**
+     * @brief received bytes: every complete line is run, the rest is kept
+     */
+    void feed(const uint8_t *buf, uint32_t len);
+
+    /**
+     * @brief run one line, without its line end
+     * @param line split in place, len < SHELL_LINE_MAX
+     */
+    void execute(char *line, uint32_t len);
+
+    /**
+     * @brief call the handler of args.argv[0], without a reply end line
+     * @return what the handler returned, or "unknown command"
+     */
+    const char *dispatch(const ShellArgv &args);
+
+    /**
+     * @brief one body line of the running command, truncated to SHELL_REPLY_MAX:
+     *        sh.format(FMT("%u lines"), n), checked at compile time (format.hpp),
+     *        without the C library; in machine mode the arguments as typed values
+     */
+    template <typename F, typename... Args> void format(F fmt, const Args &...args)
+    {
+        if (_machine)
+        {
+            cbor_format(*record(), fmt, args...);
+            return;
+        }
+        const uint32_t p = prefix(SHELL_BODY_MARK);
+        FormatOut out(&_reply[p], SHELL_REPLY_MAX - p - 2U);
+        format_to(out, fmt, args...);
+        emit(p + out.len());
+    }
+
+    /**
+     * @brief one body line, as is
+     */
+    void line(std::string_view text);
+
+    /**
+     * @brief where the body items of the running command go in machine
+     *        mode, nullptr in text mode: a command with more to say than
+     *        lines (`dump`) writes them there itself
+     */
+    CborOut *cbor()
+    {
+        return _machine ? record() : nullptr;
+    }
+
+    /**
+     * @brief the next line written by the stage before, waiting for it
+     * @param buf SHELL_REPLY_MAX bytes
+     * @return false at the end of the input, when there is none, or once
+     *         the command is cancelled
+     */
+    bool read(char *buf, uint32_t &len);
+
+    /**
+     * @brief hand the next lines to sink, up to the "." line
+     * @return false in a job or a stage, which get no lines
+     */
+    bool collect(ShellLineSink *sink);
+
+    /**
+     * @brief what the running command's body lines start with: "!<tag>:"
+     *        for a program, nothing for a person
+     * @param buf 12 bytes
+     * @return bytes written
+     */
+    uint32_t body_mark(char *buf) const
+    {
+        return mark(buf, SHELL_BODY_MARK);
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] const ShellIndex &index_getter() const
+    {
+        return _index;
+    }
+
+    /**
+     * @brief where the replies go, for a command writing to the bulk channel
+     */
+    [[nodiscard]] ShellOutput &output_getter() const
+    {
+        return _out;
+    }
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    /**
+     * @brief the running command was asked to stop: a job, or a pipeline
+     */
+    [[nodiscard]] bool cancelled() const
+    {
+        return _cancel != nullptr and _cancel->requested();
+    }
+
+    void cancel_setter(ShellCancel *cancel)
+    {
+        _cancel = cancel;
+    }
+
+    /**
+     * @brief the stage read() takes its lines from, none: no input
+     */
+    void input_setter(ShellJobs *jobs, ShellJob *source)
+    {
+        _inJobs = jobs;
+        _in     = source;
+    }
+
+    /**
+     * @brief where "cmd &" goes, none: background jobs are refused
+     */
+    [[nodiscard]] ShellJobs *jobs_getter() const
+    {
+        return _jobs;
+    }
+
+    void jobs_setter(ShellJobs *jobs)
+    {
+        _jobs = jobs;
+    }
+
+    /**
+     * @brief the variables of "$name" words and `set`, none: taken as they are
+     */
+    [[nodiscard]] ShellEnv *env_getter() const
+    {
+        return _env;
+    }
+
+    void env_setter(ShellEnv *env)
+    {
+        _env = env;
+    }
+
+    [[nodiscard]] ShellModeEnum mode_getter() const
+    {
+        return _mode;
+    }
+
+    /**
+     * @brief text or machine mode, from the next line on
+     * @return false for machine mode without a frame buffer
+     */
+    bool mode_setter(ShellModeEnum mode)
+    {
+        if (mode == ShellModeEnum::CBOR and _frame == nullptr)
+        {
+            return false;
+        }
+        _mode = mode;
+        return true;
+    }
+
+    /**
+     * @brief SHELL_FRAME_MAX bytes for the frames of machine mode, none:
+     *        text mode only (a job, a stage)
+     */
+    void frame_setter(uint8_t *frame)
+    {
+        _frame = frame;
+    }
+
+    /**
+     * @brief lines go to a sink, empty ones included
+     */
+    [[nodiscard]] bool collecting_getter() const
+    {
+        return _sink != nullptr;
+    }
+
+    /**
+     * @brief the running command came from a program: no prompt, no colours
+     */
+    [[nodiscard]] bool tagged_getter() const
+    {
+        return _tagged;
+    }
+
+    /**
+     * @brief the tag of the running command, 0 for a person
+     */
+    [[nodiscard]] uint32_t tag_getter() const
+    {
+        return _tagged ? _tag : 0U;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    uint32_t mark(char *buf, char kind) const;
+    uint32_t prefix(char kind);
+    void emit(uint32_t len);
+    void begin();
+    const char *run(ShellArgv &args);
+    void batch(ShellArgv &args);
+    void end(const char *err);
+    void close(const char *err);
+    void finish(const char *err);
+    CborOut *record();
+    void spill(const uint8_t *buf, uint32_t len) override;
+    const char *spawn(ShellArgv &args, bool background);
+    void take(char *line, uint32_t len);
+
+    ShellIndex _index;
+    ShellOutput &_out;
+    ShellJobs *_jobs      = nullptr;
+    ShellEnv *_env        = nullptr;
+    ShellCancel *_cancel  = nullptr;
+    ShellJobs *_inJobs    = nullptr;
+    ShellJob *_in         = nullptr;
+    ShellLineSink *_sink  = nullptr;
+    bool _sinkCut         = false;
+    char _line[SHELL_LINE_MAX];
+    char _reply[SHELL_REPLY_MAX];
+    uint32_t _len  = 0;
+    bool _overflow = false;
+    bool _afterCr  = false;
+    bool _tagged   = false;
+    uint32_t _tag  = 0;
+    Stats _stats   = {};
+    ShellModeEnum _mode = ShellModeEnum::TEXT;
+    uint8_t *_frame     = nullptr;  // header, then the payload _cbor writes
+    CborOut _cbor;
+    bool _machine   = false;        // the running line is in machine mode
+    bool _recording = false;        // the record of the running command is open
+    uint32_t _step  = 0;            // index of the running command in its batch
+};
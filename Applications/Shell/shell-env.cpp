@@ -0,0 +1,171 @@
+/**
+ *******************************************************************************
+ * @file    shell-env.cpp
+ * @brief   the variables of a shell session: set, unset, "$name" words
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-env.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/20
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-env.hpp"
+#include "shell-args.hpp"
+#include <cstring>
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief letters, digits and '_', not a digit first
+ */
+static bool shell_env_name_ok(std::string_view name)
+{
+    if (name.empty() or (name[0] >= '0' and name[0] <= '9'))
+    {
+        return false;
+    }
+    for (const char c : name)
+    {
+        const bool ok = (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9') or c == '_';
+        if (not ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @note  value may be a view into the slot it replaces ("set a $a"): moved, not copied
+ */
+const char *ShellEnv::set(std::string_view name, std::string_view value)
+{
+    if (not shell_env_name_ok(name))
+    {
+        return "bad variable name";
+    }
+    if (name.size() > SHELL_ENV_NAME)
+    {
+        return "name too long";
+    }
+    if (value.size() > SHELL_ENV_VALUE)
+    {
+        return "value too long";
+    }
+
+    Var *slot = nullptr;
+    for (Var &v : _vars)
+    {
+        if (v.nameLen != 0U and std::string_view(v.name, v.nameLen) == name)
+        {
+            slot = &v;
+            break;
+        }
+        slot = slot == nullptr and v.nameLen == 0U ? &v : slot;
+    }
+    if (slot == nullptr)
+    {
+        return "no room for variables";
+    }
+    memmove(slot->value, value.data(), value.size());
+    slot->valueLen = static_cast<uint8_t>(value.size());
+    memcpy(slot->name, name.data(), name.size());
+    slot->nameLen = static_cast<uint8_t>(name.size());
+    return nullptr;
+}
+
+
+bool ShellEnv::remove(std::string_view name)
+{
+    for (Var &v : _vars)
+    {
+        if (v.nameLen != 0U and std::string_view(v.name, v.nameLen) == name)
+        {
+            v.nameLen = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void ShellEnv::list(ShellEngine &sh) const
+{
+    for (const Var &v : _vars)
+    {
+        if (v.nameLen != 0U)
+        {
+            sh.format(FMT("%s=%s"), std::string_view(v.name, v.nameLen), std::string_view(v.value, v.valueLen));
+        }
+    }
+}
+
+
+uint32_t ShellEnv::count_getter() const
+{
+    uint32_t n = 0;
+    for (const Var &v : _vars)
+    {
+        n += v.nameLen != 0U ? 1U : 0U;
+    }
+    return n;
+}
+
+
+const char *shell_set(ShellEngine &sh, std::optional<std::string_view> name, std::optional<std::string_view> value)
+{
+    ShellEnv *env = sh.env_getter();
+    if (env == nullptr)
+    {
+        return "no variables here";
+    }
+    if (not name)
+    {
+        env->list(sh);
+        return nullptr;
+    }
+    if (not value)
+    {
+        const std::optional<std::string_view> v = env->find(*name);
+        if (not v)
+        {
+            return "unknown variable";
+        }
+        sh.line(*v);
+        return nullptr;
+    }
+    return env->set(*name, *value);
+}
+
+
+const char *shell_unset(ShellEngine &sh, std::string_view name)
+{
+    ShellEnv *env = sh.env_getter();
+    if (env == nullptr)
+    {
+        return "no variables here";
+    }
+    return env->remove(name) ? nullptr : "unknown variable";
+}
+
+
+
+
+/* ------- registration ------------------------------------------------------*/
+
+SHELL_COMMAND(set, shell_set, "variables of this session, \"$name\" in a line");
+SHELL_COMMAND(unset, shell_unset, "remove a variable");
@@ -0,0 +1,152 @@
+/**
+ *******************************************************************************
+ * @file    shell-env.hpp
+ * @brief   the variables of a shell session: set, unset, "$name" words
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap: a fixed table of SHELL_ENV_VARS slots in the
+ * session (shell-session.hpp), touched by the session's task only. An
+ * engine without one takes "$name" as it is.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * A word that is "$" and a name is replaced by the value before the
+ * command runs, whole: a value holding spaces stays one word, the view
+ * points at the slot, nothing is copied. The words of "cmd &" and of a
+ * pipeline are replaced before they go to the jobs, which have no
+ * variables of their own; a compiled script does not see them.
+ *
+ *      set usart 40004800          md $usart 8
+ *      set                         "usart=40004800", one line per variable
+ *      unset usart
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/20
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-args.hpp"
+#include "shell-engine.hpp"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_ENV_VARS  = 8U;    // variables of a session
+constexpr uint32_t SHELL_ENV_NAME  = 12U;   // bytes of a name
+constexpr uint32_t SHELL_ENV_VALUE = 50U;   // bytes of a value
+constexpr char SHELL_ENV_MARK      = '$';
+
+
+
+
+/*-------- 3. variables ------------------------------------------------------*/
+
+/**
+ * @brief the variables of one session
+ */
+class ShellEnv
+{
+  public:
+    /**
+     * @brief add or change a variable
+     * @return nullptr, "bad variable name", "name too long", "value too
+     *         long" or "no room for variables"
+     */
+    const char *set(std::string_view name, std::string_view value);
+
+    /**
+     * @return false when there is no such variable
+     */
+    bool remove(std::string_view name);
+
+    /**
+     * @brief "name=value", one line per variable
+     */
+    void list(ShellEngine &sh) const;
+
+    [[nodiscard]] std::optional<std::string_view> find(std::string_view name) const
+    {
+        for (const Var &v : _vars)
+        {
+            if (v.nameLen != 0U and std::string_view(v.name, v.nameLen) == name)
+            {
+                return std::string_view(v.value, v.valueLen);
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief replace the "$name" words of args by their values
+     * @return nullptr, or "unknown variable"
+     */
+    const char *expand(ShellArgv &args) const
+    {
+        for (uint32_t i = 0; i < args.argc; i++)
+        {
+            const std::string_view w = args.argv[i];
+            if (w.size() < 2U or w[0] != SHELL_ENV_MARK)
+            {
+                continue;
+            }
+            const std::optional<std::string_view> value = find(w.substr(1));
+            if (not value)
+            {
+                return "unknown variable";
+            }
+            args.argv[i] = *value;
+        }
+        return nullptr;
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t count_getter() const;
+
+    /****************** setter & getter *******************/
+
+  private:
+    struct Var
+    {
+        uint8_t nameLen;        // 0: a free slot
+        uint8_t valueLen;
+        char name[SHELL_ENV_NAME];
+        char value[SHELL_ENV_VALUE];
+    };
+
+    Var _vars[SHELL_ENV_VARS] = {};
+};
+
+
+
+
+/*-------- 4. commands -------------------------------------------------------*/
+
+/**
+ * @brief "set" lists the variables, "set name" prints one, "set name value"
+ *        sets it
+ */
+const char *shell_set(ShellEngine &sh, std::optional<std::string_view> name, std::optional<std::string_view> value);
+
+/**
+ * @brief remove a variable
+ */
+const char *shell_unset(ShellEngine &sh, std::string_view name);
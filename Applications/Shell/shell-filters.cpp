@@ -0,0 +1,168 @@
+/**
+ *******************************************************************************
+ * @file    shell-filters.cpp
+ * @brief   the built-in pipeline stages of the shell: seq, grep, head, count, hexdump, crc
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-filters.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/15
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-filters.hpp"
+#include "shell-args.hpp"
+#include "../Update/fwu-proto.hpp"
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+const char *shell_seq(ShellEngine &sh, uint32_t count)
+{
+    for (uint32_t i = 1; i <= count and not sh.cancelled(); i++)
+    {
+        sh.format(FMT("%u"), i);
+    }
+    return nullptr;
+}
+
+
+const char *shell_grep(ShellEngine &sh, std::string_view text)
+{
+    char buf[SHELL_REPLY_MAX];
+    uint32_t len;
+    while (sh.read(buf, len))
+    {
+        if (std::string_view(buf, len).find(text) != std::string_view::npos)
+        {
+            sh.line(std::string_view(buf, len));
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @note  returning is enough to stop the stage before: the engine lets its
+ *        input go, which cancels it
+ */
+const char *shell_head(ShellEngine &sh, std::optional<uint32_t> lines)
+{
+    char buf[SHELL_REPLY_MAX];
+    uint32_t len;
+    for (uint32_t n = lines.value_or(SHELL_HEAD_LINES); n != 0U and sh.read(buf, len); n--)
+    {
+        sh.line(std::string_view(buf, len));
+    }
+    return nullptr;
+}
+
+
+const char *shell_count(ShellEngine &sh)
+{
+    char buf[SHELL_REPLY_MAX];
+    uint32_t len;
+    uint32_t lines = 0;
+    uint32_t bytes = 0;
+    while (sh.read(buf, len))
+    {
+        lines++;
+        bytes += len;
+    }
+    sh.format(FMT("%u lines %u bytes"), lines, bytes);
+    return nullptr;
+}
+
+
+/**
+ * @brief "00000010  31 0a 32 ...  |1.2.|", the last row short
+ */
+static void hex_row(ShellEngine &sh, uint32_t offset, const uint8_t *row, uint32_t n)
+{
+    static const char digits[] = "0123456789abcdef";
+    char text[10 + SHELL_HEX_ROW * 3U + 2U + SHELL_HEX_ROW + 1U];
+    FormatOut head(text, 10U);
+    format_to(head, FMT("%08x  "), offset);
+    uint32_t p = head.len();
+    for (uint32_t i = 0; i < SHELL_HEX_ROW; i++)
+    {
+        text[p++] = i < n ? digits[row[i] >> 4] : ' ';
+        text[p++] = i < n ? digits[row[i] & 0xFU] : ' ';
+        text[p++] = ' ';
+    }
+    text[p++] = ' ';
+    text[p++] = '|';
+    for (uint32_t i = 0; i < n; i++)
+    {
+        text[p++] = row[i] >= 0x20U and row[i] < 0x7FU ? static_cast<char>(row[i]) : '.';
+    }
+    text[p++] = '|';
+    sh.line(std::string_view(text, p));
+}
+
+
+const char *shell_hexdump(ShellEngine &sh)
+{
+    char buf[SHELL_REPLY_MAX];
+    uint32_t len;
+    uint8_t row[SHELL_HEX_ROW];
+    uint32_t fill   = 0;
+    uint32_t offset = 0;
+    while (sh.read(buf, len))
+    {
+        for (uint32_t i = 0; i < len; i++)
+        {
+            row[fill++] = static_cast<uint8_t>(buf[i]);
+            if (fill == SHELL_HEX_ROW)
+            {
+                hex_row(sh, offset, row, fill);
+                offset += fill;
+                fill = 0;
+            }
+        }
+    }
+    if (fill != 0U)
+    {
+        hex_row(sh, offset, row, fill);
+    }
+    return nullptr;
+}
+
+
+const char *shell_crc(ShellEngine &sh)
+{
+    char buf[SHELL_REPLY_MAX];
+    uint32_t len;
+    uint32_t crc   = 0;
+    uint32_t bytes = 0;
+    while (sh.read(buf, len))
+    {
+        crc = fwu_crc32(crc, buf, len);
+        bytes += len;
+    }
+    sh.format(FMT("crc32 %08x %u bytes"), crc, bytes);
+    return nullptr;
+}
+
+
+
+
+/* ------- registration ------------------------------------------------------*/
+
+SHELL_COMMAND(seq, shell_seq, "the numbers 1 to n");
+SHELL_COMMAND(grep, shell_grep, "input lines containing a text, \"a | grep x\"");
+SHELL_COMMAND(head, shell_head, "first input lines");
+SHELL_COMMAND(count, shell_count, "input lines and bytes");
+SHELL_COMMAND(hexdump, shell_hexdump, "input bytes in hexadecimal");
+SHELL_COMMAND(crc, shell_crc, "CRC-32 of the input bytes");
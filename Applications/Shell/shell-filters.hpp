@@ -0,0 +1,88 @@
+/**
+ *******************************************************************************
+ * @file    shell-filters.hpp
+ * @brief   the built-in pipeline stages of the shell: seq, grep, head, count, hexdump, crc
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS: the stages only use the engine, they are in the command
+ * table of the board (shell-cmds.cpp) and of the host benchmark alike.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * A stage reads the lines of the stage before with sh.read() and writes
+ * its own with sh.format() or sh.line(); it holds one line at a time, the
+ * pipes between the stages hold the rest (shell-jobs.hpp):
+ *
+ *      seq 100000 | grep 7 | count         "40951 lines 201025 bytes"
+ *      echo 123456789 | crc                "crc32 cbf43926 9 bytes"
+ *
+ * hexdump and crc see the lines as one byte stream, without their line
+ * ends: a stage writing raw bytes in lines passes them through unchanged.
+ * The CRC is the one of the update protocol (fwu-proto.hpp), zlib's crc32().
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/15
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-engine.hpp"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_HEAD_LINES = 10U;  // `head` without a count
+constexpr uint32_t SHELL_HEX_ROW    = 16U;  // bytes per `hexdump` line
+
+
+
+
+/*-------- 3. stages ---------------------------------------------------------*/
+
+/**
+ * @brief the numbers 1 to count, one per line
+ */
+const char *shell_seq(ShellEngine &sh, uint32_t count);
+
+/**
+ * @brief the lines containing text
+ */
+const char *shell_grep(ShellEngine &sh, std::string_view text);
+
+/**
+ * @brief the first lines, SHELL_HEAD_LINES when left out; the stage before
+ *        is stopped after them
+ */
+const char *shell_head(ShellEngine &sh, std::optional<uint32_t> lines);
+
+/**
+ * @brief lines and bytes of the input
+ */
+const char *shell_count(ShellEngine &sh);
+
+/**
+ * @brief the input bytes in hexadecimal and ASCII, SHELL_HEX_ROW per line
+ */
+const char *shell_hexdump(ShellEngine &sh);
+
+/**
+ * @brief CRC-32 of the input bytes
+ */
+const char *shell_crc(ShellEngine &sh);
@@ -0,0 +1,84 @@
+/**
+ *******************************************************************************
+ * @file    shell-intf.h
+ * @brief   the interface of the command shell on the shell CDC port
+ *******************************************************************************
+ * @attention
+ *
+ * The shell runs one session per link (shell-session.hpp), each on a task
+ * of its own. The session of the shell CDC port (CDC_PORT_SHELL) owns its
+ * receive side and answers through the interactive class of the transmit
+ * scheduler, so replies overtake the log lines that share the port.
+ *
+ *******************************************************************************
+ * @note
+ *
+ *   CDC OUT --> fast path filter --> port ring --> shell task --> ShellEditor --> ShellEngine
+ *                                                                     |               |
+ *   CDC IN  <-- txq (interactive) <------------ echo, reply lines <---+---------------+
+ *
+ * The session (shell-session.hpp) with its line editor (shell-editor.hpp),
+ * engine (shell-engine.hpp), variables (shell-env.hpp) and background jobs
+ * (shell-jobs.hpp), and the table (shell-table.hpp) are portable; "cmd &"
+ * runs on worker tasks created with the session task;
+ * the commands of the board are in shell-cmds.cpp, the others next to
+ * their handlers, the protocol for programs in shell-proto.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/11
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define SHELL_VERSION       "1.0"
+#define SHELL_IDLE_MS       2000U   // a reply waits this long for room, then is dropped
+
+
+
+
+/*-------- 3. function prototypes --------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief create the tasks of the shell sessions, call once before the
+ *        scheduler starts
+ */
+void shell_init(void);
+
+#ifdef __cplusplus
+}
+
+#include "shell-table.hpp"
+
+/**
+ * @brief the commands of all the modules, registered with SHELL_COMMAND(), shell-cmds.cpp
+ */
+const ShellIndex &shell_builtin_index();
+
+class ShellMemory;
+
+/**
+ * @brief the address space of md, mw and dump, shell-cmds.cpp
+ */
+ShellMemory &shell_board_memory();
+#endif
@@ -0,0 +1,517 @@
+/**
+ *******************************************************************************
+ * @file    shell-jobs.cpp
+ * @brief   background jobs of the shell: a fixed job table served by worker tasks
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-jobs.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/14
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-jobs.hpp"
+#include <cstring>
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+bool ShellJobRing::push(const char *buf, uint32_t len)
+{
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+    const uint32_t tail = _tail.load(std::memory_order_acquire);
+    if (SHELL_JOB_OUT - (head - tail) < len + 1U)
+    {
+        return false;
+    }
+    _buf[head & MASK]     = static_cast<char>(len);
+    const uint32_t at     = (head + 1U) & MASK;
+    const uint32_t first  = len < SHELL_JOB_OUT - at ? len : SHELL_JOB_OUT - at;
+    memcpy(&_buf[at], buf, first);
+    memcpy(_buf, buf + first, len - first);
+    _head.store(head + 1U + len, std::memory_order_release);
+    return true;
+}
+
+
+bool ShellJobRing::pop(char *buf, uint32_t &len)
+{
+    const uint32_t tail = _tail.load(std::memory_order_relaxed);
+    const uint32_t head = _head.load(std::memory_order_acquire);
+    if (head == tail)
+    {
+        return false;
+    }
+    len                   = static_cast<uint8_t>(_buf[tail & MASK]);
+    const uint32_t at     = (tail + 1U) & MASK;
+    const uint32_t first  = len < SHELL_JOB_OUT - at ? len : SHELL_JOB_OUT - at;
+    memcpy(buf, &_buf[at], first);
+    memcpy(buf + first, _buf, len - first);
+    _tail.store(tail + 1U + len, std::memory_order_release);
+    return true;
+}
+
+
+/**
+ * @brief copy the words one after the other, each with its '\0'
+ */
+ShellJob *ShellJobs::submit(const std::string_view *argv, uint32_t argc, ShellJob *source, bool piped)
+{
+    uint32_t slot = 0;
+    while (slot < SHELL_JOB_MAX and _jobs[slot].state.load(std::memory_order_acquire) != ShellJobStateEnum::FREE)
+    {
+        slot++;
+    }
+    if (slot == SHELL_JOB_MAX or argc > SHELL_ARGC_MAX)
+    {
+        _stats.refused++;
+        return nullptr;
+    }
+
+    ShellJob &job = _jobs[slot];
+    uint32_t n    = 0;
+    for (uint32_t i = 0; i < argc; i++)
+    {
+        if (n + argv[i].size() + 1U > sizeof(job.text))
+        {
+            _stats.refused++;
+            return nullptr; // not from a line of the engine
+        }
+        memcpy(&job.text[n], argv[i].data(), argv[i].size());
+        job.args.argv[i] = std::string_view(&job.text[n], argv[i].size());
+        n += static_cast<uint32_t>(argv[i].size());
+        job.text[n++] = '\0';
+    }
+    job.args.argc = argc;
+    job.cancel.clear();
+    job.out.reset();
+    job.result = nullptr;
+    job.source = source;
+    job.piped  = piped;
+    job.owners.store(2U, std::memory_order_relaxed);
+    job.held.store(true, std::memory_order_relaxed);
+    job.seq.store(++_seq, std::memory_order_relaxed);
+    job.state.store(ShellJobStateEnum::QUEUED, std::memory_order_release);
+
+    _stats.submitted++;
+    _port.post();
+    return &job;
+}
+
+
+/**
+ * @brief "[1] running   120 B  scrub 0 100", then the counters
+ * @note  a stage feeding a pipe ends with " |", its reader removes it
+ */
+void ShellJobs::list(ShellEngine &sh)
+{
+    for (ShellJob &job : _jobs)
+    {
+        const ShellJobStateEnum state = job.state.load(std::memory_order_acquire);
+        if (state == ShellJobStateEnum::FREE or not job.held.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        char words[SHELL_LINE_MAX];
+        uint32_t n = 0;
+        for (uint32_t w = 0; w < job.args.argc; w++)
+        {
+            memcpy(&words[n], job.args.argv[w].data(), job.args.argv[w].size());
+            n += static_cast<uint32_t>(job.args.argv[w].size());
+            words[n] = ' ';
+            n += w + 1U < job.args.argc ? 1U : 0U;
+        }
+
+        const char *status = state == ShellJobStateEnum::QUEUED ? "queued"
+                             : state == ShellJobStateEnum::DONE ? "done"
+                             : job.cancel.requested()           ? "stopping"
+                                                                : "running";
+        const bool ended    = state == ShellJobStateEnum::DONE;
+        const uint32_t used = job.out.used_getter();
+        const char *result  = not ended ? "" : job.result != nullptr ? job.result : "ok";
+        sh.format(FMT("[%u] %-8s %5u B  %s%s%s%s"), number_getter(job), status, used, std::string_view(words, n),
+                  job.piped ? " |" : "", ended ? " -> " : "", result);
+        if (ended and used == 0U and not job.piped)
+        {
+            let_go(job);
+        }
+    }
+    sh.format(FMT("%u submitted, %u refused, %u killed, %u output stalls"), _stats.submitted, _stats.refused,
+              _stats.killed, stalls_getter());
+}
+
+
+/**
+ * @note  a queued job is ended here, no worker sees it; a running one is
+ *        asked, it ends when its command looks
+ */
+const char *ShellJobs::kill(uint32_t job)
+{
+    ShellJob *j = find(job);
+    if (j == nullptr)
+    {
+        return "no such job";
+    }
+
+    ShellJobStateEnum state = ShellJobStateEnum::QUEUED;
+    if (j->state.compare_exchange_strong(state, ShellJobStateEnum::RUNNING, std::memory_order_acq_rel))
+    {
+        j->cancel.request();
+        _stats.killed++;
+        end(*j, "killed"); // taken like a worker would
+    }
+    else if (state == ShellJobStateEnum::RUNNING)
+    {
+        if (not j->cancel.requested())
+        {
+            j->cancel.request();
+            _stats.killed++;
+        }
+        wake(j->writer);
+        if (j->source != nullptr)
+        {
+            wake(j->source->reader);
+        }
+    }
+    else if (not j->piped)
+    {
+        let_go(*j);
+    }
+    return nullptr;
+}
+
+
+/**
+ * @note  the state is read before the output is emptied: a job seen ended
+ *        wrote its last line already
+ */
+const char *ShellJobs::foreground(ShellEngine &sh, uint32_t job)
+{
+    ShellJob *j = find(job);
+    if (j == nullptr)
+    {
+        return "no such job";
+    }
+    if (j->piped)
+    {
+        return "job feeds a pipe";
+    }
+
+    bool asked = false;
+    for (;;)
+    {
+        const bool ended = j->state.load(std::memory_order_acquire) == ShellJobStateEnum::DONE;
+        char line[SHELL_REPLY_MAX];
+        uint32_t len = 0;
+        while (pop(*j, line, len))
+        {
+            sh.line(std::string_view(line, len));
+        }
+        if (ended)
+        {
+            break;
+        }
+        if (await_line(*j))
+        {
+            if (asked)
+            {
+                return "left in the background";
+            }
+            asked = true;
+            (void)kill(number_getter(*j));
+        }
+    }
+
+    const char *result = j->result;
+    let_go(*j);
+    return result;
+}
+
+
+bool ShellJobs::read(ShellJob &source, ShellCancel *cancel, char *buf, uint32_t &len)
+{
+    for (;;)
+    {
+        if (cancel != nullptr and cancel->requested())
+        {
+            return false;
+        }
+        const bool ended = source.state.load(std::memory_order_acquire) == ShellJobStateEnum::DONE;
+        if (pop(source, buf, len))
+        {
+            return true;
+        }
+        if (ended)
+        {
+            return false;
+        }
+        if (await_line(source) and cancel != nullptr)
+        {
+            cancel->request();
+        }
+    }
+}
+
+
+/**
+ * @note  a stage that ended is only let go; one still writing is cancelled:
+ *        its lines are dropped, it ends at its next look
+ */
+void ShellJobs::detach(ShellJob &source)
+{
+    source.cancel.request();
+    wake(source.writer);
+    let_go(source);
+}
+
+
+/**
+ * @note  workers compete for the oldest queued job, the compare and swap decides
+ */
+ShellJob *ShellJobs::take()
+{
+    for (;;)
+    {
+        ShellJob *oldest = nullptr;
+        uint32_t first   = 0;
+        for (ShellJob &job : _jobs)
+        {
+            if (job.state.load(std::memory_order_acquire) != ShellJobStateEnum::QUEUED)
+            {
+                continue;
+            }
+            const uint32_t seq = job.seq.load(std::memory_order_relaxed);
+            if (oldest == nullptr or seq - first > 0x80000000U)
+            {
+                oldest = &job;
+                first  = seq;
+            }
+        }
+        if (oldest == nullptr)
+        {
+            return nullptr;
+        }
+        ShellJobStateEnum state = ShellJobStateEnum::QUEUED;
+        if (oldest->state.compare_exchange_strong(state, ShellJobStateEnum::RUNNING, std::memory_order_acq_rel))
+        {
+            return oldest;
+        }
+    }
+}
+
+
+/**
+ * @note  the source is read before DONE, after which a reader may free the
+ *        job; then the stage before is let go
+ */
+void ShellJobs::end(ShellJob &job, const char *result)
+{
+    ShellJob *source = job.source;
+    job.result       = job.cancel.requested() ? "killed" : result;
+    job.state.store(ShellJobStateEnum::DONE, std::memory_order_release);
+    wake(job.reader);
+    if (source != nullptr)
+    {
+        detach(*source);
+    }
+    release(job);
+}
+
+
+void ShellJobs::write(ShellJob &job, const char *buf, uint32_t len)
+{
+    bool stalled = false;
+    while (not job.out.push(buf, len))
+    {
+        if (job.cancel.requested())
+        {
+            return;
+        }
+        if (not stalled)
+        {
+            stalled = true;
+            _stalls.fetch_add(1U, std::memory_order_relaxed);
+        }
+        // registered first, then looked at again: a line read in between wakes us
+        job.writer.store(_port.self(), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (job.out.free_getter() < len + 1U and not job.cancel.requested())
+        {
+            (void)_port.wait(SHELL_JOB_POLL_MS);
+        }
+        job.writer.store(nullptr, std::memory_order_relaxed);
+    }
+    wake(job.reader);
+}
+
+
+uint32_t ShellJobs::free_getter() const
+{
+    uint32_t n = 0;
+    for (const ShellJob &job : _jobs)
+    {
+        n += job.state.load(std::memory_order_acquire) == ShellJobStateEnum::FREE ? 1U : 0U;
+    }
+    return n;
+}
+
+
+uint32_t ShellJobs::idle_getter() const
+{
+    uint32_t busy = 0;
+    for (const ShellJob &job : _jobs)
+    {
+        // a cancelled job is about to let its worker go
+        const ShellJobStateEnum state = job.state.load(std::memory_order_acquire);
+        busy += (state == ShellJobStateEnum::QUEUED or state == ShellJobStateEnum::RUNNING) and
+                        not job.cancel.requested()
+                    ? 1U
+                    : 0U;
+    }
+    return busy < _workers ? _workers - busy : 0U;
+}
+
+
+/**
+ * @brief a job by its number, 0 for the newest
+ */
+ShellJob *ShellJobs::find(uint32_t job)
+{
+    if (job != 0U)
+    {
+        if (job > SHELL_JOB_MAX or not _jobs[job - 1U].held.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &_jobs[job - 1U];
+    }
+
+    ShellJob *newest = nullptr;
+    for (ShellJob &j : _jobs)
+    {
+        if (j.held.load(std::memory_order_acquire) and not j.piped and
+            (newest == nullptr or j.seq.load(std::memory_order_relaxed) - newest->seq.load(std::memory_order_relaxed) <
+                                      0x80000000U))
+        {
+            newest = &j;
+        }
+    }
+    return newest;
+}
+
+
+/**
+ * @brief the reader's share, given back once whoever reads it: `fg`, `jobs`,
+ *        `kill`, the next stage
+ */
+void ShellJobs::let_go(ShellJob &job)
+{
+    if (job.held.exchange(false, std::memory_order_acq_rel))
+    {
+        release(job);
+    }
+}
+
+
+/**
+ * @brief one owner lets go, the last frees the job
+ */
+void ShellJobs::release(ShellJob &job)
+{
+    if (job.owners.fetch_sub(1U, std::memory_order_acq_rel) == 1U)
+    {
+        job.state.store(ShellJobStateEnum::FREE, std::memory_order_release);
+    }
+}
+
+
+/**
+ * @brief take a line and wake the writer waiting for room
+ */
+bool ShellJobs::pop(ShellJob &job, char *buf, uint32_t &len)
+{
+    if (not job.out.pop(buf, len))
+    {
+        return false;
+    }
+    wake(job.writer);
+    return true;
+}
+
+
+/**
+ * @brief sleep until the job writes or ends
+ * @return true when the person interrupted
+ */
+bool ShellJobs::await_line(ShellJob &job)
+{
+    job.reader.store(_port.self(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool intr = false;
+    if (job.out.used_getter() == 0U and job.state.load(std::memory_order_acquire) != ShellJobStateEnum::DONE)
+    {
+        intr = _port.wait(SHELL_JOB_POLL_MS);
+    }
+    job.reader.store(nullptr, std::memory_order_relaxed);
+    return intr;
+}
+
+
+/**
+ * @note  the fence pairs with the one of the waiter: either it sees the
+ *        change, or this sees it registered
+ */
+void ShellJobs::wake(std::atomic<void *> &waiter)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    void *task = waiter.load(std::memory_order_relaxed);
+    if (task != nullptr)
+    {
+        _port.wake(task);
+    }
+}
+
+
+uint32_t ShellWorker::run()
+{
+    uint32_t n = 0;
+    while ((_job = _jobs.take()) != nullptr)
+    {
+        ShellJob &job = *_job;
+        _engine.cancel_setter(&job.cancel);
+        _engine.input_setter(job.source != nullptr ? &_jobs : nullptr, job.source);
+        const char *result = _engine.dispatch(job.args);
+        _engine.input_setter(nullptr, nullptr);
+        _engine.cancel_setter(nullptr);
+        _job = nullptr;
+        _jobs.end(job, result);
+        n++;
+    }
+    return n;
+}
+
+
+/**
+ * @brief a line of the job, kept without its line end
+ */
+void ShellWorker::write(const char *buf, uint32_t len)
+{
+    len -= len >= 2U and buf[len - 2U] == '\r' and buf[len - 1U] == '\n' ? 2U : 0U;
+    if (_job == nullptr or len > 0xFFU)
+    {
+        return;
+    }
+    _jobs.write(*_job, buf, len);
+}
@@ -0,0 +1,359 @@
+/**
+ *******************************************************************************
+ * @file    shell-jobs.hpp
+ * @brief   background jobs and pipelines of the shell: a fixed job table served by worker tasks
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap, like the engine: the job table, the output
+ * buffers and the cancellation are plain memory and atomics, the tasks are
+ * behind ShellJobPort. shell-cdc.cpp gives it statically allocated FreeRTOS
+ * workers, Tools/shell-host/shell-jobs-bench.cpp gives it threads.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * "cmd &" copies the words of the line into a free job and wakes a worker,
+ * the shell is ready for the next line at once:
+ *
+ *      shell task                         worker task
+ *      "scrub &" -> submit() -> [1]       take() -> RUNNING
+ *      jobs, kill 1, fg 1                 ShellEngine of the worker
+ *          ^                                  | sh.format()
+ *          +---- lines <---- job output <-----+ (waits while full)
+ *
+ * A job writes into its own bounded buffer, one whole line at a time; a
+ * full buffer stops the job until its reader takes a line, nothing is lost.
+ * `kill` sets the job's ShellCancel, the command sees sh.cancelled() and
+ * returns; a job still queued never runs.
+ *
+ *      FREE --submit--> QUEUED --take--> RUNNING --end--> DONE --read--> FREE
+ *                          +----------kill--------------> DONE
+ *
+ * "a | b | c" runs a and b as jobs and c in the shell task: the reader of a
+ * job's output is then the next stage, whose sh.read() takes the lines the
+ * stage before wrote. Each pipe holds SHELL_JOB_OUT bytes whatever flows
+ * through it; a stage ending early ("head") cancels the one feeding it.
+ *
+ *      seq 100000 --[out of job 1]--> grep 7 --[out of job 2]--> count --> reply
+ *
+ * A job has two owners, the task running it and its reader (`fg`, `jobs`,
+ * `kill`, or the next stage); each lets go once, the last one frees it. A task
+ * waiting for a line or for room registers in the job and sleeps until
+ * woken, or SHELL_JOB_POLL_MS.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/14
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-args.hpp"
+#include "shell-engine.hpp"
+#include <atomic>
+#include <cstdint>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_JOB_MAX     = 6U;      // jobs in the table, numbered 1 to SHELL_JOB_MAX
+constexpr uint32_t SHELL_JOB_OUT     = 1024U;   // output bytes kept per job, a power of two
+constexpr uint32_t SHELL_JOB_POLL_MS = 20U;     // a waiting task looks again at least this often
+
+static_assert(SHELL_PIPE_MAX <= SHELL_JOB_MAX, "a pipeline fits the table");
+
+enum class ShellJobStateEnum : uint32_t
+{
+    FREE,
+    QUEUED,
+    RUNNING,
+    DONE,
+};
+
+/**
+ * @brief what the job table needs from the tasks around it
+ */
+class ShellJobPort
+{
+  public:
+    /**
+     * @brief a job was queued: wake a worker
+     */
+    virtual void post() = 0;
+
+    /**
+     * @brief the running task, for wake()
+     */
+    virtual void *self() = 0;
+
+    /**
+     * @brief end the wait() of a task, or its next one
+     */
+    virtual void wake(void *task) = 0;
+
+    /**
+     * @brief sleep until wake(), at most ms
+     * @return true when the person interrupted the shell task (^C)
+     */
+    virtual bool wait(uint32_t ms) = 0;
+
+    virtual ~ShellJobPort() = default;
+};
+
+
+
+
+/*-------- 3. job output -----------------------------------------------------*/
+
+/**
+ * @brief the lines of one job: the worker writes, the reader reads
+ * @note  single producer, single consumer; a line is its length byte and
+ *        its bytes, without the line end, and is written whole or not at all
+ */
+class ShellJobRing
+{
+  public:
+    static_assert((SHELL_JOB_OUT & (SHELL_JOB_OUT - 1U)) == 0U, "a power of two");
+    static_assert(SHELL_REPLY_MAX - 2U <= 0xFFU and SHELL_REPLY_MAX < SHELL_JOB_OUT, "a line fits");
+
+    /**
+     * @brief store one line, false when there is no room for all of it
+     */
+    bool push(const char *buf, uint32_t len);
+
+    /**
+     * @brief take the oldest line, SHELL_REPLY_MAX bytes at most
+     */
+    bool pop(char *buf, uint32_t &len);
+
+    /**
+     * @brief empty it, only while no worker writes
+     */
+    void reset()
+    {
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t used_getter() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] uint32_t free_getter() const
+    {
+        return SHELL_JOB_OUT - used_getter();
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    static constexpr uint32_t MASK = SHELL_JOB_OUT - 1U;
+
+    char _buf[SHELL_JOB_OUT];
+    std::atomic<uint32_t> _head{0};     // free running, worker
+    std::atomic<uint32_t> _tail{0};     // free running, reader
+};
+
+/**
+ * @brief one entry of the job table
+ */
+struct ShellJob
+{
+    std::atomic<ShellJobStateEnum> state{ShellJobStateEnum::FREE};
+    std::atomic<uint32_t> owners{0};        // the running side and the reader, freed at 0
+    std::atomic<bool> held{false};          // the reader's share not given back yet
+    std::atomic<uint32_t> seq{0};           // order of submission, workers take the oldest
+    std::atomic<void *> reader{nullptr};    // a task waiting for a line of out
+    std::atomic<void *> writer{nullptr};    // a task waiting for room in out
+    ShellCancel cancel;
+    const char *result = nullptr;           // the handler's answer, read once DONE
+    ShellJob *source   = nullptr;           // the stage before, read by sh.read()
+    bool piped         = false;             // read by the next stage, not by `fg`
+    char text[SHELL_LINE_MAX];              // the words, each '\0' terminated
+    ShellArgv args;                         // views into text
+    ShellJobRing out;
+};
+
+
+
+
+/*-------- 4. job table ------------------------------------------------------*/
+
+/**
+ * @brief the jobs of a shell, no more than SHELL_JOB_MAX at a time
+ */
+class ShellJobs
+{
+  public:
+    /**
+     * @brief counters, for `jobs` and the host benchmark
+     */
+    struct Stats
+    {
+        uint32_t submitted;
+        uint32_t refused;       // the table was full
+        uint32_t killed;
+    };
+
+    /**
+     * @param workers tasks running jobs, the longest pipeline has one more stage
+     */
+    ShellJobs(ShellJobPort &port, uint32_t workers) : _port(port), _workers(workers)
+    {
+    }
+
+    /* ---- shell task ---- */
+
+    /**
+     * @brief copy words into a job and queue it
+     * @param source the stage before, whose output the job reads
+     * @param piped  read by the stage after, not by `fg`
+     * @return nullptr when the table is full
+     */
+    ShellJob *submit(const std::string_view *argv, uint32_t argc, ShellJob *source, bool piped);
+
+    /**
+     * @brief one line per job; ended jobs with nothing left to read are removed
+     */
+    void list(ShellEngine &sh);
+
+    /**
+     * @brief ask a job to stop; an ended job is removed with its output
+     */
+    const char *kill(uint32_t job);
+
+    /**
+     * @brief pass the job's lines to sh until it ends, then remove it
+     * @param job 0: the newest
+     * @return what the job's command returned; ^C asks the job to stop, a
+     *         second ^C leaves it running in the background
+     */
+    const char *foreground(ShellEngine &sh, uint32_t job);
+
+    /* ---- any task ---- */
+
+    /**
+     * @brief the next line of a stage's output, waiting for it
+     * @return false once the stage ended and everything was read, or when
+     *         cancel is requested; ^C in the shell task requests it
+     */
+    bool read(ShellJob &source, ShellCancel *cancel, char *buf, uint32_t &len);
+
+    /**
+     * @brief the reader of a stage is done: stop the stage, let it go
+     */
+    void detach(ShellJob &source);
+
+    /* ---- worker tasks ---- */
+
+    /**
+     * @brief the oldest queued job, now RUNNING, or nullptr
+     */
+    ShellJob *take();
+
+    /**
+     * @brief the end of a job taken by a worker (or by `kill`); the job is
+     *        not touched after
+     */
+    void end(ShellJob &job, const char *result);
+
+    /**
+     * @brief a line of the running job, waiting for room
+     * @note  the lines of a cancelled job are dropped instead of waiting
+     */
+    void write(ShellJob &job, const char *buf, uint32_t len);
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t number_getter(const ShellJob &job) const
+    {
+        return static_cast<uint32_t>(&job - _jobs) + 1U;
+    }
+
+    /**
+     * @brief jobs that can be submitted now
+     */
+    [[nodiscard]] uint32_t free_getter() const;
+
+    /**
+     * @brief workers not held by a queued or running job, one being
+     *        cancelled counting as idle
+     */
+    [[nodiscard]] uint32_t idle_getter() const;
+
+    [[nodiscard]] uint32_t workers_getter() const
+    {
+        return _workers;
+    }
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    /**
+     * @brief times a worker found its job's output full
+     */
+    [[nodiscard]] uint32_t stalls_getter() const
+    {
+        return _stalls.load(std::memory_order_relaxed);
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    ShellJob *find(uint32_t job);
+    void let_go(ShellJob &job);
+    void release(ShellJob &job);
+    bool pop(ShellJob &job, char *buf, uint32_t &len);
+    bool await_line(ShellJob &job);
+    void wake(std::atomic<void *> &waiter);
+
+    ShellJobPort &_port;
+    const uint32_t _workers;
+    ShellJob _jobs[SHELL_JOB_MAX];
+    uint32_t _seq = 0;
+    Stats _stats  = {};
+    std::atomic<uint32_t> _stalls{0};
+};
+
+/**
+ * @brief one worker: runs the queued jobs on its own engine
+ * @note  the engine's output is the output of the job being run, its input
+ *        the output of the job's source
+ */
+class ShellWorker : public ShellOutput
+{
+  public:
+    ShellWorker(ShellJobs &jobs, const ShellIndex &index) : _jobs(jobs), _engine(index, *this)
+    {
+    }
+
+    /**
+     * @brief run jobs until none is queued
+     * @return jobs run
+     */
+    uint32_t run();
+
+    void write(const char *buf, uint32_t len) override;
+
+  private:
+    ShellJobs &_jobs;
+    ShellEngine _engine;
+    ShellJob *_job = nullptr;
+};
@@ -0,0 +1,332 @@
+/**
+ *******************************************************************************
+ * @file    shell-memory.cpp
+ * @brief   the memory commands of the shell: md, mw, dump
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-memory.hpp.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * A bulk message is sized before it is reserved: the text of a line is
+ * 10 + 2 * n characters in hexadecimal ("aaaaaaaa: " and the digits),
+ * encode_base64_len(n) in base64, plus the body mark and the line end.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/19
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-memory.hpp"
+#include "shell-args.hpp"
+#include "../Format/encode.hpp"
+#include "../Update/fwu-proto.hpp"
+#include <cstring>
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define SHELL_MARK_MAX      12U     // "!<tag>:", ShellEngine::body_mark()
+#define SHELL_HEX_HEAD      10U     // "aaaaaaaa: "
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static ShellMemory *s_memory = nullptr;
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+void shell_memory_bind(ShellMemory *mem)
+{
+    s_memory = mem;
+}
+
+
+/**
+ * @brief the words are in range and the first is aligned
+ */
+static const char *shell_words_check(uint32_t addr, uint32_t words)
+{
+    if (s_memory == nullptr)
+    {
+        return "no memory access";
+    }
+    if ((addr & 3U) != 0U)
+    {
+        return "address not word aligned";
+    }
+    if (words != 0U and words - 1U > (UINT32_MAX - addr) / 4U)
+    {
+        return "past the end of the address space";
+    }
+    return nullptr;
+}
+
+
+const char *shell_md(ShellEngine &sh, ShellHex addr, std::optional<uint32_t> words)
+{
+    const uint32_t n      = words.value_or(SHELL_MD_WORDS);
+    const char *const err = shell_words_check(addr.value, n);
+    if (err != nullptr)
+    {
+        return err;
+    }
+
+    bool fault = false;
+    for (uint32_t i = 0; i < n and not sh.cancelled(); i += SHELL_MD_ROW)
+    {
+        const uint32_t row  = addr.value + i * 4U;
+        const uint32_t cols = n - i < SHELL_MD_ROW ? n - i : SHELL_MD_ROW;
+        char text[SHELL_HEX_HEAD + SHELL_MD_ROW * 9U + 2U + SHELL_MD_ROW * 4U + 1U];
+        char ascii[SHELL_MD_ROW * 4U];
+
+        encode_hex_word(text, row);
+        uint32_t p = 8;
+        text[p++]  = ':';
+        for (uint32_t c = 0; c < cols; c++)
+        {
+            uint32_t word = 0;
+            text[p++]     = ' ';
+            if (s_memory->read(row + c * 4U, word))
+            {
+                encode_hex_word(&text[p], word);
+                for (uint32_t b = 0; b < 4U; b++)
+                {
+                    const uint8_t v    = static_cast<uint8_t>(word >> (b * 8U));
+                    ascii[c * 4U + b] = v >= 0x20U and v < 0x7FU ? static_cast<char>(v) : '.';
+                }
+            }
+            else
+            {
+                memset(&text[p], '?', 8);
+                memset(&ascii[c * 4U], '?', 4);
+                fault = true;
+            }
+            p += 8U;
+        }
+        text[p++] = ' ';
+        text[p++] = '|';
+        memcpy(&text[p], ascii, cols * 4U);
+        p += cols * 4U;
+        text[p++] = '|';
+        sh.line(std::string_view(text, p));
+    }
+    return fault ? "bus fault" : nullptr;
+}
+
+
+const char *shell_mw(ShellEngine &sh, ShellHex addr, ShellHex value, std::optional<uint32_t> count)
+{
+    const uint32_t n      = count.value_or(1U);
+    const char *const err = shell_words_check(addr.value, n);
+    if (err != nullptr)
+    {
+        return err;
+    }
+
+    for (uint32_t i = 0; i < n and not sh.cancelled(); i++)
+    {
+        if (not s_memory->write(addr.value + i * 4U, value.value))
+        {
+            sh.format(FMT("bus fault at %08x"), addr.value + i * 4U);
+            return "bus fault";
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief characters of the text of one dump line of n bytes
+ */
+static uint32_t shell_dump_text_len(ShellDumpModeEnum mode, uint32_t n)
+{
+    return mode == ShellDumpModeEnum::HEX ? SHELL_HEX_HEAD + 2U * n : encode_base64_len(n);
+}
+
+
+/**
+ * @brief the text of one dump line, without mark nor line end
+ * @return characters written, shell_dump_text_len()
+ */
+static uint32_t shell_dump_text(char *out, ShellDumpModeEnum mode, uint32_t addr, const uint8_t *src, uint32_t n)
+{
+    if (mode != ShellDumpModeEnum::HEX)
+    {
+        return encode_base64(out, src, n);
+    }
+    encode_hex_word(out, addr);
+    out[8] = ':';
+    out[9] = ' ';
+    encode_hex(&out[SHELL_HEX_HEAD], src, n);
+    return SHELL_HEX_HEAD + 2U * n;
+}
+
+
+/**
+ * @brief one message of whole lines from src, into the bulk channel
+ * @return bytes of src sent, 0 when the channel gave no room
+ */
+static uint32_t shell_dump_lines(ShellOutput &out, ShellDumpModeEnum mode, const char *mark, uint32_t markLen,
+                                 uint32_t addr, const uint8_t *src, uint32_t left)
+{
+    const uint32_t row  = mode == ShellDumpModeEnum::HEX ? SHELL_DUMP_HEX_ROW : SHELL_DUMP_B64_ROW;
+    const uint32_t full = markLen + shell_dump_text_len(mode, row) + 2U;
+
+    uint32_t take = (SHELL_BULK_MAX / full) * row;
+    take          = left < take ? left : take;
+    const uint32_t tail = take % row;
+    const uint32_t size = (take / row) * full + (tail != 0U ? markLen + shell_dump_text_len(mode, tail) + 2U : 0U);
+
+    auto *p = reinterpret_cast<char *>(out.bulk_reserve(size));
+    if (p == nullptr)
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < take; i += row)
+    {
+        const uint32_t n = take - i < row ? take - i : row;
+        memcpy(p, mark, markLen);
+        p += markLen;
+        p += shell_dump_text(p, mode, addr + i, src + i, n);
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+    out.bulk_commit(size);
+    return take;
+}
+
+
+/**
+ * @brief one frame from src, into the bulk channel
+ * @return bytes of src sent, 0 when the channel gave no room
+ */
+static uint32_t shell_dump_frame(ShellOutput &out, uint32_t tag, uint32_t addr, const uint8_t *src, uint32_t left)
+{
+    const uint32_t n = left < SHELL_FRAME_DATA ? left : SHELL_FRAME_DATA;
+    uint8_t *p       = out.bulk_reserve(sizeof(ShellFrameHdr) + n);
+    if (p == nullptr)
+    {
+        return 0;
+    }
+    const ShellFrameHdr hdr = {SHELL_FRAME_MARK, SHELL_FRAME_DUMP, static_cast<uint16_t>(n), tag, addr,
+                               fwu_crc32(0, src, n)};
+    memcpy(p, &hdr, sizeof(hdr));
+    memcpy(p + sizeof(hdr), src, n);
+    out.bulk_commit(sizeof(hdr) + n);
+    return n;
+}
+
+
+/**
+ * @brief the bytes as CBOR body items: addr, a byte string in chunks, bytes, crc32
+ */
+static const char *shell_dump_cbor(ShellEngine &sh, CborOut &out, uint32_t addr, const uint8_t *src, uint32_t bytes)
+{
+    out.uinteger(addr);
+    out.open_bytes();
+    uint32_t done = 0;
+    while (done < bytes and not sh.cancelled())
+    {
+        const uint32_t n = bytes - done < SHELL_DUMP_CBOR_CHUNK ? bytes - done : SHELL_DUMP_CBOR_CHUNK;
+        out.bytes(src + done, n);
+        done += n;
+    }
+    out.close();
+    out.uinteger(done);
+    out.uinteger(fwu_crc32(0, src, done));
+    return nullptr;
+}
+
+
+/**
+ * @note  the bulk channel is tried first: where there is none the text
+ *        lines go through sh.line(), whose output may be a job or a stage;
+ *        in machine mode the bytes go as they are, whatever the mode asked
+ */
+const char *shell_dump(ShellEngine &sh, ShellHex addr, uint32_t bytes, std::optional<ShellDumpModeEnum> mode)
+{
+    if (s_memory == nullptr)
+    {
+        return "no memory access";
+    }
+    const uint8_t *const src = s_memory->map(addr.value, bytes);
+    if (src == nullptr)
+    {
+        return "not memory, use md";
+    }
+
+    CborOut *const cbor = sh.cbor();
+    if (cbor != nullptr)
+    {
+        return shell_dump_cbor(sh, *cbor, addr.value, src, bytes);
+    }
+
+    const ShellDumpModeEnum m = mode.value_or(ShellDumpModeEnum::HEX);
+    ShellOutput &out          = sh.output_getter();
+    char mark[SHELL_MARK_MAX];
+    const uint32_t markLen = sh.body_mark(mark);
+
+    bool bulk     = true;
+    uint32_t done = 0;
+    while (done < bytes and not sh.cancelled())
+    {
+        const uint32_t left = bytes - done;
+        uint32_t n          = 0;
+        if (bulk)
+        {
+            n = m == ShellDumpModeEnum::RAW
+                    ? shell_dump_frame(out, sh.tag_getter(), addr.value + done, src + done, left)
+                    : shell_dump_lines(out, m, mark, markLen, addr.value + done, src + done, left);
+        }
+        if (n == 0U and done != 0U and bulk)
+        {
+            return "host stopped reading";
+        }
+        if (n == 0U)
+        {
+            if (m == ShellDumpModeEnum::RAW)
+            {
+                return "raw needs the shell port";
+            }
+            bulk = false;
+            char text[SHELL_HEX_HEAD + 2U * SHELL_DUMP_HEX_ROW];
+            n = left < SHELL_DUMP_HEX_ROW ? left : SHELL_DUMP_HEX_ROW;
+            n = m == ShellDumpModeEnum::HEX ? n : (left < SHELL_DUMP_B64_ROW ? left : SHELL_DUMP_B64_ROW);
+            sh.line(std::string_view(text, shell_dump_text(text, m, addr.value + done, src + done, n)));
+        }
+        done += n;
+    }
+    if (bulk)
+    {
+        out.bulk_drain();
+    }
+
+    sh.format(FMT("%u bytes crc32 %08x"), done, fwu_crc32(0, src, done));
+    return nullptr;
+}
+
+
+
+
+/* ------- registration ------------------------------------------------------*/
+
+SHELL_COMMAND(md, shell_md, "words of memory or registers");
+SHELL_COMMAND(mw, shell_mw, "write words of memory or registers");
+SHELL_COMMAND(dump, shell_dump, "bytes of memory, hex, base64 or raw frames");
@@ -0,0 +1,148 @@
+/**
+ *******************************************************************************
+ * @file    shell-memory.hpp
+ * @brief   the memory commands of the shell: md, mw, dump
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS: the commands reach the memory through a ShellMemory
+ * bound by the owner, the board (shell-cmds.cpp) knows its regions and
+ * survives a bus fault, the host benchmark gives a buffer.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * md and mw go one word at a time through read() and write(), 32-bit
+ * accesses a peripheral register accepts; a word that faults shows as
+ * "????????". dump is for memory only, what map() gives a pointer to:
+ *
+ *      md 40000400 8               "40000400: 00000081 00000000 ... |....|"
+ *      mw 58020818 00000002        BSRR of port C: PC1 high
+ *      dump 24000000 327680        the AXI SRAM, hexadecimal
+ *      dump 24000000 327680 base64 the same in base64
+ *      dump 24000000 327680 raw    the same in binary frames
+ *
+ * On the shell port dump writes straight into the bulk transmit queue
+ * (ShellOutput::bulk_reserve()): each message holds as many whole lines as
+ * fit SHELL_BULK_MAX, or one frame of shell-proto.hpp for `raw`, encoded
+ * in place by encode.hpp. Without a bulk channel, in a job or a pipeline,
+ * the text lines go out one by one like any other and raw is refused. The
+ * last line is "<bytes> bytes crc32 <crc>" over what was dumped, sent once
+ * the bulk bytes have left. In machine mode (shell-engine.hpp) the body is
+ * the address, the bytes as a byte string of SHELL_DUMP_CBOR_CHUNK chunks,
+ * their count and CRC, in the frames of the records, whatever the mode.
+ *
+ * The port is USB full speed, 1.0 to 1.2 MB/s: hexadecimal puts 2.47
+ * bytes on the wire per byte dumped, the 320 KB of the AXI SRAM take about
+ * 0.74 s; base64 (1.44) about 0.43 s and raw (1.03) about 0.31 s. Dump
+ * large regions in base64 or raw (Tools/shell-host/shell-dump-bench).
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/19
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-args.hpp"
+#include "shell-engine.hpp"
+#include <cstdint>
+#include <optional>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_MD_WORDS        = 16U;    // `md` without a count
+constexpr uint32_t SHELL_MD_ROW          = 4U;     // words per `md` line
+constexpr uint32_t SHELL_DUMP_HEX_ROW    = 32U;    // bytes per hexadecimal `dump` line
+constexpr uint32_t SHELL_DUMP_B64_ROW    = 48U;    // bytes per base64 `dump` line, 64 characters
+constexpr uint32_t SHELL_DUMP_CBOR_CHUNK = 4096U;  // bytes per chunk of the byte string, machine mode
+
+/**
+ * @brief how `dump` writes the bytes, hexadecimal when left out
+ */
+enum class ShellDumpModeEnum
+{
+    HEX,
+    BASE64,
+    RAW,
+};
+
+template <>
+struct ShellEnumWords<ShellDumpModeEnum>
+{
+    static constexpr std::string_view name = "hex|base64|raw";
+    static constexpr ShellEnumWord<ShellDumpModeEnum> list[] = {
+        {"hex", ShellDumpModeEnum::HEX},
+        {"base64", ShellDumpModeEnum::BASE64},
+        {"raw", ShellDumpModeEnum::RAW},
+    };
+};
+
+
+
+
+/*-------- 3. memory ---------------------------------------------------------*/
+
+/**
+ * @brief the address space as the commands see it
+ */
+class ShellMemory
+{
+  public:
+    /**
+     * @brief [addr, addr + len) as plain memory
+     * @return nullptr when any of it is not: a peripheral, a hole
+     */
+    virtual const uint8_t *map(uint32_t addr, uint32_t len) = 0;
+
+    /**
+     * @brief one aligned 32-bit read
+     * @return false on a bus fault
+     */
+    virtual bool read(uint32_t addr, uint32_t &word) = 0;
+
+    /**
+     * @brief one aligned 32-bit write
+     * @return false on a bus fault
+     */
+    virtual bool write(uint32_t addr, uint32_t word) = 0;
+
+    virtual ~ShellMemory() = default;
+};
+
+/**
+ * @brief the memory of md, mw and dump; without one they fail
+ */
+void shell_memory_bind(ShellMemory *mem);
+
+
+
+
+/*-------- 4. commands -------------------------------------------------------*/
+
+/**
+ * @brief words from addr, SHELL_MD_ROW per line with their ASCII
+ */
+const char *shell_md(ShellEngine &sh, ShellHex addr, std::optional<uint32_t> words);
+
+/**
+ * @brief write value to count words from addr, one when left out
+ */
+const char *shell_mw(ShellEngine &sh, ShellHex addr, ShellHex value, std::optional<uint32_t> count);
+
+/**
+ * @brief bytes from addr in hexadecimal, base64 or binary frames
+ */
+const char *shell_dump(ShellEngine &sh, ShellHex addr, uint32_t bytes, std::optional<ShellDumpModeEnum> mode);
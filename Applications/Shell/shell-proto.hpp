@@ -0,0 +1,182 @@
+/**
+ *******************************************************************************
+ * @file    shell-proto.hpp
+ * @brief   the tagged line protocol of the shell port, for programs
+ *******************************************************************************
+ * @attention
+ *
+ * Shared by the device shell and Tools/shell-client: no HAL, no RTOS. A
+ * person at a terminal types plain command lines and never sees a tag; a
+ * program prefixes its lines with a tag and gets tagged replies, so it can
+ * keep many commands in flight and tell the replies from the log lines that
+ * share the port.
+ *
+ *******************************************************************************
+ * @note
+ *
+ *      host                                    device
+ *      !17 echo hello\n               ->
+ *      !18 version\n                  ->
+ *                                     <-      !17:hello\r\n
+ *                                     <-      !17=ok\r\n
+ *                                     <-      [    1.234] I adc: 3.30 V\r\n
+ *                                     <-      !18:1.0\r\n
+ *                                     <-      !18=ok\r\n
+ *
+ *  - request:  '!' tag ' ' command line '\n' (or '\r')
+ *  - body:     '!' tag ':' text, one line of the command's output
+ *  - end:      '!' tag '=' "ok" or "err " reason, exactly one per request
+ *  - frame:    0xFE kind len tag addr crc, then len binary bytes, never
+ *              cut (ShellFrameHdr): 'D' the raw data of `dump ... raw`,
+ *              'C' the CBOR records of a session in machine mode
+ *  - anything else from the device is not a reply: log lines, printf
+ *
+ * The tag is a decimal number chosen by the host, echoed untouched. Replies
+ * of one tag come in order; replies of different tags may interleave (jobs
+ * running in the background end when they end). Every reply line is one
+ * message of the interactive transmit class (txq-intf.h): the transmit
+ * scheduler never cuts it with another class. A dump is sent in the bulk
+ * class instead, several body lines or one frame per message: an end line
+ * is only sent once the bulk bytes of its request have left.
+ *
+ * After `mode cbor` the body of a request is CBOR (shell-engine.hpp): one
+ * record per command, the frames of a tag carry the byte stream of its
+ * records in order, addr the offset of the first byte in it. A line may
+ * batch commands with the word ";", the records tell them apart:
+ *
+ *      !19 mode cbor\n                ->
+ *                                     <-      !19=ok\r\n
+ *      !20 version ; uptime ; nope\n  ->
+ *                                     <-      0xFE 'C' ... {0:20, 1:0, 2:["H7-shell 1.0 ..."], 3:null} {0:20, 1:1, ...
+ *                                     <-      0xFE 'C' ... ... 3:"unknown command"}
+ *                                     <-      !20=err unknown command\r\n
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/10
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr char SHELL_TAG_MARK        = '!';
+constexpr char SHELL_BODY_MARK       = ':';
+constexpr char SHELL_END_MARK        = '=';
+constexpr uint32_t SHELL_LINE_MAX    = 256U;   // request line, terminator included
+constexpr uint32_t SHELL_INFLIGHT    = 1024U;  // request bytes a host keeps unanswered, half the receive ring
+constexpr uint8_t SHELL_FRAME_MARK   = 0xFEU;  // first byte of a frame, never in a text line
+constexpr char SHELL_FRAME_DUMP      = 'D';
+constexpr char SHELL_FRAME_CBOR      = 'C';
+constexpr uint32_t SHELL_FRAME_MAX   = 512U;   // a frame, header included, the transmit unit
+
+/**
+ * @brief a line of the protocol, split
+ */
+struct ShellTagged
+{
+    uint32_t tag;
+    char kind;              // ' ' request, ':' body, '=' end
+    std::string_view rest;  // after the kind character, line end removed
+};
+
+/**
+ * @brief in front of the binary bytes of a frame, little endian
+ */
+struct ShellFrameHdr
+{
+    uint8_t mark;           // SHELL_FRAME_MARK
+    uint8_t kind;           // SHELL_FRAME_DUMP or SHELL_FRAME_CBOR
+    uint16_t len;           // bytes after the header
+    uint32_t tag;           // of the request, 0 when it had none
+    uint32_t addr;          // of the first byte: in memory, or in the record stream
+    uint32_t crc;           // fwu_crc32() of the bytes
+};
+
+static_assert(sizeof(ShellFrameHdr) == 16U, "the frame header is on the wire");
+
+constexpr uint32_t SHELL_FRAME_DATA = SHELL_FRAME_MAX - sizeof(ShellFrameHdr);
+
+
+
+
+/*-------- 3. function implement ---------------------------------------------*/
+
+/**
+ * @brief split a tagged line
+ * @param line one line, with or without its line end
+ * @return false for a line that is not tagged
+ */
+constexpr bool shell_parse_tagged(std::string_view line, ShellTagged &out)
+{
+    while (not line.empty() and (line.back() == '\n' or line.back() == '\r'))
+    {
+        line.remove_suffix(1);
+    }
+    if (line.size() < 3U or line[0] != SHELL_TAG_MARK)
+    {
+        return false;
+    }
+
+    uint64_t tag = 0;
+    size_t i     = 1;
+    for (; i < line.size() and line[i] >= '0' and line[i] <= '9'; i++)
+    {
+        tag = tag * 10U + static_cast<uint32_t>(line[i] - '0');
+        if (tag > UINT32_MAX)
+        {
+            return false;
+        }
+    }
+    if (i == 1U or i == line.size())
+    {
+        return false;
+    }
+
+    const char kind = line[i];
+    if (kind != ' ' and kind != SHELL_BODY_MARK and kind != SHELL_END_MARK)
+    {
+        return false;
+    }
+    out = {static_cast<uint32_t>(tag), kind, line.substr(i + 1U)};
+    return true;
+}
+
+static_assert([] {
+    ShellTagged t{};
+    return shell_parse_tagged("!42=ok\r\n", t) and t.tag == 42U and t.kind == '=' and t.rest == "ok";
+}());
+static_assert([] {
+    ShellTagged t{};
+    return not shell_parse_tagged("[    1.000] I x", t) and not shell_parse_tagged("!x:1", t);
+}());
+
+/**
+ * @brief a frame header at the start of buf
+ * @return false when buf is shorter than a header or is not one
+ */
+inline bool shell_parse_frame(const uint8_t *buf, uint32_t len, ShellFrameHdr &out)
+{
+    if (len < sizeof(ShellFrameHdr) or buf[0] != SHELL_FRAME_MARK)
+    {
+        return false;
+    }
+    memcpy(&out, buf, sizeof(ShellFrameHdr));
+    return out.len <= SHELL_FRAME_DATA;
+}
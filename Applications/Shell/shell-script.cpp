@@ -0,0 +1,766 @@
+/**
+ *******************************************************************************
+ * @file    shell-script.cpp
+ * @brief   shell scripts compiled once into bytecode, kept in and run from the NOR flash
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-script.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/16
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-script.hpp"
+#include "../Update/fwu-proto.hpp"
+#include <cstring>
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define SHELL_SCRIPT_NO_SLOT    0xFFFFFFFFU
+#define SHELL_SCRIPT_READ_STEP  64U     // bytes read at a time without a window
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @note  a script packs the arguments of a typed command by their types:
+ *        the same names with other types, or in another order, are another table
+ */
+uint32_t shell_script_table_id(const ShellIndex &index)
+{
+    uint32_t h = shell_hash(std::string_view(), index.count);
+    for (uint32_t i = 0; i < index.count; i++)
+    {
+        const ShellCommand &cmd = index.cmds[i];
+        h                       = shell_hash(cmd.name, h);
+        h                       = shell_hash(cmd.pack != nullptr ? "typed" : "raw", h + cmd.required);
+        for (uint32_t p = 0; p < cmd.paramCount; p++)
+        {
+            h = shell_hash(cmd.params[p], h);
+        }
+    }
+    return h;
+}
+
+
+
+
+/* ---- compiler ---- */
+
+void ShellScriptCompiler::reset()
+{
+    _len        = 0;
+    _ops        = 0;
+    _line       = 0;
+    _depth      = 0;
+    _err        = nullptr;
+    _message[0] = '\0';
+}
+
+
+const char *ShellScriptCompiler::line(char *text, uint32_t len)
+{
+    _line++;
+    if (_err != nullptr)
+    {
+        return _err;
+    }
+
+    uint32_t i = 0;
+    while (i < len and (text[i] == ' ' or text[i] == '\t'))
+    {
+        i++;
+    }
+    if (i == len or text[i] == '#')
+    {
+        return nullptr; // a comment is not split: its quotes need not match
+    }
+
+    ShellArgv args;
+    const char *err = shell_tokenize(text, len, args);
+    if (err != nullptr)
+    {
+        return fail(err);
+    }
+    bool done = false;
+    err       = keyword(args, done);
+    if (done)
+    {
+        return err != nullptr ? fail(err) : nullptr;
+    }
+    return call(args, args.argv[0] == "try" ? 1U : 0U);
+}
+
+
+const char *ShellScriptCompiler::finish()
+{
+    if (_err == nullptr and _depth != 0U)
+    {
+        return fail("missing end");
+    }
+    return _err;
+}
+
+
+/**
+ * @brief repeat, if, else, end, exit
+ * @param done set when the line was one of them
+ */
+const char *ShellScriptCompiler::keyword(const ShellArgv &args, bool &done)
+{
+    const std::string_view w = args.argv[0];
+    done                     = true;
+    if (w == "repeat")
+    {
+        uint32_t n = 0;
+        if (args.argc != 2U or not shell_parse_uint(args.argv[1], n))
+        {
+            return "usage: repeat <n>";
+        }
+        if (_depth == SHELL_SCRIPT_DEPTH)
+        {
+            return "blocks nested too deep";
+        }
+        if (emit(ShellOpEnum::REPEAT, n) == nullptr)
+        {
+            return "script too long";
+        }
+        _blocks[_depth++] = {BlockEnum::REPEAT, _len};
+        return nullptr;
+    }
+    if (w == "if")
+    {
+        if (args.argc != 2U or (args.argv[1] != "ok" and args.argv[1] != "fail"))
+        {
+            return "usage: if ok|fail";
+        }
+        if (_depth == SHELL_SCRIPT_DEPTH)
+        {
+            return "blocks nested too deep";
+        }
+        const uint32_t at = _len;
+        ShellOp *op       = emit(ShellOpEnum::IF, 0);
+        if (op == nullptr)
+        {
+            return "script too long";
+        }
+        op->flags         = args.argv[1] == "fail" ? SHELL_OP_FAIL : 0U;
+        _blocks[_depth++] = {BlockEnum::IF, at};
+        return nullptr;
+    }
+    if (w == "else")
+    {
+        if (args.argc != 1U)
+        {
+            return "usage: else";
+        }
+        if (_depth == 0U or _blocks[_depth - 1U].kind != BlockEnum::IF)
+        {
+            return "else without if";
+        }
+        const uint32_t at = _len;
+        if (emit(ShellOpEnum::JUMP, 0) == nullptr)
+        {
+            return "script too long";
+        }
+        patch(_blocks[_depth - 1U].at, _len);
+        _blocks[_depth - 1U] = {BlockEnum::ELSE, at};
+        return nullptr;
+    }
+    if (w == "end")
+    {
+        if (args.argc != 1U)
+        {
+            return "usage: end";
+        }
+        if (_depth == 0U)
+        {
+            return "end without a block";
+        }
+        const Block b = _blocks[--_depth];
+        if (b.kind != BlockEnum::REPEAT)
+        {
+            patch(b.at, _len);
+        }
+        else if (emit(ShellOpEnum::LOOP, b.at) == nullptr)
+        {
+            return "script too long";
+        }
+        return nullptr;
+    }
+    if (w == "exit")
+    {
+        if (args.argc != 1U)
+        {
+            return "usage: exit";
+        }
+        return emit(ShellOpEnum::EXIT, 0) == nullptr ? "script too long" : nullptr;
+    }
+    done = false;
+    return nullptr;
+}
+
+
+/**
+ * @brief a command: its index, then its packed arguments, or its words
+ *        for a handler taking the ShellArgv
+ * @param first 1 after "try"
+ */
+const char *ShellScriptCompiler::call(const ShellArgv &line, uint32_t first)
+{
+    ShellArgv args;
+    args.argc = line.argc - first;
+    if (args.argc == 0U)
+    {
+        return fail("usage: try <command>");
+    }
+    for (uint32_t i = 0; i < args.argc; i++)
+    {
+        args.argv[i] = line.argv[first + i];
+        if (args.argv[i] == SHELL_PIPE_MARK or (i + 1U == args.argc and args.argv[i] == SHELL_JOB_MARK))
+        {
+            return fail("no jobs or pipelines in a script");
+        }
+    }
+    if (args.argv[0] == SHELL_SCRIPT_COMMAND)
+    {
+        return fail("scripts do not nest");
+    }
+    const ShellCommand *cmd = _index.find(args.argv[0]);
+    if (cmd == nullptr)
+    {
+        return fail("unknown command");
+    }
+    if (_size - _len < SHELL_SCRIPT_OP_MAX)
+    {
+        return fail("script too long");
+    }
+
+    ShellOp op     = {};
+    op.code        = static_cast<uint8_t>(ShellOpEnum::CALL);
+    op.flags       = first != 0U ? SHELL_OP_TRY : 0U;
+    op.line        = static_cast<uint16_t>(_line < 0xFFFFU ? _line : 0xFFFFU);
+    op.command     = static_cast<uint8_t>(cmd - _index.cmds);
+    uint8_t *body  = &_code[_len + sizeof(ShellOp)];
+    uint32_t room  = SHELL_SCRIPT_OP_MAX - sizeof(ShellOp);
+    uint32_t bytes = 0;
+    if (cmd->pack != nullptr)
+    {
+        ShellPacked out = {body, room, 0};
+        uint32_t bad    = 0;
+        const char *err = cmd->pack(args, out, bad);
+        if (err != nullptr)
+        {
+            char detail[SHELL_REPLY_MAX / 2U];
+            if (bad < cmd->paramCount)
+            {
+                (void)format_to(detail, sizeof(detail), FMT("argument %u <%s>: \"%s\""), bad + 1U, cmd->params[bad],
+                                args.argv[bad + 1U]);
+            }
+            else
+            {
+                const uint32_t n = shell_format_usage(*cmd, detail, sizeof(detail));
+                detail[n]        = '\0';
+            }
+            return fail(err, detail);
+        }
+        op.argc = static_cast<uint8_t>(args.argc - 1U);
+        bytes   = out.len;
+    }
+    else
+    {
+        op.flags |= SHELL_OP_RAW;
+        op.argc = static_cast<uint8_t>(args.argc);
+        for (uint32_t i = 0; i < args.argc; i++)
+        {
+            const std::string_view w = args.argv[i];
+            if (w.size() >= room - bytes)
+            {
+                return fail("arguments too long");
+            }
+            memcpy(&body[bytes], w.data(), w.size());
+            body[bytes + w.size()] = 0;
+            bytes += static_cast<uint32_t>(w.size()) + 1U;
+        }
+    }
+
+    op.size = static_cast<uint16_t>((sizeof(ShellOp) + bytes + 3U) & ~3U);
+    memset(&body[bytes], 0, op.size - sizeof(ShellOp) - bytes);
+    memcpy(&_code[_len], &op, sizeof(op));
+    _len += op.size;
+    _ops++;
+    return nullptr;
+}
+
+
+/**
+ * @brief append an op without arguments
+ * @return the op, to set its flags; nullptr when the code is full
+ */
+ShellOp *ShellScriptCompiler::emit(ShellOpEnum code, uint32_t value)
+{
+    if (_size - _len < sizeof(ShellOp))
+    {
+        return nullptr;
+    }
+    ShellOp *op = reinterpret_cast<ShellOp *>(&_code[_len]);
+    *op         = {};
+    op->code    = static_cast<uint8_t>(code);
+    op->size    = sizeof(ShellOp);
+    op->line    = static_cast<uint16_t>(_line < 0xFFFFU ? _line : 0xFFFFU);
+    op->value   = value;
+    _len += sizeof(ShellOp);
+    _ops++;
+    return op;
+}
+
+
+/**
+ * @brief the jump target of the IF or JUMP at `at`
+ */
+void ShellScriptCompiler::patch(uint32_t at, uint32_t value)
+{
+    reinterpret_cast<ShellOp *>(&_code[at])->value = value;
+}
+
+
+const char *ShellScriptCompiler::fail(const char *reason, const char *detail)
+{
+    _err = reason;
+    (void)format_to(_message, sizeof(_message), FMT("line %u: %s%s%s"), _line, reason, detail != nullptr ? ": " : "",
+                    detail != nullptr ? detail : "");
+    return reason;
+}
+
+
+
+
+/* ---- store ---- */
+
+const char *ShellScriptStore::save(std::string_view name, const ShellScriptCompiler &compiler)
+{
+    if (not _flash.enable_getter())
+    {
+        return "flash not ready";
+    }
+    if (name.empty() or name.size() > SHELL_SCRIPT_NAME_MAX)
+    {
+        return "bad name";
+    }
+    if (SHELL_SCRIPT_SLOT % _flash.geometry_getter().sectorSize != 0U)
+    {
+        return "sector larger than a script slot";
+    }
+
+    uint32_t slot = SHELL_SCRIPT_NO_SLOT;
+    uint32_t old  = SHELL_SCRIPT_NO_SLOT;
+    ShellScriptHeader h;
+    for (uint32_t s = 0; s < slots_getter(); s++)
+    {
+        if (not header(s, h))
+        {
+            slot = slot == SHELL_SCRIPT_NO_SLOT ? s : slot;
+        }
+        else if (name == h.name)
+        {
+            old = s;
+        }
+    }
+    slot = slot != SHELL_SCRIPT_NO_SLOT ? slot : old; // no free slot: replaced in place
+    if (slot == SHELL_SCRIPT_NO_SLOT)
+    {
+        return "no free script slot";
+    }
+
+    h       = {};
+    h.magic = SHELL_SCRIPT_MAGIC;
+    h.size  = compiler.size_getter();
+    h.crc   = fwu_crc32(0, compiler.code_getter(), h.size);
+    h.table = shell_script_table_id(compiler.index_getter());
+    h.ops   = static_cast<uint16_t>(compiler.ops_getter());
+    h.lines = static_cast<uint16_t>(compiler.lines_getter() < 0xFFFFU ? compiler.lines_getter() : 0xFFFFU);
+    memcpy(h.name, name.data(), name.size());
+
+    const uint32_t addr = _base + slot * SHELL_SCRIPT_SLOT;
+    const char *err     = erase(slot, SHELL_SCRIPT_CODE + h.size);
+    if (err == nullptr)
+    {
+        err = write(addr + SHELL_SCRIPT_CODE, compiler.code_getter(), h.size);
+    }
+    if (err == nullptr)
+    {
+        err = write(addr, reinterpret_cast<const uint8_t *>(&h), sizeof(h)); // last: the script is whole
+    }
+    if (err == nullptr and old != SHELL_SCRIPT_NO_SLOT and old != slot)
+    {
+        err = erase(old, 1U);
+    }
+    return err;
+}
+
+
+const char *ShellScriptStore::remove(std::string_view name)
+{
+    uint32_t slot = 0;
+    ShellScriptHeader h;
+    if (not find(name, slot, h))
+    {
+        return "no such script";
+    }
+    return erase(slot, 1U);
+}
+
+
+void ShellScriptStore::list(ShellEngine &sh)
+{
+    const uint32_t table = shell_script_table_id(sh.index_getter());
+    uint32_t used        = 0;
+    ShellScriptHeader h;
+    for (uint32_t s = 0; s < slots_getter(); s++)
+    {
+        if (header(s, h))
+        {
+            used++;
+            sh.format(FMT("%-15s %5u B %4u ops %4u lines%s"), h.name, h.size, h.ops, h.lines,
+                      h.table != table ? "  (other commands, load it again)" : "");
+        }
+    }
+    sh.format(FMT("%u of %u slots used"), used, slots_getter());
+}
+
+
+/**
+ * @note  the loop counters are on the stack: a script reached again through
+ *        a `repeat` starts its count over
+ */
+const char *ShellScriptStore::run(ShellEngine &sh, std::string_view name)
+{
+    uint32_t slot = 0;
+    ShellScriptHeader h;
+    if (not find(name, slot, h))
+    {
+        return "no such script";
+    }
+    const ShellIndex &index = sh.index_getter();
+    if (h.table != shell_script_table_id(index))
+    {
+        return "compiled for other commands, load it again";
+    }
+    if (not verify(slot, h))
+    {
+        return "script corrupt";
+    }
+    _stats.runs++;
+
+    const uint32_t code = _base + slot * SHELL_SCRIPT_SLOT + SHELL_SCRIPT_CODE;
+    uint32_t loops[SHELL_SCRIPT_DEPTH];
+    uint32_t depth = 0;
+    bool ok        = true;
+    uint32_t pc    = 0;
+    alignas(4) uint8_t buf[SHELL_SCRIPT_OP_MAX];
+    while (pc != h.size)
+    {
+        if (sh.cancelled())
+        {
+            return "killed";
+        }
+        ShellOp op;
+        if (pc > h.size or pc % 4U != 0U or not fetch(code + pc, code + h.size, buf))
+        {
+            return "script changed";
+        }
+        memcpy(&op, buf, sizeof(op));
+        _stats.ops++;
+        pc += op.size;
+
+        switch (static_cast<ShellOpEnum>(op.code))
+        {
+        case ShellOpEnum::CALL: {
+            const char *err = op.command < index.count ? call(sh, index.cmds[op.command], op, buf) : "script changed";
+            ok              = err == nullptr;
+            if (not ok and (op.flags & SHELL_OP_TRY) == 0U)
+            {
+                sh.format(FMT("line %u: %s"), op.line, err);
+                return err;
+            }
+            break;
+        }
+        case ShellOpEnum::REPEAT:
+            if (depth == SHELL_SCRIPT_DEPTH)
+            {
+                return "script changed";
+            }
+            loops[depth++] = op.value;
+            break;
+
+        case ShellOpEnum::LOOP: // a count of 0 never ends
+            if (depth == 0U)
+            {
+                return "script changed";
+            }
+            if (loops[depth - 1U] == 0U or --loops[depth - 1U] != 0U)
+            {
+                pc = op.value;
+            }
+            else
+            {
+                depth--;
+            }
+            break;
+
+        case ShellOpEnum::IF:
+            if (((op.flags & SHELL_OP_FAIL) != 0U) == ok)
+            {
+                pc = op.value;
+            }
+            break;
+
+        case ShellOpEnum::JUMP:
+            pc = op.value;
+            break;
+
+        case ShellOpEnum::EXIT:
+            return nullptr;
+
+        default:
+            return "script changed";
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief call the command of a CALL op, its arguments after the op in buf
+ */
+const char *ShellScriptStore::call(ShellEngine &sh, const ShellCommand &cmd, const ShellOp &op, const uint8_t *buf)
+{
+    _stats.calls++;
+    const uint8_t *args = &buf[sizeof(ShellOp)];
+    if ((op.flags & SHELL_OP_RAW) == 0U)
+    {
+        return cmd.run != nullptr ? cmd.run(sh, args) : "script changed";
+    }
+
+    ShellArgv argv;
+    argv.argc             = op.argc < SHELL_ARGC_MAX ? op.argc : SHELL_ARGC_MAX;
+    const char *p         = reinterpret_cast<const char *>(args);
+    const char *const end = reinterpret_cast<const char *>(&buf[op.size]);
+    for (uint32_t i = 0; i < argv.argc; i++)
+    {
+        const size_t n = strnlen(p, static_cast<size_t>(end - p));
+        if (p + n == end)
+        {
+            return "script changed";
+        }
+        argv.argv[i] = std::string_view(p, n);
+        p += n + 1U;
+    }
+    return cmd.handler(sh, argv);
+}
+
+
+/**
+ * @brief from the window when there is one, else through read()
+ */
+bool ShellScriptStore::copy(const uint8_t *window, uint32_t addr, void *buf, uint32_t len)
+{
+    if (window != nullptr)
+    {
+        memcpy(buf, &window[addr], len);
+        return true;
+    }
+    return _flash.read(addr, static_cast<uint8_t *>(buf), len) == FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief copy the op at addr and its arguments, under one lock
+ * @return false when the bytes are not an op ending before `end`
+ */
+bool ShellScriptStore::fetch(uint32_t addr, uint32_t end, uint8_t *buf)
+{
+    ShellOp op;
+    _flash.lock();
+    const uint8_t *window = _flash.map();
+    bool ok               = end - addr >= sizeof(ShellOp) and copy(window, addr, buf, sizeof(ShellOp));
+    if (ok)
+    {
+        memcpy(&op, buf, sizeof(op));
+        ok = op.size >= sizeof(ShellOp) and op.size <= SHELL_SCRIPT_OP_MAX and op.size % 4U == 0U and
+             op.size <= end - addr;
+    }
+    if (ok and op.size > sizeof(ShellOp))
+    {
+        ok = copy(window, addr + sizeof(ShellOp), &buf[sizeof(ShellOp)], op.size - sizeof(ShellOp));
+    }
+    _flash.unlock();
+    return ok;
+}
+
+
+/**
+ * @return true when the slot holds a script
+ */
+bool ShellScriptStore::header(uint32_t slot, ShellScriptHeader &h)
+{
+    _flash.lock();
+    const bool ok = _flash.enable_getter() and copy(_flash.map(), _base + slot * SHELL_SCRIPT_SLOT, &h, sizeof(h));
+    _flash.unlock();
+    return ok and h.magic == SHELL_SCRIPT_MAGIC and h.size <= SHELL_SCRIPT_CODE_MAX and
+           h.name[SHELL_SCRIPT_NAME_MAX] == '\0';
+}
+
+
+bool ShellScriptStore::find(std::string_view name, uint32_t &slot, ShellScriptHeader &h)
+{
+    for (slot = 0; slot < slots_getter(); slot++)
+    {
+        if (header(slot, h) and name == h.name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief the CRC of the code, straight from the window when there is one
+ */
+bool ShellScriptStore::verify(uint32_t slot, const ShellScriptHeader &h)
+{
+    const uint32_t addr = _base + slot * SHELL_SCRIPT_SLOT + SHELL_SCRIPT_CODE;
+    uint32_t crc        = 0;
+    _flash.lock();
+    const uint8_t *window = _flash.map();
+    if (window != nullptr)
+    {
+        crc = fwu_crc32(0, &window[addr], h.size);
+    }
+    _flash.unlock();
+
+    for (uint32_t done = 0; window == nullptr and done < h.size;)
+    {
+        uint8_t buf[SHELL_SCRIPT_READ_STEP];
+        const uint32_t n = h.size - done < sizeof(buf) ? h.size - done : static_cast<uint32_t>(sizeof(buf));
+        if (_flash.read(addr + done, buf, n) != FlashErrCode::FLASH_SUCCESS)
+        {
+            return false;
+        }
+        crc = fwu_crc32(crc, buf, n);
+        done += n;
+    }
+    return crc == h.crc;
+}
+
+
+/**
+ * @brief erase the sectors of a slot holding its first len bytes
+ */
+const char *ShellScriptStore::erase(uint32_t slot, uint32_t len)
+{
+    const uint32_t sector = _flash.geometry_getter().sectorSize;
+    const uint32_t addr   = _base + slot * SHELL_SCRIPT_SLOT;
+    for (uint32_t at = 0; at < len; at += sector)
+    {
+        if (_flash.erase_sector(addr + at) != FlashErrCode::FLASH_SUCCESS)
+        {
+            return "flash erase failed";
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief program len bytes, a page at a time
+ */
+const char *ShellScriptStore::write(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    const uint32_t page = _flash.geometry_getter().pageSize;
+    while (len != 0U)
+    {
+        const uint32_t room = page - addr % page;
+        const uint32_t n    = len < room ? len : room;
+        if (_flash.program(addr, data, n) != FlashErrCode::FLASH_SUCCESS)
+        {
+            return "flash program failed";
+        }
+        addr += n;
+        data += n;
+        len -= n;
+    }
+    return nullptr;
+}
+
+
+
+
+/* ---- loader ---- */
+
+const char *ShellScriptLoader::begin(ShellEngine &sh, std::string_view name)
+{
+    if (name.size() > SHELL_SCRIPT_NAME_MAX)
+    {
+        return "name too long";
+    }
+    if (_busy.exchange(true, std::memory_order_acquire))
+    {
+        return "another session is loading a script";
+    }
+    if (not sh.collect(this))
+    {
+        _busy.store(false, std::memory_order_release);
+        return "no lines to load in a job";
+    }
+    _compiler.reset();
+    memcpy(_name, name.data(), name.size());
+    _name[name.size()] = '\0';
+    if (not sh.tagged_getter())
+    {
+        sh.format(FMT("end with a line holding only \"%s\""), SHELL_TEXT_END);
+    }
+    return nullptr;
+}
+
+
+void ShellScriptLoader::line(char *text, uint32_t len)
+{
+    (void)_compiler.line(text, len);
+}
+
+
+const char *ShellScriptLoader::end(ShellEngine &sh, bool cut)
+{
+    const char *err = cut ? "line too long" : _compiler.finish();
+    if (err != nullptr and not cut)
+    {
+        sh.line(_compiler.message_getter());
+    }
+    if (err == nullptr)
+    {
+        err = _store.save(_name, _compiler);
+    }
+    if (err == nullptr)
+    {
+        sh.format(FMT("%s: %u ops %u B from %u lines"), _name, _compiler.ops_getter(), _compiler.size_getter(),
+                  _compiler.lines_getter());
+    }
+    _busy.store(false, std::memory_order_release);
+    return err;
+}
@@ -0,0 +1,363 @@
+/**
+ *******************************************************************************
+ * @file    shell-script.hpp
+ * @brief   shell scripts compiled once into bytecode, kept in and run from the NOR flash
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap, like the engine: the compiler writes into a
+ * buffer it is given, the store and the interpreter only see a FlashIntf.
+ * shell-cmds.cpp puts the store over the OSPI flash (hospi1), whose top
+ * STORAGE_RESERVED_TOP bytes the MSC disk leaves out, and
+ * Tools/shell-host/shell-script-bench.cpp over FlashSimImpl.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * `script load <name>` takes the lines that follow, up to ".", and compiles
+ * them one by one: the command name is looked up once and its index kept,
+ * the arguments of a typed handler are parsed once and kept packed
+ * (shell-args.hpp), the blocks become jumps. Running the script is then a
+ * walk over the ops, without a word to split or to parse:
+ *
+ *      # blink PC1 five times         REPEAT 5
+ *      repeat 5                       CALL   pin {PC1, toggle}
+ *          pin PC1 toggle             CALL   sleep {100}
+ *          sleep 100                  LOOP   back to the pin
+ *      end                            CALL   storage, try
+ *      try storage                    IF     fail, else to the end
+ *      if fail                        CALL   echo (raw: "echo" "no" "disk")
+ *          echo no disk
+ *      end
+ *
+ *      repeat <n> ... end      n times, 0: until the script is killed
+ *      if ok|fail ... [else ...] end
+ *                              on the result of the last command
+ *      try <command>           a failure does not stop the script
+ *      exit                    end the script here
+ *      # ...                   a comment
+ *
+ * A command that fails without `try` stops the script with
+ * "line <n>: <reason>". Jobs, pipelines and `script` itself are refused by
+ * the compiler. A script runs in the task of the line that started it:
+ * "script run blink &" runs it as a job, `kill` stops it between two ops.
+ *
+ * Each script has a slot of SHELL_SCRIPT_SLOT bytes: the header in the
+ * first page, the code after it. The code is programmed first and the
+ * header last, so a slot with a valid header holds a whole script; erasing
+ * the header's sector removes it. The header keeps the CRC of the code
+ * and a fingerprint of the command table: a script compiled for another
+ * firmware is refused, not misread.
+ *
+ * The interpreter reads the code through flash.map() when the driver has a
+ * window (the OSPI flash in memory-mapped mode): each op is copied from the
+ * window under flash.lock() and run after flash.unlock(), so the storage
+ * task keeps the bus between two ops. Without a window it uses flash.read().
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/16
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-args.hpp"
+#include "shell-engine.hpp"
+#include "../../Drivers/Peripheral/Flash/flash-intf.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_SCRIPT_MAGIC    = 0x31534853U;     // "SHS1"
+constexpr uint32_t SHELL_SCRIPT_SLOT     = 16384U;          // flash bytes per script, a multiple of the sector
+constexpr uint32_t SHELL_SCRIPT_CODE     = 256U;            // the header's page, the code starts after
+constexpr uint32_t SHELL_SCRIPT_CODE_MAX = SHELL_SCRIPT_SLOT - SHELL_SCRIPT_CODE;
+constexpr uint32_t SHELL_SCRIPT_NAME_MAX = 15U;
+constexpr uint32_t SHELL_SCRIPT_DEPTH    = 8U;              // blocks open at a time
+constexpr uint32_t SHELL_SCRIPT_OP_MAX   = 384U;            // one op and its arguments, on the stack of the runner
+constexpr std::string_view SHELL_SCRIPT_COMMAND = "script"; // not called from a script
+
+enum class ShellOpEnum : uint8_t
+{
+    CALL,       // command, argc, the packed arguments or the words
+    REPEAT,     // value: the count, 0 forever
+    LOOP,       // value: the first op of the body
+    IF,         // value: where to go when the condition does not hold
+    JUMP,       // value: where to go
+    EXIT,
+};
+
+constexpr uint8_t SHELL_OP_TRY  = 0x01U;    // CALL: a failure does not stop the script
+constexpr uint8_t SHELL_OP_RAW  = 0x02U;    // CALL: the words follow, for a ShellHandler
+constexpr uint8_t SHELL_OP_FAIL = 0x04U;    // IF: holds when the last command failed
+
+/**
+ * @brief one op of the code, its arguments after it
+ */
+struct ShellOp
+{
+    uint8_t code;       // ShellOpEnum
+    uint8_t flags;
+    uint16_t size;      // bytes of the op and its arguments, a multiple of 4
+    uint16_t line;      // in the source, for the errors
+    uint8_t command;    // index in the command table
+    uint8_t argc;       // RAW: the words, the command name included
+    uint32_t value;
+};
+
+static_assert(sizeof(ShellOp) == 12U, "the op is stored as is");
+
+/**
+ * @brief the first bytes of a slot
+ */
+struct ShellScriptHeader
+{
+    uint32_t magic;
+    uint32_t size;      // bytes of code
+    uint32_t crc;       // of the code, fwu_crc32()
+    uint32_t table;     // shell_script_table_id() of the firmware that compiled it
+    uint16_t ops;
+    uint16_t lines;
+    char name[SHELL_SCRIPT_NAME_MAX + 1U];
+};
+
+static_assert(sizeof(ShellScriptHeader) <= SHELL_SCRIPT_CODE, "the header fits its page");
+
+
+
+
+/*-------- 3. function prototypes --------------------------------------------*/
+
+/**
+ * @brief fingerprint of a command table: names, argument types and order
+ */
+uint32_t shell_script_table_id(const ShellIndex &index);
+
+
+
+
+/*-------- 4. compiler -------------------------------------------------------*/
+
+/**
+ * @brief source lines in, code out, one pass: the jumps are patched when
+ *        their block ends
+ */
+class ShellScriptCompiler
+{
+  public:
+    /**
+     * @param code where the code goes, 4-byte aligned, SHELL_SCRIPT_CODE_MAX
+     *             bytes at most are used
+     */
+    ShellScriptCompiler(const ShellIndex &index, uint8_t *code, uint32_t size)
+        : _index(index), _code(code), _size(size < SHELL_SCRIPT_CODE_MAX ? size : SHELL_SCRIPT_CODE_MAX)
+    {
+    }
+
+    /**
+     * @brief forget the code, for a new script
+     */
+    void reset();
+
+    /**
+     * @brief compile one line, split in place
+     * @return nullptr, or the reason; after a failure the next lines are ignored
+     */
+    const char *line(char *text, uint32_t len);
+
+    /**
+     * @brief after the last line: every block closed
+     */
+    const char *finish();
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] const ShellIndex &index_getter() const
+    {
+        return _index;
+    }
+
+    [[nodiscard]] const uint8_t *code_getter() const
+    {
+        return _code;
+    }
+
+    [[nodiscard]] uint32_t size_getter() const
+    {
+        return _len;
+    }
+
+    [[nodiscard]] uint32_t ops_getter() const
+    {
+        return _ops;
+    }
+
+    [[nodiscard]] uint32_t lines_getter() const
+    {
+        return _line;
+    }
+
+    /**
+     * @brief "line <n>: <reason>[: <detail>]" of the first failure, empty without one
+     */
+    [[nodiscard]] const char *message_getter() const
+    {
+        return _message;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    enum class BlockEnum : uint8_t
+    {
+        REPEAT,
+        IF,
+        ELSE,
+    };
+
+    struct Block
+    {
+        BlockEnum kind;
+        uint32_t at;    // REPEAT: the first op of the body, IF/ELSE: the op to patch
+    };
+
+    const char *keyword(const ShellArgv &args, bool &done);
+    const char *call(const ShellArgv &args, uint32_t first);
+    ShellOp *emit(ShellOpEnum code, uint32_t value);
+    void patch(uint32_t at, uint32_t value);
+    const char *fail(const char *reason, const char *detail = nullptr);
+
+    const ShellIndex &_index;
+    uint8_t *_code;
+    const uint32_t _size;
+    uint32_t _len  = 0;
+    uint32_t _ops  = 0;
+    uint32_t _line = 0;
+    Block _blocks[SHELL_SCRIPT_DEPTH];
+    uint32_t _depth   = 0;
+    const char *_err  = nullptr;
+    char _message[SHELL_REPLY_MAX] = {};
+};
+
+
+
+
+/*-------- 5. store & interpreter --------------------------------------------*/
+
+/**
+ * @brief the scripts in a region of a flash, SHELL_SCRIPT_SLOT bytes each
+ */
+class ShellScriptStore
+{
+  public:
+    /**
+     * @brief counters, for the host benchmark
+     */
+    struct Stats
+    {
+        uint32_t runs;
+        uint32_t ops;       // ops run
+        uint32_t calls;     // commands called
+    };
+
+    /**
+     * @param base first byte of the region, sector aligned
+     * @param size bytes of the region
+     */
+    ShellScriptStore(FlashIntf &flash, uint32_t base, uint32_t size) : _flash(flash), _base(base), _size(size)
+    {
+    }
+
+    /**
+     * @brief write the code of the compiler as the script `name`, replacing
+     *        the one of that name
+     */
+    const char *save(std::string_view name, const ShellScriptCompiler &compiler);
+
+    /**
+     * @brief erase a script
+     */
+    const char *remove(std::string_view name);
+
+    /**
+     * @brief one line per script
+     */
+    void list(ShellEngine &sh);
+
+    /**
+     * @brief run a script on sh, with the command table of sh
+     * @return nullptr, or the reason the script stopped, after a line naming
+     *         the line of the source
+     */
+    const char *run(ShellEngine &sh, std::string_view name);
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t slots_getter() const
+    {
+        return _size / SHELL_SCRIPT_SLOT;
+    }
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    const char *call(ShellEngine &sh, const ShellCommand &cmd, const ShellOp &op, const uint8_t *buf);
+    bool copy(const uint8_t *window, uint32_t addr, void *buf, uint32_t len);
+    bool fetch(uint32_t addr, uint32_t end, uint8_t *buf);
+    bool header(uint32_t slot, ShellScriptHeader &h);
+    bool find(std::string_view name, uint32_t &slot, ShellScriptHeader &h);
+    bool verify(uint32_t slot, const ShellScriptHeader &h);
+    const char *erase(uint32_t slot, uint32_t len);
+    const char *write(uint32_t addr, const uint8_t *data, uint32_t len);
+
+    FlashIntf &_flash;
+    const uint32_t _base;
+    const uint32_t _size;
+    Stats _stats = {};
+};
+
+/**
+ * @brief the sink of `script load`: compile the lines, store the script at "."
+ * @note  one load at a time: the sessions share the compiler, the second
+ *        one is refused until the first reaches its "."
+ */
+class ShellScriptLoader : public ShellLineSink
+{
+  public:
+    ShellScriptLoader(ShellScriptCompiler &compiler, ShellScriptStore &store) : _compiler(compiler), _store(store)
+    {
+    }
+
+    /**
+     * @brief take the next lines of sh as the script `name`
+     */
+    const char *begin(ShellEngine &sh, std::string_view name);
+
+    void line(char *text, uint32_t len) override;
+    const char *end(ShellEngine &sh, bool cut) override;
+
+  private:
+    ShellScriptCompiler &_compiler;
+    ShellScriptStore &_store;
+    char _name[SHELL_SCRIPT_NAME_MAX + 1U] = {};
+    std::atomic<bool> _busy{false};
+};
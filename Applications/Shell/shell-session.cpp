@@ -0,0 +1,167 @@
+/**
+ *******************************************************************************
+ * @file    shell-session.cpp
+ * @brief   one shell on one link: transport, editor, engine, variables and jobs together
+ *******************************************************************************
+ * @attention
+ *
+ * See shell-session.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/20
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "shell-session.hpp"
+#include "shell-args.hpp"
+#include <cstring>
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static ShellSession *const *s_sessions = nullptr;
+static uint32_t s_session_count        = 0;
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+ShellSession::ShellSession(std::string_view name, const ShellIndex &index, ShellTransport &link, ShellJobPort &port)
+    : _name(name), _link(link), _engine(index, link), _editor(_engine, link), _jobs(port, SHELL_SESSION_WORKERS),
+      _workers{{_jobs, index}, {_jobs, index}, {_jobs, index}}
+{
+    static_assert(SHELL_SESSION_WORKERS == 3U, "one entry per worker above");
+    _engine.jobs_setter(&_jobs);
+    _engine.env_setter(&_env);
+    _engine.frame_setter(_frame);
+}
+
+
+bool ShellSession::poll()
+{
+    uint32_t n = _held;
+    if (n != 0U)
+    {
+        memcpy(_rx, _hold, n);
+        _held = 0;
+    }
+    else
+    {
+        n = _link.read(_rx, sizeof(_rx));
+    }
+    if (n == 0U)
+    {
+        return false;
+    }
+    _editor.feed(_rx, n);
+    _link.flush();
+    return true;
+}
+
+
+/**
+ * @note  called from within poll(), by `fg` or a last stage: _rx is in use,
+ *        the keys go to _hold; what does not fit stays in the transport
+ */
+bool ShellSession::hold()
+{
+    bool intr = false;
+    uint8_t buf[32];
+    _link.flush();
+    while (_held < sizeof(_hold))
+    {
+        const uint32_t room = sizeof(_hold) - _held;
+        const uint32_t n    = _link.read(buf, room < sizeof(buf) ? room : sizeof(buf));
+        if (n == 0U)
+        {
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (buf[i] == KEY_INTR)
+            {
+                intr = true;
+            }
+            else
+            {
+                _hold[_held++] = buf[i];
+            }
+        }
+    }
+    return intr;
+}
+
+
+/**
+ * @brief the word of a mode, as `mode` takes it
+ */
+static std::string_view shell_mode_word(ShellModeEnum mode)
+{
+    for (const ShellEnumWord<ShellModeEnum> &w : ShellEnumWords<ShellModeEnum>::list)
+    {
+        if (w.value == mode)
+        {
+            return w.word;
+        }
+    }
+    return "?";
+}
+
+
+void shell_sessions_bind(ShellSession *const *list, uint32_t count)
+{
+    s_sessions      = list;
+    s_session_count = count < SHELL_SESSION_MAX ? count : SHELL_SESSION_MAX;
+}
+
+
+/**
+ * @note  the counters of another session are read while it runs: each is
+ *        one word, a line may mix two moments
+ */
+const char *shell_sessions(ShellEngine &sh)
+{
+    for (uint32_t i = 0; i < s_session_count; i++)
+    {
+        ShellSession &s              = *s_sessions[i];
+        const ShellEngine::Stats &st = s.engine_getter().stats_getter();
+        const char *const self       = &s.engine_getter() == &sh ? "*" : " ";
+        sh.format(FMT("%s%-8s %-4s %8u commands %6u failed %2u vars %u B"), self, s.name_getter(),
+                  shell_mode_word(s.engine_getter().mode_getter()), st.commands, st.failed,
+                  s.env_getter().count_getter(), SHELL_SESSION_BYTES);
+    }
+    return nullptr;
+}
+
+
+/**
+ * @note  a job or a stage runs on a worker's engine, which has no frame:
+ *        machine mode is refused there
+ */
+const char *shell_mode(ShellEngine &sh, std::optional<ShellModeEnum> mode)
+{
+    if (not mode)
+    {
+        sh.line(shell_mode_word(sh.mode_getter()));
+        return nullptr;
+    }
+    return sh.mode_setter(*mode) ? nullptr : "no machine mode here";
+}
+
+
+
+
+/* ------- registration ------------------------------------------------------*/
+
+SHELL_COMMAND(sessions, shell_sessions, "the shells on the links, * this one");
+SHELL_COMMAND(mode, shell_mode, "replies as text or CBOR records, this session");
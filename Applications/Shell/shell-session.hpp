@@ -0,0 +1,216 @@
+/**
+ *******************************************************************************
+ * @file    shell-session.hpp
+ * @brief   one shell on one link: transport, editor, engine, variables and jobs together
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap: the owner gives the transport and the job port
+ * and runs the session on a task of its own, one task per session, plus
+ * SHELL_SESSION_WORKERS worker tasks. shell-cdc.cpp does it on the shell
+ * CDC port, Tools/shell-host/shell-session-bench.cpp with two sessions on
+ * memory transports and threads.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Everything a session changes is in its ShellSession: the line being
+ * edited and the history, the variables, the line being assembled and the
+ * reply being formatted, the mode and the frame of machine mode, the job
+ * table, the keys held during `fg`. The
+ * sessions share the command table, which is constant, and nothing else
+ * of the shell: they run their commands side by side without a lock. A
+ * command touching something of the board takes it for itself (`top`,
+ * `script load`) or relies on the driver's own locking.
+ *
+ *      transport A --read--> ShellSession A: editor -> engine -> jobs A, workers A
+ *                 <--write-- (echo, replies)     |
+ *                                                +--> ShellIndex (shared, constant)
+ *      transport B --read--> ShellSession B: editor -> engine -> jobs B, workers B
+ *
+ * The memory of a session is sizeof(ShellSession), SHELL_SESSION_BYTES
+ * below, plus the stacks of its tasks; `sessions` lists them with their
+ * counters.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/20
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "shell-args.hpp"
+#include "shell-editor.hpp"
+#include "shell-engine.hpp"
+#include "shell-env.hpp"
+#include "shell-jobs.hpp"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_SESSION_RX      = 256U;    // bytes read from the transport at a time
+constexpr uint32_t SHELL_SESSION_WORKERS = 3U;      // worker tasks of a session
+constexpr uint32_t SHELL_SESSION_MAX     = 4U;      // sessions `sessions` can list
+
+
+
+
+template <>
+struct ShellEnumWords<ShellModeEnum>
+{
+    static constexpr std::string_view name = "text|cbor";
+    static constexpr ShellEnumWord<ShellModeEnum> list[] = {
+        {"text", ShellModeEnum::TEXT},
+        {"cbor", ShellModeEnum::CBOR},
+    };
+};
+
+
+
+
+/*-------- 3. transport ------------------------------------------------------*/
+
+/**
+ * @brief the link of a session: bytes in, reply lines and echo out
+ * @note  write() may wait for room, it is called by the session's task and
+ *        by its `fg`; the bulk channel of ShellOutput is optional
+ */
+class ShellTransport : public ShellOutput
+{
+  public:
+    /**
+     * @brief what arrived, without waiting
+     * @return bytes copied, 0 when nothing did
+     */
+    virtual uint32_t read(uint8_t *buf, uint32_t len) = 0;
+
+    /**
+     * @brief the session handled what it read: send what write() gathered
+     */
+    virtual void flush()
+    {
+    }
+};
+
+
+
+
+/*-------- 4. session --------------------------------------------------------*/
+
+/**
+ * @brief the whole state of one shell
+ */
+class ShellSession
+{
+  public:
+    /**
+     * @param name for `sessions`, static
+     * @param port the tasks of this session, wait() of its task calls hold()
+     */
+    ShellSession(std::string_view name, const ShellIndex &index, ShellTransport &link, ShellJobPort &port);
+
+    ShellSession(const ShellSession &)            = delete;
+    ShellSession &operator=(const ShellSession &) = delete;
+
+    /**
+     * @brief run what arrived: held keys first, then the transport
+     * @return false when nothing did, the task may sleep until more arrives
+     */
+    bool poll();
+
+    /**
+     * @brief read the transport while the session's task waits on a job:
+     *        keys are kept for poll()
+     * @return a ^C arrived
+     */
+    bool hold();
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] std::string_view name_getter() const
+    {
+        return _name;
+    }
+
+    [[nodiscard]] ShellEngine &engine_getter()
+    {
+        return _engine;
+    }
+
+    [[nodiscard]] ShellEditor &editor_getter()
+    {
+        return _editor;
+    }
+
+    [[nodiscard]] ShellEnv &env_getter()
+    {
+        return _env;
+    }
+
+    [[nodiscard]] ShellJobs &jobs_getter()
+    {
+        return _jobs;
+    }
+
+    /**
+     * @brief the worker a worker task runs, i < SHELL_SESSION_WORKERS
+     */
+    [[nodiscard]] ShellWorker &worker_getter(uint32_t i)
+    {
+        return _workers[i];
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    static constexpr uint8_t KEY_INTR = 0x03U;  // ^C
+
+    const std::string_view _name;
+    ShellTransport &_link;
+    ShellEnv _env;
+    ShellEngine _engine;
+    ShellEditor _editor;
+    ShellJobs _jobs;
+    ShellWorker _workers[SHELL_SESSION_WORKERS];
+    uint8_t _rx[SHELL_SESSION_RX];
+    uint8_t _hold[SHELL_SESSION_RX];    // keys that arrived during `fg`
+    uint32_t _held = 0;
+    uint8_t _frame[SHELL_FRAME_MAX];    // of the engine's machine mode
+};
+
+constexpr uint32_t SHELL_SESSION_BYTES = sizeof(ShellSession);
+
+/**
+ * @brief the sessions `sessions` lists, at most SHELL_SESSION_MAX
+ */
+void shell_sessions_bind(ShellSession *const *list, uint32_t count);
+
+
+
+
+/*-------- 5. commands -------------------------------------------------------*/
+
+/**
+ * @brief one line per session: name, mode, commands, failures, variables, bytes
+ */
+const char *shell_sessions(ShellEngine &sh);
+
+/**
+ * @brief "mode" prints the mode of this session, "mode cbor" or "mode text"
+ *        sets it for the lines that follow
+ */
+const char *shell_mode(ShellEngine &sh, std::optional<ShellModeEnum> mode);
@@ -0,0 +1,417 @@
+/**
+ *******************************************************************************
+ * @file    shell-table.hpp
+ * @brief   the command table of the shell, indexed by a perfect hash
+ *******************************************************************************
+ * @attention
+ *
+ * No HAL, no RTOS, no heap: the table is a constexpr object in flash, the
+ * same header builds on the host (Tools/shell-host, Tools/app-host).
+ *
+ *******************************************************************************
+ * @note
+ *
+ * A ShellTable is built from an array of ShellCommand by the compiler. It
+ * tries seeds until shell_hash() sends every command name to its own slot of
+ * a power of two array, at least four times larger than the table, so a
+ * seed is found in a few tries. A lookup is then one hash of the word, one
+ * slot read and one comparison with the only candidate:
+ *
+ *      "echo" --shell_hash(seed)--> slot[h & mask] --> cmds[i] --> == "echo" ?
+ *
+ * Two commands with the same name always collide, the table does not build:
+ *
+ *      static constexpr ShellTable s_table(s_cmds);
+ *      static_assert(s_table.valid(), "duplicate command name");
+ *
+ * The compiler also sorts the names for completion (shell-complete.hpp): the
+ * words starting with what was typed are one range of the sorted list,
+ * found by two binary searches, and their longest common prefix is the one
+ * of the first and the last word of the range.
+ *
+ * The firmware's commands are not one array: each module registers its
+ * own with SHELL_COMMAND() (shell-args.hpp, app-intf.h) and the linker
+ * lays the descriptors out sorted by name, the names alongside. No
+ * compiler sees them all, so the first call of shell_registered_index(),
+ * at boot, runs the same seed search over them: the descriptors stay in
+ * flash, only the slots are in RAM, shell_slots(SHELL_REGISTERED_MAX)
+ * bytes. Beyond SHELL_REGISTERED_MAX commands, or without a seed, the
+ * index falls back to a binary search of the names, in place.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/11
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "../app-intf.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+class ShellEngine;
+struct ShellArgv;
+struct ShellPacked;
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t SHELL_SEED_TRIES     = 4096U;  // budget of the seed search
+constexpr uint8_t SHELL_SLOT_FREE       = 0xFFU;
+constexpr uint32_t SHELL_REGISTERED_MAX = 64U;    // registered commands the boot time hash takes
+
+/**
+ * @brief a sorted word list, ASCII case folded: command names, argument values
+ */
+struct ShellWords
+{
+    const std::string_view *list = nullptr;
+    uint32_t count               = 0;
+};
+
+/**
+ * @brief the words of a ShellWords starting with a prefix, [first, last)
+ */
+struct ShellRange
+{
+    uint32_t first;
+    uint32_t last;
+};
+
+/**
+ * @brief run a command
+ * @param args the words of the line, args.argv[0] is the command name
+ * @return nullptr on success, else the reason of the failure (a literal)
+ */
+using ShellHandler = const char *(*)(ShellEngine &sh, const ShellArgv &args);
+
+/**
+ * @brief parse the arguments once, into bytes a compiled script keeps (shell-script.hpp)
+ * @param bad the argument that did not parse, from 0
+ * @return nullptr, or the reason
+ */
+using ShellPacker = const char *(*)(const ShellArgv &args, ShellPacked &out, uint32_t &bad);
+
+/**
+ * @brief run the command on the bytes of its ShellPacker
+ */
+using ShellRunner = const char *(*)(ShellEngine &sh, const uint8_t *packed);
+
+/**
+ * @brief one command of the table
+ * @note  shell_command() in shell-args.hpp fills params from the handler's
+ *        declaration; a handler taking the ShellArgv itself leaves them empty
+ */
+struct ShellCommand
+{
+    std::string_view name;
+    ShellHandler handler;
+    std::string_view help;                      // one line, shown by `help`
+    const std::string_view *params = nullptr;   // type of each argument
+    const ShellWords *values       = nullptr;   // the words each argument takes, if a list
+    uint8_t paramCount             = 0;
+    uint8_t required               = 0;         // the others are optional, at the end
+    ShellPacker pack               = nullptr;   // typed handlers only
+    ShellRunner run                = nullptr;
+};
+
+
+
+
+/*-------- 3. function implement ---------------------------------------------*/
+
+constexpr char shell_fold(char c)
+{
+    return c >= 'A' and c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+/**
+ * @brief a name the linker sorts as ShellWords do: one that folding leaves alone
+ */
+constexpr bool shell_registrable(std::string_view name)
+{
+    for (const char c : name)
+    {
+        if (shell_fold(c) != c)
+        {
+            return false;
+        }
+    }
+    return not name.empty();
+}
+
+/**
+ * @brief the order of ShellWords: bytes compared case folded, a prefix first
+ */
+constexpr bool shell_word_less(std::string_view a, std::string_view b)
+{
+    for (size_t i = 0; i < a.size() and i < b.size(); i++)
+    {
+        if (shell_fold(a[i]) != shell_fold(b[i]))
+        {
+            return shell_fold(a[i]) < shell_fold(b[i]);
+        }
+    }
+    return a.size() < b.size();
+}
+
+/**
+ * @brief -1, 0 or 1 as the start of word is below, equal to or above prefix
+ */
+constexpr int shell_prefix_compare(std::string_view word, std::string_view prefix)
+{
+    for (size_t i = 0; i < prefix.size(); i++)
+    {
+        if (i == word.size())
+        {
+            return -1;
+        }
+        if (shell_fold(word[i]) != shell_fold(prefix[i]))
+        {
+            return shell_fold(word[i]) < shell_fold(prefix[i]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief the words starting with prefix: two binary searches
+ */
+constexpr ShellRange shell_words_range(const ShellWords &w, std::string_view prefix)
+{
+    uint32_t lo = 0;
+    uint32_t hi = w.count;
+    while (lo < hi)
+    {
+        const uint32_t mid = (lo + hi) / 2U;
+        if (shell_prefix_compare(w.list[mid], prefix) < 0)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    const uint32_t first = lo;
+    hi                   = w.count;
+    while (lo < hi)
+    {
+        const uint32_t mid = (lo + hi) / 2U;
+        if (shell_prefix_compare(w.list[mid], prefix) <= 0)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return {first, lo};
+}
+
+/**
+ * @brief sort n words in place, insertion sort: for the compiler, n is small
+ */
+constexpr void shell_words_sort(std::string_view *w, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        const std::string_view v = w[i];
+        size_t j                 = i;
+        for (; j != 0U and shell_word_less(v, w[j - 1U]); j--)
+        {
+            w[j] = w[j - 1U];
+        }
+        w[j] = v;
+    }
+}
+
+/**
+ * @brief seeded FNV-1a with a final mix, the same at compile time and at run time
+ */
+constexpr uint32_t shell_hash(std::string_view s, uint32_t seed)
+{
+    uint32_t h = 2166136261U ^ (seed * 0x9E3779B9U);
+    for (const char c : s)
+    {
+        h = (h ^ static_cast<uint8_t>(c)) * 16777619U;
+    }
+    h ^= h >> 16;
+    h *= 0x7FEB352DU;
+    h ^= h >> 15;
+    return h;
+}
+
+/**
+ * @brief slots of a table of n commands: a power of two, at least 4 n
+ */
+constexpr uint32_t shell_slots(size_t n)
+{
+    uint32_t s = 8U;
+    while (s < 4U * n)
+    {
+        s <<= 1;
+    }
+    return s;
+}
+
+/**
+ * @brief give each command its own slot for one seed
+ * @return false on a collision, slot is then left half filled
+ */
+constexpr bool shell_place(const ShellCommand *cmds, uint32_t n, uint32_t seed, uint8_t *slot, uint32_t slots)
+{
+    for (uint32_t i = 0; i < slots; i++)
+    {
+        slot[i] = SHELL_SLOT_FREE;
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint8_t &s = slot[shell_hash(cmds[i].name, seed) & (slots - 1U)];
+        if (s != SHELL_SLOT_FREE)
+        {
+            return false;
+        }
+        s = static_cast<uint8_t>(i);
+    }
+    return true;
+}
+
+/**
+ * @brief the first seed that places every command, by the compiler or at boot
+ * @return 0 when none within SHELL_SEED_TRIES: two names are the same
+ */
+constexpr uint32_t shell_seed(const ShellCommand *cmds, uint32_t n, uint8_t *slot, uint32_t slots)
+{
+    for (uint32_t seed = 1; seed < SHELL_SEED_TRIES; seed++)
+    {
+        if (shell_place(cmds, n, seed, slot, slots))
+        {
+            return seed;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief what the engine keeps of a ShellTable, or of the registered commands, whatever their number
+ */
+struct ShellIndex
+{
+    const ShellCommand *cmds;
+    const uint8_t *slot;    // nullptr: cmds sorted as names, no hash
+    uint32_t count;
+    uint32_t mask;
+    uint32_t seed;
+    ShellWords names;       // the command names, sorted
+
+    /**
+     * @brief the command called `name`, nullptr when there is none
+     */
+    [[nodiscard]] const ShellCommand *find(std::string_view name) const
+    {
+        if (slot == nullptr)
+        {
+            uint32_t lo = 0;
+            uint32_t hi = count;
+            while (lo < hi)
+            {
+                const uint32_t mid = (lo + hi) / 2U;
+                if (shell_word_less(names.list[mid], name))
+                {
+                    lo = mid + 1U;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            return lo < count and cmds[lo].name == name ? &cmds[lo] : nullptr;
+        }
+        const uint8_t i = slot[shell_hash(name, seed) & mask];
+        return i != SHELL_SLOT_FREE and cmds[i].name == name ? &cmds[i] : nullptr;
+    }
+};
+
+APP_TABLE_DECLARE(shell_cmds, ShellCommand);
+APP_TABLE_DECLARE(shell_names, std::string_view);
+
+/**
+ * @brief the commands registered with SHELL_COMMAND(), where the linker put them
+ * @note  the tables are sorted by name and parallel, the i-th name is the one of the i-th command.
+ *        The first call hashes them, before the scheduler starts: shell-cmds.cpp keeps the index
+ *        in a static, built before main()
+ */
+inline ShellIndex shell_registered_index()
+{
+    static uint8_t s_slot[shell_slots(SHELL_REGISTERED_MAX)];
+    static uint32_t s_seed = 0;
+    static bool s_built    = false;
+
+    const auto cmds      = APP_TABLE(shell_cmds);
+    const auto names     = APP_TABLE(shell_names);
+    const uint32_t slots = shell_slots(cmds.count());
+    if (not s_built)
+    {
+        s_seed  = cmds.count() <= SHELL_REGISTERED_MAX ? shell_seed(cmds.begin(), cmds.count(), s_slot, slots) : 0U;
+        s_built = true;
+    }
+    return {cmds.begin(), s_seed != 0U ? s_slot : nullptr, cmds.count(), slots - 1U, s_seed,
+            {names.begin(), names.count()}};
+}
+
+/**
+ * @brief a command array and its perfect hash, built by the compiler
+ */
+template <size_t N>
+class ShellTable
+{
+  public:
+    static_assert(N != 0U and N < SHELL_SLOT_FREE, "a table holds 1 to 254 commands");
+    static constexpr uint32_t SLOTS = shell_slots(N);
+
+    /**
+     * @param cmds an array with static storage, the table points into it
+     */
+    constexpr explicit ShellTable(const ShellCommand (&cmds)[N]) : _cmds(cmds)
+    {
+        for (uint32_t i = 0; i < N; i++)
+        {
+            _names[i] = cmds[i].name;
+        }
+        shell_words_sort(_names, N);
+        _seed = shell_seed(cmds, static_cast<uint32_t>(N), _slot, SLOTS);
+    }
+
+    /**
+     * @brief a seed was found: names are unique and each has its slot
+     */
+    [[nodiscard]] constexpr bool valid() const
+    {
+        return _seed != 0U;
+    }
+
+    [[nodiscard]] constexpr ShellIndex index() const
+    {
+        return {_cmds, _slot, static_cast<uint32_t>(N), SLOTS - 1U, _seed, {_names, static_cast<uint32_t>(N)}};
+    }
+
+  private:
+    const ShellCommand *_cmds;
+    std::string_view _names[N] = {};
+    uint8_t _slot[SLOTS]       = {};
+    uint32_t _seed             = 0;
+};
@@ -0,0 +1,488 @@
+/**
+ *******************************************************************************
+ * @file    sector-cache.cpp
+ * @brief   write-back cache of erase sectors between 512-byte blocks and NOR
+ *******************************************************************************
+ * @attention
+ *
+ * Host buildable, see sector-cache.hpp.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Eviction picks the least recently used clean line first: dirty lines are
+ * kept as long as possible so that later blocks of the same sector still
+ * merge, and a read stream does not push out data waiting to be written.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/6
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "sector-cache.hpp"
+#include <cstring>
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define NO_SECTOR           0xFFFFFFFFU
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief true when every byte of the range is erased
+ */
+static bool is_blank(const uint8_t *p, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (p[i] != 0xFFU)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief true when programming `next` over `prev` needs an erase first
+ */
+static bool needs_erase(const uint8_t *prev, const uint8_t *next, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if ((next[i] & static_cast<uint8_t>(~prev[i])) != 0U)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief bind to a region of the flash
+ */
+FlashErrCode SectorCache::init(uint32_t base, uint32_t size)
+{
+    const FlashGeometry &g = _flash.geometry_getter();
+    if (not _flash.enable_getter())
+    {
+        return FlashErrCode::FLASH_NOT_EN;
+    }
+    if (g.sectorSize % BLOCK_SIZE != 0U or g.sectorSize / BLOCK_SIZE > 32U or g.pageSize > MAX_PAGE or
+        g.pageSize == 0U or g.sectorSize % g.pageSize != 0U or g.sectorSize / g.pageSize > 32U or
+        base % g.sectorSize != 0U)
+    {
+        return FlashErrCode::FLASH_NOT_ALIGNED;
+    }
+    if (base >= g.size)
+    {
+        return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+    }
+
+    _sectorSize      = g.sectorSize;
+    _pageSize        = g.pageSize;
+    _blocksPerSector = g.sectorSize / BLOCK_SIZE;
+    _fullMask        = _blocksPerSector == 32U ? 0xFFFFFFFFU : ((1UL << _blocksPerSector) - 1U);
+    _base            = base;
+    _size            = (size == 0U or size > g.size - base) ? g.size - base : size;
+    _size -= _size % _sectorSize;
+    _lines = _memSize / _sectorSize;
+    _lines = _lines > MAX_LINES ? MAX_LINES : _lines;
+    if (_lines == 0U)
+    {
+        return FlashErrCode::FLASH_MEM_ALLOC_FAILED;
+    }
+    invalidate();
+    _stats = {};
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief forget every line
+ */
+void SectorCache::invalidate()
+{
+    for (Line &l : _line)
+    {
+        l = {};
+    }
+    _clock          = 0;
+    _lastReadSector = NO_SECTOR;
+    _prefetchSector = NO_SECTOR;
+}
+
+
+/**
+ * @brief line holding a sector, nullptr if not cached
+ */
+SectorCache::Line *SectorCache::find(uint32_t sector)
+{
+    for (uint32_t i = 0; i < _lines; i++)
+    {
+        if (_line[i].used and _line[i].sector == sector)
+        {
+            return &_line[i];
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief get the line of a sector, making room if needed
+ * @param forRead only evict clean lines, fail with nullptr when all are dirty
+ */
+FlashErrCode SectorCache::take(uint32_t sector, bool forRead, Line **out)
+{
+    Line *l = find(sector);
+    if (l == nullptr)
+    {
+        Line *clean = nullptr;
+        Line *any   = nullptr;
+        for (uint32_t i = 0; i < _lines and l == nullptr; i++)
+        {
+            Line &c = _line[i];
+            if (not c.used)
+            {
+                l = &c;
+            }
+            else if (c.dirty == 0U)
+            {
+                clean = (clean == nullptr or c.stamp < clean->stamp) ? &c : clean;
+            }
+            else
+            {
+                any = (any == nullptr or c.stamp < any->stamp) ? &c : any;
+            }
+        }
+        l = l != nullptr ? l : clean;
+        if (l == nullptr)
+        {
+            if (forRead or any == nullptr)
+            {
+                *out = nullptr;
+                return FlashErrCode::FLASH_SUCCESS;
+            }
+            const FlashErrCode err = write_back(*any);
+            if (err != FlashErrCode::FLASH_SUCCESS)
+            {
+                return err;
+            }
+            _stats.evictions++;
+            l = any;
+        }
+        *l = {sector, 0U, 0U, 0U, true};
+    }
+    l->stamp = ++_clock;
+    *out     = l;
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief read the blocks of a line that are not valid, in runs
+ */
+FlashErrCode SectorCache::fill(Line &l)
+{
+    uint8_t *data       = data_of(l);
+    const uint32_t addr = _base + l.sector * _sectorSize;
+    uint32_t b          = 0;
+
+    while (b < _blocksPerSector)
+    {
+        if ((l.valid & (1UL << b)) != 0U)
+        {
+            b++;
+            continue;
+        }
+        uint32_t e = b;
+        while (e < _blocksPerSector and (l.valid & (1UL << e)) == 0U)
+        {
+            e++;
+        }
+        const FlashErrCode err = _flash.read(addr + b * BLOCK_SIZE, data + b * BLOCK_SIZE, (e - b) * BLOCK_SIZE);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        b = e;
+    }
+    l.valid = _fullMask;
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief write a dirty line back, with an erase only when bits must rise
+ */
+FlashErrCode SectorCache::write_back(Line &l)
+{
+    if (l.dirty == 0U)
+    {
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+    FlashErrCode err = fill(l);
+    if (err != FlashErrCode::FLASH_SUCCESS)
+    {
+        return err;
+    }
+
+    const uint8_t *data        = data_of(l);
+    const uint32_t addr        = _base + l.sector * _sectorSize;
+    const uint32_t pagesPerBlk = BLOCK_SIZE / _pageSize;
+    const uint32_t pages       = _sectorSize / _pageSize;
+    uint32_t changed           = 0;
+    uint32_t checked           = 0;
+    bool erase                 = false;
+
+    /* compare the pages under the dirty blocks with the array */
+    for (uint32_t p = 0; p < pages; p++)
+    {
+        if ((l.dirty & (1UL << (p / pagesPerBlk))) == 0U)
+        {
+            continue;
+        }
+        checked++;
+        err = _flash.read(addr + p * _pageSize, _page, _pageSize);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        if (std::memcmp(_page, data + p * _pageSize, _pageSize) == 0)
+        {
+            continue;
+        }
+        changed |= 1UL << p;
+        erase = erase or needs_erase(_page, data + p * _pageSize, _pageSize);
+    }
+
+    if (erase)
+    {
+        err = _flash.erase_sector(addr);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        _stats.erases++;
+        changed = 0;
+        for (uint32_t p = 0; p < pages; p++)
+        {
+            changed |= is_blank(data + p * _pageSize, _pageSize) ? 0U : (1UL << p);
+        }
+    }
+    else
+    {
+        _stats.eraseSkips++;
+    }
+
+    for (uint32_t p = 0; p < pages; p++)
+    {
+        if ((changed & (1UL << p)) == 0U)
+        {
+            continue;
+        }
+        err = _flash.program(addr + p * _pageSize, data + p * _pageSize, _pageSize);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        _stats.programs++;
+    }
+
+    if (not erase)
+    {
+        uint32_t n = 0;
+        for (uint32_t m = changed; m != 0U; m &= m - 1U)
+        {
+            n++;
+        }
+        _stats.pageSkips += checked - n;
+    }
+    l.dirty = 0;
+    _stats.flushes++;
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief read blocks, through the lines
+ */
+FlashErrCode SectorCache::read(uint32_t lba, uint8_t *buf, uint32_t count)
+{
+    if (lba >= block_count() or count > block_count() - lba)
+    {
+        return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+    }
+    _stats.readBlocks += count;
+
+    while (count != 0U)
+    {
+        const uint32_t sector = lba / _blocksPerSector;
+        const uint32_t b      = lba % _blocksPerSector;
+        const uint32_t n      = count < _blocksPerSector - b ? count : _blocksPerSector - b;
+        const uint32_t mask   = ((n == 32U) ? 0xFFFFFFFFU : ((1UL << n) - 1U)) << b;
+        FlashErrCode err      = FlashErrCode::FLASH_SUCCESS;
+
+        Line *l = find(sector);
+        if (l != nullptr and (l->valid & mask) == mask)
+        {
+            l->stamp = ++_clock;
+            _stats.hits += n;
+        }
+        else
+        {
+            if (l == nullptr)
+            {
+                _stats.misses++;
+            }
+            err = take(sector, true, &l);
+            if (err == FlashErrCode::FLASH_SUCCESS and l != nullptr)
+            {
+                err = fill(*l);
+            }
+        }
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+
+        if (l != nullptr)
+        {
+            std::memcpy(buf, data_of(*l) + b * BLOCK_SIZE, n * BLOCK_SIZE);
+        }
+        else
+        {
+            /* every line holds dirty data: read around the cache */
+            err = _flash.read(_base + lba * BLOCK_SIZE, buf, n * BLOCK_SIZE);
+            if (err != FlashErrCode::FLASH_SUCCESS)
+            {
+                return err;
+            }
+        }
+
+        if (sector != _lastReadSector)
+        {
+            const bool sequential = sector == _lastReadSector + 1U;
+            _prefetchSector       = (sequential and (sector + 1U) * _sectorSize < _size) ? sector + 1U : NO_SECTOR;
+            _lastReadSector       = sector;
+        }
+
+        lba += n;
+        buf += n * BLOCK_SIZE;
+        count -= n;
+    }
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief write blocks into the lines
+ */
+FlashErrCode SectorCache::write(uint32_t lba, const uint8_t *buf, uint32_t count)
+{
+    if (lba >= block_count() or count > block_count() - lba)
+    {
+        return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+    }
+    _stats.writeBlocks += count;
+
+    while (count != 0U)
+    {
+        const uint32_t sector = lba / _blocksPerSector;
+        const uint32_t b      = lba % _blocksPerSector;
+        const uint32_t n      = count < _blocksPerSector - b ? count : _blocksPerSector - b;
+        const uint32_t mask   = ((n == 32U) ? 0xFFFFFFFFU : ((1UL << n) - 1U)) << b;
+
+        Line *l                = nullptr;
+        const FlashErrCode err = take(sector, false, &l);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        std::memcpy(data_of(*l) + b * BLOCK_SIZE, buf, n * BLOCK_SIZE);
+        l->valid |= mask;
+        l->dirty |= mask;
+
+        lba += n;
+        buf += n * BLOCK_SIZE;
+        count -= n;
+    }
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief write back every dirty line
+ */
+FlashErrCode SectorCache::flush()
+{
+    FlashErrCode res = FlashErrCode::FLASH_SUCCESS;
+    for (uint32_t i = 0; i < _lines; i++)
+    {
+        if (_line[i].used and _line[i].dirty != 0U)
+        {
+            const FlashErrCode err = write_back(_line[i]);
+            res                    = res == FlashErrCode::FLASH_SUCCESS ? err : res;
+        }
+    }
+    return res;
+}
+
+
+/**
+ * @brief load the predicted next sector into a clean line
+ */
+bool SectorCache::prefetch()
+{
+    const uint32_t sector = _prefetchSector;
+    _prefetchSector       = NO_SECTOR;
+    if (sector == NO_SECTOR or find(sector) != nullptr)
+    {
+        return false;
+    }
+    Line *l = nullptr;
+    if (take(sector, true, &l) != FlashErrCode::FLASH_SUCCESS or l == nullptr)
+    {
+        return false;
+    }
+    if (fill(*l) != FlashErrCode::FLASH_SUCCESS)
+    {
+        l->used = false;
+        return false;
+    }
+    l->stamp = 0; // first to go if the reader never comes
+    _stats.prefetches++;
+    return true;
+}
+
+
+/**
+ * @brief true when some line waits for a write back
+ */
+bool SectorCache::dirty() const
+{
+    for (uint32_t i = 0; i < _lines; i++)
+    {
+        if (_line[i].used and _line[i].dirty != 0U)
+        {
+            return true;
+        }
+    }
+    return false;
+}
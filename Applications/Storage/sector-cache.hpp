@@ -0,0 +1,197 @@
+/**
+ *******************************************************************************
+ * @file    sector-cache.hpp
+ * @brief   write-back cache of erase sectors between 512-byte blocks and NOR
+ *******************************************************************************
+ * @attention
+ *
+ * Pure C++ on top of FlashIntf, no HAL and no RTOS: the same code runs on the
+ * host against FlashSimImpl (Tools/msc-sim). The caller serialises the calls,
+ * on the target everything runs in the storage task.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * A host writes 512-byte blocks, the flash erases 4 KB sectors and programs
+ * 256-byte pages. Writing through would cost one erase per block, eight per
+ * sector for a sequential stream, and wear the part eight times faster.
+ *
+ * Each line of the cache holds one whole sector with two block masks:
+ *
+ *      valid   the block in the line is the current content
+ *      dirty   the block was written by the host and not flushed yet
+ *
+ * Writes only copy into the line, without reading the flash first, so blocks
+ * written one at a time merge in RAM. A line is written back when it is
+ * evicted, on flush() (SYNCHRONIZE CACHE, eject, idle timer):
+ *
+ *      1. blocks that are not valid are read from the flash
+ *      2. every page under a dirty block is compared with the flash: when the
+ *         new data only clears bits, the sector needs no erase
+ *      3. either the changed pages are programmed in place, or the sector is
+ *         erased once and every page that is not blank is programmed
+ *
+ * Reads are served from the lines, a miss loads the whole sector (read-ahead
+ * inside the sector) and a sequential stream also marks the next sector for
+ * prefetch(), which the owner calls when the bus is busy with other work.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/6
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "../../Drivers/Peripheral/Flash/flash-intf.hpp"
+#include <cstdint>
+
+
+
+
+/*-------- 2. cache ----------------------------------------------------------*/
+
+/**
+ * @brief sector cache, lines live in memory given by the owner
+ */
+class SectorCache
+{
+  public:
+    static constexpr uint32_t BLOCK_SIZE = 512;
+    static constexpr uint32_t MAX_LINES  = 32;
+    static constexpr uint32_t MAX_PAGE   = 256;
+
+    /**
+     * @brief counters, for the shell and the benchmarks
+     */
+    struct Stats
+    {
+        uint64_t readBlocks;
+        uint64_t writeBlocks;
+        uint64_t hits;          // blocks served from a line
+        uint64_t misses;        // sectors loaded for a read
+        uint64_t prefetches;    // sectors loaded by prefetch()
+        uint64_t evictions;     // dirty lines written back to make room
+        uint64_t flushes;       // dirty lines written back
+        uint64_t erases;
+        uint64_t programs;
+        uint64_t eraseSkips;    // flushes done by programming only
+        uint64_t pageSkips;     // pages left alone, identical in the flash
+    };
+
+    /**
+     * @param flash   enabled flash driver
+     * @param mem     line storage, a multiple of the sector size, 4-byte aligned
+     * @param memSize bytes at mem
+     */
+    SectorCache(FlashIntf &flash, uint8_t *mem, uint32_t memSize) : _flash(flash), _mem(mem), _memSize(memSize)
+    {
+    }
+
+    /**
+     * @brief bind to a region of the flash, sector aligned
+     * @param base first byte of the region
+     * @param size bytes, 0 for the rest of the device
+     */
+    [[nodiscard]] FlashErrCode init(uint32_t base = 0, uint32_t size = 0);
+
+    /**
+     * @brief read blocks
+     */
+    [[nodiscard]] FlashErrCode read(uint32_t lba, uint8_t *buf, uint32_t count);
+
+    /**
+     * @brief write blocks into the cache, the flash is updated later
+     */
+    [[nodiscard]] FlashErrCode write(uint32_t lba, const uint8_t *buf, uint32_t count);
+
+    /**
+     * @brief write back every dirty line, lines stay cached clean
+     */
+    [[nodiscard]] FlashErrCode flush();
+
+    /**
+     * @brief load the sector a sequential reader will ask for next
+     * @return true when a sector was loaded
+     */
+    bool prefetch();
+
+    /**
+     * @brief forget every line, dirty data is lost
+     */
+    void invalidate();
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t block_count() const
+    {
+        return _size / BLOCK_SIZE;
+    }
+
+    [[nodiscard]] bool dirty() const;
+
+    [[nodiscard]] uint32_t lines_getter() const
+    {
+        return _lines;
+    }
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    void stats_reset()
+    {
+        _stats = {};
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    struct Line
+    {
+        uint32_t sector; // index inside the region
+        uint32_t valid;  // block mask
+        uint32_t dirty;  // block mask
+        uint32_t stamp;  // last use, for LRU
+        bool used;
+    };
+
+    [[nodiscard]] uint8_t *data_of(const Line &l) const
+    {
+        return _mem + static_cast<uint32_t>(&l - _line) * _sectorSize;
+    }
+
+    Line *find(uint32_t sector);
+    [[nodiscard]] FlashErrCode take(uint32_t sector, bool forRead, Line **out);
+    [[nodiscard]] FlashErrCode fill(Line &l);
+    [[nodiscard]] FlashErrCode write_back(Line &l);
+
+    FlashIntf &_flash;
+    uint8_t *_mem;
+    uint32_t _memSize;
+
+    Line _line[MAX_LINES] = {};
+    uint32_t _lines       = 0;
+    uint32_t _base        = 0;
+    uint32_t _size        = 0;
+    uint32_t _sectorSize  = 0;
+    uint32_t _pageSize    = 0;
+    uint32_t _blocksPerSector = 0;
+    uint32_t _fullMask    = 0;
+    uint32_t _clock       = 0;
+
+    uint32_t _lastReadSector = 0xFFFFFFFFU;
+    uint32_t _prefetchSector = 0xFFFFFFFFU;
+
+    uint8_t _page[MAX_PAGE] = {};
+    Stats _stats            = {};
+};
@@ -0,0 +1,127 @@
+/**
+ *******************************************************************************
+ * @file    storage-intf.h
+ * @brief   the interface of the USB mass storage backend
+ *******************************************************************************
+ * @attention
+ *
+ * The storage task owns the OSPI flash and the sector cache. Every function
+ * but storage_notify() and the getters runs in that task: the MSC transport
+ * (USBD_MSC_Process) is called from it and calls back storage_read(),
+ * storage_write() and storage_sync() through USB_DEVICE/App/usbd_storage_if.c.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The flash is exported as one LUN of 512-byte blocks, all of it but the
+ * top STORAGE_RESERVED_TOP bytes, where the shell keeps its compiled
+ * scripts (shell-script.hpp). Dirty sectors
+ * are written back on SYNCHRONIZE CACHE, on eject, when a line is needed for
+ * other data, and after STORAGE_FLUSH_MS without a write from the host.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/6
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define STORAGE_BLOCK_SIZE      512U
+#define STORAGE_LINES           16U         // cached sectors, in AXI SRAM
+#define STORAGE_LINE_SIZE       4096U       // largest sector the cache accepts
+#define STORAGE_FLUSH_MS        250U        // write back after this much write silence
+#define STORAGE_RESERVED_TOP    0x40000U    // end of the flash kept out of the LUN, for the shell
+
+
+
+
+/*-------- 3. typedef --------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief counters of the cache, for the shell
+ */
+typedef struct
+{
+    uint32_t readBlocks;
+    uint32_t writeBlocks;
+    uint32_t hits;          // blocks served from the cache
+    uint32_t misses;        // sectors loaded for a read
+    uint32_t prefetches;    // sectors loaded ahead of a sequential reader
+    uint32_t flushes;       // dirty sectors written back
+    uint32_t erases;
+    uint32_t programs;
+    uint32_t eraseSkips;    // write backs done without an erase
+} StorageStatsTypeDef;
+
+
+
+
+/*-------- 4. function prototypes --------------------------------------------*/
+
+/**
+ * @brief create the storage task, it brings up the flash and the cache
+ */
+void storage_init(void);
+
+/**
+ * @brief the medium can be accessed
+ * @return 1 when ready, 0 while starting or when the flash is missing
+ */
+uint8_t storage_ready(void);
+
+/**
+ * @brief number of 512-byte blocks
+ */
+uint32_t storage_block_count(void);
+
+/**
+ * @brief read blocks, storage task only
+ * @return 0 on success, -1 on a flash error
+ */
+int8_t storage_read(uint8_t *buf, uint32_t lba, uint32_t count);
+
+/**
+ * @brief write blocks into the cache, storage task only
+ * @return 0 on success, -1 on a flash error
+ */
+int8_t storage_write(const uint8_t *buf, uint32_t lba, uint32_t count);
+
+/**
+ * @brief write back every dirty sector, storage task only
+ * @return 0 on success, -1 on a flash error
+ */
+int8_t storage_sync(void);
+
+/**
+ * @brief wake the storage task, called by the MSC class in the USB interrupt
+ */
+void storage_notify(void);
+
+/**
+ * @brief copy the cache counters
+ */
+void storage_get_stats(StorageStatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
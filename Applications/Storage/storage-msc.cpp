@@ -0,0 +1,245 @@
+/**
+ *******************************************************************************
+ * @file    storage-msc.cpp
+ * @brief   the USB mass storage backend: OSPI flash behind a sector cache
+ *******************************************************************************
+ * @attention
+ *
+ * The task sleeps on a thread flag raised by the MSC class in the USB
+ * interrupt and runs the transport until no event is left, so every media
+ * access, erases included, happens here and never in the interrupt.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * While the host is silent the task uses the time for the cache: it loads
+ * the sector a sequential reader will ask for next, and writes dirty sectors
+ * back once no write came for STORAGE_FLUSH_MS.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/6
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define STORAGE_FLAG_USB    0x0001U
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "storage-intf.h"
+#include "../app-intf.h"
+#include "sector-cache.hpp"
+#include "../../Drivers/Peripheral/Flash/flash-intf.hpp"
+#include "cmsis_os.h"
+#include "usbd_msc.h"
+#include <new>
+#include <variant>
+
+extern "C" USBD_HandleTypeDef hUsbDeviceHS;
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static osThreadId_t s_storage_task;
+
+static const osThreadAttr_t s_storage_attr = {
+    .name       = "storage",
+    .stack_size = 1024,
+    .priority   = (osPriority_t)osPriorityNormal,
+};
+
+static uint8_t s_lines[STORAGE_LINES * STORAGE_LINE_SIZE] __attribute__((section(".axi_sram"), aligned(32)));
+
+alignas(SectorCache) static uint8_t s_cache_mem[sizeof(SectorCache)];
+static SectorCache *s_cache = nullptr;
+
+static volatile uint8_t s_ready      = 0;
+static volatile uint32_t s_blocks    = 0;
+static uint32_t s_last_write         = 0;
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief bring up the flash and the cache
+ * @return true when the medium can be exported
+ */
+static bool storage_open()
+{
+    auto product = p_flash_ospi_fcty->produce();
+    if (not std::holds_alternative<FlashIntf *>(product))
+    {
+        return false;
+    }
+
+    FlashIntf *flash = std::get<FlashIntf *>(product);
+    if (flash->enable() != FlashErrCode::FLASH_SUCCESS)
+    {
+        return false;
+    }
+
+    s_cache = new (s_cache_mem) SectorCache(*flash, s_lines, sizeof(s_lines));
+    const uint32_t size = flash->geometry_getter().size;
+    if (size <= STORAGE_RESERVED_TOP or s_cache->init(0, size - STORAGE_RESERVED_TOP) != FlashErrCode::FLASH_SUCCESS)
+    {
+        s_cache = nullptr;
+        return false;
+    }
+
+    s_blocks = s_cache->block_count();
+    s_ready  = 1;
+    return true;
+}
+
+
+/**
+ * @brief the storage task
+ */
+static void storage_task(void *argument)
+{
+    (void)argument;
+
+    if (not storage_open())
+    {
+        // the host sees a unit with no medium
+        osThreadExit();
+    }
+
+    for (;;)
+    {
+        const bool dirty = s_cache->dirty();
+        (void)osThreadFlagsWait(STORAGE_FLAG_USB, osFlagsWaitAny, dirty ? STORAGE_FLUSH_MS : osWaitForever);
+
+        while (USBD_MSC_Process(&hUsbDeviceHS) != 0U)
+        {
+        }
+
+        // the bus is idle: read ahead, then write back after a write pause
+        if (s_cache->prefetch())
+        {
+            continue;
+        }
+        if (s_cache->dirty() and (osKernelGetTickCount() - s_last_write) >= STORAGE_FLUSH_MS)
+        {
+            (void)s_cache->flush();
+        }
+    }
+}
+
+
+/**
+ * @brief create the storage task, it brings up the flash and the cache
+ */
+extern "C" void storage_init(void)
+{
+    s_storage_task = osThreadNew(storage_task, nullptr, &s_storage_attr);
+}
+
+APP_REGISTER(40, storage, storage_init);
+
+
+/**
+ * @brief the medium can be accessed
+ */
+extern "C" uint8_t storage_ready(void)
+{
+    return s_ready;
+}
+
+
+/**
+ * @brief number of 512-byte blocks
+ */
+extern "C" uint32_t storage_block_count(void)
+{
+    return s_blocks;
+}
+
+
+/**
+ * @brief read blocks, storage task only
+ */
+extern "C" int8_t storage_read(uint8_t *buf, uint32_t lba, uint32_t count)
+{
+    if (s_cache == nullptr or s_cache->read(lba, buf, count) != FlashErrCode::FLASH_SUCCESS)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief write blocks into the cache, storage task only
+ */
+extern "C" int8_t storage_write(const uint8_t *buf, uint32_t lba, uint32_t count)
+{
+    if (s_cache == nullptr or s_cache->write(lba, buf, count) != FlashErrCode::FLASH_SUCCESS)
+    {
+        return -1;
+    }
+    s_last_write = osKernelGetTickCount();
+    return 0;
+}
+
+
+/**
+ * @brief write back every dirty sector, storage task only
+ */
+extern "C" int8_t storage_sync(void)
+{
+    if (s_cache == nullptr or s_cache->flush() != FlashErrCode::FLASH_SUCCESS)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief wake the storage task, USB interrupt
+ */
+extern "C" void storage_notify(void)
+{
+    if (s_storage_task != nullptr)
+    {
+        (void)osThreadFlagsSet(s_storage_task, STORAGE_FLAG_USB);
+    }
+}
+
+
+/**
+ * @brief copy the cache counters
+ */
+extern "C" void storage_get_stats(StorageStatsTypeDef *stats)
+{
+    if (s_cache == nullptr)
+    {
+        *stats = {};
+        return;
+    }
+
+    const SectorCache::Stats &s = s_cache->stats_getter();
+    stats->readBlocks  = static_cast<uint32_t>(s.readBlocks);
+    stats->writeBlocks = static_cast<uint32_t>(s.writeBlocks);
+    stats->hits        = static_cast<uint32_t>(s.hits);
+    stats->misses      = static_cast<uint32_t>(s.misses);
+    stats->prefetches  = static_cast<uint32_t>(s.prefetches);
+    stats->flushes     = static_cast<uint32_t>(s.flushes);
+    stats->erases      = static_cast<uint32_t>(s.erases);
+    stats->programs    = static_cast<uint32_t>(s.programs);
+    stats->eraseSkips  = static_cast<uint32_t>(s.eraseSkips);
+}
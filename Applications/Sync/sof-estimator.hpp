@@ -0,0 +1,288 @@
+/**
+ *******************************************************************************
+ * @file    sof-estimator.hpp
+ * @brief   offset and drift estimator of the device clock against USB frames
+ *******************************************************************************
+ * @attention
+ *
+ * Pure computation, no HAL dependency: the same header is built on the host
+ * by Tools/sof-sync/sof-sim.cpp to check the estimator against synthetic SOF
+ * sequences.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The host sends one SOF per millisecond (full speed), so the frame number is
+ * a clock owned by the host. Every SOF is stamped with the device cycle
+ * counter, which gives samples (k, t): frame k started at device time t plus
+ * the interrupt latency. The latency is never negative and is usually small,
+ * with rare large values when interrupts are masked or a higher priority
+ * handler runs.
+ *
+ * The model t = phase + period * (k - k_ref) is tracked by an alpha-beta
+ * filter. The gains start at the values of a least squares fit over the
+ * samples seen so far (fast lock), then decay to fixed floors that average
+ * the latency jitter. Samples whose residual is outside the gate are ignored,
+ * after too many of them in a row the filter restarts: that covers bus resets,
+ * suspend and a host that restarted its frame counter.
+ *
+ * The constant part of the interrupt latency stays in the phase; subtract it
+ * with `latency` if it is known.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/5
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <cmath>
+#include <cstdint>
+
+
+
+
+/*-------- 2. estimator ------------------------------------------------------*/
+
+/**
+ * @brief alpha-beta tracker of the device time of each USB frame
+ */
+class SofEstimator
+{
+  public:
+    /**
+     * @brief tuning, all times in device cycles
+     */
+    struct Config
+    {
+        double nominal_period; // cycles per frame of a perfect crystal
+        double gate;           // largest residual accepted once locked
+        double latency;        // constant interrupt latency to remove
+        double alpha_min;      // phase gain floor
+        double beta_min;       // period gain floor
+        uint32_t lock_samples; // accepted samples before reporting a lock
+        uint32_t max_rejects;  // consecutive rejections before a restart
+        uint32_t max_gap;      // frames without SOF before a restart
+    };
+
+    /**
+     * @brief defaults for a core clock in Hz and 1 ms frames
+     */
+    static constexpr Config default_config(double core_hz)
+    {
+        return Config{core_hz / 1000.0, core_hz * 20e-6, 0.0, 1.0 / 32.0, 1.0 / 4096.0, 64U, 64U, 100U};
+    }
+
+    explicit SofEstimator(const Config &cfg) : _cfg(cfg)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        _count     = 0;
+        _rejects   = 0;
+        _period    = _cfg.nominal_period;
+        _phase     = 0.0;
+        _frame     = 0;
+        _residual2 = 0.0;
+    }
+
+    /**
+     * @brief feed one SOF
+     * @param frame  unwrapped frame index
+     * @param cycles unwrapped device cycle stamp
+     * @return true when the sample was used
+     */
+    bool update(int64_t frame, int64_t cycles)
+    {
+        const double t = static_cast<double>(cycles) - _cfg.latency;
+
+        if (_count == 0U)
+        {
+            return start(frame, t);
+        }
+
+        const int64_t dt = frame - _frame;
+        if (dt <= 0 or dt > static_cast<int64_t>(_cfg.max_gap))
+        {
+            return start(frame, t); // frame counter restarted or long silence
+        }
+
+        const double pred = _phase + _period * static_cast<double>(dt);
+        const double r    = t - pred;
+        if (_count >= 8U and (r > _cfg.gate or r < -_cfg.gate))
+        {
+            if (++_rejects > _cfg.max_rejects)
+            {
+                return start(frame, t);
+            }
+            return false;
+        }
+        _rejects = 0;
+
+        /* least squares gains of a constant velocity model, floored */
+        const double n = static_cast<double>(_count + 1U);
+        double alpha   = 2.0 * (2.0 * n - 1.0) / (n * (n + 1.0));
+        double beta    = 6.0 / (n * (n + 1.0));
+        alpha          = alpha < _cfg.alpha_min ? _cfg.alpha_min : alpha;
+        beta           = beta < _cfg.beta_min ? _cfg.beta_min : beta;
+
+        _phase = pred + alpha * r;
+        _period += beta * r / static_cast<double>(dt);
+        _frame = frame;
+        _count++;
+        _residual2 += (r * r - _residual2) / 64.0;
+        return true;
+    }
+
+    /**
+     * @brief device time of the start of a frame
+     */
+    double frame_to_cycles(double frame) const
+    {
+        return _phase + _period * (frame - static_cast<double>(_frame)) + _cfg.latency;
+    }
+
+    /**
+     * @brief frame clock at a device time, fractional frames
+     */
+    double cycles_to_frame(int64_t cycles) const
+    {
+        return static_cast<double>(_frame) +
+               (static_cast<double>(cycles) - _cfg.latency - _phase) / _period;
+    }
+
+    bool locked() const
+    {
+        return _count >= _cfg.lock_samples;
+    }
+
+    /**
+     * @brief drift of the device clock, parts per million, positive when fast
+     */
+    double drift_ppm() const
+    {
+        return (_period / _cfg.nominal_period - 1.0) * 1e6;
+    }
+
+    double period() const
+    {
+        return _period;
+    }
+
+    /**
+     * @brief RMS of the recent residuals, cycles
+     */
+    double jitter_rms() const
+    {
+        return std::sqrt(_residual2);
+    }
+
+    uint32_t samples() const
+    {
+        return _count;
+    }
+
+    /**
+     * @brief times the filter started over on its own (gap, rejections)
+     */
+    uint32_t restarts() const
+    {
+        return _restarts;
+    }
+
+  private:
+    bool start(int64_t frame, double t)
+    {
+        if (_count != 0U)
+        {
+            _restarts++;
+        }
+        reset();
+        _phase = t;
+        _frame = frame;
+        _count = 1;
+        return true;
+    }
+
+    Config _cfg;
+    uint32_t _count;
+    uint32_t _rejects;
+    uint32_t _restarts = 0;
+    double _period;
+    double _phase; // device time of frame _frame, latency removed
+    int64_t _frame;
+    double _residual2;
+};
+
+
+
+
+/*-------- 3. counter extension ----------------------------------------------*/
+
+/**
+ * @brief widen the 11-bit frame number and the 32-bit cycle counter
+ * @note  correct as long as consecutive samples are less than 1024 frames and
+ *        2^31 cycles (3.9 s at 550 MHz) apart; a longer silence only shifts
+ *        the frame index, which the estimator then sees as a restart
+ */
+class SofUnwrap
+{
+  public:
+    void feed(uint32_t frame11, uint32_t cycles32)
+    {
+        if (not _valid)
+        {
+            _frame  = frame11 & 0x7FFU;
+            _cycles = cycles32;
+            _valid  = true;
+        }
+        else
+        {
+            _frame += (frame11 - _last_frame) & 0x7FFU;
+            _cycles += static_cast<uint32_t>(cycles32 - _last_cycles);
+        }
+        _last_frame  = frame11 & 0x7FFU;
+        _last_cycles = cycles32;
+    }
+
+    /**
+     * @brief widen a cycle stamp close to the last sample (within 2^31 cycles)
+     */
+    int64_t cycles_of(uint32_t cycles32) const
+    {
+        return _cycles + static_cast<int32_t>(cycles32 - _last_cycles);
+    }
+
+    int64_t frame() const
+    {
+        return _frame;
+    }
+
+    int64_t cycles() const
+    {
+        return _cycles;
+    }
+
+    void reset()
+    {
+        _valid = false;
+    }
+
+  private:
+    bool _valid          = false;
+    uint32_t _last_frame  = 0;
+    uint32_t _last_cycles = 0;
+    int64_t _frame        = 0;
+    int64_t _cycles       = 0;
+};
@@ -0,0 +1,157 @@
+/**
+ *******************************************************************************
+ * @file    sof-sync.cpp
+ * @brief   USB SOF clock synchronisation service
+ *******************************************************************************
+ * @attention
+ *
+ * The estimator works in double precision: the Cortex-M7 of the STM32H723
+ * has a double precision FPU and one update costs well under a microsecond.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The stamp is taken at the entry of OTG_HS_IRQHandler when the SOF flag is
+ * already pending, which removes the time HAL_PCD_IRQHandler spends on the
+ * endpoint interrupts served before the SOF. When the SOF flag rose while the
+ * handler was running the stamp is taken in the callback instead.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/5
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "sof-sync.h"
+#include "sof-estimator.hpp"
+#include "../../Drivers/Peripheral/DWT/dwt-cycle.h"
+#include "stm32h7xx_hal.h"
+
+
+
+
+/* ------- macro -------------------------------------------------------------*/
+
+#define SOF_ENTER_CRITICAL()    uint32_t primask_ = __get_PRIMASK(); __disable_irq()
+#define SOF_EXIT_CRITICAL()     __set_PRIMASK(primask_)
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static SofEstimator s_est(SofEstimator::default_config(550e6));
+static SofUnwrap s_unwrap;
+static bool s_configured = false;
+
+static uint32_t s_entry_stamp;
+static bool s_entry_valid = false;
+static uint32_t s_bus_resets = 0;
+static uint32_t s_last_frame = 0;
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief stamp the interrupt entry if a SOF is already pending
+ */
+extern "C" void sof_sync_irq_entry(void)
+{
+    const uint32_t now = dwt_cycle_now();
+    s_entry_valid      = (USB_OTG_HS->GINTSTS & USB_OTG_GINTSTS_SOF) != 0U;
+    s_entry_stamp      = now;
+}
+
+
+/**
+ * @brief feed one SOF to the estimator, USB interrupt context
+ */
+extern "C" void sof_sync_on_sof(uint32_t frame)
+{
+    const uint32_t stamp = s_entry_valid ? s_entry_stamp : dwt_cycle_now();
+    s_entry_valid        = false;
+
+    if (not s_configured)
+    {
+        /* the core clock is only known once SystemClock_Config() ran */
+        s_est        = SofEstimator(SofEstimator::default_config(static_cast<double>(SystemCoreClock)));
+        s_configured = true;
+    }
+
+    s_last_frame = frame;
+    s_unwrap.feed(frame, stamp);
+    (void)s_est.update(s_unwrap.frame(), s_unwrap.cycles());
+}
+
+
+/**
+ * @brief drop the lock, the next SOF starts a new estimate
+ */
+extern "C" void sof_sync_reset(void)
+{
+    SOF_ENTER_CRITICAL();
+    dwt_cycle_init();
+    s_est.reset();
+    s_unwrap.reset();
+    s_entry_valid = false;
+    s_bus_resets++;
+    SOF_EXIT_CRITICAL();
+}
+
+
+/**
+ * @brief device cycle stamp to host frame clock, in microseconds
+ */
+extern "C" uint8_t sof_sync_to_host_us(uint32_t cycles, int64_t *host_us)
+{
+    uint8_t ok = 0;
+    SOF_ENTER_CRITICAL();
+    if (s_est.locked())
+    {
+        const double frame = s_est.cycles_to_frame(s_unwrap.cycles_of(cycles));
+        if (host_us != nullptr)
+        {
+            *host_us = static_cast<int64_t>(frame * 1000.0);
+        }
+        ok = 1;
+    }
+    SOF_EXIT_CRITICAL();
+    return ok;
+}
+
+
+/**
+ * @brief host frame clock of now
+ */
+extern "C" uint8_t sof_sync_now_us(int64_t *host_us)
+{
+    return sof_sync_to_host_us(dwt_cycle_now(), host_us);
+}
+
+
+/**
+ * @brief snapshot of the estimator state
+ */
+extern "C" void sof_sync_get_status(SofSyncStatusTypeDef *status)
+{
+    if (status == nullptr)
+    {
+        return;
+    }
+    SOF_ENTER_CRITICAL();
+    status->locked   = s_est.locked() ? 1U : 0U;
+    status->samples  = s_est.samples();
+    status->restarts = s_bus_resets + s_est.restarts();
+    status->driftPpb = static_cast<int32_t>(s_est.drift_ppm() * 1000.0);
+    status->jitterNs = static_cast<uint32_t>(s_est.jitter_rms() * 1e9 / static_cast<double>(SystemCoreClock));
+    status->frame    = s_last_frame;
+    SOF_EXIT_CRITICAL();
+}
@@ -0,0 +1,112 @@
+/**
+ *******************************************************************************
+ * @file    sof-sync.h
+ * @brief   the interface of the USB SOF clock synchronisation service
+ *******************************************************************************
+ * @attention
+ *
+ * Only built in when USBD_SOF_SYNC is 1 in usbd_conf.h. The USB driver feeds
+ * it from interrupt context, the conversion functions are safe from any task
+ * or interrupt.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * "Host USB time" is the frame clock of the host, in microseconds:
+ *
+ *      host_us = unwrapped_frame_number * 1000 + offset_in_frame_us
+ *
+ * so (host_us / 1000) & 0x7FF is the frame number on the bus, which the PC
+ * side can relate to its own clock (usbmon timestamps, the frame number of
+ * an isochronous URB, ...). The frame count starts over after a bus reset.
+ *
+ * Feeding order inside OTG_HS_IRQHandler:
+ *
+ *      sof_sync_irq_entry();                   // first thing, stamps the IRQ
+ *      HAL_PCD_IRQHandler()
+ *          -> HAL_PCD_SOFCallback()
+ *              -> sof_sync_on_sof(frame);      // uses the entry stamp
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/5
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. typedef --------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief state of the estimator, for diagnostics
+ */
+typedef struct
+{
+    uint8_t  locked;        // conversions are valid
+    uint32_t samples;       // SOFs used since the last restart
+    uint32_t restarts;      // bus resets, suspends and lost locks
+    int32_t  driftPpb;      // device clock against the host, parts per billion
+    uint32_t jitterNs;      // RMS of the SOF stamp residuals
+    uint32_t frame;         // last 11-bit frame number seen
+} SofSyncStatusTypeDef;
+
+
+
+
+/*-------- 3. function prototypes --------------------------------------------*/
+
+/**
+ * @brief stamp the USB interrupt entry, call first in OTG_HS_IRQHandler
+ */
+void sof_sync_irq_entry(void);
+
+/**
+ * @brief feed one SOF, called from the PCD SOF callback
+ * @param frame 11-bit frame number from OTG_DSTS.FNSOF
+ */
+void sof_sync_on_sof(uint32_t frame);
+
+/**
+ * @brief forget the lock, called on bus reset and suspend
+ */
+void sof_sync_reset(void);
+
+/**
+ * @brief convert a device cycle stamp (dwt_cycle_now()) to host USB time
+ * @note  the stamp must be less than ~3.9 s away from the last SOF
+ * @param cycles  DWT cycle counter value
+ * @param host_us destination, microseconds of the host frame clock
+ * @return 1 when locked and `host_us` is valid, 0 otherwise
+ */
+uint8_t sof_sync_to_host_us(uint32_t cycles, int64_t *host_us);
+
+/**
+ * @brief host USB time of now
+ */
+uint8_t sof_sync_now_us(int64_t *host_us);
+
+/**
+ * @brief snapshot of the estimator state
+ */
+void sof_sync_get_status(SofSyncStatusTypeDef *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,310 @@
+/**
+ *******************************************************************************
+ * @file    tx-scheduler.cpp
+ * @brief   per-class transmit queues with strict priority and deficit round robin
+ *******************************************************************************
+ * @attention
+ *
+ * See tx-scheduler.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/8
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "tx-scheduler.hpp"
+#include <cstring>
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief bind the queues to their memory
+ */
+TxScheduler::TxScheduler(const ClassConfig (&cfg)[CLASSES])
+{
+    for (uint32_t c = 0; c < CLASSES; c++)
+    {
+        _q[c].ring    = cfg[c].ring;
+        _q[c].size    = cfg[c].size;
+        _q[c].quantum = cfg[c].quantum != 0U ? cfg[c].quantum : 1U;
+    }
+}
+
+
+/**
+ * @brief queue one message, producer of the class only
+ */
+uint32_t TxScheduler::enqueue(uint32_t cls, const uint8_t *data, uint32_t len, uint32_t nowUs)
+{
+    Queue &q            = _q[cls];
+    const uint32_t head = q.head.load(std::memory_order_relaxed);
+    const uint32_t room = q.size - (head - q.tail.load(std::memory_order_acquire));
+    const uint32_t n    = len < room ? len : room;
+    const uint32_t mh   = q.markHead.load(std::memory_order_relaxed);
+
+    // without a mark the message would merge with the previous one
+    if (n == 0U or mh - q.markTail.load(std::memory_order_acquire) == MAX_MARKS)
+    {
+        q.stats.dropped += len;
+        return 0;
+    }
+    q.stats.dropped += len - n;
+
+    // the mark goes first, the consumer sees it no later than the bytes
+    q.marks[mh & (MAX_MARKS - 1U)] = {head, nowUs};
+    q.markHead.store(mh + 1U, std::memory_order_release);
+
+    const uint32_t off   = head & (q.size - 1U);
+    const uint32_t first = n < q.size - off ? n : q.size - off;
+    memcpy(&q.ring[off], data, first);
+    memcpy(q.ring, data + first, n - first);
+    q.head.store(head + n, std::memory_order_release);
+
+    q.stats.bytesIn += n;
+    q.stats.messages++;
+    return n;
+}
+
+
+/**
+ * @brief room at the head of the ring for a message written in place
+ */
+uint8_t *TxScheduler::reserve(uint32_t cls, uint32_t len)
+{
+    Queue &q           = _q[cls];
+    const uint32_t off = q.head.load(std::memory_order_relaxed) & (q.size - 1U);
+    if (len == 0U or len > q.size - off or free_getter(cls) < len)
+    {
+        return nullptr;
+    }
+    return &q.ring[off];
+}
+
+
+/**
+ * @brief publish a message written in place, the consumer only freed room since reserve()
+ */
+uint32_t TxScheduler::commit(uint32_t cls, uint32_t len, uint32_t nowUs)
+{
+    Queue &q            = _q[cls];
+    const uint32_t head = q.head.load(std::memory_order_relaxed);
+    const uint32_t mh   = q.markHead.load(std::memory_order_relaxed);
+    if (len == 0U)
+    {
+        return 0;
+    }
+
+    q.marks[mh & (MAX_MARKS - 1U)] = {head, nowUs};
+    q.markHead.store(mh + 1U, std::memory_order_release);
+    q.head.store(head + len, std::memory_order_release);
+
+    q.stats.bytesIn += len;
+    q.stats.messages++;
+    return len;
+}
+
+
+/**
+ * @brief close the marks of the messages whose first byte left
+ */
+void TxScheduler::time_marks(Queue &q, uint32_t tail, uint32_t nowUs)
+{
+    uint32_t mt       = q.markTail.load(std::memory_order_relaxed);
+    const uint32_t mh = q.markHead.load(std::memory_order_acquire);
+    while (mt != mh)
+    {
+        const Mark &m = q.marks[mt & (MAX_MARKS - 1U)];
+        if (static_cast<int32_t>(tail - m.start) <= 0)
+        {
+            break;
+        }
+        const uint32_t d = nowUs - m.us;
+        uint32_t bin     = 0;
+        while (bin < HIST_BINS - 1U and (d >> bin) != 0U)
+        {
+            bin++;
+        }
+        q.stats.hist[bin]++;
+        q.stats.timed++;
+        q.stats.delaySumUs += d;
+        q.stats.delayMaxUs = d > q.stats.delayMaxUs ? d : q.stats.delayMaxUs;
+        mt++;
+    }
+    q.markTail.store(mt, std::memory_order_release);
+}
+
+
+/**
+ * @brief copy up to cap bytes out of one queue
+ */
+uint32_t TxScheduler::take(Queue &q, uint8_t *out, uint32_t cap, uint32_t nowUs)
+{
+    const uint32_t tail  = q.tail.load(std::memory_order_relaxed);
+    const uint32_t avail = q.head.load(std::memory_order_acquire) - tail;
+    const uint32_t n     = cap < avail ? cap : avail;
+    if (n == 0U)
+    {
+        return 0;
+    }
+
+    const uint32_t off   = tail & (q.size - 1U);
+    const uint32_t first = n < q.size - off ? n : q.size - off;
+    memcpy(out, &q.ring[off], first);
+    memcpy(out + first, q.ring, n - first);
+    time_marks(q, tail + n, nowUs);
+    q.tail.store(tail + n, std::memory_order_release);
+    q.stats.bytesOut += n;
+    return n;
+}
+
+
+/**
+ * @brief bytes up to the end of the message at the tail of a queue
+ * @note  the next mark is the start of the next message; without one the
+ *        message runs to the head, enqueue() publishes whole messages
+ */
+uint32_t TxScheduler::message_left(const Queue &q)
+{
+    const uint32_t tail = q.tail.load(std::memory_order_relaxed);
+    const uint32_t mh   = q.markHead.load(std::memory_order_acquire);
+    for (uint32_t mt = q.markTail.load(std::memory_order_relaxed); mt != mh; mt++)
+    {
+        // the first mark may be the message at the tail itself, not started yet
+        const uint32_t next = q.marks[mt & (MAX_MARKS - 1U)].start;
+        if (next != tail)
+        {
+            return next - tail;
+        }
+    }
+    return q.head.load(std::memory_order_acquire) - tail;
+}
+
+
+/**
+ * @brief class of the next message: interactive, else the round robin turn
+ * @return CLASSES when every queue is empty
+ */
+uint32_t TxScheduler::pick()
+{
+    if (queued_getter(0) != 0U)
+    {
+        return 0;
+    }
+
+    bool any = false;
+    for (uint32_t c = 1; c < CLASSES; c++)
+    {
+        any = any or queued_getter(c) != 0U;
+    }
+    if (not any)
+    {
+        return CLASSES;
+    }
+
+    // terminates: every pass over a backlogged class earns it a quantum
+    for (;;)
+    {
+        Queue &q = _q[_turn];
+        if (queued_getter(_turn) == 0U)
+        {
+            q.deficit = 0; // an idle class does not save up credit
+        }
+        else if (q.deficit > 0)
+        {
+            return _turn;
+        }
+        else
+        {
+            q.deficit += static_cast<int32_t>(q.quantum); // a new turn
+            if (q.deficit > 0)
+            {
+                return _turn;
+            }
+        }
+        _turn = _turn + 1U < CLASSES ? _turn + 1U : 1U;
+    }
+}
+
+
+/**
+ * @brief next bytes to send: interactive first, then the others by turns,
+ *        one whole message at a time
+ */
+uint32_t TxScheduler::dequeue(uint8_t *out, uint32_t cap, uint32_t nowUs)
+{
+    uint32_t n = 0;
+    while (n < cap)
+    {
+        if (_open == CLASSES)
+        {
+            _open = pick();
+            if (_open == CLASSES)
+            {
+                break;
+            }
+            _unit = MAX_UNIT;
+        }
+
+        Queue &q            = _q[_open];
+        const uint32_t left = message_left(q);
+        uint32_t want       = left < _unit ? left : _unit;
+        want                = want < cap - n ? want : cap - n;
+        const uint32_t t    = take(q, out + n, want, nowUs);
+        n += t;
+        _unit -= t;
+        if (_open != 0U)
+        {
+            q.deficit -= static_cast<int32_t>(t);
+        }
+
+        if (t == left or _unit == 0U)
+        {
+            // message done, or long enough to be cut: the link may change class
+            if (_open != 0U and (q.deficit <= 0 or queued_getter(_open) == 0U))
+            {
+                q.deficit = queued_getter(_open) == 0U ? 0 : q.deficit;
+                _turn     = _turn + 1U < CLASSES ? _turn + 1U : 1U;
+            }
+            _open = CLASSES;
+        }
+    }
+    return n;
+}
+
+
+/**
+ * @brief nothing queued in any class
+ */
+bool TxScheduler::empty() const
+{
+    for (uint32_t c = 0; c < CLASSES; c++)
+    {
+        if (queued_getter(c) != 0U)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief clear the counters of every class
+ */
+void TxScheduler::stats_reset()
+{
+    for (auto &q : _q)
+    {
+        q.stats = {};
+    }
+}
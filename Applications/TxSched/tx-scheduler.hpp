@@ -0,0 +1,192 @@
+/**
+ *******************************************************************************
+ * @file    tx-scheduler.hpp
+ * @brief   per-class transmit queues with strict priority and deficit round robin
+ *******************************************************************************
+ * @attention
+ *
+ * Pure C++, no HAL and no RTOS: the same code runs on the host with synthetic
+ * traffic (Tools/txq-sim). Each class queue is single producer / single
+ * consumer: the owner serialises the producers of a class, and the calls of
+ * dequeue(). Times are microseconds from any free running clock.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Class 0 (interactive) is served first, always. The other classes share
+ * what is left with deficit round robin by bytes: on its turn a class earns
+ * its quantum and sends messages while it has credit, the last one may
+ * leave it in debt for the next round, so when every class is backlogged
+ * the bytes split in the ratio of the quanta, whatever the size of the
+ * messages. Bytes of one class never reorder.
+ *
+ * The link only changes class between messages, so a text line written in
+ * one enqueue() call reaches the host whole, never cut by another class;
+ * only a message longer than MAX_UNIT may be cut, every MAX_UNIT bytes.
+ *
+ * The consumer asks for at most `cap` bytes at a time: an interactive byte
+ * waits for the bytes already handed out (at most one `cap`, the owner keeps
+ * it small), for the rest of the message on the link (less than MAX_UNIT)
+ * and for the interactive bytes queued before it, never for the backlog of
+ * another class.
+ *
+ * A producer may also write a message in place: reserve() gives room at
+ * the head of the ring, commit() publishes what was written there, like
+ * an enqueue() of it without the copy. The room is never split by the end
+ * of the ring; where it would be, reserve() gives none and enqueue() is
+ * the way.
+ *
+ * A message is what one enqueue() or commit() call wrote. Its queueing delay runs from
+ * enqueue() to the dequeue() that takes its first byte. A class holds at
+ * most MAX_MARKS messages: the mark of each one is also where the link may
+ * change class, so a message finding the marks full is refused whole.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/8
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <atomic>
+#include <cstdint>
+
+
+
+
+/*-------- 2. scheduler ------------------------------------------------------*/
+
+/**
+ * @brief transmit scheduler
+ */
+class TxScheduler
+{
+  public:
+    static constexpr uint32_t CLASSES    = 3;
+    static constexpr uint32_t MAX_MARKS  = 64;  // messages queued per class, power of two
+    static constexpr uint32_t HIST_BINS  = 16;  // log2 of microseconds
+    static constexpr uint32_t MAX_UNIT   = 512; // bytes sent before a long message may be cut
+
+    /**
+     * @brief memory and weight of one class
+     */
+    struct ClassConfig
+    {
+        uint8_t *ring;      // queue storage
+        uint32_t size;      // bytes, power of two
+        uint32_t quantum;   // bytes per round, unused for class 0
+    };
+
+    /**
+     * @brief counters of one class
+     */
+    struct ClassStats
+    {
+        uint64_t bytesIn;       // accepted by enqueue()
+        uint64_t bytesOut;      // handed out by dequeue()
+        uint32_t messages;
+        uint32_t dropped;       // bytes refused, queue or marks full
+        uint32_t timed;
+        uint64_t delaySumUs;
+        uint32_t delayMaxUs;
+        uint32_t hist[HIST_BINS]; // bin i: delay < 2^i us, last bin everything above
+    };
+
+    explicit TxScheduler(const ClassConfig (&cfg)[CLASSES]);
+
+    /**
+     * @brief queue one message, producer of the class only
+     * @return bytes accepted, the rest is counted as dropped
+     */
+    uint32_t enqueue(uint32_t cls, const uint8_t *data, uint32_t len, uint32_t nowUs);
+
+    /**
+     * @brief room for one message of len bytes written in place, producer of the class only
+     * @return where to write it, nullptr when the queue or its marks are full
+     *         or when the end of the ring falls inside the room
+     */
+    uint8_t *reserve(uint32_t cls, uint32_t len);
+
+    /**
+     * @brief publish the first len bytes written at the last reserve(), len at most what it reserved
+     * @return len
+     */
+    uint32_t commit(uint32_t cls, uint32_t len, uint32_t nowUs);
+
+    /**
+     * @brief next bytes to send, consumer only
+     * @param out destination
+     * @param cap room at out
+     * @return bytes written to out
+     */
+    uint32_t dequeue(uint8_t *out, uint32_t cap, uint32_t nowUs);
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t free_getter(uint32_t cls) const
+    {
+        const Queue &q = _q[cls];
+        if (q.markHead.load(std::memory_order_relaxed) - q.markTail.load(std::memory_order_acquire) == MAX_MARKS)
+        {
+            return 0; // no room for one more message
+        }
+        return q.size - (q.head.load(std::memory_order_relaxed) - q.tail.load(std::memory_order_acquire));
+    }
+
+    [[nodiscard]] uint32_t queued_getter(uint32_t cls) const
+    {
+        const Queue &q = _q[cls];
+        return q.head.load(std::memory_order_acquire) - q.tail.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool empty() const;
+
+    [[nodiscard]] const ClassStats &stats_getter(uint32_t cls) const
+    {
+        return _q[cls].stats;
+    }
+
+    void stats_reset();
+
+    /****************** setter & getter *******************/
+
+  private:
+    struct Mark
+    {
+        uint32_t start; // free running index of the first byte
+        uint32_t us;    // enqueue time
+    };
+
+    struct Queue
+    {
+        uint8_t *ring     = nullptr;
+        uint32_t size     = 0;
+        uint32_t quantum  = 0;
+        int32_t deficit   = 0; // credit of the round, negative for a debt
+        std::atomic<uint32_t> head{0};  // producer
+        std::atomic<uint32_t> tail{0};  // consumer
+        std::atomic<uint32_t> markHead{0};
+        std::atomic<uint32_t> markTail{0};
+        Mark marks[MAX_MARKS] = {};
+        ClassStats stats      = {};
+    };
+
+    uint32_t take(Queue &q, uint8_t *out, uint32_t cap, uint32_t nowUs);
+    static void time_marks(Queue &q, uint32_t tail, uint32_t nowUs);
+    static uint32_t message_left(const Queue &q);
+    uint32_t pick();
+
+    Queue _q[CLASSES];
+    uint32_t _turn = 1;       // class holding the round robin turn
+    uint32_t _open = CLASSES; // class with a message on the link, CLASSES for none
+    uint32_t _unit = 0;       // bytes of the open message still to send before a switch
+};
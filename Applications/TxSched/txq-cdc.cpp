@@ -0,0 +1,305 @@
+/**
+ *******************************************************************************
+ * @file    txq-cdc.cpp
+ * @brief   the transmit scheduler in front of the shell CDC port
+ *******************************************************************************
+ * @attention
+ *
+ * The scheduler has one consumer, txq_pump(), called by the writers and by
+ * the transfer complete interrupt: each dequeue() runs under PRIMASK, so it
+ * never runs twice at once. Each one moves at most TXQ_BURST bytes, a copy
+ * of a few microseconds; a pump while no host listens repeats it until the
+ * queues are empty.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The queueing delay is measured in microseconds from a clock built on the
+ * DWT cycle counter; the HAL tick takes over when the counter may have
+ * wrapped since the last reading (no traffic for a second or more).
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/8
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define TXQ_PORT            CDC_PORT_SHELL
+#define TXQ_CLOCK_SPAN_MS   1000U   // DWT deltas are trusted below this
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "txq-intf.h"
+#include "../app-intf.h"
+#include "tx-scheduler.hpp"
+#include "cmsis_os.h"
+#include "stm32h7xx_hal.h"
+#include "usbd_cdc_if.h"
+#include "../../Drivers/Peripheral/DWT/dwt-cycle.h"
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static uint8_t s_interactive[TXQ_INTERACTIVE_SIZE] __attribute__((section(".axi_sram"), aligned(32)));
+static uint8_t s_telemetry[TXQ_TELEMETRY_SIZE] __attribute__((section(".axi_sram"), aligned(32)));
+static uint8_t s_bulk[TXQ_BULK_SIZE] __attribute__((section(".axi_sram"), aligned(32)));
+static uint8_t s_burst[TXQ_BURST];
+
+static TxScheduler *s_sched = nullptr;
+static osMutexId_t s_lock[TXQ_CLASS_NUM];
+
+static uint32_t s_clock_us   = 0; // free running microseconds
+static uint32_t s_clock_cyc  = 0; // cycle count s_clock_us stands for
+static uint32_t s_clock_tick = 0;
+
+static uint64_t s_rate_bytes[TXQ_CLASS_NUM] = {}; // bytesOut at the previous query
+static uint32_t s_rate_tick[TXQ_CLASS_NUM]  = {};
+
+static_assert(static_cast<uint32_t>(TXQ_CLASS_NUM) == TxScheduler::CLASSES, "one queue per class");
+static_assert((TXQ_INTERACTIVE_SIZE & (TXQ_INTERACTIVE_SIZE - 1U)) == 0U and
+                  (TXQ_TELEMETRY_SIZE & (TXQ_TELEMETRY_SIZE - 1U)) == 0U and
+                  (TXQ_BULK_SIZE & (TXQ_BULK_SIZE - 1U)) == 0U,
+              "queue sizes must be powers of two");
+static_assert(2U * TXQ_BURST <= APP_TX_DATA_SIZE, "the port ring must hold two bursts");
+static_assert(TXQ_UNIT == TxScheduler::MAX_UNIT, "the link cuts messages every MAX_UNIT bytes");
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief microseconds, from the cycle counter when it cannot have wrapped
+ * @note  any context
+ */
+static uint32_t txq_now_us()
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t cyc  = dwt_cycle_now();
+    const uint32_t tick = HAL_GetTick();
+    const uint32_t mhz  = SystemCoreClock / 1000000U;
+    if (tick - s_clock_tick < TXQ_CLOCK_SPAN_MS)
+    {
+        const uint32_t d = cyc - s_clock_cyc;
+        s_clock_us += d / mhz;
+        s_clock_cyc = cyc - d % mhz; // keep the fraction for the next reading
+    }
+    else
+    {
+        s_clock_us += (tick - s_clock_tick) * 1000U;
+        s_clock_cyc = cyc;
+    }
+    s_clock_tick        = tick;
+    const uint32_t now  = s_clock_us;
+    __set_PRIMASK(primask);
+    return now;
+}
+
+
+/**
+ * @brief top the port ring up to one burst pending; while no host listens,
+ *        empty the classes into it
+ * @note  any context, also the transfer complete callback of the port. The
+ *        port ring parks what it holds while the host is closed and keeps
+ *        the newest bytes (usbd_cdc_if.c): a rising DTR replays the latest
+ *        output, not the oldest that filled the class queues first. One
+ *        burst per critical section, the interrupts run between them.
+ */
+static void txq_pump(uint8_t port)
+{
+    (void)port;
+    if (s_sched == nullptr)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        const bool open = CDC_HostOpen_HS(TXQ_PORT) != 0U;
+        uint32_t n      = 0;
+        if (not open or APP_TX_DATA_SIZE - CDC_TxFree_HS(TXQ_PORT) < TXQ_BURST)
+        {
+            n = s_sched->dequeue(s_burst, TXQ_BURST, txq_now_us());
+            if (n != 0U)
+            {
+                (void)CDC_Write_HS(TXQ_PORT, s_burst, n);
+            }
+        }
+        __set_PRIMASK(primask);
+
+        if (open or n == 0U)
+        {
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief create the class locks and hook the port
+ */
+extern "C" void txq_init(void)
+{
+    static const TxScheduler::ClassConfig cfg[TxScheduler::CLASSES] = {
+        {s_interactive, TXQ_INTERACTIVE_SIZE, 1U},
+        {s_telemetry, TXQ_TELEMETRY_SIZE, TXQ_TELEMETRY_QUANTUM},
+        {s_bulk, TXQ_BULK_SIZE, TXQ_BULK_QUANTUM},
+    };
+    static TxScheduler sched(cfg);
+
+    for (auto &lock : s_lock)
+    {
+        lock = osMutexNew(nullptr);
+    }
+    dwt_cycle_init();
+    s_clock_tick = HAL_GetTick();
+    s_clock_cyc  = dwt_cycle_now();
+    s_sched      = &sched;
+    CDC_SetTxNotify_HS(TXQ_PORT, txq_pump);
+}
+
+APP_REGISTER(10, txq, txq_init); // before anything that transmits
+
+
+/**
+ * @brief queue bytes for the host in a class, never blocks
+ */
+extern "C" uint32_t txq_write(TxqClassEnum cls, const uint8_t *buf, uint32_t len)
+{
+    if (s_sched == nullptr or static_cast<uint32_t>(cls) >= TxScheduler::CLASSES)
+    {
+        return 0;
+    }
+
+    (void)osMutexAcquire(s_lock[cls], osWaitForever);
+    const uint32_t n = s_sched->enqueue(cls, buf, len, txq_now_us());
+    (void)osMutexRelease(s_lock[cls]);
+
+    txq_pump(TXQ_PORT);
+    return n;
+}
+
+
+/**
+ * @brief room in a class queue for a message written in place, the class
+ *        stays locked until txq_commit()
+ */
+extern "C" uint8_t *txq_reserve(TxqClassEnum cls, uint32_t len)
+{
+    if (s_sched == nullptr or static_cast<uint32_t>(cls) >= TxScheduler::CLASSES)
+    {
+        return nullptr;
+    }
+
+    (void)osMutexAcquire(s_lock[cls], osWaitForever);
+    uint8_t *p = s_sched->reserve(cls, len);
+    if (p == nullptr)
+    {
+        (void)osMutexRelease(s_lock[cls]);
+    }
+    return p;
+}
+
+
+/**
+ * @brief publish the message written at txq_reserve(), unlock the class
+ */
+extern "C" uint32_t txq_commit(TxqClassEnum cls, uint32_t len)
+{
+    if (s_sched == nullptr or static_cast<uint32_t>(cls) >= TxScheduler::CLASSES)
+    {
+        return 0;
+    }
+
+    const uint32_t n = s_sched->commit(cls, len, txq_now_us());
+    (void)osMutexRelease(s_lock[cls]);
+
+    txq_pump(TXQ_PORT);
+    return n;
+}
+
+
+/**
+ * @brief room left in a class queue
+ */
+extern "C" uint32_t txq_free(TxqClassEnum cls)
+{
+    if (s_sched == nullptr or static_cast<uint32_t>(cls) >= TxScheduler::CLASSES)
+    {
+        return 0;
+    }
+    return s_sched->free_getter(cls);
+}
+
+
+/**
+ * @brief bytes of a class queue not handed to the port yet
+ */
+extern "C" uint32_t txq_queued(TxqClassEnum cls)
+{
+    if (s_sched == nullptr or static_cast<uint32_t>(cls) >= TxScheduler::CLASSES)
+    {
+        return 0;
+    }
+    return s_sched->queued_getter(cls);
+}
+
+
+/**
+ * @brief snapshot of the counters of a class
+ */
+extern "C" void txq_get_stats(TxqClassEnum cls, TxqStatsTypeDef *stats)
+{
+    if (s_sched == nullptr or stats == nullptr or static_cast<uint32_t>(cls) >= TxScheduler::CLASSES)
+    {
+        return;
+    }
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const TxScheduler::ClassStats st = s_sched->stats_getter(cls);
+    const uint32_t queued            = s_sched->queued_getter(cls);
+    __set_PRIMASK(primask);
+
+    const uint32_t tick = HAL_GetTick();
+    const uint32_t ms   = tick - s_rate_tick[cls];
+    stats->rateBps      = ms != 0U ? static_cast<uint32_t>((st.bytesOut - s_rate_bytes[cls]) * 1000U / ms) : 0U;
+    s_rate_bytes[cls]   = st.bytesOut;
+    s_rate_tick[cls]    = tick;
+
+    stats->bytes      = st.bytesOut;
+    stats->messages   = st.messages;
+    stats->dropped    = st.dropped;
+    stats->queued     = queued;
+    stats->delayAvgUs = st.timed != 0U ? static_cast<uint32_t>(st.delaySumUs / st.timed) : 0U;
+    stats->delayMaxUs = st.delayMaxUs;
+
+    // first bin holding the 99th percentile, its upper edge
+    const uint64_t want = (static_cast<uint64_t>(st.timed) * 99U + 99U) / 100U;
+    uint64_t seen       = 0;
+    stats->delayP99Us   = 0;
+    for (uint32_t bin = 0; bin < TxScheduler::HIST_BINS and st.timed != 0U; bin++)
+    {
+        seen += st.hist[bin];
+        if (seen >= want)
+        {
+            const uint32_t edge = bin + 1U < TxScheduler::HIST_BINS ? (1UL << bin) : st.delayMaxUs;
+            stats->delayP99Us   = edge < st.delayMaxUs ? edge : st.delayMaxUs;
+            break;
+        }
+    }
+}
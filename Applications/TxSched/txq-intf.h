@@ -0,0 +1,156 @@
+/**
+ *******************************************************************************
+ * @file    txq-intf.h
+ * @brief   the interface of the shell port transmit scheduler
+ *******************************************************************************
+ * @attention
+ *
+ * Every producer of the shell CDC port writes through txq_write() instead of
+ * CDC_Write_HS(): the scheduler decides which class goes out next and keeps
+ * the port ring almost empty, so an interactive reply never waits behind a
+ * dump. Only tasks may write, the producers of one class are serialised by a
+ * mutex; the other functions are safe from any task.
+ *
+ *******************************************************************************
+ * @note
+ *
+ *  txq_write(INTERACTIVE) --+
+ *  txq_write(TELEMETRY)  ---+--> TxScheduler --> CDC_Write_HS(shell) --> IN EP
+ *  txq_write(BULK)       ---+    (tx-scheduler.hpp)  at most TXQ_BURST pending
+ *
+ * The scheduler is pumped by the writers and by the transfer complete
+ * interrupt of the port. Interactive is served first; telemetry and bulk
+ * share the rest of the link by deficit round robin, in the ratio of their
+ * quanta. The link changes class only between messages, so a line written
+ * in one txq_write() call reaches the host whole (up to 512 bytes). The
+ * interactive class waits at most for the bytes already in the port ring,
+ * less than 2 * TXQ_BURST, and the rest of the message on the link, whatever
+ * the other classes queue.
+ *
+ * A producer of large output writes it in place instead of copying it:
+ * txq_reserve() hands out room in its class queue, txq_commit() publishes
+ * what was written there. Only the room up to the end of the queue's ring
+ * is given, a message across it goes through txq_write().
+ *
+ * While no host listens the queues are emptied into the port ring as they
+ * are written, in the order of the scheduler. The ring parks its bytes
+ * until DTR rises and overwrites the oldest ones (usbd_cdc_if.c), so the
+ * host that opens the port gets the newest output, at most
+ * APP_TX_DATA_SIZE bytes, and the queues never fill with stale lines.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/8
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define TXQ_INTERACTIVE_SIZE    1024U   // bytes, power of two
+#define TXQ_TELEMETRY_SIZE      4096U
+#define TXQ_BULK_SIZE           8192U
+#define TXQ_TELEMETRY_QUANTUM   1024U   // bytes per round, telemetry gets 2/3 of
+#define TXQ_BULK_QUANTUM        512U    // what interactive leaves when both are backlogged
+#define TXQ_BURST               512U    // bytes moved into the port ring at a time
+#define TXQ_UNIT                512U    // a message up to this reaches the host uncut
+
+
+
+
+/*-------- 3. typedef --------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief traffic classes, by priority
+ */
+typedef enum
+{
+    TXQ_INTERACTIVE = 0,    // shell replies and echo
+    TXQ_TELEMETRY   = 1,    // logs, periodic status
+    TXQ_BULK        = 2,    // dumps, transfers
+    TXQ_CLASS_NUM   = 3,
+} TxqClassEnum;
+
+/**
+ * @brief counters of one class
+ */
+typedef struct
+{
+    uint64_t bytes;         // sent since boot
+    uint32_t messages;      // txq_write() calls accepted
+    uint32_t dropped;       // bytes refused, queue full
+    uint32_t queued;        // bytes waiting now
+    uint32_t rateBps;       // bytes per second since the previous query
+    uint32_t delayAvgUs;    // queueing delay, from txq_write() to the first byte leaving
+    uint32_t delayMaxUs;
+    uint32_t delayP99Us;    // upper bound, power of two resolution
+} TxqStatsTypeDef;
+
+
+
+
+/*-------- 4. function prototypes --------------------------------------------*/
+
+/**
+ * @brief create the class locks and hook the port, call once before the
+ *        scheduler starts
+ */
+void txq_init(void);
+
+/**
+ * @brief queue bytes for the host in a class, never blocks
+ * @note  tasks only
+ * @return bytes accepted, the rest is dropped and counted
+ */
+uint32_t txq_write(TxqClassEnum cls, const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief room for one message of len bytes, to be written in place
+ * @note  tasks only; the class stays locked until txq_commit()
+ * @return where to write it, NULL when the queue is full or its ring ends
+ *         inside the room: the class is left unlocked
+ */
+uint8_t *txq_reserve(TxqClassEnum cls, uint32_t len);
+
+/**
+ * @brief queue the first len bytes written at the last txq_reserve() of the class
+ * @return len
+ */
+uint32_t txq_commit(TxqClassEnum cls, uint32_t len);
+
+/**
+ * @brief room left in a class queue
+ */
+uint32_t txq_free(TxqClassEnum cls);
+
+/**
+ * @brief bytes of a class queue not handed to the port yet
+ */
+uint32_t txq_queued(TxqClassEnum cls);
+
+/**
+ * @brief snapshot of the counters of a class
+ */
+void txq_get_stats(TxqClassEnum cls, TxqStatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
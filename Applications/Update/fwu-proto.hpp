@@ -0,0 +1,173 @@
+/**
+ *******************************************************************************
+ * @file    fwu-proto.hpp
+ * @brief   the chunk protocol of the firmware update over the data CDC port
+ *******************************************************************************
+ * @attention
+ *
+ * Shared by the device and Tools/fwu/fwu-host.cpp: no HAL, no RTOS. Every
+ * field is little endian, both ends are.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The host starts with the text line "update <size> <crc>" on the benchmark
+ * port (bench-intf.h). From there the link is binary until DONE or FAIL:
+ *
+ *      device                                  host
+ *      erase the staging slot
+ *      READY  value = window          ->
+ *                                     <-      frame 0, frame 1, ... frame w-1
+ *      program frame 0, ACK off 1024  ->
+ *                                     <-      frame w
+ *      ...
+ *      read back, CRC                 ->      DONE value = crc  (or FAIL)
+ *
+ * A frame is a FwuFrameHdr and `length` payload bytes. Every frame but the
+ * last carries FWU_CHUNK bytes. The host keeps up to `window` frames in
+ * flight (go-back-N), so the USB transfer of the next frames overlaps the
+ * programming of the current one and the rate is the one of the flash, not
+ * the one of a round trip per chunk.
+ *
+ * The device accepts only the frame at the offset it expects:
+ *   - a bad header CRC or payload CRC  -> NAK with the expected offset, then
+ *     the device hunts byte by byte for the next valid header
+ *   - a valid frame at another offset  -> skipped, no reply after the first
+ *     NAK, the frames the host had in flight are dropped silently
+ * The host restarts from the offset of a NAK, or from the last ACK when no
+ * reply comes in time.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/7
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <array>
+#include <cstdint>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+constexpr uint32_t FWU_FRAME_MAGIC = 0x46555746U; // "FWUF"
+constexpr uint32_t FWU_REPLY_MAGIC = 0x52555746U; // "FWUR"
+constexpr uint32_t FWU_CHUNK       = 1024U;       // payload of a frame, two fit the CDC receive ring
+constexpr uint32_t FWU_WINDOW      = 4U;          // frames the host may keep in flight
+
+/**
+ * @brief status of a reply
+ */
+enum class FwuStatus : uint32_t
+{
+    FWU_READY = 1, // slot erased, value = window in frames
+    FWU_ACK   = 2, // everything below offset is programmed
+    FWU_NAK   = 3, // frame damaged, resend from offset
+    FWU_DONE  = 4, // image complete and checked, value = crc
+    FWU_FAIL  = 5, // update aborted, value = FwuErrCode
+};
+
+/**
+ * @brief reason of a FAIL
+ */
+enum class FwuErrCode : uint32_t
+{
+    FWU_ERR_NONE,
+    FWU_TOO_BIG,        // the image does not fit the slot
+    FWU_BAD_FRAME,      // a frame the protocol does not allow (length)
+    FWU_FLASH_ERROR,    // erase, program or read back refused
+    FWU_CRC_MISMATCH,   // the image read back is not the announced one
+    FWU_BAD_IMAGE,      // no vector table at the start of the image
+    FWU_TIMEOUT,        // the host went silent
+    FWU_SUCCESS,
+};
+
+
+
+
+/*-------- 3. frames ---------------------------------------------------------*/
+
+/**
+ * @brief header of a frame, host to device
+ */
+struct FwuFrameHdr
+{
+    uint32_t magic;     // FWU_FRAME_MAGIC
+    uint32_t offset;    // of the payload in the image
+    uint32_t length;    // payload bytes
+    uint32_t crc;       // CRC-32 of the payload
+    uint32_t hcrc;      // CRC-32 of the four fields above
+};
+
+/**
+ * @brief reply, device to host
+ */
+struct FwuReply
+{
+    uint32_t magic;     // FWU_REPLY_MAGIC
+    FwuStatus status;
+    uint32_t offset;    // next byte the device expects
+    uint32_t value;     // depends on the status
+};
+
+static_assert(sizeof(FwuFrameHdr) == 20U, "the header is sent as is");
+static_assert(sizeof(FwuReply) == 16U, "the reply is sent as is");
+
+
+
+
+/*-------- 4. CRC ------------------------------------------------------------*/
+
+/**
+ * @brief table of the reflected CRC-32 (IEEE 802.3), built at compile time
+ */
+constexpr std::array<uint32_t, 256> fwu_crc_table()
+{
+    std::array<uint32_t, 256> t = {};
+    for (uint32_t i = 0; i < 256U; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+        {
+            c = (c & 1U) != 0U ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+        }
+        t[i] = c;
+    }
+    return t;
+}
+
+inline constexpr std::array<uint32_t, 256> FWU_CRC_TABLE = fwu_crc_table();
+
+/**
+ * @brief update a CRC-32 with more bytes, same value as zlib's crc32()
+ * @param crc 0 for the first call
+ */
+inline uint32_t fwu_crc32(uint32_t crc, const void *data, uint32_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    crc              = ~crc;
+    while (len-- != 0U)
+    {
+        crc = FWU_CRC_TABLE[(crc ^ *p++) & 0xFFU] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief CRC of the header fields in front of hcrc
+ */
+inline uint32_t fwu_header_crc(const FwuFrameHdr &h)
+{
+    return fwu_crc32(0, &h, sizeof(FwuFrameHdr) - sizeof(h.hcrc));
+}
@@ -0,0 +1,297 @@
+/**
+ *******************************************************************************
+ * @file    fwu-receiver.cpp
+ * @brief   device side of the firmware update protocol, stream to flash
+ *******************************************************************************
+ * @attention
+ *
+ * See fwu-receiver.hpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/7
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "fwu-receiver.hpp"
+#include <cstring>
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief fill a reply with the current position
+ */
+void FwuReceiver::make_reply(FwuReply &reply, FwuStatus status, uint32_t value) const
+{
+    reply.magic  = FWU_REPLY_MAGIC;
+    reply.status = status;
+    reply.offset = _expect;
+    reply.value  = value;
+}
+
+
+/**
+ * @brief start an update: erase what the image needs
+ */
+void FwuReceiver::begin(uint32_t size, uint32_t crc, FwuReply &reply)
+{
+    _stats      = {};
+    _size       = size;
+    _crc        = crc;
+    _expect     = 0;
+    _fill       = 0;
+    _nakPending = false;
+
+    if (size == 0U or size > _slot)
+    {
+        abort(FwuErrCode::FWU_TOO_BIG, reply);
+        return;
+    }
+
+    const uint32_t sector = _flash.geometry_getter().sectorSize;
+    for (uint32_t off = 0; off < size; off += sector)
+    {
+        if (_flash.erase_sector(_base + off) != FlashErrCode::FLASH_SUCCESS)
+        {
+            abort(FwuErrCode::FWU_FLASH_ERROR, reply);
+            return;
+        }
+    }
+
+    _state = State::HEADER;
+    make_reply(reply, FwuStatus::FWU_READY, FWU_WINDOW);
+}
+
+
+/**
+ * @brief give up, a later begin() starts over
+ */
+void FwuReceiver::abort(FwuErrCode err, FwuReply &reply)
+{
+    _state = State::FAILED;
+    make_reply(reply, FwuStatus::FWU_FAIL, static_cast<uint32_t>(err));
+}
+
+
+/**
+ * @brief the collected header is a header
+ */
+bool FwuReceiver::header_valid() const
+{
+    return _hdr.magic == FWU_FRAME_MAGIC and _hdr.hcrc == fwu_header_crc(_hdr);
+}
+
+
+/**
+ * @brief report a damaged frame, once until the expected frame comes
+ */
+void FwuReceiver::nak(FwuReply &reply, bool &has)
+{
+    if (not _nakPending)
+    {
+        _stats.naks++;
+        _nakPending = true;
+        make_reply(reply, FwuStatus::FWU_NAK, 0);
+        has = true;
+    }
+}
+
+
+/**
+ * @brief a whole valid header is in _hdr, decide what to do with its payload
+ */
+void FwuReceiver::header_done(FwuReply &reply, bool &has)
+{
+    _fill = 0;
+    if (_hdr.offset != _expect)
+    {
+        // a frame the host sent before it saw our NAK, or a resend of an
+        // acknowledged one: drop it, and tell where to restart if not done yet
+        _stats.skipped++;
+        nak(reply, has);
+        _state = _hdr.length != 0U ? State::SKIP : State::HEADER;
+        return;
+    }
+
+    // every frame but the last is full, so the offsets stay page aligned
+    const bool last = _hdr.offset + _hdr.length == _size;
+    if (_hdr.length == 0U or _hdr.length > FWU_CHUNK or _hdr.length > _size - _hdr.offset or
+        (_hdr.length != FWU_CHUNK and not last))
+    {
+        abort(FwuErrCode::FWU_BAD_FRAME, reply);
+        has = true;
+        return;
+    }
+    _nakPending = false; // the resend came, a damaged copy is reported again
+    _state      = State::PAYLOAD;
+}
+
+
+/**
+ * @brief program the checked payload, page by page
+ */
+FwuErrCode FwuReceiver::program_frame()
+{
+    const uint32_t page = _flash.geometry_getter().pageSize;
+    for (uint32_t off = 0; off < _hdr.length; off += page)
+    {
+        const uint32_t n = _hdr.length - off < page ? _hdr.length - off : page;
+        if (_flash.program(_base + _hdr.offset + off, &_frame[off], n) != FlashErrCode::FLASH_SUCCESS)
+        {
+            return FwuErrCode::FWU_FLASH_ERROR;
+        }
+        _stats.programs++;
+    }
+    return FwuErrCode::FWU_SUCCESS;
+}
+
+
+/**
+ * @brief CRC of the image as the flash holds it
+ */
+FwuErrCode FwuReceiver::check_image(uint32_t &crc)
+{
+    crc = 0;
+    for (uint32_t off = 0; off < _size; off += FWU_CHUNK)
+    {
+        const uint32_t n = _size - off < FWU_CHUNK ? _size - off : FWU_CHUNK;
+        if (_flash.read(_base + off, _frame, n) != FlashErrCode::FLASH_SUCCESS)
+        {
+            return FwuErrCode::FWU_FLASH_ERROR;
+        }
+        crc = fwu_crc32(crc, _frame, n);
+    }
+    return FwuErrCode::FWU_SUCCESS;
+}
+
+
+/**
+ * @brief the payload of the expected frame is complete
+ */
+void FwuReceiver::payload_done(FwuReply &reply, bool &has)
+{
+    _fill  = 0;
+    _state = State::HEADER;
+    has    = true;
+
+    if (fwu_crc32(0, _frame, _hdr.length) != _hdr.crc)
+    {
+        has = false;
+        nak(reply, has);
+        return;
+    }
+
+    FwuErrCode err = program_frame();
+    if (err != FwuErrCode::FWU_SUCCESS)
+    {
+        abort(err, reply);
+        return;
+    }
+    _expect += _hdr.length;
+    _stats.frames++;
+    _stats.bytes += _hdr.length;
+
+    if (_expect != _size)
+    {
+        make_reply(reply, FwuStatus::FWU_ACK, 0);
+        return;
+    }
+
+    // the last frame: trust the flash only after reading it back
+    uint32_t crc = 0;
+    err          = check_image(crc);
+    if (err != FwuErrCode::FWU_SUCCESS)
+    {
+        abort(err, reply);
+        return;
+    }
+    if (crc != _crc)
+    {
+        abort(FwuErrCode::FWU_CRC_MISMATCH, reply);
+        return;
+    }
+    _state = State::DONE;
+    make_reply(reply, FwuStatus::FWU_DONE, crc);
+}
+
+
+/**
+ * @brief process received bytes, stops after the first reply
+ */
+uint32_t FwuReceiver::feed(const uint8_t *data, uint32_t len, FwuReply &reply, bool &has)
+{
+    uint8_t *hdr = reinterpret_cast<uint8_t *>(&_hdr);
+    uint32_t pos = 0;
+    has          = false;
+
+    while (pos < len and not has and not finished() and _state != State::IDLE)
+    {
+        switch (_state)
+        {
+            case State::HEADER:
+            {
+                hdr[_fill++] = data[pos++];
+                if (_fill == 1U and hdr[0] != static_cast<uint8_t>(FWU_FRAME_MAGIC))
+                {
+                    _fill = 0; // not even the start of a magic
+                    _stats.hunted++;
+                }
+                else if (_fill == sizeof(FwuFrameHdr))
+                {
+                    if (header_valid())
+                    {
+                        header_done(reply, has);
+                    }
+                    else
+                    {
+                        // damaged header: report it, then slide one byte
+                        nak(reply, has);
+                        memmove(hdr, hdr + 1, sizeof(FwuFrameHdr) - 1U);
+                        _fill = sizeof(FwuFrameHdr) - 1U;
+                        _stats.hunted++;
+                    }
+                }
+                break;
+            }
+
+            case State::PAYLOAD:
+            case State::SKIP:
+            {
+                uint32_t n = _hdr.length - _fill;
+                n          = n < len - pos ? n : len - pos;
+                if (_state == State::PAYLOAD)
+                {
+                    memcpy(&_frame[_fill], &data[pos], n);
+                }
+                pos += n;
+                _fill += n;
+                if (_fill == _hdr.length)
+                {
+                    if (_state == State::PAYLOAD)
+                    {
+                        payload_done(reply, has);
+                    }
+                    else
+                    {
+                        _fill  = 0;
+                        _state = State::HEADER;
+                    }
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+    return pos;
+}
@@ -0,0 +1,159 @@
+/**
+ *******************************************************************************
+ * @file    fwu-receiver.hpp
+ * @brief   device side of the firmware update protocol, stream to flash
+ *******************************************************************************
+ * @attention
+ *
+ * Pure C++ on top of FlashIntf, like the sector cache: the same code runs on
+ * the host against FlashSimImpl (Tools/fwu/fwu-host.cpp -e). The owner feeds
+ * the bytes it receives and sends the replies it gets back, the receiver
+ * knows nothing of the link.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The whole slot is erased in begin(), before READY: on the single bank H723
+ * an erase stalls the bus for a long time, this way the stream itself only
+ * waits for word programs, short enough for the USB interrupt to keep up.
+ *
+ * A frame is collected in _frame and programmed page by page once its CRC
+ * checks. While it is programmed the next frames queue up in the CDC
+ * receive ring, which is the second buffer of the pipeline.
+ *
+ * See fwu-proto.hpp for the protocol.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/7
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "fwu-proto.hpp"
+#include "../../Drivers/Peripheral/Flash/flash-intf.hpp"
+#include <cstdint>
+
+
+
+
+/*-------- 2. receiver -------------------------------------------------------*/
+
+/**
+ * @brief stream of frames to a flash region
+ */
+class FwuReceiver
+{
+  public:
+    /**
+     * @brief counters, for the shell and the host test
+     */
+    struct Stats
+    {
+        uint32_t frames;        // accepted and programmed
+        uint32_t bytes;
+        uint32_t naks;
+        uint32_t skipped;       // valid frames at another offset
+        uint32_t hunted;        // bytes dropped looking for a header
+        uint32_t programs;
+    };
+
+    /**
+     * @param flash enabled flash driver
+     * @param base  first byte of the slot, sector aligned
+     * @param size  bytes of the slot, whole sectors
+     */
+    FwuReceiver(FlashIntf &flash, uint32_t base, uint32_t size) : _flash(flash), _base(base), _slot(size)
+    {
+    }
+
+    /**
+     * @brief start an update: erase what the image needs
+     * @param size  bytes of the image
+     * @param crc   CRC-32 of the image
+     * @param reply READY, or FAIL
+     */
+    void begin(uint32_t size, uint32_t crc, FwuReply &reply);
+
+    /**
+     * @brief process received bytes, stops after the first reply
+     * @param data  received bytes
+     * @param len   bytes at data
+     * @param reply filled when has is set
+     * @param has   set when reply must be sent to the host
+     * @return bytes consumed, feed the rest again
+     */
+    uint32_t feed(const uint8_t *data, uint32_t len, FwuReply &reply, bool &has);
+
+    /**
+     * @brief give up, a later begin() starts over
+     */
+    void abort(FwuErrCode err, FwuReply &reply);
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] bool finished() const
+    {
+        return _state == State::DONE or _state == State::FAILED;
+    }
+
+    [[nodiscard]] bool succeeded() const
+    {
+        return _state == State::DONE;
+    }
+
+    [[nodiscard]] uint32_t size_getter() const
+    {
+        return _size;
+    }
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    enum class State
+    {
+        IDLE,
+        HEADER,     // collecting a header, hunting when it is not valid
+        PAYLOAD,    // collecting the payload of the expected frame
+        SKIP,       // dropping the payload of a frame at another offset
+        DONE,
+        FAILED,
+    };
+
+    void make_reply(FwuReply &reply, FwuStatus status, uint32_t value) const;
+    bool header_valid() const;
+    void header_done(FwuReply &reply, bool &has);
+    void payload_done(FwuReply &reply, bool &has);
+    void nak(FwuReply &reply, bool &has);
+    [[nodiscard]] FwuErrCode program_frame();
+    [[nodiscard]] FwuErrCode check_image(uint32_t &crc);
+
+    FlashIntf &_flash;
+    uint32_t _base;
+    uint32_t _slot;
+
+    State _state      = State::IDLE;
+    uint32_t _size    = 0;
+    uint32_t _crc     = 0;
+    uint32_t _expect  = 0;      // next offset to program
+    uint32_t _fill    = 0;      // bytes of the header or payload collected
+    bool _nakPending  = false;  // a NAK was sent, stay silent until _expect comes
+
+    FwuFrameHdr _hdr = {};
+    alignas(32) uint8_t _frame[FWU_CHUNK] = {};
+    Stats _stats = {};
+};
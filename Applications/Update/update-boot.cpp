@@ -0,0 +1,280 @@
+/**
+ *******************************************************************************
+ * @file    update-boot.cpp
+ * @brief   the boot stub in sector 0: finishes a pending update, then starts the firmware
+ *******************************************************************************
+ * @attention
+ *
+ * Everything here is in the .boot section of sector 0, which an update never
+ * writes, and runs before the startup code: no .data, no .bss, no HAL, no
+ * library call, no constant outside the literal pools of these functions.
+ * Each function is BOOT_TEXT; a helper that is not would be linked in the
+ * firmware sectors, which the copy erases under it.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The copy is restartable instead of resumable at a precise point: the slot
+ * and its marker stay as they are until the marker is completed, so after a
+ * reset or a power loss in the middle of the copy the stub sees the marker
+ * again and starts over from the slot.
+ *
+ *      marker          slot CRC    firmware CRC    the stub
+ *      none, done      -           -               starts the firmware
+ *      pending         bad         -               marks FAILED, starts the firmware
+ *      pending         ok          ok              marks DONE (reset after the copy)
+ *      pending         ok          bad             copies, checks, marks DONE
+ *
+ * Every erase and program step checks the error flags of FLASH->SR1; a copy
+ * that fails or does not check is tried BOOT_TRIES times, then the stub
+ * stops: the slot is still whole and the next power up tries again.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/21
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define BOOT_TEXT           __attribute__((section(".boot.text"), noinline))
+#define BOOT_TRIES          3U
+#define BOOT_WORD_SIZE      (FLASH_NB_32BITWORD_IN_FLASHWORD * 4U)
+#define BOOT_ERRORS         (FLASH_SR_WRPERR | FLASH_SR_PGSERR | FLASH_SR_STRBERR | FLASH_SR_INCERR | FLASH_SR_OPERR)
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "update-intf.h"
+#include "stm32h7xx_hal.h"
+
+
+
+
+/* ------- function prototypes -----------------------------------------------*/
+
+extern "C" uint32_t _estack;
+extern "C" void boot_reset(void);
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+/**
+ * @brief the vector table the part boots from: a stack and a reset, the
+ *        firmware sets up its own table with VTOR
+ */
+__attribute__((used, section(".boot_vector"))) static const void *const s_bootVector[2] = {
+    &_estack, reinterpret_cast<const void *>(&boot_reset)};
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief leave the Run* mode of the supply, as ExitRun0Mode() which the copy may have erased
+ * @note  PWR_CR3 takes one write per power up, the one of ExitRun0Mode() later is the same
+ */
+BOOT_TEXT static void boot_supply(void)
+{
+#if defined(USE_PWR_LDO_SUPPLY) and defined(SMPS)
+    PWR->CR3 = (PWR->CR3 & ~PWR_CR3_SMPSEN) | PWR_CR3_LDOEN;
+#elif defined(USE_PWR_LDO_SUPPLY)
+    PWR->CR3 |= PWR_CR3_LDOEN;
+#else
+#error "update-boot.cpp: set the supply of this board as ExitRun0Mode() does"
+#endif
+    while ((PWR->CSR1 & PWR_CSR1_ACTVOSRDY) == 0U)
+    {
+    }
+}
+
+
+/**
+ * @brief CRC-32 of a range of the bank, bit by bit: the table of fwu-proto.hpp is in the firmware sectors
+ */
+BOOT_TEXT static uint32_t boot_crc(uint32_t addr, uint32_t len)
+{
+    const volatile uint8_t *p = reinterpret_cast<const volatile uint8_t *>(FLASH_BANK1_BASE + addr);
+    uint32_t crc              = 0xFFFFFFFFU;
+
+    while (len-- != 0U)
+    {
+        crc ^= *p++;
+        for (uint32_t b = 0; b < 8U; b++)
+        {
+            crc = (crc & 1U) != 0U ? 0xEDB88320U ^ (crc >> 1) : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+
+/**
+ * @brief wait for the end of an erase or a program
+ * @return true when FLASH->SR1 has no error flag, the flags are cleared otherwise
+ */
+BOOT_TEXT static bool boot_wait(void)
+{
+    while ((FLASH->SR1 & FLASH_SR_QW) != 0U)
+    {
+    }
+
+    const uint32_t err = FLASH->SR1 & BOOT_ERRORS;
+    if (err != 0U)
+    {
+        FLASH->CCR1 = err;
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief program one flash word of the bank from 8 words anywhere
+ */
+BOOT_TEXT static bool boot_program(uint32_t addr, const volatile uint32_t *src)
+{
+    // volatile so the compiler does not turn the loop into a memcpy call
+    volatile uint32_t *dst = reinterpret_cast<volatile uint32_t *>(FLASH_BANK1_BASE + addr);
+
+    FLASH->CR1 |= FLASH_CR_PG;
+    for (uint32_t i = 0; i < FLASH_NB_32BITWORD_IN_FLASHWORD; i++)
+    {
+        dst[i] = src[i];
+    }
+    __DSB();
+
+    const bool ok = boot_wait();
+    FLASH->CR1 &= ~FLASH_CR_PG;
+    return ok;
+}
+
+
+/**
+ * @brief erase the firmware sectors the image needs and program the slot over them
+ */
+BOOT_TEXT static bool boot_copy(uint32_t size)
+{
+    const uint32_t first = UPDATE_FW_BASE / FLASH_SECTOR_SIZE;
+    const uint32_t last  = (UPDATE_FW_BASE + size - 1U) / FLASH_SECTOR_SIZE;
+
+    for (uint32_t s = first; s <= last; s++)
+    {
+        FLASH->CR1 &= ~(FLASH_CR_PSIZE | FLASH_CR_SNB);
+        FLASH->CR1 |= FLASH_CR_SER | FLASH_VOLTAGE_RANGE_3 | (s << FLASH_CR_SNB_Pos) | FLASH_CR_START;
+        const bool ok = boot_wait();
+        FLASH->CR1 &= ~(FLASH_CR_SER | FLASH_CR_SNB);
+        if (not ok)
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t off = 0; off < size; off += BOOT_WORD_SIZE)
+    {
+        const volatile uint32_t *src =
+            reinterpret_cast<const volatile uint32_t *>(FLASH_BANK1_BASE + UPDATE_SLOT_BASE + off);
+        if (not boot_program(UPDATE_FW_BASE + off, src))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief finish the update the marker announces, then complete the marker
+ */
+BOOT_TEXT static void boot_update(const volatile UpdateMarkTypeDef *pending)
+{
+    const uint32_t size = pending->size;
+    const uint32_t crc  = pending->crc;
+
+    FLASH->KEYR1 = FLASH_KEY1;
+    FLASH->KEYR1 = FLASH_KEY2;
+    FLASH->CCR1  = BOOT_ERRORS | FLASH_CCR_CLR_EOP;
+
+    uint32_t result = UPDATE_MARK_DONE;
+    if (boot_crc(UPDATE_SLOT_BASE, size) != crc)
+    {
+        result = UPDATE_MARK_FAILED;
+    }
+    else if (boot_crc(UPDATE_FW_BASE, size) != crc)
+    {
+        uint32_t tries = 0;
+        while (not(boot_copy(size) and boot_crc(UPDATE_FW_BASE, size) == crc))
+        {
+            if (++tries == BOOT_TRIES)
+            {
+                FLASH->CR1 |= FLASH_CR_LOCK;
+                for (;;)
+                {
+                }
+            }
+        }
+    }
+
+    volatile uint32_t done[FLASH_NB_32BITWORD_IN_FLASHWORD];
+    done[0] = result;
+    done[1] = size;
+    done[2] = crc;
+    done[3] = ~(result ^ size ^ crc);
+    for (uint32_t i = 4; i < FLASH_NB_32BITWORD_IN_FLASHWORD; i++)
+    {
+        done[i] = 0xFFFFFFFFU;
+    }
+    // a failed program leaves the marker pending: the next boot finds the firmware checks and retries
+    (void)boot_program(UPDATE_MARK_BASE + BOOT_WORD_SIZE, done);
+
+    FLASH->CR1 |= FLASH_CR_LOCK;
+}
+
+
+/**
+ * @brief first code after reset: copy a pending update, then jump to the firmware
+ */
+extern "C" BOOT_TEXT __attribute__((noreturn)) void boot_reset(void)
+{
+    const volatile UpdateMarkTypeDef *mark =
+        reinterpret_cast<const volatile UpdateMarkTypeDef *>(FLASH_BANK1_BASE + UPDATE_MARK_BASE);
+
+    if (mark[0].magic == UPDATE_MARK_PENDING and mark[0].check == ~(mark[0].magic ^ mark[0].size ^ mark[0].crc) and
+        mark[0].size != 0U and mark[0].size <= UPDATE_FW_SIZE and mark[1].magic == 0xFFFFFFFFU)
+    {
+        boot_supply();
+        boot_update(&mark[0]);
+    }
+
+    const volatile uint32_t *vec = reinterpret_cast<const volatile uint32_t *>(FLASH_BANK1_BASE + UPDATE_FW_BASE);
+    const uint32_t sp            = vec[0];
+    const uint32_t pc            = vec[1];
+    if (pc == 0xFFFFFFFFU)
+    {
+        // no firmware, load one with the debugger
+        for (;;)
+        {
+        }
+    }
+
+    SCB->VTOR = FLASH_BANK1_BASE + UPDATE_FW_BASE;
+    __DSB();
+    __ISB();
+    __asm volatile("msr msp, %0\n"
+                   "bx  %1\n"
+                   :
+                   : "r"(sp), "r"(pc)
+                   : "memory");
+    for (;;)
+    {
+    }
+}
@@ -0,0 +1,172 @@
+/**
+ *******************************************************************************
+ * @file    update-flash.cpp
+ * @brief   the in-application firmware update, staged in internal flash
+ *******************************************************************************
+ * @attention
+ *
+ * update_receive() runs in the task that owns the link and blocks it for the
+ * whole transfer. update_apply() does not copy anything: it programs the
+ * "copy pending" marker and resets, the boot stub in sector 0
+ * (update-boot.cpp) does the copy before the firmware starts.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The staging slot is as large as the firmware sectors, so a staged image
+ * always fits the place it is copied to. Each update starts by erasing the
+ * marker sector: the marker of the previous update is gone before a byte
+ * of the new image reaches the slot.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/7
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "update-intf.h"
+#include "fwu-receiver.hpp"
+#include "../../Drivers/Peripheral/Flash/flash-intf.hpp"
+#include "stm32h7xx_hal.h"
+#include <cstring>
+#include <variant>
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static FlashIntf *s_flash = nullptr; // the internal bank, once update_receive() enabled it
+static uint32_t s_staged  = 0;       // bytes of a checked image in the slot, 0 for none
+static uint32_t s_crc     = 0;       // its CRC-32
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief the image starts with a vector table this part can boot from sector 1
+ * @note  an image objcopied with the boot stub starts with the table of the
+ *        stub, its PC is in sector 0 and fails here
+ */
+static bool update_image_bootable(uint32_t size)
+{
+    const uint32_t *vec = reinterpret_cast<const uint32_t *>(FLASH_BANK1_BASE + UPDATE_SLOT_BASE);
+    const uint32_t sp   = vec[0];
+    const uint32_t pc   = vec[1];
+
+    const bool spOk = (sp > D1_DTCMRAM_BASE and sp <= D1_DTCMRAM_BASE + 0x20000U) or
+                      (sp > D1_AXISRAM_BASE and sp <= D1_AXISRAM_BASE + 0x50000U);
+    const bool pcOk = (pc & 1U) != 0U and pc >= FLASH_BANK1_BASE + UPDATE_FW_BASE and
+                      pc < FLASH_BANK1_BASE + UPDATE_FW_BASE + size;
+    return spOk and pcOk;
+}
+
+
+/**
+ * @brief receive an image into the staging slot, replies go out on the link
+ */
+extern "C" int32_t update_receive(const UpdateLinkTypeDef *link, uint32_t size, uint32_t crc)
+{
+    FwuReply reply = {};
+    s_staged       = 0;
+
+    auto product = p_flash_internal_fcty->produce();
+    if (not std::holds_alternative<FlashIntf *>(product) or
+        std::get<FlashIntf *>(product)->enable() != FlashErrCode::FLASH_SUCCESS)
+    {
+        reply = {FWU_REPLY_MAGIC, FwuStatus::FWU_FAIL, 0, static_cast<uint32_t>(FwuErrCode::FWU_FLASH_ERROR)};
+        link->write(&reply, sizeof(reply));
+        return -1;
+    }
+
+    s_flash = std::get<FlashIntf *>(product);
+    if (s_flash->erase_sector(UPDATE_MARK_BASE) != FlashErrCode::FLASH_SUCCESS)
+    {
+        reply = {FWU_REPLY_MAGIC, FwuStatus::FWU_FAIL, 0, static_cast<uint32_t>(FwuErrCode::FWU_FLASH_ERROR)};
+        link->write(&reply, sizeof(reply));
+        return -1;
+    }
+
+    static FwuReceiver rx(*s_flash, UPDATE_SLOT_BASE, UPDATE_SLOT_SIZE);
+    static uint8_t buf[512];
+
+    rx.begin(size, crc, reply);
+    link->write(&reply, sizeof(reply));
+
+    while (not rx.finished())
+    {
+        const uint32_t n = link->read(buf, sizeof(buf), UPDATE_IDLE_MS);
+        if (n == 0U)
+        {
+            rx.abort(FwuErrCode::FWU_TIMEOUT, reply);
+            link->write(&reply, sizeof(reply));
+            break;
+        }
+
+        uint32_t pos = 0;
+        while (pos < n and not rx.finished())
+        {
+            bool has = false;
+            pos += rx.feed(&buf[pos], n - pos, reply, has);
+            if (not has)
+            {
+                continue;
+            }
+            if (reply.status == FwuStatus::FWU_DONE and not update_image_bootable(size))
+            {
+                rx.abort(FwuErrCode::FWU_BAD_IMAGE, reply);
+            }
+            link->write(&reply, sizeof(reply));
+        }
+    }
+
+    if (not rx.succeeded())
+    {
+        return -1;
+    }
+    s_staged = size;
+    s_crc    = crc;
+    return 0;
+}
+
+
+/**
+ * @brief mark the staged image pending and reset, the boot stub copies it
+ */
+extern "C" void update_apply(void)
+{
+    if (s_staged == 0U or s_flash == nullptr)
+    {
+        return;
+    }
+
+    UpdateMarkTypeDef mark = {};
+    mark.magic             = UPDATE_MARK_PENDING;
+    mark.size              = s_staged;
+    mark.crc               = s_crc;
+    mark.check             = ~(mark.magic ^ mark.size ^ mark.crc);
+    memset(mark.reserved, 0xFF, sizeof(mark.reserved));
+
+    UpdateMarkTypeDef back = {};
+    if (s_flash->program(UPDATE_MARK_BASE, reinterpret_cast<const uint8_t *>(&mark), sizeof(mark)) !=
+            FlashErrCode::FLASH_SUCCESS or
+        s_flash->read(UPDATE_MARK_BASE, reinterpret_cast<uint8_t *>(&back), sizeof(back)) !=
+            FlashErrCode::FLASH_SUCCESS or
+        memcmp(&mark, &back, sizeof(mark)) != 0)
+    {
+        // the marker sector is erased again by the next update_receive()
+        s_staged = 0;
+        return;
+    }
+
+    __disable_irq();
+    NVIC_SystemReset();
+}
@@ -0,0 +1,121 @@
+/**
+ *******************************************************************************
+ * @file    update-intf.h
+ * @brief   the interface of the in-application firmware update
+ *******************************************************************************
+ * @attention
+ *
+ * The bank of 8 sectors of 128 KB is split (see STM32H723XG_FLASH.ld):
+ *
+ *      sector  0       the boot stub, update-boot.cpp, never written by an update
+ *      sectors 1 to 3  the firmware
+ *      sectors 4 to 6  the staging slot
+ *      sector  7       the marker of a pending copy
+ *
+ * The running firmware is never touched until the staged copy is complete
+ * and its CRC checks. Then update_apply() writes a "copy pending" marker
+ * and resets; the boot stub copies the slot over the firmware, checks the
+ * result against the staged CRC and marks the copy done. A reset or a power
+ * loss during the copy only starts it over from the slot.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The link is given by the caller, today the benchmark task on the data CDC
+ * port ("update <size> <crc>", bench-intf.h). The protocol is in
+ * fwu-proto.hpp, the host side is Tools/fwu/fwu-host.cpp.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/7
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <stdint.h>
+
+
+
+
+/*-------- 2. define ---------------------------------------------------------*/
+
+#define UPDATE_FW_BASE      0x00020000U // offset in the bank, sector 1
+#define UPDATE_FW_SIZE      0x00060000U // sectors 1 to 3
+#define UPDATE_SLOT_BASE    0x00080000U // sector 4
+#define UPDATE_SLOT_SIZE    0x00060000U // sectors 4 to 6, also the largest image
+#define UPDATE_MARK_BASE    0x000E0000U // sector 7, two flash words: pending, then done
+#define UPDATE_IDLE_MS      2000U       // give up after this much host silence
+
+#define UPDATE_MARK_PENDING 0x50445755U // the slot holds an image to copy
+#define UPDATE_MARK_DONE    0x45444755U // copied and checked
+#define UPDATE_MARK_FAILED  0x4C494655U // the slot did not check, firmware left as it was
+
+
+
+
+/*-------- 3. typedef --------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief byte link the update runs on
+ */
+typedef struct
+{
+    /**
+     * @brief read what is available, waiting up to timeout ms for a first byte
+     * @return bytes read, 0 on timeout
+     */
+    uint32_t (*read)(uint8_t *buf, uint32_t len, uint32_t timeout);
+
+    /**
+     * @brief queue bytes for the host, may wait for room
+     */
+    void (*write)(const void *buf, uint32_t len);
+} UpdateLinkTypeDef;
+
+/**
+ * @brief a marker, one 32-byte flash word programmed once after the erase of sector 7
+ */
+typedef struct
+{
+    uint32_t magic;         // UPDATE_MARK_*, 0xFFFFFFFF while not written
+    uint32_t size;          // bytes of the staged image
+    uint32_t crc;           // CRC-32 of the staged image
+    uint32_t check;         // ~(magic ^ size ^ crc)
+    uint32_t reserved[4];   // 0xFFFFFFFF
+} UpdateMarkTypeDef;
+
+
+
+
+/*-------- 4. function prototypes --------------------------------------------*/
+
+/**
+ * @brief receive an image into the staging slot, replies go out on the link
+ * @param size bytes of the image
+ * @param crc  CRC-32 of the image
+ * @return 0 when the slot holds a checked image, -1 otherwise
+ */
+int32_t update_receive(const UpdateLinkTypeDef *link, uint32_t size, uint32_t crc);
+
+/**
+ * @brief mark the staged image pending and reset, the boot stub copies it
+ * @note  does not return when an image is staged and the marker is written
+ */
+void update_apply(void);
+
+#ifdef __cplusplus
+}
+#endif
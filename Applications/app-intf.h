@@ -1,16 +1,34 @@
 /**
  *******************************************************************************
- * @file    app_intf.h
- * @brief   简要描述
+ * @file    app-intf.h
+ * @brief   registration of the applications and of what they bring, in tables the linker builds
  *******************************************************************************
  * @attention
  *
- * none
+ * C++ only. No HAL, no RTOS: the same header builds on the host, where
+ * Tools/app-host/app-host.ld adds the tables of STM32H723XG_FLASH.ld to the
+ * default script of the host linker.
  *
  *******************************************************************************
  * @note
  *
- * none
+ * A module registers what it brings in its own source, nobody keeps the
+ * list. Each registration is a constexpr descriptor in a section of its
+ * own, ".<table>.<key>"; the linker script gathers the sections of a table
+ * sorted by name between __<table>_start and __<table>_end, in flash:
+ *
+ *      txq-cdc.cpp      APP_REGISTER(10, txq, txq_init)        .apps.10_txq    \
+ *      shell-cdc.cpp    APP_REGISTER(50, shell, shell_init)    .apps.50_shell   > .app_tables: txq, log, shell
+ *      log-ring.cpp     APP_REGISTER(20, log, log_init)        .apps.20_log    /
+ *
+ * The tables are read where they are: no copy to RAM, no constructor, no
+ * list built at boot. The descriptor of a key is also a symbol, table_key,
+ * so the same key twice in a table does not link.
+ *
+ * app_init_all() runs the init of every application by level, once,
+ * before the scheduler starts; a level has two digits as the linker sorts
+ * them as text. The shell commands are a table too, SHELL_COMMAND() in
+ * Shell/shell-args.hpp, sorted by command name.
  *
  *******************************************************************************
  * @author  MekLi
@@ -24,38 +42,107 @@
 
 /* Define to prevent recursive inclusion -----------------------------------------------------------------------------*/
 
+#pragma once
 
 
 
 
 /*-------- includes --------------------------------------------------------------------------------------------------*/
 
+#include <cstdint>
 
 
 
 
 /*-------- typedef ---------------------------------------------------------------------------------------------------*/
 
+/**
+ * @brief an application, what starts it
+ */
+struct AppDesc
+{
+    const char *name;
+    void (*init)(void);     // creates its tasks and queues, the scheduler not started yet
+};
 
+/**
+ * @brief the descriptors of a table, where the linker put them
+ */
+template <typename T>
+struct AppTable
+{
+    const T *first;
+    const T *last;
 
+    [[nodiscard]] const T *begin() const
+    {
+        return first;
+    }
 
+    [[nodiscard]] const T *end() const
+    {
+        return last;
+    }
 
-/*-------- define ----------------------------------------------------------------------------------------------------*/
+    [[nodiscard]] uint32_t count() const
+    {
+        return static_cast<uint32_t>(last - first);
+    }
+};
 
+template <typename T> AppTable(const T *, const T *) -> AppTable<T>;
 
 
 
 
 /*-------- macro -----------------------------------------------------------------------------------------------------*/
 
+/**
+ * @brief define the descriptor of `key` in `table`, of type `type`; the initializer follows
+ * @note  aligned to its type: the compiler aligns a large object more, which
+ *        would leave holes between the descriptors of a table
+ */
+#define APP_DESCRIPTOR(table, key, type)                                                                               \
+    extern const type table##_##key;                                                                                  \
+    __attribute__((used, section("." #table "." #key), aligned(alignof(type)))) constexpr type table##_##key
+
+/**
+ * @brief the bounds of a table, symbols of the linker script
+ */
+#define APP_TABLE_DECLARE(table, type) extern "C" const type __##table##_start[], __##table##_end[]
+
+/**
+ * @brief the AppTable of a table declared with APP_TABLE_DECLARE
+ */
+#define APP_TABLE(table) AppTable{__##table##_start, __##table##_end}
+
+/**
+ * @brief an application, started by app_init_all() at its level, 10 to 99
+ * @param init void init(void), returns once its tasks exist
+ */
+#define APP_REGISTER(level, name, init)                                                                                \
+    static_assert((level) >= 10 and (level) <= 99, "a level has two digits, the linker sorts them as text");        \
+    APP_DESCRIPTOR(apps, level##_##name, AppDesc) = {#name, init}
 
 
 
 
 /*-------- variables -------------------------------------------------------------------------------------------------*/
 
+APP_TABLE_DECLARE(apps, AppDesc);
 
 
 
 
 /*-------- function prototypes ---------------------------------------------------------------------------------------*/
+
+/**
+ * @brief start the applications, lowest level first; call once before the scheduler starts
+ */
+inline void app_init_all()
+{
+    for (const AppDesc &app : APP_TABLE(apps))
+    {
+        app.init();
+    }
+}
@@ -165,6 +165,25 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+
+/* SysTick_Handler is in stm32h7xx_it.c (USER CODE 1), measured for `top`:
+   keep the one of cmsis_os2.c out whatever the generated value above. */
+#undef USE_CUSTOM_SYSTICK_HANDLER_IMPLEMENTATION
+#define USE_CUSTOM_SYSTICK_HANDLER_IMPLEMENTATION 1
+
+/* CPU time per task and per interrupt group in DWT cycles, for `top`
+   (Applications/CpuLoad/cpu-load.h); thread local storage pointer 0 is the
+   task's record. */
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS  1
+#define INCLUDE_xTaskGetIdleTaskHandle           1
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  void cpu_load_start(void);
+  void cpu_load_switch_in(void *task, void **slot);
+  void cpu_load_task_delete(void *record);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()  cpu_load_start()
+#define traceTASK_SWITCHED_IN()  cpu_load_switch_in(pxCurrentTCB, &pxCurrentTCB->pvThreadLocalStoragePointers[0])
+#define traceTASK_DELETE(pxTCB)  cpu_load_task_delete((pxTCB)->pvThreadLocalStoragePointers[0])
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
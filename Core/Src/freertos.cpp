@@ -27,6 +27,7 @@
 /* USER CODE BEGIN Includes */
 #include "usb_device.h"
 #include "../../Drivers/Peripheral/GPIO/gpio-intf.hpp"
+#include "../../Applications/app-intf.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -97,6 +98,7 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  app_init_all(); /* every module registered with APP_REGISTER(), by level */
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -22,6 +22,16 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "usbd_conf.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "../../Applications/CpuLoad/cpu-load.h"
+#if (USBD_SOF_SYNC == 1U)
+#include "../../Applications/Sync/sof-sync.h"
+#endif /* USBD_SOF_SYNC */
+#if (USBD_FAST_PATH == 1U)
+#include "../../Applications/FastPath/fast-path.h"
+#endif /* USBD_FAST_PATH */
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -46,7 +56,7 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+void xPortSysTickHandler(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -166,11 +176,12 @@ void DebugMon_Handler(void)
 void TIM1_UP_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM1_UP_IRQn 0 */
-
+  CpuIsrFrameTypeDef cpu;
+  cpu_isr_enter(&cpu);
   /* USER CODE END TIM1_UP_IRQn 0 */
   HAL_TIM_IRQHandler(&htim1);
   /* USER CODE BEGIN TIM1_UP_IRQn 1 */
-
+  cpu_isr_exit(&cpu, CPU_ISR_HAL_TICK);
   /* USER CODE END TIM1_UP_IRQn 1 */
 }
 
@@ -180,14 +191,38 @@ void TIM1_UP_IRQHandler(void)
 void OTG_HS_IRQHandler(void)
 {
   /* USER CODE BEGIN OTG_HS_IRQn 0 */
-
+#if (USBD_SOF_SYNC == 1U)
+  sof_sync_irq_entry();
+#endif /* USBD_SOF_SYNC */
+#if (USBD_FAST_PATH == 1U)
+  fast_path_irq_entry();
+#endif /* USBD_FAST_PATH */
+  CpuIsrFrameTypeDef cpu;
+  cpu_isr_enter(&cpu);
   /* USER CODE END OTG_HS_IRQn 0 */
   HAL_PCD_IRQHandler(&hpcd_USB_OTG_HS);
   /* USER CODE BEGIN OTG_HS_IRQn 1 */
-
+  cpu_isr_exit(&cpu, CPU_ISR_USB);
   /* USER CODE END OTG_HS_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief The kernel tick, measured (USE_CUSTOM_SYSTICK_HANDLER_IMPLEMENTATION
+  *        is 1: this replaces the handler of cmsis_os2.c).
+  */
+void SysTick_Handler(void)
+{
+  CpuIsrFrameTypeDef cpu;
+  cpu_isr_enter(&cpu);
+  /* Clear overflow flag */
+  SysTick->CTRL;
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    xPortSysTickHandler();
+  }
+  cpu_isr_exit(&cpu, CPU_ISR_OS_TICK);
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,70 @@
+/**
+ *******************************************************************************
+ * @file    dwt-cycle.h
+ * @brief   the DWT cycle counter, shared time base for cheap timestamps
+ *******************************************************************************
+ * @attention
+ *
+ * The counter is 32 bits wide and wraps every 2^32 / SystemCoreClock seconds
+ * (about 7.8 s at 550 MHz): only differences of recent stamps are meaningful.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * Usable from C and C++, from tasks and from any interrupt priority: reading
+ * the counter is a single load and has no side effect.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/2
+ * @version 1.0
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "stm32h7xx.h"
+#include <stdint.h>
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief start the cycle counter, idempotent
+ */
+static inline void dwt_cycle_init(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U)
+    {
+        return;
+    }
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55U; // unlock the DWT on the Cortex-M7
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief current core cycle count
+ */
+static inline uint32_t dwt_cycle_now(void)
+{
+    return DWT->CYCCNT;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,186 @@
+/**
+ *******************************************************************************
+ * @file    flash-internal-impl.cpp
+ * @brief   the internal flash bank of the STM32H723 through HAL_FLASH
+ *******************************************************************************
+ * @attention
+ *
+ * The H723 has a single bank of 8 sectors of 128 KB, and the code runs from
+ * it: while a sector is erased or a flash word programmed, every fetch from
+ * the bank stalls, interrupts included. The driver is meant for maintenance
+ * work such as staging a firmware update, not for a live data path.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The program unit is the 256-bit flash word (the "page" of FlashIntf): its
+ * ECC is computed once, so a word can be programmed only once after an
+ * erase. A program shorter than a flash word is padded with 0xFF.
+ *
+ * Addresses are offsets from the start of the bank (FLASH_BANK1_BASE).
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/7
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define IFLASH_WORD_SIZE        (FLASH_NB_32BITWORD_IN_FLASHWORD * 4U)
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "flash-intf.hpp"
+#include "stm32h7xx_hal.h"
+#include <cstring>
+#include <variant>
+
+
+
+
+/* ------- class prototypes --------------------------------------------------*/
+
+/**
+ * @brief internal flash bank 1
+ */
+class flash_internal_impl_t final : public FlashIntf
+{
+  public:
+    FlashErrCode enable() override;
+    FlashErrCode read(uint32_t addr, uint8_t *buf, uint32_t len) override;
+    FlashErrCode program(uint32_t addr, const uint8_t *buf, uint32_t len) override;
+    FlashErrCode erase_sector(uint32_t addr) override;
+
+  private:
+    alignas(32) uint32_t _word[FLASH_NB_32BITWORD_IN_FLASHWORD] = {};
+};
+
+/**
+ * @brief factory of the internal flash, one bank on this part
+ */
+class flash_internal_fcty_impl_t : public FlashFctyIntf
+{
+    std::variant<FlashIntf *, FlashErrCode> produce() override
+    {
+        static flash_internal_impl_t flash;
+        return &flash;
+    }
+};
+
+flash_internal_fcty_impl_t flashInternalFcty;
+FlashFctyIntf *p_flash_internal_fcty = &flashInternalFcty;
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief fill the geometry, the bank is always there
+ */
+FlashErrCode flash_internal_impl_t::enable()
+{
+    _geometry   = {FLASH_BANK_SIZE, FLASH_SECTOR_SIZE, IFLASH_WORD_SIZE};
+    _isEnabled  = true;
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief read any range, the bank is memory mapped
+ */
+FlashErrCode flash_internal_impl_t::read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (not _isEnabled)
+    {
+        return FlashErrCode::FLASH_NOT_EN;
+    }
+    if (addr >= _geometry.size or len > _geometry.size - addr)
+    {
+        return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+    }
+
+    const void *src = reinterpret_cast<const void *>(FLASH_BANK1_BASE + addr);
+    if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U)
+    {
+        // the array changed under the cache if this range was programmed
+        SCB_InvalidateDCache_by_Addr(const_cast<void *>(src), static_cast<int32_t>(len));
+    }
+    memcpy(buf, src, len);
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief program one flash word, or the head of one padded with 0xFF
+ */
+FlashErrCode flash_internal_impl_t::program(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    FlashErrCode err = check_program(addr, len);
+    if (err != FlashErrCode::FLASH_SUCCESS)
+    {
+        return err;
+    }
+
+    // the word must start on a flash word boundary
+    if (addr % IFLASH_WORD_SIZE != 0U)
+    {
+        return FlashErrCode::FLASH_NOT_ALIGNED;
+    }
+
+    memset(_word, 0xFF, sizeof(_word));
+    memcpy(_word, buf, len);
+
+    if (HAL_FLASH_Unlock() != HAL_OK)
+    {
+        return FlashErrCode::FLASH_BUS_ERROR;
+    }
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_FLASHWORD, FLASH_BANK1_BASE + addr,
+                          static_cast<uint32_t>(reinterpret_cast<uintptr_t>(_word))) != HAL_OK)
+    {
+        err = (HAL_FLASH_GetError() & HAL_FLASH_ERROR_WRP) != 0U ? FlashErrCode::FLASH_BUS_ERROR
+                                                                  : FlashErrCode::FLASH_TIMEOUT;
+    }
+    (void)HAL_FLASH_Lock();
+    return err;
+}
+
+
+/**
+ * @brief erase the 128 KB sector starting at addr
+ */
+FlashErrCode flash_internal_impl_t::erase_sector(uint32_t addr)
+{
+    FlashErrCode err = check_erase(addr);
+    if (err != FlashErrCode::FLASH_SUCCESS)
+    {
+        return err;
+    }
+
+    FLASH_EraseInitTypeDef erase = {};
+    erase.TypeErase    = FLASH_TYPEERASE_SECTORS;
+    erase.Banks        = FLASH_BANK_1;
+    erase.Sector       = addr / FLASH_SECTOR_SIZE;
+    erase.NbSectors    = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    uint32_t bad       = 0;
+
+    if (HAL_FLASH_Unlock() != HAL_OK)
+    {
+        return FlashErrCode::FLASH_BUS_ERROR;
+    }
+    if (HAL_FLASHEx_Erase(&erase, &bad) != HAL_OK)
+    {
+        err = FlashErrCode::FLASH_TIMEOUT;
+    }
+    (void)HAL_FLASH_Lock();
+    return err;
+}
@@ -0,0 +1,230 @@
+/**
+*******************************************************************************
+* @file    flash-intf.hpp
+* @brief   the interface of NOR flash driver
+*******************************************************************************
+* @attention
+*
+* The interface does not include any HAL header: the sector cache and the host
+* tools are built against it on a PC with the simulated backend of
+* flash-sim-impl.hpp.
+*
+*******************************************************************************
+* @note
+*
+* Same layout as gpio-intf.hpp: enums, the interface, the factories.
+*
+* +---------------------------------------------------------------------------+
+* |                      flash-intf.hpp - interface                           |
+* +---------------------------------------------------------------------------+
+*               |                                   |
+* +------------------------------+   +----------------------------------------+
+* | flash-ospi-impl.cpp          |   | flash-sim-impl.hpp                     |
+* | SPI NOR behind OCTOSPI1      |   | RAM image with NOR rules, host & target|
+* +------------------------------+   +----------------------------------------+
+*               |
+* +------------------------------+
+* | flash-internal-impl.cpp      |
+* | on-chip bank, 32-byte words  |
+* +------------------------------+
+*
+* NOR rules every implementation follows:
+*   - an erase sets every byte of a sector to 0xFF
+*   - a program can only clear bits, and never crosses a page boundary
+*   - a read has no alignment constraint
+*
+* A device that can also be read in the address space hands out its window
+* with map(). The window is only valid under lock(): another task's read,
+* program or erase takes the bus back, so a user of map() copies what it
+* needs and unlocks:
+*
+*      flash.lock();
+*      const uint8_t *base = flash.map();      // nullptr: no window
+*      memcpy(op, base + addr, len);
+*      flash.unlock();
+*
+*******************************************************************************
+* @author  MekLi
+* @date    2025/9/6
+* @version 1.0
+*******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include <cstdint>
+#include <variant>
+
+
+
+
+/*-------- 2. enum -----------------------------------------------------------*/
+
+/**
+ * @brief flash driver error code
+ */
+enum class FlashErrCode
+{
+    FLASH_ERR_NONE,
+    FLASH_NOT_DETECTED,     // no answer to the JEDEC ID command
+    FLASH_NOT_EN,           // enable() was not called or failed
+    FLASH_ADDR_OUT_OF_RANGE,
+    FLASH_NOT_ALIGNED,      // erase not on a sector, program across a page
+    FLASH_BUS_ERROR,        // the controller refused the command
+    FLASH_TIMEOUT,          // the busy bit did not clear in time
+    FLASH_MEM_ALLOC_FAILED,
+    FLASH_SUCCESS,
+};
+
+/**
+ * @brief layout of the memory, in bytes
+ */
+struct FlashGeometry
+{
+    uint32_t size;          // whole device
+    uint32_t sectorSize;    // smallest erase unit
+    uint32_t pageSize;      // largest program unit
+};
+
+
+
+
+/*-------- 3. interface ------------------------------------------------------*/
+
+/**
+ * @brief 1.flash interface
+ */
+class FlashIntf
+{
+  public:
+    /**
+     * @brief probe the device and fill the geometry
+     */
+    [[nodiscard]] virtual FlashErrCode enable() = 0;
+
+    /**
+     * @brief read any range
+     */
+    [[nodiscard]] virtual FlashErrCode read(uint32_t addr, uint8_t *buf, uint32_t len) = 0;
+
+    /**
+     * @brief program inside one page, waits for the end of the program
+     */
+    [[nodiscard]] virtual FlashErrCode program(uint32_t addr, const uint8_t *buf, uint32_t len) = 0;
+
+    /**
+     * @brief erase the sector starting at addr, waits for the end of the erase
+     */
+    [[nodiscard]] virtual FlashErrCode erase_sector(uint32_t addr) = 0;
+
+    /**
+     * @brief keep the device for the caller, the driver's own calls nest inside
+     */
+    virtual void lock()
+    {
+    }
+
+    virtual void unlock()
+    {
+    }
+
+    /**
+     * @brief the whole device readable at the returned address, under lock()
+     * @return nullptr when the driver has no window or is not enabled
+     */
+    [[nodiscard]] virtual const uint8_t *map()
+    {
+        return nullptr;
+    }
+
+    virtual ~FlashIntf() = default;
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] const FlashGeometry &geometry_getter() const
+    {
+        return this->_geometry;
+    }
+
+    [[nodiscard]] bool enable_getter() const
+    {
+        return this->_isEnabled;
+    }
+
+    /****************** setter & getter *******************/
+
+
+  protected:
+    /**
+     * @brief common argument check of program()
+     */
+    [[nodiscard]] FlashErrCode check_program(uint32_t addr, uint32_t len) const
+    {
+        if (not _isEnabled)
+        {
+            return FlashErrCode::FLASH_NOT_EN;
+        }
+        if (addr >= _geometry.size or len > _geometry.size - addr)
+        {
+            return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+        }
+        if (len == 0U or (addr % _geometry.pageSize) + len > _geometry.pageSize)
+        {
+            return FlashErrCode::FLASH_NOT_ALIGNED;
+        }
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+
+    /**
+     * @brief common argument check of erase_sector()
+     */
+    [[nodiscard]] FlashErrCode check_erase(uint32_t addr) const
+    {
+        if (not _isEnabled)
+        {
+            return FlashErrCode::FLASH_NOT_EN;
+        }
+        if (addr >= _geometry.size)
+        {
+            return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+        }
+        if (addr % _geometry.sectorSize != 0U)
+        {
+            return FlashErrCode::FLASH_NOT_ALIGNED;
+        }
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+
+    FlashGeometry _geometry = {0, 4096, 256};
+    bool _isEnabled         = false;
+};
+
+
+/**
+ * @brief 2. abstract factory
+ */
+class FlashFctyIntf
+{
+  public:
+    virtual ~FlashFctyIntf() = default;
+
+    /**
+     * @brief The produce method of the factory
+     */
+    [[nodiscard]] virtual std::variant<FlashIntf *, FlashErrCode> produce() = 0;
+};
+
+
+
+
+/*-------- 4. factories ------------------------------------------------------*/
+
+extern FlashFctyIntf *p_flash_ospi_fcty;     // SPI NOR flash on OCTOSPI1 (hospi1)
+extern FlashFctyIntf *p_flash_internal_fcty; // on-chip flash bank 1, through HAL_FLASH
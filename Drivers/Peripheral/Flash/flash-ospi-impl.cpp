@@ -0,0 +1,559 @@
+/**
+ *******************************************************************************
+ * @file    flash-ospi-impl.cpp
+ * @brief   SPI NOR flash behind OCTOSPI1, indirect mode, memory-mapped on request
+ *******************************************************************************
+ * @attention
+ *
+ * hospi1 is configured by CubeMX in quad mode (IO0..IO3). Only commands that
+ * the common 3 V quad NOR parts (Winbond W25Q, Micron MT25Q, Macronix MX25L,
+ * ISSI IS25LP) share are used:
+ *
+ *      0x9F  JEDEC ID              1-0-1
+ *      0x05  read status 1         1-0-1
+ *      0x06  write enable          1-0-0
+ *      0x6B  quad output read      1-1-4, 8 dummy cycles   (0x6C, 4-byte)
+ *      0x02  page program          1-1-1                   (0x12, 4-byte)
+ *      0x20  4 KB sector erase     1-1-0                   (0x21, 4-byte)
+ *
+ * The page program is single line on purpose: the quad program opcode is
+ * not the same on every vendor and tPP (~0.4 ms) dwarfs the 20 us of data.
+ *
+ *******************************************************************************
+ * @note
+ *
+ * The capacity comes from the third byte of the JEDEC ID. Parts above 16 MB
+ * are driven with the 4-byte address opcodes, so the address mode register
+ * of the flash is never touched. The quad enable bit is set on the vendors
+ * that need it, this is a non volatile write done once in the life of the
+ * part.
+ *
+ * Erase completion is polled with a 1 ms sleep between reads of the status
+ * register once the scheduler runs: a 45 ms erase leaves the CPU to the other
+ * tasks. Program completion is polled without sleeping.
+ *
+ * map() switches the controller to memory-mapped mode, the part then reads
+ * at OCTOSPI1_BASE with the same quad output read. MPU region 0 leaves that
+ * address without access, so the window opens region NOR_MAP_MPU_REGION over
+ * the part, read only and never executed, and closes it before the next
+ * indirect command aborts the memory-mapped mode. Every public call takes
+ * the recursive bus mutex, lock() takes it for a caller reading the window.
+ *
+ *******************************************************************************
+ * @author  MekLi
+ * @date    2025/9/6
+ * @version 1.0
+ *******************************************************************************
+ */
+
+
+
+
+/* ------- define ------------------------------------------------------------*/
+
+#define NOR_CMD_READ_ID         0x9FU
+#define NOR_CMD_READ_SR1        0x05U
+#define NOR_CMD_READ_SR2        0x35U
+#define NOR_CMD_WRITE_SR1       0x01U
+#define NOR_CMD_WRITE_SR2       0x31U
+#define NOR_CMD_WRITE_EN        0x06U
+#define NOR_CMD_READ_QUAD       0x6BU
+#define NOR_CMD_READ_QUAD_4B    0x6CU
+#define NOR_CMD_PROGRAM         0x02U
+#define NOR_CMD_PROGRAM_4B      0x12U
+#define NOR_CMD_ERASE_4K        0x20U
+#define NOR_CMD_ERASE_4K_4B     0x21U
+
+#define NOR_SR1_BUSY            0x01U
+#define NOR_READ_DUMMY          8U
+
+#define NOR_MFR_WINBOND         0xEFU
+#define NOR_MFR_MACRONIX        0xC2U
+#define NOR_MFR_ISSI            0x9DU
+
+#define NOR_PROGRAM_TIMEOUT_MS  5U
+#define NOR_ERASE_TIMEOUT_MS    500U
+#define NOR_SR_TIMEOUT_MS       50U
+
+#define NOR_MAP_MPU_REGION      MPU_REGION_NUMBER1
+#define NOR_MAP_SHIFT_MAX       28U     // the OCTOSPI1 window is 256 MB
+
+
+
+
+/* ------- include -----------------------------------------------------------*/
+
+#include "flash-intf.hpp"
+#include "cmsis_os.h"
+#include "octospi.h"
+#include "stm32h7xx_hal.h"
+#include "FreeRTOS.h"
+#include <variant>
+
+
+
+
+/* ------- class prototypes --------------------------------------------------*/
+
+/**
+ * @brief quad SPI NOR on OCTOSPI1
+ */
+class flash_ospi_impl_t final : public FlashIntf
+{
+  public:
+    explicit flash_ospi_impl_t(OSPI_HandleTypeDef *hospi) : _hospi(hospi)
+    {
+    }
+    FlashErrCode enable() override;
+    FlashErrCode read(uint32_t addr, uint8_t *buf, uint32_t len) override;
+    FlashErrCode program(uint32_t addr, const uint8_t *buf, uint32_t len) override;
+    FlashErrCode erase_sector(uint32_t addr) override;
+    void lock() override;
+    void unlock() override;
+    const uint8_t *map() override;
+
+  private:
+    /**
+     * @brief the bus for one indirect call: locked, out of memory-mapped mode
+     */
+    class Indirect
+    {
+      public:
+        explicit Indirect(flash_ospi_impl_t &flash) : _flash(flash)
+        {
+            _flash.lock();
+            _flash.unmap();
+        }
+        ~Indirect()
+        {
+            _flash.unlock();
+        }
+
+      private:
+        flash_ospi_impl_t &_flash;
+    };
+
+    FlashErrCode command(uint8_t opcode, bool hasAddr, uint32_t addr, uint32_t dataLines,
+                         uint32_t dummy, uint32_t nbData,
+                         uint32_t operation = HAL_OSPI_OPTYPE_COMMON_CFG) const;
+    FlashErrCode read_reg(uint8_t opcode, uint8_t *buf, uint32_t len) const;
+    FlashErrCode write_reg(uint8_t opcode, uint8_t value) const;
+    FlashErrCode write_enable() const;
+    FlashErrCode wait_ready(uint32_t timeoutMs, bool sleep) const;
+    FlashErrCode enable_quad(uint8_t mfr) const;
+    void unmap();
+
+    OSPI_HandleTypeDef *_hospi;
+    bool _addr4          = false;
+    bool _mapped         = false;
+    uint32_t _shift      = 0;       // log2 of the size
+    osMutexId_t _busLock = nullptr;
+};
+
+/**
+ * @brief factory of the OCTOSPI1 flash, one device on the board
+ */
+class flash_ospi_fcty_impl_t : public FlashFctyIntf
+{
+    std::variant<FlashIntf *, FlashErrCode> produce() override
+    {
+        static flash_ospi_impl_t flash(&hospi1);
+        return &flash;
+    }
+};
+
+flash_ospi_fcty_impl_t flashOspiFcty;
+FlashFctyIntf *p_flash_ospi_fcty = &flashOspiFcty;
+
+
+
+
+/* ------- variables ---------------------------------------------------------*/
+
+static StaticSemaphore_t s_bus_lock_cb;
+static const osMutexAttr_t s_bus_lock_attr = {
+    .name      = "nor",
+    .attr_bits = osMutexRecursive | osMutexPrioInherit,
+    .cb_mem    = &s_bus_lock_cb,
+    .cb_size   = sizeof(s_bus_lock_cb),
+};
+
+
+
+
+/* ------- function implement ------------------------------------------------*/
+
+/**
+ * @brief issue the instruction, address and dummy phases of one command
+ * @param opcode    instruction, single line
+ * @param hasAddr   send `addr` on a single line, 3 or 4 bytes
+ * @param dataLines HAL_OSPI_DATA_NONE, HAL_OSPI_DATA_1_LINE or HAL_OSPI_DATA_4_LINES
+ * @param dummy     dummy cycles before the data
+ * @param nbData    bytes of the data phase
+ * @param operation HAL_OSPI_OPTYPE_READ_CFG / _WRITE_CFG: the command of the
+ *                  memory-mapped mode, nothing is sent
+ */
+FlashErrCode flash_ospi_impl_t::command(uint8_t opcode, bool hasAddr, uint32_t addr, uint32_t dataLines,
+                                        uint32_t dummy, uint32_t nbData, uint32_t operation) const
+{
+    OSPI_RegularCmdTypeDef cmd = {};
+    cmd.OperationType          = operation;
+    cmd.FlashId                = HAL_OSPI_FLASH_ID_1;
+    cmd.Instruction            = opcode;
+    cmd.InstructionMode        = HAL_OSPI_INSTRUCTION_1_LINE;
+    cmd.InstructionSize        = HAL_OSPI_INSTRUCTION_8_BITS;
+    cmd.InstructionDtrMode     = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
+    cmd.Address                = addr;
+    cmd.AddressMode            = hasAddr ? HAL_OSPI_ADDRESS_1_LINE : HAL_OSPI_ADDRESS_NONE;
+    cmd.AddressSize            = _addr4 ? HAL_OSPI_ADDRESS_32_BITS : HAL_OSPI_ADDRESS_24_BITS;
+    cmd.AddressDtrMode         = HAL_OSPI_ADDRESS_DTR_DISABLE;
+    cmd.AlternateBytesMode     = HAL_OSPI_ALTERNATE_BYTES_NONE;
+    cmd.DataMode               = dataLines;
+    cmd.NbData                 = nbData;
+    cmd.DataDtrMode            = HAL_OSPI_DATA_DTR_DISABLE;
+    cmd.DummyCycles            = dummy;
+    cmd.DQSMode                = HAL_OSPI_DQS_DISABLE;
+    cmd.SIOOMode               = HAL_OSPI_SIOO_INST_EVERY_CMD;
+
+    if (HAL_OSPI_Command(_hospi, &cmd, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+    {
+        return FlashErrCode::FLASH_BUS_ERROR;
+    }
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief read a register (ID, status) on a single line
+ */
+FlashErrCode flash_ospi_impl_t::read_reg(uint8_t opcode, uint8_t *buf, uint32_t len) const
+{
+    const FlashErrCode err = command(opcode, false, 0, HAL_OSPI_DATA_1_LINE, 0, len);
+    if (err != FlashErrCode::FLASH_SUCCESS)
+    {
+        return err;
+    }
+    if (HAL_OSPI_Receive(_hospi, buf, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+    {
+        return FlashErrCode::FLASH_BUS_ERROR;
+    }
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief write one status register byte and wait for the end of the write
+ */
+FlashErrCode flash_ospi_impl_t::write_reg(uint8_t opcode, uint8_t value) const
+{
+    FlashErrCode err = write_enable();
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = command(opcode, false, 0, HAL_OSPI_DATA_1_LINE, 0, 1);
+    }
+    if (err == FlashErrCode::FLASH_SUCCESS and HAL_OSPI_Transmit(_hospi, &value, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+    {
+        err = FlashErrCode::FLASH_BUS_ERROR;
+    }
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = wait_ready(NOR_SR_TIMEOUT_MS, true);
+    }
+    return err;
+}
+
+
+/**
+ * @brief set the write enable latch, needed before every program and erase
+ */
+FlashErrCode flash_ospi_impl_t::write_enable() const
+{
+    return command(NOR_CMD_WRITE_EN, false, 0, HAL_OSPI_DATA_NONE, 0, 0);
+}
+
+
+/**
+ * @brief poll the busy bit
+ * @param timeoutMs give up after this time
+ * @param sleep     yield 1 ms between two polls when the scheduler runs
+ */
+FlashErrCode flash_ospi_impl_t::wait_ready(uint32_t timeoutMs, bool sleep) const
+{
+    const uint32_t start = HAL_GetTick();
+    sleep                = sleep and osKernelGetState() == osKernelRunning;
+    for (;;)
+    {
+        uint8_t sr             = 0;
+        const FlashErrCode err = read_reg(NOR_CMD_READ_SR1, &sr, 1);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        if ((sr & NOR_SR1_BUSY) == 0U)
+        {
+            return FlashErrCode::FLASH_SUCCESS;
+        }
+        if (HAL_GetTick() - start > timeoutMs)
+        {
+            return FlashErrCode::FLASH_TIMEOUT;
+        }
+        if (sleep)
+        {
+            osDelay(1);
+        }
+    }
+}
+
+
+/**
+ * @brief set the quad enable bit on the vendors that gate IO2/IO3 with it
+ */
+FlashErrCode flash_ospi_impl_t::enable_quad(uint8_t mfr) const
+{
+    uint8_t sr       = 0;
+    FlashErrCode err = FlashErrCode::FLASH_SUCCESS;
+
+    switch (mfr)
+    {
+    case NOR_MFR_WINBOND: // QE is bit 1 of status register 2
+        err = read_reg(NOR_CMD_READ_SR2, &sr, 1);
+        if (err == FlashErrCode::FLASH_SUCCESS and (sr & 0x02U) == 0U)
+        {
+            err = write_reg(NOR_CMD_WRITE_SR2, static_cast<uint8_t>(sr | 0x02U));
+        }
+        break;
+
+    case NOR_MFR_MACRONIX: // QE is bit 6 of the status register
+    case NOR_MFR_ISSI:
+        err = read_reg(NOR_CMD_READ_SR1, &sr, 1);
+        if (err == FlashErrCode::FLASH_SUCCESS and (sr & 0x40U) == 0U)
+        {
+            err = write_reg(NOR_CMD_WRITE_SR1, static_cast<uint8_t>(sr | 0x40U));
+        }
+        break;
+
+    default: // Micron and others: quad output read needs no enable bit
+        break;
+    }
+    return err;
+}
+
+
+/**
+ * @brief probe the part and fill the geometry
+ * @return FLASH_NOT_DETECTED when the ID reads as all 0 or all 1
+ */
+FlashErrCode flash_ospi_impl_t::enable()
+{
+    uint8_t id[3] = {0, 0, 0};
+
+    if (_busLock == nullptr)
+    {
+        _busLock = osMutexNew(&s_bus_lock_attr);
+    }
+    const Indirect bus(*this);
+    _isEnabled       = false;
+    _addr4           = false;
+    FlashErrCode err = read_reg(NOR_CMD_READ_ID, id, sizeof(id));
+    if (err != FlashErrCode::FLASH_SUCCESS)
+    {
+        return err;
+    }
+    if ((id[0] == 0x00U and id[1] == 0x00U) or (id[0] == 0xFFU and id[1] == 0xFFU))
+    {
+        return FlashErrCode::FLASH_NOT_DETECTED;
+    }
+
+    /* capacity code: 2^n bytes up to 0x1F, Micron and Winbond continue at 0x20 = 64 MB */
+    const uint8_t code = id[2];
+    if (code < 0x10U or code > 0x22U)
+    {
+        return FlashErrCode::FLASH_NOT_DETECTED;
+    }
+    const uint32_t shift = code <= 0x1FU ? code : code - 6U;
+    _geometry.size       = shift >= 32U ? 0xFFFFFFFFU : (1UL << shift);
+    _geometry.sectorSize = 4096;
+    _geometry.pageSize   = 256;
+    _addr4               = _geometry.size > (16UL << 20);
+    _shift               = shift;
+
+    err = enable_quad(id[0]);
+    if (err != FlashErrCode::FLASH_SUCCESS)
+    {
+        return err;
+    }
+    _isEnabled = true;
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief quad output read of any range
+ */
+FlashErrCode flash_ospi_impl_t::read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    const Indirect bus(*this);
+    if (not _isEnabled)
+    {
+        return FlashErrCode::FLASH_NOT_EN;
+    }
+    if (addr >= _geometry.size or len > _geometry.size - addr)
+    {
+        return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+    }
+    if (len == 0U)
+    {
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+    const FlashErrCode err = command(_addr4 ? NOR_CMD_READ_QUAD_4B : NOR_CMD_READ_QUAD, true, addr,
+                                     HAL_OSPI_DATA_4_LINES, NOR_READ_DUMMY, len);
+    if (err != FlashErrCode::FLASH_SUCCESS)
+    {
+        return err;
+    }
+    if (HAL_OSPI_Receive(_hospi, buf, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+    {
+        return FlashErrCode::FLASH_BUS_ERROR;
+    }
+    return FlashErrCode::FLASH_SUCCESS;
+}
+
+
+/**
+ * @brief page program, the range must stay inside one page
+ */
+FlashErrCode flash_ospi_impl_t::program(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    const Indirect bus(*this);
+    FlashErrCode err = check_program(addr, len);
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = write_enable();
+    }
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = command(_addr4 ? NOR_CMD_PROGRAM_4B : NOR_CMD_PROGRAM, true, addr, HAL_OSPI_DATA_1_LINE, 0, len);
+    }
+    if (err == FlashErrCode::FLASH_SUCCESS and
+        HAL_OSPI_Transmit(_hospi, const_cast<uint8_t *>(buf), HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+    {
+        err = FlashErrCode::FLASH_BUS_ERROR;
+    }
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = wait_ready(NOR_PROGRAM_TIMEOUT_MS, false);
+    }
+    return err;
+}
+
+
+/**
+ * @brief erase the 4 KB sector starting at addr
+ */
+FlashErrCode flash_ospi_impl_t::erase_sector(uint32_t addr)
+{
+    const Indirect bus(*this);
+    FlashErrCode err = check_erase(addr);
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = write_enable();
+    }
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = command(_addr4 ? NOR_CMD_ERASE_4K_4B : NOR_CMD_ERASE_4K, true, addr, HAL_OSPI_DATA_NONE, 0, 0);
+    }
+    if (err == FlashErrCode::FLASH_SUCCESS)
+    {
+        err = wait_ready(NOR_ERASE_TIMEOUT_MS, true);
+    }
+    return err;
+}
+
+
+/**
+ * @note  before the scheduler runs, and before enable(), there is no one to
+ *        share the bus with
+ */
+void flash_ospi_impl_t::lock()
+{
+    if (_busLock != nullptr and osKernelGetState() == osKernelRunning)
+    {
+        (void)osMutexAcquire(_busLock, osWaitForever);
+    }
+}
+
+
+void flash_ospi_impl_t::unlock()
+{
+    if (_busLock != nullptr and osKernelGetState() == osKernelRunning)
+    {
+        (void)osMutexRelease(_busLock);
+    }
+}
+
+
+/**
+ * @brief the part at OCTOSPI1_BASE, up to the next indirect call
+ * @note  the write command is the page program: the HAL wants both before
+ *        the memory-mapped mode, the MPU region keeps the window read only
+ */
+const uint8_t *flash_ospi_impl_t::map()
+{
+    if (not _isEnabled)
+    {
+        return nullptr;
+    }
+    if (not _mapped)
+    {
+        FlashErrCode err = command(_addr4 ? NOR_CMD_READ_QUAD_4B : NOR_CMD_READ_QUAD, true, 0,
+                                   HAL_OSPI_DATA_4_LINES, NOR_READ_DUMMY, 0, HAL_OSPI_OPTYPE_READ_CFG);
+        if (err == FlashErrCode::FLASH_SUCCESS)
+        {
+            err = command(_addr4 ? NOR_CMD_PROGRAM_4B : NOR_CMD_PROGRAM, true, 0, HAL_OSPI_DATA_1_LINE, 0, 0,
+                          HAL_OSPI_OPTYPE_WRITE_CFG);
+        }
+        OSPI_MemoryMappedTypeDef mapped = {};
+        mapped.TimeOutActivation        = HAL_OSPI_TIMEOUT_COUNTER_DISABLE;
+        if (err != FlashErrCode::FLASH_SUCCESS or HAL_OSPI_MemoryMapped(_hospi, &mapped) != HAL_OK)
+        {
+            (void)HAL_OSPI_Abort(_hospi);
+            return nullptr;
+        }
+
+        const uint32_t shift          = _shift < NOR_MAP_SHIFT_MAX ? _shift : NOR_MAP_SHIFT_MAX;
+        MPU_Region_InitTypeDef region = {};
+        region.Enable                 = MPU_REGION_ENABLE;
+        region.Number                 = NOR_MAP_MPU_REGION;
+        region.BaseAddress            = OCTOSPI1_BASE;
+        region.Size                   = static_cast<uint8_t>(shift - 1U); // MPU_REGION_SIZE_32B is 2^5
+        region.SubRegionDisable       = 0x00;
+        region.TypeExtField           = MPU_TEX_LEVEL1;
+        region.AccessPermission       = MPU_REGION_PRIV_RO_URO;
+        region.DisableExec            = MPU_INSTRUCTION_ACCESS_DISABLE;
+        region.IsShareable            = MPU_ACCESS_NOT_SHAREABLE;
+        region.IsCacheable            = MPU_ACCESS_NOT_CACHEABLE;
+        region.IsBufferable           = MPU_ACCESS_NOT_BUFFERABLE;
+        HAL_MPU_ConfigRegion(&region);
+        __DSB();
+        __ISB();
+        _mapped = true;
+    }
+    return reinterpret_cast<const uint8_t *>(OCTOSPI1_BASE);
+}
+
+
+/**
+ * @brief close the window and leave the memory-mapped mode, if open
+ */
+void flash_ospi_impl_t::unmap()
+{
+    if (not _mapped)
+    {
+        return;
+    }
+    HAL_MPU_DisableRegion(NOR_MAP_MPU_REGION);
+    __DSB();
+    __ISB();
+    (void)HAL_OSPI_Abort(_hospi);
+    _mapped = false;
+}
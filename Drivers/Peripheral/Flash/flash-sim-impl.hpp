@@ -0,0 +1,201 @@
+/**
+*******************************************************************************
+* @file    flash-sim-impl.hpp
+* @brief   simulated NOR flash, RAM image with NOR rules and a timing model
+*******************************************************************************
+* @attention
+*
+* Header only and free of HAL code, meant for the host: Tools/msc-sim builds
+* the sector cache on top of it. The image is heap allocated, do not use it
+* on the target for more than a few sectors.
+*
+*******************************************************************************
+* @note
+*
+* A program ANDs the data into the image like the real array does. Setting a
+* bit that is 0 is counted in `violations`: with a correct user of the driver
+* that counter stays at 0.
+*
+* Every operation adds its duration to `busyNs` with the typical timings of a
+* quad SPI NOR at 100 MHz (W25Q / MT25Q / MX25 class parts), so a workload
+* can be turned into a throughput without the hardware.
+*
+* map() gives the image itself: what the OSPI driver reads through the
+* memory-mapped window, the host reads here, without counting it.
+*
+*******************************************************************************
+* @author  MekLi
+* @date    2025/9/6
+* @version 1.0
+*******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+
+#pragma once
+
+
+
+
+/*-------- 1. includes & imports ---------------------------------------------*/
+
+#include "flash-intf.hpp"
+#include <cstring>
+#include <vector>
+
+
+
+
+/*-------- 2. implementation -------------------------------------------------*/
+
+/**
+ * @brief simulated flash
+ */
+class FlashSimImpl final : public FlashIntf
+{
+  public:
+    /**
+     * @brief datasheet timings, nanoseconds
+     */
+    struct Timing
+    {
+        uint64_t cmdNs;         // command + address + dummy cycles
+        uint64_t readNsPerByte; // quad output read
+        uint64_t progNsPerByte; // single line data phase of a page program
+        uint64_t progNs;        // tPP, page program time
+        uint64_t eraseNs;       // tSE, 4 KB sector erase time
+    };
+
+    /**
+     * @brief operation counters
+     */
+    struct Stats
+    {
+        uint64_t reads;
+        uint64_t readBytes;
+        uint64_t programs;
+        uint64_t programBytes;
+        uint64_t erases;
+        uint64_t violations;    // bits a program tried to raise
+        uint64_t busyNs;        // modelled time spent in the flash
+    };
+
+    static constexpr Timing default_timing()
+    {
+        return Timing{400, 20, 80, 400000, 45000000};
+    }
+
+    explicit FlashSimImpl(uint32_t size, uint32_t sectorSize = 4096, uint32_t pageSize = 256,
+                          const Timing &timing = default_timing())
+        : _timing(timing)
+    {
+        _geometry = {size, sectorSize, pageSize};
+    }
+
+    [[nodiscard]] FlashErrCode enable() override
+    {
+        _image.assign(_geometry.size, 0xFFU);
+        _eraseCount.assign(_geometry.size / _geometry.sectorSize, 0U);
+        _stats     = {};
+        _isEnabled = true;
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+
+    [[nodiscard]] FlashErrCode read(uint32_t addr, uint8_t *buf, uint32_t len) override
+    {
+        if (not _isEnabled)
+        {
+            return FlashErrCode::FLASH_NOT_EN;
+        }
+        if (addr >= _geometry.size or len > _geometry.size - addr)
+        {
+            return FlashErrCode::FLASH_ADDR_OUT_OF_RANGE;
+        }
+        std::memcpy(buf, &_image[addr], len);
+        _stats.reads++;
+        _stats.readBytes += len;
+        _stats.busyNs += _timing.cmdNs + _timing.readNsPerByte * len;
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+
+    [[nodiscard]] FlashErrCode program(uint32_t addr, const uint8_t *buf, uint32_t len) override
+    {
+        const FlashErrCode err = check_program(addr, len);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        for (uint32_t i = 0; i < len; i++)
+        {
+            if ((buf[i] & ~_image[addr + i]) != 0U)
+            {
+                _stats.violations++;
+            }
+            _image[addr + i] &= buf[i];
+        }
+        _stats.programs++;
+        _stats.programBytes += len;
+        _stats.busyNs += _timing.cmdNs + _timing.progNsPerByte * len + _timing.progNs;
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+
+    [[nodiscard]] FlashErrCode erase_sector(uint32_t addr) override
+    {
+        const FlashErrCode err = check_erase(addr);
+        if (err != FlashErrCode::FLASH_SUCCESS)
+        {
+            return err;
+        }
+        std::memset(&_image[addr], 0xFF, _geometry.sectorSize);
+        _eraseCount[addr / _geometry.sectorSize]++;
+        _stats.erases++;
+        _stats.busyNs += _timing.cmdNs + _timing.eraseNs;
+        return FlashErrCode::FLASH_SUCCESS;
+    }
+
+    [[nodiscard]] const uint8_t *map() override
+    {
+        return _isEnabled ? _image.data() : nullptr;
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    void stats_reset()
+    {
+        _stats = {};
+    }
+
+    /**
+     * @brief largest number of erases of one sector, wear indicator
+     */
+    [[nodiscard]] uint32_t max_erase_count() const
+    {
+        uint32_t m = 0;
+        for (const uint32_t c : _eraseCount)
+        {
+            m = c > m ? c : m;
+        }
+        return m;
+    }
+
+    /**
+     * @brief the raw image, bypassing the counters
+     */
+    [[nodiscard]] const uint8_t *image() const
+    {
+        return _image.data();
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    Timing _timing;
+    Stats _stats = {};
+    std::vector<uint8_t> _image;
+    std::vector<uint32_t> _eraseCount;
+};
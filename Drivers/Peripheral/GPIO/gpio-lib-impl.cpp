@@ -225,7 +225,7 @@ GpioErrCode pyro_gpio_lib_impl_t::enable()
  */
 GpioErrCode pyro_gpio_lib_impl_t::set()
 {
-    if (pinRaw > 15)
+    if (pinRaw == 0U) // a mask set by enable(), not a pin number
     {
         return GpioErrCode::GPIO_ERR_NONE;
     }
@@ -240,7 +240,7 @@ GpioErrCode pyro_gpio_lib_impl_t::set()
  */
 GpioErrCode pyro_gpio_lib_impl_t::reset()
 {
-    if (pinRaw > 15)
+    if (pinRaw == 0U) // a mask set by enable(), not a pin number
     {
         return GpioErrCode::GPIO_ERR_NONE;
     }
@@ -256,7 +256,7 @@ GpioErrCode pyro_gpio_lib_impl_t::reset()
  */
 GpioErrCode pyro_gpio_lib_impl_t::write(GpioStateEnum state)
 {
-    if (pinRaw > 15)
+    if (pinRaw == 0U) // a mask set by enable(), not a pin number
     {
         return GpioErrCode::GPIO_ERR_NONE;
     }
@@ -275,7 +275,7 @@ GpioErrCode pyro_gpio_lib_impl_t::write(GpioStateEnum state)
  */
 std::variant<GpioStateEnum, GpioErrCode> pyro_gpio_lib_impl_t::read()
 {
-    if (pinRaw > 15)
+    if (pinRaw == 0U) // a mask set by enable(), not a pin number
     {
         return GpioErrCode::GPIO_ERR_NONE;
     }
@@ -291,7 +291,7 @@ std::variant<GpioStateEnum, GpioErrCode> pyro_gpio_lib_impl_t::read()
  */
 GpioErrCode pyro_gpio_lib_impl_t::toggle()
 {
-    if (pinRaw > 15)
+    if (pinRaw == 0U) // a mask set by enable(), not a pin number
     {
         return GpioErrCode::GPIO_ERR_NONE;
     }
@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite_builder.h
+  * @brief   Header for the composite configuration descriptor builder.
+  ******************************************************************************
+  * @attention
+  *
+  * The core of this library already routes requests and endpoint events per
+  * class when USE_USBD_COMPOSITE is defined; this module provides the missing
+  * builder that allocates interfaces/endpoints for every registered class and
+  * assembles the concatenated configuration descriptor.
+  *
+  * Only the class types used by this project are implemented (see
+  * USBD_CMPSIT_ACTIVATE_xxx in usbd_conf.h).
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_COMPOSITE_BUILDER_H__
+#define __USBD_COMPOSITE_BUILDER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_ioreq.h"
+
+#if USBD_CMPSIT_ACTIVATE_CDC == 1U
+#include "usbd_cdc.h"
+#endif /* USBD_CMPSIT_ACTIVATE_CDC */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+#include "usbd_vendor.h"
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_MSC == 1U
+#include "usbd_msc.h"
+#endif /* USBD_CMPSIT_ACTIVATE_MSC */
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_CMPSIT
+  * @brief This file is the header file for usbd_composite_builder.c
+  * @{
+  */
+
+/** @defgroup USBD_CMPSIT_Exported_Defines
+  * @{
+  */
+#ifndef USBD_CMPST_MAX_CONFDESC_SZ
+#define USBD_CMPST_MAX_CONFDESC_SZ                  300U
+#endif /* USBD_CMPST_MAX_CONFDESC_SZ */
+
+#ifndef USBD_CONFIG_STR_DESC_IDX
+#define USBD_CONFIG_STR_DESC_IDX                    0U
+#endif /* USBD_CONFIG_STR_DESC_IDX */
+
+#ifndef USBD_CONFIG_BMATTRIBUTES
+#if (USBD_SELF_POWERED == 1U)
+#define USBD_CONFIG_BMATTRIBUTES                    0xC0U
+#else
+#define USBD_CONFIG_BMATTRIBUTES                    0x80U
+#endif /* USBD_SELF_POWERED */
+#endif /* USBD_CONFIG_BMATTRIBUTES */
+
+/* Size of one CDC ACM function including its Interface Association */
+#define USBD_CMPSIT_CDC_DESC_SIZ                    (USB_IAD_DESC_SIZE + 58U)
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CMPSIT_Exported_TypesDefinitions
+  * @{
+  */
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CMPSIT_Exported_Variables
+  * @{
+  */
+extern USBD_ClassTypeDef USBD_CMPSIT;
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CMPSIT_Exported_Functions
+  * @{
+  */
+uint8_t  USBD_CMPSIT_AddClass(USBD_HandleTypeDef *pdev,
+                              USBD_ClassTypeDef *pclass,
+                              USBD_CompositeClassTypeDef class,
+                              uint8_t cfgidx);
+
+uint32_t USBD_CMPSIT_GetClassID(USBD_HandleTypeDef *pdev,
+                                USBD_CompositeClassTypeDef Class,
+                                uint32_t Instance);
+
+uint32_t USBD_CMPSIT_SetClassID(USBD_HandleTypeDef *pdev,
+                                USBD_CompositeClassTypeDef Class,
+                                uint32_t Instance);
+
+uint8_t  USBD_CMPST_ClearConfDesc(USBD_HandleTypeDef *pdev);
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_COMPOSITE_BUILDER_H__ */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
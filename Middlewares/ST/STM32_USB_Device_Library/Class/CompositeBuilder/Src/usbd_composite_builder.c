@@ -0,0 +1,658 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite_builder.c
+  * @brief   Composite configuration descriptor builder.
+  ******************************************************************************
+  * @attention
+  *
+  * This builder is called by USBD_RegisterClassComposite() for every class
+  * instance. It:
+  *   - reserves the interface numbers used by the class,
+  *   - records the endpoints passed by the application (EpAddr) in the
+  *     class table so that USBD_CoreFindEP()/USBD_CoreGetEPAdd() can route
+  *     endpoint events to the right instance,
+  *   - appends the class descriptors (with an Interface Association
+  *     Descriptor when the class spans several interfaces) to the FS and HS
+  *     configuration descriptors returned to the host.
+  *
+  * The same class may be registered several times (e.g. two CDC ACM ports);
+  * instances are told apart with USBD_CMPSIT_SetClassID().
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite_builder.h"
+
+#ifdef USE_USBD_COMPOSITE
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_CMPSIT
+  * @brief composite builder module
+  * @{
+  */
+
+/** @defgroup USBD_CMPSIT_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t *USBD_CMPSIT_GetFSCfgDesc(uint16_t *length);
+static uint8_t *USBD_CMPSIT_GetHSCfgDesc(uint16_t *length);
+static uint8_t *USBD_CMPSIT_GetOtherSpeedCfgDesc(uint16_t *length);
+static uint8_t *USBD_CMPSIT_GetDeviceQualifierDescriptor(uint16_t *length);
+
+static uint8_t  USBD_CMPSIT_FindFreeIFNbr(USBD_HandleTypeDef *pdev);
+static void     USBD_CMPSIT_AddConfDesc(uint8_t *pConf, __IO uint32_t *Sze);
+static void     USBD_CMPSIT_AssignEp(USBD_HandleTypeDef *pdev, uint8_t Add,
+                                     uint8_t Type, uint32_t Sze);
+
+#if USBD_CMPSIT_ACTIVATE_CDC == 1U
+static void     USBD_CMPSIT_CDCDesc(USBD_HandleTypeDef *pdev, uint8_t *pConf,
+                                    __IO uint32_t *Sze, uint8_t speed);
+#endif /* USBD_CMPSIT_ACTIVATE_CDC */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+static void     USBD_CMPSIT_VendorDesc(USBD_HandleTypeDef *pdev, uint8_t *pConf,
+                                       __IO uint32_t *Sze, uint8_t speed);
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_MSC == 1U
+static void     USBD_CMPSIT_MSCDesc(USBD_HandleTypeDef *pdev, uint8_t *pConf,
+                                    __IO uint32_t *Sze, uint8_t speed);
+#endif /* USBD_CMPSIT_ACTIVATE_MSC */
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CMPSIT_Private_Variables
+  * @{
+  */
+/* Composite class callbacks: only the descriptor getters are used, every
+   other event is dispatched by the core directly to the registered classes */
+USBD_ClassTypeDef USBD_CMPSIT =
+{
+  NULL, /* Init */
+  NULL, /* DeInit */
+  NULL, /* Setup */
+  NULL, /* EP0_TxSent */
+  NULL, /* EP0_RxReady */
+  NULL, /* DataIn */
+  NULL, /* DataOut */
+  NULL, /* SOF */
+  NULL, /* IsoINIncomplete */
+  NULL, /* IsoOUTIncomplete */
+  USBD_CMPSIT_GetHSCfgDesc,
+  USBD_CMPSIT_GetFSCfgDesc,
+  USBD_CMPSIT_GetOtherSpeedCfgDesc,
+  USBD_CMPSIT_GetDeviceQualifierDescriptor,
+#if (USBD_SUPPORT_USER_STRING_DESC == 1U)
+  NULL,
+#endif /* USBD_SUPPORT_USER_STRING_DESC */
+};
+
+/* Configuration descriptors for both speeds, filled class after class */
+__ALIGN_BEGIN static uint8_t USBD_CMPSIT_FSCfgDesc[USBD_CMPST_MAX_CONFDESC_SZ] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t USBD_CMPSIT_HSCfgDesc[USBD_CMPST_MAX_CONFDESC_SZ] __ALIGN_END;
+
+static __IO uint32_t CurrFSConfDescSz = 0U;
+static __IO uint32_t CurrHSConfDescSz = 0U;
+
+/* USB Standard Device Qualifier Descriptor */
+__ALIGN_BEGIN static uint8_t USBD_CMPSIT_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_DESC] __ALIGN_END =
+{
+  USB_LEN_DEV_QUALIFIER_DESC,
+  USB_DESC_TYPE_DEVICE_QUALIFIER,
+  0x00,
+  0x02,
+  0xEF,                                       /* bDeviceClass: Miscellaneous */
+  0x02,                                       /* bDeviceSubClass: Common Class */
+  0x01,                                       /* bDeviceProtocol: IAD */
+  0x40,
+  0x01,
+  0x00,
+};
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CMPSIT_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_CMPSIT_AddClass
+  *         Register a class in the class list and append its descriptors
+  * @param  pdev: device instance
+  * @param  pclass: class handle
+  * @param  class: type of the class
+  * @param  cfgidx: configuration index (unused)
+  * @retval status
+  */
+uint8_t USBD_CMPSIT_AddClass(USBD_HandleTypeDef *pdev,
+                             USBD_ClassTypeDef *pclass,
+                             USBD_CompositeClassTypeDef class,
+                             uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+  if ((pdev->classId >= USBD_MAX_SUPPORTED_CLASS) || (pclass == NULL) ||
+      (pdev->tclasslist[pdev->classId].Active != 0U))
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  /* First class: build the configuration descriptor header */
+  if (pdev->NumClasses == 0U)
+  {
+    USBD_CMPSIT_AddConfDesc(USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz);
+    USBD_CMPSIT_AddConfDesc(USBD_CMPSIT_HSCfgDesc, &CurrHSConfDescSz);
+  }
+
+  pdev->tclasslist[pdev->classId].ClassId = pdev->classId;
+  pdev->tclasslist[pdev->classId].ClassType = class;
+  pdev->tclasslist[pdev->classId].Active = 1U;
+  pdev->tclasslist[pdev->classId].NumEps = 0U;
+  pdev->tclasslist[pdev->classId].NumIf = 0U;
+
+  switch (class)
+  {
+#if USBD_CMPSIT_ACTIVATE_CDC == 1U
+    case CLASS_TYPE_CDC:
+      /* Communication + data interfaces */
+      pdev->tclasslist[pdev->classId].NumIf = 2U;
+      pdev->tclasslist[pdev->classId].Ifs[0] = USBD_CMPSIT_FindFreeIFNbr(pdev);
+      pdev->tclasslist[pdev->classId].Ifs[1] = (uint8_t)(pdev->tclasslist[pdev->classId].Ifs[0] + 1U);
+
+      /* Data IN, data OUT and notification endpoints, in EpAddr order */
+      pdev->tclasslist[pdev->classId].CurrPcktSze = CDC_DATA_FS_MAX_PACKET_SIZE;
+      USBD_CMPSIT_AssignEp(pdev, pdev->tclasslist[pdev->classId].EpAdd[0], USBD_EP_TYPE_BULK,
+                           CDC_DATA_FS_MAX_PACKET_SIZE);
+      USBD_CMPSIT_AssignEp(pdev, pdev->tclasslist[pdev->classId].EpAdd[1], USBD_EP_TYPE_BULK,
+                           CDC_DATA_FS_MAX_PACKET_SIZE);
+      USBD_CMPSIT_AssignEp(pdev, pdev->tclasslist[pdev->classId].EpAdd[2], USBD_EP_TYPE_INTR,
+                           CDC_CMD_PACKET_SIZE);
+
+      USBD_CMPSIT_CDCDesc(pdev, USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz, (uint8_t)USBD_SPEED_FULL);
+      USBD_CMPSIT_CDCDesc(pdev, USBD_CMPSIT_HSCfgDesc, &CurrHSConfDescSz, (uint8_t)USBD_SPEED_HIGH);
+      break;
+#endif /* USBD_CMPSIT_ACTIVATE_CDC */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+    case CLASS_TYPE_VENDOR:
+      /* Single interface, bulk IN and bulk OUT in EpAddr order */
+      pdev->tclasslist[pdev->classId].NumIf = 1U;
+      pdev->tclasslist[pdev->classId].Ifs[0] = USBD_CMPSIT_FindFreeIFNbr(pdev);
+
+      pdev->tclasslist[pdev->classId].CurrPcktSze = VENDOR_DATA_FS_MAX_PACKET_SIZE;
+      USBD_CMPSIT_AssignEp(pdev, pdev->tclasslist[pdev->classId].EpAdd[0], USBD_EP_TYPE_BULK,
+                           VENDOR_DATA_FS_MAX_PACKET_SIZE);
+      USBD_CMPSIT_AssignEp(pdev, pdev->tclasslist[pdev->classId].EpAdd[1], USBD_EP_TYPE_BULK,
+                           VENDOR_DATA_FS_MAX_PACKET_SIZE);
+
+      USBD_CMPSIT_VendorDesc(pdev, USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz, (uint8_t)USBD_SPEED_FULL);
+      USBD_CMPSIT_VendorDesc(pdev, USBD_CMPSIT_HSCfgDesc, &CurrHSConfDescSz, (uint8_t)USBD_SPEED_HIGH);
+      break;
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_MSC == 1U
+    case CLASS_TYPE_MSC:
+      /* Single interface, bulk IN and bulk OUT in EpAddr order */
+      pdev->tclasslist[pdev->classId].NumIf = 1U;
+      pdev->tclasslist[pdev->classId].Ifs[0] = USBD_CMPSIT_FindFreeIFNbr(pdev);
+
+      pdev->tclasslist[pdev->classId].CurrPcktSze = MSC_MAX_FS_PACKET;
+      USBD_CMPSIT_AssignEp(pdev, pdev->tclasslist[pdev->classId].EpAdd[0], USBD_EP_TYPE_BULK,
+                           MSC_MAX_FS_PACKET);
+      USBD_CMPSIT_AssignEp(pdev, pdev->tclasslist[pdev->classId].EpAdd[1], USBD_EP_TYPE_BULK,
+                           MSC_MAX_FS_PACKET);
+
+      USBD_CMPSIT_MSCDesc(pdev, USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz, (uint8_t)USBD_SPEED_FULL);
+      USBD_CMPSIT_MSCDesc(pdev, USBD_CMPSIT_HSCfgDesc, &CurrHSConfDescSz, (uint8_t)USBD_SPEED_HIGH);
+      break;
+#endif /* USBD_CMPSIT_ACTIVATE_MSC */
+
+    default:
+      pdev->tclasslist[pdev->classId].Active = 0U;
+      return (uint8_t)USBD_FAIL;
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetClassID
+  *         Get the class id of the Nth instance of a class type
+  * @param  pdev: device instance
+  * @param  Class: class type
+  * @param  Instance: instance number (0 for the first registered one)
+  * @retval class id, 0xFF if not found
+  */
+uint32_t USBD_CMPSIT_GetClassID(USBD_HandleTypeDef *pdev,
+                                USBD_CompositeClassTypeDef Class,
+                                uint32_t Instance)
+{
+  uint32_t inst = 0U;
+
+  for (uint32_t idx = 0U; idx < pdev->NumClasses; idx++)
+  {
+    if ((pdev->tclasslist[idx].ClassType == Class) &&
+        (pdev->tclasslist[idx].Active == 1U))
+    {
+      if (inst == Instance)
+      {
+        return idx;
+      }
+      inst++;
+    }
+  }
+
+  return 0xFFU;
+}
+
+/**
+  * @brief  USBD_CMPSIT_SetClassID
+  *         Select the Nth instance of a class type as the current class
+  * @param  pdev: device instance
+  * @param  Class: class type
+  * @param  Instance: instance number (0 for the first registered one)
+  * @retval class id, 0xFF if not found
+  */
+uint32_t USBD_CMPSIT_SetClassID(USBD_HandleTypeDef *pdev,
+                                USBD_CompositeClassTypeDef Class,
+                                uint32_t Instance)
+{
+  uint32_t idx = USBD_CMPSIT_GetClassID(pdev, Class, Instance);
+
+  if (idx != 0xFFU)
+  {
+    pdev->classId = idx;
+  }
+
+  return idx;
+}
+
+/**
+  * @brief  USBD_CMPST_ClearConfDesc
+  *         Reset the configuration descriptors
+  * @param  pdev: device instance
+  * @retval status
+  */
+uint8_t USBD_CMPST_ClearConfDesc(USBD_HandleTypeDef *pdev)
+{
+  UNUSED(pdev);
+
+  CurrFSConfDescSz = 0U;
+  CurrHSConfDescSz = 0U;
+  (void)USBD_memset(USBD_CMPSIT_FSCfgDesc, 0, sizeof(USBD_CMPSIT_FSCfgDesc));
+  (void)USBD_memset(USBD_CMPSIT_HSCfgDesc, 0, sizeof(USBD_CMPSIT_HSCfgDesc));
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetFSCfgDesc
+  *         Return the full speed configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_CMPSIT_GetFSCfgDesc(uint16_t *length)
+{
+  *length = (uint16_t)CurrFSConfDescSz;
+  return USBD_CMPSIT_FSCfgDesc;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetHSCfgDesc
+  *         Return the high speed configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_CMPSIT_GetHSCfgDesc(uint16_t *length)
+{
+  *length = (uint16_t)CurrHSConfDescSz;
+  return USBD_CMPSIT_HSCfgDesc;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetOtherSpeedCfgDesc
+  *         Return the other speed configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_CMPSIT_GetOtherSpeedCfgDesc(uint16_t *length)
+{
+  *length = (uint16_t)CurrFSConfDescSz;
+  return USBD_CMPSIT_FSCfgDesc;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetDeviceQualifierDescriptor
+  *         Return the device qualifier descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_CMPSIT_GetDeviceQualifierDescriptor(uint16_t *length)
+{
+  *length = (uint16_t)sizeof(USBD_CMPSIT_DeviceQualifierDesc);
+  return USBD_CMPSIT_DeviceQualifierDesc;
+}
+
+/**
+  * @brief  USBD_CMPSIT_FindFreeIFNbr
+  *         Return the first interface number not used by a previous class
+  * @param  pdev: device instance
+  * @retval interface number
+  */
+static uint8_t USBD_CMPSIT_FindFreeIFNbr(USBD_HandleTypeDef *pdev)
+{
+  uint32_t ifnum = 0U;
+
+  for (uint32_t idx = 0U; idx < pdev->classId; idx++)
+  {
+    ifnum += pdev->tclasslist[idx].NumIf;
+  }
+
+  return (uint8_t)ifnum;
+}
+
+/**
+  * @brief  USBD_CMPSIT_AddConfDesc
+  *         Write the configuration descriptor header
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the buffer, updated
+  * @retval none
+  */
+static void USBD_CMPSIT_AddConfDesc(uint8_t *pConf, __IO uint32_t *Sze)
+{
+  USBD_ConfigDescTypeDef *ptr = (USBD_ConfigDescTypeDef *)(void *)pConf;
+
+  ptr->bLength = (uint8_t)sizeof(USBD_ConfigDescTypeDef);
+  ptr->bDescriptorType = USB_DESC_TYPE_CONFIGURATION;
+  ptr->wTotalLength = 0U;
+  ptr->bNumInterfaces = 0U;
+  ptr->bConfigurationValue = 1U;
+  ptr->iConfiguration = USBD_CONFIG_STR_DESC_IDX;
+  ptr->bmAttributes = USBD_CONFIG_BMATTRIBUTES;
+  ptr->bMaxPower = USBD_MAX_POWER;
+
+  *Sze = sizeof(USBD_ConfigDescTypeDef);
+}
+
+/**
+  * @brief  USBD_CMPSIT_AssignEp
+  *         Record an endpoint in the current class table
+  * @param  pdev: device instance
+  * @param  Add: endpoint address
+  * @param  Type: endpoint type
+  * @param  Sze: full speed max packet size
+  * @retval none
+  */
+static void USBD_CMPSIT_AssignEp(USBD_HandleTypeDef *pdev, uint8_t Add,
+                                 uint8_t Type, uint32_t Sze)
+{
+  uint32_t idx = pdev->tclasslist[pdev->classId].NumEps;
+
+  if (idx >= USBD_MAX_CLASS_ENDPOINTS)
+  {
+    return;
+  }
+
+  pdev->tclasslist[pdev->classId].Eps[idx].add = Add;
+  pdev->tclasslist[pdev->classId].Eps[idx].type = Type;
+  pdev->tclasslist[pdev->classId].Eps[idx].size = (uint8_t)Sze;
+  pdev->tclasslist[pdev->classId].Eps[idx].is_used = 1U;
+  pdev->tclasslist[pdev->classId].NumEps++;
+}
+
+#if USBD_CMPSIT_ACTIVATE_CDC == 1U
+/**
+  * @brief  USBD_CMPSIT_CDCDesc
+  *         Append the descriptors of one CDC ACM function
+  * @param  pdev: device instance
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the buffer, updated
+  * @param  speed: USBD_SPEED_FULL or USBD_SPEED_HIGH
+  * @retval none
+  */
+static void USBD_CMPSIT_CDCDesc(USBD_HandleTypeDef *pdev, uint8_t *pConf,
+                                __IO uint32_t *Sze, uint8_t speed)
+{
+  USBD_CompositeElementTypeDef *pcls = &pdev->tclasslist[pdev->classId];
+  USBD_ConfigDescTypeDef *phdr = (USBD_ConfigDescTypeDef *)(void *)pConf;
+  uint8_t *p = &pConf[*Sze];
+  uint16_t mps = (speed == (uint8_t)USBD_SPEED_HIGH) ? CDC_DATA_HS_MAX_PACKET_SIZE
+                                                     : CDC_DATA_FS_MAX_PACKET_SIZE;
+  uint8_t interval = (speed == (uint8_t)USBD_SPEED_HIGH) ? CDC_HS_BINTERVAL : CDC_FS_BINTERVAL;
+  uint32_t i = 0U;
+
+  if ((*Sze + USBD_CMPSIT_CDC_DESC_SIZ) > USBD_CMPST_MAX_CONFDESC_SZ)
+  {
+    return;
+  }
+
+  /* Interface Association Descriptor */
+  p[i++] = USB_IAD_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_IAD;
+  p[i++] = pcls->Ifs[0];                      /* bFirstInterface */
+  p[i++] = 0x02U;                             /* bInterfaceCount */
+  p[i++] = 0x02U;                             /* bFunctionClass: CDC */
+  p[i++] = 0x02U;                             /* bFunctionSubClass: ACM */
+  p[i++] = 0x01U;                             /* bFunctionProtocol: AT commands */
+  p[i++] = 0x00U;                             /* iFunction */
+
+  /* Communication interface */
+  p[i++] = USB_IF_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_INTERFACE;
+  p[i++] = pcls->Ifs[0];                      /* bInterfaceNumber */
+  p[i++] = 0x00U;                             /* bAlternateSetting */
+  p[i++] = 0x01U;                             /* bNumEndpoints */
+  p[i++] = 0x02U;                             /* bInterfaceClass: Communication */
+  p[i++] = 0x02U;                             /* bInterfaceSubClass: ACM */
+  p[i++] = 0x01U;                             /* bInterfaceProtocol */
+  p[i++] = 0x00U;                             /* iInterface */
+
+  /* Header Functional Descriptor */
+  p[i++] = 0x05U;
+  p[i++] = 0x24U;
+  p[i++] = 0x00U;
+  p[i++] = 0x10U;                             /* bcdCDC 1.10 */
+  p[i++] = 0x01U;
+
+  /* Call Management Functional Descriptor */
+  p[i++] = 0x05U;
+  p[i++] = 0x24U;
+  p[i++] = 0x01U;
+  p[i++] = 0x00U;                             /* bmCapabilities */
+  p[i++] = pcls->Ifs[1];                      /* bDataInterface */
+
+  /* ACM Functional Descriptor */
+  p[i++] = 0x04U;
+  p[i++] = 0x24U;
+  p[i++] = 0x02U;
+  p[i++] = 0x02U;                             /* bmCapabilities: line coding + state */
+
+  /* Union Functional Descriptor */
+  p[i++] = 0x05U;
+  p[i++] = 0x24U;
+  p[i++] = 0x06U;
+  p[i++] = pcls->Ifs[0];                      /* bMasterInterface */
+  p[i++] = pcls->Ifs[1];                      /* bSlaveInterface0 */
+
+  /* Notification endpoint */
+  p[i++] = USB_EP_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_ENDPOINT;
+  p[i++] = pcls->Eps[2].add;
+  p[i++] = USBD_EP_TYPE_INTR;
+  p[i++] = LOBYTE(CDC_CMD_PACKET_SIZE);
+  p[i++] = HIBYTE(CDC_CMD_PACKET_SIZE);
+  p[i++] = interval;
+
+  /* Data interface */
+  p[i++] = USB_IF_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_INTERFACE;
+  p[i++] = pcls->Ifs[1];                      /* bInterfaceNumber */
+  p[i++] = 0x00U;                             /* bAlternateSetting */
+  p[i++] = 0x02U;                             /* bNumEndpoints */
+  p[i++] = 0x0AU;                             /* bInterfaceClass: CDC Data */
+  p[i++] = 0x00U;
+  p[i++] = 0x00U;
+  p[i++] = 0x00U;                             /* iInterface */
+
+  /* Data OUT endpoint */
+  p[i++] = USB_EP_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_ENDPOINT;
+  p[i++] = pcls->Eps[1].add;
+  p[i++] = USBD_EP_TYPE_BULK;
+  p[i++] = LOBYTE(mps);
+  p[i++] = HIBYTE(mps);
+  p[i++] = 0x00U;
+
+  /* Data IN endpoint */
+  p[i++] = USB_EP_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_ENDPOINT;
+  p[i++] = pcls->Eps[0].add;
+  p[i++] = USBD_EP_TYPE_BULK;
+  p[i++] = LOBYTE(mps);
+  p[i++] = HIBYTE(mps);
+  p[i++] = 0x00U;
+
+  *Sze += i;
+  phdr->bNumInterfaces += 2U;
+  phdr->wTotalLength = (uint16_t)*Sze;
+}
+#endif /* USBD_CMPSIT_ACTIVATE_CDC */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+/**
+  * @brief  USBD_CMPSIT_VendorDesc
+  *         Append the descriptors of the vendor bulk function
+  * @param  pdev: device instance
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the buffer, updated
+  * @param  speed: USBD_SPEED_FULL or USBD_SPEED_HIGH
+  * @retval none
+  */
+static void USBD_CMPSIT_VendorDesc(USBD_HandleTypeDef *pdev, uint8_t *pConf,
+                                   __IO uint32_t *Sze, uint8_t speed)
+{
+  USBD_CompositeElementTypeDef *pcls = &pdev->tclasslist[pdev->classId];
+  USBD_ConfigDescTypeDef *phdr = (USBD_ConfigDescTypeDef *)(void *)pConf;
+  uint8_t *p = &pConf[*Sze];
+  uint16_t mps = (speed == (uint8_t)USBD_SPEED_HIGH) ? VENDOR_DATA_HS_MAX_PACKET_SIZE
+                                                     : VENDOR_DATA_FS_MAX_PACKET_SIZE;
+  uint32_t i = 0U;
+
+  if ((*Sze + USB_VENDOR_FUNC_DESC_SIZ) > USBD_CMPST_MAX_CONFDESC_SZ)
+  {
+    return;
+  }
+
+  /* Vendor interface */
+  p[i++] = USB_IF_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_INTERFACE;
+  p[i++] = pcls->Ifs[0];                      /* bInterfaceNumber */
+  p[i++] = 0x00U;                             /* bAlternateSetting */
+  p[i++] = 0x02U;                             /* bNumEndpoints */
+  p[i++] = 0xFFU;                             /* bInterfaceClass: vendor specific */
+  p[i++] = 0x00U;
+  p[i++] = 0x00U;
+  p[i++] = 0x00U;                             /* iInterface */
+
+  /* Bulk IN endpoint */
+  p[i++] = USB_EP_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_ENDPOINT;
+  p[i++] = pcls->Eps[0].add;
+  p[i++] = USBD_EP_TYPE_BULK;
+  p[i++] = LOBYTE(mps);
+  p[i++] = HIBYTE(mps);
+  p[i++] = 0x00U;
+
+  /* Bulk OUT endpoint */
+  p[i++] = USB_EP_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_ENDPOINT;
+  p[i++] = pcls->Eps[1].add;
+  p[i++] = USBD_EP_TYPE_BULK;
+  p[i++] = LOBYTE(mps);
+  p[i++] = HIBYTE(mps);
+  p[i++] = 0x00U;
+
+  *Sze += i;
+  phdr->bNumInterfaces += 1U;
+  phdr->wTotalLength = (uint16_t)*Sze;
+}
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_MSC == 1U
+/**
+  * @brief  USBD_CMPSIT_MSCDesc
+  *         Append the descriptors of the mass storage function
+  * @param  pdev: device instance
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the buffer, updated
+  * @param  speed: USBD_SPEED_FULL or USBD_SPEED_HIGH
+  * @retval none
+  */
+static void USBD_CMPSIT_MSCDesc(USBD_HandleTypeDef *pdev, uint8_t *pConf,
+                                __IO uint32_t *Sze, uint8_t speed)
+{
+  USBD_CompositeElementTypeDef *pcls = &pdev->tclasslist[pdev->classId];
+  USBD_ConfigDescTypeDef *phdr = (USBD_ConfigDescTypeDef *)(void *)pConf;
+  uint8_t *p = &pConf[*Sze];
+  uint16_t mps = (speed == (uint8_t)USBD_SPEED_HIGH) ? MSC_MAX_HS_PACKET : MSC_MAX_FS_PACKET;
+  uint32_t i = 0U;
+
+  if ((*Sze + USB_MSC_FUNC_DESC_SIZ) > USBD_CMPST_MAX_CONFDESC_SZ)
+  {
+    return;
+  }
+
+  /* Mass storage interface */
+  p[i++] = USB_IF_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_INTERFACE;
+  p[i++] = pcls->Ifs[0];                      /* bInterfaceNumber */
+  p[i++] = 0x00U;                             /* bAlternateSetting */
+  p[i++] = 0x02U;                             /* bNumEndpoints */
+  p[i++] = 0x08U;                             /* bInterfaceClass: mass storage */
+  p[i++] = 0x06U;                             /* bInterfaceSubClass: SCSI transparent */
+  p[i++] = 0x50U;                             /* bInterfaceProtocol: bulk-only */
+  p[i++] = 0x00U;                             /* iInterface */
+
+  /* Bulk IN endpoint */
+  p[i++] = USB_EP_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_ENDPOINT;
+  p[i++] = pcls->Eps[0].add;
+  p[i++] = USBD_EP_TYPE_BULK;
+  p[i++] = LOBYTE(mps);
+  p[i++] = HIBYTE(mps);
+  p[i++] = 0x00U;
+
+  /* Bulk OUT endpoint */
+  p[i++] = USB_EP_DESC_SIZE;
+  p[i++] = USB_DESC_TYPE_ENDPOINT;
+  p[i++] = pcls->Eps[1].add;
+  p[i++] = USBD_EP_TYPE_BULK;
+  p[i++] = LOBYTE(mps);
+  p[i++] = HIBYTE(mps);
+  p[i++] = 0x00U;
+
+  *Sze += i;
+  phdr->bNumInterfaces += 1U;
+  phdr->wTotalLength = (uint16_t)*Sze;
+}
+#endif /* USBD_CMPSIT_ACTIVATE_MSC */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#endif /* USE_USBD_COMPOSITE */
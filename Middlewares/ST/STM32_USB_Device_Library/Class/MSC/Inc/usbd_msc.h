@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc.h
+  * @brief   Header for the usbd_msc.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * Mass storage function, SCSI transparent command set over Bulk-Only
+  * Transport, one interface with a bulk IN and a bulk OUT endpoint. The class
+  * is meant to be registered through the composite builder.
+  *
+  * Media access is slow (a NOR sector erase takes tens of milliseconds) so it
+  * never runs in the USB interrupt: the endpoint and request callbacks record
+  * an event and call the Notify hook of the storage interface, the task woken
+  * by that hook calls USBD_MSC_Process() which runs the transport and calls
+  * the Read/Write/Sync hooks. Data phases are double buffered: the next media
+  * chunk is read while the previous one is on the bus, and the next OUT chunk
+  * is received while the previous one is written.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_MSC_H
+#define __USBD_MSC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_msc_bot.h"
+#include  "usbd_msc_scsi.h"
+#include  "usbd_ioreq.h"
+
+/** @addtogroup USBD_MSC_BOT
+  * @{
+  */
+
+/** @defgroup USBD_MSC
+  * @brief This file is the Header file for usbd_msc.c
+  * @{
+  */
+
+
+/** @defgroup USBD_BOT_Exported_Defines
+  * @{
+  */
+/* MSC Class Config */
+#ifndef MSC_MEDIA_PACKET
+#define MSC_MEDIA_PACKET                            4096U  /* One media chunk, two are allocated */
+#endif /* MSC_MEDIA_PACKET */
+
+#ifndef MSC_IN_EP
+#define MSC_IN_EP                                   0x86U  /* EP6 for BULK IN */
+#endif /* MSC_IN_EP */
+#ifndef MSC_OUT_EP
+#define MSC_OUT_EP                                  0x06U  /* EP6 for BULK OUT */
+#endif /* MSC_OUT_EP */
+
+#define MSC_MAX_FS_PACKET                           0x40U
+#define MSC_MAX_HS_PACKET                           0x200U
+
+/* Highest logical unit number, the sense list is shared so one unit only */
+#ifndef USBD_MSC_MAX_LUN
+#define USBD_MSC_MAX_LUN                            0U
+#endif /* USBD_MSC_MAX_LUN */
+
+#define BOT_GET_MAX_LUN                             0xFEU
+#define BOT_RESET                                   0xFFU
+
+/* Interface + 2 endpoint descriptors */
+#define USB_MSC_FUNC_DESC_SIZ                       23U
+
+/* Events posted by the interrupt callbacks for USBD_MSC_Process() */
+#define MSC_EVT_DATA_IN                             0x01U
+#define MSC_EVT_DATA_OUT                            0x02U
+#define MSC_EVT_CLEAR_FEATURE                       0x04U
+#define MSC_EVT_RESET                               0x08U
+/**
+  * @}
+  */
+
+
+/** @defgroup USB_CORE_Exported_Types
+  * @{
+  */
+
+typedef struct _USBD_STORAGE
+{
+  int8_t (* Init)(uint8_t lun);
+  int8_t (* GetCapacity)(uint8_t lun, uint32_t *block_num, uint16_t *block_size);
+  int8_t (* IsReady)(uint8_t lun);
+  int8_t (* IsWriteProtected)(uint8_t lun);
+  int8_t (* Read)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+  int8_t (* Write)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+  int8_t (* GetMaxLun)(void);
+  int8_t *pInquiry;
+  int8_t (* Sync)(uint8_t lun);    /* SYNCHRONIZE CACHE and eject, may be NULL */
+  void   (* Notify)(void);         /* interrupt context: an event is pending */
+} USBD_StorageTypeDef;
+
+
+typedef struct
+{
+  uint32_t                 max_lun;
+  uint32_t                 interface;
+  uint8_t                  bot_state;
+  uint8_t                  bot_status;
+  uint32_t                 bot_data_length;
+  uint8_t                  bot_data[USBD_BOT_MAX_DATA];
+  USBD_MSC_BOT_CBWTypeDef  cbw;
+  USBD_MSC_BOT_CSWTypeDef  csw;
+
+  USBD_SCSI_SenseTypeDef   scsi_sense [SENSE_LIST_DEEPTH];
+  uint8_t                  scsi_sense_head;
+  uint8_t                  scsi_sense_tail;
+  uint8_t                  scsi_medium_state;
+
+  uint16_t                 scsi_blk_size;
+  uint32_t                 scsi_blk_nbr;
+
+  uint32_t                 scsi_blk_addr;   /* next block to read from or write to the media */
+  uint32_t                 scsi_blk_len;    /* blocks left for the media */
+  uint32_t                 xfer_blk_len;    /* blocks left for the bus */
+  uint8_t                  xfer_busy;       /* a chunk is on the bus */
+  uint8_t                  xfer_ready;      /* the other chunk is filled and waits for the bus */
+  uint8_t                  xfer_idx;        /* media buffer of the chunk on the bus */
+  uint8_t                  xfer_error;      /* media error while the bus was busy */
+  uint32_t                 xfer_len[2];     /* bytes in each media buffer */
+
+  __IO uint32_t            Events;          /* MSC_EVT_xxx */
+  __IO uint32_t            RxLength;
+  __IO uint8_t             ClearEp;
+  uint8_t                  InEp;
+  uint8_t                  OutEp;
+  uint16_t                 Mps;
+} USBD_MSC_BOT_HandleTypeDef;
+
+/* Structure for MSC process */
+extern USBD_ClassTypeDef  USBD_MSC;
+#define USBD_MSC_CLASS    &USBD_MSC
+
+uint8_t USBD_MSC_RegisterStorage(USBD_HandleTypeDef *pdev,
+                                 USBD_StorageTypeDef *fops);
+uint8_t USBD_MSC_Process(USBD_HandleTypeDef *pdev);
+
+USBD_MSC_BOT_HandleTypeDef *USBD_MSC_GetHandle(USBD_HandleTypeDef *pdev);
+USBD_StorageTypeDef        *USBD_MSC_GetStorage(USBD_HandleTypeDef *pdev);
+uint8_t                    *USBD_MSC_GetMediaBuffer(uint8_t idx);
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_MSC_H */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
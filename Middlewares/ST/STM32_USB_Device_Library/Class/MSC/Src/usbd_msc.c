@@ -0,0 +1,501 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc.c
+  * @brief   This file provides all the MSC core functions.
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                MSC Class  Description
+  *          ===================================================================
+  *           This module manages the MSC class V1.0 following the "Universal
+  *           Serial Bus Mass Storage Class (MSC) Bulk-Only Transport (BOT)
+  *           Version 1.0 Sep. 31, 1999".
+  *           This driver implements the following aspects of the specification:
+  *             - Bulk-Only Transport protocol
+  *             - Subclass : SCSI transparent command set (ref. SCSI Primary
+  *               Commands - 3 (SPC-3))
+  *
+  *           Callbacks run in the USB interrupt and only record what happened
+  *           (MSC_EVT_xxx) before calling the Notify hook of the storage
+  *           interface. The transport itself runs in USBD_MSC_Process(), called
+  *           by the task that Notify wakes, so the media may block for as long
+  *           as an erase takes without holding the USB interrupt.
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_msc.h"
+
+#ifndef USE_USBD_COMPOSITE
+#error "usbd_msc is registered through the composite builder, define USE_USBD_COMPOSITE"
+#endif /* USE_USBD_COMPOSITE */
+
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup MSC_CORE
+  * @brief Mass storage core module
+  * @{
+  */
+
+/** @defgroup MSC_CORE_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_MSC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_MSC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_MSC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_MSC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_MSC_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static void    USBD_MSC_PostEvent(USBD_HandleTypeDef *pdev, USBD_MSC_BOT_HandleTypeDef *hmsc,
+                                  uint32_t evt);
+/**
+  * @}
+  */
+
+
+/** @defgroup MSC_CORE_Private_Variables
+  * @{
+  */
+
+
+USBD_ClassTypeDef  USBD_MSC =
+{
+  USBD_MSC_Init,
+  USBD_MSC_DeInit,
+  USBD_MSC_Setup,
+  NULL, /*EP0_TxSent*/
+  NULL, /*EP0_RxReady*/
+  USBD_MSC_DataIn,
+  USBD_MSC_DataOut,
+  NULL, /*SOF */
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+#if (USBD_SUPPORT_USER_STRING_DESC == 1U)
+  NULL,
+#endif /* USBD_SUPPORT_USER_STRING_DESC */
+};
+
+/* The function has a single instance: its class id is kept for the task side */
+static uint8_t MSCClassId = 0xFFU;
+
+/* Two media chunks, one on the bus while the other is read or written */
+__ALIGN_BEGIN static uint8_t MSCMediaBuf[2][MSC_MEDIA_PACKET] __ALIGN_END;
+/**
+  * @}
+  */
+
+
+/** @defgroup MSC_CORE_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_MSC_Init
+  *         Initialize  the mass storage configuration
+  * @param  pdev: device instance
+  * @param  cfgidx: configuration index
+  * @retval status
+  */
+static uint8_t USBD_MSC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+  USBD_MSC_BOT_HandleTypeDef *hmsc;
+
+  hmsc = (USBD_MSC_BOT_HandleTypeDef *)USBD_malloc(sizeof(USBD_MSC_BOT_HandleTypeDef));
+
+  if (hmsc == NULL)
+  {
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    return (uint8_t)USBD_EMEM;
+  }
+
+  (void)USBD_memset(hmsc, 0, sizeof(USBD_MSC_BOT_HandleTypeDef));
+
+  pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
+  pdev->pClassData = pdev->pClassDataCmsit[pdev->classId];
+
+  /* Get the Endpoints addresses allocated for this class instance */
+  hmsc->InEp  = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+  hmsc->OutEp = USBD_CoreGetEPAdd(pdev, USBD_EP_OUT, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+  hmsc->Mps   = (pdev->dev_speed == USBD_SPEED_HIGH) ? MSC_MAX_HS_PACKET : MSC_MAX_FS_PACKET;
+
+  /* Open EP OUT */
+  (void)USBD_LL_OpenEP(pdev, hmsc->OutEp, USBD_EP_TYPE_BULK, hmsc->Mps);
+  pdev->ep_out[hmsc->OutEp & 0xFU].is_used = 1U;
+
+  /* Open EP IN */
+  (void)USBD_LL_OpenEP(pdev, hmsc->InEp, USBD_EP_TYPE_BULK, hmsc->Mps);
+  pdev->ep_in[hmsc->InEp & 0xFU].is_used = 1U;
+
+  /* Init the BOT  layer */
+  MSC_BOT_Init(pdev);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_MSC_DeInit
+  *         DeInitialize  the mass storage configuration
+  * @param  pdev: device instance
+  * @param  cfgidx: configuration index
+  * @retval status
+  */
+static uint8_t USBD_MSC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+  uint8_t in_ep  = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+  uint8_t out_ep = USBD_CoreGetEPAdd(pdev, USBD_EP_OUT, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+
+  /* Close MSC EPs */
+  (void)USBD_LL_CloseEP(pdev, out_ep);
+  pdev->ep_out[out_ep & 0xFU].is_used = 0U;
+
+  /* Close EP IN */
+  (void)USBD_LL_CloseEP(pdev, in_ep);
+  pdev->ep_in[in_ep & 0xFU].is_used = 0U;
+
+  /* Free MSC Class Resources */
+  if (pdev->pClassDataCmsit[pdev->classId] != NULL)
+  {
+    /* De-Init the BOT layer */
+    MSC_BOT_DeInit(pdev);
+
+    (void)USBD_free(pdev->pClassDataCmsit[pdev->classId]);
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    pdev->pClassData = NULL;
+  }
+
+  return (uint8_t)USBD_OK;
+}
+/**
+  * @brief  USBD_MSC_Setup
+  *         Handle the MSC specific requests
+  * @param  pdev: device instance
+  * @param  req: USB request
+  * @retval status
+  */
+static uint8_t USBD_MSC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+  USBD_StatusTypeDef ret = USBD_OK;
+  uint32_t max_lun;
+  uint16_t status_info = 0U;
+
+  if (hmsc == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    /* Class request */
+    case USB_REQ_TYPE_CLASS:
+      switch (req->bRequest)
+      {
+        case BOT_GET_MAX_LUN:
+          if ((req->wValue  == 0U) && (req->wLength == 1U) &&
+              ((req->bmRequest & 0x80U) == 0x80U))
+          {
+            max_lun = (uint32_t)((USBD_StorageTypeDef *)pdev->pUserData[pdev->classId])->GetMaxLun();
+            hmsc->max_lun = (max_lun > USBD_MSC_MAX_LUN) ? USBD_MSC_MAX_LUN : max_lun;
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&hmsc->max_lun, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case BOT_RESET :
+          if ((req->wValue  == 0U) && (req->wLength == 0U) &&
+              ((req->bmRequest & 0x80U) != 0x80U))
+          {
+            /* The transport restarts in the task, the host waits for the CBW stage */
+            USBD_MSC_PostEvent(pdev, hmsc, MSC_EVT_RESET);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+    /* Interface & Endpoint request */
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&hmsc->interface, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            hmsc->interface = (uint8_t)(req->wValue);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            if (req->wValue == USB_FEATURE_EP_HALT)
+            {
+              /* Flush the FIFO */
+              (void)USBD_LL_FlushEP(pdev, (uint8_t)req->wIndex);
+
+              /* Handle BOT error */
+              hmsc->ClearEp = (uint8_t)req->wIndex;
+              USBD_MSC_PostEvent(pdev, hmsc, MSC_EVT_CLEAR_FEATURE);
+            }
+          }
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_MSC_DataIn
+  *         handle data IN Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_MSC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  UNUSED(epnum);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hmsc == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  USBD_MSC_PostEvent(pdev, hmsc, MSC_EVT_DATA_IN);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_MSC_DataOut
+  *         handle data OUT Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_MSC_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hmsc == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  hmsc->RxLength = USBD_LL_GetRxDataSize(pdev, epnum);
+  USBD_MSC_PostEvent(pdev, hmsc, MSC_EVT_DATA_OUT);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_MSC_PostEvent
+  *         Record an event for USBD_MSC_Process and wake its task
+  * @param  pdev: device instance
+  * @param  hmsc: class handle
+  * @param  evt: MSC_EVT_xxx
+  * @retval None
+  */
+static void USBD_MSC_PostEvent(USBD_HandleTypeDef *pdev, USBD_MSC_BOT_HandleTypeDef *hmsc,
+                               uint32_t evt)
+{
+  USBD_StorageTypeDef *fops = (USBD_StorageTypeDef *)pdev->pUserData[pdev->classId];
+
+  hmsc->Events |= evt;
+
+  if ((fops != NULL) && (fops->Notify != NULL))
+  {
+    fops->Notify();
+  }
+}
+
+/**
+  * @brief  USBD_MSC_Process
+  *         Run the transport for the pending events, task context
+  * @param  pdev: device instance
+  * @retval 1 if an event was handled, 0 if there was nothing to do
+  */
+uint8_t USBD_MSC_Process(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint32_t primask;
+  uint32_t evt;
+
+  if (hmsc == NULL)
+  {
+    return 0U;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  evt = hmsc->Events;
+  hmsc->Events = 0U;
+  __set_PRIMASK(primask);
+
+  if (evt == 0U)
+  {
+    return 0U;
+  }
+
+  if ((evt & MSC_EVT_RESET) != 0U)
+  {
+    /* Whatever was in flight belongs to the aborted command */
+    MSC_BOT_Reset(pdev);
+    return 1U;
+  }
+  if ((evt & MSC_EVT_CLEAR_FEATURE) != 0U)
+  {
+    MSC_BOT_CplClrFeature(pdev, hmsc->ClearEp);
+  }
+  if ((evt & MSC_EVT_DATA_OUT) != 0U)
+  {
+    MSC_BOT_DataOut(pdev);
+  }
+  if ((evt & MSC_EVT_DATA_IN) != 0U)
+  {
+    MSC_BOT_DataIn(pdev);
+  }
+
+  return 1U;
+}
+
+/**
+  * @brief  USBD_MSC_GetHandle
+  *         Class handle of the MSC instance, from any context
+  * @param  pdev: device instance
+  * @retval handle, NULL when the device is not configured
+  */
+USBD_MSC_BOT_HandleTypeDef *USBD_MSC_GetHandle(USBD_HandleTypeDef *pdev)
+{
+  if (MSCClassId >= USBD_MAX_SUPPORTED_CLASS)
+  {
+    return NULL;
+  }
+
+  return (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDataCmsit[MSCClassId];
+}
+
+/**
+  * @brief  USBD_MSC_GetStorage
+  *         Storage interface of the MSC instance
+  * @param  pdev: device instance
+  * @retval storage interface
+  */
+USBD_StorageTypeDef *USBD_MSC_GetStorage(USBD_HandleTypeDef *pdev)
+{
+  if (MSCClassId >= USBD_MAX_SUPPORTED_CLASS)
+  {
+    return NULL;
+  }
+
+  return (USBD_StorageTypeDef *)pdev->pUserData[MSCClassId];
+}
+
+/**
+  * @brief  USBD_MSC_GetMediaBuffer
+  *         One of the two media chunks
+  * @param  idx: 0 or 1
+  * @retval MSC_MEDIA_PACKET bytes
+  */
+uint8_t *USBD_MSC_GetMediaBuffer(uint8_t idx)
+{
+  return MSCMediaBuf[idx & 1U];
+}
+
+/**
+  * @brief  USBD_MSC_RegisterStorage
+  * @param  pdev: device instance
+  * @param  fops: storage callback
+  * @retval status
+  */
+uint8_t USBD_MSC_RegisterStorage(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *fops)
+{
+  if (fops == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  pdev->pUserData[pdev->classId] = fops;
+  MSCClassId = (uint8_t)pdev->classId;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
@@ -0,0 +1,628 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc_bot.c
+  * @brief   This file provides all the BOT protocol core functions.
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                BOT Protocol
+  *          ===================================================================
+  *           Everything but MSC_BOT_Init() runs in the task calling
+  *           USBD_MSC_Process(). Calls into the low level driver are made with
+  *           interrupts masked, the OTG interrupt shares registers with them.
+  *
+  *           READ: chunk n is on the bus while chunk n+1 is read from the
+  *           media into the other buffer; the IN completion of chunk n sends
+  *           chunk n+1 at once and starts reading chunk n+2.
+  *
+  *           WRITE: when chunk n arrives the endpoint is armed for chunk n+1
+  *           into the other buffer before chunk n is written to the media, so
+  *           the host keeps sending while the media works.
+  *
+  *           Errors follow the reference implementation: the data endpoint is
+  *           stalled and the failed CSW goes out when the host clears the IN
+  *           halt; a CBW that is not valid stalls both endpoints until a Bulk
+  *           Only Mass Storage Reset.
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_msc_bot.h"
+#include "usbd_msc.h"
+#include "usbd_msc_scsi.h"
+#include "usbd_ioreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup MSC_BOT
+  * @brief BOT protocol module
+  * @{
+  */
+
+/** @defgroup MSC_BOT_Private_Defines
+  * @{
+  */
+#define MSC_BOT_LOCK()      uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define MSC_BOT_UNLOCK()    __set_PRIMASK(primask)
+/**
+  * @}
+  */
+
+
+/** @defgroup MSC_BOT_Private_FunctionPrototypes
+  * @{
+  */
+static void MSC_BOT_CBW_Decode(USBD_HandleTypeDef *pdev);
+static void MSC_BOT_SendData(USBD_HandleTypeDef *pdev, uint8_t *pbuf, uint32_t len);
+static int8_t MSC_BOT_ReadMedia(USBD_HandleTypeDef *pdev, uint8_t idx);
+static void MSC_BOT_SendChunk(USBD_HandleTypeDef *pdev, uint8_t idx);
+static void MSC_BOT_ReadNext(USBD_HandleTypeDef *pdev);
+static void MSC_BOT_ArmOut(USBD_HandleTypeDef *pdev, uint8_t idx);
+static void MSC_BOT_WriteNext(USBD_HandleTypeDef *pdev);
+/**
+  * @}
+  */
+
+
+/** @defgroup MSC_BOT_Private_Functions
+  * @{
+  */
+
+
+/**
+  * @brief  MSC_BOT_Init
+  *         Initialize the BOT Process, interrupt context (SET_CONFIGURATION)
+  * @param  pdev: device instance
+  * @retval None
+  */
+void MSC_BOT_Init(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  hmsc->bot_state = USBD_BOT_IDLE;
+  hmsc->bot_status = USBD_BOT_STATUS_NORMAL;
+
+  hmsc->scsi_sense_tail = 0U;
+  hmsc->scsi_sense_head = 0U;
+  hmsc->scsi_medium_state = SCSI_MEDIUM_UNLOCKED;
+
+  ((USBD_StorageTypeDef *)pdev->pUserData[pdev->classId])->Init(0U);
+
+  (void)USBD_LL_FlushEP(pdev, hmsc->OutEp);
+  (void)USBD_LL_FlushEP(pdev, hmsc->InEp);
+
+  /* Prepare EP to Receive First BOT Cmd */
+  (void)USBD_LL_PrepareReceive(pdev, hmsc->OutEp, (uint8_t *)&hmsc->cbw,
+                               USBD_BOT_CBW_LENGTH);
+}
+
+/**
+  * @brief  MSC_BOT_Reset
+  *         Bulk-Only Mass Storage Reset, drop the command in progress
+  * @param  pdev: device instance
+  * @retval None
+  */
+void MSC_BOT_Reset(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  hmsc->bot_state  = USBD_BOT_IDLE;
+  hmsc->bot_status = USBD_BOT_STATUS_RECOVERY;
+  hmsc->xfer_busy  = 0U;
+  hmsc->xfer_ready = 0U;
+  hmsc->xfer_error = 0U;
+
+  MSC_BOT_LOCK();
+  (void)USBD_LL_FlushEP(pdev, hmsc->InEp);
+  (void)USBD_LL_ClearStallEP(pdev, hmsc->InEp);
+  (void)USBD_LL_ClearStallEP(pdev, hmsc->OutEp);
+
+  /* Prepare EP to Receive First BOT Cmd */
+  (void)USBD_LL_PrepareReceive(pdev, hmsc->OutEp, (uint8_t *)&hmsc->cbw,
+                               USBD_BOT_CBW_LENGTH);
+  MSC_BOT_UNLOCK();
+}
+
+/**
+  * @brief  MSC_BOT_DeInit
+  *         DeInitialize the BOT Machine
+  * @param  pdev: device instance
+  * @retval None
+  */
+void MSC_BOT_DeInit(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hmsc != NULL)
+  {
+    hmsc->bot_state = USBD_BOT_IDLE;
+  }
+}
+
+/**
+  * @brief  MSC_BOT_DataIn
+  *         Handle BOT IN data stage
+  * @param  pdev: device instance
+  * @retval None
+  */
+void MSC_BOT_DataIn(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  switch (hmsc->bot_state)
+  {
+    case USBD_BOT_DATA_IN:
+      MSC_BOT_ReadNext(pdev);
+      break;
+
+    case USBD_BOT_SEND_DATA:
+    case USBD_BOT_LAST_DATA_IN:
+      MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_PASSED);
+      break;
+
+    default:
+      break;
+  }
+}
+/**
+  * @brief  MSC_BOT_DataOut
+  *         Process MSC OUT data
+  * @param  pdev: device instance
+  * @retval None
+  */
+void MSC_BOT_DataOut(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  switch (hmsc->bot_state)
+  {
+    case USBD_BOT_IDLE:
+      MSC_BOT_CBW_Decode(pdev);
+      break;
+
+    case USBD_BOT_DATA_OUT:
+      MSC_BOT_WriteNext(pdev);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+  * @brief  MSC_BOT_CBW_Decode
+  *         Decode the CBW command and set the BOT state machine accordingly
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void  MSC_BOT_CBW_Decode(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  hmsc->csw.dTag = hmsc->cbw.dTag;
+  hmsc->csw.dDataResidue = hmsc->cbw.dDataLength;
+
+  if ((hmsc->RxLength != USBD_BOT_CBW_LENGTH) ||
+      (hmsc->cbw.dSignature != USBD_BOT_CBW_SIGNATURE) ||
+      (hmsc->cbw.bLUN > hmsc->max_lun) || (hmsc->cbw.bCBLength < 1U) ||
+      (hmsc->cbw.bCBLength > 16U))
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, ILLEGAL_REQUEST, INVALID_CDB);
+
+    hmsc->bot_status = USBD_BOT_STATUS_ERROR;
+    MSC_BOT_Abort(pdev);
+  }
+  else
+  {
+    hmsc->bot_status = USBD_BOT_STATUS_NORMAL;
+    hmsc->bot_state = USBD_BOT_IDLE;
+    hmsc->bot_data_length = 0U;
+
+    if (SCSI_ProcessCmd(pdev, hmsc->cbw.bLUN, &hmsc->cbw.CB[0]) < 0)
+    {
+      if (hmsc->cbw.dDataLength == 0U)
+      {
+        MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_FAILED);
+      }
+      else
+      {
+        MSC_BOT_Abort(pdev);
+      }
+    }
+    /* Media transfers are driven by the read and write pipelines */
+    else if ((hmsc->bot_state != USBD_BOT_DATA_IN) &&
+             (hmsc->bot_state != USBD_BOT_DATA_OUT) &&
+             (hmsc->bot_state != USBD_BOT_LAST_DATA_IN))
+    {
+      if ((hmsc->bot_data_length > 0U) && (hmsc->cbw.dDataLength > 0U))
+      {
+        MSC_BOT_SendData(pdev, hmsc->bot_data, hmsc->bot_data_length);
+      }
+      else
+      {
+        MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_PASSED);
+      }
+    }
+    else
+    {
+      return;
+    }
+  }
+}
+
+/**
+  * @brief  MSC_BOT_SendData
+  *         Send the requested data
+  * @param  pdev: device instance
+  * @param  pbuf: pointer to data buffer
+  * @param  len: Data Length
+  * @retval None
+  */
+static void  MSC_BOT_SendData(USBD_HandleTypeDef *pdev, uint8_t *pbuf, uint32_t len)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint32_t length = MIN(hmsc->cbw.dDataLength, len);
+
+  hmsc->csw.dDataResidue -= length;
+  hmsc->csw.bStatus = USBD_CSW_CMD_PASSED;
+  hmsc->bot_state = USBD_BOT_SEND_DATA;
+
+  MSC_BOT_LOCK();
+  (void)USBD_LL_Transmit(pdev, hmsc->InEp, pbuf, length);
+  MSC_BOT_UNLOCK();
+}
+
+/**
+  * @brief  MSC_BOT_SendCSW
+  *         Send the Command Status Wrapper and wait for the next CBW
+  * @param  pdev: device instance
+  * @param  CSW_Status : CSW status
+  * @retval None
+  */
+void  MSC_BOT_SendCSW(USBD_HandleTypeDef *pdev, uint8_t CSW_Status)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  hmsc->csw.dSignature = USBD_BOT_CSW_SIGNATURE;
+  hmsc->csw.bStatus = CSW_Status;
+  hmsc->bot_state = USBD_BOT_IDLE;
+  hmsc->xfer_busy = 0U;
+  hmsc->xfer_ready = 0U;
+
+  MSC_BOT_LOCK();
+  (void)USBD_LL_Transmit(pdev, hmsc->InEp, (uint8_t *)&hmsc->csw,
+                         USBD_BOT_CSW_LENGTH);
+
+  /* Prepare EP to Receive next Cmd */
+  (void)USBD_LL_PrepareReceive(pdev, hmsc->OutEp, (uint8_t *)&hmsc->cbw,
+                               USBD_BOT_CBW_LENGTH);
+  MSC_BOT_UNLOCK();
+}
+
+/**
+  * @brief  MSC_BOT_Abort
+  *         Stall the data stage, the CSW follows the clear of the IN halt
+  * @param  pdev: device instance
+  * @retval status
+  */
+void  MSC_BOT_Abort(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  /* Nothing more is sent or received for this command */
+  hmsc->bot_state = USBD_BOT_NO_DATA;
+  hmsc->xfer_busy = 0U;
+  hmsc->xfer_ready = 0U;
+
+  MSC_BOT_LOCK();
+  if ((hmsc->cbw.bmFlags == 0U) &&
+      (hmsc->cbw.dDataLength != 0U) &&
+      (hmsc->bot_status == USBD_BOT_STATUS_NORMAL))
+  {
+    (void)USBD_LL_StallEP(pdev, hmsc->OutEp);
+  }
+
+  (void)USBD_LL_StallEP(pdev, hmsc->InEp);
+
+  if (hmsc->bot_status == USBD_BOT_STATUS_ERROR)
+  {
+    (void)USBD_LL_StallEP(pdev, hmsc->InEp);
+    (void)USBD_LL_StallEP(pdev, hmsc->OutEp);
+  }
+  MSC_BOT_UNLOCK();
+}
+
+/**
+  * @brief  MSC_BOT_CplClrFeature
+  *         Complete the clear feature request
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval None
+  */
+
+void  MSC_BOT_CplClrFeature(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  if (hmsc->bot_status == USBD_BOT_STATUS_ERROR) /* Bad CBW Signature */
+  {
+    MSC_BOT_LOCK();
+    (void)USBD_LL_StallEP(pdev, hmsc->InEp);
+    (void)USBD_LL_StallEP(pdev, hmsc->OutEp);
+    MSC_BOT_UNLOCK();
+  }
+  else if (((epnum & 0x80U) == 0x80U) && (hmsc->bot_status != USBD_BOT_STATUS_RECOVERY))
+  {
+    MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_FAILED);
+  }
+  else
+  {
+    return;
+  }
+}
+
+/**
+  * @brief  MSC_BOT_ReadMedia
+  *         Read the next chunk of a READ command into a media buffer
+  * @param  pdev: device instance
+  * @param  idx: media buffer
+  * @retval status, the sense code is set on error
+  */
+static int8_t MSC_BOT_ReadMedia(USBD_HandleTypeDef *pdev, uint8_t idx)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint32_t n = MIN(hmsc->scsi_blk_len, MSC_MEDIA_PACKET / (uint32_t)hmsc->scsi_blk_size);
+
+  if (USBD_MSC_GetStorage(pdev)->Read(hmsc->cbw.bLUN, USBD_MSC_GetMediaBuffer(idx),
+                                      hmsc->scsi_blk_addr, (uint16_t)n) < 0)
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, MEDIUM_ERROR, UNRECOVERED_READ_ERROR);
+    return -1;
+  }
+
+  hmsc->scsi_blk_addr += n;
+  hmsc->scsi_blk_len -= n;
+  hmsc->xfer_len[idx] = n * hmsc->scsi_blk_size;
+
+  return 0;
+}
+
+/**
+  * @brief  MSC_BOT_SendChunk
+  *         Put a filled media buffer on the bus
+  * @param  pdev: device instance
+  * @param  idx: media buffer
+  * @retval None
+  */
+static void MSC_BOT_SendChunk(USBD_HandleTypeDef *pdev, uint8_t idx)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  hmsc->xfer_idx = idx;
+  hmsc->xfer_busy = 1U;
+  hmsc->csw.dDataResidue -= hmsc->xfer_len[idx];
+
+  MSC_BOT_LOCK();
+  (void)USBD_LL_Transmit(pdev, hmsc->InEp, USBD_MSC_GetMediaBuffer(idx), hmsc->xfer_len[idx]);
+  MSC_BOT_UNLOCK();
+}
+
+/**
+  * @brief  MSC_BOT_StartRead
+  *         Start the data stage of a READ, scsi_blk_addr/len are set
+  * @param  pdev: device instance
+  * @retval status
+  */
+int8_t MSC_BOT_StartRead(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  hmsc->xfer_ready = 0U;
+  hmsc->xfer_error = 0U;
+
+  if (MSC_BOT_ReadMedia(pdev, 0U) < 0)
+  {
+    return -1;
+  }
+
+  hmsc->bot_state = USBD_BOT_DATA_IN;
+  MSC_BOT_SendChunk(pdev, 0U);
+
+  /* Read ahead while the first chunk is on the bus */
+  if (hmsc->scsi_blk_len > 0U)
+  {
+    if (MSC_BOT_ReadMedia(pdev, 1U) < 0)
+    {
+      hmsc->xfer_error = 1U;
+    }
+    else
+    {
+      hmsc->xfer_ready = 1U;
+    }
+  }
+
+  return 0;
+}
+
+/**
+  * @brief  MSC_BOT_ReadNext
+  *         A READ chunk left, send the one read ahead and read the next
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void MSC_BOT_ReadNext(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint8_t next = hmsc->xfer_idx ^ 1U;
+
+  hmsc->xfer_busy = 0U;
+
+  if (hmsc->xfer_error != 0U)
+  {
+    MSC_BOT_Abort(pdev);
+    return;
+  }
+
+  if (hmsc->xfer_ready == 0U)
+  {
+    MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_PASSED);
+    return;
+  }
+
+  hmsc->xfer_ready = 0U;
+  MSC_BOT_SendChunk(pdev, next);
+
+  if (hmsc->scsi_blk_len > 0U)
+  {
+    if (MSC_BOT_ReadMedia(pdev, next ^ 1U) < 0)
+    {
+      hmsc->xfer_error = 1U;
+    }
+    else
+    {
+      hmsc->xfer_ready = 1U;
+    }
+  }
+}
+
+/**
+  * @brief  MSC_BOT_ArmOut
+  *         Receive the next chunk of a WRITE into a media buffer
+  * @param  pdev: device instance
+  * @param  idx: media buffer
+  * @retval None
+  */
+static void MSC_BOT_ArmOut(USBD_HandleTypeDef *pdev, uint8_t idx)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint32_t n = MIN(hmsc->xfer_blk_len, MSC_MEDIA_PACKET / (uint32_t)hmsc->scsi_blk_size);
+
+  hmsc->xfer_blk_len -= n;
+  hmsc->xfer_len[idx] = n * hmsc->scsi_blk_size;
+  hmsc->xfer_idx = idx;
+  hmsc->xfer_busy = 1U;
+
+  MSC_BOT_LOCK();
+  (void)USBD_LL_PrepareReceive(pdev, hmsc->OutEp, USBD_MSC_GetMediaBuffer(idx), hmsc->xfer_len[idx]);
+  MSC_BOT_UNLOCK();
+}
+
+/**
+  * @brief  MSC_BOT_StartWrite
+  *         Start the data stage of a WRITE, scsi_blk_addr/len are set
+  * @param  pdev: device instance
+  * @retval status
+  */
+int8_t MSC_BOT_StartWrite(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  hmsc->xfer_blk_len = hmsc->scsi_blk_len;
+  hmsc->xfer_error = 0U;
+  hmsc->bot_state = USBD_BOT_DATA_OUT;
+
+  MSC_BOT_ArmOut(pdev, 0U);
+
+  return 0;
+}
+
+/**
+  * @brief  MSC_BOT_WriteNext
+  *         A WRITE chunk arrived: receive the next one and write this one
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void MSC_BOT_WriteNext(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint8_t idx = hmsc->xfer_idx;
+  uint32_t len = hmsc->xfer_len[idx];
+
+  hmsc->xfer_busy = 0U;
+
+  if (hmsc->RxLength != len)
+  {
+    /* The host ended the data stage early */
+    MSC_BOT_SendCSW(pdev, USBD_CSW_PHASE_ERROR);
+    return;
+  }
+
+  if (hmsc->xfer_blk_len > 0U)
+  {
+    MSC_BOT_ArmOut(pdev, idx ^ 1U);
+  }
+
+  if (USBD_MSC_GetStorage(pdev)->Write(hmsc->cbw.bLUN, USBD_MSC_GetMediaBuffer(idx),
+                                       hmsc->scsi_blk_addr,
+                                       (uint16_t)(len / hmsc->scsi_blk_size)) < 0)
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, HARDWARE_ERROR, WRITE_FAULT);
+    MSC_BOT_Abort(pdev);
+    return;
+  }
+
+  hmsc->scsi_blk_addr += len / hmsc->scsi_blk_size;
+  hmsc->scsi_blk_len -= len / hmsc->scsi_blk_size;
+  hmsc->csw.dDataResidue -= len;
+
+  if (hmsc->scsi_blk_len == 0U)
+  {
+    MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_PASSED);
+  }
+}
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
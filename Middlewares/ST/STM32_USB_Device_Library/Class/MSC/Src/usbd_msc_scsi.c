@@ -0,0 +1,734 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc_scsi.c
+  * @brief   This file provides all the USBD SCSI layer functions.
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                SCSI Commands
+  *          ===================================================================
+  *           Immediate commands fill bot_data and set bot_data_length, the
+  *           transport sends it. READ and WRITE check the CBW against the CDB
+  *           and hand the block range to the transport pipelines.
+  *
+  *           MODE SENSE reports a caching page with WCE set: the media sits
+  *           behind a write-back cache, the host then sends SYNCHRONIZE CACHE
+  *           on unmount and eject which flushes it.
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_msc_bot.h"
+#include "usbd_msc_scsi.h"
+#include "usbd_msc.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup MSC_SCSI
+  * @brief Mass storage SCSI layer module
+  * @{
+  */
+
+/** @defgroup MSC_SCSI_Private_Macros
+  * @{
+  */
+#define SCSI_BE16(p)    (((uint32_t)(p)[0] << 8) | (uint32_t)(p)[1])
+#define SCSI_BE32(p)    (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | \
+                         ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
+/**
+  * @}
+  */
+
+
+/** @defgroup MSC_SCSI_Private_FunctionPrototypes
+  * @{
+  */
+static int8_t SCSI_TestUnitReady(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_Inquiry(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_ReadFormatCapacity(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_ReadCapacity10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_RequestSense(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_StartStopUnit(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_AllowPreventRemovable(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_ModeSense(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params, uint8_t ten);
+static int8_t SCSI_Read(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params, uint8_t twelve);
+static int8_t SCSI_Write(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params, uint8_t twelve);
+static int8_t SCSI_Verify10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_SynchronizeCache10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_CheckMedia(USBD_HandleTypeDef *pdev, uint8_t lun);
+static int8_t SCSI_CheckAddressRange(USBD_HandleTypeDef *pdev, uint8_t lun,
+                                     uint32_t blk_offset, uint32_t blk_nbr);
+/**
+  * @}
+  */
+
+
+/** @defgroup MSC_SCSI_Private_Functions
+  * @{
+  */
+
+
+/**
+  * @brief  SCSI_ProcessCmd
+  *         Process SCSI commands
+  * @param  pdev: device instance
+  * @param  lun: Logical unit number
+  * @param  cmd: Command parameters
+  * @retval status
+  */
+int8_t SCSI_ProcessCmd(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *cmd)
+{
+  int8_t ret;
+
+  switch (cmd[0])
+  {
+    case SCSI_TEST_UNIT_READY:
+      ret = SCSI_TestUnitReady(pdev, lun, cmd);
+      break;
+
+    case SCSI_REQUEST_SENSE:
+      ret = SCSI_RequestSense(pdev, lun, cmd);
+      break;
+
+    case SCSI_INQUIRY:
+      ret = SCSI_Inquiry(pdev, lun, cmd);
+      break;
+
+    case SCSI_START_STOP_UNIT:
+      ret = SCSI_StartStopUnit(pdev, lun, cmd);
+      break;
+
+    case SCSI_ALLOW_MEDIUM_REMOVAL:
+      ret = SCSI_AllowPreventRemovable(pdev, lun, cmd);
+      break;
+
+    case SCSI_MODE_SENSE6:
+      ret = SCSI_ModeSense(pdev, lun, cmd, 0U);
+      break;
+
+    case SCSI_MODE_SENSE10:
+      ret = SCSI_ModeSense(pdev, lun, cmd, 1U);
+      break;
+
+    case SCSI_READ_FORMAT_CAPACITIES:
+      ret = SCSI_ReadFormatCapacity(pdev, lun, cmd);
+      break;
+
+    case SCSI_READ_CAPACITY10:
+      ret = SCSI_ReadCapacity10(pdev, lun, cmd);
+      break;
+
+    case SCSI_READ10:
+      ret = SCSI_Read(pdev, lun, cmd, 0U);
+      break;
+
+    case SCSI_READ12:
+      ret = SCSI_Read(pdev, lun, cmd, 1U);
+      break;
+
+    case SCSI_WRITE10:
+      ret = SCSI_Write(pdev, lun, cmd, 0U);
+      break;
+
+    case SCSI_WRITE12:
+      ret = SCSI_Write(pdev, lun, cmd, 1U);
+      break;
+
+    case SCSI_VERIFY10:
+      ret = SCSI_Verify10(pdev, lun, cmd);
+      break;
+
+    case SCSI_SYNCHRONIZE_CACHE10:
+      ret = SCSI_SynchronizeCache10(pdev, lun, cmd);
+      break;
+
+    default:
+      SCSI_SenseCode(pdev, lun, ILLEGAL_REQUEST, INVALID_CDB);
+      ret = -1;
+      break;
+  }
+
+  return ret;
+}
+
+
+/**
+  * @brief  SCSI_TestUnitReady
+  *         Process SCSI Test Unit Ready Command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_TestUnitReady(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  UNUSED(params);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  /* case 9 : Hi > D0 */
+  if (hmsc->cbw.dDataLength != 0U)
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, ILLEGAL_REQUEST, INVALID_CDB);
+    return -1;
+  }
+
+  if (SCSI_CheckMedia(pdev, lun) < 0)
+  {
+    return -1;
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_Inquiry
+  *         Process Inquiry command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_Inquiry(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint32_t alloc = SCSI_BE16(&params[3]);
+  uint32_t len;
+
+  if ((params[1] & 0x01U) != 0U) /* Evpd is set */
+  {
+    if (params[2] != 0x00U)
+    {
+      SCSI_SenseCode(pdev, lun, ILLEGAL_REQUEST, INVALID_FIELD_IN_COMMAND);
+      return -1;
+    }
+
+    /* Supported VPD pages: this one only */
+    hmsc->bot_data[0] = 0x00U;
+    hmsc->bot_data[1] = 0x00U;
+    hmsc->bot_data[2] = 0x00U;
+    hmsc->bot_data[3] = 0x01U;
+    hmsc->bot_data[4] = 0x00U;
+    len = 5U;
+  }
+  else
+  {
+    uint8_t *pPage = (uint8_t *) &USBD_MSC_GetStorage(pdev)->pInquiry[lun * STANDARD_INQUIRY_DATA_LEN];
+
+    len = MIN((uint32_t)pPage[4] + 5U, STANDARD_INQUIRY_DATA_LEN);
+    (void)USBD_memcpy(hmsc->bot_data, pPage, len);
+  }
+
+  hmsc->bot_data_length = MIN(len, alloc);
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_ReadCapacity10
+  *         Process Read Capacity 10 command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_ReadCapacity10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  UNUSED(params);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint32_t last;
+
+  if (SCSI_CheckMedia(pdev, lun) < 0)
+  {
+    return -1;
+  }
+
+  last = hmsc->scsi_blk_nbr - 1U;
+
+  hmsc->bot_data[0] = (uint8_t)(last >> 24);
+  hmsc->bot_data[1] = (uint8_t)(last >> 16);
+  hmsc->bot_data[2] = (uint8_t)(last >>  8);
+  hmsc->bot_data[3] = (uint8_t)(last);
+
+  hmsc->bot_data[4] = 0U;
+  hmsc->bot_data[5] = 0U;
+  hmsc->bot_data[6] = (uint8_t)(hmsc->scsi_blk_size >>  8);
+  hmsc->bot_data[7] = (uint8_t)(hmsc->scsi_blk_size);
+
+  hmsc->bot_data_length = READ_CAPACITY10_DATA_LEN;
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_ReadFormatCapacity
+  *         Process Read Format Capacity command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_ReadFormatCapacity(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint32_t blk_nbr = 0U;
+  uint16_t blk_size = 0U;
+  uint8_t i;
+
+  for (i = 0U; i < READ_FORMAT_CAPACITY_DATA_LEN; i++)
+  {
+    hmsc->bot_data[i] = 0U;
+  }
+
+  hmsc->bot_data[3] = 0x08U;  /* one capacity descriptor */
+
+  if (USBD_MSC_GetStorage(pdev)->GetCapacity(lun, &blk_nbr, &blk_size) != 0)
+  {
+    /* Maximum capacity, no media present */
+    hmsc->bot_data[4] = 0xFFU;
+    hmsc->bot_data[5] = 0xFFU;
+    hmsc->bot_data[6] = 0xFFU;
+    hmsc->bot_data[7] = 0xFFU;
+    hmsc->bot_data[8] = 0x03U;
+    blk_size = 512U;
+  }
+  else
+  {
+    hmsc->bot_data[4] = (uint8_t)(blk_nbr >> 24);
+    hmsc->bot_data[5] = (uint8_t)(blk_nbr >> 16);
+    hmsc->bot_data[6] = (uint8_t)(blk_nbr >>  8);
+    hmsc->bot_data[7] = (uint8_t)(blk_nbr);
+    hmsc->bot_data[8] = 0x02U;  /* formatted media */
+  }
+
+  hmsc->bot_data[9]  = 0U;
+  hmsc->bot_data[10] = (uint8_t)(blk_size >>  8);
+  hmsc->bot_data[11] = (uint8_t)(blk_size);
+
+  hmsc->bot_data_length = MIN(READ_FORMAT_CAPACITY_DATA_LEN, SCSI_BE16(&params[7]));
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_ModeSense
+  *         Process Mode Sense6 and Mode Sense10 commands
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @param  ten: MODE SENSE(10) layout
+  * @retval status
+  */
+static int8_t SCSI_ModeSense(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params, uint8_t ten)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint8_t page = params[2] & 0x3FU;
+  uint32_t hdr = (ten != 0U) ? MODE_SENSE10_HDR_LEN : MODE_SENSE6_HDR_LEN;
+  uint32_t alloc = (ten != 0U) ? SCSI_BE16(&params[7]) : (uint32_t)params[4];
+  uint8_t wp = (USBD_MSC_GetStorage(pdev)->IsWriteProtected(lun) != 0) ? 0x80U : 0x00U;
+  uint32_t len = hdr;
+  uint32_t i;
+
+  for (i = 0U; i < (MODE_SENSE10_HDR_LEN + MODE_SENSE_CACHING_PAGE_LEN); i++)
+  {
+    hmsc->bot_data[i] = 0U;
+  }
+
+  /* Caching mode page: write cache enabled */
+  if ((page == 0x08U) || (page == 0x3FU))
+  {
+    hmsc->bot_data[len + 0U] = 0x08U;
+    hmsc->bot_data[len + 1U] = MODE_SENSE_CACHING_PAGE_LEN - 2U;
+    hmsc->bot_data[len + 2U] = 0x04U;
+    len += MODE_SENSE_CACHING_PAGE_LEN;
+  }
+
+  if (ten != 0U)
+  {
+    hmsc->bot_data[0] = (uint8_t)((len - 2U) >> 8);
+    hmsc->bot_data[1] = (uint8_t)(len - 2U);
+    hmsc->bot_data[3] = wp;
+  }
+  else
+  {
+    hmsc->bot_data[0] = (uint8_t)(len - 1U);
+    hmsc->bot_data[2] = wp;
+  }
+
+  hmsc->bot_data_length = MIN(len, alloc);
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_RequestSense
+  *         Process Request Sense command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_RequestSense(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  UNUSED(lun);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  uint8_t i;
+
+  for (i = 0U; i < REQUEST_SENSE_DATA_LEN; i++)
+  {
+    hmsc->bot_data[i] = 0U;
+  }
+
+  hmsc->bot_data[0] = 0x70U;
+  hmsc->bot_data[7] = REQUEST_SENSE_DATA_LEN - 8U;
+
+  if ((hmsc->scsi_sense_head != hmsc->scsi_sense_tail))
+  {
+    hmsc->bot_data[2] = (uint8_t)hmsc->scsi_sense[hmsc->scsi_sense_head].Skey;
+    hmsc->bot_data[12] = (uint8_t)hmsc->scsi_sense[hmsc->scsi_sense_head].ASC;
+    hmsc->bot_data[13] = (uint8_t)hmsc->scsi_sense[hmsc->scsi_sense_head].ASCQ;
+    hmsc->scsi_sense_head++;
+
+    if (hmsc->scsi_sense_head == SENSE_LIST_DEEPTH)
+    {
+      hmsc->scsi_sense_head = 0U;
+    }
+  }
+
+  hmsc->bot_data_length = MIN(REQUEST_SENSE_DATA_LEN, params[4]);
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_SenseCode
+  *         Load the last error code in the error list
+  * @param  lun: Logical unit number
+  * @param  sKey: Sense Key
+  * @param  ASC: Additional Sense Code
+  * @retval none
+
+  */
+void SCSI_SenseCode(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t sKey, uint8_t ASC)
+{
+  UNUSED(lun);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (hmsc == NULL)
+  {
+    return;
+  }
+
+  hmsc->scsi_sense[hmsc->scsi_sense_tail].Skey = sKey;
+  hmsc->scsi_sense[hmsc->scsi_sense_tail].ASC = ASC;
+  hmsc->scsi_sense[hmsc->scsi_sense_tail].ASCQ = 0U;
+  hmsc->scsi_sense_tail++;
+
+  if (hmsc->scsi_sense_tail == SENSE_LIST_DEEPTH)
+  {
+    hmsc->scsi_sense_tail = 0U;
+  }
+}
+
+
+/**
+  * @brief  SCSI_StartStopUnit
+  *         Process Start Stop Unit command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_StartStopUnit(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  USBD_StorageTypeDef *storage = USBD_MSC_GetStorage(pdev);
+
+  if ((hmsc->scsi_medium_state == SCSI_MEDIUM_LOCKED) && ((params[4] & 0x3U) == 2U))
+  {
+    SCSI_SenseCode(pdev, lun, ILLEGAL_REQUEST, INVALID_FIELD_IN_COMMAND);
+    return -1;
+  }
+
+  if ((params[4] & 0x3U) == 0x2U) /* START=0 and LOEJ Load Eject=1 */
+  {
+    if ((storage->Sync != NULL) && (storage->Sync(lun) < 0))
+    {
+      SCSI_SenseCode(pdev, lun, MEDIUM_ERROR, WRITE_FAULT);
+      return -1;
+    }
+    hmsc->scsi_medium_state = SCSI_MEDIUM_EJECTED;
+  }
+  else if ((params[4] & 0x3U) == 0x3U) /* START=1 and LOEJ Load Eject=1 */
+  {
+    hmsc->scsi_medium_state = SCSI_MEDIUM_UNLOCKED;
+  }
+  else
+  {
+    /* START=1 or 0 and LOEJ=0: nothing to spin */
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_AllowPreventRemovable
+  *         Process Allow Prevent Removable medium command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_AllowPreventRemovable(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  UNUSED(lun);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if (params[4] == 0U)
+  {
+    hmsc->scsi_medium_state = SCSI_MEDIUM_UNLOCKED;
+  }
+  else
+  {
+    hmsc->scsi_medium_state = SCSI_MEDIUM_LOCKED;
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_Read
+  *         Process Read10 and Read12 commands
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @param  twelve: READ(12) layout
+  * @retval status
+  */
+static int8_t SCSI_Read(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params, uint8_t twelve)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  /* case 10 : Ho <> Di */
+  if ((hmsc->cbw.bmFlags & 0x80U) != 0x80U)
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, ILLEGAL_REQUEST, INVALID_CDB);
+    return -1;
+  }
+
+  if (SCSI_CheckMedia(pdev, lun) < 0)
+  {
+    return -1;
+  }
+
+  hmsc->scsi_blk_addr = SCSI_BE32(&params[2]);
+  hmsc->scsi_blk_len = (twelve != 0U) ? SCSI_BE32(&params[6]) : SCSI_BE16(&params[7]);
+
+  if (SCSI_CheckAddressRange(pdev, lun, hmsc->scsi_blk_addr, hmsc->scsi_blk_len) < 0)
+  {
+    return -1; /* error */
+  }
+
+  /* cases 4,5 : Hi <> Dn */
+  if (hmsc->cbw.dDataLength != (hmsc->scsi_blk_len * hmsc->scsi_blk_size))
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, ILLEGAL_REQUEST, INVALID_CDB);
+    return -1;
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  if (hmsc->scsi_blk_len == 0U)
+  {
+    return 0;
+  }
+
+  return MSC_BOT_StartRead(pdev);
+}
+
+
+/**
+  * @brief  SCSI_Write
+  *         Process Write10 and Write12 commands
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @param  twelve: WRITE(12) layout
+  * @retval status
+  */
+static int8_t SCSI_Write(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params, uint8_t twelve)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  /* case 8 : Hi <> Do */
+  if ((hmsc->cbw.bmFlags & 0x80U) == 0x80U)
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, ILLEGAL_REQUEST, INVALID_CDB);
+    return -1;
+  }
+
+  if (SCSI_CheckMedia(pdev, lun) < 0)
+  {
+    return -1;
+  }
+
+  /* Check If media is write-protected */
+  if (USBD_MSC_GetStorage(pdev)->IsWriteProtected(lun) != 0)
+  {
+    SCSI_SenseCode(pdev, lun, DATA_PROTECT, WRITE_PROTECTED);
+    return -1;
+  }
+
+  hmsc->scsi_blk_addr = SCSI_BE32(&params[2]);
+  hmsc->scsi_blk_len = (twelve != 0U) ? SCSI_BE32(&params[6]) : SCSI_BE16(&params[7]);
+
+  /* check if LBA address is in the right range */
+  if (SCSI_CheckAddressRange(pdev, lun, hmsc->scsi_blk_addr, hmsc->scsi_blk_len) < 0)
+  {
+    return -1; /* error */
+  }
+
+  /* cases 3,11,13 : Hn,Ho <> D0 */
+  if (hmsc->cbw.dDataLength != (hmsc->scsi_blk_len * hmsc->scsi_blk_size))
+  {
+    SCSI_SenseCode(pdev, hmsc->cbw.bLUN, ILLEGAL_REQUEST, INVALID_CDB);
+    return -1;
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  if (hmsc->scsi_blk_len == 0U)
+  {
+    return 0;
+  }
+
+  return MSC_BOT_StartWrite(pdev);
+}
+
+
+/**
+  * @brief  SCSI_Verify10
+  *         Process Verify10 command, the media has no check to run
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_Verify10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if ((params[1] & 0x02U) == 0x02U)
+  {
+    SCSI_SenseCode(pdev, lun, ILLEGAL_REQUEST, INVALID_FIELD_IN_COMMAND);
+    return -1; /* Error, Verify Mode Not supported*/
+  }
+
+  if (SCSI_CheckMedia(pdev, lun) < 0)
+  {
+    return -1;
+  }
+
+  if (SCSI_CheckAddressRange(pdev, lun, SCSI_BE32(&params[2]), SCSI_BE16(&params[7])) < 0)
+  {
+    return -1; /* error */
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_SynchronizeCache10
+  *         Process Synchronize Cache10 command, write back the media cache
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_SynchronizeCache10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  UNUSED(params);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  USBD_StorageTypeDef *storage = USBD_MSC_GetStorage(pdev);
+
+  if ((storage->Sync != NULL) && (storage->Sync(lun) < 0))
+  {
+    SCSI_SenseCode(pdev, lun, MEDIUM_ERROR, WRITE_FAULT);
+    return -1;
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_CheckMedia
+  *         Check the unit is ready and refresh its geometry
+  * @param  lun: Logical unit number
+  * @retval status
+  */
+static int8_t SCSI_CheckMedia(USBD_HandleTypeDef *pdev, uint8_t lun)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+  USBD_StorageTypeDef *storage = USBD_MSC_GetStorage(pdev);
+
+  if ((hmsc->scsi_medium_state == SCSI_MEDIUM_EJECTED) ||
+      (storage->IsReady(lun) != 0) ||
+      (storage->GetCapacity(lun, &hmsc->scsi_blk_nbr, &hmsc->scsi_blk_size) != 0) ||
+      (hmsc->scsi_blk_size == 0U) || (hmsc->scsi_blk_size > MSC_MEDIA_PACKET))
+  {
+    SCSI_SenseCode(pdev, lun, NOT_READY, MEDIUM_NOT_PRESENT);
+    return -1;
+  }
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_CheckAddressRange
+  *         Check address range
+  * @param  lun: Logical unit number
+  * @param  blk_offset: first block address
+  * @param  blk_nbr: number of block to be processed
+  * @retval status
+  */
+static int8_t SCSI_CheckAddressRange(USBD_HandleTypeDef *pdev, uint8_t lun,
+                                     uint32_t blk_offset, uint32_t blk_nbr)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_GetHandle(pdev);
+
+  if ((blk_offset > hmsc->scsi_blk_nbr) || (blk_nbr > (hmsc->scsi_blk_nbr - blk_offset)))
+  {
+    SCSI_SenseCode(pdev, lun, ILLEGAL_REQUEST, ADDRESS_OUT_OF_RANGE);
+    return -1;
+  }
+
+  return 0;
+}
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
@@ -0,0 +1,154 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vendor.h
+  * @brief   Header file for the usbd_vendor.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * Vendor specific bulk function: one interface (class 0xFF) with a bulk IN
+  * and a bulk OUT endpoint, no class requests on the data path. The function
+  * answers the Microsoft OS 2.0 descriptor request so that Windows binds
+  * WinUSB to it without an INF; Linux and macOS use it through libusb.
+  *
+  * The class is meant to be registered through the composite builder.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USB_VENDOR_H
+#define __USB_VENDOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup usbd_vendor
+  * @brief This file is the Header file for usbd_vendor.c
+  * @{
+  */
+
+
+/** @defgroup usbd_vendor_Exported_Defines
+  * @{
+  */
+#ifndef VENDOR_IN_EP
+#define VENDOR_IN_EP                                0x85U  /* EP5 for data IN */
+#endif /* VENDOR_IN_EP */
+#ifndef VENDOR_OUT_EP
+#define VENDOR_OUT_EP                               0x05U  /* EP5 for data OUT */
+#endif /* VENDOR_OUT_EP */
+
+#define VENDOR_DATA_HS_MAX_PACKET_SIZE              512U  /* Endpoint IN & OUT Packet size */
+#define VENDOR_DATA_FS_MAX_PACKET_SIZE              64U   /* Endpoint IN & OUT Packet size */
+
+/* Interface + 2 endpoint descriptors */
+#define USB_VENDOR_FUNC_DESC_SIZ                    23U
+
+#define VENDOR_REQ_MAX_DATA_SIZE                    64U
+
+/*---------------------------------------------------------------------*/
+/*  Microsoft OS 2.0 descriptors                                       */
+/*---------------------------------------------------------------------*/
+#ifndef VENDOR_MS_VENDOR_CODE
+#define VENDOR_MS_VENDOR_CODE                       0x20U  /* bRequest of the MS OS 2.0 request */
+#endif /* VENDOR_MS_VENDOR_CODE */
+
+/* DeviceInterfaceGUIDs registry value, used by WinUSB clients to find us */
+#ifndef VENDOR_DEVICE_INTERFACE_GUID
+#define VENDOR_DEVICE_INTERFACE_GUID                "{8F3A6C2E-5B1D-4E7A-9C44-2D6B1E0F7A31}"
+#endif /* VENDOR_DEVICE_INTERFACE_GUID */
+
+#define MS_OS_20_DESCRIPTOR_INDEX                   0x07U
+#define MS_OS_20_SET_HEADER_DESCRIPTOR              0x00U
+#define MS_OS_20_SUBSET_HEADER_CONFIGURATION        0x01U
+#define MS_OS_20_SUBSET_HEADER_FUNCTION             0x02U
+#define MS_OS_20_FEATURE_COMPATIBLE_ID              0x03U
+#define MS_OS_20_FEATURE_REG_PROPERTY               0x04U
+
+/* Set header + configuration subset + function subset + compatible ID +
+   DeviceInterfaceGUIDs (REG_MULTI_SZ, 42 byte name, 80 byte value) */
+#define VENDOR_MSOS20_DESC_SIZ                      (10U + 8U + 8U + 20U + 132U)
+
+/* BOS platform capability pointing at the descriptor set above */
+#define VENDOR_MSOS20_PLATFORM_CAP_SIZ              28U
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CORE_Exported_TypesDefinitions
+  * @{
+  */
+typedef struct _USBD_VENDOR_Itf
+{
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  int8_t (* Control)(uint8_t cmd, uint8_t *pbuf, uint16_t length);
+  int8_t (* Receive)(uint8_t *Buf, uint32_t *Len);
+  int8_t (* TransmitCplt)(uint8_t *Buf, uint32_t *Len, uint8_t epnum);
+} USBD_VENDOR_ItfTypeDef;
+
+
+typedef struct
+{
+  uint32_t data[VENDOR_REQ_MAX_DATA_SIZE / 4U];      /* Force 32-bit alignment */
+  uint8_t  CmdOpCode;
+  uint8_t  CmdLength;
+  uint8_t  *RxBuffer;
+  uint8_t  *TxBuffer;
+  uint32_t RxLength;
+  uint32_t TxLength;
+
+  __IO uint32_t TxState;
+  __IO uint32_t RxState;
+} USBD_VENDOR_HandleTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CORE_Exported_Variables
+  * @{
+  */
+extern USBD_ClassTypeDef USBD_VENDOR;
+#define USBD_VENDOR_CLASS &USBD_VENDOR
+/**
+  * @}
+  */
+
+/** @defgroup USB_CORE_Exported_Functions
+  * @{
+  */
+uint8_t USBD_VENDOR_RegisterInterface(USBD_HandleTypeDef *pdev,
+                                      USBD_VENDOR_ItfTypeDef *fops);
+
+uint8_t USBD_VENDOR_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff,
+                                uint32_t length, uint8_t ClassId);
+uint8_t USBD_VENDOR_TransmitPacket(USBD_HandleTypeDef *pdev, uint8_t ClassId);
+uint8_t USBD_VENDOR_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff);
+uint8_t USBD_VENDOR_ReceivePacket(USBD_HandleTypeDef *pdev);
+uint8_t USBD_VENDOR_GetPlatformCap(uint8_t *pbuf);
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USB_VENDOR_H */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,662 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vendor.c
+  * @brief   This file provides the high layer firmware functions to manage the
+  *          following functionalities of a vendor specific bulk function:
+  *           - Initialization and Configuration of high and low layer
+  *           - OUT/IN data transfer
+  *           - Vendor requests and Microsoft OS 2.0 descriptors
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                              Vendor Class Driver Description
+  *          ===================================================================
+  *           The function exposes one interface with a bulk IN and a bulk OUT
+  *           endpoint and nothing else: no line coding, no notification
+  *           endpoint, no class protocol on the data path.
+  *
+  *           IN transfers are handed to the core as one multi-packet transfer
+  *           and are NOT terminated by a zero length packet: the endpoint is a
+  *           byte stream and the host keeps its large URBs filling across
+  *           transfer boundaries.
+  *
+  *           Device recipient vendor requests with wIndex 7 return the MS OS
+  *           2.0 descriptor set (WinUSB compatible ID + DeviceInterfaceGUIDs)
+  *           for the function subset of this interface. Interface recipient
+  *           vendor requests are forwarded to the interface Control callback
+  *           like CDC class requests.
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_vendor.h"
+#include "usbd_ctlreq.h"
+
+#ifndef USE_USBD_COMPOSITE
+#error "usbd_vendor is registered through the composite builder, define USE_USBD_COMPOSITE"
+#endif /* USE_USBD_COMPOSITE */
+
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup USBD_VENDOR
+  * @brief usbd vendor module
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_VENDOR_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_VENDOR_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_VENDOR_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_VENDOR_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_VENDOR_EP0_RxReady(USBD_HandleTypeDef *pdev);
+static uint32_t USBD_VENDOR_BuildMsOs20(USBD_HandleTypeDef *pdev, uint8_t *pbuf);
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_Private_Variables
+  * @{
+  */
+
+/* Vendor interface class callbacks structure */
+USBD_ClassTypeDef  USBD_VENDOR =
+{
+  USBD_VENDOR_Init,
+  USBD_VENDOR_DeInit,
+  USBD_VENDOR_Setup,
+  NULL,                 /* EP0_TxSent */
+  USBD_VENDOR_EP0_RxReady,
+  USBD_VENDOR_DataIn,
+  USBD_VENDOR_DataOut,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+#if (USBD_SUPPORT_USER_STRING_DESC == 1U)
+  NULL,
+#endif /* USBD_SUPPORT_USER_STRING_DESC */
+};
+
+static uint8_t VENDORInEpAdd = VENDOR_IN_EP;
+static uint8_t VENDOROutEpAdd = VENDOR_OUT_EP;
+
+/* MS OS 2.0 descriptor set, built on request with the current interface number */
+__ALIGN_BEGIN static uint8_t USBD_VENDOR_MsOs20Desc[VENDOR_MSOS20_DESC_SIZ] __ALIGN_END;
+
+/* {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F}, MS OS 2.0 platform capability UUID */
+static const uint8_t USBD_VENDOR_MsOs20Uuid[16] =
+{
+  0xDFU, 0x60U, 0xDDU, 0xD8U, 0x89U, 0x45U, 0xC7U, 0x4CU,
+  0x9CU, 0xD2U, 0x65U, 0x9DU, 0x9EU, 0x64U, 0x8AU, 0x9FU
+};
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_VENDOR_Init
+  *         Initialize the vendor interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+  USBD_VENDOR_HandleTypeDef *hvendor;
+  uint16_t mps;
+
+  hvendor = (USBD_VENDOR_HandleTypeDef *)USBD_malloc(sizeof(USBD_VENDOR_HandleTypeDef));
+
+  if (hvendor == NULL)
+  {
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    return (uint8_t)USBD_EMEM;
+  }
+
+  (void)USBD_memset(hvendor, 0, sizeof(USBD_VENDOR_HandleTypeDef));
+
+  pdev->pClassDataCmsit[pdev->classId] = (void *)hvendor;
+  pdev->pClassData = pdev->pClassDataCmsit[pdev->classId];
+
+  /* Get the Endpoints addresses allocated for this class instance */
+  VENDORInEpAdd  = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+  VENDOROutEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_OUT, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+
+  mps = (pdev->dev_speed == USBD_SPEED_HIGH) ? VENDOR_DATA_HS_MAX_PACKET_SIZE
+                                             : VENDOR_DATA_FS_MAX_PACKET_SIZE;
+
+  /* Open EP IN */
+  (void)USBD_LL_OpenEP(pdev, VENDORInEpAdd, USBD_EP_TYPE_BULK, mps);
+  pdev->ep_in[VENDORInEpAdd & 0xFU].is_used = 1U;
+
+  /* Open EP OUT */
+  (void)USBD_LL_OpenEP(pdev, VENDOROutEpAdd, USBD_EP_TYPE_BULK, mps);
+  pdev->ep_out[VENDOROutEpAdd & 0xFU].is_used = 1U;
+
+  hvendor->RxBuffer = NULL;
+
+  /* Init  physical Interface components */
+  ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->Init();
+
+  /* Init Xfer states */
+  hvendor->TxState = 0U;
+  hvendor->RxState = 0U;
+
+  if (hvendor->RxBuffer == NULL)
+  {
+    return (uint8_t)USBD_EMEM;
+  }
+
+  /* Prepare Out endpoint to receive next packet */
+  (void)USBD_LL_PrepareReceive(pdev, VENDOROutEpAdd, hvendor->RxBuffer, mps);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_DeInit
+  *         DeInitialize the vendor layer
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+  /* Get the Endpoints addresses allocated for this class instance */
+  VENDORInEpAdd  = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+  VENDOROutEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_OUT, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+
+  /* Close EP IN */
+  (void)USBD_LL_CloseEP(pdev, VENDORInEpAdd);
+  pdev->ep_in[VENDORInEpAdd & 0xFU].is_used = 0U;
+
+  /* Close EP OUT */
+  (void)USBD_LL_CloseEP(pdev, VENDOROutEpAdd);
+  pdev->ep_out[VENDOROutEpAdd & 0xFU].is_used = 0U;
+
+  /* DeInit  physical Interface components */
+  if (pdev->pClassDataCmsit[pdev->classId] != NULL)
+  {
+    ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->DeInit();
+    (void)USBD_free(pdev->pClassDataCmsit[pdev->classId]);
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    pdev->pClassData = NULL;
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_Setup
+  *         Handle the vendor specific requests
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_Setup(USBD_HandleTypeDef *pdev,
+                                 USBD_SetupReqTypedef *req)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+  uint16_t len;
+  uint8_t ifalt = 0U;
+  uint16_t status_info = 0U;
+  USBD_StatusTypeDef ret = USBD_OK;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_VENDOR:
+      /* MS OS 2.0 descriptor set, also asked before SET_CONFIGURATION */
+      if (((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_DEVICE) &&
+          (req->bRequest == VENDOR_MS_VENDOR_CODE) &&
+          (req->wIndex == MS_OS_20_DESCRIPTOR_INDEX) &&
+          ((req->bmRequest & 0x80U) != 0U))
+      {
+        len = (uint16_t)USBD_VENDOR_BuildMsOs20(pdev, USBD_VENDOR_MsOs20Desc);
+        (void)USBD_CtlSendData(pdev, USBD_VENDOR_MsOs20Desc, MIN(len, req->wLength));
+        break;
+      }
+
+      if ((hvendor == NULL) ||
+          ((req->bmRequest & USB_REQ_RECIPIENT_MASK) != USB_REQ_RECIPIENT_INTERFACE))
+      {
+        USBD_CtlError(pdev, req);
+        ret = USBD_FAIL;
+        break;
+      }
+
+      if (req->wLength != 0U)
+      {
+        if ((req->bmRequest & 0x80U) != 0U)
+        {
+          len = MIN(VENDOR_REQ_MAX_DATA_SIZE, req->wLength);
+          ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->Control(req->bRequest,
+                                                                              (uint8_t *)hvendor->data,
+                                                                              len);
+          (void)USBD_CtlSendData(pdev, (uint8_t *)hvendor->data, len);
+        }
+        else
+        {
+          hvendor->CmdOpCode = req->bRequest;
+          hvendor->CmdLength = (uint8_t)MIN(req->wLength, VENDOR_REQ_MAX_DATA_SIZE);
+
+          (void)USBD_CtlPrepareRx(pdev, (uint8_t *)hvendor->data, hvendor->CmdLength);
+        }
+      }
+      else
+      {
+        ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->Control(req->bRequest,
+                                                                            (uint8_t *)req, 0U);
+      }
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, &ifalt, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE:
+          if (pdev->dev_state != USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_VENDOR_DataIn
+  *         Data sent on non-control IN endpoint, no ZLP is appended
+  * @param  pdev: device instance
+  * @param  epnum: endpoint number
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor;
+
+  if (pdev->pClassDataCmsit[pdev->classId] == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+  hvendor->TxState = 0U;
+
+  if (((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->TransmitCplt != NULL)
+  {
+    ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->TransmitCplt(hvendor->TxBuffer,
+                                                                             &hvendor->TxLength, epnum);
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_DataOut
+  *         Data received on non-control Out endpoint
+  * @param  pdev: device instance
+  * @param  epnum: endpoint number
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  /* Get the received data length */
+  hvendor->RxLength = USBD_LL_GetRxDataSize(pdev, epnum);
+
+  /* The endpoint stays NAKed until the interface calls USBD_VENDOR_ReceivePacket */
+  ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->Receive(hvendor->RxBuffer, &hvendor->RxLength);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_EP0_RxReady
+  *         Handle EP0 Rx Ready event
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if ((pdev->pUserData[pdev->classId] != NULL) && (hvendor->CmdOpCode != 0xFFU))
+  {
+    ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->Control(hvendor->CmdOpCode,
+                                                                        (uint8_t *)hvendor->data,
+                                                                        (uint16_t)hvendor->CmdLength);
+    hvendor->CmdOpCode = 0xFFU;
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_BuildMsOs20
+  *         Build the MS OS 2.0 descriptor set for the vendor interface
+  * @param  pdev: device instance
+  * @param  pbuf: destination, VENDOR_MSOS20_DESC_SIZ bytes
+  * @retval descriptor set length
+  */
+static uint32_t USBD_VENDOR_BuildMsOs20(USBD_HandleTypeDef *pdev, uint8_t *pbuf)
+{
+  static const char name[] = "DeviceInterfaceGUIDs";
+  static const char guid[] = VENDOR_DEVICE_INTERFACE_GUID;
+  uint8_t ifnum = 0U;
+  uint32_t i = 0U;
+  uint32_t k;
+
+  for (uint32_t idx = 0U; idx < pdev->NumClasses; idx++)
+  {
+    if (pdev->tclasslist[idx].ClassType == CLASS_TYPE_VENDOR)
+    {
+      ifnum = pdev->tclasslist[idx].Ifs[0];
+      break;
+    }
+  }
+
+  /* Descriptor set header */
+  pbuf[i++] = 10U;
+  pbuf[i++] = 0U;
+  pbuf[i++] = MS_OS_20_SET_HEADER_DESCRIPTOR;
+  pbuf[i++] = 0U;
+  pbuf[i++] = 0x00U;                          /* dwWindowsVersion: 8.1 */
+  pbuf[i++] = 0x00U;
+  pbuf[i++] = 0x03U;
+  pbuf[i++] = 0x06U;
+  pbuf[i++] = LOBYTE(VENDOR_MSOS20_DESC_SIZ);
+  pbuf[i++] = HIBYTE(VENDOR_MSOS20_DESC_SIZ);
+
+  /* Configuration subset header */
+  pbuf[i++] = 8U;
+  pbuf[i++] = 0U;
+  pbuf[i++] = MS_OS_20_SUBSET_HEADER_CONFIGURATION;
+  pbuf[i++] = 0U;
+  pbuf[i++] = 0U;                             /* configuration index */
+  pbuf[i++] = 0U;
+  pbuf[i++] = LOBYTE(VENDOR_MSOS20_DESC_SIZ - 10U);
+  pbuf[i++] = HIBYTE(VENDOR_MSOS20_DESC_SIZ - 10U);
+
+  /* Function subset header */
+  pbuf[i++] = 8U;
+  pbuf[i++] = 0U;
+  pbuf[i++] = MS_OS_20_SUBSET_HEADER_FUNCTION;
+  pbuf[i++] = 0U;
+  pbuf[i++] = ifnum;                          /* bFirstInterface */
+  pbuf[i++] = 0U;
+  pbuf[i++] = LOBYTE(VENDOR_MSOS20_DESC_SIZ - 18U);
+  pbuf[i++] = HIBYTE(VENDOR_MSOS20_DESC_SIZ - 18U);
+
+  /* Compatible ID: WINUSB */
+  pbuf[i++] = 20U;
+  pbuf[i++] = 0U;
+  pbuf[i++] = MS_OS_20_FEATURE_COMPATIBLE_ID;
+  pbuf[i++] = 0U;
+  (void)USBD_memset(&pbuf[i], 0, 16U);
+  (void)USBD_memcpy(&pbuf[i], "WINUSB", 6U);
+  i += 16U;
+
+  /* Registry property: DeviceInterfaceGUIDs, REG_MULTI_SZ */
+  pbuf[i++] = 132U;
+  pbuf[i++] = 0U;
+  pbuf[i++] = MS_OS_20_FEATURE_REG_PROPERTY;
+  pbuf[i++] = 0U;
+  pbuf[i++] = 0x07U;                          /* REG_MULTI_SZ */
+  pbuf[i++] = 0U;
+  pbuf[i++] = (uint8_t)(2U * sizeof(name));   /* wPropertyNameLength, with NUL */
+  pbuf[i++] = 0U;
+  for (k = 0U; k < sizeof(name); k++)
+  {
+    pbuf[i++] = (uint8_t)name[k];
+    pbuf[i++] = 0U;
+  }
+  pbuf[i++] = (uint8_t)(2U * (sizeof(guid) + 1U)); /* wPropertyDataLength, double NUL */
+  pbuf[i++] = 0U;
+  for (k = 0U; k < sizeof(guid); k++)
+  {
+    pbuf[i++] = (uint8_t)guid[k];
+    pbuf[i++] = 0U;
+  }
+  pbuf[i++] = 0U;
+  pbuf[i++] = 0U;
+
+  return i;
+}
+
+/**
+  * @brief  USBD_VENDOR_GetPlatformCap
+  *         Write the MS OS 2.0 platform capability for the BOS descriptor
+  * @param  pbuf: destination, VENDOR_MSOS20_PLATFORM_CAP_SIZ bytes
+  * @retval number of bytes written
+  */
+uint8_t USBD_VENDOR_GetPlatformCap(uint8_t *pbuf)
+{
+  uint8_t i = 0U;
+
+  pbuf[i++] = VENDOR_MSOS20_PLATFORM_CAP_SIZ;
+  pbuf[i++] = USB_DEVICE_CAPABITY_TYPE;
+  pbuf[i++] = 0x05U;                          /* bDevCapabilityType: platform */
+  pbuf[i++] = 0x00U;
+  (void)USBD_memcpy(&pbuf[i], USBD_VENDOR_MsOs20Uuid, sizeof(USBD_VENDOR_MsOs20Uuid));
+  i += (uint8_t)sizeof(USBD_VENDOR_MsOs20Uuid);
+  pbuf[i++] = 0x00U;                          /* dwWindowsVersion: 8.1 */
+  pbuf[i++] = 0x00U;
+  pbuf[i++] = 0x03U;
+  pbuf[i++] = 0x06U;
+  pbuf[i++] = LOBYTE(VENDOR_MSOS20_DESC_SIZ);
+  pbuf[i++] = HIBYTE(VENDOR_MSOS20_DESC_SIZ);
+  pbuf[i++] = VENDOR_MS_VENDOR_CODE;
+  pbuf[i++] = 0x00U;                          /* bAltEnumCode */
+
+  return i;
+}
+
+/**
+  * @brief  USBD_VENDOR_RegisterInterface
+  * @param  pdev: device instance
+  * @param  fops: Vendor Interface callback
+  * @retval status
+  */
+uint8_t USBD_VENDOR_RegisterInterface(USBD_HandleTypeDef *pdev,
+                                      USBD_VENDOR_ItfTypeDef *fops)
+{
+  if (fops == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  pdev->pUserData[pdev->classId] = fops;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_SetTxBuffer
+  * @param  pdev: device instance
+  * @param  pbuff: Tx Buffer
+  * @param  length: length of data to be sent, any number of packets
+  * @param  ClassId: The Class ID
+  * @retval status
+  */
+uint8_t USBD_VENDOR_SetTxBuffer(USBD_HandleTypeDef *pdev,
+                                uint8_t *pbuff, uint32_t length, uint8_t ClassId)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[ClassId];
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  hvendor->TxBuffer = pbuff;
+  hvendor->TxLength = length;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_SetRxBuffer
+  * @param  pdev: device instance
+  * @param  pbuff: Rx Buffer, one max packet
+  * @retval status
+  */
+uint8_t USBD_VENDOR_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  hvendor->RxBuffer = pbuff;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_TransmitPacket
+  *         Start the IN transfer set by USBD_VENDOR_SetTxBuffer
+  * @param  pdev: device instance
+  * @param  ClassId: The Class ID
+  * @retval status
+  */
+uint8_t USBD_VENDOR_TransmitPacket(USBD_HandleTypeDef *pdev, uint8_t ClassId)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[ClassId];
+  USBD_StatusTypeDef ret = USBD_BUSY;
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  /* Get the Endpoints addresses allocated for this class instance */
+  VENDORInEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_BULK, ClassId);
+
+  if (hvendor->TxState == 0U)
+  {
+    /* Tx Transfer in progress */
+    hvendor->TxState = 1U;
+
+    /* Update the packet total length */
+    pdev->ep_in[VENDORInEpAdd & 0xFU].total_length = hvendor->TxLength;
+
+    /* Transmit all packets of the buffer in one transfer */
+    (void)USBD_LL_Transmit(pdev, VENDORInEpAdd, hvendor->TxBuffer, hvendor->TxLength);
+
+    ret = USBD_OK;
+  }
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_VENDOR_ReceivePacket
+  *         prepare OUT Endpoint for reception
+  * @param  pdev: device instance
+  * @retval status
+  */
+uint8_t USBD_VENDOR_ReceivePacket(USBD_HandleTypeDef *pdev)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  /* Get the Endpoints addresses allocated for this class instance */
+  VENDOROutEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_OUT, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  /* Prepare Out endpoint to receive next packet */
+  (void)USBD_LL_PrepareReceive(pdev, VENDOROutEpAdd, hvendor->RxBuffer,
+                               (pdev->dev_speed == USBD_SPEED_HIGH) ? VENDOR_DATA_HS_MAX_PACKET_SIZE
+                                                                    : VENDOR_DATA_FS_MAX_PACKET_SIZE);
+
+  return (uint8_t)USBD_OK;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
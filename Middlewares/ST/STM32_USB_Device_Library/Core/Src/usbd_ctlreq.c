@@ -104,11 +104,26 @@ static uint8_t USBD_GetLen(uint8_t *buf);
 USBD_StatusTypeDef USBD_StdDevReq(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
 {
   USBD_StatusTypeDef ret = USBD_OK;
+#if defined(USE_USBD_COMPOSITE) && (USBD_CMPSIT_ACTIVATE_VENDOR == 1U)
+  uint32_t idx;
+#endif /* USE_USBD_COMPOSITE && USBD_CMPSIT_ACTIVATE_VENDOR */
 
   switch (req->bmRequest & USB_REQ_TYPE_MASK)
   {
     case USB_REQ_TYPE_CLASS:
     case USB_REQ_TYPE_VENDOR:
+#if defined(USE_USBD_COMPOSITE) && (USBD_CMPSIT_ACTIVATE_VENDOR == 1U)
+      /* Device recipient vendor requests (MS OS 2.0 descriptors) belong to
+         the vendor function, whatever class handled the last event */
+      if ((req->bmRequest & USB_REQ_TYPE_MASK) == USB_REQ_TYPE_VENDOR)
+      {
+        idx = USBD_CMPSIT_GetClassID(pdev, CLASS_TYPE_VENDOR, 0U);
+        if (idx != 0xFFU)
+        {
+          pdev->classId = idx;
+        }
+      }
+#endif /* USE_USBD_COMPOSITE && USBD_CMPSIT_ACTIVATE_VENDOR */
       ret = (USBD_StatusTypeDef)pdev->pClass[pdev->classId]->Setup(pdev, req);
       break;
 
@@ -0,0 +1,388 @@
+/**
+ * @file        app-host.cpp
+ * @brief       Host build of the registration tables of Applications/app-intf.h: applications and shell commands
+ *
+ * @attention   Linux or any C++17 host compiler with GNU ld or lld. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./app-host [-n lookups] [-r seed]
+ *
+ *              app-host.ld gives the host linker the tables of
+ *              STM32H723XG_FLASH.ld. The commands come from three
+ *              modules that know nothing of each other: shell-filters.cpp
+ *              and shell-env.cpp unchanged, and this file, 40 in all as in
+ *              Tools/shell-host; the applications from this file,
+ *              registered out of order.
+ *
+ *              Checks: app_init_all() runs each application once, by
+ *              level; the command table holds every registered command
+ *              once, sorted, the names alongside; a command is found at
+ *              its descriptor, the symbol SHELL_COMMAND() defined, no
+ *              copy; the registered index has its perfect hash, built
+ *              at the first call; words close to a name are not found,
+ *              alike through that hash, the binary search it falls back
+ *              to and the compile time hash of the same commands; an
+ *              engine over the table runs typed commands of every
+ *              module, `help` lists them by name.
+ *
+ *              Then measures ShellIndex::find on the same mix of names
+ *              and unknown words: the registered table through its boot
+ *              time hash and through the binary search, against the
+ *              perfect hash of a ShellTable.
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/21
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/app-intf.h"
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../../Applications/Shell/shell-env.hpp"
+#include "../../Applications/Shell/shell-filters.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t lookups = 4000000;
+    unsigned seed    = 1;
+} opt;
+
+static std::string s_started;   // the applications, in the order they started
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n lookups] [-r seed]\n"
+            "  checks the linker tables and times their lookup against the perfect hash\n",
+            argv0);
+}
+
+static void radio_init(void)
+{
+    s_started += "radio ";
+}
+
+static void queue_init(void)
+{
+    s_started += "queue ";
+}
+
+static void logger_init(void)
+{
+    s_started += "logger ";
+}
+
+APP_REGISTER(30, radio, radio_init);
+APP_REGISTER(10, queue, queue_init);
+APP_REGISTER(20, logger, logger_init);
+
+static const char *cmd_nop(ShellEngine &sh, const ShellArgv &args)
+{
+    (void)sh;
+    (void)args;
+    return nullptr;
+}
+
+static const char *cmd_echo(ShellEngine &sh, std::string_view text)
+{
+    sh.line(text);
+    return nullptr;
+}
+
+static const char *cmd_add(ShellEngine &sh, uint32_t a, uint32_t b)
+{
+    sh.format(FMT("%u"), a + b);
+    return nullptr;
+}
+
+static const char *cmd_help(ShellEngine &sh)
+{
+    const ShellIndex &idx = sh.index_getter();
+    for (uint32_t i = 0; i < idx.count; i++)
+    {
+        sh.line(idx.cmds[i].name);
+    }
+    return nullptr;
+}
+
+SHELL_COMMAND(help, cmd_help, "list the commands");
+SHELL_COMMAND(echo, cmd_echo, "");
+SHELL_COMMAND(add, cmd_add, "");
+SHELL_COMMAND(version, cmd_nop, "");
+SHELL_COMMAND(uptime, cmd_nop, "");
+SHELL_COMMAND(txq, cmd_nop, "");
+SHELL_COMMAND(log, cmd_nop, "");
+SHELL_COMMAND(usb, cmd_nop, "");
+SHELL_COMMAND(storage, cmd_nop, "");
+SHELL_COMMAND(md, cmd_nop, "");
+SHELL_COMMAND(mw, cmd_nop, "");
+SHELL_COMMAND(dump, cmd_nop, "");
+SHELL_COMMAND(top, cmd_nop, "");
+SHELL_COMMAND(gpio, cmd_nop, "");
+SHELL_COMMAND(pin, cmd_nop, "");
+SHELL_COMMAND(adc, cmd_nop, "");
+SHELL_COMMAND(pwm, cmd_nop, "");
+SHELL_COMMAND(reset, cmd_nop, "");
+SHELL_COMMAND(jobs, cmd_nop, "");
+SHELL_COMMAND(kill, cmd_nop, "");
+SHELL_COMMAND(run, cmd_nop, "");
+SHELL_COMMAND(script, cmd_nop, "");
+SHELL_COMMAND(history, cmd_nop, "");
+SHELL_COMMAND(clear, cmd_nop, "");
+SHELL_COMMAND(flash, cmd_nop, "");
+SHELL_COMMAND(erase, cmd_nop, "");
+SHELL_COMMAND(update, cmd_nop, "");
+SHELL_COMMAND(sync, cmd_nop, "");
+SHELL_COMMAND(clock, cmd_nop, "");
+SHELL_COMMAND(temp, cmd_nop, "");
+SHELL_COMMAND(volt, cmd_nop, "");
+SHELL_COMMAND(i2c, cmd_nop, "");
+
+/**
+ * @brief the same 40 commands as one array, the way a single module would list them
+ */
+static constexpr ShellCommand s_same[] = {
+    shell_command<cmd_help>("help", ""),     shell_command<cmd_echo>("echo", ""),
+    shell_command<cmd_add>("add", ""),       {"version", cmd_nop, ""},
+    {"uptime", cmd_nop, ""},                 {"txq", cmd_nop, ""},
+    {"log", cmd_nop, ""},                    {"usb", cmd_nop, ""},
+    {"storage", cmd_nop, ""},                {"md", cmd_nop, ""},
+    {"mw", cmd_nop, ""},                     {"dump", cmd_nop, ""},
+    {"top", cmd_nop, ""},                    {"gpio", cmd_nop, ""},
+    {"pin", cmd_nop, ""},                    {"adc", cmd_nop, ""},
+    {"pwm", cmd_nop, ""},                    {"reset", cmd_nop, ""},
+    {"jobs", cmd_nop, ""},                   {"kill", cmd_nop, ""},
+    {"run", cmd_nop, ""},                    {"script", cmd_nop, ""},
+    {"history", cmd_nop, ""},                {"clear", cmd_nop, ""},
+    {"flash", cmd_nop, ""},                  {"erase", cmd_nop, ""},
+    {"update", cmd_nop, ""},                 {"sync", cmd_nop, ""},
+    {"clock", cmd_nop, ""},                  {"temp", cmd_nop, ""},
+    {"volt", cmd_nop, ""},                   {"i2c", cmd_nop, ""},
+    shell_command<shell_seq>("seq", ""),     shell_command<shell_grep>("grep", ""),
+    shell_command<shell_head>("head", ""),   shell_command<shell_count>("count", ""),
+    shell_command<shell_hexdump>("hexdump", ""), shell_command<shell_crc>("crc", ""),
+    shell_command<shell_set>("set", ""),     shell_command<shell_unset>("unset", ""),
+};
+
+static constexpr ShellTable s_table(s_same);
+static_assert(s_table.valid(), "duplicate command name, or no perfect hash within SHELL_SEED_TRIES");
+
+static constexpr ShellIndex s_hashed = s_table.index();
+
+/**
+ * @brief keeps the replies
+ */
+class CaptureOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        text.append(buf, len);
+    }
+
+    std::string text;
+};
+
+static void expect(const ShellIndex &index, const char *in, const char *out)
+{
+    CaptureOutput cap;
+    ShellEngine sh(index, cap);
+    sh.feed(reinterpret_cast<const uint8_t *>(in), static_cast<uint32_t>(strlen(in)));
+    if (cap.text != out)
+    {
+        fail("\"%s\" gave \"%s\", not \"%s\"", in, cap.text.c_str(), out);
+    }
+}
+
+static void check_apps()
+{
+    const auto apps = APP_TABLE(apps);
+    if (apps.count() != 3U)
+    {
+        fail("%u applications registered, not 3", apps.count());
+    }
+    app_init_all();
+    if (s_started != "queue logger radio ")
+    {
+        fail("applications started as \"%s\"", s_started.c_str());
+    }
+    const AppDesc *volatile first = apps.begin(); // the compiler takes two symbols for two objects
+    if (first != &apps_10_queue or strcmp(first->name, "queue") != 0)
+    {
+        fail("the first application is not the descriptor of level 10");
+    }
+}
+
+extern const ShellCommand shell_cmds_grep;  // SHELL_COMMAND() of shell-filters.cpp
+extern const ShellCommand shell_cmds_unset; // and of shell-env.cpp
+
+static void check_table(const ShellIndex &index, const ShellIndex &sorted, std::vector<std::string> &unknown)
+{
+    constexpr uint32_t count = sizeof(s_same) / sizeof(s_same[0]);
+    if (index.count != count or index.names.count != count)
+    {
+        fail("%u commands and %u names registered, not %u", index.count, index.names.count, count);
+        return;
+    }
+    if (index.slot == nullptr or index.mask + 1U != shell_slots(count) or index.seed == 0U)
+    {
+        fail("no hash of the registered commands");
+        return;
+    }
+    if (shell_registered_index().slot != index.slot)
+    {
+        fail("a second call hashed the commands again");
+    }
+    for (uint32_t i = 0; i < index.count; i++)
+    {
+        if (index.names.list[i] != index.cmds[i].name)
+        {
+            fail("name %u is not the one of command %u", i, i);
+        }
+        if (i != 0U and not shell_word_less(index.names.list[i - 1U], index.names.list[i]))
+        {
+            fail("names %u and %u not sorted", i - 1U, i);
+        }
+    }
+    if (index.find("echo") != &shell_cmds_echo or index.find("grep") != &shell_cmds_grep or
+        index.find("unset") != &shell_cmds_unset)
+    {
+        fail("a command is not found at its descriptor");
+    }
+
+    // names and their neighbours, found alike by the three indexes
+    for (const ShellCommand &cmd : s_same)
+    {
+        const std::string name(cmd.name);
+        const ShellCommand *hit = index.find(name);
+        if (hit == nullptr or hit->name != cmd.name or sorted.find(name) != hit or s_hashed.find(name) != &cmd)
+        {
+            fail("%s not found at its entry", name.c_str());
+        }
+        unknown.push_back(name + "x");
+        unknown.push_back(name.substr(0, name.size() - 1U));
+        unknown.push_back(std::string(1, static_cast<char>(name[0] - 32)) + name.substr(1));
+        std::string changed = name;
+        changed.back()      = changed.back() == 'z' ? 'a' : static_cast<char>(changed.back() + 1);
+        unknown.push_back(changed);
+    }
+    unknown.push_back("");
+    unknown.push_back("zzzz");
+    for (const std::string &w : unknown)
+    {
+        const ShellCommand *a = index.find(w);
+        const ShellCommand *b = s_hashed.find(w);
+        if ((a == nullptr) != (b == nullptr) or (a != nullptr and a->name != w) or sorted.find(w) != a)
+        {
+            fail("\"%s\" found differently by the three indexes", w.c_str());
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.lookups = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.lookups == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    check_apps();
+
+    const ShellIndex index = shell_registered_index();
+    ShellIndex sorted      = index;
+    sorted.slot            = nullptr; // the fallback without a seed
+    std::vector<std::string> unknown;
+    check_table(index, sorted, unknown);
+    printf("%u commands registered by 3 modules, %zu bytes of descriptors and names in place, %u bytes of slots\n",
+           index.count, static_cast<size_t>(index.count) * (sizeof(ShellCommand) + sizeof(std::string_view)),
+           shell_slots(SHELL_REGISTERED_MAX));
+
+    // commands of every module through one engine
+    expect(index, "!1 add 2 3\n", "!1:5\r\n!1=ok\r\n");
+    expect(index, "!2 seq 2\n", "!2:1\r\n!2:2\r\n!2=ok\r\n");
+    expect(index, "!3 unset x\n", "!3=err no variables here\r\n");
+    expect(index, "!4 echo hi\n", "!4:hi\r\n!4=ok\r\n");
+    expect(index, "!5 nosuch\n", "!5=err unknown command\r\n");
+    {
+        CaptureOutput cap;
+        ShellEngine sh(index, cap);
+        const char line[] = "help\n";
+        sh.feed(reinterpret_cast<const uint8_t *>(line), sizeof(line) - 1U);
+        if (cap.text.compare(0, 10, "adc\r\nadd\r\n") != 0)
+        {
+            fail("help does not list by name: \"%.20s\"", cap.text.c_str());
+        }
+    }
+
+    // the same word mix for both: mostly names, one in 8 unknown
+    std::mt19937 rng(opt.seed);
+    std::vector<std::string> words;
+    for (uint32_t i = 0; i < 4096U; i++)
+    {
+        words.push_back(rng() % 8U == 0U ? unknown[rng() % unknown.size()]
+                                         : std::string(s_same[rng() % index.count].name));
+    }
+
+    uintptr_t hits = 0;
+    auto t0        = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lookups; i++)
+    {
+        hits += index.find(words[i & 4095U]) != nullptr ? 2U : 0U;
+    }
+    const double registeredNs = ns_since(t0, opt.lookups);
+
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lookups; i++)
+    {
+        hits -= sorted.find(words[i & 4095U]) != nullptr ? 1U : 0U;
+    }
+    const double sortedNs = ns_since(t0, opt.lookups);
+
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lookups; i++)
+    {
+        hits -= s_hashed.find(words[i & 4095U]) != nullptr ? 1U : 0U;
+    }
+    const double hashNs = ns_since(t0, opt.lookups);
+    if (hits != 0U)
+    {
+        fail("the indexes disagree on %zu words", static_cast<size_t>(hits));
+    }
+
+    printf("registered  %7.1f ns/lookup  perfect hash of the linker's table, built at the first call\n", registeredNs);
+    printf("sorted      %7.1f ns/lookup  binary search of the same, the fallback (%.1fx)\n", sortedNs,
+           sortedNs / registeredNs);
+    printf("hash        %7.1f ns/lookup  perfect hash of one array by the compiler, %u slots\n", hashNs,
+           s_hashed.mask + 1U);
+
+    return check_summary();
+}
@@ -0,0 +1,483 @@
+/**
+ * @file        format-bench.cpp
+ * @brief       Host checks of the compile-time checked formatter against snprintf(), and its speed
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./format-bench [-n lines] [-s seed]
+ *
+ *              Builds Applications/Format/format.cpp unchanged.
+ *
+ *              Checks, each against glibc's snprintf() of the same string:
+ *              integers of every width and sign through every flag, width
+ *              and precision, the 64-bit limits; %f %e %g of values from
+ *              1e-300 to 1e300 and of the awkward ones (0, -0, the roundings
+ *              that carry, inf, nan); %s of pointers, arrays and string
+ *              views with precision and width; %c, %%; a cut at the end of
+ *              the buffer. A double whose output differs is accepted only
+ *              when a double within 16 ulps prints that way (a tie, see
+ *              format.cpp), and counted.
+ *
+ *              The format strings the compiler refuses: build with
+ *              -DFORMAT_BENCH_REFUSE=1 (too few arguments), 2 (%s of an int),
+ *              3 (%d of a string) or 4 (a conversion that does not parse).
+ *
+ *              Then measures nanoseconds per line, ours and snprintf(), for
+ *              lines like the ones of the shell, the log and the telemetry.
+ *              The target's newlib-nano printf adds its reentrancy lock and
+ *              its va_list walk to what glibc costs here.
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/18
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Format/format.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+/**
+ * @brief ours and snprintf() of the same literal and arguments
+ */
+#define EXPECT(f, ...) expect(__LINE__, f, FMT(f), __VA_ARGS__)
+#define EXPECT0(f)     expect(__LINE__, f, FMT(f))
+
+/**
+ * @brief the same, a double accepted within 16 ulps
+ */
+#define EXPECT_F(f, v) expect_double(__LINE__, f, FMT(f), v)
+
+enum class Mood
+{
+    CALM = 3,
+    ANGRY = -2,
+};
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t lines = 2000000;
+    uint32_t seed  = 1;
+} opt;
+
+static uint32_t s_checks = 0;
+static uint32_t s_ties   = 0;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n lines] [-s seed]\n"
+            "  checks the formatter against snprintf and times both\n",
+            argv0);
+}
+
+template <typename F, typename... A> static void expect(int line, const char *f, F fmt, A... a)
+{
+    char ours[256];
+    char libc[256];
+    const uint32_t n = format_to(ours, sizeof(ours), fmt, a...);
+    snprintf(libc, sizeof(libc), f, a...);
+    s_checks++;
+    if (strcmp(ours, libc) != 0 or n != strlen(libc))
+    {
+        fail("line %d \"%s\": \"%s\", not \"%s\"", line, f, ours, libc);
+    }
+}
+
+template <typename F> static void expect_double(int line, const char *f, F fmt, double v)
+{
+    char ours[256];
+    char libc[256];
+    format_to(ours, sizeof(ours), fmt, v);
+    snprintf(libc, sizeof(libc), f, v);
+    s_checks++;
+    if (strcmp(ours, libc) == 0)
+    {
+        return;
+    }
+    double lo = v;
+    double hi = v;
+    for (int i = 0; i < 16; i++)
+    {
+        lo = std::nextafter(lo, -INFINITY);
+        hi = std::nextafter(hi, INFINITY);
+        char near[256];
+        snprintf(near, sizeof(near), f, lo);
+        const bool low = strcmp(ours, near) == 0;
+        snprintf(near, sizeof(near), f, hi);
+        if (low or strcmp(ours, near) == 0)
+        {
+            s_ties++;
+            return;
+        }
+    }
+    fail("line %d \"%s\" of %.17g: \"%s\", not \"%s\"", line, f, v, ours, libc);
+}
+
+/**
+ * @brief every integer conversion of one value
+ */
+template <typename T> static void expect_ints(T v)
+{
+    using S = long long;
+    using U = unsigned long long;
+    const S s = static_cast<S>(v);
+    EXPECT("%lld|%5lld|%-5lld|%05lld|%+lld|% lld|%.3lld|%+08lld|%-+6lld|%.0lld", s, s, s, s, s, s, s, s, s, s);
+    if constexpr (std::is_unsigned_v<T>)
+    {
+        const U u = static_cast<U>(v);
+        EXPECT("%llu|%12llu|%-12llu|%012llu|%.15llu", u, u, u, u, u);
+    }
+    const U bits = static_cast<U>(static_cast<std::make_unsigned_t<T>>(v));
+    char ours[128];
+    char libc[128];
+    format_to(ours, sizeof(ours), FMT("%x|%X|%08x|%#x|%#010x|%-9x|%.4x|%o|%#o|%12o|%#.0o"), v, v, v, v, v, v, v, v, v,
+              v, v);
+    snprintf(libc, sizeof(libc), "%llx|%llX|%08llx|%#llx|%#010llx|%-9llx|%.4llx|%llo|%#llo|%12llo|%#.0llo", bits,
+             bits, bits, bits, bits, bits, bits, bits, bits, bits, bits);
+    s_checks++;
+    if (strcmp(ours, libc) != 0)
+    {
+        fail("bits of %lld: \"%s\", not \"%s\"", s, ours, libc);
+    }
+}
+
+/**
+ * @brief the %e and %g conversions of one value
+ */
+static void expect_sci(double v)
+{
+    EXPECT_F("%e", v);
+    EXPECT_F("%g", v);
+    EXPECT_F("%.0e", v);
+    EXPECT_F("%.3e", v);
+    EXPECT_F("%.9E", v);
+    EXPECT_F("%14.2e", v);
+    EXPECT_F("%.1g", v);
+    EXPECT_F("%.3g", v);
+    EXPECT_F("%.9g", v);
+    EXPECT_F("%#g", v);
+    EXPECT_F("%G", v);
+    EXPECT_F("%-10g|", v);
+}
+
+/**
+ * @brief every floating conversion of one value, below 1.8e19 for %f
+ */
+static void expect_doubles(double v)
+{
+    expect_sci(v);
+    EXPECT_F("%f", v);
+    EXPECT_F("%.0f", v);
+    EXPECT_F("%.1f", v);
+    EXPECT_F("%.3f", v);
+    EXPECT_F("%.9f", v);
+    EXPECT_F("%12.4f", v);
+    EXPECT_F("%-12.2f|", v);
+    EXPECT_F("%+.2f", v);
+    EXPECT_F("% .5f", v);
+    EXPECT_F("%012.3f", v);
+    EXPECT_F("%#.0f", v);
+}
+
+
+/**
+ * @brief time one way of printing line i, ns per line; sum keeps the output alive
+ */
+template <typename F> static double time_lines(F print, uint64_t &sum)
+{
+    char buf[160];
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lines; i++)
+    {
+        const uint32_t n = print(buf, sizeof(buf), i);
+        sum += n + static_cast<uint8_t>(buf[n / 2U]);
+    }
+    return ns_since(t0, opt.lines);
+}
+
+static void report(const char *what, double ours, double libc)
+{
+    printf("%-10s %7.1f ns/line   snprintf %7.1f ns/line  (%.1fx)\n", what, ours, libc, libc / ours);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:s:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.lines = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 's': opt.seed = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.lines == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+#if FORMAT_BENCH_REFUSE == 1
+    char refused[8];
+    format_to(refused, sizeof(refused), FMT("%d and %d"), 1);
+#elif FORMAT_BENCH_REFUSE == 2
+    char refused[8];
+    format_to(refused, sizeof(refused), FMT("%s"), 42);
+#elif FORMAT_BENCH_REFUSE == 3
+    char refused[8];
+    format_to(refused, sizeof(refused), FMT("%d"), "42");
+#elif FORMAT_BENCH_REFUSE == 4
+    char refused[8];
+    format_to(refused, sizeof(refused), FMT("%5"), 42);
+#endif
+
+    // literals
+    EXPECT0("");
+    EXPECT0("plain text");
+    EXPECT0("100%% sure, %%d");
+
+    // integers
+    const long long edges[] = {0, 1, -1, 7, 9, 10, 99, 100, -100, 12345, -98765, 999999999, 1000000000,
+                               4294967295LL, 4294967296LL, 999999999999999999LL, LLONG_MAX, LLONG_MIN};
+    for (long long v : edges)
+    {
+        expect_ints(v);
+        expect_ints(static_cast<int32_t>(v));
+        expect_ints(static_cast<uint32_t>(v));
+        expect_ints(static_cast<uint64_t>(v));
+        expect_ints(static_cast<int16_t>(v));
+        expect_ints(static_cast<int8_t>(v));
+        expect_ints(static_cast<uint8_t>(v));
+    }
+    std::mt19937_64 rng(opt.seed);
+    for (uint32_t i = 0; i < 20000U; i++)
+    {
+        const uint64_t r = rng() >> (rng() % 64U);
+        expect_ints(static_cast<int64_t>(r));
+        expect_ints(static_cast<uint64_t>(r));
+        expect_ints(static_cast<int32_t>(r));
+        expect_ints(static_cast<uint32_t>(r));
+    }
+    EXPECT("%d %u", true, false);
+    {
+        char ours[32];
+        format_to(ours, sizeof(ours), FMT("%d %d %x"), Mood::CALM, Mood::ANGRY, Mood::ANGRY);
+        s_checks++;
+        if (strcmp(ours, "3 -2 fffffffe") != 0)
+        {
+            fail("enums: \"%s\"", ours);
+        }
+    }
+
+    // text
+    const char *null = nullptr;
+    const char name[8] = "sensor";
+    EXPECT("%s|%8s|%-8s|%.3s|%8.2s|%-4.1s|", "abc", "abc", "abc", "abcdef", "abcdef", "xyz");
+    EXPECT("[%s] [%10s] [%-10s]", name, name, name);
+    EXPECT("%c%c%5c%-3c|", 'o', 'k', '!', '?');
+    {
+        char ours[64];
+        const char full[4] = {'a', 'b', 'c', 'd'}; // no '\0': the array bounds it
+        format_to(ours, sizeof(ours), FMT("%s|%6s|%.2s|%s|%s"), std::string_view("view"), std::string_view("vi"),
+                  std::string_view("view"), full, null);
+        s_checks++;
+        if (strcmp(ours, "view|    vi|vi|abcd|(null)") != 0)
+        {
+            fail("views, arrays, null: \"%s\"", ours);
+        }
+        const void *p = reinterpret_cast<const void *>(0x2400abcdU);
+        format_to(ours, sizeof(ours), FMT("%p %p"), p, name);
+        char want[64];
+        snprintf(want, sizeof(want), "%#.8lx %#.8lx", 0x2400abcdUL, static_cast<unsigned long>(reinterpret_cast<uintptr_t>(name)));
+        s_checks++;
+        if (strcmp(ours, want) != 0)
+        {
+            fail("pointers: \"%s\", not \"%s\"", ours, want);
+        }
+    }
+
+    // floating point
+    const double awkward[] = {0.0, -0.0, 1.0, -1.0, 0.5, 0.05, 0.95, 9.5, 9.9999996, 99.99999, 999999.4, 9999995.0, 0.0001,
+                              0.00009999999, 123456.789, 1e-5, 1e15, 1e16, 1.8e19, 1e19, 4.9e-324, 2.2250738585072014e-308,
+                              1.7976931348623157e308, 3.14159265358979, 2.718281828459045, 1e100, 1e-100,
+                              static_cast<double>(INFINITY), -static_cast<double>(INFINITY), static_cast<double>(NAN)};
+    for (double v : awkward)
+    {
+        if (std::fabs(v) < 1.8e19)
+        {
+            expect_doubles(v);
+        }
+        else
+        {
+            expect_sci(v);
+        }
+    }
+    {
+        char ours[64];
+        format_to(ours, sizeof(ours), FMT("%f %.2F"), 1e100, -2e19);
+        s_checks++;
+        if (strcmp(ours, "1.000000e+100 -2.00E+19") != 0)
+        {
+            fail("%%f beyond 64 bits: \"%s\"", ours);
+        }
+        format_to(ours, sizeof(ours), FMT("%#g"), 999999.5); // glibc: "1.e+06", C: precision P - 1
+        s_checks++;
+        if (strcmp(ours, "1.00000e+06") != 0)
+        {
+            fail("%%#g carried to the next decade: \"%s\"", ours);
+        }
+    }
+    std::uniform_real_distribution<double> mant(1.0, 10.0);
+    for (uint32_t i = 0; i < 20000U; i++)
+    {
+        const int e = static_cast<int>(rng() % 601U) - 300;
+        const double v = mant(rng) * std::pow(10.0, e) * ((rng() & 1U) != 0U ? -1.0 : 1.0);
+        if (std::fabs(v) < 1.8e19)
+        {
+            expect_doubles(v);
+        }
+        else
+        {
+            expect_sci(v);
+        }
+    }
+    for (uint32_t i = 0; i < 20000U; i++)
+    {
+        const double v = static_cast<double>(static_cast<int32_t>(rng() % 2000001U) - 1000000) / 1000.0; // millivolts
+        expect_doubles(v);
+    }
+    {
+        char ours[64];
+        format_to(ours, sizeof(ours), FMT("%.3f %f %g %.1e"), 1.5F, 25, -3, 1000000000000ULL);
+        s_checks++;
+        if (strcmp(ours, "1.500 25.000000 -3 1.0e+12") != 0)
+        {
+            fail("floats and integers as doubles: \"%s\"", ours);
+        }
+    }
+
+    // cuts
+    {
+        char small[8];
+        const uint32_t n = format_to(small, sizeof(small), FMT("%s %u"), "hello", 12345U);
+        s_checks++;
+        if (n != 7U or strcmp(small, "hello 1") != 0)
+        {
+            fail("cut: %u \"%s\"", n, small);
+        }
+        char one[1] = {'x'};
+        s_checks++;
+        if (format_to(one, 1U, FMT("%d"), 5) != 0U or one[0] != '\0')
+        {
+            fail("cut to nothing");
+        }
+        char wide[4];
+        FormatOut out(wide, sizeof(wide));
+        format_to(out, FMT("%10.3f"), 1.0);
+        format_to(out, FMT("%s"), "more");
+        s_checks++;
+        if (out.len() != 4U or memcmp(wide, "    ", 4) != 0)
+        {
+            fail("cut of a padded double");
+        }
+    }
+
+    // the run-time parser, the logger's
+    {
+        const char text[] = "%-08.3lx";
+        const char *p     = &text[1];
+        FormatSpec sp;
+        s_checks++;
+        if (not format_parse(p, &text[sizeof(text) - 1U], sp) or *p != '\0' or not sp.left or not sp.zero or
+            sp.width != 8 or sp.prec != 3 or sp.conv != 'x')
+        {
+            fail("format_parse of %s", text);
+        }
+        const char bad[] = "%5q";
+        p                = &bad[1];
+        FormatSpec sq;
+        s_checks++;
+        if (format_parse(p, &bad[sizeof(bad) - 1U], sq) or sq.conv != 'q' or *p != '\0')
+        {
+            fail("format_parse of %s", bad);
+        }
+    }
+
+    printf("%u checks, %u doubles within 16 ulps of snprintf's\n", s_checks, s_ties);
+
+    // speed
+    std::vector<uint32_t> u32(4096);
+    std::vector<double> volts(4096);
+    std::vector<const char *> names(4096);
+    static const char *const task_names[] = {"IDLE", "shellCdc", "logDrain", "storage", "Tmr Svc", "defaultTask"};
+    for (uint32_t i = 0; i < 4096U; i++)
+    {
+        u32[i]   = static_cast<uint32_t>(rng() >> (rng() % 32U));
+        volts[i] = static_cast<double>(static_cast<int32_t>(rng() % 66001U) - 33000) / 10000.0;
+        names[i] = task_names[i % 6U];
+    }
+
+    uint64_t ours = 0;
+    uint64_t libc = 0;
+#define TIME(what, f, ...)                                                                                             \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        const double a = time_lines(                                                                                   \
+            [&](char *buf, uint32_t size, uint32_t i) {                                                                \
+                const uint32_t k = i & 4095U;                                                                          \
+                (void)k;                                                                                               \
+                return format_to(buf, size, FMT(f), __VA_ARGS__);                                                      \
+            },                                                                                                         \
+            ours);                                                                                                     \
+        const double b = time_lines(                                                                                   \
+            [&](char *buf, uint32_t size, uint32_t i) {                                                                \
+                const uint32_t k = i & 4095U;                                                                          \
+                (void)k;                                                                                               \
+                return static_cast<uint32_t>(snprintf(buf, size, f, __VA_ARGS__));                                     \
+            },                                                                                                         \
+            libc);                                                                                                     \
+        report(what, a, b);                                                                                            \
+    } while (0)
+
+    TIME("count", "%u", u32[k]);
+    TIME("offset", "%08x  ", u32[k]);
+    TIME("crc", "%08x %u", u32[k], u32[k ^ 1U]);
+    TIME("top row", "%-11s %10u %3u.%02u%% %6u", names[k], u32[k], u32[k] % 100U, u32[k ^ 1U] % 100U, u32[k ^ 2U]);
+    TIME("log head", "[%5u.%03u] I adc %d mV", i / 1000U, i % 1000U, static_cast<int32_t>(u32[k]));
+    TIME("volts", "%.3f V", volts[k]);
+    TIME("sci", "%e", volts[k] * 1e-6);
+#undef TIME
+
+    printf("(%llu %llu)\n", static_cast<unsigned long long>(ours & 0xFFU), static_cast<unsigned long long>(libc & 0xFFU));
+
+    return check_summary();
+}
@@ -0,0 +1,745 @@
+/**
+ * @file        fwu-host.cpp
+ * @brief       Host side of the firmware update over the data CDC port, with a device stand-in
+ *
+ * @attention   Linux or any POSIX C++17 host. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./fwu-host [-w window] firmware.bin /dev/ttyACM1
+ *                  ./fwu-host -e [-s kb] [-l latency_us] [-p word_us] [-c per_million]
+ *
+ *              firmware.bin is the raw image without the boot stub of
+ *              sector 0 (objcopy -O binary -R .boot), at most 384 KB. The
+ *              device answers DONE once the staged copy checks, marks it
+ *              pending and resets; the boot stub copies it over the firmware.
+ *
+ *              -e runs the protocol against a stand-in of the device: the
+ *              real FwuReceiver on top of FlashSimImpl with the geometry of
+ *              the H723 bank (128 KB sectors, 32-byte flash words) and one
+ *              word program every `word_us`. The link is a pair of queues
+ *              with `latency_us` each way and a 2 KB bound toward the device,
+ *              the size of its CDC receive ring. The runs are:
+ *
+ *                  window-1     one frame per round trip
+ *                  window-N     FWU_WINDOW frames in flight, must run close
+ *                               to the speed of the flash
+ *                  corrupt      bytes toward the device flipped at random,
+ *                               NAK and resend must still give the image
+ *                  too-big      image larger than the slot, FAIL expected
+ *                  bad-crc      wrong CRC announced, FAIL expected
+ *
+ *              The exit status is non zero on any failed check, so the same
+ *              binary works as a CI check.
+ *
+ *              The protocol is described in Applications/Update/fwu-proto.hpp.
+ *
+ * @author      MekLi
+ * @date        2025/9/7
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Update/fwu-receiver.hpp"
+#include "../../Drivers/Peripheral/Flash/flash-sim-impl.hpp"
+#include "../host-test.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+/* keep in sync with Applications/Update/update-intf.h and usbd_cdc_if.h */
+#define SLOT_BASE           0x00080000U
+#define SLOT_SIZE           0x00060000U
+#define BANK_SIZE           0x00100000U
+#define SECTOR_SIZE         0x00020000U
+#define WORD_SIZE           32U
+#define DEVICE_RX_RING      2048U
+#define DEVICE_IDLE_MS      2000U
+
+#define READY_TIMEOUT_MS    30000   // the device erases the slot first
+#define ACK_TIMEOUT_MS      1000    // then go back to the last ACK
+#define PACKET              512U    // USB high speed bulk packet
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+using Clock = std::chrono::steady_clock;
+
+static struct
+{
+    uint32_t window    = FWU_WINDOW;
+    bool emulate       = false;
+    uint32_t kb        = 256;
+    uint32_t latencyUs = 500;
+    uint32_t wordUs    = 16;
+    uint32_t corrupt   = 200;   // bytes flipped per million in the corrupt run
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-w window] firmware.bin /dev/ttyACMx\n"
+            "       %s -e [-s kb] [-l latency_us] [-p word_us] [-c per_million]\n"
+            "  -w  frames in flight (default %u)\n"
+            "  -e  self test against a device stand-in\n"
+            "  -s  image size of the self test (default %u KB)\n"
+            "  -l  one way latency of the emulated link (default %u us)\n"
+            "  -p  program time of one 32-byte flash word (default %u us)\n"
+            "  -c  corrupted bytes per million in the corrupt run (default %u)\n",
+            argv0, argv0, opt.window, opt.kb, opt.latencyUs, opt.wordUs, opt.corrupt);
+}
+
+static double seconds_since(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+
+/**
+ * @brief byte link to the device
+ */
+class Link
+{
+  public:
+    virtual ~Link() = default;
+    virtual bool write(const void *buf, size_t len) = 0;
+
+    /**
+     * @return bytes read, 0 on timeout, -1 on error
+     */
+    virtual long read(uint8_t *buf, size_t len, int timeoutMs) = 0;
+};
+
+
+/**
+ * @brief the CDC ACM tty of the board
+ */
+class TtyLink final : public Link
+{
+  public:
+    explicit TtyLink(const char *path)
+    {
+        _fd = open(path, O_RDWR | O_NOCTTY);
+        struct termios tio;
+        if (_fd >= 0 and tcgetattr(_fd, &tio) == 0)
+        {
+            cfmakeraw(&tio);
+            tio.c_cc[VMIN]  = 0;
+            tio.c_cc[VTIME] = 0;
+            if (tcsetattr(_fd, TCSANOW, &tio) == 0)
+            {
+                (void)tcflush(_fd, TCIOFLUSH);
+                return;
+            }
+        }
+        perror(path);
+        if (_fd >= 0)
+        {
+            close(_fd);
+        }
+        _fd = -1;
+    }
+
+    ~TtyLink() override
+    {
+        if (_fd >= 0)
+        {
+            close(_fd);
+        }
+    }
+
+    bool ok() const
+    {
+        return _fd >= 0;
+    }
+
+    bool write(const void *buf, size_t len) override
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(buf);
+        while (len != 0U)
+        {
+            const ssize_t n = ::write(_fd, p, len);
+            if (n < 0)
+            {
+                perror("write");
+                return false;
+            }
+            p += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    long read(uint8_t *buf, size_t len, int timeoutMs) override
+    {
+        struct pollfd pfd = {_fd, POLLIN, 0};
+        const int r       = poll(&pfd, 1, timeoutMs);
+        if (r <= 0)
+        {
+            return r;
+        }
+        return static_cast<long>(::read(_fd, buf, len));
+    }
+
+  private:
+    int _fd = -1;
+};
+
+
+/**
+ * @brief one direction of the emulated USB link: in order, delayed, bounded
+ */
+class Wire
+{
+  public:
+    Wire(uint32_t latencyUs, size_t cap) : _latency(std::chrono::microseconds(latencyUs)), _cap(cap)
+    {
+    }
+
+    /**
+     * @brief flip `perMillion` of the bytes pushed from now on
+     */
+    void corrupt(uint32_t perMillion, unsigned seed)
+    {
+        _perMillion = perMillion;
+        _rng.seed(seed);
+    }
+
+    void push(const uint8_t *p, size_t len)
+    {
+        while (len != 0U)
+        {
+            const size_t n = len < PACKET ? len : PACKET;
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [&] { return _queued + n <= _cap; }); // the device NAKs the OUT token
+            Packet pk{Clock::now() + _latency, std::vector<uint8_t>(p, p + n), 0};
+            for (auto &b : pk.data)
+            {
+                if (_perMillion != 0U and _rng() % 1000000U < _perMillion)
+                {
+                    b ^= static_cast<uint8_t>(1U << (_rng() % 8U));
+                    _flipped++;
+                }
+            }
+            _queue.push_back(std::move(pk));
+            _queued += n;
+            _cv.notify_all();
+            p += n;
+            len -= n;
+        }
+    }
+
+    size_t pop(uint8_t *buf, size_t len, int timeoutMs)
+    {
+        const auto limit = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;)
+        {
+            if (not _queue.empty() and _queue.front().due <= Clock::now())
+            {
+                break;
+            }
+            if (Clock::now() >= limit)
+            {
+                return 0;
+            }
+            if (_queue.empty())
+            {
+                _cv.wait_until(lock, limit);
+            }
+            else
+            {
+                _cv.wait_until(lock, std::min(limit, _queue.front().due));
+            }
+        }
+
+        size_t got = 0;
+        while (got < len and not _queue.empty() and _queue.front().due <= Clock::now())
+        {
+            Packet &pk     = _queue.front();
+            const size_t n = std::min(len - got, pk.data.size() - pk.pos);
+            memcpy(buf + got, &pk.data[pk.pos], n);
+            pk.pos += n;
+            got += n;
+            _queued -= n;
+            if (pk.pos == pk.data.size())
+            {
+                _queue.pop_front();
+            }
+        }
+        _cv.notify_all();
+        return got;
+    }
+
+    uint32_t flipped() const
+    {
+        return _flipped;
+    }
+
+  private:
+    struct Packet
+    {
+        Clock::time_point due;
+        std::vector<uint8_t> data;
+        size_t pos;
+    };
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<Packet> _queue;
+    Clock::duration _latency;
+    size_t _cap;
+    size_t _queued       = 0;
+    uint32_t _perMillion = 0;
+    uint32_t _flipped    = 0;
+    std::mt19937 _rng;
+};
+
+
+/**
+ * @brief host end of a pair of wires
+ */
+class WireLink final : public Link
+{
+  public:
+    WireLink(Wire &toDevice, Wire &fromDevice) : _out(toDevice), _in(fromDevice)
+    {
+    }
+
+    bool write(const void *buf, size_t len) override
+    {
+        _out.push(static_cast<const uint8_t *>(buf), len);
+        return true;
+    }
+
+    long read(uint8_t *buf, size_t len, int timeoutMs) override
+    {
+        return static_cast<long>(_in.pop(buf, len, timeoutMs));
+    }
+
+  private:
+    Wire &_out;
+    Wire &_in;
+};
+
+
+/**
+ * @brief replies out of the byte stream, text before them is skipped
+ */
+class ReplyReader
+{
+  public:
+    explicit ReplyReader(Link &link) : _link(link)
+    {
+    }
+
+    /**
+     * @return 1 with a reply, 0 on timeout, -1 on error
+     */
+    int next(FwuReply &r, int timeoutMs)
+    {
+        const auto limit = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;)
+        {
+            while (_buf.size() >= sizeof(FwuReply))
+            {
+                uint32_t magic;
+                memcpy(&magic, _buf.data(), sizeof(magic));
+                if (magic == FWU_REPLY_MAGIC)
+                {
+                    memcpy(&r, _buf.data(), sizeof(r));
+                    _buf.erase(_buf.begin(), _buf.begin() + sizeof(r));
+                    return 1;
+                }
+                _text.push_back(static_cast<char>(_buf.front()));
+                _buf.erase(_buf.begin());
+            }
+
+            const int left = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(limit - Clock::now()).count());
+            if (left <= 0)
+            {
+                return 0;
+            }
+            uint8_t tmp[256];
+            const long n = _link.read(tmp, sizeof(tmp), left);
+            if (n < 0)
+            {
+                return -1;
+            }
+            _buf.insert(_buf.end(), tmp, tmp + n);
+        }
+    }
+
+    /**
+     * @brief what the device printed instead of a reply, "err unknown command"
+     */
+    const std::string &text() const
+    {
+        return _text;
+    }
+
+  private:
+    Link &_link;
+    std::vector<uint8_t> _buf;
+    std::string _text;
+};
+
+
+/**
+ * @brief outcome of one transfer
+ */
+struct Result
+{
+    bool done;
+    FwuReply last;      // DONE or FAIL, or the last reply seen
+    double sec;         // from READY to DONE
+    uint32_t frames;    // sent, resends included
+    uint32_t naks;
+    uint32_t timeouts;
+};
+
+
+/**
+ * @brief stream an image with up to `window` frames in flight (go-back-N)
+ */
+static Result send_image(Link &link, const std::vector<uint8_t> &img, uint32_t crc, uint32_t window)
+{
+    Result res = {};
+    ReplyReader rr(link);
+    const uint32_t size = static_cast<uint32_t>(img.size());
+
+    char cmd[64];
+    const int len = snprintf(cmd, sizeof(cmd), "update %u 0x%08x\n", size, crc);
+    if (not link.write(cmd, static_cast<size_t>(len)))
+    {
+        return res;
+    }
+
+    FwuReply r = {};
+    if (rr.next(r, READY_TIMEOUT_MS) != 1 or r.status != FwuStatus::FWU_READY)
+    {
+        res.last = r;
+        if (not rr.text().empty())
+        {
+            fprintf(stderr, "device: %s", rr.text().c_str());
+        }
+        return res;
+    }
+    window = std::min(window, r.value);
+    window = window != 0U ? window : 1U;
+
+    const auto t0 = Clock::now();
+    std::vector<uint8_t> frame(sizeof(FwuFrameHdr) + FWU_CHUNK);
+    uint32_t acked = 0;
+    uint32_t next  = 0;
+    for (;;)
+    {
+        while (next < size and next - acked < window * FWU_CHUNK)
+        {
+            FwuFrameHdr h;
+            h.magic  = FWU_FRAME_MAGIC;
+            h.offset = next;
+            h.length = std::min(FWU_CHUNK, size - next);
+            h.crc    = fwu_crc32(0, &img[next], h.length);
+            h.hcrc   = fwu_header_crc(h);
+            memcpy(frame.data(), &h, sizeof(h));
+            memcpy(frame.data() + sizeof(h), &img[next], h.length);
+            if (not link.write(frame.data(), sizeof(h) + h.length))
+            {
+                return res;
+            }
+            next += h.length;
+            res.frames++;
+        }
+
+        const int got = rr.next(r, ACK_TIMEOUT_MS);
+        if (got < 0)
+        {
+            return res;
+        }
+        if (got == 0)
+        {
+            res.timeouts++;
+            next = acked; // go back to what the device holds for sure
+            continue;
+        }
+
+        res.last = r;
+        switch (r.status)
+        {
+            case FwuStatus::FWU_ACK:
+                acked = std::max(acked, r.offset);
+                next  = std::max(next, acked);
+                break;
+            case FwuStatus::FWU_NAK:
+                res.naks++;
+                acked = r.offset;
+                next  = r.offset;
+                break;
+            case FwuStatus::FWU_DONE:
+                res.done = true;
+                res.sec  = seconds_since(t0);
+                return res;
+            default:
+                return res;
+        }
+    }
+}
+
+
+/**
+ * @brief the device side of update_receive(), on the simulated flash, paced
+ *        like the real bank: each word program holds the task for `wordUs`
+ */
+static void device_stand_in(Wire &in, Wire &out, FlashSimImpl &flash, FwuReceiver::Stats &stats)
+{
+    std::string line;
+    uint8_t buf[PACKET];
+    size_t n   = 0;
+    size_t pos = 0;
+
+    // the command line on the benchmark port
+    for (;;)
+    {
+        n   = in.pop(buf, sizeof(buf), DEVICE_IDLE_MS);
+        pos = 0;
+        if (n == 0U)
+        {
+            return;
+        }
+        while (pos < n and buf[pos] != '\n')
+        {
+            line.push_back(static_cast<char>(buf[pos++]));
+        }
+        if (pos < n)
+        {
+            pos++;
+            break;
+        }
+    }
+
+    unsigned long size = 0;
+    unsigned long crc  = 0;
+    if (sscanf(line.c_str(), "update %lu %lx", &size, &crc) != 2)
+    {
+        out.push(reinterpret_cast<const uint8_t *>("err unknown command\r\n"), 21);
+        return;
+    }
+
+    FwuReceiver rx(flash, SLOT_BASE, SLOT_SIZE);
+    FwuReply reply;
+    rx.begin(static_cast<uint32_t>(size), static_cast<uint32_t>(crc), reply);
+    out.push(reinterpret_cast<const uint8_t *>(&reply), sizeof(reply));
+    flash.stats_reset(); // the erase before READY is not paced
+
+    auto busyUntil = Clock::now();
+    while (not rx.finished())
+    {
+        if (pos == n)
+        {
+            n   = in.pop(buf, sizeof(buf), DEVICE_IDLE_MS);
+            pos = 0;
+            if (n == 0U)
+            {
+                rx.abort(FwuErrCode::FWU_TIMEOUT, reply);
+                out.push(reinterpret_cast<const uint8_t *>(&reply), sizeof(reply));
+                break;
+            }
+        }
+
+        bool has              = false;
+        const uint64_t before = flash.stats_getter().busyNs;
+        pos += rx.feed(&buf[pos], static_cast<uint32_t>(n - pos), reply, has);
+
+        // the bank stalls the task while it programs, the USB keeps receiving
+        busyUntil = std::max(busyUntil, Clock::now()) + std::chrono::nanoseconds(flash.stats_getter().busyNs - before);
+        std::this_thread::sleep_until(busyUntil);
+        if (has)
+        {
+            out.push(reinterpret_cast<const uint8_t *>(&reply), sizeof(reply));
+        }
+    }
+    stats = rx.stats_getter();
+}
+
+
+/**
+ * @brief one self test run
+ * @param expect FWU_DONE, or FWU_FAIL with the reason in `reason`
+ */
+static double run(const char *name, const std::vector<uint8_t> &img, uint32_t crc, uint32_t window,
+                  uint32_t corrupt, FwuStatus expect, FwuErrCode reason = FwuErrCode::FWU_ERR_NONE)
+{
+    // H723 bank: 128 KB sectors, 32-byte words; only the word program is paced
+    const FlashSimImpl::Timing t = {0, 0, 0, static_cast<uint64_t>(opt.wordUs) * 1000U, 0};
+    FlashSimImpl flash(BANK_SIZE, SECTOR_SIZE, WORD_SIZE, t);
+    (void)flash.enable();
+
+    Wire toDevice(opt.latencyUs, DEVICE_RX_RING);
+    Wire fromDevice(opt.latencyUs, 1U << 20);
+    toDevice.corrupt(corrupt, 1);
+    WireLink link(toDevice, fromDevice);
+
+    FwuReceiver::Stats ds = {};
+    std::thread dev(device_stand_in, std::ref(toDevice), std::ref(fromDevice), std::ref(flash), std::ref(ds));
+    const Result res = send_image(link, img, crc, window);
+    dev.join();
+
+    const double mbs = res.done ? static_cast<double>(img.size()) / res.sec / 1e6 : 0.0;
+    printf("%-10s %6u %3u %8.3f %8.3f %6u %5u %5u %6u %8u  %s\n", name, static_cast<uint32_t>(img.size() / 1024U),
+           window, res.sec, mbs, res.frames, res.naks, res.timeouts, toDevice.flipped(), ds.hunted,
+           res.done ? "DONE" : "FAIL");
+
+    if (expect == FwuStatus::FWU_DONE)
+    {
+        if (not res.done)
+        {
+            fail("%s: no DONE, last status %u value %u", name, static_cast<unsigned>(res.last.status),
+                 res.last.value);
+        }
+        else if (memcmp(flash.image() + SLOT_BASE, img.data(), img.size()) != 0)
+        {
+            fail("%s: the slot differs from the image", name);
+        }
+        if (flash.stats_getter().violations != 0U)
+        {
+            fail("%s: a word was programmed twice", name);
+        }
+    }
+    else if (res.last.status != expect or res.last.value != static_cast<uint32_t>(reason))
+    {
+        fail("%s: expected FAIL %u, got status %u value %u", name, static_cast<unsigned>(reason),
+             static_cast<unsigned>(res.last.status), res.last.value);
+    }
+    return mbs;
+}
+
+
+/**
+ * @brief the runs of -e
+ */
+static int self_test()
+{
+    std::vector<uint8_t> img(opt.kb * 1024U + 100U); // a short last frame too
+    std::mt19937 rng(7);
+    for (auto &b : img)
+    {
+        b = static_cast<uint8_t>(rng());
+    }
+    const uint32_t crc = fwu_crc32(0, img.data(), static_cast<uint32_t>(img.size()));
+
+    const double flashMbs = static_cast<double>(WORD_SIZE) / opt.wordUs;
+    printf("link %u us each way, flash %u us per %u-byte word (%.3f MB/s)\n\n", opt.latencyUs, opt.wordUs, WORD_SIZE,
+           flashMbs);
+    printf("%-10s %6s %3s %8s %8s %6s %5s %5s %6s %8s\n", "run", "KB", "win", "s", "MB/s", "frames", "naks", "t/o",
+           "flips", "hunted");
+
+    const double w1 = run("window-1", img, crc, 1, 0, FwuStatus::FWU_DONE);
+    const double wn = run("window-N", img, crc, FWU_WINDOW, 0, FwuStatus::FWU_DONE);
+    run("corrupt", img, crc, FWU_WINDOW, opt.corrupt, FwuStatus::FWU_DONE);
+
+    std::vector<uint8_t> big(SLOT_SIZE + 1U, 0x5A);
+    run("too-big", big, 0, FWU_WINDOW, 0, FwuStatus::FWU_FAIL, FwuErrCode::FWU_TOO_BIG);
+    run("bad-crc", img, crc ^ 1U, FWU_WINDOW, 0, FwuStatus::FWU_FAIL, FwuErrCode::FWU_CRC_MISMATCH);
+
+    printf("\nwindow-N runs at %.0f%% of the flash, window-1 at %.0f%%\n", 100.0 * wn / flashMbs,
+           100.0 * w1 / flashMbs);
+    if (wn <= w1)
+    {
+        fail("frames in flight do not beat one frame per round trip");
+    }
+
+    return check_summary();
+}
+
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "w:es:l:p:c:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'w': opt.window = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'e': opt.emulate = true; break;
+        case 's': opt.kb = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'l': opt.latencyUs = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'p': opt.wordUs = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'c': opt.corrupt = static_cast<uint32_t>(atoi(optarg)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.window == 0U or opt.wordUs == 0U or opt.kb == 0U or opt.kb * 1024U + 100U > SLOT_SIZE)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (opt.emulate)
+    {
+        return self_test();
+    }
+    if (optind != argc - 2)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[optind], "rb");
+    if (f == nullptr)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    std::vector<uint8_t> img;
+    uint8_t tmp[4096];
+    size_t n;
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) != 0U)
+    {
+        img.insert(img.end(), tmp, tmp + n);
+    }
+    fclose(f);
+    if (img.empty() or img.size() > SLOT_SIZE)
+    {
+        fprintf(stderr, "%s: %zu bytes, the slot holds 1 to %u\n", argv[optind], img.size(), SLOT_SIZE);
+        return 1;
+    }
+
+    TtyLink link(argv[optind + 1]);
+    if (not link.ok())
+    {
+        return 1;
+    }
+    const uint32_t crc = fwu_crc32(0, img.data(), static_cast<uint32_t>(img.size()));
+    printf("%s: %zu bytes, crc 0x%08x\n", argv[optind], img.size(), crc);
+
+    const Result res = send_image(link, img, crc, opt.window);
+    if (not res.done)
+    {
+        fprintf(stderr, "update failed: status %u value %u at offset %u\n", static_cast<unsigned>(res.last.status),
+                res.last.value, res.last.offset);
+        return 1;
+    }
+    printf("done in %.3f s, %.3f MB/s, %u frames, %u naks, %u timeouts; the device restarts\n", res.sec,
+           static_cast<double>(img.size()) / res.sec / 1e6, res.frames, res.naks, res.timeouts);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file        host-test.hpp
+ * @brief       What every host tool counts its checks and times its loops with
+ *
+ * @attention   Any C++17 host. One translation unit per tool: the count is
+ *              an inline variable, one for the whole program anyway.
+ *
+ *              A tool calls fail() for every check that does not hold, goes
+ *              on with the others, and ends main() with
+ *              `return check_summary();`, non zero when one failed: what
+ *              Tools/CMakeLists.txt registers with ctest.
+ *
+ * @author      MekLi
+ * @date        2025/9/21
+ * @version     1.0
+ */
+
+#pragma once
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+inline uint32_t s_failures = 0;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+/**
+ * @brief report a failed check on stderr, "FAIL " and the message, and count it
+ */
+__attribute__((format(printf, 1, 2))) inline void fail(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    fputs("FAIL ", stderr);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+    s_failures++;
+}
+
+/**
+ * @brief nanoseconds since t0, per item when n is given
+ */
+inline double ns_since(std::chrono::steady_clock::time_point t0, uint64_t n = 1U)
+{
+    const auto d = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0);
+    return static_cast<double>(d.count()) / static_cast<double>(n);
+}
+
+/**
+ * @brief the last line of a tool and its exit status
+ */
+inline int check_summary(void)
+{
+    if (s_failures != 0U)
+    {
+        printf("%u check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
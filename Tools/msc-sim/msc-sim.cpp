@@ -0,0 +1,327 @@
+/**
+ * @file        msc-sim.cpp
+ * @brief       Host check and throughput model of the MSC sector cache on a simulated NOR flash
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./msc-sim [-m flash_mb] [-l lines] [-c chunk_blocks] [-n ops] [-r seed]
+ *
+ *              Runs the workloads a USB host sends to the mass storage
+ *              function through SectorCache on top of FlashSimImpl, with the
+ *              same geometry as the board (4 KB sectors, 256 B pages):
+ *
+ *                  seq-write    whole region, `chunk` blocks per WRITE(10)
+ *                  seq-read     whole region, `chunk` blocks per READ(10)
+ *                  rewrite      same data again, must cost no erase
+ *                  rand-write   4 KB at random 4 KB aligned offsets
+ *                  rand-read    4 KB at random 4 KB aligned offsets
+ *                  rand-512     one block at random offsets
+ *                  seq-512      1 MB, one block per command (dd bs=512)
+ *
+ *              Every write also goes to a reference image. Every read is
+ *              compared with it, and so is the flash after each flush. The
+ *              flash must never be asked to raise a bit without an erase.
+ *              Any mismatch makes the exit status non zero, so the tool
+ *              doubles as a CI check.
+ *
+ *              MB/s figures come from the datasheet timings of the simulated
+ *              part: "flash" is the throughput of the flash alone, "link" adds
+ *              a full speed bulk-only transport (~1 MB/s payload, 1 ms per
+ *              command) overlapped with the flash work like the device does.
+ *              "naive" is the erase count of a write-through driver that
+ *              erases and reprograms the sector for every write command.
+ *
+ * @author      MekLi
+ * @date        2025/9/6
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Storage/sector-cache.hpp"
+#include "../../Drivers/Peripheral/Flash/flash-sim-impl.hpp"
+#include "../host-test.hpp"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+#define SECTOR_SIZE         4096U
+#define PAGE_SIZE           256U
+#define BLOCK               SectorCache::BLOCK_SIZE
+#define USB_BYTES_PER_US    1.0     // full speed bulk payload, ~1 MB/s
+#define USB_CMD_US          1000.0  // CBW + CSW + scheduling, one frame each way
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t flash_mb = 16;
+    uint32_t lines    = 16;
+    uint32_t chunk    = 64;
+    uint32_t ops      = 2000;
+    unsigned seed     = 1;
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-m flash_mb] [-l lines] [-c chunk_blocks] [-n ops] [-r seed]\n"
+            "  -m  simulated flash size (default %u MB)\n"
+            "  -l  cache lines of 4 KB (default %u, at most %u)\n"
+            "  -c  blocks per command of the sequential workloads (default %u)\n"
+            "  -n  commands of the random workloads (default %u)\n"
+            "  -r  random seed (default %u)\n",
+            argv0, opt.flash_mb, opt.lines, SectorCache::MAX_LINES, opt.chunk, opt.ops, opt.seed);
+}
+
+/**
+ * @brief one workload run through the cache
+ */
+class Bench
+{
+  public:
+    Bench(FlashSimImpl &flash, SectorCache &cache, std::vector<uint8_t> &ref, std::mt19937 &rng)
+        : _flash(flash), _cache(cache), _ref(ref), _rng(rng)
+    {
+    }
+
+    void begin(const char *name)
+    {
+        _name = name;
+        _flash.stats_reset();
+        _cache.stats_reset();
+        _bytes = 0;
+        _cmds  = 0;
+        _naive = 0;
+    }
+
+    void write(uint32_t lba, uint32_t count, bool sameData = false)
+    {
+        std::vector<uint8_t> buf(count * BLOCK);
+        if (sameData)
+        {
+            std::memcpy(buf.data(), &_ref[lba * BLOCK], buf.size());
+        }
+        else
+        {
+            for (auto &b : buf)
+            {
+                b = static_cast<uint8_t>(_rng());
+            }
+        }
+        std::memcpy(&_ref[lba * BLOCK], buf.data(), buf.size());
+        if (_cache.write(lba, buf.data(), count) != FlashErrCode::FLASH_SUCCESS)
+        {
+            fail("write error at lba %u", lba);
+        }
+        const uint32_t bps = SECTOR_SIZE / BLOCK;
+        _naive += (lba + count - 1U) / bps - lba / bps + 1U;
+        _bytes += buf.size();
+        _cmds++;
+    }
+
+    void read(uint32_t lba, uint32_t count)
+    {
+        std::vector<uint8_t> buf(count * BLOCK);
+        if (_cache.read(lba, buf.data(), count) != FlashErrCode::FLASH_SUCCESS)
+        {
+            fail("read error at lba %u", lba);
+        }
+        else if (std::memcmp(buf.data(), &_ref[lba * BLOCK], buf.size()) != 0)
+        {
+            fail("read data mismatch at lba %u", lba);
+        }
+        /* the device prefetches while the previous chunk is on the bus */
+        (void)_cache.prefetch();
+        _bytes += buf.size();
+        _cmds++;
+    }
+
+    void end()
+    {
+        if (_cache.flush() != FlashErrCode::FLASH_SUCCESS)
+        {
+            fail("flush error");
+        }
+        if (std::memcmp(_flash.image(), _ref.data(), _ref.size()) != 0)
+        {
+            fail("flash content differs from the reference after flush");
+        }
+        const FlashSimImpl::Stats &fs = _flash.stats_getter();
+        const SectorCache::Stats &cs  = _cache.stats_getter();
+        if (fs.violations != 0U)
+        {
+            fail("%llu bits programmed from 0 to 1", static_cast<unsigned long long>(fs.violations));
+        }
+
+        const double mb       = static_cast<double>(_bytes) / 1e6;
+        const double flash_us = static_cast<double>(fs.busyNs) / 1e3;
+        const double usb_us   = static_cast<double>(_bytes) / USB_BYTES_PER_US + USB_CMD_US * _cmds;
+        const double link_us  = flash_us > usb_us ? flash_us : usb_us;
+        printf("%-11s %7.2f %9.1f %9.2f %7.3f %7llu %8llu %7llu %9llu %7llu\n", _name, mb, flash_us / 1e3,
+               flash_us > 0 ? mb / (flash_us / 1e6) : 0.0, mb / (link_us / 1e6),
+               static_cast<unsigned long long>(fs.erases), static_cast<unsigned long long>(fs.programs),
+               static_cast<unsigned long long>(cs.eraseSkips), static_cast<unsigned long long>(cs.hits),
+               static_cast<unsigned long long>(_naive));
+    }
+
+    uint64_t erases() const
+    {
+        return _flash.stats_getter().erases;
+    }
+
+  private:
+    void fail(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+    {
+        va_list ap;
+        va_start(ap, fmt);
+        fprintf(stderr, "FAIL %s: ", _name);
+        vfprintf(stderr, fmt, ap);
+        fputc('\n', stderr);
+        va_end(ap);
+        s_failures++;
+    }
+
+    FlashSimImpl &_flash;
+    SectorCache &_cache;
+    std::vector<uint8_t> &_ref;
+    std::mt19937 &_rng;
+    const char *_name = "";
+    uint64_t _bytes   = 0;
+    uint64_t _cmds    = 0;
+    uint64_t _naive   = 0;
+};
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "m:l:c:n:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'm': opt.flash_mb = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'l': opt.lines = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'c': opt.chunk = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'n': opt.ops = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.flash_mb == 0U or opt.lines == 0U or opt.lines > SectorCache::MAX_LINES or opt.chunk == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FlashSimImpl flash(opt.flash_mb << 20, SECTOR_SIZE, PAGE_SIZE);
+    std::vector<uint8_t> lines(opt.lines * SECTOR_SIZE);
+    SectorCache cache(flash, lines.data(), static_cast<uint32_t>(lines.size()));
+    if (flash.enable() != FlashErrCode::FLASH_SUCCESS or cache.init() != FlashErrCode::FLASH_SUCCESS)
+    {
+        fprintf(stderr, "init failed\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> ref(opt.flash_mb << 20, 0xFFU);
+    std::mt19937 rng(opt.seed);
+    Bench b(flash, cache, ref, rng);
+    const uint32_t blocks = cache.block_count();
+    const uint32_t bps    = SECTOR_SIZE / BLOCK;
+
+    printf("flash %u MB, %u lines of %u B, %u blocks per sequential command\n\n", opt.flash_mb, cache.lines_getter(),
+           SECTOR_SIZE, opt.chunk);
+    printf("%-11s %7s %9s %9s %7s %7s %8s %7s %9s %7s\n", "workload", "MB", "flash ms", "flash MB/s", "link",
+           "erases", "programs", "no-ers", "hits", "naive");
+
+    b.begin("seq-write");
+    for (uint32_t lba = 0; lba < blocks; lba += opt.chunk)
+    {
+        b.write(lba, opt.chunk < blocks - lba ? opt.chunk : blocks - lba);
+    }
+    b.end();
+
+    b.begin("seq-read");
+    cache.invalidate();
+    for (uint32_t lba = 0; lba < blocks; lba += opt.chunk)
+    {
+        b.read(lba, opt.chunk < blocks - lba ? opt.chunk : blocks - lba);
+    }
+    b.end();
+
+    b.begin("rewrite");
+    for (uint32_t lba = 0; lba < blocks; lba += opt.chunk)
+    {
+        b.write(lba, opt.chunk < blocks - lba ? opt.chunk : blocks - lba, true);
+    }
+    b.end();
+    if (b.erases() != 0U)
+    {
+        fail("rewrite: identical data caused %llu erases", static_cast<unsigned long long>(b.erases()));
+    }
+
+    std::uniform_int_distribution<uint32_t> sector(0, blocks / bps - 1U);
+    std::uniform_int_distribution<uint32_t> block(0, blocks - 1U);
+
+    b.begin("rand-write");
+    for (uint32_t i = 0; i < opt.ops; i++)
+    {
+        b.write(sector(rng) * bps, bps);
+    }
+    b.end();
+
+    b.begin("rand-read");
+    cache.invalidate();
+    for (uint32_t i = 0; i < opt.ops; i++)
+    {
+        b.read(sector(rng) * bps, bps);
+    }
+    b.end();
+
+    b.begin("rand-512");
+    for (uint32_t i = 0; i < opt.ops; i++)
+    {
+        b.write(block(rng), 1);
+    }
+    b.end();
+
+    b.begin("seq-512");
+    for (uint32_t lba = 0; lba < (1U << 20) / BLOCK and lba < blocks; lba++)
+    {
+        b.write(lba, 1);
+    }
+    b.end();
+
+    /* mixed traffic with reads checked against the reference while lines are dirty */
+    b.begin("mixed");
+    std::uniform_int_distribution<uint32_t> len(1, 3 * bps);
+    for (uint32_t i = 0; i < opt.ops; i++)
+    {
+        const uint32_t lba  = block(rng);
+        const uint32_t want = len(rng);
+        const uint32_t n    = want < blocks - lba ? want : blocks - lba;
+        if (rng() & 1U)
+        {
+            b.write(lba, n);
+        }
+        else
+        {
+            b.read(lba, n);
+        }
+    }
+    b.end();
+
+    printf("\nmax erases of one sector: %u\n", flash.max_erase_count());
+    return check_summary();
+}
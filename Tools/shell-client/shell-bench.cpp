@@ -0,0 +1,554 @@
+/**
+ * @file        shell-bench.cpp
+ * @brief       Command throughput of the shell port: one command at a time against the pipelined client
+ *
+ * @attention   Linux only. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-bench [-d /dev/ttyACM0 | -e] [-n commands] [-w window] [-l turnaround_us] [-t lines_per_s]
+ *
+ *              -d runs against the board. -e (the default) runs against a
+ *              stand-in on a pseudo terminal: a thread on the master side
+ *              that answers the tagged protocol of shell-proto.hpp like the
+ *              device does, `echo` and an error for anything else, and
+ *              writes numbered log lines at -t lines per second in between.
+ *              It handles what one read() brings after -l microseconds, the
+ *              time the device needs to see a USB packet and answer, so a
+ *              host that waits for every reply pays it on every command.
+ *
+ *              The same commands run twice:
+ *
+ *                  naive        write one command, read() byte per byte
+ *                               until its end line, then the next one
+ *                  pipelined    ShellClient, -w commands in flight, replies
+ *                               matched by tag
+ *
+ *              Checks: every command gets exactly one end line, the body of
+ *              an echo matches what was sent, the unknown commands fail;
+ *              the log lines of the stand-in arrive in sequence, none lost;
+ *              from a window of 4, the pipelined client runs at least twice
+ *              as many commands per second. Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/10
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "shell-client.hpp"
+#include "../host-test.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+#define BAD_EVERY   50U     // one command in BAD_EVERY is unknown to the device
+#define LOG_PREFIX  "[bench] I seq "
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    const char *device = nullptr;   // nullptr: pty stand-in
+    uint32_t count     = 5000;
+    uint32_t window    = 32;
+    uint32_t turnUs    = 250;       // two microframes
+    uint32_t logRate   = 2000;      // lines per second
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-d tty | -e] [-n commands] [-w window] [-l turnaround_us] [-t lines_per_s]\n"
+            "  runs the same commands one at a time and pipelined, -e against a pty stand-in\n",
+            argv0);
+}
+
+static uint64_t now_us()
+{
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief the command number i: an echo, or now and then one the device does not know
+ */
+static std::string command_of(uint32_t i)
+{
+    return (i % BAD_EVERY == BAD_EVERY - 1U ? "nosuch " : "echo x") + std::to_string(i);
+}
+
+/**
+ * @brief the device side of the pty: answers tagged commands, writes log lines
+ */
+class StandIn
+{
+  public:
+    StandIn(int master, uint32_t turnUs, uint32_t logRate) : _fd(master), _turnUs(turnUs), _logRate(logRate)
+    {
+    }
+
+    void start()
+    {
+        _thread = std::thread([this] { run(); });
+    }
+
+    void stop()
+    {
+        _stop = true;
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+    }
+
+  private:
+    void run()
+    {
+        std::string in;
+        std::string out;
+        char buf[4096];
+        const uint64_t period = _logRate != 0U ? 1000000U / _logRate : 0U;
+        uint64_t nextLog      = now_us() + period;
+
+        while (not _stop)
+        {
+            out.clear();
+            const uint64_t now = now_us();
+            while (period != 0U and now >= nextLog)
+            {
+                out += LOG_PREFIX + std::to_string(_seq++) + "\r\n";
+                nextLog += period;
+            }
+
+            pollfd p = {_fd, POLLIN, 0};
+            const int wait = period != 0U ? static_cast<int>((nextLog - std::min(nextLog, now)) / 1000U) : 10;
+            if (out.empty() and ::poll(&p, 1, std::min(wait, 10)) > 0)
+            {
+                const ssize_t n = read(_fd, buf, sizeof(buf));
+                if (n <= 0)
+                {
+                    break; // the client side closed
+                }
+                in.append(buf, static_cast<size_t>(n));
+                std::this_thread::sleep_for(std::chrono::microseconds(_turnUs));
+                answer(in, out);
+            }
+            if (not out.empty() and not send(out))
+            {
+                break;
+            }
+        }
+    }
+
+    void answer(std::string &in, std::string &out)
+    {
+        size_t at = 0;
+        for (size_t nl; (nl = in.find_first_of("\r\n", at)) != std::string::npos; at = nl + 1U)
+        {
+            ShellTagged t{};
+            if (not shell_parse_tagged(std::string_view(in).substr(at, nl - at), t) or t.kind != ' ')
+            {
+                continue; // an empty line, or a person typing: not measured here
+            }
+            const std::string tag = SHELL_TAG_MARK + std::to_string(t.tag);
+            if (t.rest.substr(0, 5) == "echo ")
+            {
+                out += tag + SHELL_BODY_MARK + std::string(t.rest.substr(5)) + "\r\n";
+                out += tag + SHELL_END_MARK + "ok\r\n";
+            }
+            else
+            {
+                out += tag + SHELL_END_MARK + "err unknown command\r\n";
+            }
+        }
+        in.erase(0, at);
+    }
+
+    bool send(const std::string &out)
+    {
+        size_t done = 0;
+        while (done < out.size())
+        {
+            const ssize_t n = write(_fd, out.data() + done, out.size() - done);
+            if (n < 0 and errno != EINTR)
+            {
+                return false;
+            }
+            done += n > 0 ? static_cast<size_t>(n) : 0U;
+        }
+        return true;
+    }
+
+    int _fd;
+    uint32_t _turnUs;
+    uint32_t _logRate;
+    uint32_t _seq = 0;
+    std::atomic<bool> _stop{false};
+    std::thread _thread;
+};
+
+/**
+ * @brief counts the log lines of the stand-in and checks their sequence
+ */
+struct LogCheck
+{
+    bool enabled   = false;
+    bool started   = false;
+    uint32_t next  = 0;
+    uint64_t lines = 0;
+    uint64_t gaps  = 0;
+
+    void line(std::string_view s)
+    {
+        lines++;
+        if (not enabled or s.substr(0, sizeof(LOG_PREFIX) - 1U) != LOG_PREFIX)
+        {
+            return;
+        }
+        const uint32_t seq = static_cast<uint32_t>(strtoul(std::string(s.substr(sizeof(LOG_PREFIX) - 1U)).c_str(), nullptr, 10));
+        gaps += started and seq != next ? 1U : 0U;
+        started = true;
+        next    = seq + 1U;
+    }
+};
+
+struct Result
+{
+    double seconds;
+    uint64_t syscalls;
+    std::vector<uint64_t> latUs;
+    LogCheck log;
+};
+
+/**
+ * @brief the reply of one command, as either mode sees it
+ */
+struct Reply
+{
+    uint32_t index;
+    uint64_t sentUs;
+    uint32_t ends;
+    bool ok;
+    std::string body;
+};
+
+static void check_reply(const char *mode, const Reply &r)
+{
+    const std::string cmd = command_of(r.index);
+    const bool bad        = cmd.compare(0, 5, "echo ") != 0;
+    if (r.ends != 1U)
+    {
+        fail("%s: command %u ended %u times", mode, r.index, r.ends);
+    }
+    else if (r.ok == bad)
+    {
+        fail("%s: command %u \"%s\" %s", mode, r.index, cmd.c_str(), r.ok ? "succeeded" : "failed");
+    }
+    else if (not bad and r.body != cmd.substr(5))
+    {
+        fail("%s: command %u echoed \"%s\"", mode, r.index, r.body.c_str());
+    }
+}
+
+static int open_raw(const char *path, bool nonblock)
+{
+    const int fd = open(path, O_RDWR | O_NOCTTY | (nonblock ? O_NONBLOCK : 0));
+    termios tio{};
+    if (fd >= 0 and tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        (void)tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+/**
+ * @brief one command at a time, as a script with a serial library does it
+ */
+static Result run_naive(const char *path, bool stand)
+{
+    Result res{};
+    res.log.enabled = stand;
+    const int fd    = open_raw(path, false);
+    if (fd < 0)
+    {
+        fail("naive: open %s: %s", path, strerror(errno));
+        return res;
+    }
+
+    const uint64_t t0 = now_us();
+    std::string line;
+    for (uint32_t i = 0; i < opt.count; i++)
+    {
+        const uint32_t tag    = i + 1U;
+        const std::string req = SHELL_TAG_MARK + std::to_string(tag) + " " + command_of(i) + "\n";
+        Reply r               = {i, now_us(), 0, false, {}};
+        res.syscalls++;
+        if (write(fd, req.data(), req.size()) != static_cast<ssize_t>(req.size()))
+        {
+            fail("naive: write: %s", strerror(errno));
+            break;
+        }
+
+        while (r.ends == 0U)
+        {
+            char c = 0;
+            res.syscalls++;
+            if (read(fd, &c, 1) != 1)
+            {
+                fail("naive: read: %s", strerror(errno));
+                close(fd);
+                return res;
+            }
+            if (c != '\n')
+            {
+                line += c;
+                continue;
+            }
+            if (not line.empty() and line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            ShellTagged t{};
+            if (not shell_parse_tagged(line, t))
+            {
+                res.log.line(line);
+            }
+            else if (t.tag == tag and t.kind == SHELL_BODY_MARK)
+            {
+                r.body = std::string(t.rest);
+            }
+            else if (t.tag == tag and t.kind == SHELL_END_MARK)
+            {
+                r.ends++;
+                r.ok = t.rest == "ok";
+            }
+            line.clear();
+        }
+        res.latUs.push_back(now_us() - r.sentUs);
+        check_reply("naive", r);
+    }
+    res.seconds = static_cast<double>(now_us() - t0) / 1e6;
+    close(fd);
+    return res;
+}
+
+/**
+ * @brief records what the pipelined client delivers
+ */
+class Collector : public ShellListener
+{
+  public:
+    void on_line(uint32_t tag, std::string_view text) override
+    {
+        auto it = pending.find(tag);
+        if (it != pending.end())
+        {
+            it->second.body = std::string(text);
+        }
+    }
+
+    void on_done(uint32_t tag, bool ok, std::string_view detail) override
+    {
+        (void)detail;
+        auto it = pending.find(tag);
+        if (it == pending.end())
+        {
+            fail("pipelined: end of tag %u never sent", tag);
+            return;
+        }
+        it->second.ends++;
+        it->second.ok = ok;
+        latUs.push_back(now_us() - it->second.sentUs);
+        check_reply("pipelined", it->second);
+        pending.erase(it);
+    }
+
+    void on_telemetry(std::string_view line) override
+    {
+        log.line(line);
+    }
+
+    std::unordered_map<uint32_t, Reply> pending;
+    std::vector<uint64_t> latUs;
+    LogCheck log;
+};
+
+/**
+ * @brief the same commands through ShellClient
+ */
+static Result run_pipelined(const char *path, bool stand)
+{
+    Result res{};
+    Collector col;
+    col.log.enabled = stand;
+    ShellClient client(col, opt.window);
+    if (not client.open(path))
+    {
+        fail("pipelined: open %s: %s", path, strerror(errno));
+        return res;
+    }
+
+    const uint64_t t0 = now_us();
+    uint64_t polls    = 0;
+    uint32_t sent     = 0;
+    uint64_t idleFrom = now_us();
+    while (sent < opt.count or client.outstanding_getter() != 0U)
+    {
+        for (; sent < opt.count; sent++)
+        {
+            const uint32_t tag = client.submit(command_of(sent));
+            if (tag == 0U)
+            {
+                break; // window full: wait for replies
+            }
+            col.pending[tag] = {sent, now_us(), 0, false, {}};
+        }
+
+        polls++;
+        const int lines = client.poll(100);
+        if (lines < 0)
+        {
+            fail("pipelined: device went away");
+            break;
+        }
+        idleFrom = lines != 0 ? now_us() : idleFrom;
+        if (now_us() - idleFrom > 2000000U)
+        {
+            fail("pipelined: %u commands unanswered for 2 s", client.outstanding_getter());
+            break;
+        }
+    }
+    res.seconds = static_cast<double>(now_us() - t0) / 1e6;
+
+    const ShellClient::Stats &s = client.stats_getter();
+    res.syscalls                = s.reads + s.writes + polls;
+    res.latUs                   = std::move(col.latUs);
+    res.log                     = col.log;
+    if (s.completed != opt.count or not col.pending.empty())
+    {
+        fail("pipelined: %llu of %u commands ended", static_cast<unsigned long long>(s.completed), opt.count);
+    }
+    if (s.orphans != 0U or s.overlong != 0U)
+    {
+        fail("pipelined: %llu orphan replies, %llu overlong lines", static_cast<unsigned long long>(s.orphans),
+             static_cast<unsigned long long>(s.overlong));
+    }
+    return res;
+}
+
+static double report(const char *mode, Result &r)
+{
+    if (r.latUs.empty() or r.seconds <= 0.0)
+    {
+        printf("%-10s  no result\n", mode);
+        return 0.0;
+    }
+    std::sort(r.latUs.begin(), r.latUs.end());
+    const double rate = static_cast<double>(r.latUs.size()) / r.seconds;
+    printf("%-10s  %9.0f cmd/s  p50 %6llu us  p99 %6llu us  %6.2f syscalls/cmd  %7.0f log lines/s\n", mode, rate,
+           static_cast<unsigned long long>(r.latUs[r.latUs.size() / 2U]),
+           static_cast<unsigned long long>(r.latUs[r.latUs.size() * 99U / 100U]),
+           static_cast<double>(r.syscalls) / static_cast<double>(r.latUs.size()),
+           static_cast<double>(r.log.lines) / r.seconds);
+    if (r.log.gaps != 0U)
+    {
+        fail("%s: %llu gaps in the log line sequence", mode, static_cast<unsigned long long>(r.log.gaps));
+    }
+    return rate;
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "d:en:w:l:t:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'd': opt.device = optarg; break;
+        case 'e': opt.device = nullptr; break;
+        case 'n': opt.count = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'w': opt.window = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'l': opt.turnUs = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 't': opt.logRate = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.count == 0U or opt.window == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const bool stand = opt.device == nullptr;
+    printf("%s, %u commands, window %u", stand ? "pty stand-in" : opt.device, opt.count, opt.window);
+    if (stand)
+    {
+        printf(", turnaround %u us, %u log lines/s", opt.turnUs, opt.logRate);
+    }
+    printf("\n");
+
+    Result res[2];
+    for (int mode = 0; mode < 2; mode++)
+    {
+        int master = -1;
+        int slave  = -1;
+        char name[64];
+        StandIn *dev = nullptr;
+        if (stand)
+        {
+            if (openpty(&master, &slave, name, nullptr, nullptr) != 0)
+            {
+                fail("openpty: %s", strerror(errno));
+                break;
+            }
+            dev = new StandIn(master, opt.turnUs, opt.logRate);
+            dev->start();
+        }
+
+        const char *path = stand ? name : opt.device;
+        res[mode]        = mode == 0 ? run_naive(path, stand) : run_pipelined(path, stand);
+
+        if (stand)
+        {
+            close(slave); // the stand-in reads EIO and leaves
+            dev->stop();
+            delete dev;
+            close(master);
+        }
+    }
+
+    const double naive = report("naive", res[0]);
+    const double piped = report("pipelined", res[1]);
+    if (naive > 0.0)
+    {
+        printf("speedup     %.1fx\n", piped / naive);
+    }
+    if (opt.window >= 4U and piped < 2.0 * naive)
+    {
+        fail("pipelined %.0f cmd/s is not twice naive %.0f cmd/s", piped, naive);
+    }
+
+    return check_summary();
+}
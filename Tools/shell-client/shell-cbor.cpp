@@ -0,0 +1,479 @@
+/**
+ * @file        shell-cbor.cpp
+ * @brief       Host decoder of the shell's machine mode, see shell-cbor.hpp
+ *
+ * @author      MekLi
+ * @date        2025/9/21
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "shell-cbor.hpp"
+#include "../../Applications/Update/fwu-proto.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+/**
+ * @brief an IEEE 754 half, major type 7 with 25
+ */
+static double cbor_half(uint32_t h)
+{
+    const uint32_t exp  = (h >> 10) & 0x1FU;
+    const uint32_t mant = h & 0x3FFU;
+    double v;
+    if (exp == 0U)
+    {
+        v = std::ldexp(mant, -24);
+    }
+    else if (exp != 31U)
+    {
+        v = std::ldexp(mant + 1024U, static_cast<int>(exp) - 25);
+    }
+    else
+    {
+        v = mant == 0U ? INFINITY : NAN;
+    }
+    return (h & 0x8000U) != 0U ? -v : v;
+}
+
+
+/**
+ * @brief major type 7: false, true, null, undefined, floating point, break, simple values
+ */
+void CborReader::simple(CborItem &it, uint8_t ai, uint64_t arg)
+{
+    it.open = false;
+    switch (ai)
+    {
+    case 20:
+    case 21:
+        it.type = CborTypeEnum::BOOL;
+        it.b    = ai == 21U;
+        break;
+    case 22: it.type = CborTypeEnum::NUL; break;
+    case 23: it.type = CborTypeEnum::UNDEFINED; break;
+    case 25:
+        it.type = CborTypeEnum::FLOAT;
+        it.f    = cbor_half(static_cast<uint32_t>(arg));
+        break;
+    case 26:
+    {
+        const uint32_t bits = static_cast<uint32_t>(arg);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        it.type = CborTypeEnum::FLOAT;
+        it.f    = f;
+        break;
+    }
+    case 27:
+        it.type = CborTypeEnum::FLOAT;
+        memcpy(&it.f, &arg, sizeof(it.f));
+        break;
+    case 31: it.type = CborTypeEnum::BREAK; break;
+    default: it.type = CborTypeEnum::SIMPLE; break;
+    }
+}
+
+
+/**
+ * @note  recursive, CBOR_DEPTH_MAX containers deep at most
+ */
+bool CborReader::skip(const CborItem &it)
+{
+    switch (it.type)
+    {
+    case CborTypeEnum::BYTES:
+    case CborTypeEnum::TEXT:
+        for (CborItem c{}; it.open;)
+        {
+            if (not next(c))
+            {
+                return false;
+            }
+            if (c.type == CborTypeEnum::BREAK)
+            {
+                return true;
+            }
+            if (c.type != it.type or c.open)
+            {
+                _bad = true; // a chunk is a whole string of the same type
+                return false;
+            }
+        }
+        return true;
+    case CborTypeEnum::ARRAY:
+    case CborTypeEnum::MAP:
+    case CborTypeEnum::TAG: break;
+    case CborTypeEnum::BREAK: _bad = true; return false;
+    default: return true;
+    }
+
+    if (_deep == CBOR_DEPTH_MAX)
+    {
+        _bad = true;
+        return false;
+    }
+    _deep++;
+    const uint64_t n = it.type == CborTypeEnum::TAG ? 1U : (it.type == CborTypeEnum::MAP ? 2U * it.u : it.u);
+    bool ok          = true;
+    for (uint64_t i = 0; ok and (it.open or i < n); i++)
+    {
+        CborItem c{};
+        ok = next(c);
+        if (ok and c.type == CborTypeEnum::BREAK)
+        {
+            ok   = it.open and (it.type != CborTypeEnum::MAP or i % 2U == 0U);
+            _bad = not ok;
+            break;
+        }
+        ok = ok and skip(c);
+    }
+    _deep--;
+    return ok;
+}
+
+
+long cbor_length(const uint8_t *buf, size_t len)
+{
+    CborReader r(buf, len);
+    if (r.skip())
+    {
+        return static_cast<long>(r.pos_getter());
+    }
+    return r.bad_getter() ? -1 : 0;
+}
+
+
+/**
+ * @brief the tree of the item whose head is it, its items read from r
+ * @return 1, 0 when the bytes end inside it, -1 when it is not CBOR
+ */
+static int cbor_build(CborReader &r, const CborItem &it, CborValue &out, uint32_t depth)
+{
+    out.type = it.type;
+    out.u    = it.u;
+    out.f    = it.f;
+    out.b    = it.b;
+    CborItem c{};
+    switch (it.type)
+    {
+    case CborTypeEnum::BYTES:
+    case CborTypeEnum::TEXT:
+        out.str.assign(it.str.data(), it.open ? 0U : it.str.size());
+        while (it.open)
+        {
+            if (not r.next(c))
+            {
+                return r.bad_getter() ? -1 : 0;
+            }
+            if (c.type == CborTypeEnum::BREAK)
+            {
+                break;
+            }
+            if (c.type != it.type or c.open)
+            {
+                return -1;
+            }
+            out.str.append(c.str.data(), c.str.size());
+        }
+        return 1;
+    case CborTypeEnum::ARRAY:
+    case CborTypeEnum::MAP:
+    case CborTypeEnum::TAG: break;
+    case CborTypeEnum::BREAK: return -1;
+    default: return 1;
+    }
+
+    if (depth == CBOR_DEPTH_MAX)
+    {
+        return -1;
+    }
+    const uint64_t n = it.type == CborTypeEnum::TAG ? 1U : (it.type == CborTypeEnum::MAP ? 2U * it.u : it.u);
+    for (uint64_t i = 0; it.open or i < n; i++)
+    {
+        if (not r.next(c))
+        {
+            return r.bad_getter() ? -1 : 0;
+        }
+        if (c.type == CborTypeEnum::BREAK)
+        {
+            return it.open and (it.type != CborTypeEnum::MAP or i % 2U == 0U) ? 1 : -1;
+        }
+        out.items.emplace_back();
+        const int k = cbor_build(r, c, out.items.back(), depth + 1U);
+        if (k <= 0)
+        {
+            return k;
+        }
+    }
+    return 1;
+}
+
+
+long cbor_decode(const uint8_t *buf, size_t len, CborValue &out)
+{
+    out = CborValue{};
+    CborReader r(buf, len);
+    CborItem it{};
+    if (not r.next(it))
+    {
+        return r.bad_getter() ? -1 : 0;
+    }
+    const int k = cbor_build(r, it, out, 0U);
+    return k > 0 ? static_cast<long>(r.pos_getter()) : k;
+}
+
+
+const CborValue *CborValue::at(uint64_t k) const
+{
+    if (type != Type::MAP)
+    {
+        return nullptr;
+    }
+    for (size_t i = 0; i + 1U < items.size(); i += 2U)
+    {
+        if (items[i].type == Type::UINT and items[i].u == k)
+        {
+            return &items[i + 1U];
+        }
+    }
+    return nullptr;
+}
+
+
+std::string CborValue::diag() const
+{
+    char num[40];
+    std::string s;
+    switch (type)
+    {
+    case Type::UINT: snprintf(num, sizeof(num), "%llu", static_cast<unsigned long long>(u)); return num;
+    case Type::NINT:
+        if (u == UINT64_MAX)
+        {
+            return "-18446744073709551616";
+        }
+        snprintf(num, sizeof(num), "-%llu", static_cast<unsigned long long>(u + 1U));
+        return num;
+    case Type::BYTES:
+        s = "h'";
+        for (const char c : str)
+        {
+            snprintf(num, sizeof(num), "%02x", static_cast<uint8_t>(c));
+            s += num;
+        }
+        return s + "'";
+    case Type::TEXT:
+        s = "\"";
+        for (const char c : str)
+        {
+            s += c == '"' or c == '\\' ? std::string("\\") + c : std::string(1, c);
+        }
+        return s + "\"";
+    case Type::ARRAY:
+    case Type::MAP:
+        s = type == Type::ARRAY ? "[" : "{";
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            s += i == 0U ? "" : (type == Type::MAP and i % 2U != 0U ? ": " : ", ");
+            s += items[i].diag();
+        }
+        return s + (type == Type::ARRAY ? "]" : "}");
+    case Type::TAG:
+        snprintf(num, sizeof(num), "%llu(", static_cast<unsigned long long>(u));
+        return num + (items.empty() ? std::string() : items[0].diag()) + ")";
+    case Type::BOOL: return b ? "true" : "false";
+    case Type::NUL: return "null";
+    case Type::SIMPLE: snprintf(num, sizeof(num), "simple(%llu)", static_cast<unsigned long long>(u)); return num;
+    case Type::FLOAT:
+        if (std::isnan(f))
+        {
+            return "NaN";
+        }
+        if (std::isinf(f))
+        {
+            return f > 0 ? "Infinity" : "-Infinity";
+        }
+        for (int prec = 1; prec <= 17; prec++) // the shortest that reads back
+        {
+            snprintf(num, sizeof(num), "%.*g", prec, f);
+            if (strtod(num, nullptr) == f)
+            {
+                break;
+            }
+        }
+        if (std::fabs(f) < 1e16 and f == std::trunc(f)) // whole: 100000.0, not 1e+05
+        {
+            snprintf(num, sizeof(num), "%.1f", f);
+        }
+        s = num;
+        return s.find_first_of(".e") == std::string::npos ? s + ".0" : s;
+    default: return "undefined";
+    }
+}
+
+
+/**
+ * @brief lines and frames, each whole, in the order they came
+ */
+void ShellCborStream::feed(const uint8_t *buf, size_t len)
+{
+    _in.insert(_in.end(), buf, buf + len);
+    size_t at = 0;
+    while (at < _in.size())
+    {
+        const size_t left = _in.size() - at;
+        const size_t n    = _in[at] == SHELL_FRAME_MARK ? frame(&_in[at], left) : line(&_in[at], left);
+        if (n == 0U)
+        {
+            break;
+        }
+        at += n;
+    }
+    _in.erase(_in.begin(), _in.begin() + static_cast<long>(at));
+}
+
+
+/**
+ * @return bytes of the frame at p, 0 while it is not all there
+ * @note  a frame of another kind (`dump ... raw`) is skipped whole
+ */
+size_t ShellCborStream::frame(const uint8_t *p, size_t len)
+{
+    ShellFrameHdr hdr{};
+    if (len < sizeof(hdr))
+    {
+        return 0;
+    }
+    if (not shell_parse_frame(p, static_cast<uint32_t>(len), hdr))
+    {
+        _stats.badCrc++;
+        return 1; // not a header: look for the next line or frame after it
+    }
+    const size_t size = sizeof(hdr) + hdr.len;
+    if (len < size)
+    {
+        return 0;
+    }
+    if (hdr.kind != SHELL_FRAME_CBOR)
+    {
+        return size;
+    }
+    _stats.frames++;
+    const uint8_t *payload = p + sizeof(hdr);
+    if (fwu_crc32(0, payload, hdr.len) != hdr.crc)
+    {
+        _stats.badCrc++;
+        return size;
+    }
+
+    Pending &s = _tags[hdr.tag];
+    if (hdr.addr == 0U and s.next != 0U)
+    {
+        // the next line of the same tag, or of no tag: a new stream
+        _stats.leftover += s.bytes.size() - s.used;
+        s = Pending{};
+    }
+    if (s.broken or hdr.addr != s.next)
+    {
+        _stats.gaps += s.broken ? 0U : 1U;
+        s.broken = true;
+        return size;
+    }
+    s.bytes.insert(s.bytes.end(), payload, payload + hdr.len);
+    s.next += hdr.len;
+    // a record longer than a frame is tried again once the stream doubled, or at a short frame: the last of a line
+    if (hdr.len < SHELL_FRAME_DATA or s.bytes.size() - s.used >= 2U * s.tried)
+    {
+        records(hdr.tag, s);
+    }
+    return size;
+}
+
+
+/**
+ * @return bytes of the line at p, line end included, 0 while it has no end
+ */
+size_t ShellCborStream::line(const uint8_t *p, size_t len)
+{
+    const void *nl = memchr(p, '\n', len);
+    if (nl == nullptr)
+    {
+        return 0;
+    }
+    const size_t size = static_cast<size_t>(static_cast<const uint8_t *>(nl) - p) + 1U;
+    std::string_view text(reinterpret_cast<const char *>(p), size);
+    while (not text.empty() and (text.back() == '\n' or text.back() == '\r'))
+    {
+        text.remove_suffix(1);
+    }
+    _stats.lines++;
+
+    ShellTagged t{};
+    if (not shell_parse_tagged(text, t) or t.kind != SHELL_END_MARK)
+    {
+        _listener.on_line(text);
+        return size;
+    }
+    const auto it = _tags.find(t.tag);
+    if (it != _tags.end())
+    {
+        records(t.tag, it->second);
+        _stats.leftover += it->second.broken ? 0U : it->second.bytes.size() - it->second.used;
+        _tags.erase(it);
+    }
+    const bool ok           = t.rest == "ok";
+    std::string_view detail = t.rest;
+    if (not ok and detail.substr(0, 4) == "err ")
+    {
+        detail.remove_prefix(4);
+    }
+    _listener.on_done(t.tag, ok, detail);
+    return size;
+}
+
+
+/**
+ * @brief hand the whole records of a tag's stream, keep the start of the next one
+ */
+void ShellCborStream::records(uint32_t tag, Pending &s)
+{
+    while (not s.broken and s.used < s.bytes.size())
+    {
+        const uint8_t *const record = &s.bytes[s.used];
+        const long n                = cbor_length(record, s.bytes.size() - s.used);
+        if (n == 0)
+        {
+            s.tried = s.bytes.size() - s.used;
+            break;
+        }
+        if (n < 0)
+        {
+            _stats.malformed++;
+            s.broken = true;
+            break;
+        }
+        s.used += static_cast<size_t>(n);
+        s.tried = 0;
+        _stats.records++;
+        _stats.payload += static_cast<uint64_t>(n);
+        _listener.on_record(tag, record, static_cast<size_t>(n));
+    }
+    if (s.used == s.bytes.size() or s.broken)
+    {
+        s.bytes.clear();
+        s.used = 0;
+    }
+    else if (s.used > s.bytes.size() / 2U)
+    {
+        s.bytes.erase(s.bytes.begin(), s.bytes.begin() + static_cast<long>(s.used));
+        s.used = 0;
+    }
+}
@@ -0,0 +1,351 @@
+/**
+ * @file        shell-cbor.hpp
+ * @brief       Host decoder of the shell's machine mode: frames out of the port stream, CBOR records out of the frames
+ *
+ * @attention   Any C++17 host. One ShellCborStream is fed by one thread,
+ *              the bytes as they come from the port, cut anywhere; it
+ *              calls its listener from feed().
+ *
+ * @note        After `mode cbor` a session answers in frames of
+ *              Applications/Shell/shell-proto.hpp, kind 'C', between the
+ *              text lines that still share the port (log lines, the end
+ *              lines of tagged requests). The stream:
+ *
+ *                - tells a frame from a line by its first byte, 0xFE,
+ *                  never in a text line, a frame or a line being one
+ *                  message of the device's transmit queue, never cut;
+ *                - checks the CRC of each frame and that it starts where
+ *                  the one before of its tag ended;
+ *                - puts the payloads of a tag back together and hands
+ *                  every record as soon as its last byte is there, as
+ *                  bytes, the frames joined:
+ *
+ *                      {0: tag, 1: index in the batch, 2: [body items], 3: null or reason}
+ *
+ *              Two decoders for them. CborReader pulls one item at a
+ *              time, a head or a string, with views into the bytes and
+ *              nothing allocated: what a program reading thousands of
+ *              values per second wants. cbor_decode() builds a CborValue
+ *              tree on the heap, handy where speed does not matter. The
+ *              device only encodes (Applications/Format/cbor.hpp).
+ *
+ * @author      MekLi
+ * @date        2025/9/21
+ * @version     1.0
+ */
+
+#pragma once
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-proto.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+constexpr uint32_t CBOR_DEPTH_MAX = 32U;   // containers inside each other, deeper is refused
+
+
+/* ------- class prototypes ------------------------------------------------------------------------------------------*/
+
+enum class CborTypeEnum : uint8_t
+{
+    UINT,
+    NINT,       // -1 - u
+    BYTES,
+    TEXT,
+    ARRAY,
+    MAP,        // items: key, value, key, value ...
+    TAG,        // u the tag, then the tagged item
+    BOOL,
+    NUL,
+    UNDEFINED,
+    SIMPLE,     // u its value
+    FLOAT,
+    BREAK,      // the end of an open item, CborReader only
+};
+
+/**
+ * @brief what CborReader::next() read: a whole number, simple value or
+ *        string, or the head of a container whose items follow
+ */
+struct CborItem
+{
+    CborTypeEnum type;
+    bool open;              // size unknown: items, or string chunks, up to a BREAK
+    bool b;
+    uint64_t u;             // the value, the size of a container, the tag
+    double f;
+    std::string_view str;   // a string or a chunk, into the reader's bytes
+};
+
+/**
+ * @brief pulls items out of bytes, without a copy nor an allocation
+ */
+class CborReader
+{
+  public:
+    CborReader(const uint8_t *buf, size_t len) : _buf(buf), _len(len)
+    {
+    }
+
+    /**
+     * @brief the next item
+     * @return false at the end of the bytes (cut_getter()) or on bytes
+     *         that are not CBOR (bad_getter()); the position is kept
+     */
+    bool next(CborItem &it)
+    {
+        if (_pos >= _len)
+        {
+            _cut = true;
+            return false;
+        }
+        const uint8_t major = _buf[_pos] >> 5;
+        const uint8_t ai    = _buf[_pos] & 0x1FU;
+        size_t at           = _pos + 1U;
+        uint64_t arg        = ai;
+        if (ai >= 24U and ai <= 27U)
+        {
+            const size_t n = size_t{1} << (ai - 24U);
+            if (n > _len - at)
+            {
+                _cut = true;
+                return false;
+            }
+            arg = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                arg = (arg << 8) | _buf[at + i];
+            }
+            at += n;
+        }
+        else if (ai > 27U and (ai != 31U or major == 0U or major == 1U or major == 6U))
+        {
+            _bad = true;
+            return false;
+        }
+        it.open = ai == 31U;
+        it.u    = arg;
+
+        switch (major)
+        {
+        case 0: it.type = CborTypeEnum::UINT; break;
+        case 1: it.type = CborTypeEnum::NINT; break;
+        case 2:
+        case 3:
+            it.type = major == 2U ? CborTypeEnum::BYTES : CborTypeEnum::TEXT;
+            if (not it.open)
+            {
+                if (arg > _len - at)
+                {
+                    _cut = true;
+                    return false;
+                }
+                it.str = std::string_view(reinterpret_cast<const char *>(_buf + at), static_cast<size_t>(arg));
+                at += static_cast<size_t>(arg);
+            }
+            break;
+        case 4: it.type = CborTypeEnum::ARRAY; break;
+        case 5: it.type = CborTypeEnum::MAP; break;
+        case 6: it.type = CborTypeEnum::TAG; break;
+        default: simple(it, ai, arg); break;
+        }
+        _pos = at;
+        return true;
+    }
+
+    /**
+     * @brief the items inside the one next() just gave, skipped
+     * @return false as next() does
+     */
+    bool skip(const CborItem &it);
+
+    /**
+     * @brief a whole item, skipped
+     */
+    bool skip()
+    {
+        CborItem it{};
+        return next(it) and skip(it);
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] size_t pos_getter() const
+    {
+        return _pos;
+    }
+
+    [[nodiscard]] bool cut_getter() const
+    {
+        return _cut;
+    }
+
+    [[nodiscard]] bool bad_getter() const
+    {
+        return _bad;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    static void simple(CborItem &it, uint8_t ai, uint64_t arg);
+
+    const uint8_t *_buf;
+    size_t _len;
+    size_t _pos    = 0;
+    uint32_t _deep = 0;     // containers skip() is inside of
+    bool _cut      = false;
+    bool _bad      = false;
+};
+
+/**
+ * @brief bytes of the whole item at buf, nothing decoded
+ * @return 0 when buf holds only part of it, -1 when it is not CBOR
+ */
+long cbor_length(const uint8_t *buf, size_t len);
+
+/**
+ * @brief one decoded item, a tree
+ */
+struct CborValue
+{
+    using Type = CborTypeEnum;
+
+    Type type  = Type::UNDEFINED;
+    uint64_t u = 0;
+    double f   = 0.0;
+    bool b     = false;
+    std::string str;                // bytes or text, chunks joined
+    std::vector<CborValue> items;
+
+    [[nodiscard]] bool is_int() const
+    {
+        return type == Type::UINT or type == Type::NINT;
+    }
+
+    /**
+     * @brief an integer as a signed value, NINT beyond INT64_MIN wraps
+     */
+    [[nodiscard]] int64_t integer() const
+    {
+        return type == Type::NINT ? -1 - static_cast<int64_t>(u) : static_cast<int64_t>(u);
+    }
+
+    /**
+     * @brief the value of key k in a map, nullptr when there is none
+     */
+    [[nodiscard]] const CborValue *at(uint64_t k) const;
+
+    /**
+     * @brief diagnostic notation (RFC 8949 section 8), for messages
+     */
+    [[nodiscard]] std::string diag() const;
+};
+
+/**
+ * @brief decode the item at buf into a tree
+ * @return bytes it took, 0 when buf holds only part of it, -1 when it is not CBOR
+ */
+long cbor_decode(const uint8_t *buf, size_t len, CborValue &out);
+
+/**
+ * @brief what the stream hands to its user, called from feed()
+ */
+class ShellCborListener
+{
+  public:
+    virtual ~ShellCborListener() = default;
+
+    /**
+     * @brief one record of the request `tag`, 0 for a line that had none,
+     *        for CborReader or cbor_decode()
+     * @note  the bytes are the stream's, valid during the call only
+     */
+    virtual void on_record(uint32_t tag, const uint8_t *record, size_t len) = 0;
+
+    /**
+     * @brief the end line of the request `tag`, after its last record
+     */
+    virtual void on_done(uint32_t tag, bool ok, std::string_view detail)
+    {
+        (void)tag;
+        (void)ok;
+        (void)detail;
+    }
+
+    /**
+     * @brief any other line: log, telemetry, text replies
+     */
+    virtual void on_line(std::string_view line)
+    {
+        (void)line;
+    }
+};
+
+/**
+ * @brief demultiplexes the port: lines, frames, records
+ */
+class ShellCborStream
+{
+  public:
+    struct Stats
+    {
+        uint64_t frames;
+        uint64_t records;
+        uint64_t lines;
+        uint64_t payload;       // bytes of records
+        uint64_t badCrc;        // frames dropped, CRC or header wrong
+        uint64_t gaps;          // frames not where their tag's stream ended: the stream of the tag is dropped
+        uint64_t malformed;     // record streams that are not CBOR, dropped
+        uint64_t leftover;      // bytes of a tag's stream not making a whole record at its end line
+    };
+
+    explicit ShellCborStream(ShellCborListener &listener) : _listener(listener)
+    {
+    }
+
+    /**
+     * @brief the next bytes from the port
+     */
+    void feed(const uint8_t *buf, size_t len);
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    /**
+     * @brief the record stream of one tag, what is not decoded yet
+     */
+    struct Pending
+    {
+        std::vector<uint8_t> bytes;
+        size_t used    = 0;     // decoded already
+        size_t tried   = 0;     // bytes after used at the last try, not a whole record
+        uint64_t next  = 0;     // stream offset of the next frame
+        bool broken    = false; // a frame was lost: skip up to the end line
+    };
+
+    size_t frame(const uint8_t *p, size_t len);
+    size_t line(const uint8_t *p, size_t len);
+    void records(uint32_t tag, Pending &s);
+
+    ShellCborListener &_listener;
+    std::vector<uint8_t> _in;   // the start of a frame or a line, waiting for the rest
+    std::unordered_map<uint32_t, Pending> _tags;
+    Stats _stats = {};
+};
@@ -0,0 +1,392 @@
+/**
+ * @file        shell-client.cpp
+ * @brief       Host client of the device shell, see shell-client.hpp
+ *
+ * @author      MekLi
+ * @date        2025/9/10
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "shell-client.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+/**
+ * @brief map a memfd twice, back to back
+ */
+MirrorRing::MirrorRing(size_t size)
+{
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size              = (size + page - 1U) / page * page;
+
+    const int fd = memfd_create("shell-ring", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+    void *area = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+    {
+        area = mmap(nullptr, 2U * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (area != MAP_FAILED)
+    {
+        uint8_t *base = static_cast<uint8_t *>(area);
+        if (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED or
+            mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+        {
+            munmap(area, 2U * size);
+        }
+        else
+        {
+            _base = base;
+            _size = size;
+        }
+    }
+    ::close(fd);
+}
+
+
+MirrorRing::~MirrorRing()
+{
+    if (_base != nullptr)
+    {
+        munmap(_base, 2U * _size);
+    }
+}
+
+
+ShellClient::ShellClient(ShellListener &listener, uint32_t window, size_t ring)
+    : _listener(listener), _window(window != 0U ? window : 1U), _rx(ring), _tx(ring), _slots(4U * _window)
+{
+}
+
+
+ShellClient::~ShellClient()
+{
+    close();
+}
+
+
+/**
+ * @brief open a tty, raw and non blocking
+ */
+bool ShellClient::open(const char *path)
+{
+    const int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    termios tio{};
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        (void)tcsetattr(fd, TCSANOW, &tio);
+    }
+    return attach(fd);
+}
+
+
+/**
+ * @brief take over an open descriptor
+ */
+bool ShellClient::attach(int fd)
+{
+    close();
+    if (not _rx.valid() or not _tx.valid())
+    {
+        ::close(fd);
+        errno = ENOMEM;
+        return false;
+    }
+
+    const int flags = fcntl(fd, F_GETFL);
+    (void)fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    _ep = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = fd;
+    if (_ep < 0 or epoll_ctl(_ep, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        const int err = errno;
+        ::close(fd);
+        close();
+        errno = err;
+        return false;
+    }
+    _fd = fd;
+    return true;
+}
+
+
+void ShellClient::close()
+{
+    if (_ep >= 0)
+    {
+        ::close(_ep);
+    }
+    if (_fd >= 0)
+    {
+        ::close(_fd);
+    }
+    _ep       = -1;
+    _fd       = -1;
+    _wantOut  = false;
+    _inflight = 0;
+    _inBytes  = 0;
+    for (Slot &s : _slots)
+    {
+        s = {};
+    }
+}
+
+
+/**
+ * @brief format "!<tag> <command>\n" into the transmit ring
+ */
+uint32_t ShellClient::submit(std::string_view command)
+{
+    char prefix[16];
+    Slot *slot = nullptr;
+    for (uint32_t n = 0; slot == nullptr and n < _slots.size(); n++)
+    {
+        _nextTag = _nextTag != 0U ? _nextTag : 1U; // 0 marks a free slot
+        Slot &s  = _slots[_nextTag % _slots.size()];
+        if (s.tag == 0U)
+        {
+            slot = &s;
+        }
+        else
+        {
+            _nextTag++; // a slow command still holds this slot
+        }
+    }
+
+    const int plen     = snprintf(prefix, sizeof(prefix), "%c%u ", SHELL_TAG_MARK, _nextTag);
+    const size_t bytes = static_cast<size_t>(plen) + command.size() + 1U;
+    if (slot == nullptr or _fd < 0 or _inflight >= _window or bytes > SHELL_LINE_MAX or
+        _inBytes + bytes > SHELL_INFLIGHT or bytes > _tx.free_getter() or
+        command.find_first_of("\r\n") != std::string_view::npos)
+    {
+        return 0;
+    }
+
+    uint8_t *w = _tx.write_ptr();
+    memcpy(w, prefix, static_cast<size_t>(plen));
+    memcpy(w + plen, command.data(), command.size());
+    w[bytes - 1U] = '\n';
+    _tx.commit(bytes);
+
+    const uint32_t tag = _nextTag++;
+    *slot              = {tag, static_cast<uint32_t>(bytes)};
+    _inflight++;
+    _inBytes += static_cast<uint32_t>(bytes);
+    _stats.submitted++;
+    return tag;
+}
+
+
+/**
+ * @brief write what the transmit ring holds, in one system call when the tty takes it
+ * @return false when the device went away
+ */
+bool ShellClient::flush()
+{
+    while (_tx.used_getter() != 0U)
+    {
+        const ssize_t n = write(_fd, _tx.read_ptr(), _tx.used_getter());
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN)
+            {
+                return false;
+            }
+            break;
+        }
+        _stats.writes++;
+        _stats.bytesOut += static_cast<uint64_t>(n);
+        _tx.consume(static_cast<size_t>(n));
+    }
+
+    // wake up for room only while something waits for it
+    const bool want = _tx.used_getter() != 0U;
+    if (want != _wantOut)
+    {
+        epoll_event ev{};
+        ev.events  = EPOLLIN | (want ? static_cast<uint32_t>(EPOLLOUT) : 0U);
+        ev.data.fd = _fd;
+        (void)epoll_ctl(_ep, EPOLL_CTL_MOD, _fd, &ev);
+        _wantOut = want;
+    }
+    return true;
+}
+
+
+/**
+ * @brief read everything available into the receive ring
+ * @return bytes read, -1 when the device went away
+ */
+int ShellClient::drain()
+{
+    int total = 0;
+    while (_rx.free_getter() != 0U)
+    {
+        const ssize_t n = read(_fd, _rx.write_ptr(), _rx.free_getter());
+        if (n > 0)
+        {
+            _stats.reads++;
+            _stats.bytesIn += static_cast<uint64_t>(n);
+            _rx.commit(static_cast<size_t>(n));
+            total += static_cast<int>(n);
+            continue;
+        }
+        if (n < 0 and errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 and errno == EAGAIN)
+        {
+            break;
+        }
+        return -1; // end of file, or EIO once the other side of a pty closed
+    }
+    return total;
+}
+
+
+/**
+ * @brief hand every complete line to the listener
+ * @return lines delivered
+ */
+int ShellClient::dispatch()
+{
+    int lines = 0;
+    for (;;)
+    {
+        const char *base = reinterpret_cast<const char *>(_rx.read_ptr());
+        const size_t used = _rx.used_getter();
+        const void *nl    = memchr(base + _scanned, '\n', used - _scanned);
+        if (nl == nullptr)
+        {
+            _scanned = used;
+            if (_rx.free_getter() == 0U)
+            {
+                _stats.overlong++; // no line end in a whole ring: drop it
+                _rx.consume(used);
+                _scanned = 0;
+            }
+            return lines;
+        }
+
+        const size_t len = static_cast<size_t>(static_cast<const char *>(nl) - base) + 1U;
+        std::string_view line(base, len);
+        while (not line.empty() and (line.back() == '\n' or line.back() == '\r'))
+        {
+            line.remove_suffix(1);
+        }
+
+        ShellTagged t{};
+        if (not shell_parse_tagged(line, t) or t.kind == ' ')
+        {
+            _stats.telemetry++;
+            _listener.on_telemetry(line);
+        }
+        else
+        {
+            Slot &slot = _slots[t.tag % _slots.size()];
+            if (slot.tag != t.tag)
+            {
+                _stats.orphans++;
+            }
+            else if (t.kind == SHELL_BODY_MARK)
+            {
+                _listener.on_line(t.tag, t.rest);
+            }
+            else
+            {
+                const bool ok = t.rest == "ok";
+                std::string_view detail = t.rest;
+                if (not ok and detail.substr(0, 4) == "err ")
+                {
+                    detail.remove_prefix(4);
+                }
+                _inflight--;
+                _inBytes -= slot.bytes;
+                slot = {};
+                _stats.completed++;
+                _stats.failed += ok ? 0U : 1U;
+                _listener.on_done(t.tag, ok, detail);
+            }
+        }
+
+        _rx.consume(len);
+        _scanned = 0;
+        lines++;
+    }
+}
+
+
+/**
+ * @brief flush, wait for the device, deliver what came
+ */
+int ShellClient::poll(int timeoutMs)
+{
+    if (_fd < 0 or not flush())
+    {
+        return -1;
+    }
+
+    epoll_event ev[2];
+    const int n = epoll_wait(_ep, ev, 2, timeoutMs);
+    if (n < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    int lines = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if ((ev[i].events & EPOLLIN) != 0U)
+        {
+            const int got = drain();
+            lines += dispatch();
+            if (got < 0)
+            {
+                return -1;
+            }
+        }
+        else if ((ev[i].events & (EPOLLERR | EPOLLHUP)) != 0U)
+        {
+            return -1;
+        }
+        if ((ev[i].events & EPOLLOUT) != 0U and not flush())
+        {
+            return -1;
+        }
+    }
+
+    // replies may have opened the window: send what the listener queued
+    if (not flush())
+    {
+        return -1;
+    }
+    return lines;
+}
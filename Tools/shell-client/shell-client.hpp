@@ -0,0 +1,238 @@
+/**
+ * @file        shell-client.hpp
+ * @brief       Host client of the device shell: pipelined tagged commands and telemetry over the CDC tty
+ *
+ * @attention   Linux only (epoll, memfd). One ShellClient is driven by one
+ *              thread: submit() queues, poll() moves bytes and calls the
+ *              listener, from the thread that called poll().
+ *
+ * @note        What makes it fast compared with a blocking read() per byte
+ *              and a write() per command:
+ *
+ *                - commands are formatted straight into a transmit ring and
+ *                  leave in one write() per poll(), however many there are;
+ *                - up to `window` commands are in flight, their replies are
+ *                  matched by tag (Applications/Shell/shell-proto.hpp), the
+ *                  device never waits for the host between two commands;
+ *                - received bytes land in a ring mapped twice back to back,
+ *                  so every line is contiguous even across the wrap: the
+ *                  listener gets std::string_view into the ring, nothing is
+ *                  copied after read();
+ *                - the tty is raw and non blocking, epoll wakes the loop on
+ *                  data or on room to write.
+ *
+ * @author      MekLi
+ * @date        2025/9/10
+ * @version     1.0
+ */
+
+#pragma once
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-proto.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+/* ------- class prototypes ------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief byte ring mapped twice in a row, any readable or writable span is contiguous
+ */
+class MirrorRing
+{
+  public:
+    explicit MirrorRing(size_t size); // rounded up to the page size
+    ~MirrorRing();
+    MirrorRing(const MirrorRing &)            = delete;
+    MirrorRing &operator=(const MirrorRing &) = delete;
+
+    [[nodiscard]] bool valid() const
+    {
+        return _base != nullptr;
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] size_t size_getter() const
+    {
+        return _size;
+    }
+
+    [[nodiscard]] size_t used_getter() const
+    {
+        return _head - _tail;
+    }
+
+    [[nodiscard]] size_t free_getter() const
+    {
+        return _size - used_getter();
+    }
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint8_t *write_ptr() const
+    {
+        return _base + (_head % _size);
+    }
+
+    [[nodiscard]] const uint8_t *read_ptr() const
+    {
+        return _base + (_tail % _size);
+    }
+
+    void commit(size_t n)
+    {
+        _head += n;
+    }
+
+    void consume(size_t n)
+    {
+        _tail += n;
+    }
+
+  private:
+    uint8_t *_base = nullptr;
+    size_t _size   = 0;
+    uint64_t _head = 0;
+    uint64_t _tail = 0;
+};
+
+/**
+ * @brief what the client hands to its user, called from poll()
+ * @note  the views point into the receive ring, valid during the call only
+ */
+class ShellListener
+{
+  public:
+    virtual ~ShellListener() = default;
+
+    /**
+     * @brief one output line of the command `tag`
+     */
+    virtual void on_line(uint32_t tag, std::string_view text)
+    {
+        (void)tag;
+        (void)text;
+    }
+
+    /**
+     * @brief the command `tag` ended, `detail` is the reason of an error
+     */
+    virtual void on_done(uint32_t tag, bool ok, std::string_view detail) = 0;
+
+    /**
+     * @brief a line that is not a reply: log, telemetry, printf
+     */
+    virtual void on_telemetry(std::string_view line)
+    {
+        (void)line;
+    }
+};
+
+/**
+ * @brief pipelined client of the device shell
+ */
+class ShellClient
+{
+  public:
+    struct Stats
+    {
+        uint64_t submitted;
+        uint64_t completed;
+        uint64_t failed;        // ended with "err"
+        uint64_t telemetry;     // lines
+        uint64_t orphans;       // replies for a tag not in flight
+        uint64_t bytesIn;
+        uint64_t bytesOut;
+        uint64_t reads;         // system calls
+        uint64_t writes;
+        uint64_t overlong;      // lines longer than the receive ring, dropped
+    };
+
+    /**
+     * @param window commands in flight at most
+     * @param ring   bytes of each ring
+     */
+    ShellClient(ShellListener &listener, uint32_t window = 32, size_t ring = 1U << 16);
+    ~ShellClient();
+    ShellClient(const ShellClient &)            = delete;
+    ShellClient &operator=(const ShellClient &) = delete;
+
+    /**
+     * @brief open a tty (or the slave of a pty), raw and non blocking
+     * @return false with errno set
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief use a descriptor already open, the client owns it from now on
+     */
+    bool attach(int fd);
+
+    void close();
+
+    /**
+     * @brief queue a command line, it leaves at the next poll()
+     * @return its tag, 0 when the window is full, when SHELL_INFLIGHT
+     *         request bytes are unanswered, or for a line too long
+     */
+    uint32_t submit(std::string_view command);
+
+    /**
+     * @brief flush, wait up to timeoutMs for the device, deliver what came
+     * @return lines delivered, -1 when the device went away
+     */
+    int poll(int timeoutMs);
+
+    /****************** setter & getter *******************/
+
+    [[nodiscard]] uint32_t outstanding_getter() const
+    {
+        return _inflight;
+    }
+
+    [[nodiscard]] uint32_t window_getter() const
+    {
+        return _window;
+    }
+
+    [[nodiscard]] const Stats &stats_getter() const
+    {
+        return _stats;
+    }
+
+    /****************** setter & getter *******************/
+
+  private:
+    /**
+     * @brief a command in flight, in the slot tag % slots
+     */
+    struct Slot
+    {
+        uint32_t tag; // 0 when free
+        uint32_t bytes;
+    };
+
+    bool flush();
+    int drain();
+    int dispatch();
+
+    ShellListener &_listener;
+    uint32_t _window;
+    MirrorRing _rx;
+    MirrorRing _tx;
+    int _fd            = -1;
+    int _ep            = -1;
+    bool _wantOut      = false;
+    uint32_t _nextTag  = 1;
+    uint32_t _inflight = 0;
+    uint32_t _inBytes  = 0; // request bytes not answered yet
+    size_t _scanned    = 0; // bytes of the receive ring known to hold no line end
+    std::vector<Slot> _slots;
+    Stats _stats = {};
+};
@@ -0,0 +1,393 @@
+/**
+ * @file        shell-args-bench.cpp
+ * @brief       Host checks of the shell tokenizer and argument parsers, timed against the C library
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-args-bench [-n words]
+ *
+ *              Checks: words split in place with quotes and escapes, each one
+ *              '\0' terminated; the parsers take whole words and refuse
+ *              overflow and trailing garbage; a typed command gets its usage
+ *              line, or the argument that did not parse.
+ *
+ *              Then measures the cost per word (per line for split) of:
+ *
+ *                  split        shell_tokenize() against strtok_r()
+ *                  uint         shell_parse_uint() against strtoul()
+ *                  hex          shell_parse_hex() against strtoul(.., 16)
+ *                  int          shell_parse_int() against strtol()
+ *                  float        shell_parse_float() against strtof()
+ *                  scan         shell_parse_uint() against sscanf("%u")
+ *
+ *              The firmware links newlib-nano; the host library is glibc,
+ *              whose strto*() are faster than newlib's, so the ratios shown
+ *              are a lower bound of the target's.
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/12
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t words = 2000000;
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n words]\n"
+            "  checks the shell tokenizer and parsers and times them against strtol/strtof/sscanf\n",
+            argv0);
+}
+
+/**
+ * @brief the words of line, joined by '|', or "!reason"
+ */
+static std::string split(const std::string &line)
+{
+    char buf[SHELL_LINE_MAX];
+    memcpy(buf, line.data(), line.size());
+    ShellArgv args;
+    const char *err = shell_tokenize(buf, static_cast<uint32_t>(line.size()), args);
+    if (err != nullptr)
+    {
+        return std::string("!") + err;
+    }
+    std::string joined;
+    for (uint32_t i = 0; i < args.argc; i++)
+    {
+        const std::string_view w = args.argv[i];
+        if (w.data()[w.size()] != '\0')
+        {
+            fail("\"%s\": word %u not terminated", line.c_str(), i);
+        }
+        if (w.data() < buf or w.data() + w.size() > buf + line.size())
+        {
+            fail("\"%s\": word %u outside the line", line.c_str(), i);
+        }
+        joined += (i != 0U ? "|" : "") + std::string(w);
+    }
+    return joined;
+}
+
+static void expect_split(const std::string &line, const std::string &words)
+{
+    const std::string got = split(line);
+    if (got != words)
+    {
+        fail("split \"%s\" gave \"%s\", not \"%s\"", line.c_str(), got.c_str(), words.c_str());
+    }
+}
+
+template <typename T>
+static void expect_parse(bool (*parse)(std::string_view, T &), const char *word, bool ok, T want = T{})
+{
+    T v{};
+    const bool got = parse(word, v);
+    if (got != ok or (ok and v != want))
+    {
+        fail("parse \"%s\" gave %d %.9g, not %d %.9g", word, got, static_cast<double>(v), ok,
+             static_cast<double>(want));
+    }
+}
+
+static void expect_pin(const char *word, int port, int pin)
+{
+    ShellPin p{};
+    const bool ok = shell_parse_pin(word, p);
+    if (port < 0 ? ok : (not ok or static_cast<int>(p.port) != port or static_cast<int>(p.pin) != pin))
+    {
+        fail("pin \"%s\" gave %d %d.%d, not %d.%d", word, ok, static_cast<int>(p.port), static_cast<int>(p.pin),
+             port, pin);
+    }
+}
+
+
+/**
+ * @brief a typed command, keeps what it was called with
+ */
+static int32_t s_calledInt  = 0;
+static uint32_t s_calledOpt = 0;
+
+static const char *cmd_typed(ShellEngine &sh, ShellHex addr, int32_t delta, std::optional<uint32_t> count)
+{
+    s_calledInt = static_cast<int32_t>(addr.value) + delta;
+    s_calledOpt = count.value_or(1U);
+    sh.format(FMT("%d"), s_calledInt);
+    return nullptr;
+}
+
+static constexpr ShellCommand s_cmds[] = {
+    shell_command<cmd_typed>("typed", ""),
+};
+
+static constexpr ShellTable s_table(s_cmds);
+static_assert(s_table.valid(), "no perfect hash");
+static_assert(s_cmds[0].paramCount == 3U and s_cmds[0].required == 2U, "derived from the declaration");
+
+class CaptureOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        text.append(buf, len);
+    }
+
+    std::string text;
+};
+
+static void expect_reply(const char *in, const char *out)
+{
+    CaptureOutput cap;
+    ShellEngine sh(s_table.index(), cap);
+    sh.feed(reinterpret_cast<const uint8_t *>(in), static_cast<uint32_t>(strlen(in)));
+    if (cap.text != out)
+    {
+        fail("\"%s\" gave \"%s\", not \"%s\"", in, cap.text.c_str(), out);
+    }
+}
+
+
+/**
+ * @brief time one parser over the words, ns per word; sum keeps the results alive
+ */
+template <typename F>
+static double time_words(const std::vector<std::string> &words, F parse, uint64_t &sum)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.words; i++)
+    {
+        sum += parse(words[i & 4095U].c_str(), static_cast<uint32_t>(words[i & 4095U].size()));
+    }
+    return ns_since(t0, opt.words);
+}
+
+static void report(const char *what, double ours, double libc, const char *against)
+{
+    printf("%-6s %6.1f ns/word   %-10s %6.1f ns/word  (%.1fx)\n", what, ours, against, libc, libc / ours);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.words = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.words == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // the tokenizer
+    expect_split("", "");
+    expect_split(" \t ", "");
+    expect_split("md 24000000 16", "md|24000000|16");
+    expect_split("  echo\t\thi  ", "echo|hi");
+    expect_split("echo \"a b\" c", "echo|a b|c");
+    expect_split("echo 'a \\n b'", "echo|a \\n b");
+    expect_split("echo \"x\\\"y\\\\z\"", "echo|x\"y\\z");
+    expect_split("echo \"\\x41\\x7a\\t.\"", "echo|Az\t.");
+    expect_split("echo a\\ b", "echo|a b");
+    expect_split("echo pre\"mid dle\"post", "echo|premid dlepost");
+    expect_split("echo \"\" ''", "echo||");
+    expect_split("echo \"open", "!unterminated quote");
+    expect_split("echo 'open", "!unterminated quote");
+    expect_split("echo end\\", "!bad escape");
+    expect_split("echo \"\\x4\"", "!bad escape");
+    expect_split("echo \"\\xg0\"", "!bad escape");
+    expect_split("a b c d e f g h i j k l m n o p", "a|b|c|d|e|f|g|h|i|j|k|l|m|n|o|p");
+    expect_split("a b c d e f g h i j k l m n o p q", "!too many words");
+    {
+        const std::string full(SHELL_LINE_MAX - 1U, 'w');
+        expect_split(full, full);
+    }
+
+    // the parsers
+    expect_parse<uint32_t>(shell_parse_uint, "0", true, 0U);
+    expect_parse<uint32_t>(shell_parse_uint, "4294967295", true, 4294967295U);
+    expect_parse<uint32_t>(shell_parse_uint, "4294967296", false);
+    expect_parse<uint32_t>(shell_parse_uint, "0x1F", true, 31U);
+    expect_parse<uint32_t>(shell_parse_uint, "0x", false);
+    expect_parse<uint32_t>(shell_parse_uint, "12a", false);
+    expect_parse<uint32_t>(shell_parse_uint, "-1", false);
+    expect_parse<uint32_t>(shell_parse_uint, "", false);
+    expect_parse<int32_t>(shell_parse_int, "-2147483648", true, INT32_MIN);
+    expect_parse<int32_t>(shell_parse_int, "2147483647", true, INT32_MAX);
+    expect_parse<int32_t>(shell_parse_int, "2147483648", false);
+    expect_parse<int32_t>(shell_parse_int, "+7", true, 7);
+    expect_parse<int32_t>(shell_parse_int, "-", false);
+    expect_parse<int32_t>(shell_parse_int, "1 ", false);
+    expect_parse<uint32_t>(shell_parse_hex, "24000000", true, 0x24000000U);
+    expect_parse<uint32_t>(shell_parse_hex, "0xDeadBeef", true, 0xDEADBEEFU);
+    expect_parse<uint32_t>(shell_parse_hex, "123456789", false);
+    expect_parse<uint32_t>(shell_parse_hex, "12g", false);
+    expect_parse<float>(shell_parse_float, "1.5", true, 1.5F);
+    expect_parse<float>(shell_parse_float, "-0.25", true, -0.25F);
+    expect_parse<float>(shell_parse_float, ".5", true, 0.5F);
+    expect_parse<float>(shell_parse_float, "3.", true, 3.0F);
+    expect_parse<float>(shell_parse_float, "1e3", true, 1000.0F);
+    expect_parse<float>(shell_parse_float, "2.5E-2", true, 0.025F);
+    expect_parse<float>(shell_parse_float, "3.14159265358979", true, 3.14159265358979F);
+    expect_parse<float>(shell_parse_float, "1e39", false);
+    expect_parse<float>(shell_parse_float, "1e", false);
+    expect_parse<float>(shell_parse_float, ".", false);
+    expect_parse<float>(shell_parse_float, "1.2.3", false);
+    expect_parse<float>(shell_parse_float, "nan", false);
+    expect_parse<bool>(shell_parse_bool, "on", true, true);
+    expect_parse<bool>(shell_parse_bool, "0", true, false);
+    expect_parse<bool>(shell_parse_bool, "yes", false);
+    expect_pin("PC1", 3, 2);
+    expect_pin("pa15", 1, 16);
+    expect_pin("PH0", 8, 1);
+    expect_pin("PI0", -1, 0);
+    expect_pin("PA16", -1, 0);
+    expect_pin("PA01", -1, 0);
+    expect_pin("PA", -1, 0);
+    expect_pin("XA1", -1, 0);
+
+    // typed dispatch
+    expect_reply("!1 typed 10 -6\n", "!1:10\r\n!1=ok\r\n");
+    if (s_calledInt != 10 or s_calledOpt != 1U)
+    {
+        fail("typed 10 -6 called with %ld %lu", static_cast<long>(s_calledInt), static_cast<unsigned long>(s_calledOpt));
+    }
+    expect_reply("!2 typed 0x20 1 5\n", "!2:33\r\n!2=ok\r\n");
+    if (s_calledOpt != 5U)
+    {
+        fail("typed 0x20 1 5 called with count %lu", static_cast<unsigned long>(s_calledOpt));
+    }
+    expect_reply("!3 typed 10\n", "!3:usage: typed <hex> <int> [uint]\r\n!3=err missing argument\r\n");
+    expect_reply("!4 typed 1 2 3 4\n", "!4:usage: typed <hex> <int> [uint]\r\n!4=err too many arguments\r\n");
+    expect_reply("!5 typed 1 x\n", "!5:argument 2 <int>: \"x\"\r\n!5=err bad argument\r\n");
+    expect_reply("typed zz 1\n", "argument 1 <hex>: \"zz\"\r\nerr bad argument\r\n");
+    expect_reply("!6 typed \"1\n", "!6=err unterminated quote\r\n");
+
+    // the same words for every method
+    std::mt19937 rng(1);
+    std::vector<std::string> dec, hex, sdec, flt, lines;
+    for (uint32_t i = 0; i < 4096U; i++)
+    {
+        const uint32_t v = rng() >> (rng() % 32U);
+        dec.push_back(std::to_string(v));
+        char b[32];
+        snprintf(b, sizeof(b), "%lx", static_cast<unsigned long>(v));
+        hex.push_back(b);
+        sdec.push_back(std::to_string(static_cast<int32_t>(rng() >> (rng() % 32U))));
+        snprintf(b, sizeof(b), "%.*f", static_cast<int>(rng() % 5U), static_cast<double>(v % 100000U) / 7.0);
+        flt.push_back(b);
+        lines.push_back("md " + hex.back() + " " + dec.back() + " " + flt.back());
+    }
+
+    uint64_t ours = 0;
+    uint64_t libc = 0;
+    const double splitNs = time_words(lines, [](const char *s, uint32_t n) {
+        char buf[SHELL_LINE_MAX];
+        memcpy(buf, s, n);
+        ShellArgv args;
+        (void)shell_tokenize(buf, n, args);
+        return static_cast<uint64_t>(args.argc);
+    }, ours);
+    const double strtokNs = time_words(lines, [](const char *s, uint32_t n) {
+        char buf[SHELL_LINE_MAX];
+        memcpy(buf, s, n + 1U);
+        char *save    = nullptr;
+        uint64_t argc = 0;
+        for (char *w = strtok_r(buf, " \t", &save); w != nullptr; w = strtok_r(nullptr, " \t", &save))
+        {
+            argc++;
+        }
+        return argc;
+    }, libc);
+
+    const double uintNs = time_words(dec, [](const char *s, uint32_t n) {
+        uint32_t v = 0;
+        (void)shell_parse_uint(std::string_view(s, n), v);
+        return static_cast<uint64_t>(v);
+    }, ours);
+    const double strtoulNs = time_words(dec, [](const char *s, uint32_t) {
+        return static_cast<uint64_t>(strtoul(s, nullptr, 10));
+    }, libc);
+
+    const double hexNs = time_words(hex, [](const char *s, uint32_t n) {
+        uint32_t v = 0;
+        (void)shell_parse_hex(std::string_view(s, n), v);
+        return static_cast<uint64_t>(v);
+    }, ours);
+    const double strtoulHexNs = time_words(hex, [](const char *s, uint32_t) {
+        return static_cast<uint64_t>(strtoul(s, nullptr, 16));
+    }, libc);
+
+    const double intNs = time_words(sdec, [](const char *s, uint32_t n) {
+        int32_t v = 0;
+        (void)shell_parse_int(std::string_view(s, n), v);
+        return static_cast<uint64_t>(static_cast<uint32_t>(v));
+    }, ours);
+    const double strtolNs = time_words(sdec, [](const char *s, uint32_t) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(strtol(s, nullptr, 10)));
+    }, libc);
+
+    const double floatNs = time_words(flt, [](const char *s, uint32_t n) {
+        float v = 0.0F;
+        (void)shell_parse_float(std::string_view(s, n), v);
+        return static_cast<uint64_t>(std::lround(v * 8.0F));
+    }, ours);
+    const double strtofNs = time_words(flt, [](const char *s, uint32_t) {
+        return static_cast<uint64_t>(std::lround(strtof(s, nullptr) * 8.0F));
+    }, libc);
+
+    const double scanNs = time_words(dec, [](const char *s, uint32_t n) {
+        uint32_t v = 0;
+        (void)shell_parse_uint(std::string_view(s, n), v);
+        return static_cast<uint64_t>(v);
+    }, ours);
+    const double sscanfNs = time_words(dec, [](const char *s, uint32_t) {
+        unsigned v = 0;
+        (void)sscanf(s, "%u", &v);
+        return static_cast<uint64_t>(v);
+    }, libc);
+
+    if (ours != libc)
+    {
+        fail("the parsers and the C library disagree on the benchmark words");
+    }
+
+    report("split", splitNs, strtokNs, "strtok_r");
+    report("uint", uintNs, strtoulNs, "strtoul");
+    report("hex", hexNs, strtoulHexNs, "strtoul/16");
+    report("int", intNs, strtolNs, "strtol");
+    report("float", floatNs, strtofNs, "strtof");
+    report("scan", scanNs, sscanfNs, "sscanf");
+
+    return check_summary();
+}
@@ -0,0 +1,988 @@
+/**
+ * @file        shell-cbor-bench.cpp
+ * @brief       Host checks of the shell's machine mode and of its CBOR encoder, timed against text and regexes
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-cbor-bench [-n lines] [-r seed]
+ *
+ *              The encoder of Applications/Format/cbor.hpp is checked
+ *              against the examples of RFC 8949 appendix A, written into
+ *              a buffer that holds them and streamed through a buffer of
+ *              one byte; cbor_format() gives the typed arguments of a
+ *              format. The decoder of Tools/shell-client/shell-cbor takes
+ *              the same bytes back, every cut short prefix as incomplete,
+ *              and refuses what is not CBOR.
+ *
+ *              Then a session (shell-session.cpp unchanged) runs lines
+ *              through its engine. Checks: a batch "a ; b ; c" runs every
+ *              command, a person gets an "err" line per failure, a program
+ *              one end line with the first; `mode cbor` takes effect on the
+ *              next line, each command of it is one record {0: tag, 1:
+ *              index, 2: [body], 3: null or reason} in frames that are
+ *              never longer than SHELL_FRAME_MAX, their CRC and offsets
+ *              right, the end line after the last one; a line without a
+ *              tag gets records of tag 0 and no line; `dump` of 64 KB
+ *              comes back byte for byte; `sessions` shows the mode; an
+ *              engine without a frame refuses machine mode; the stream cut
+ *              in random pieces decodes the same, a corrupt frame is
+ *              counted and its tag dropped.
+ *
+ *              Then the comparison the mode is for: `adc` writes -n lines
+ *              of readings, in text mode as a program parses them today
+ *              (std::regex, or sscanf()) and in CBOR mode pulled with
+ *              CborReader: the values must agree; it prints the bytes on
+ *              the wire, the time of the shell and of the host per
+ *              reading, and checks that decoding beats the regexes.
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/21
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../host-test.hpp"
+#include "../shell-client/shell-cbor.hpp"
+#include "../../Applications/Format/cbor.hpp"
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../../Applications/Shell/shell-memory.hpp"
+#include "../../Applications/Shell/shell-session.hpp"
+#include "../../Applications/Update/fwu-proto.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <regex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t SRAM_BASE = 0x24000000U;
+constexpr uint32_t SRAM_SIZE = 64U * 1024U;
+constexpr uint32_t ROUNDS    = 5U;     // the best of
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t lines = 20000;
+    unsigned seed  = 1;
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n lines] [-r seed]\n"
+            "  checks the CBOR encoder, decoder and machine mode, and times them against text\n",
+            argv0);
+}
+
+static std::string hex_of(const uint8_t *p, size_t n)
+{
+    std::string s;
+    char two[3];
+    for (size_t i = 0; i < n; i++)
+    {
+        snprintf(two, sizeof(two), "%02x", p[i]);
+        s += two;
+    }
+    return s;
+}
+
+static std::vector<uint8_t> bytes_of(const char *hex)
+{
+    std::vector<uint8_t> b;
+    for (size_t i = 0; hex[i] != 0 and hex[i + 1U] != 0; i += 2U)
+    {
+        b.push_back(static_cast<uint8_t>(std::stoul(std::string(hex + i, 2), nullptr, 16)));
+    }
+    return b;
+}
+
+
+/**
+ * @brief what spills, gathered
+ */
+class Gather : public CborSpill
+{
+  public:
+    void spill(const uint8_t *buf, uint32_t len) override
+    {
+        bytes.insert(bytes.end(), buf, buf + len);
+        spills++;
+    }
+
+    std::vector<uint8_t> bytes;
+    uint32_t spills = 0;
+};
+
+/**
+ * @brief one example: how to write it, its bytes, its diagnostic notation
+ */
+struct Vector
+{
+    void (*write)(CborOut &out);
+    const char *hex;
+    const char *diag;
+};
+
+static const Vector s_vectors[] = {
+    {[](CborOut &o) { o.uinteger(0); }, "00", "0"},
+    {[](CborOut &o) { o.uinteger(1); }, "01", "1"},
+    {[](CborOut &o) { o.uinteger(10); }, "0a", "10"},
+    {[](CborOut &o) { o.uinteger(23); }, "17", "23"},
+    {[](CborOut &o) { o.uinteger(24); }, "1818", "24"},
+    {[](CborOut &o) { o.uinteger(25); }, "1819", "25"},
+    {[](CborOut &o) { o.uinteger(100); }, "1864", "100"},
+    {[](CborOut &o) { o.uinteger(1000); }, "1903e8", "1000"},
+    {[](CborOut &o) { o.uinteger(1000000); }, "1a000f4240", "1000000"},
+    {[](CborOut &o) { o.uinteger(1000000000000ULL); }, "1b000000e8d4a51000", "1000000000000"},
+    {[](CborOut &o) { o.uinteger(UINT64_MAX); }, "1bffffffffffffffff", "18446744073709551615"},
+    {[](CborOut &o) { o.integer(-1); }, "20", "-1"},
+    {[](CborOut &o) { o.integer(-10); }, "29", "-10"},
+    {[](CborOut &o) { o.integer(-100); }, "3863", "-100"},
+    {[](CborOut &o) { o.integer(-1000); }, "3903e7", "-1000"},
+    {[](CborOut &o) { o.integer(INT64_MIN); }, "3b7fffffffffffffff", "-9223372036854775808"},
+    {[](CborOut &o) { o.real(1.1); }, "fb3ff199999999999a", "1.1"},
+    {[](CborOut &o) { o.real(100000.0); }, "fa47c35000", "100000.0"},
+    {[](CborOut &o) { o.real(3.4028234663852886e+38); }, "fa7f7fffff", "3.4028234663852886e+38"},
+    {[](CborOut &o) { o.real(1.0e+300); }, "fb7e37e43c8800759c", "1e+300"},
+    {[](CborOut &o) { o.real(-4.1); }, "fbc010666666666666", "-4.1"},
+    {[](CborOut &o) { o.real(0.0); }, "fa00000000", "0.0"},       // the RFC's preferred form is a half, f90000
+    {[](CborOut &o) { o.real(INFINITY); }, "fa7f800000", "Infinity"},
+    {[](CborOut &o) { o.real(NAN); }, "fa7fc00000", "NaN"},
+    {[](CborOut &o) { o.boolean(false); }, "f4", "false"},
+    {[](CborOut &o) { o.boolean(true); }, "f5", "true"},
+    {[](CborOut &o) { o.null(); }, "f6", "null"},
+    {[](CborOut &o) { o.bytes("", 0); }, "40", "h''"},
+    {[](CborOut &o) { o.bytes("\x01\x02\x03\x04", 4); }, "4401020304", "h'01020304'"},
+    {[](CborOut &o) { o.text(""); }, "60", "\"\""},
+    {[](CborOut &o) { o.text("a"); }, "6161", "\"a\""},
+    {[](CborOut &o) { o.text("IETF"); }, "6449455446", "\"IETF\""},
+    {[](CborOut &o) { o.text("\"\\"); }, "62225c", "\"\\\"\\\\\""},
+    {[](CborOut &o) { o.text("\xc3\xbc"); }, "62c3bc", "\"\xc3\xbc\""},
+    {[](CborOut &o) { o.array(0); }, "80", "[]"},
+    {[](CborOut &o) {
+         o.array(3);
+         o.uinteger(1);
+         o.uinteger(2);
+         o.uinteger(3);
+     },
+     "83010203", "[1, 2, 3]"},
+    {[](CborOut &o) {
+         o.array(3);
+         o.uinteger(1);
+         o.array(2);
+         o.uinteger(2);
+         o.uinteger(3);
+         o.array(2);
+         o.uinteger(4);
+         o.uinteger(5);
+     },
+     "8301820203820405", "[1, [2, 3], [4, 5]]"},
+    {[](CborOut &o) {
+         o.array(25);
+         for (uint32_t i = 1; i <= 25U; i++)
+         {
+             o.uinteger(i);
+         }
+     },
+     "98190102030405060708090a0b0c0d0e0f101112131415161718181819",
+     "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25]"},
+    {[](CborOut &o) { o.map(0); }, "a0", "{}"},
+    {[](CborOut &o) {
+         o.map(2);
+         o.uinteger(1);
+         o.uinteger(2);
+         o.uinteger(3);
+         o.uinteger(4);
+     },
+     "a201020304", "{1: 2, 3: 4}"},
+    {[](CborOut &o) {
+         o.map(2);
+         o.text("a");
+         o.uinteger(1);
+         o.text("b");
+         o.array(2);
+         o.uinteger(2);
+         o.uinteger(3);
+     },
+     "a26161016162820203", "{\"a\": 1, \"b\": [2, 3]}"},
+    {[](CborOut &o) {
+         o.open_array();
+         o.uinteger(1);
+         o.array(2);
+         o.uinteger(2);
+         o.uinteger(3);
+         o.open_array();
+         o.uinteger(4);
+         o.uinteger(5);
+         o.close();
+         o.close();
+     },
+     "9f018202039f0405ffff", "[1, [2, 3], [4, 5]]"},
+    {[](CborOut &o) {
+         o.open_map();
+         o.text("Fun");
+         o.boolean(true);
+         o.text("Amt");
+         o.integer(-2);
+         o.close();
+     },
+     "bf6346756ef563416d7421ff", "{\"Fun\": true, \"Amt\": -2}"},
+    {[](CborOut &o) {
+         o.open_bytes();
+         o.bytes("\x01\x02", 2);
+         o.bytes("\x03\x04\x05", 3);
+         o.close();
+     },
+     "5f42010243030405ff", "h'0102030405'"},
+    {[](CborOut &o) {
+         o.open_text();
+         o.text("strea");
+         o.text("ming");
+         o.close();
+     },
+     "7f657374726561646d696e67ff", "\"streaming\""},
+};
+
+
+/**
+ * @brief the encoder and the decoder on the vectors of the RFC
+ */
+static void check_vectors()
+{
+    for (const Vector &v : s_vectors)
+    {
+        uint8_t buf[64];
+        CborOut whole(buf, sizeof(buf));
+        v.write(whole);
+        const std::string got = hex_of(buf, whole.len_getter());
+        if (got != v.hex or whole.dropped_getter() != 0U)
+        {
+            fail("%s encoded as %s, expected %s", v.diag, got.c_str(), v.hex);
+        }
+
+        uint8_t one;
+        Gather g;
+        CborOut streamed(&one, 1U, &g);
+        v.write(streamed);
+        streamed.flush();
+        if (hex_of(g.bytes.data(), g.bytes.size()) != v.hex or streamed.total_getter() != g.bytes.size())
+        {
+            fail("%s through a 1-byte buffer is %s", v.diag, hex_of(g.bytes.data(), g.bytes.size()).c_str());
+        }
+
+        const std::vector<uint8_t> b = bytes_of(v.hex);
+        CborValue value;
+        const long n = cbor_decode(b.data(), b.size(), value);
+        if (n != static_cast<long>(b.size()) or value.diag() != v.diag)
+        {
+            fail("%s decoded as %s, %ld of %zu bytes", v.hex, value.diag().c_str(), n, b.size());
+        }
+        for (size_t cut = 0; cut < b.size(); cut++)
+        {
+            if (cbor_decode(b.data(), cut, value) != 0)
+            {
+                fail("%s cut to %zu bytes is not incomplete", v.hex, cut);
+            }
+        }
+    }
+
+    for (const char *bad : {"ff", "1c", "5f01ff", "7f4161ff", "bf01ff", "1f"})
+    {
+        const std::vector<uint8_t> b = bytes_of(bad);
+        CborValue value;
+        const long n = cbor_decode(b.data(), b.size(), value);
+        if (n >= 0)
+        {
+            fail("%s decoded, %ld bytes", bad, n);
+        }
+    }
+    std::vector<uint8_t> deep(CBOR_DEPTH_MAX + 8U, 0x81U);
+    deep.push_back(0x00U);
+    CborValue value;
+    if (cbor_decode(deep.data(), deep.size(), value) != -1)
+    {
+        fail("%zu nested arrays decoded", deep.size() - 1U);
+    }
+
+    uint8_t small[4];
+    CborOut cut(small, sizeof(small));
+    cut.text("hello");
+    if (cut.len_getter() != 4U or cut.dropped_getter() != 2U)
+    {
+        fail("\"hello\" in 4 bytes: %u kept, %u dropped", cut.len_getter(), cut.dropped_getter());
+    }
+}
+
+
+enum class BenchColourEnum : int8_t
+{
+    RED = -2,
+    BLUE = 3,
+};
+
+/**
+ * @brief cbor_format(): the arguments, typed, in order
+ */
+static void check_format()
+{
+    uint8_t buf[128];
+    CborOut out(buf, sizeof(buf));
+    const char name[8] = "ch";
+    cbor_format(out, FMT("%s=%u %d %.2f %c %p %02x %s %i %d %u|%s"), name, 7U, -3, 2.5, 'Z',
+                reinterpret_cast<const void *>(0x1234), static_cast<uint8_t>(0xAB), std::string_view("sv"), true,
+                BenchColourEnum::RED, static_cast<int64_t>(-5000000000LL), static_cast<const char *>(nullptr));
+    CborValue v;
+    const long n = cbor_decode(buf, out.len_getter(), v);
+    const std::string want = "[\"ch\", 7, -3, 2.5, \"Z\", 4660, 171, \"sv\", true, -2, -5000000000, \"(null)\"]";
+    if (n != static_cast<long>(out.len_getter()) or v.diag() != want)
+    {
+        fail("cbor_format() gave %s, expected %s", v.diag().c_str(), want.c_str());
+    }
+
+    CborOut none(buf, sizeof(buf));
+    cbor_format(none, FMT("no arguments"));
+    if (hex_of(buf, none.len_getter()) != "80")
+    {
+        fail("cbor_format() without arguments gave %s", hex_of(buf, none.len_getter()).c_str());
+    }
+}
+
+
+/**
+ * @brief 64 KB of "AXI SRAM"
+ */
+class HostMemory : public ShellMemory
+{
+  public:
+    explicit HostMemory(std::mt19937 &rng) : ram(SRAM_SIZE)
+    {
+        for (uint8_t &b : ram)
+        {
+            b = static_cast<uint8_t>(rng());
+        }
+    }
+
+    const uint8_t *map(uint32_t addr, uint32_t len) override
+    {
+        if (addr - SRAM_BASE < SRAM_SIZE and len <= SRAM_SIZE - (addr - SRAM_BASE))
+        {
+            return &ram[addr - SRAM_BASE];
+        }
+        return nullptr;
+    }
+
+    bool read(uint32_t addr, uint32_t &word) override
+    {
+        if (addr - SRAM_BASE >= SRAM_SIZE)
+        {
+            return false;
+        }
+        memcpy(&word, &ram[addr - SRAM_BASE], 4);
+        return true;
+    }
+
+    bool write(uint32_t addr, uint32_t word) override
+    {
+        if (addr - SRAM_BASE >= SRAM_SIZE)
+        {
+            return false;
+        }
+        memcpy(&ram[addr - SRAM_BASE], &word, 4);
+        return true;
+    }
+
+    std::vector<uint8_t> ram;
+};
+
+/**
+ * @brief no worker ever runs: the checks here start no job
+ */
+class IdlePort : public ShellJobPort
+{
+  public:
+    void post() override
+    {
+    }
+
+    void *self() override
+    {
+        return this;
+    }
+
+    void wake(void *task) override
+    {
+        (void)task;
+    }
+
+    bool wait(uint32_t ms) override
+    {
+        (void)ms;
+        return false;
+    }
+};
+
+/**
+ * @brief the link, gathered: every write() is one message of the transmit queue
+ */
+class WireTransport : public ShellTransport
+{
+  public:
+    uint32_t read(uint8_t *buf, uint32_t len) override
+    {
+        (void)buf;
+        (void)len;
+        return 0;
+    }
+
+    void write(const char *buf, uint32_t len) override
+    {
+        wire.append(buf, len);
+        const bool frame = len != 0U and static_cast<uint8_t>(buf[0]) == SHELL_FRAME_MARK;
+        frames += frame ? 1U : 0U;
+        longest = frame and len > longest ? len : longest;
+    }
+
+    /**
+     * @brief what came since the last call
+     */
+    std::string take()
+    {
+        std::string s;
+        s.swap(wire);
+        return s;
+    }
+
+    std::string wire;
+    uint32_t frames  = 0;
+    uint32_t longest = 0;   // frame
+};
+
+
+/**
+ * @brief a reading of `adc`, the same on both sides
+ */
+struct Reading
+{
+    uint32_t ch;
+    int32_t mv;
+    double volts;
+    uint32_t raw;
+    std::string state;
+};
+
+static Reading reading_of(uint32_t i)
+{
+    const int32_t mv = static_cast<int32_t>((i * 37U) % 3800U) - 500;
+    return {i % 8U, mv, mv / 1000.0, i * 2654435761U, mv > 3000 ? "high" : "ok"};
+}
+
+/**
+ * @brief n readings, like a telemetry command prints them
+ */
+static const char *cmd_adc(ShellEngine &sh, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const Reading r = reading_of(i);
+        sh.format(FMT("ch%u %d mV %.3f V raw %08x %s"), r.ch, r.mv, r.volts, r.raw, r.state.c_str());
+    }
+    return nullptr;
+}
+
+static const char *cmd_echo(ShellEngine &sh, std::string_view word)
+{
+    sh.line(word);
+    return nullptr;
+}
+
+static constexpr ShellCommand s_cmds[] = {
+    shell_command<cmd_echo>("echo", ""),
+    shell_command<cmd_adc>("adc", ""),
+    shell_command<shell_mode>("mode", ""),
+    shell_command<shell_dump>("dump", ""),
+    shell_command<shell_sessions>("sessions", ""),
+};
+
+static constexpr ShellTable s_table(s_cmds);
+static_assert(s_table.valid(), "no perfect hash");
+static constexpr ShellIndex s_index = s_table.index();
+
+
+/**
+ * @brief one session on a gathered link
+ */
+struct Rig
+{
+    Rig() : session("bench", s_index, link, port)
+    {
+    }
+
+    /**
+     * @brief run the lines, as the far end sent them
+     */
+    std::string run(std::string_view lines)
+    {
+        session.engine_getter().feed(reinterpret_cast<const uint8_t *>(lines.data()),
+                                     static_cast<uint32_t>(lines.size()));
+        return link.take();
+    }
+
+    WireTransport link;
+    IdlePort port;
+    ShellSession session;
+};
+
+/**
+ * @brief the stream as a listener gets it, in diagnostic notation
+ */
+class Collect : public ShellCborListener
+{
+  public:
+    void on_record(uint32_t tag, const uint8_t *record, size_t len) override
+    {
+        (void)tag;
+        CborValue v;
+        if (cbor_decode(record, len, v) != static_cast<long>(len))
+        {
+            fail("a record the stream handed does not decode");
+        }
+        records.push_back(v.diag());
+        last = std::move(v);
+    }
+
+    void on_done(uint32_t tag, bool ok, std::string_view detail) override
+    {
+        done.push_back("!" + std::to_string(tag) + (ok ? " ok" : " err ") + std::string(detail));
+    }
+
+    void on_line(std::string_view line) override
+    {
+        lines.emplace_back(line);
+    }
+
+    std::vector<std::string> records;
+    std::vector<std::string> done;
+    std::vector<std::string> lines;
+    CborValue last;
+};
+
+static void expect(const char *what, const std::string &got, const std::string &want)
+{
+    if (got != want)
+    {
+        fail("%s: \"%s\", expected \"%s\"", what, got.c_str(), want.c_str());
+    }
+}
+
+static std::string joined(const std::vector<std::string> &v)
+{
+    std::string s;
+    for (const std::string &x : v)
+    {
+        s += (s.empty() ? "" : " | ") + x;
+    }
+    return s;
+}
+
+
+/**
+ * @brief batches in text mode, machine mode on a session
+ */
+static void check_session(std::mt19937 &rng)
+{
+    Rig rig;
+    ShellSession *const list[] = {&rig.session};
+    shell_sessions_bind(list, 1U);
+
+    expect("mode", rig.run("mode\n"), "text\r\n");
+    expect("batch of a person", rig.run("echo a ; nope ; echo b\n"), "a\r\nerr unknown command\r\nb\r\n");
+    expect("batch of a program", rig.run("!5 echo a ; nope ; echo b\n"), "!5:a\r\n!5:b\r\n!5=err unknown command\r\n");
+    expect("empty command", rig.run("!6 echo a ; ; echo b ;\n"), "!6:a\r\n!6:b\r\n!6=err empty command\r\n");
+    expect("last ;", rig.run("!7 echo a ;\n"), "!7:a\r\n!7=ok\r\n");
+    expect("mode cbor", rig.run("!8 mode cbor\n"), "!8=ok\r\n");
+
+    Collect c;
+    ShellCborStream stream(c);
+    std::string wire = rig.run("!9 echo hi ; nope ; adc 2\n");
+    stream.feed(reinterpret_cast<const uint8_t *>(wire.data()), wire.size());
+    expect("records of a batch", joined(c.records),
+           "{0: 9, 1: 0, 2: [\"hi\"], 3: null} | {0: 9, 1: 1, 2: [], 3: \"unknown command\"} | "
+           "{0: 9, 1: 2, 2: [[0, -500, -0.5, 0, \"ok\"], [1, -463, -0.463, 2654435761, \"ok\"]], 3: null}");
+    expect("end of a batch", joined(c.done), "!9 err unknown command");
+    if (wire.size() < 2U or wire.compare(wire.size() - 2U, 2U, "\r\n") != 0 or not c.lines.empty())
+    {
+        fail("machine mode: the end line is not last, or %zu other lines", c.lines.size());
+    }
+
+    c.records.clear();
+    c.done.clear();
+    wire = rig.run("echo untagged\nmode\n");
+    stream.feed(reinterpret_cast<const uint8_t *>(wire.data()), wire.size());
+    expect("lines without a tag", joined(c.records),
+           "{0: 0, 1: 0, 2: [\"untagged\"], 3: null} | {0: 0, 1: 0, 2: [\"cbor\"], 3: null}");
+    if (not c.done.empty() or not c.lines.empty())
+    {
+        fail("lines without a tag got end lines or text");
+    }
+
+    c.records.clear();
+    wire = rig.run("!10 sessions\n");
+    stream.feed(reinterpret_cast<const uint8_t *>(wire.data()), wire.size());
+    const CborValue *body = c.last.at(2U);
+    if (body == nullptr or body->items.size() != 1U or body->items[0].items.size() < 3U or
+        body->items[0].items[2].str != "cbor" or body->items[0].items[0].str != "*")
+    {
+        fail("sessions in machine mode: %s", c.records.empty() ? "nothing" : c.records.back().c_str());
+    }
+
+    std::mt19937 memRng(rng());
+    HostMemory mem(memRng);
+    shell_memory_bind(&mem);
+    rig.link.frames  = 0;
+    rig.link.longest = 0;
+    char line[64];
+    snprintf(line, sizeof(line), "!11 dump %08x %u raw\n", SRAM_BASE, SRAM_SIZE);
+    wire = rig.run(line);
+    stream.feed(reinterpret_cast<const uint8_t *>(wire.data()), wire.size());
+    body = c.last.at(2U);
+    if (body == nullptr or body->items.size() != 4U or body->items[0].u != SRAM_BASE or
+        body->items[1].str != std::string(mem.ram.begin(), mem.ram.end()) or body->items[2].u != SRAM_SIZE or
+        body->items[3].u != fwu_crc32(0, mem.ram.data(), SRAM_SIZE))
+    {
+        fail("dump in machine mode does not give the memory back");
+    }
+    if (rig.link.longest > SHELL_FRAME_MAX or rig.link.frames < SRAM_SIZE / SHELL_FRAME_DATA)
+    {
+        fail("dump: %u frames, the longest %u bytes", rig.link.frames, rig.link.longest);
+    }
+
+    // the same stream cut anywhere, then with one byte of a frame changed
+    wire = rig.run("!12 adc 300 ; dump 24000000 4000\n");
+    for (int pass = 0; pass < 2; pass++)
+    {
+        Collect cut;
+        ShellCborStream again(cut);
+        std::string w = wire;
+        if (pass == 1)
+        {
+            w[w.size() / 2U] = static_cast<char>(w[w.size() / 2U] ^ 0x40);
+        }
+        for (size_t at = 0; at < w.size();)
+        {
+            const size_t n = std::min<size_t>(1U + rng() % 100U, w.size() - at);
+            again.feed(reinterpret_cast<const uint8_t *>(w.data() + at), n);
+            at += n;
+        }
+        const ShellCborStream::Stats &st = again.stats_getter();
+        if (pass == 0 and (cut.records.size() != 2U or st.badCrc != 0U or st.gaps != 0U or cut.done.size() != 1U))
+        {
+            fail("stream in pieces: %zu records, %llu bad, %llu gaps", cut.records.size(),
+                 static_cast<unsigned long long>(st.badCrc), static_cast<unsigned long long>(st.gaps));
+        }
+        if (pass == 1 and (st.badCrc + st.malformed == 0U or cut.records.size() == 2U or cut.done.size() != 1U))
+        {
+            fail("a corrupt frame went unseen: %zu records, %llu bad", cut.records.size(),
+                 static_cast<unsigned long long>(st.badCrc));
+        }
+    }
+
+    wire = rig.run("!13 mode text\n");
+    stream.feed(reinterpret_cast<const uint8_t *>(wire.data()), wire.size());
+    expect("mode text, in machine mode", c.records.back(), "{0: 13, 1: 0, 2: [], 3: null}");
+    expect("text again", rig.run("!14 echo t\n"), "!14:t\r\n!14=ok\r\n");
+
+    WireTransport bare;
+    ShellEngine worker(s_index, bare);
+    worker.feed(reinterpret_cast<const uint8_t *>("mode cbor\n"), 10U);
+    expect("engine without a frame", bare.take(), "err no machine mode here\r\n");
+    shell_memory_bind(nullptr);
+    shell_sessions_bind(nullptr, 0U);
+}
+
+
+/**
+ * @brief what a program gets from the readings, either way
+ */
+struct Parsed
+{
+    std::vector<Reading> readings;
+    bool ended = false;
+};
+
+class AdcListener : public ShellCborListener
+{
+  public:
+    explicit AdcListener(Parsed &out) : _out(out)
+    {
+    }
+
+    /**
+     * @note  pulled item by item, no tree: {0: tag, 1: step, 2: [[ch, mV, V, raw, state] ...], 3: null}
+     */
+    void on_record(uint32_t tag, const uint8_t *record, size_t len) override
+    {
+        (void)tag;
+        CborReader r(record, len);
+        CborItem map{};
+        if (not r.next(map) or map.type != CborTypeEnum::MAP)
+        {
+            return;
+        }
+        for (uint64_t i = 0; i < map.u; i++)
+        {
+            CborItem key{};
+            CborItem val{};
+            if (not r.next(key) or not r.next(val))
+            {
+                return;
+            }
+            const bool ok = key.u == 2U and val.type == CborTypeEnum::ARRAY ? body(r, val) : r.skip(val);
+            if (not ok)
+            {
+                return;
+            }
+        }
+    }
+
+    void on_done(uint32_t tag, bool ok, std::string_view detail) override
+    {
+        (void)tag;
+        (void)detail;
+        _out.ended = ok;
+    }
+
+  private:
+    bool body(CborReader &r, const CborItem &list)
+    {
+        CborItem row{};
+        for (uint64_t i = 0; list.open or i < list.u; i++)
+        {
+            if (not r.next(row))
+            {
+                return false;
+            }
+            if (row.type == CborTypeEnum::BREAK)
+            {
+                break;
+            }
+            if (row.type != CborTypeEnum::ARRAY or row.u != 5U)
+            {
+                if (not r.skip(row))
+                {
+                    return false;
+                }
+                continue;
+            }
+            CborItem c[5];
+            for (CborItem &x : c)
+            {
+                if (not r.next(x))
+                {
+                    return false;
+                }
+            }
+            const int64_t mv = c[1].type == CborTypeEnum::NINT ? -1 - static_cast<int64_t>(c[1].u)
+                                                                : static_cast<int64_t>(c[1].u);
+            _out.readings.push_back({static_cast<uint32_t>(c[0].u), static_cast<int32_t>(mv), c[2].f,
+                                     static_cast<uint32_t>(c[3].u), std::string(c[4].str)});
+        }
+        return true;
+    }
+
+    Parsed &_out;
+};
+
+/**
+ * @brief the text as automation reads it today: a regex per line
+ */
+static void parse_regex(const std::string &wire, Parsed &out)
+{
+    static const std::regex body(R"(^!\d+:ch(\d+) (-?\d+) mV (-?[0-9.]+) V raw ([0-9a-f]{8}) (\w+)\r?$)");
+    static const std::regex end(R"(^!\d+=ok\r?$)");
+    size_t at = 0;
+    while (at < wire.size())
+    {
+        size_t nl = wire.find('\n', at);
+        nl        = nl == std::string::npos ? wire.size() : nl;
+        const std::string line(wire, at, nl - at);
+        std::smatch m;
+        if (std::regex_match(line, m, body))
+        {
+            out.readings.push_back({static_cast<uint32_t>(std::stoul(m[1])), std::stoi(m[2]), std::stod(m[3]),
+                                    static_cast<uint32_t>(std::stoul(m[4], nullptr, 16)), m[5]});
+        }
+        else if (std::regex_match(line, end))
+        {
+            out.ended = true;
+        }
+        at = nl + 1U;
+    }
+}
+
+/**
+ * @brief the same with sscanf(), what a careful C host would do
+ */
+static void parse_scanf(const std::string &wire, Parsed &out)
+{
+    const char *p   = wire.c_str();
+    const char *end = p + wire.size();
+    while (p < end)
+    {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        nl             = nl == nullptr ? end : nl;
+        char line[96]; // sscanf() runs strlen() over what it is given: one line, not the rest of the wire
+        const size_t n = std::min(static_cast<size_t>(nl - p), sizeof(line) - 1U);
+        memcpy(line, p, n);
+        line[n] = '\0';
+        unsigned tag;
+        unsigned ch;
+        int mv;
+        double v;
+        unsigned raw;
+        char state[16];
+        char ok[3];
+        if (sscanf(line, "!%u:ch%u %d mV %lf V raw %8x %15s", &tag, &ch, &mv, &v, &raw, state) == 6)
+        {
+            out.readings.push_back({ch, mv, v, raw, state});
+        }
+        else if (sscanf(line, "!%u=%2s", &tag, ok) == 2 and strcmp(ok, "ok") == 0)
+        {
+            out.ended = true;
+        }
+        p = nl + 1;
+    }
+}
+
+static void compare(const char *how, const Parsed &got, uint32_t n)
+{
+    if (got.readings.size() != n or not got.ended)
+    {
+        fail("%s: %zu readings of %u, %s", how, got.readings.size(), n, got.ended ? "ended" : "no end");
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const Reading want = reading_of(i);
+        const Reading &r   = got.readings[i];
+        if (r.ch != want.ch or r.mv != want.mv or std::fabs(r.volts - want.volts) > 0.0006 or r.raw != want.raw or
+            r.state != want.state)
+        {
+            fail("%s: reading %u is ch%u %d %f %08x %s", how, i, r.ch, r.mv, r.volts, r.raw, r.state.c_str());
+            return;
+        }
+    }
+}
+
+/**
+ * @brief `adc` both ways: the shell's time, the wire, the host's time
+ */
+static void bench()
+{
+    const uint32_t n = opt.lines;
+    char line[32];
+    snprintf(line, sizeof(line), "!1 adc %u\n", n);
+
+    double shellText = 1e30;
+    double shellCbor = 1e30;
+    double hostRegex = 1e30;
+    double hostScanf = 1e30;
+    double hostCbor  = 1e30;
+    std::string text;
+    std::string cbor;
+    for (uint32_t round = 0; round < ROUNDS; round++)
+    {
+        Rig rig;
+        auto t0   = Clock::now();
+        text      = rig.run(line);
+        shellText = std::min(shellText, ns_since(t0));
+        (void)rig.run("mode cbor\n");
+        t0        = Clock::now();
+        cbor      = rig.run(line);
+        shellCbor = std::min(shellCbor, ns_since(t0));
+
+        Parsed byRegex;
+        Parsed byScanf;
+        Parsed byCbor;
+        if (round == 0U or n <= 20000U)
+        {
+            t0 = Clock::now();
+            parse_regex(text, byRegex);
+            hostRegex = std::min(hostRegex, ns_since(t0));
+        }
+        t0 = Clock::now();
+        parse_scanf(text, byScanf);
+        hostScanf = std::min(hostScanf, ns_since(t0));
+        t0        = Clock::now();
+        AdcListener l(byCbor);
+        ShellCborStream stream(l);
+        stream.feed(reinterpret_cast<const uint8_t *>(cbor.data()), cbor.size());
+        hostCbor = std::min(hostCbor, ns_since(t0));
+
+        if (round == 0U)
+        {
+            compare("text, regex", byRegex, n);
+            compare("text, sscanf", byScanf, n);
+            compare("cbor", byCbor, n);
+        }
+    }
+
+    printf("\n%u readings of `adc`, best of %u\n", n, ROUNDS);
+    printf("  %-14s %10s %9s %16s %16s\n", "", "wire B", "B/reading", "shell ns/reading", "host ns/reading");
+    printf("  %-14s %10zu %9.1f %16.1f %16.1f\n", "text + regex", text.size(), static_cast<double>(text.size()) / n,
+           shellText / n, hostRegex / n);
+    printf("  %-14s %10zu %9.1f %16.1f %16.1f\n", "text + sscanf", text.size(), static_cast<double>(text.size()) / n,
+           shellText / n, hostScanf / n);
+    printf("  %-14s %10zu %9.1f %16.1f %16.1f\n", "cbor + decode", cbor.size(), static_cast<double>(cbor.size()) / n,
+           shellCbor / n, hostCbor / n);
+    if (hostCbor >= hostRegex)
+    {
+        fail("decoding CBOR (%.0f ns) is not faster than the regexes (%.0f ns)", hostCbor / n, hostRegex / n);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.lines = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.lines == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(opt.seed);
+    check_vectors();
+    check_format();
+    check_session(rng);
+    bench();
+
+    return check_summary();
+}
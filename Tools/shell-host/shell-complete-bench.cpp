@@ -0,0 +1,388 @@
+/**
+ * @file        shell-complete-bench.cpp
+ * @brief       Host checks of the shell Tab completion, and the prefix lookup timed against a linear scan
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-complete-bench [-w words] [-n lookups] [-r seed]
+ *
+ *              Checks: the compiler sorted the command names and the
+ *              argument words; the candidates and their common part for
+ *              names, pins, on|off and enum words, case folded; no list
+ *              for numbers, unknown commands, words past the arguments;
+ *              Tab in the line editor completes, rings, then lists.
+ *
+ *              Then measures, on a sorted list of generated words (the
+ *              table itself holds at most 254 names):
+ *
+ *                  range        shell_words_range() and the common prefix
+ *                               of the first and last candidate
+ *                  linear       every word compared with the prefix, the
+ *                               common prefix grown over the matches
+ *                  complete     shell_complete() on lines of the table
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/14
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../../Applications/Shell/shell-complete.hpp"
+#include "../../Applications/Shell/shell-editor.hpp"
+#include "../host-test.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+enum class ModeEnum
+{
+    FAST,
+    SLOW,
+    SAFE,
+};
+
+template <>
+struct ShellEnumWords<ModeEnum>
+{
+    static constexpr std::string_view name = "slow|fast|safe";
+    static constexpr ShellEnumWord<ModeEnum> list[] = {
+        {"slow", ModeEnum::SLOW},
+        {"fast", ModeEnum::FAST},
+        {"safe", ModeEnum::SAFE},
+    };
+};
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t words   = 20000;
+    uint32_t lookups = 2000000;
+    unsigned seed    = 1;
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-w words] [-n lookups] [-r seed]\n"
+            "  checks the shell completion and times the sorted prefix index against a linear scan\n",
+            argv0);
+}
+
+static const char *cmd_nop(ShellEngine &sh)
+{
+    (void)sh;
+    return nullptr;
+}
+
+static const char *cmd_pin(ShellEngine &sh, ShellPin pin, std::optional<ModeEnum> mode)
+{
+    (void)sh;
+    (void)pin;
+    (void)mode;
+    return nullptr;
+}
+
+static const char *cmd_led(ShellEngine &sh, bool on)
+{
+    (void)sh;
+    (void)on;
+    return nullptr;
+}
+
+static const char *cmd_md(ShellEngine &sh, ShellHex addr, std::optional<uint32_t> count)
+{
+    (void)sh;
+    (void)addr;
+    (void)count;
+    return nullptr;
+}
+
+static constexpr ShellCommand s_cmds[] = {
+    shell_command<cmd_nop>("help", ""),    shell_command<cmd_nop>("version", ""), shell_command<cmd_nop>("uptime", ""),
+    shell_command<cmd_nop>("usb", ""),     shell_command<cmd_nop>("storage", ""), shell_command<cmd_nop>("status", ""),
+    shell_command<cmd_nop>("start", ""),   shell_command<cmd_nop>("stop", ""),    shell_command<cmd_nop>("step", ""),
+    shell_command<cmd_pin>("pin", ""),     shell_command<cmd_led>("led", ""),     shell_command<cmd_md>("md", ""),
+    shell_command<cmd_nop>("mw", ""),      shell_command<cmd_nop>("log", ""),     shell_command<cmd_nop>("txq", ""),
+};
+
+static constexpr ShellTable s_table(s_cmds);
+static_assert(s_table.valid(), "no perfect hash");
+static constexpr ShellIndex s_index = s_table.index();
+
+static_assert(s_index.names.list[0] == "help" and s_index.names.list[14] == "version", "names sorted at compile time");
+static_assert(shell_words_range(s_index.names, "st").last - shell_words_range(s_index.names, "st").first == 5U,
+              "a range found at compile time");
+static_assert(SHELL_ENUM_SORTED<ModeEnum>.list[0] == "fast" and SHELL_PIN_NAMES.list[2] == "PA10", "words sorted");
+
+static bool sorted(const ShellWords &w)
+{
+    for (uint32_t i = 1; i < w.count; i++)
+    {
+        if (not shell_word_less(w.list[i - 1U], w.list[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief the candidates of line joined by spaces and their common part, "-" for no list
+ */
+static void expect(const char *line, const char *words, const char *common)
+{
+    ShellCompletion c{};
+    std::string got   = "-";
+    std::string share = "-";
+    if (shell_complete(s_index, line, c))
+    {
+        got.clear();
+        for (uint32_t i = c.range.first; i < c.range.last; i++)
+        {
+            got += (i != c.range.first ? " " : "") + std::string(c.words.list[i]);
+        }
+        share = c.range.first == c.range.last ? "" : std::string(c.words.list[c.range.first].substr(0, c.common));
+        if (c.start + c.typed != strlen(line))
+        {
+            fail("\"%s\": word at %u, %u bytes", line, c.start, c.typed);
+        }
+    }
+    if (got != words or share != common)
+    {
+        fail("\"%s\" gave \"%s\" / \"%s\", not \"%s\" / \"%s\"", line, got.c_str(), share.c_str(), words, common);
+    }
+}
+
+class CaptureOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        text.append(buf, len);
+    }
+
+    std::string text;
+};
+
+static void expect_tab(ShellEditor &ed, CaptureOutput &out, const std::string &keys, const char *line,
+                       const char *printed)
+{
+    out.text.clear();
+    ed.feed(reinterpret_cast<const uint8_t *>(keys.data()), static_cast<uint32_t>(keys.size()));
+    if (ed.line_getter() != line or out.text.find(printed) == std::string::npos)
+    {
+        fail("tab after \"%s\": line \"%.*s\", echo \"%s\"", keys.c_str(), static_cast<int>(ed.line_getter().size()),
+             ed.line_getter().data(), out.text.c_str());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "w:n:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'w': opt.words = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'n': opt.lookups = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.words == 0U or opt.lookups == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // the lists the compiler built
+    if (not sorted(s_index.names) or s_index.names.count != s_index.count)
+    {
+        fail("command names not sorted");
+    }
+    if (not sorted(ShellArg<ShellPin>::words) or ShellArg<ShellPin>::words.count != 128U or
+        not sorted(ShellArg<bool>::words) or not sorted(ShellArg<ModeEnum>::words))
+    {
+        fail("argument words not sorted");
+    }
+    for (uint32_t i = 0; i < 128U; i++)
+    {
+        ShellPin p{};
+        if (not shell_parse_pin(SHELL_PIN_NAMES.list[i], p))
+        {
+            fail("pin word \"%.*s\" does not parse", static_cast<int>(SHELL_PIN_NAMES.list[i].size()),
+                 SHELL_PIN_NAMES.list[i].data());
+        }
+    }
+
+    // names
+    expect("", "help led log md mw pin start status step stop storage txq uptime usb version", "");
+    expect("st", "start status step stop storage", "st");
+    expect("sta", "start status", "sta");
+    expect("star", "start", "start");
+    expect("US", "usb", "usb");
+    expect("u", "uptime usb", "u");
+    expect("x", "", "");
+    expect("  m", "md mw", "m");
+    // arguments
+    expect("pin pc1", "PC1 PC10 PC11 PC12 PC13 PC14 PC15", "PC1");
+    expect("pin  PH", "PH0 PH1 PH10 PH11 PH12 PH13 PH14 PH15 PH2 PH3 PH4 PH5 PH6 PH7 PH8 PH9", "PH");
+    expect("pin PC2", "PC2", "PC2");
+    expect("pin pc1 s", "safe slow", "s");
+    expect("pin pc1 F", "fast", "fast");
+    expect("pin pc1 fast x", "-", "-");
+    expect("led o", "off on", "o");
+    expect("led ", "0 1 false off on true", "");
+    expect("md 2400", "-", "-");
+    expect("md 24000000 1", "-", "-");
+    expect("nosuch x", "-", "-");
+    expect("help x", "-", "-");
+    {
+        ShellCompletion all{};
+        if (not shell_complete(s_index, "pin ", all) or all.range.last - all.range.first != 128U)
+        {
+            fail("\"pin \": not every pin");
+        }
+    }
+
+    // the editor
+    {
+        CaptureOutput out;
+        ShellEngine sh(s_index, out);
+        ShellEditor ed(sh, out);
+        expect_tab(ed, out, "pi\t", "pin ", "n ");
+        expect_tab(ed, out, "pc1\t", "pin pc1", "\a");
+        expect_tab(ed, out, "\t", "pin pc1", "PC1  PC10  PC11  PC12  PC13  PC14  PC15\r\n> pin pc1");
+        expect_tab(ed, out, "2\tt\t", "pin pc12 t", "\a");
+        expect_tab(ed, out, "\x7f" "f\t", "pin pc12 fast ", "ast ");
+        expect_tab(ed, out, "\x15" "s\t", "st", "t");
+        expect_tab(ed, out, "\t\t", "st", "start  status  step  stop  storage\r\n> st");
+        expect_tab(ed, out, "\x15" "pin \t", "pin P", "P");
+        expect_tab(ed, out, "\t\t", "pin P", "(64 more)");
+        expect_tab(ed, out, "\x15" "zz\t", "zz", "\a");
+    }
+
+    // a word list as large as a shell grows to, sorted like the compiler does
+    static const char *const parts[] = {"adc", "can", "clk", "dma", "eth", "fl",  "gpio", "i2c", "irq", "log",
+                                        "mem", "pwm", "rtc", "spi", "sd",  "tim", "uart", "usb", "wdg", "xspi"};
+    static const char *const verbs[] = {"_get", "_set", "_read", "_write", "_stat", "_reset", "_dump", "_cfg"};
+    std::mt19937 rng(opt.seed);
+    std::vector<std::string> store;
+    while (store.size() < opt.words)
+    {
+        store.push_back(std::string(parts[rng() % 20U]) + std::to_string(rng() % 8U) + verbs[rng() % 8U] +
+                        (rng() % 2U == 0U ? "" : std::string(verbs[rng() % 8U])));
+    }
+    std::vector<std::string_view> list(store.begin(), store.end());
+    std::sort(list.begin(), list.end(), shell_word_less);
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    const ShellWords big = {list.data(), static_cast<uint32_t>(list.size())};
+
+    std::vector<std::string> prefixes;
+    for (uint32_t i = 0; i < 4096U; i++)
+    {
+        const std::string_view w = list[rng() % list.size()];
+        prefixes.push_back(std::string(w.substr(0, 1U + rng() % w.size())));
+    }
+
+    uint64_t sumRange = 0;
+    auto t0           = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lookups; i++)
+    {
+        const std::string &p = prefixes[i & 4095U];
+        const ShellRange r   = shell_words_range(big, p);
+        uint32_t n           = 0;
+        const std::string_view a = big.list[r.first];
+        const std::string_view b = big.list[r.last - 1U];
+        while (n < a.size() and n < b.size() and shell_fold(a[n]) == shell_fold(b[n]))
+        {
+            n++;
+        }
+        sumRange += (r.last - r.first) * 1000U + n;
+    }
+    const double rangeNs = ns_since(t0, opt.lookups);
+
+    const uint32_t linearLookups = opt.lookups / 64U + 1U;
+    uint64_t sumLinear           = 0;
+    uint64_t sumCheck            = 0;
+    t0                           = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < linearLookups; i++)
+    {
+        const std::string &p = prefixes[i & 4095U];
+        uint32_t count       = 0;
+        std::string_view first;
+        uint32_t n = 0;
+        for (const std::string_view w : list)
+        {
+            if (shell_prefix_compare(w, p) != 0)
+            {
+                continue;
+            }
+            if (count++ == 0U)
+            {
+                first = w;
+                n     = static_cast<uint32_t>(w.size());
+            }
+            uint32_t k = 0;
+            while (k < n and k < w.size() and shell_fold(first[k]) == shell_fold(w[k]))
+            {
+                k++;
+            }
+            n = k;
+        }
+        sumLinear += count * 1000U + n;
+    }
+    const double linearNs = ns_since(t0, linearLookups);
+    for (uint32_t i = 0; i < linearLookups; i++)
+    {
+        const ShellRange r = shell_words_range(big, prefixes[i & 4095U]);
+        const std::string_view a = big.list[r.first];
+        const std::string_view b = big.list[r.last - 1U];
+        uint32_t n               = 0;
+        while (n < a.size() and n < b.size() and shell_fold(a[n]) == shell_fold(b[n]))
+        {
+            n++;
+        }
+        sumCheck += (r.last - r.first) * 1000U + n;
+    }
+    if (sumCheck != sumLinear)
+    {
+        fail("the range and the linear scan disagree");
+    }
+
+    static const char *const lines[] = {"st", "pin pc1", "pin PA1 s", "led o", "u", "md 24", "pin ", ""};
+    uint64_t sumComplete = 0;
+    t0                   = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lookups; i++)
+    {
+        ShellCompletion r{};
+        sumComplete += shell_complete(s_index, lines[i & 7U], r) ? r.range.last - r.range.first + r.common : 0U;
+    }
+    const double completeNs = ns_since(t0, opt.lookups);
+
+    printf("%zu words\n", list.size());
+    printf("range     %7.1f ns/prefix\n", rangeNs);
+    printf("linear    %7.1f ns/prefix  (%.0fx)\n", linearNs, linearNs / rangeNs);
+    printf("complete  %7.1f ns/line    (%lu)\n", completeNs, static_cast<unsigned long>(sumComplete + sumRange % 2U));
+
+    return check_summary();
+}
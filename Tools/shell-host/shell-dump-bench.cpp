@@ -0,0 +1,850 @@
+/**
+ * @file        shell-dump-bench.cpp
+ * @brief       Host checks of md, mw, dump and of the encoders under them, timed against other encoders
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-dump-bench [-b link_bytes_per_s] [-r seed]
+ *
+ *              The encoders of Applications/Format/encode.cpp are checked
+ *              against plain byte at a time encoders: every pair of bytes in
+ *              hexadecimal, every three bytes in base64, the RFC 4648
+ *              vectors, random data of every length up to 300 at every
+ *              alignment, and nothing written past the end.
+ *
+ *              The commands run unchanged in an engine over 320 KB of
+ *              random "AXI SRAM" at 0x24000000 and a register hole at
+ *              0x40000000 that faults. Their output goes through the
+ *              transmit scheduler with the sizes of txq-intf.h, the bulk
+ *              channel written in place like ShellTxqOutput does, staged
+ *              where a message would cross the end of the ring; the link
+ *              takes TXQ_BURST bytes whenever the shell waits for room.
+ *
+ *              Checks: md shows the words and their ASCII, "????????" and
+ *              "bus fault" for the hole, refuses an unaligned address; mw
+ *              writes the words; the 320 KB dump in hexadecimal, base64
+ *              and raw frames, tagged and not, decodes back to the memory,
+ *              every address and frame CRC right, the final CRC line
+ *              right and behind every bulk byte on the wire; every bulk
+ *              message is whole lines or one frame, at most
+ *              SHELL_BULK_MAX bytes, both in place and staged ones were
+ *              used for text; without a bulk channel the same lines come through
+ *              sh.line() and raw is refused; a dump of the hole or past
+ *              the memory is refused.
+ *
+ *              Then times the encoders on 320 KB against the lane
+ *              arithmetic (SWAR) ones they were chosen over, byte at a time
+ *              ones and snprintf(), and the whole dump of the
+ *              AXI SRAM per mode: the host time of the shell and the
+ *              time the bytes take on a link of -b bytes per second.
+ *
+ *              The default link is the USB port of the board, full speed
+ *              only (Device_Only_FS): 1.0 to 1.2 MB/s measured. There the
+ *              320 KB take about 0.74 s in hexadecimal (2.47 bytes on the
+ *              wire per byte), 0.43 s in base64 and 0.31 s raw: base64 or
+ *              raw is the way to dump the AXI SRAM well under a second.
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/19
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Format/encode.hpp"
+#include "../../Applications/Shell/shell-memory.hpp"
+#include "../../Applications/TxSched/tx-scheduler.hpp"
+#include "../../Applications/Update/fwu-proto.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+/* the values of txq-intf.h */
+#define INTERACTIVE_SIZE    1024U
+#define TELEMETRY_SIZE      4096U
+#define BULK_SIZE           8192U
+#define BURST               512U
+
+constexpr uint32_t SRAM_BASE = 0x24000000U;
+constexpr uint32_t SRAM_SIZE = 320U * 1024U;  // every other address faults
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t bps  = 1100000;    // the full-speed CDC port as measured, 1.0 to 1.2 MB/s
+    unsigned seed = 1;
+} opt;
+
+static const char s_hex_digits[]  = "0123456789abcdef";
+static const char s_b64_digits[]  = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-b link_bytes_per_s] [-r seed]\n"
+            "  checks md, mw, dump and the hex and base64 encoders, and times them\n",
+            argv0);
+}
+
+
+/**
+ * @brief the reference encoders: one table lookup per character
+ */
+static void ref_hex(char *out, const uint8_t *in, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        *out++ = s_hex_digits[in[i] >> 4];
+        *out++ = s_hex_digits[in[i] & 0xFU];
+    }
+}
+
+static uint32_t ref_base64(char *out, const uint8_t *in, uint32_t len)
+{
+    uint32_t p = 0;
+    for (uint32_t i = 0; i < len; i += 3U)
+    {
+        const uint32_t n = len - i < 3U ? len - i : 3U;
+        uint32_t x       = static_cast<uint32_t>(in[i]) << 16;
+        x |= n > 1U ? static_cast<uint32_t>(in[i + 1U]) << 8 : 0U;
+        x |= n > 2U ? in[i + 2U] : 0U;
+        out[p++] = s_b64_digits[(x >> 18) & 0x3FU];
+        out[p++] = s_b64_digits[(x >> 12) & 0x3FU];
+        out[p++] = n > 1U ? s_b64_digits[(x >> 6) & 0x3FU] : '=';
+        out[p++] = n > 2U ? s_b64_digits[x & 0x3FU] : '=';
+    }
+    return p;
+}
+
+/**
+ * @brief the lane arithmetic encoders (SWAR) encode.hpp was measured against
+ */
+static inline uint32_t swar_spread16(uint32_t z)
+{
+    return (z | (z << 8)) & 0x00FF00FFU;
+}
+
+static inline uint32_t swar_hex_lanes(uint32_t n)
+{
+    return n + 0x30303030U + (((n + 0x06060606U) >> 4) & 0x01010101U) * 39U;
+}
+
+static void swar_hex(char *out, const uint8_t *in, uint32_t len)
+{
+    for (; len >= 4U; len -= 4U, in += 4, out += 8)
+    {
+        uint32_t w;
+        memcpy(&w, in, 4);
+        const uint32_t hi = (w >> 4) & 0x0F0F0F0FU;
+        const uint32_t lo = w & 0x0F0F0F0FU;
+        const uint32_t a  = swar_hex_lanes(swar_spread16(hi & 0xFFFFU) | (swar_spread16(lo & 0xFFFFU) << 8));
+        const uint32_t b  = swar_hex_lanes(swar_spread16(hi >> 16) | (swar_spread16(lo >> 16) << 8));
+        memcpy(out, &a, 4);
+        memcpy(out + 4, &b, 4);
+    }
+    ref_hex(out, in, len);
+}
+
+static inline uint32_t swar_ge(uint32_t s, uint32_t k)
+{
+    return ((s + (0x80U - k) * 0x01010101U) >> 7) & 0x01010101U;
+}
+
+static void swar_base64(char *out, const uint8_t *in, uint32_t len)
+{
+    for (; len >= 3U; len -= 3U, in += 3, out += 4)
+    {
+        const uint32_t x = (static_cast<uint32_t>(in[0]) << 16) | (static_cast<uint32_t>(in[1]) << 8) | in[2];
+        const uint32_t s =
+            ((x >> 18) & 0x3FU) | ((x >> 4) & 0x3F00U) | ((x << 10) & 0x3F0000U) | ((x << 24) & 0x3F000000U);
+        const uint32_t c = s + 0x41414141U + 6U * swar_ge(s, 26U) + 3U * swar_ge(s, 63U) - 75U * swar_ge(s, 52U) -
+                           15U * swar_ge(s, 62U);
+        memcpy(out, &c, 4);
+    }
+    ref_base64(out, in, len);
+}
+
+static bool decode_hex(const std::string &text, std::vector<uint8_t> &out)
+{
+    if (text.size() % 2U != 0U)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); i += 2U)
+    {
+        const char *hi = strchr(s_hex_digits, text[i]);
+        const char *lo = strchr(s_hex_digits, text[i + 1U]);
+        if (hi == nullptr or lo == nullptr or text[i] == 0 or text[i + 1U] == 0)
+        {
+            return false;
+        }
+        out.push_back(static_cast<uint8_t>(((hi - s_hex_digits) << 4) | (lo - s_hex_digits)));
+    }
+    return true;
+}
+
+static bool decode_base64(const std::string &text, std::vector<uint8_t> &out)
+{
+    if (text.size() % 4U != 0U)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); i += 4U)
+    {
+        uint32_t x    = 0;
+        uint32_t pads = 0;
+        for (size_t k = 0; k < 4U; k++)
+        {
+            const char c = text[i + k];
+            const char *d = strchr(s_b64_digits, c);
+            if (c == '=' and k >= 2U)
+            {
+                pads++;
+                x <<= 6;
+                continue;
+            }
+            if (d == nullptr or c == 0 or pads != 0U)
+            {
+                return false;
+            }
+            x = (x << 6) | static_cast<uint32_t>(d - s_b64_digits);
+        }
+        out.push_back(static_cast<uint8_t>(x >> 16));
+        if (pads < 2U)
+        {
+            out.push_back(static_cast<uint8_t>(x >> 8));
+        }
+        if (pads < 1U)
+        {
+            out.push_back(static_cast<uint8_t>(x));
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief the encoders against the references
+ */
+static void check_encoders(std::mt19937 &rng)
+{
+    char got[1024];
+    char want[1024];
+
+    for (uint32_t v = 0; v < 0x10000U; v++)
+    {
+        const uint8_t in[2] = {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8)};
+        encode_hex(got, in, 2);
+        ref_hex(want, in, 2);
+        if (memcmp(got, want, 4) != 0)
+        {
+            fail("hex of %02x %02x is %.4s, expected %.4s", in[0], in[1], got, want);
+            break;
+        }
+    }
+    for (uint32_t v = 0; v < 0x1000000U; v++)
+    {
+        const uint8_t in[3] = {static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v)};
+        encode_base64(got, in, 3);
+        ref_base64(want, in, 3);
+        if (memcmp(got, want, 4) != 0)
+        {
+            fail("base64 of %06x is %.4s, expected %.4s", v, got, want);
+            break;
+        }
+    }
+
+    static const char *const rfc[][2] = {{"", ""},         {"f", "Zg=="},         {"fo", "Zm8="},
+                                         {"foo", "Zm9v"},  {"foob", "Zm9vYg=="},  {"fooba", "Zm9vYmE="},
+                                         {"foobar", "Zm9vYmFy"}};
+    for (const auto &v : rfc)
+    {
+        const uint32_t n = encode_base64(got, reinterpret_cast<const uint8_t *>(v[0]), strlen(v[0]));
+        if (std::string(got, n) != v[1])
+        {
+            fail("base64 of \"%s\" is \"%.*s\", expected \"%s\"", v[0], static_cast<int>(n), got, v[1]);
+        }
+    }
+
+    for (uint32_t v : {0x00000000U, 0x0123abcdU, 0xdeadbeefU, 0xffffffffU, 0x24000000U})
+    {
+        char text[9];
+        snprintf(text, sizeof(text), "%08x", v);
+        encode_hex_word(got, v);
+        if (memcmp(got, text, 8) != 0)
+        {
+            fail("word %s encoded as %.8s", text, got);
+        }
+    }
+
+    uint8_t data[300 + 8];
+    for (uint8_t &b : data)
+    {
+        b = static_cast<uint8_t>(rng());
+    }
+    for (uint32_t len = 0; len <= 300U; len++)
+    {
+        for (uint32_t at = 0; at < 8U; at++)
+        {
+            memset(got, '#', sizeof(got));
+            encode_hex(got + at, data + at, len);
+            ref_hex(want, data + at, len);
+            if (memcmp(got + at, want, 2U * len) != 0 or got[at + 2U * len] != '#')
+            {
+                fail("hex of %u bytes at +%u differs or overruns", len, at);
+            }
+
+            memset(got, '#', sizeof(got));
+            const uint32_t n = encode_base64(got + at, data + at, len);
+            const uint32_t m = ref_base64(want, data + at, len);
+            if (n != m or n != encode_base64_len(len) or memcmp(got + at, want, n) != 0 or got[at + n] != '#')
+            {
+                fail("base64 of %u bytes at +%u differs or overruns", len, at);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief 320 KB of RAM and a register hole
+ */
+class HostMemory : public ShellMemory
+{
+  public:
+    explicit HostMemory(std::mt19937 &rng) : ram(SRAM_SIZE)
+    {
+        for (uint8_t &b : ram)
+        {
+            b = static_cast<uint8_t>(rng());
+        }
+    }
+
+    const uint8_t *map(uint32_t addr, uint32_t len) override
+    {
+        if (addr - SRAM_BASE < SRAM_SIZE and len <= SRAM_SIZE - (addr - SRAM_BASE))
+        {
+            return &ram[addr - SRAM_BASE];
+        }
+        return nullptr;
+    }
+
+    bool read(uint32_t addr, uint32_t &word) override
+    {
+        if (addr - SRAM_BASE >= SRAM_SIZE)
+        {
+            return false;
+        }
+        memcpy(&word, &ram[addr - SRAM_BASE], 4);
+        return true;
+    }
+
+    bool write(uint32_t addr, uint32_t word) override
+    {
+        if (addr - SRAM_BASE >= SRAM_SIZE)
+        {
+            return false;
+        }
+        memcpy(&ram[addr - SRAM_BASE], &word, 4);
+        return true;
+    }
+
+    std::vector<uint8_t> ram;
+};
+
+
+/**
+ * @brief the shell port as ShellTxqOutput drives it: replies in the interactive
+ *        class, bulk messages in place or staged, and a link that drains a burst
+ *        whenever the shell waits
+ */
+class LinkOutput : public ShellOutput
+{
+  public:
+    explicit LinkOutput(bool bulk) : _bulk(bulk), _sched(config())
+    {
+    }
+
+    void write(const char *buf, uint32_t len) override
+    {
+        while (_sched.free_getter(0) < len)
+        {
+            pump();
+        }
+        (void)_sched.enqueue(0, reinterpret_cast<const uint8_t *>(buf), len, 0);
+    }
+
+    uint8_t *bulk_reserve(uint32_t len) override
+    {
+        if (not _bulk or len > SHELL_BULK_MAX)
+        {
+            return nullptr;
+        }
+        for (;;)
+        {
+            uint8_t *p = _sched.reserve(2, len);
+            _staged    = p == nullptr and _sched.free_getter(2) >= len;
+            if (p != nullptr or _staged)
+            {
+                _at = p != nullptr ? p : _stage;
+                return _at;
+            }
+            pump();
+        }
+    }
+
+    void bulk_commit(uint32_t len) override
+    {
+        messages.push_back(std::string(reinterpret_cast<const char *>(_at), len));
+        if (_staged)
+        {
+            staged++;
+            (void)_sched.enqueue(2, _stage, len, 0);
+        }
+        else
+        {
+            placed++;
+            (void)_sched.commit(2, len, 0);
+        }
+    }
+
+    void bulk_drain() override
+    {
+        while (_sched.queued_getter(2) != 0U)
+        {
+            pump();
+        }
+        drained = wire.size();
+    }
+
+    /**
+     * @brief everything still queued onto the wire
+     */
+    void flush()
+    {
+        while (not _sched.empty())
+        {
+            pump();
+        }
+    }
+
+    std::string wire;
+    std::vector<std::string> messages;  // the bulk messages as committed
+    uint32_t placed  = 0;
+    uint32_t staged  = 0;
+    size_t drained   = 0;               // wire bytes at the last bulk_drain()
+
+  private:
+    static const TxScheduler::ClassConfig (&config())[TxScheduler::CLASSES]
+    {
+        static uint8_t r0[INTERACTIVE_SIZE], r1[TELEMETRY_SIZE], r2[BULK_SIZE];
+        static const TxScheduler::ClassConfig cfg[TxScheduler::CLASSES] = {
+            {r0, INTERACTIVE_SIZE, 1U},
+            {r1, TELEMETRY_SIZE, 1024U},
+            {r2, BULK_SIZE, 512U},
+        };
+        return cfg;
+    }
+
+    void pump()
+    {
+        uint8_t burst[BURST];
+        const uint32_t n = _sched.dequeue(burst, BURST, 0);
+        wire.append(reinterpret_cast<const char *>(burst), n);
+    }
+
+    bool _bulk;
+    bool _staged = false;
+    uint8_t *_at = nullptr;
+    uint8_t _stage[SHELL_BULK_MAX];
+    TxScheduler _sched;
+};
+
+
+static constexpr ShellCommand s_cmds[] = {
+    shell_command<shell_md>("md", ""),
+    shell_command<shell_mw>("mw", ""),
+    shell_command<shell_dump>("dump", ""),
+};
+
+static constexpr ShellTable s_table(s_cmds);
+static_assert(s_table.valid(), "no perfect hash");
+static constexpr ShellIndex s_index = s_table.index();
+
+
+/**
+ * @brief run one command line on a fresh port
+ */
+static void run(LinkOutput &out, const std::string &line)
+{
+    ShellEngine sh(s_index, out);
+    sh.feed(reinterpret_cast<const uint8_t *>(line.data()), static_cast<uint32_t>(line.size()));
+    out.flush();
+}
+
+/**
+ * @brief the text lines of a wire without frames
+ */
+static std::vector<std::string> lines_of(const std::string &wire)
+{
+    std::vector<std::string> lines;
+    size_t at = 0;
+    while (at < wire.size())
+    {
+        const size_t end = wire.find("\r\n", at);
+        if (end == std::string::npos)
+        {
+            lines.push_back(wire.substr(at));
+            break;
+        }
+        lines.push_back(wire.substr(at, end - at));
+        at = end + 2U;
+    }
+    return lines;
+}
+
+static void expect_wire(const char *what, const std::string &got, const std::string &want)
+{
+    if (got != want)
+    {
+        fail("%s: \"%s\", expected \"%s\"", what, got.c_str(), want.c_str());
+    }
+}
+
+static std::string summary(const std::vector<uint8_t> &ram, uint32_t off, uint32_t len)
+{
+    char text[64];
+    snprintf(text, sizeof(text), "%u bytes crc32 %08x", len, fwu_crc32(0, &ram[off], len));
+    return text;
+}
+
+
+/**
+ * @brief md and mw
+ */
+static void check_words(HostMemory &mem)
+{
+    uint8_t w[8] = {'A', 'B', 'C', 'D', 0x00, 0x7F, 'x', 0x80};
+    memcpy(&mem.ram[0x100], w, sizeof(w));
+
+    LinkOutput out(true);
+    run(out, "!5 md 24000100 2\n");
+    expect_wire("md", out.wire, "!5:24000100: 44434241 80787f00 |ABCD..x.|\r\n!5=ok\r\n");
+
+    LinkOutput more(true);
+    run(more, "md 24000100 5\n");
+    const std::vector<std::string> lines = lines_of(more.wire);
+    if (lines.size() != 2U or lines[1].rfind("24000110: ", 0) != 0U or lines[1].size() != 10U + 8U + 7U)
+    {
+        fail("md of 5 words: \"%s\"", more.wire.c_str());
+    }
+
+    LinkOutput hole(true);
+    run(hole, "!6 md 3ffffffc 2\n");
+    if (hole.wire.find("3ffffffc: ???????? ???????? |????????|") == std::string::npos or
+        hole.wire.find("!6=err bus fault") == std::string::npos)
+    {
+        fail("md of the hole: \"%s\"", hole.wire.c_str());
+    }
+
+    LinkOutput odd(true);
+    run(odd, "!7 md 24000102\n");
+    expect_wire("md unaligned", odd.wire, "!7=err address not word aligned\r\n");
+
+    LinkOutput end(true);
+    run(end, "!8 md fffffff0 5\n");
+    expect_wire("md past the end", end.wire, "!8=err past the end of the address space\r\n");
+
+    LinkOutput wr(true);
+    run(wr, "!9 mw 24000200 deadbeef 3\n");
+    uint32_t words[4];
+    memcpy(words, &mem.ram[0x200], sizeof(words));
+    if (wr.wire != "!9=ok\r\n" or words[0] != 0xdeadbeefU or words[2] != 0xdeadbeefU or words[3] == 0xdeadbeefU)
+    {
+        fail("mw: \"%s\", %08x %08x %08x", wr.wire.c_str(), words[0], words[2], words[3]);
+    }
+
+    LinkOutput wh(true);
+    run(wh, "!10 mw 40000000 1\n");
+    expect_wire("mw of the hole", wh.wire, "!10:bus fault at 40000000\r\n!10=err bus fault\r\n");
+}
+
+
+/**
+ * @brief every bulk message is whole lines, or one frame
+ */
+static void check_messages(const char *what, const LinkOutput &out, bool raw)
+{
+    for (const std::string &m : out.messages)
+    {
+        if (m.size() > SHELL_BULK_MAX)
+        {
+            fail("%s: a bulk message of %zu bytes", what, m.size());
+            return;
+        }
+        const bool whole = raw ? static_cast<uint8_t>(m[0]) == SHELL_FRAME_MARK
+                               : m.size() >= 2U and m.compare(m.size() - 2U, 2, "\r\n") == 0;
+        if (not whole)
+        {
+            fail("%s: a bulk message is not whole", what);
+            return;
+        }
+    }
+    // a frame of SHELL_BULK_MAX bytes never crosses the end of the ring, lines do
+    if (out.placed == 0U or (not raw and out.staged == 0U))
+    {
+        fail("%s: %u messages in place, %u staged, both ways expected", what, out.placed, out.staged);
+    }
+}
+
+
+/**
+ * @brief a text dump decodes back to the memory
+ */
+static void check_text_dump(HostMemory &mem, ShellDumpModeEnum mode, bool tagged, bool bulk)
+{
+    const bool hex       = mode == ShellDumpModeEnum::HEX;
+    const char *const word = hex ? "hex" : "base64";
+    char what[64];
+    snprintf(what, sizeof(what), "dump %s%s%s", word, tagged ? " tagged" : "", bulk ? "" : " without bulk");
+
+    LinkOutput out(bulk);
+    run(out, std::string(tagged ? "!3 " : "") + "dump 24000000 327680 " + word + "\n");
+    std::vector<std::string> lines = lines_of(out.wire);
+    const std::string mark         = tagged ? "!3:" : "";
+    const std::string end          = summary(mem.ram, 0, SRAM_SIZE);
+
+    if (lines.size() < 2U or lines[lines.size() - (tagged ? 2U : 1U)] != mark + end or
+        (tagged and lines.back() != "!3=ok"))
+    {
+        fail("%s: ends with \"%s\"", what, lines.empty() ? "" : lines.back().c_str());
+        return;
+    }
+    if (bulk and (out.drained == 0U or out.wire.rfind(mark + end) < out.drained))
+    {
+        fail("%s: the crc line overtook bulk bytes", what);
+    }
+
+    std::vector<uint8_t> back;
+    const uint32_t row = hex ? SHELL_DUMP_HEX_ROW : SHELL_DUMP_B64_ROW;
+    for (size_t i = 0; i + (tagged ? 2U : 1U) < lines.size(); i++)
+    {
+        if (lines[i].compare(0, mark.size(), mark) != 0)
+        {
+            fail("%s: line %zu \"%s\" without its mark", what, i, lines[i].c_str());
+            return;
+        }
+        std::string text = lines[i].substr(mark.size());
+        if (hex)
+        {
+            char addr[16];
+            snprintf(addr, sizeof(addr), "%08x: ", SRAM_BASE + static_cast<uint32_t>(i) * row);
+            if (text.compare(0, 10, addr) != 0)
+            {
+                fail("%s: line %zu is \"%s\", expected address %s", what, i, text.c_str(), addr);
+                return;
+            }
+            text = text.substr(10);
+        }
+        if (not(hex ? decode_hex(text, back) : decode_base64(text, back)))
+        {
+            fail("%s: line %zu \"%s\" does not decode", what, i, text.c_str());
+            return;
+        }
+    }
+    if (back != mem.ram)
+    {
+        fail("%s: %zu bytes decoded, not the memory", what, back.size());
+    }
+    if (bulk)
+    {
+        check_messages(what, out, false);
+    }
+}
+
+
+/**
+ * @brief a raw dump rebuilds the memory from its frames
+ */
+static void check_raw_dump(HostMemory &mem, uint32_t off, uint32_t len)
+{
+    LinkOutput out(true);
+    char line[64];
+    snprintf(line, sizeof(line), "!4 dump %08x %u raw\n", SRAM_BASE + off, len);
+    run(out, line);
+
+    std::vector<uint8_t> back;
+    size_t at = 0;
+    while (at < out.wire.size() and static_cast<uint8_t>(out.wire[at]) == SHELL_FRAME_MARK)
+    {
+        ShellFrameHdr h;
+        const auto *p = reinterpret_cast<const uint8_t *>(out.wire.data()) + at;
+        if (not shell_parse_frame(p, static_cast<uint32_t>(out.wire.size() - at), h) or h.kind != SHELL_FRAME_DUMP or
+            h.tag != 4U or at + sizeof(h) + h.len > out.wire.size())
+        {
+            fail("raw dump: a bad frame at wire byte %zu", at);
+            return;
+        }
+        if (h.addr != SRAM_BASE + off + back.size() or fwu_crc32(0, p + sizeof(h), h.len) != h.crc)
+        {
+            fail("raw dump: frame at %08x, CRC %08x, expected %08x", h.addr, h.crc,
+                 SRAM_BASE + off + static_cast<uint32_t>(back.size()));
+            return;
+        }
+        back.insert(back.end(), p + sizeof(h), p + sizeof(h) + h.len);
+        at += sizeof(h) + h.len;
+    }
+    expect_wire("raw dump end", out.wire.substr(at), "!4:" + summary(mem.ram, off, len) + "\r\n!4=ok\r\n");
+    if (back != std::vector<uint8_t>(mem.ram.begin() + off, mem.ram.begin() + off + len))
+    {
+        fail("raw dump: %zu bytes rebuilt, not the memory", back.size());
+    }
+    if (len == SRAM_SIZE)
+    {
+        check_messages("raw dump", out, true);
+    }
+}
+
+
+/**
+ * @brief what dump refuses
+ */
+static void check_refused()
+{
+    LinkOutput nobulk(false);
+    run(nobulk, "!1 dump 24000000 64 raw\n");
+    expect_wire("raw without bulk", nobulk.wire, "!1=err raw needs the shell port\r\n");
+
+    LinkOutput hole(true);
+    run(hole, "!2 dump 40000000 16\n");
+    expect_wire("dump of the hole", hole.wire, "!2=err not memory, use md\r\n");
+
+    LinkOutput past(true);
+    run(past, "!3 dump 2404fff0 32\n");
+    expect_wire("dump past the memory", past.wire, "!3=err not memory, use md\r\n");
+
+    LinkOutput small(true);
+    run(small, "dump 24000000 5\n");
+    if (small.wire.rfind("24000000: ", 0) != 0U or small.wire.find("\r\n5 bytes crc32 ") == std::string::npos)
+    {
+        fail("dump of 5 bytes: \"%s\"", small.wire.c_str());
+    }
+}
+
+
+/**
+ * @brief the encoders on 320 KB, MB/s of input
+ */
+static void measure_encoders(const HostMemory &mem)
+{
+    static char text[2U * SRAM_SIZE + 16U];
+    const uint8_t *src = mem.ram.data();
+    const uint32_t reps = 20;
+    uint64_t sum        = 0;
+
+    auto rate = [&](const char *what, auto encode) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < reps; r++)
+        {
+            encode();
+            sum += static_cast<uint8_t>(text[r]);
+        }
+        const double mbs = static_cast<double>(SRAM_SIZE) * reps / (ns_since(t0) / 1e9) / 1e6;
+        printf("  %-22s %8.0f MB/s\n", what, mbs);
+        return mbs;
+    };
+
+    printf("encoders, 320 KB in, host\n");
+    const double hex = rate("hex encode.hpp", [&] { encode_hex(text, src, SRAM_SIZE); });
+    const double swarHex = rate("hex swar lanes", [&] { swar_hex(text, src, SRAM_SIZE); });
+    rate("hex byte at a time", [&] { ref_hex(text, src, SRAM_SIZE); });
+    rate("hex snprintf", [&] {
+        for (uint32_t i = 0; i < SRAM_SIZE; i++)
+        {
+            snprintf(&text[2U * i], 3, "%02x", src[i]);
+        }
+    });
+    const double b64     = rate("base64 encode.hpp", [&] { encode_base64(text, src, SRAM_SIZE); });
+    const double swarB64 = rate("base64 swar lanes", [&] { swar_base64(text, src, SRAM_SIZE); });
+    rate("base64 byte at a time", [&] { ref_base64(text, src, SRAM_SIZE); });
+    printf("  encode.hpp against swar: hex %.2fx, base64 %.2fx (%llu)\n", hex / swarHex, b64 / swarB64,
+           static_cast<unsigned long long>(sum & 1U));
+}
+
+
+/**
+ * @brief the whole AXI SRAM per mode: shell time on the host, bytes and time on the link
+ */
+static void measure_dumps()
+{
+    printf("dump of the 320 KB AXI SRAM, tagged, link %u B/s\n", opt.bps);
+    const char *const modes[] = {"hex", "base64", "raw"};
+    for (const char *mode : modes)
+    {
+        LinkOutput out(true);
+        const auto t0 = std::chrono::steady_clock::now();
+        run(out, std::string("!1 dump 24000000 327680 ") + mode + "\n");
+        const double ms = ns_since(t0) / 1e6;
+        printf("  %-7s %8zu bytes on the wire (%.2fx)  shell %6.2f ms on the host  link %6.3f s\n", mode,
+               out.wire.size(), static_cast<double>(out.wire.size()) / SRAM_SIZE, ms,
+               static_cast<double>(out.wire.size()) / opt.bps);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "b:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'b': opt.bps = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.bps == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(opt.seed);
+    check_encoders(rng);
+
+    HostMemory mem(rng);
+    shell_memory_bind(&mem);
+    check_words(mem);
+    for (ShellDumpModeEnum mode : {ShellDumpModeEnum::HEX, ShellDumpModeEnum::BASE64})
+    {
+        check_text_dump(mem, mode, true, true);
+        check_text_dump(mem, mode, false, true);
+        check_text_dump(mem, mode, true, false);
+    }
+    check_raw_dump(mem, 0, SRAM_SIZE);
+    check_raw_dump(mem, 3, 1000);
+    check_raw_dump(mem, 0, 0);
+    check_refused();
+
+    measure_encoders(mem);
+    measure_dumps();
+
+    return check_summary();
+}
@@ -0,0 +1,697 @@
+/**
+ * @file        shell-editor-bench.cpp
+ * @brief       Host checks of the shell line editor on a VT100 screen model, and the echo it costs per edit
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-editor-bench [-n keys] [-r seed]
+ *
+ *              The echo goes to a one line VT100 model (printable bytes, \b,
+ *              \r, \n, BEL, ESC[nC, ESC[nD, ESC[K, ESC[H, ESC[2J): after
+ *              every scripted key the row on the model must be the prompt
+ *              and the line of the editor, its cursor at the editor's.
+ *
+ *              Checks: cursor, delete, cut and history keys, search, ^C,
+ *              ^L, escape sequences split across packets, "\r\n" as one
+ *              line end, the length limit, tagged lines passed to the
+ *              engine without echo, pastes of many lines, the history ring
+ *              when it wraps; then a random key mix against a std::string
+ *              model of the same edits.
+ *
+ *              Then counts the echo per edit, one key per USB packet,
+ *              against redrawing the line at every key (\r, prompt, line,
+ *              ESC[K, cursor back), and the writes of a pasted script.
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/13
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../../Applications/Shell/shell-editor.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+#define LEFT    "\x1b[D"
+#define RIGHT   "\x1b[C"
+#define UP      "\x1b[A"
+#define DOWN    "\x1b[B"
+#define HOME    "\x1b[H"
+#define END     "\x1bOF"
+#define DEL     "\x1b[3~"
+#define BS      "\x7f"
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t keys = 200000;
+    unsigned seed = 1;
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n keys] [-r seed]\n"
+            "  checks the shell line editor on a VT100 model and counts its echo per edit\n",
+            argv0);
+}
+
+/**
+ * @brief the escape sequences the editor may send, on one row and the rows above
+ */
+class Screen
+{
+  public:
+    void apply(const char *buf, uint32_t len)
+    {
+        for (uint32_t i = 0; i < len; i++)
+        {
+            byte(static_cast<uint8_t>(buf[i]));
+        }
+    }
+
+    std::vector<std::string> rows; // the lines scrolled up
+    std::string row;
+    uint32_t col   = 0;
+    uint32_t bells = 0;
+
+  private:
+    void byte(uint8_t c)
+    {
+        if (_state == 1U)
+        {
+            _state = c == '[' ? 2U : 0U;
+            _arg   = 0;
+            if (c != '[')
+            {
+                fail("screen: ESC %c", c);
+            }
+            return;
+        }
+        if (_state == 2U)
+        {
+            if (c >= '0' and c <= '9')
+            {
+                _arg = _arg * 10U + (c - '0');
+                return;
+            }
+            _state           = 0;
+            const uint32_t n = _arg == 0U ? 1U : _arg;
+            switch (c)
+            {
+            case 'C': col += n; break;
+            case 'D': col = n > col ? 0U : col - n; break;
+            case 'K': row.resize(col < row.size() ? col : row.size()); break;
+            case 'H': col = 0; break;
+            case 'J':
+                rows.clear();
+                row.clear();
+                break;
+            default: fail("screen: ESC [ %u %c", _arg, c); break;
+            }
+            return;
+        }
+        switch (c)
+        {
+        case 0x1B: _state = 1; break;
+        case '\b': col -= col != 0U ? 1U : 0U; break;
+        case '\r': col = 0; break;
+        case '\n':
+            rows.push_back(row);
+            row.clear();
+            break;
+        case '\a': bells++; break;
+        default:
+            if (c < 0x20U or c > 0x7EU)
+            {
+                fail("screen: byte 0x%02x", c);
+                break;
+            }
+            if (row.size() <= col)
+            {
+                row.resize(col + 1U, ' ');
+            }
+            row[col++] = static_cast<char>(c);
+            break;
+        }
+    }
+
+    uint32_t _state = 0;
+    uint32_t _arg   = 0;
+};
+
+/**
+ * @brief the echo and the replies, on the screen and counted
+ */
+class ScreenOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        if (screen != nullptr)
+        {
+            screen->apply(buf, len);
+        }
+        text.append(buf, keep ? len : 0U);
+        writes++;
+        bytes += len;
+    }
+
+    Screen *screen = nullptr;
+    bool keep      = true;
+    std::string text;
+    uint64_t writes = 0;
+    uint64_t bytes  = 0;
+};
+
+static const char *cmd_echo(ShellEngine &sh, const ShellArgv &args)
+{
+    std::string s;
+    for (uint32_t i = 1; i < args.argc; i++)
+    {
+        s += (i != 1U ? " " : "") + std::string(args.argv[i]);
+    }
+    sh.line(s);
+    return nullptr;
+}
+
+static const char *cmd_version(ShellEngine &sh)
+{
+    sh.line("1.0");
+    return nullptr;
+}
+
+static constexpr ShellCommand s_cmds[] = {
+    shell_command<cmd_echo>("echo", ""),
+    shell_command<cmd_version>("version", ""),
+};
+
+static constexpr ShellTable s_table(s_cmds);
+static_assert(s_table.valid(), "no perfect hash");
+
+/**
+ * @brief a terminal on an editor on an engine
+ */
+struct Session
+{
+    explicit Session(bool withScreen = true) : sh(s_table.index(), out), ed(sh, out)
+    {
+        out.screen = withScreen ? &screen : nullptr;
+    }
+
+    /**
+     * @brief every byte in its own packet, as typed
+     */
+    void type(const std::string &keys)
+    {
+        for (const char c : keys)
+        {
+            const uint8_t b = static_cast<uint8_t>(c);
+            ed.feed(&b, 1);
+        }
+    }
+
+    /**
+     * @brief all bytes in one packet
+     */
+    void chunk(const std::string &bytes)
+    {
+        ed.feed(reinterpret_cast<const uint8_t *>(bytes.data()), static_cast<uint32_t>(bytes.size()));
+    }
+
+    Screen screen;
+    ScreenOutput out;
+    ShellEngine sh;
+    ShellEditor ed;
+};
+
+/**
+ * @brief the screen row is the prompt and shown, the cursor at col
+ */
+static void expect_row(const char *what, Session &s, const std::string &shown, uint32_t col)
+{
+    const std::string want = std::string(SHELL_PROMPT) + shown;
+    const uint32_t wantCol = static_cast<uint32_t>(SHELL_PROMPT.size()) + col;
+    std::string row        = s.screen.row;
+    while (row.size() > want.size() and row.back() == ' ')
+    {
+        row.pop_back(); // blanks left by a shorter line look the same as erased cells
+    }
+    if (row != want or s.screen.col != wantCol)
+    {
+        fail("%s: screen \"%s\" at %u, not \"%s\" at %u", what, s.screen.row.c_str(), s.screen.col, want.c_str(),
+             wantCol);
+    }
+}
+
+/**
+ * @brief the line of the editor is line, cursor at cur, and the screen shows it
+ */
+static void expect_line(const char *what, Session &s, const std::string &line, uint32_t cur)
+{
+    if (s.ed.line_getter() != line or s.ed.cursor_getter() != cur)
+    {
+        fail("%s: line \"%.*s\" at %u, not \"%s\" at %u", what, static_cast<int>(s.ed.line_getter().size()),
+             s.ed.line_getter().data(), s.ed.cursor_getter(), line.c_str(), cur);
+    }
+    expect_row(what, s, line, cur);
+}
+
+static bool has_row(const Session &s, const std::string &row)
+{
+    for (const std::string &r : s.screen.rows)
+    {
+        if (r == row)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void check_keys()
+{
+    Session s;
+    s.type("hello");
+    expect_line("typed", s, "hello", 5);
+    s.type(LEFT LEFT "X");
+    expect_line("insert", s, "helXlo", 4);
+    s.type(HOME DEL);
+    expect_line("home delete", s, "elXlo", 0);
+    s.type(END BS);
+    expect_line("end backspace", s, "elXl", 4);
+    s.type("\x01" RIGHT "\x04");
+    expect_line("^A right ^D", s, "eXl", 1);
+    s.type("\x05" " one  two" "\x17");
+    expect_line("^W", s, "eXl one  ", 9);
+    s.type("\x02" "\x02" "\x02" "\x0b");
+    expect_line("^K", s, "eXl on", 6);
+    s.type(LEFT "\x15");
+    expect_line("^U", s, "n", 0);
+    s.type("\x06" "\x1b[1;5C" "\x1b[1~" "\x1b[4~");
+    expect_line("modified keys", s, "n", 1);
+    s.type("\x03");
+    expect_line("^C", s, "", 0);
+    if (not has_row(s, "> n^C"))
+    {
+        fail("^C: no \"> n^C\" row");
+    }
+
+    // escape sequences across packets, and a paste in one
+    s.chunk("ab\x1b");
+    s.chunk("[");
+    s.chunk("D");
+    expect_line("split escape", s, "ab", 1);
+    s.chunk("0123456789" LEFT "Z");
+    expect_line("paste", s, "a012345678Z9b", 11);
+    s.type("\x0c");
+    if (not s.screen.rows.empty())
+    {
+        fail("^L: the screen is not cleared");
+    }
+    expect_line("^L", s, "a012345678Z9b", 11);
+    s.type("\x15" "\x0b");
+
+    // length limit
+    const uint32_t bells = s.screen.bells;
+    s.chunk(std::string(300, 'a'));
+    expect_line("too long", s, std::string(SHELL_LINE_MAX - 1U, 'a'), SHELL_LINE_MAX - 1U);
+    if (s.screen.bells == bells)
+    {
+        fail("too long: no bell");
+    }
+    s.type(HOME "\x0b");
+    expect_line("cut all", s, "", 0);
+}
+
+static void check_lines()
+{
+    Session s;
+    s.type("echo hi  there\r\n");
+    if (not has_row(s, "> echo hi  there") or not has_row(s, "hi there"))
+    {
+        fail("enter: rows \"%s\"", s.screen.rows.empty() ? "" : s.screen.rows.back().c_str());
+    }
+    expect_line("enter", s, "", 0);
+    size_t prompts = 0;
+    for (size_t at = 0; (at = s.out.text.find(SHELL_PROMPT, at)) != std::string::npos; at++)
+    {
+        prompts++;
+    }
+    if (prompts != 2U)
+    {
+        fail("\"\\r\\n\": %zu prompts, not 2", prompts);
+    }
+
+    s.type("nosuch\r");
+    if (not has_row(s, "err unknown command"))
+    {
+        fail("unknown: no error row");
+    }
+
+    // a program's line: to the engine, no echo, no history
+    s.out.text.clear();
+    s.chunk("!5 echo x\n!6 version\r\n");
+    if (s.out.text != "!5:x\r\n!5=ok\r\n!6:1.0\r\n!6=ok\r\n")
+    {
+        fail("tagged: \"%s\"", s.out.text.c_str());
+    }
+    s.chunk("!7 echo ");
+    s.chunk("split\n");
+    if (s.out.text.find("!7:split\r\n!7=ok\r\n") == std::string::npos)
+    {
+        fail("tagged across packets: \"%s\"", s.out.text.c_str());
+    }
+
+    // history
+    s.type("echo a\recho b\rversion\rpar");
+    s.type(UP);
+    expect_line("up", s, "version", 7);
+    s.type(UP UP);
+    expect_line("up up", s, "echo a", 6);
+    s.type(DOWN);
+    expect_line("down", s, "echo b", 6);
+    s.type(DOWN DOWN);
+    expect_line("down to own", s, "par", 3);
+    s.type("\x15" "\x10" "\x10" "\x0e");
+    expect_line("^P ^N", s, "version", 7);
+    s.type("\x15" "echo a\r");
+    if (s.ed.history_getter().count_getter() != 6U)
+    {
+        fail("history: %u lines, not 6", s.ed.history_getter().count_getter());
+    }
+
+    // search
+    s.type("keep" "\x12" "ech");
+    expect_row("search", s, "(search)'ech': echo a", 15);
+    s.type("\x12");
+    expect_row("search again", s, "(search)'ech': echo b", 15);
+    s.type("\x12");
+    expect_row("search same", s, "(search)'ech': echo a", 15);
+    s.type("\x12");
+    expect_row("search further", s, "(search)'ech': echo hi  there", 15);
+    s.type("\x12");
+    expect_row("search past", s, "(failed search)'ech': echo hi  there", 22);
+    s.type(BS "ho b");
+    expect_row("search edit", s, "(search)'echo b': echo b", 18);
+    s.type("\x07");
+    expect_line("search cancelled", s, "keep", 4);
+    s.type("\x15" "\x12" "sio" RIGHT);
+    expect_line("search taken", s, "version", 4);
+    s.type("\x15" "\x12" "b\r");
+    if (s.screen.rows.back() != "b" or s.ed.line_getter() != "")
+    {
+        fail("search enter: \"%s\"", s.screen.rows.back().c_str());
+    }
+
+    // a pasted script, lines run in order
+    s.out.text.clear();
+    s.chunk("echo first line\recho second line\n\necho third line\r\n");
+    const char *want = "echo first line\r\nfirst line\r\n> echo second line\r\nsecond line\r\n> \r\n> echo third "
+                       "line\r\nthird line\r\n> ";
+    if (s.out.text != want)
+    {
+        fail("pasted script: \"%s\"", s.out.text.c_str());
+    }
+    if (s.ed.stats_getter().pasted == 0U)
+    {
+        fail("pasted script: not counted as a paste");
+    }
+}
+
+static void check_history()
+{
+    ShellHistory h{};
+    char buf[SHELL_LINE_MAX];
+    if (h.newest() != SHELL_HIST_NONE or h.search("x", h.newest()) != SHELL_HIST_NONE)
+    {
+        fail("history: not empty");
+    }
+    h.push("one");
+    h.push("one");
+    h.push("");
+    if (h.count_getter() != 1U)
+    {
+        fail("history: %u lines after a repeat and an empty one", h.count_getter());
+    }
+    const std::string big(SHELL_LINE_MAX - 1U, 'z');
+    for (uint32_t i = 0; i < 500U; i++)
+    {
+        h.push("line " + std::to_string(i) + (i % 7U == 0U ? big.substr(0, i % 200U) : ""));
+    }
+    if (h.used_getter() > SHELL_HISTORY_BYTES)
+    {
+        fail("history: %u bytes used", h.used_getter());
+    }
+
+    uint32_t n    = 0;
+    uint32_t last = 0;
+    uint32_t pos  = h.newest();
+    for (uint32_t i = 499U; pos != SHELL_HIST_NONE; i--, n++)
+    {
+        const std::string want = "line " + std::to_string(i) + (i % 7U == 0U ? big.substr(0, i % 200U) : "");
+        const std::string got(buf, h.copy(pos, buf));
+        if (got != want)
+        {
+            fail("history: \"%s\", not \"%s\"", got.c_str(), want.c_str());
+            break;
+        }
+        last = pos;
+        pos  = h.older(pos);
+    }
+    if (n != h.count_getter() or n < 10U)
+    {
+        fail("history: walked %u of %u lines", n, h.count_getter());
+    }
+    uint32_t back = 1;
+    for (pos = last; h.newer(pos) != SHELL_HIST_NONE; pos = h.newer(pos))
+    {
+        back++;
+    }
+    if (back != n or pos != h.newest())
+    {
+        fail("history: %u lines walking back", back);
+    }
+    if (h.search("line 499", h.newest()) != h.newest() or h.search("line 3 ", h.newest()) != SHELL_HIST_NONE)
+    {
+        fail("history: search");
+    }
+    h.push(big);
+    if (h.copy(h.newest(), buf) != big.size())
+    {
+        fail("history: a line of %zu bytes", big.size());
+    }
+}
+
+/**
+ * @brief random keys, and the same edits on a std::string
+ */
+static void check_random()
+{
+    static const char *const keys[] = {"a", "b", " ", "xyz", LEFT, RIGHT, HOME, END, DEL, BS, "\x01", "\x05", "\x0b", "\x15", "\x17"};
+    std::mt19937 rng(opt.seed);
+    Session s;
+    std::string line;
+    uint32_t cur = 0;
+    for (uint32_t i = 0; i < 20000U and s_failures == 0U; i++)
+    {
+        const std::string k = keys[rng() % (sizeof(keys) / sizeof(keys[0]))];
+        if (k == LEFT)
+        {
+            cur -= cur != 0U ? 1U : 0U;
+        }
+        else if (k == RIGHT)
+        {
+            cur += cur < line.size() ? 1U : 0U;
+        }
+        else if (k == HOME or k == "\x01")
+        {
+            cur = 0;
+        }
+        else if (k == END or k == "\x05")
+        {
+            cur = static_cast<uint32_t>(line.size());
+        }
+        else if (k == DEL)
+        {
+            line.erase(cur, cur < line.size() ? 1U : 0U);
+        }
+        else if (k == BS)
+        {
+            if (cur != 0U)
+            {
+                line.erase(--cur, 1);
+            }
+        }
+        else if (k == "\x0b")
+        {
+            line.erase(cur);
+        }
+        else if (k == "\x15")
+        {
+            line.erase(0, cur);
+            cur = 0;
+        }
+        else if (k == "\x17")
+        {
+            uint32_t w = cur;
+            while (w != 0U and line[w - 1U] == ' ')
+            {
+                w--;
+            }
+            while (w != 0U and line[w - 1U] != ' ')
+            {
+                w--;
+            }
+            line.erase(w, cur - w);
+            cur = w;
+        }
+        else if (line.size() + k.size() < 80U)
+        {
+            line.insert(cur, k);
+            cur += static_cast<uint32_t>(k.size());
+        }
+        else
+        {
+            continue;
+        }
+        (rng() % 4U == 0U ? static_cast<void>(s.chunk(k)) : s.type(k));
+        expect_line("random", s, line, cur);
+    }
+}
+
+/**
+ * @brief echo bytes per edit of a script typed key by key, and of a full redraw
+ */
+static void report(const char *what, const std::string &setup, const std::string &keys)
+{
+    Session s(false);
+    s.out.keep = false;
+    s.type(setup);
+    const uint64_t bytes0 = s.out.bytes;
+    uint64_t naive        = 0;
+    uint32_t edits        = 0;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        // an escape sequence is one edit
+        size_t n = 1;
+        if (keys[i] == '\x1b')
+        {
+            while (i + n < keys.size() and not(keys[i + n] >= 0x40 and keys[i + n] <= 0x7E and n > 1U))
+            {
+                n++;
+            }
+            n++;
+        }
+        s.type(keys.substr(i, n));
+        i += n - 1U;
+        edits++;
+        const uint32_t len  = static_cast<uint32_t>(s.ed.line_getter().size());
+        const uint32_t back = len - s.ed.cursor_getter();
+        naive += 1U + SHELL_PROMPT.size() + len + 3U + (back == 0U ? 0U : back == 1U ? 3U : back < 10U ? 4U : 5U);
+    }
+    const double ours = static_cast<double>(s.out.bytes - bytes0) / edits;
+    printf("%-22s %5u edits %7.2f B/edit   redraw %7.2f B/edit  (%.1fx)\n", what, edits, ours,
+           static_cast<double>(naive) / edits, static_cast<double>(naive) / edits / ours);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.keys = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.keys == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    check_keys();
+    check_lines();
+    check_history();
+    check_random();
+
+    const std::string cmd = "md 24000000 16 --words --count 4";
+    report("typing", "", cmd);
+    report("insert mid-line", cmd + HOME RIGHT RIGHT RIGHT, "0x");
+    report("backspace mid-line", cmd + HOME RIGHT RIGHT RIGHT RIGHT RIGHT, BS BS BS);
+    report("cursor keys", cmd, HOME END LEFT LEFT LEFT RIGHT HOME RIGHT RIGHT);
+    report("cut word, line", cmd, "\x17" "\x17" "\x01" "\x0b");
+    report("history, similar", "md 24000000 16\rmd 24000100 16\rmd 24000100 32\r", UP UP UP DOWN DOWN);
+    report("history, different", "version\rmd 24000000 16\rstorage\r", UP UP UP DOWN);
+    report("search", "md 24000000 16\rversion\rtxq\r", "\x12" "md" "\x07");
+
+    // a pasted script: key by key, then as it arrives
+    std::string script;
+    for (uint32_t i = 0; i < 64U; i++)
+    {
+        script += "echo line " + std::to_string(i) + " of the pasted script\r";
+    }
+    Session perKey(false);
+    perKey.out.keep = false;
+    perKey.type(script);
+    Session bulk(false);
+    bulk.out.keep = false;
+    for (size_t at = 0; at < script.size(); at += 64U)
+    {
+        bulk.chunk(script.substr(at, 64U));
+    }
+    printf("paste %zu B, 64 lines    per key %6lu writes %6lu B   64 B packets %6lu writes %6lu B\n",
+           script.size(), static_cast<unsigned long>(perKey.out.writes), static_cast<unsigned long>(perKey.out.bytes),
+           static_cast<unsigned long>(bulk.out.writes), static_cast<unsigned long>(bulk.out.bytes));
+    if (bulk.out.bytes != perKey.out.bytes or bulk.out.writes * 2U > perKey.out.writes)
+    {
+        fail("paste: the packets did not make fewer writes of the same bytes");
+    }
+
+    // editing cost
+    Session t(false);
+    t.out.keep = false;
+    std::mt19937 rng(opt.seed);
+    static const char *const mix[] = {"a", "b", LEFT, RIGHT, BS, HOME, END};
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < 4096U; i++)
+    {
+        keys.push_back(mix[rng() % (sizeof(mix) / sizeof(mix[0]))]);
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.keys; i++)
+    {
+        t.chunk(keys[i & 4095U]);
+        if ((i & 63U) == 63U)
+        {
+            t.type("\x15" "\x0b");
+        }
+    }
+    printf("editing                %7.1f ns/key\n", ns_since(t0, opt.keys));
+
+    return check_summary();
+}
@@ -0,0 +1,273 @@
+/**
+ * @file        shell-host.cpp
+ * @brief       Host build of the shell engine: protocol checks and dispatch cost per command
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-host [-n lookups] [-r seed]
+ *
+ *              Builds Applications/Shell/shell-engine.cpp unchanged with a
+ *              table of 40 commands, the built-in names and the ones a
+ *              larger shell grows to, whose handlers do nothing.
+ *
+ *              Checks: every name is found at its own entry, words close to
+ *              a name (prefixes, one letter more or changed, other case) are
+ *              not; tagged and plain lines get the replies of shell-proto.hpp,
+ *              long lines are refused with their end line.
+ *
+ *              Then measures, on the same mix of names and unknown words:
+ *
+ *                  hash         ShellIndex::find, the perfect hash
+ *                  linear       strcmp() against every entry, the usual
+ *                               C shell table
+ *                  dispatch     ShellEngine::feed() of whole lines,
+ *                               "!<tag> name args\n", replies to a sink
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/11
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t lookups = 4000000;
+    unsigned seed    = 1;
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n lookups] [-r seed]\n"
+            "  checks the shell engine and times the command lookup against a linear strcmp scan\n",
+            argv0);
+}
+
+static const char *cmd_nop(ShellEngine &sh, const ShellArgv &args)
+{
+    (void)sh;
+    (void)args;
+    return nullptr;
+}
+
+static const char *cmd_echo(ShellEngine &sh, std::string_view text)
+{
+    sh.line(text);
+    return nullptr;
+}
+
+static const char *cmd_fail(ShellEngine &sh, const ShellArgv &args)
+{
+    (void)args;
+    sh.format(FMT("%d lines"), 1);
+    return "refused";
+}
+
+static constexpr ShellCommand s_cmds[] = {
+    {"help", cmd_nop, ""},     shell_command<cmd_echo>("echo", ""),    {"version", cmd_nop, ""}, {"uptime", cmd_nop, ""},
+    {"txq", cmd_nop, ""},      {"log", cmd_nop, ""},      {"usb", cmd_nop, ""},     {"storage", cmd_nop, ""},
+    {"fail", cmd_fail, ""},    {"md", cmd_nop, ""},       {"mw", cmd_nop, ""},      {"dump", cmd_nop, ""},
+    {"top", cmd_nop, ""},      {"gpio", cmd_nop, ""},     {"pin", cmd_nop, ""},     {"adc", cmd_nop, ""},
+    {"pwm", cmd_nop, ""},      {"reset", cmd_nop, ""},    {"jobs", cmd_nop, ""},    {"kill", cmd_nop, ""},
+    {"run", cmd_nop, ""},      {"script", cmd_nop, ""},   {"history", cmd_nop, ""}, {"clear", cmd_nop, ""},
+    {"flash", cmd_nop, ""},    {"erase", cmd_nop, ""},    {"update", cmd_nop, ""},  {"sync", cmd_nop, ""},
+    {"clock", cmd_nop, ""},    {"temp", cmd_nop, ""},     {"volt", cmd_nop, ""},    {"i2c", cmd_nop, ""},
+    {"spi", cmd_nop, ""},      {"uart", cmd_nop, ""},     {"can", cmd_nop, ""},     {"tasks", cmd_nop, ""},
+    {"heap", cmd_nop, ""},     {"fastpath", cmd_nop, ""}, {"bench", cmd_nop, ""},   {"set", cmd_nop, ""},
+};
+
+static constexpr ShellTable s_table(s_cmds);
+static_assert(s_table.valid(), "duplicate command name, or no perfect hash within SHELL_SEED_TRIES");
+
+static constexpr ShellIndex s_index = s_table.index();
+
+/**
+ * @brief keeps the replies, for the protocol checks
+ */
+class CaptureOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        text.append(buf, len);
+    }
+
+    std::string text;
+};
+
+/**
+ * @brief counts the replies, for the benchmark
+ */
+class SinkOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        bytes += len;
+        last = buf[0];
+    }
+
+    uint64_t bytes = 0;
+    char last      = 0;
+};
+
+static void expect(const char *in, const char *out)
+{
+    CaptureOutput cap;
+    ShellEngine sh(s_index, cap);
+    sh.feed(reinterpret_cast<const uint8_t *>(in), static_cast<uint32_t>(strlen(in)));
+    if (cap.text != out)
+    {
+        fail("\"%s\" gave \"%s\", not \"%s\"", in, cap.text.c_str(), out);
+    }
+}
+
+static const ShellCommand *linear_find(const char *name)
+{
+    for (const ShellCommand &c : s_cmds)
+    {
+        if (strcmp(c.name.data(), name) == 0) // the names are literals, terminated
+        {
+            return &c;
+        }
+    }
+    return nullptr;
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.lookups = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.lookups == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    constexpr uint32_t count = sizeof(s_cmds) / sizeof(s_cmds[0]);
+    printf("%u commands, %u slots, seed %u\n", count, s_index.mask + 1U, s_index.seed);
+
+    // names and their neighbours
+    std::vector<std::string> unknown;
+    for (const ShellCommand &cmd : s_cmds)
+    {
+        const std::string name(cmd.name);
+        if (s_index.find(name) != &cmd)
+        {
+            fail("%s not found at its entry", name.c_str());
+        }
+        unknown.push_back(name + "x");
+        unknown.push_back(name.substr(0, name.size() - 1U));
+        unknown.push_back(std::string(1, static_cast<char>(name[0] - 32)) + name.substr(1));
+        std::string changed = name;
+        changed.back()      = changed.back() == 'z' ? 'a' : static_cast<char>(changed.back() + 1);
+        unknown.push_back(changed);
+    }
+    unknown.push_back("");
+    for (const std::string &w : unknown)
+    {
+        const ShellCommand *hit = s_index.find(w);
+        if (hit != nullptr and hit->name != w)
+        {
+            fail("\"%s\" found as %.*s", w.c_str(), static_cast<int>(hit->name.size()), hit->name.data());
+        }
+    }
+
+    // the protocol
+    expect("!7 echo \"hi there\"\n", "!7:hi there\r\n!7=ok\r\n");
+    expect("!8 nosuch 1 2\r\n", "!8=err unknown command\r\n");
+    expect("!9 fail\n", "!9:1 lines\r\n!9=err refused\r\n");
+    expect("!10 \n", "!10=err unknown command\r\n");
+    expect("echo  hi\r\n\r\n", "hi\r\n");
+    expect("!15 echo a b\n", "!15:usage: echo <text>\r\n!15=err too many arguments\r\n");
+    expect("  nosuch\n", "err unknown command\r\n");
+    expect("!11 help\n!12 echo a\n", "!11=ok\r\n!12:a\r\n!12=ok\r\n");
+    expect("!x echo a\n", "err unknown command\r\n");
+    {
+        const std::string longLine = "!13 echo " + std::string(SHELL_LINE_MAX, 'a') + "\n!14 echo b\n";
+        expect(longLine.c_str(), "!13=err line too long\r\n!14:b\r\n!14=ok\r\n");
+    }
+
+    // the same word mix for every method: mostly names, one in 8 unknown
+    std::mt19937 rng(opt.seed);
+    std::vector<std::string> words;
+    for (uint32_t i = 0; i < 4096U; i++)
+    {
+        words.push_back(rng() % 8U == 0U ? unknown[rng() % unknown.size()] : std::string(s_cmds[rng() % count].name));
+    }
+
+    uintptr_t sink = 0;
+    auto t0        = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lookups; i++)
+    {
+        sink += reinterpret_cast<uintptr_t>(s_index.find(words[i & 4095U]));
+    }
+    const double hashNs = ns_since(t0, opt.lookups);
+
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opt.lookups; i++)
+    {
+        sink -= reinterpret_cast<uintptr_t>(linear_find(words[i & 4095U].c_str()));
+    }
+    const double linearNs = ns_since(t0, opt.lookups);
+    if (sink != 0U)
+    {
+        fail("the hash and the linear scan disagree");
+    }
+
+    std::string stream;
+    for (uint32_t i = 0; i < 4096U; i++)
+    {
+        stream += "!" + std::to_string(i + 1U) + " " + words[i] + " 0x24000000 16\n";
+    }
+    SinkOutput out;
+    ShellEngine sh(s_index, out);
+    const uint32_t rounds = opt.lookups / 4096U + 1U;
+    t0                    = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        sh.feed(reinterpret_cast<const uint8_t *>(stream.data()), static_cast<uint32_t>(stream.size()));
+    }
+    const double dispatchNs = ns_since(t0, static_cast<uint64_t>(rounds) * 4096U);
+    const ShellEngine::Stats &st = sh.stats_getter();
+    if (st.commands + st.unknown != rounds * 4096U)
+    {
+        fail("dispatch ran %u of %u lines", st.commands + st.unknown, rounds * 4096U);
+    }
+
+    printf("hash      %7.1f ns/lookup\n", hashNs);
+    printf("linear    %7.1f ns/lookup  (%.1fx)\n", linearNs, linearNs / hashNs);
+    printf("dispatch  %7.1f ns/line    (%.1f reply bytes per line)\n", dispatchNs,
+           static_cast<double>(out.bytes) / (static_cast<double>(rounds) * 4096.0));
+
+    return check_summary();
+}
@@ -0,0 +1,716 @@
+/**
+ * @file        shell-jobs-bench.cpp
+ * @brief       Host checks of the shell background jobs and pipelines, with threads for the worker tasks
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-jobs-bench [-n jobs] [-w workers] [-l lines]
+ *
+ *              Builds Applications/Shell/shell-jobs.cpp, the filters and
+ *              the built-ins (jobs, kill, fg, echo) unchanged, registered
+ *              with the bench's own commands by the linker
+ *              (Tools/app-host/app-host.ld); the ShellJobPort is condition
+ *              variables standing in for the semaphore and the thread flags
+ *              of shell-cdc.cpp, the workers are std::thread running
+ *              ShellWorker::run().
+ *
+ *              Checks: "cmd &" answers its job number at once, plain and
+ *              tagged; `fg` passes the lines of a job in order, the ones
+ *              written while the output was full included; `kill` ends a
+ *              queued job at once and a running one at its next look at
+ *              sh.cancelled(); ^C in `fg` kills, a second one leaves the
+ *              job in the background; a full table refuses; `jobs` lists
+ *              and removes the ended jobs; argument errors come with the job.
+ *              Pipelines: seq, grep, head, count, hexdump and crc give the
+ *              lines and values computed here; head stops the stages before
+ *              it, ^C stops a pipeline, a last stage that reads nothing
+ *              too; malformed pipelines and pipelines without idle workers
+ *              are refused; the table is empty after each.
+ *
+ *              Then measures:
+ *
+ *                  start        "cmd &" fed to the handler running
+ *                  kill         `kill` to the job seen ended
+ *                  output       lines through a job output read by `fg`
+ *                  pipelines    lines and bytes per second through 2, 3
+ *                               and 4 stages, each pipe SHELL_JOB_OUT bytes
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/14
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../../Applications/Shell/shell-jobs.hpp"
+#include "../../Applications/Update/fwu-proto.hpp"
+#include "../host-test.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief the thread flag of a task
+ */
+struct Waiter
+{
+    std::mutex m;
+    std::condition_variable cv;
+    bool woken = false;
+};
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t jobs    = 2000;
+    uint32_t workers = 3;
+    uint32_t lines   = 1000000;
+} opt;
+
+static std::atomic<int64_t> s_started{0}; // ns, set by `stamp`
+
+static thread_local Waiter t_waiter;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n jobs] [-w workers] [-l lines]\n"
+            "  checks the shell job table with threads as workers, times start, kill, output and pipelines\n",
+            argv0);
+}
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief the semaphore, the thread flags and ^C of shell-cdc.cpp
+ */
+class ThreadPort : public ShellJobPort
+{
+  public:
+    void post() override
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _posts++;
+        _work.notify_one();
+    }
+
+    void *self() override
+    {
+        return &t_waiter;
+    }
+
+    void wake(void *task) override
+    {
+        Waiter *w = static_cast<Waiter *>(task);
+        std::lock_guard<std::mutex> l(w->m);
+        w->woken = true;
+        w->cv.notify_one();
+    }
+
+    bool wait(uint32_t ms) override
+    {
+        if (interrupted())
+        {
+            return true;
+        }
+        {
+            std::unique_lock<std::mutex> l(t_waiter.m);
+            t_waiter.cv.wait_for(l, std::chrono::milliseconds(ms), [] { return t_waiter.woken; });
+            t_waiter.woken = false;
+        }
+        return interrupted();
+    }
+
+    /**
+     * @brief the ^C typed during the next waits of the shell thread
+     */
+    void interrupt(uint32_t n)
+    {
+        _interrupts.store(n);
+    }
+
+    /**
+     * @brief a worker sleeps until a post, false once stopped
+     */
+    bool acquire()
+    {
+        std::unique_lock<std::mutex> l(_m);
+        _work.wait(l, [this] { return _posts != 0U or _quit; });
+        if (_posts == 0U)
+        {
+            return false;
+        }
+        _posts--;
+        return true;
+    }
+
+    void quit()
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _quit = true;
+        _work.notify_all();
+    }
+
+  private:
+    bool interrupted()
+    {
+        uint32_t n = _interrupts.load();
+        while (std::this_thread::get_id() == _shell and n != 0U and not _interrupts.compare_exchange_weak(n, n - 1U))
+        {
+        }
+        return std::this_thread::get_id() == _shell and n != 0U;
+    }
+
+    const std::thread::id _shell = std::this_thread::get_id(); // built before main()
+    std::mutex _m;
+    std::condition_variable _work;
+    std::atomic<uint32_t> _interrupts{0};
+    uint32_t _posts = 0;
+    bool _quit      = false;
+};
+
+static ThreadPort s_port;
+static ShellJobs *s_jobs = nullptr; // built in main(), once the workers are counted
+
+class CaptureOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        text.append(buf, len);
+    }
+
+    std::string text;
+};
+
+static const char *cmd_quick(ShellEngine &sh)
+{
+    sh.line("quick");
+    return nullptr;
+}
+
+static const char *cmd_fail(ShellEngine &sh)
+{
+    (void)sh;
+    return "boom";
+}
+
+static const char *cmd_stamp(ShellEngine &sh)
+{
+    (void)sh;
+    s_started.store(now_ns(), std::memory_order_release);
+    return nullptr;
+}
+
+static const char *cmd_lines(ShellEngine &sh, uint32_t n)
+{
+    for (uint32_t i = 0; i < n and not sh.cancelled(); i++)
+    {
+        sh.format(FMT("line %u"), i);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief runs until killed, looking every 100 us
+ */
+static const char *cmd_spin(ShellEngine &sh)
+{
+    while (not sh.cancelled())
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return nullptr;
+}
+
+/**
+ * @brief never looks: a kill only shows at its end
+ */
+static const char *cmd_stubborn(ShellEngine &sh, uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    sh.line("stubborn done");
+    return nullptr;
+}
+
+SHELL_COMMAND(quick, cmd_quick, "");
+SHELL_COMMAND(fail, cmd_fail, "");
+SHELL_COMMAND(stamp, cmd_stamp, "");
+SHELL_COMMAND(lines, cmd_lines, "");
+SHELL_COMMAND(spin, cmd_spin, "");
+SHELL_COMMAND(stubborn, cmd_stubborn, "");
+
+/* these, the built-ins (echo, jobs, kill, fg, ...) and the filters, as the linker gathered them */
+static const ShellIndex s_index = shell_registered_index();
+
+/**
+ * @brief the shell task: feed a line, return what came back
+ */
+static std::string run(ShellEngine &sh, CaptureOutput &cap, const std::string &line)
+{
+    cap.text.clear();
+    const std::string in = line + "\n";
+    sh.feed(reinterpret_cast<const uint8_t *>(in.data()), static_cast<uint32_t>(in.size()));
+    return cap.text;
+}
+
+static void expect(ShellEngine &sh, CaptureOutput &cap, const std::string &line, const std::string &out)
+{
+    const std::string got = run(sh, cap, line);
+    if (got != out)
+    {
+        fail("\"%s\" gave \"%s\", not \"%s\"", line.c_str(), got.c_str(), out.c_str());
+    }
+}
+
+/**
+ * @brief wait until the job runs, false after a second
+ * @note  `jobs` removes the ended jobs: not for a job that may have ended
+ */
+static bool settle(uint32_t job, const char *state)
+{
+    CaptureOutput cap;
+    ShellEngine sh(s_index, cap);
+    sh.jobs_setter(s_jobs);
+    const std::string want = "[" + std::to_string(job) + "] " + state;
+    for (int i = 0; i < 1000; i++)
+    {
+        if (run(sh, cap, "jobs").find(want) != std::string::npos)
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+/**
+ * @brief wait until the table is empty, false after a second
+ */
+static bool drained()
+{
+    for (int i = 0; i < 1000 and s_jobs->free_getter() != SHELL_JOB_MAX; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return s_jobs->free_getter() == SHELL_JOB_MAX;
+}
+
+/**
+ * @brief the last job read by fg: its worker lets go of it a moment after, the
+ *        next job takes the same number once it did
+ */
+static void expect_last(ShellEngine &sh, CaptureOutput &cap, const std::string &line, const std::string &out)
+{
+    expect(sh, cap, line, out);
+    if (not drained())
+    {
+        fail("jobs left in the table after \"%s\": %u free", line.c_str(), s_jobs->free_getter());
+    }
+}
+
+static void check_basic(ShellEngine &sh, CaptureOutput &cap)
+{
+    expect(sh, cap, "quick &", "[1]\r\n");
+    expect_last(sh, cap, "fg", "quick\r\n");
+    expect(sh, cap, "fail &", "[1]\r\n");
+    expect_last(sh, cap, "fg 1", "err boom\r\n");
+    expect(sh, cap, "fg 1", "err no such job\r\n");
+    expect(sh, cap, "kill 3", "err no such job\r\n");
+    expect(sh, cap, "nosuch &", "err unknown command\r\n");
+    expect(sh, cap, "lines x &", "[1]\r\n");
+    expect_last(sh, cap, "fg", "argument 1 <uint>: \"x\"\r\nerr bad argument\r\n");
+
+    expect(sh, cap, "!7 quick &", "!7:[1]\r\n!7=ok\r\n");
+    expect_last(sh, cap, "!8 fg 1", "!8:quick\r\n!8=ok\r\n");
+    expect(sh, cap, "!9 fail &", "!9:[1]\r\n!9=ok\r\n");
+    expect_last(sh, cap, "!10 fg", "!10=err boom\r\n");
+
+    CaptureOutput alone;
+    ShellEngine none(s_index, alone);
+    expect(none, alone, "quick &", "err no background jobs\r\n");
+    expect(none, alone, "fg", "err no background jobs\r\n");
+}
+
+/**
+ * @brief a job writing far more than its output holds: it waits, fg reads all
+ */
+static void check_output(ShellEngine &sh, CaptureOutput &cap)
+{
+    const uint32_t stalls = s_jobs->stalls_getter();
+    expect(sh, cap, "lines 2000 &", "[1]\r\n");
+    if (not settle(1, "running"))
+    {
+        fail("count did not start");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (s_jobs->stalls_getter() == stalls)
+    {
+        fail("a full job output did not stop the job");
+    }
+    const std::string got = run(sh, cap, "fg 1");
+    std::string want;
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        want += "line " + std::to_string(i) + "\r\n";
+    }
+    if (got != want)
+    {
+        fail("fg of lines 2000 gave %zu bytes, not %zu", got.size(), want.size());
+    }
+    if (not drained())
+    {
+        fail("jobs left in the table after fg of lines 2000");
+    }
+}
+
+static void check_kill(ShellEngine &sh, CaptureOutput &cap)
+{
+    // the workers busy, the others queued; the table full
+    for (uint32_t i = 1; i <= SHELL_JOB_MAX; i++)
+    {
+        expect(sh, cap, "spin &", "[" + std::to_string(i) + "]\r\n");
+    }
+    expect(sh, cap, "spin &", "err job table full\r\n");
+    for (uint32_t i = 1; i <= opt.workers and i <= SHELL_JOB_MAX; i++)
+    {
+        if (not settle(i, "running"))
+        {
+            fail("job %u did not start", i);
+        }
+    }
+
+    const uint32_t queued = SHELL_JOB_MAX;
+    if (opt.workers < SHELL_JOB_MAX)
+    {
+        expect(sh, cap, "kill " + std::to_string(queued), "");
+        const std::string list = run(sh, cap, "jobs");
+        if (list.find("[" + std::to_string(queued) + "] done         0 B  spin -> killed") == std::string::npos)
+        {
+            fail("a killed queued job is not ended at once: %s", list.c_str());
+        }
+        if (run(sh, cap, "jobs").find("[" + std::to_string(queued) + "]") != std::string::npos)
+        {
+            fail("jobs did not remove the ended job");
+        }
+    }
+    else
+    {
+        expect(sh, cap, "fg " + std::to_string(queued) + " x", "usage: fg [uint]\r\nerr too many arguments\r\n");
+        expect(sh, cap, "kill " + std::to_string(queued), "");
+        expect(sh, cap, "fg " + std::to_string(queued), "err killed\r\n");
+    }
+
+    for (uint32_t i = 1; i < queued; i++)
+    {
+        expect(sh, cap, "kill " + std::to_string(i), "");
+        expect(sh, cap, "fg " + std::to_string(i), "err killed\r\n");
+    }
+    if (not drained() or run(sh, cap, "jobs").find("[") != std::string::npos)
+    {
+        fail("jobs left in the table");
+    }
+
+    // ^C in fg kills; a job that does not look is left in the background by a second one
+    expect(sh, cap, "spin &", "[1]\r\n");
+    s_port.interrupt(1);
+    expect_last(sh, cap, "fg", "err killed\r\n");
+    expect(sh, cap, "stubborn 100 &", "[1]\r\n");
+    if (not settle(1, "running"))
+    {
+        fail("stubborn did not start");
+    }
+    s_port.interrupt(2);
+    expect(sh, cap, "fg", "err left in the background\r\n");
+    expect_last(sh, cap, "fg", "stubborn done\r\nerr killed\r\n");
+}
+
+/**
+ * @brief bytes of `seq count`, without the line ends
+ */
+static double numbers_bytes(uint32_t count)
+{
+    double bytes = 0;
+    for (uint64_t width = 1, low = 1; low <= count; width++, low *= 10U)
+    {
+        bytes += static_cast<double>(width * (std::min<uint64_t>(count, low * 10U - 1U) - low + 1U));
+    }
+    return bytes;
+}
+
+/**
+ * @brief the bytes of `seq count | grep text`, without the line ends
+ */
+static std::string numbers(uint32_t count, const std::string &text = "")
+{
+    std::string bytes;
+    for (uint32_t i = 1; i <= count; i++)
+    {
+        if (std::to_string(i).find(text) != std::string::npos)
+        {
+            bytes += std::to_string(i);
+        }
+    }
+    return bytes;
+}
+
+static std::string crc_line(const std::string &bytes)
+{
+    char line[64];
+    snprintf(line, sizeof(line), "crc32 %08lx %zu bytes\r\n",
+             static_cast<unsigned long>(fwu_crc32(0, bytes.data(), static_cast<uint32_t>(bytes.size()))), bytes.size());
+    return line;
+}
+
+static void expect_drained(const char *after)
+{
+    if (not drained())
+    {
+        fail("jobs left in the table after %s: %u free", after, s_jobs->free_getter());
+    }
+}
+
+static void check_pipes(ShellEngine &sh, CaptureOutput &cap)
+{
+    const bool three = opt.workers >= 2U; // three stages in front, two in the background
+
+    expect(sh, cap, "seq 5 | count", "5 lines 5 bytes\r\n");
+    expect(sh, cap, "seq 100 | count", "100 lines 192 bytes\r\n");
+    expect(sh, cap, "echo 123456789 | crc", "crc32 cbf43926 9 bytes\r\n");
+    expect(sh, cap, "!5 seq 3 | count", "!5:3 lines 3 bytes\r\n!5=ok\r\n");
+    expect(sh, cap, "seq 3 | nosuch", "err unknown command\r\n");
+    if (three)
+    {
+        expect(sh, cap, "seq 20 | grep 1 | count", "11 lines 21 bytes\r\n");
+        expect(sh, cap, "seq 20 | grep 1 | head 3", "1\r\n10\r\n11\r\n");
+    }
+    expect_drained("simple pipelines");
+
+    // a stream far larger than a pipe, through all stages
+    const std::string crc = crc_line(numbers(5000));
+    expect(sh, cap, "seq 5000 | crc", crc);
+    if (three)
+    {
+        expect(sh, cap, "seq 5000 | grep 7 | crc", crc_line(numbers(5000, "7")));
+    }
+    expect(sh, cap, "seq 20 | hexdump",
+           "00000000  31 32 33 34 35 36 37 38 39 31 30 31 31 31 32 31  |1234567891011121|\r\n"
+           "00000010  33 31 34 31 35 31 36 31 37 31 38 31 39 32 30     |314151617181920|\r\n");
+    expect_drained("long pipelines");
+
+    // head, a last stage reading nothing and ^C all stop the stages before
+    expect(sh, cap, "seq 100000000 | head 3", "1\r\n2\r\n3\r\n");
+    expect(sh, cap, "seq 100000000 | quick", "quick\r\n");
+    if (three)
+    {
+        expect(sh, cap, "seq 100000000 | grep 9 | head 1", "9\r\n");
+    }
+    expect_drained("head");
+    s_port.interrupt(1);
+    const std::string got = run(sh, cap, "seq 100000000 | count");
+    if (got.size() < 19U or got.compare(got.size() - 17U, 17U, "err interrupted\r\n") != 0)
+    {
+        fail("^C in a pipeline gave \"%s\"", got.c_str());
+    }
+    expect_drained("^C");
+
+    // in the background: fg reads the last stage, killing it stops the first
+    if (three)
+    {
+        expect(sh, cap, "seq 5000 | crc &", "[2]\r\n");
+        const std::string first = run(sh, cap, "fg 1"); // the first stage may be gone already
+        if (first != "err job feeds a pipe\r\n" and first != "err no such job\r\n")
+        {
+            fail("fg of a piped job gave \"%s\"", first.c_str());
+        }
+        expect(sh, cap, "fg", crc);
+        expect_drained("a background pipeline");
+        expect(sh, cap, "spin | count &", "[2]\r\n");
+        if (not settle(2, "running"))
+        {
+            fail("count did not start");
+        }
+        expect(sh, cap, "kill 2", "");
+        expect(sh, cap, "fg 2", "0 lines 0 bytes\r\nerr killed\r\n");
+        expect_drained("a killed background pipeline");
+    }
+    else
+    {
+        expect(sh, cap, "seq 5000 | crc &", "err more stages than workers\r\n");
+    }
+
+    // no worker for a stage in front: refused rather than waiting for one
+    expect(sh, cap, "spin &", "[1]\r\n");
+    if (not settle(1, "running"))
+    {
+        fail("spin did not start");
+    }
+    if (opt.workers == 1U)
+    {
+        expect(sh, cap, "seq 3 | count", "err workers busy\r\n");
+    }
+    expect(sh, cap, "kill 1", "");
+    expect_last(sh, cap, "fg 1", "err killed\r\n");
+
+    // malformed
+    expect(sh, cap, "seq 3 |", "err empty stage\r\n");
+    expect(sh, cap, "| count", "err empty stage\r\n");
+    expect(sh, cap, "seq 3 | | count", "err empty stage\r\n");
+    expect(sh, cap, "seq 3 | count | count | count | count", "err too many stages\r\n");
+    if (opt.workers < SHELL_PIPE_MAX - 1U)
+    {
+        expect(sh, cap, "seq 3 | count | count | count", "err more stages than workers\r\n");
+    }
+    else
+    {
+        expect(sh, cap, "seq 3 | count | count | count", "1 lines 16 bytes\r\n");
+    }
+    expect_drained("malformed pipelines");
+}
+
+/**
+ * @brief lines through 2 to SHELL_PIPE_MAX stages
+ */
+static void measure_pipes(ShellEngine &sh, CaptureOutput &cap)
+{
+    static const char *const pipes[] = {
+        "| count",
+        "| grep 7 | count",
+        "| grep 7 | grep 1 | count",
+    };
+    const std::string lines = std::to_string(opt.lines);
+    for (uint32_t k = 0; k < sizeof(pipes) / sizeof(pipes[0]) and k + 1U <= opt.workers; k++)
+    {
+        const uint32_t stalls = s_jobs->stalls_getter();
+        const auto t0         = Clock::now();
+        const std::string out = run(sh, cap, "seq " + lines + " " + pipes[k]);
+        const double s        = std::chrono::duration<double>(Clock::now() - t0).count();
+        if (out.find(" lines ") == std::string::npos)
+        {
+            fail("seq %s %s gave \"%s\"", lines.c_str(), pipes[k], out.c_str());
+        }
+        printf("pipe    %u stages  %9.0f lines/s %6.2f MB/s  %u stalls  -> %s", k + 2U, opt.lines / s,
+               numbers_bytes(opt.lines) / s / 1e6, s_jobs->stalls_getter() - stalls, out.c_str());
+    }
+    printf("        %u B per pipe whatever flows through it\n", SHELL_JOB_OUT);
+}
+
+static void measure(ShellEngine &sh, CaptureOutput &cap)
+{
+    std::vector<double> start;
+    std::vector<double> kill;
+    for (uint32_t i = 0; i < opt.jobs; i++)
+    {
+        s_started.store(0);
+        const int64_t t0 = now_ns();
+        (void)run(sh, cap, "stamp &");
+        (void)run(sh, cap, "fg");
+        start.push_back(static_cast<double>(s_started.load() - t0) / 1000.0);
+    }
+    for (uint32_t i = 0; i < opt.jobs / 10U; i++)
+    {
+        (void)drained();
+        (void)run(sh, cap, "spin &");
+        (void)settle(1, "running");
+        const int64_t t0 = now_ns();
+        (void)run(sh, cap, "kill 1");
+        (void)run(sh, cap, "fg 1");
+        kill.push_back(static_cast<double>(now_ns() - t0) / 1000.0);
+    }
+
+    const uint32_t lines = 20000;
+    const auto t0        = Clock::now();
+    (void)run(sh, cap, "lines " + std::to_string(lines) + " &");
+    const std::string out = run(sh, cap, "fg");
+    const double s        = std::chrono::duration<double>(Clock::now() - t0).count();
+    if (std::count(out.begin(), out.end(), '\n') != static_cast<long>(lines))
+    {
+        fail("lines %u gave %ld lines", lines, static_cast<long>(std::count(out.begin(), out.end(), '\n')));
+    }
+
+    std::sort(start.begin(), start.end());
+    std::sort(kill.begin(), kill.end());
+    printf("%u workers, %u jobs of %u B output\n", opt.workers, SHELL_JOB_MAX, SHELL_JOB_OUT);
+    printf("start   median %6.1f us  p99 %7.1f us\n", start[start.size() / 2U], start[start.size() * 99U / 100U]);
+    printf("kill    median %6.1f us  p99 %7.1f us\n", kill[kill.size() / 2U], kill[kill.size() * 99U / 100U]);
+    printf("output  %.0f lines/s, %u stalls\n", lines / s, s_jobs->stalls_getter());
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:w:l:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.jobs = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'w': opt.workers = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'l': opt.lines = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    opt.jobs    = std::max(opt.jobs, 10U);
+    opt.workers = std::max(opt.workers, 1U);
+    opt.lines   = std::max(opt.lines, 1000U);
+
+    static ShellJobs jobs(s_port, opt.workers);
+    s_jobs = &jobs;
+
+    // the waiters built before any wake(): the table reaches them through fences
+    (void)s_port.self();
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < opt.workers; i++)
+    {
+        workers.emplace_back([] {
+            (void)s_port.self();
+            ShellWorker w(*s_jobs, s_index);
+            while (s_port.acquire())
+            {
+                (void)w.run();
+            }
+        });
+    }
+
+    CaptureOutput cap;
+    ShellEngine sh(s_index, cap);
+    sh.jobs_setter(s_jobs);
+    check_basic(sh, cap);
+    check_output(sh, cap);
+    check_kill(sh, cap);
+    check_pipes(sh, cap);
+    measure(sh, cap);
+    measure_pipes(sh, cap);
+
+    s_port.quit();
+    for (std::thread &t : workers)
+    {
+        t.join();
+    }
+
+    return check_summary();
+}
@@ -0,0 +1,576 @@
+/**
+ * @file        shell-script-bench.cpp
+ * @brief       Host checks of the compiled shell scripts, over the simulated NOR flash, timed against text lines
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-script-bench [-n commands]
+ *
+ *              Builds Applications/Shell/shell-script.cpp unchanged over
+ *              FlashSimImpl, the store in the top 256 KB of a 16 MB part
+ *              like on the board; map() of the simulation is the image,
+ *              the memory-mapped window of the OSPI flash. Every check runs
+ *              twice, the second time through a driver without a window,
+ *              which reads the code with read().
+ *
+ *              Checks: `script load` takes the lines up to "." through the
+ *              engine, plain and tagged; the compiler refuses unknown
+ *              commands, arguments that do not parse (naming the line and
+ *              the argument), unbalanced blocks, jobs, pipelines and
+ *              `script` itself; a second session loading meanwhile; repeat, nested repeat, if/else on ok and
+ *              fail, try and exit run the commands they should, with the
+ *              arguments parsed at load time, texts included; a failure
+ *              stops the script with its line; list, rm, replacing a
+ *              script, a full store; a header never written, a flipped bit
+ *              in the code and another command table are refused.
+ *
+ *              Then measures the cost per command of the same work as text
+ *              lines fed to the engine (split, lookup, parse, call) and as
+ *              a script run from the flash (fetch, call). Both drivers
+ *              copy from the same host memory: the gap between them says
+ *              how the host compiler and CPU take the copies, not what the
+ *              OSPI bus costs.
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/16
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../../Applications/Shell/shell-script.hpp"
+#include "../../Drivers/Peripheral/Flash/flash-sim-impl.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+constexpr uint32_t FLASH_SIZE   = 16UL << 20;
+constexpr uint32_t SCRIPT_AREA  = 0x40000U;     // STORAGE_RESERVED_TOP of the board
+constexpr uint32_t SCRIPT_BASE  = FLASH_SIZE - SCRIPT_AREA;
+
+/**
+ * @brief the simulated flash without its window: the code is read with read()
+ */
+class FlashNoWindow final : public FlashIntf
+{
+  public:
+    explicit FlashNoWindow(FlashSimImpl &sim) : _sim(sim)
+    {
+    }
+
+    [[nodiscard]] FlashErrCode enable() override
+    {
+        _geometry  = _sim.geometry_getter();
+        _isEnabled = _sim.enable_getter();
+        return _isEnabled ? FlashErrCode::FLASH_SUCCESS : FlashErrCode::FLASH_NOT_EN;
+    }
+
+    [[nodiscard]] FlashErrCode read(uint32_t addr, uint8_t *buf, uint32_t len) override
+    {
+        return _sim.read(addr, buf, len);
+    }
+
+    [[nodiscard]] FlashErrCode program(uint32_t addr, const uint8_t *buf, uint32_t len) override
+    {
+        return _sim.program(addr, buf, len);
+    }
+
+    [[nodiscard]] FlashErrCode erase_sector(uint32_t addr) override
+    {
+        return _sim.erase_sector(addr);
+    }
+
+  private:
+    FlashSimImpl &_sim;
+};
+
+enum class BenchColourEnum
+{
+    RED,
+    GREEN,
+};
+
+template <>
+struct ShellEnumWords<BenchColourEnum>
+{
+    static constexpr std::string_view name = "red|green";
+    static constexpr ShellEnumWord<BenchColourEnum> list[] = {
+        {"red", BenchColourEnum::RED},
+        {"green", BenchColourEnum::GREEN},
+    };
+};
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t commands = 1000000;
+} opt;
+
+static ShellScriptStore *s_store   = nullptr;
+static ShellScriptLoader *s_loader = nullptr;
+static std::string s_trace;         // what the commands were called with
+static uint64_t s_sum = 0;          // keeps the benchmark calls alive
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n commands]\n"
+            "  checks the shell script compiler, store and interpreter and times them against text lines\n",
+            argv0);
+}
+
+static const char *cmd_echo(ShellEngine &sh, const ShellArgv &args)
+{
+    std::string t;
+    for (uint32_t i = 1; i < args.argc; i++)
+    {
+        t += (i != 1U ? " " : "") + std::string(args.argv[i]);
+    }
+    s_trace += "echo(" + t + ")";
+    sh.line(t);
+    return nullptr;
+}
+
+static const char *cmd_add(ShellEngine &sh, int32_t a, int32_t b, std::optional<uint32_t> times)
+{
+    (void)sh;
+    s_trace += "add(" + std::to_string(a + b) + (times ? "x" + std::to_string(*times) : "") + ")";
+    return nullptr;
+}
+
+static const char *cmd_say(ShellEngine &sh, std::string_view text, std::optional<std::string_view> more)
+{
+    (void)sh;
+    s_trace += "say(" + std::string(text) + (more ? "," + std::string(*more) : "") + ")";
+    if (text.data()[text.size()] != '\0')
+    {
+        fail("say: text not terminated");
+    }
+    return nullptr;
+}
+
+static const char *cmd_led(ShellEngine &sh, BenchColourEnum colour, bool on)
+{
+    (void)sh;
+    s_trace += std::string("led(") + (colour == BenchColourEnum::RED ? "red" : "green") + (on ? ",on)" : ",off)");
+    return nullptr;
+}
+
+static const char *cmd_boom(ShellEngine &sh)
+{
+    (void)sh;
+    s_trace += "boom";
+    return "boom";
+}
+
+/**
+ * @brief the benchmark's command: no trace, just work the compiler cannot drop
+ */
+static const char *cmd_acc(ShellEngine &sh, ShellHex addr, uint32_t value)
+{
+    (void)sh;
+    s_sum += addr.value ^ value;
+    return nullptr;
+}
+
+static const char *cmd_script(ShellEngine &sh, std::string_view action, std::optional<std::string_view> name)
+{
+    if (action == "list")
+    {
+        s_store->list(sh);
+        return nullptr;
+    }
+    if (not name)
+    {
+        return "missing script name";
+    }
+    if (action == "load")
+    {
+        return s_loader->begin(sh, *name);
+    }
+    if (action == "run")
+    {
+        return s_store->run(sh, *name);
+    }
+    return action == "rm" ? s_store->remove(*name) : "bad action";
+}
+
+static constexpr ShellCommand s_cmds[] = {
+    shell_command<cmd_echo>("echo", ""),
+    shell_command<cmd_add>("add", ""),
+    shell_command<cmd_say>("say", ""),
+    shell_command<cmd_led>("led", ""),
+    shell_command<cmd_boom>("boom", ""),
+    shell_command<cmd_acc>("acc", ""),
+    shell_command<cmd_script>("script", ""),
+};
+
+static constexpr ShellTable s_table(s_cmds);
+static_assert(s_table.valid(), "no perfect hash");
+static constexpr ShellIndex s_index = s_table.index();
+
+/**
+ * @brief the same commands in another order: another firmware
+ */
+static constexpr ShellCommand s_other_cmds[] = {
+    shell_command<cmd_add>("add", ""),
+    shell_command<cmd_echo>("echo", ""),
+    shell_command<cmd_say>("say", ""),
+    shell_command<cmd_led>("led", ""),
+    shell_command<cmd_boom>("boom", ""),
+    shell_command<cmd_acc>("acc", ""),
+    shell_command<cmd_script>("script", ""),
+};
+
+static constexpr ShellTable s_other_table(s_other_cmds);
+static_assert(s_other_table.valid(), "no perfect hash");
+
+class CaptureOutput : public ShellOutput
+{
+  public:
+    void write(const char *buf, uint32_t len) override
+    {
+        text.append(buf, len);
+    }
+
+    std::string text;
+};
+
+static void feed(ShellEngine &sh, const std::string &text)
+{
+    sh.feed(reinterpret_cast<const uint8_t *>(text.data()), static_cast<uint32_t>(text.size()));
+}
+
+/**
+ * @brief load a script through the engine, tagged
+ * @return the reply to the "." line
+ */
+static std::string load(const char *name, const std::string &source)
+{
+    CaptureOutput cap;
+    ShellEngine sh(s_index, cap);
+    feed(sh, std::string("!1 script load ") + name + "\n");
+    if (cap.text != "!1=ok\r\n")
+    {
+        fail("load %s started with \"%s\"", name, cap.text.c_str());
+    }
+    cap.text.clear();
+    feed(sh, source + "!2 .\n");
+    return cap.text;
+}
+
+/**
+ * @brief run a script, untagged
+ * @return the output, then the trace of the commands after a '#'
+ */
+static std::string run(const char *name, const ShellIndex &index = s_index)
+{
+    CaptureOutput cap;
+    ShellEngine sh(index, cap);
+    s_trace.clear();
+    feed(sh, std::string("script run ") + name + "\n");
+    return cap.text + "#" + s_trace;
+}
+
+static void expect_load(const char *name, const std::string &source, const std::string &reply)
+{
+    const std::string got = load(name, source);
+    if (got != reply)
+    {
+        fail("load %s gave \"%s\", not \"%s\"", name, got.c_str(), reply.c_str());
+    }
+}
+
+/**
+ * @brief a source the compiler refuses with `message`
+ */
+static void expect_refused(const std::string &source, const std::string &message, const std::string &reason)
+{
+    expect_load("bad", source, "!2:" + message + "\r\n!2=err " + reason + "\r\n");
+}
+
+static void expect_run(const char *name, const std::string &out, const ShellIndex &index = s_index)
+{
+    const std::string got = run(name, index);
+    if (got != out)
+    {
+        fail("run %s gave \"%s\", not \"%s\"", name, got.c_str(), out.c_str());
+    }
+}
+
+static std::string ok_reply(const char *name, uint32_t ops, uint32_t bytes, uint32_t lines)
+{
+    return "!2:" + std::string(name) + ": " + std::to_string(ops) + " ops " + std::to_string(bytes) + " B from " +
+           std::to_string(lines) + " lines\r\n!2=ok\r\n";
+}
+
+/**
+ * @brief the address of the slot holding `name`, read from the image
+ */
+static uint32_t slot_of(FlashSimImpl &sim, const char *name)
+{
+    for (uint32_t a = SCRIPT_BASE; a < FLASH_SIZE; a += SHELL_SCRIPT_SLOT)
+    {
+        ShellScriptHeader h;
+        memcpy(&h, &sim.map()[a], sizeof(h));
+        if (h.magic == SHELL_SCRIPT_MAGIC and strcmp(h.name, name) == 0)
+        {
+            return a;
+        }
+    }
+    fail("no slot holds %s", name);
+    return SCRIPT_BASE;
+}
+
+static void check(FlashSimImpl &sim, FlashIntf &flash)
+{
+    ShellScriptStore store(flash, SCRIPT_BASE, SCRIPT_AREA);
+    alignas(4) static uint8_t code[SHELL_SCRIPT_CODE_MAX];
+    ShellScriptCompiler compiler(s_index, code, sizeof(code));
+    ShellScriptLoader loader(compiler, store);
+    s_store  = &store;
+    s_loader = &loader;
+    for (uint32_t a = SCRIPT_BASE; a < FLASH_SIZE; a += 4096U)
+    {
+        (void)sim.erase_sector(a);
+    }
+
+    // plain loading, with the hint for a person
+    {
+        CaptureOutput cap;
+        ShellEngine sh(s_index, cap);
+        feed(sh, "script load hi\necho hello   world\n  # a comment, \"unbalanced\n\n.\n");
+        const std::string want = "end with a line holding only \".\"\r\nhi: 1 ops 32 B from 3 lines\r\n";
+        if (cap.text != want)
+        {
+            fail("plain load gave \"%s\"", cap.text.c_str());
+        }
+        cap.text.clear();
+        feed(sh, "echo after\n");
+        if (cap.text != "after\r\n")
+        {
+            fail("the line after the load gave \"%s\"", cap.text.c_str());
+        }
+    }
+    expect_run("hi", "hello world\r\n#echo(hello world)");
+
+    // one load at a time: a second session waits for the "." of the first
+    {
+        CaptureOutput capA;
+        CaptureOutput capB;
+        ShellEngine a(s_index, capA);
+        ShellEngine b(s_index, capB);
+        feed(a, "!1 script load one\necho a\n");
+        feed(b, "!2 script load two\n");
+        feed(a, "!3 .\n");
+        feed(b, "!4 script load two\necho b\n!5 .\n");
+        feed(a, "!6 script rm one\n!7 script rm two\n");
+        if (capA.text != "!1=ok\r\n!3:one: 1 ops 20 B from 1 lines\r\n!3=ok\r\n!6=ok\r\n!7=ok\r\n" or
+            capB.text != "!2=err another session is loading a script\r\n!4=ok\r\n"
+                          "!5:two: 1 ops 20 B from 1 lines\r\n!5=ok\r\n")
+        {
+            fail("two loads at once gave \"%s\" and \"%s\"", capA.text.c_str(), capB.text.c_str());
+        }
+    }
+
+    // typed arguments parsed at load time, texts kept
+    expect_load("args", "add 40 2\nadd -1 -2 7\nsay \"a b\" c\nsay x\nled green on\nled red 0\n",
+                ok_reply("args", 6, 156, 6));
+    expect_run("args", "#add(42)add(-3x7)say(a b,c)say(x)led(green,on)led(red,off)");
+
+    // blocks
+    expect_load("loop", "repeat 3\n  add 1 1\nend\nrepeat 2\n  repeat 2\n    echo in\n  end\n  say out\nend\n",
+                ok_reply("loop", 9, 148, 9));
+    expect_run("loop", "in\r\nin\r\nin\r\nin\r\n#add(2)add(2)add(2)echo(in)echo(in)say(out)echo(in)echo(in)say(out)");
+    expect_load("cond",
+                "try boom\nif fail\n  say failed\nelse\n  say fine\nend\nif ok\n  say ok1\nend\n"
+                "add 0 0\nif ok\n  say ok2\nelse\n  say never\nend\nexit\nsay after\n",
+                ok_reply("cond", 14, 296, 17));
+    expect_run("cond", "#boomsay(failed)say(ok1)add(0)say(ok2)");
+
+    // a failure stops the script at its line
+    expect_load("stop", "add 1 2\nboom\nadd 3 4\n", ok_reply("stop", 3, 68, 3));
+    expect_run("stop", "line 2: boom\r\nerr boom\r\n#add(3)boom");
+
+    // refused at load time
+    expect_refused("add 1 2\nnope 1\n", "line 2: unknown command", "unknown command");
+    expect_refused("\nadd 1 x\n", "line 2: bad argument: argument 2 <int>: \"x\"", "bad argument");
+    expect_refused("add 1\n", "line 1: missing argument: add <int> <int> [uint]", "missing argument");
+    expect_refused("led blue on\n", "line 1: bad argument: argument 1 <red|green>: \"blue\"", "bad argument");
+    expect_refused("repeat 2\nadd 1 1\n", "line 2: missing end", "missing end");
+    expect_refused("end\n", "line 1: end without a block", "end without a block");
+    expect_refused("repeat 2\nelse\nend\n", "line 2: else without if", "else without if");
+    expect_refused("if maybe\n", "line 1: usage: if ok|fail", "usage: if ok|fail");
+    expect_refused("repeat x\n", "line 1: usage: repeat <n>", "usage: repeat <n>");
+    expect_refused("try\n", "line 1: usage: try <command>", "usage: try <command>");
+    expect_refused("add 1 2 &\n", "line 1: no jobs or pipelines in a script", "no jobs or pipelines in a script");
+    expect_refused("echo a | echo\n", "line 1: no jobs or pipelines in a script", "no jobs or pipelines in a script");
+    expect_refused("script run hi\n", "line 1: scripts do not nest", "scripts do not nest");
+    expect_refused("echo \"open\n", "line 1: unterminated quote", "unterminated quote");
+    expect_refused(std::string("repeat 1\n") + "repeat 1\n" + "repeat 1\n" + "repeat 1\n" + "repeat 1\n" +
+                       "repeat 1\n" + "repeat 1\n" + "repeat 1\n" + "repeat 1\n",
+                   "line 9: blocks nested too deep", "blocks nested too deep");
+    {
+        std::string big;
+        for (uint32_t i = 0; i < SHELL_SCRIPT_CODE_MAX / 16U; i++)
+        {
+            big += "add 1 2\n";
+        }
+        const std::string got = load("big", big);
+        if (got.find("=err script too long") == std::string::npos)
+        {
+            fail("an oversized script gave \"%s\"", got.c_str());
+        }
+    }
+
+    // the store
+    expect_load("hi", "echo again\n", ok_reply("hi", 1, 24, 1));
+    expect_run("hi", "again\r\n#echo(again)");
+    {
+        CaptureOutput cap;
+        ShellEngine sh(s_index, cap);
+        feed(sh, "script list\n");
+        const std::string want = "args              156 B    6 ops    6 lines\r\n"
+                                 "loop              148 B    9 ops    9 lines\r\n"
+                                 "cond              296 B   14 ops   17 lines\r\n"
+                                 "stop               68 B    3 ops    3 lines\r\n"
+                                 "hi                 24 B    1 ops    1 lines\r\n"
+                                 "5 of 16 slots used\r\n";
+        if (cap.text != want)
+        {
+            fail("list gave \"%s\"", cap.text.c_str());
+        }
+        cap.text.clear();
+        feed(sh, "!3 script rm loop\n!4 script rm loop\n!5 script run loop\n");
+        if (cap.text != "!3=ok\r\n!4=err no such script\r\n!5=err no such script\r\n")
+        {
+            fail("rm gave \"%s\"", cap.text.c_str());
+        }
+    }
+    for (uint32_t i = 0; i < store.slots_getter(); i++)
+    {
+        const std::string name = "s" + std::to_string(i);
+        const std::string got  = load(name.c_str(), "add 1 1\n");
+        const bool full        = got.find("=err no free script slot") != std::string::npos;
+        if (full != (i >= store.slots_getter() - 4U))
+        {
+            fail("load %s into a store of %lu slots gave \"%s\"", name.c_str(),
+                 static_cast<unsigned long>(store.slots_getter()), got.c_str());
+        }
+    }
+    expect_load("s0", "add 2 2\n", ok_reply("s0", 1, 28, 1)); // replaced in place when full
+    expect_run("s0", "#add(4)");
+
+    // damage: a flipped bit, another command table, a header never written
+    {
+        const uint32_t slot = slot_of(sim, "hi");
+        const uint8_t zero  = 0x00U;
+        expect_run("hi", "again\r\n#echo(again)");
+        expect_run("hi", "err compiled for other commands, load it again\r\n#", s_other_table.index());
+        (void)sim.program(slot + SHELL_SCRIPT_CODE + 20U, &zero, 1U);
+        expect_run("hi", "err script corrupt\r\n#");
+        (void)sim.erase_sector(slot);
+        (void)sim.program(slot + SHELL_SCRIPT_CODE, code, 16U); // code without its header
+        expect_run("hi", "err no such script\r\n#");
+    }
+    if (sim.stats_getter().violations != 0U)
+    {
+        fail("%llu bits raised by a program", static_cast<unsigned long long>(sim.stats_getter().violations));
+    }
+    s_store  = nullptr;
+    s_loader = nullptr;
+}
+
+/**
+ * @brief the same commands as text and as a script, ns per command
+ */
+static void measure(FlashSimImpl &sim, FlashIntf &flash, const char *what)
+{
+    ShellScriptStore store(flash, SCRIPT_BASE, SCRIPT_AREA);
+    alignas(4) static uint8_t code[SHELL_SCRIPT_CODE_MAX];
+    ShellScriptCompiler compiler(s_index, code, sizeof(code));
+    ShellScriptLoader loader(compiler, store);
+    s_store  = &store;
+    s_loader = &loader;
+
+    const char *const body[] = {"acc 24000000 16", "acc 0x40 0x1000", "acc DEADBEEF 4294967295", "acc 1 2"};
+    const uint32_t rounds    = opt.commands / 4U;
+    std::string text;
+    for (const char *line : body)
+    {
+        text += std::string(line) + "\n";
+    }
+    expect_load("bench", "repeat " + std::to_string(rounds) + "\n" + text + "end\n", ok_reply("bench", 6, 104, 6));
+
+    CaptureOutput cap;
+    ShellEngine sh(s_index, cap);
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        feed(sh, text);
+    }
+    const double textNs = ns_since(t0, 4ULL * rounds);
+
+    const uint64_t readBytes = sim.stats_getter().readBytes;
+    t0                       = std::chrono::steady_clock::now();
+    feed(sh, "script run bench\n");
+    const double scriptNs = ns_since(t0, 4ULL * rounds);
+    if (not cap.text.empty())
+    {
+        fail("the benchmark printed \"%s\"", cap.text.c_str());
+    }
+    const uint64_t read = sim.stats_getter().readBytes - readBytes;
+    printf("%-9s text %6.1f ns/cmd   script %6.1f ns/cmd  (%.1fx)   %llu ops, %.1f B read()/cmd\n", what, textNs,
+           scriptNs, textNs / scriptNs, static_cast<unsigned long long>(store.stats_getter().ops),
+           static_cast<double>(read) / (4.0 * rounds));
+    s_store  = nullptr;
+    s_loader = nullptr;
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.commands = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.commands < 4U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FlashSimImpl sim(FLASH_SIZE);
+    FlashNoWindow noWindow(sim);
+    if (sim.enable() != FlashErrCode::FLASH_SUCCESS or noWindow.enable() != FlashErrCode::FLASH_SUCCESS)
+    {
+        fprintf(stderr, "no flash\n");
+        return 1;
+    }
+    check(sim, sim);
+    check(sim, noWindow);
+    measure(sim, sim, "window");
+    measure(sim, noWindow, "read()");
+
+    return check_summary();
+}
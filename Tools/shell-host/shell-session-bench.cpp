@@ -0,0 +1,650 @@
+/**
+ * @file        shell-session-bench.cpp
+ * @brief       Host checks of two shell sessions side by side, each on a memory transport and its own threads
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./shell-session-bench [-n lines]
+ *
+ *              Builds Applications/Shell/shell-session.cpp unchanged with
+ *              two sessions "a" and "b" on one command table: the handlers
+ *              of the firmware (shell-builtins.cpp, the filters, set, unset,
+ *              sessions) and `nap`, gathered by the linker
+ *              (Tools/app-host/app-host.ld). A transport is
+ *              a byte queue in, the replies out; a session runs on a thread
+ *              of its own, its workers on three more, the job port is
+ *              condition variables standing in for the thread flags and the
+ *              semaphore of shell-cdc.cpp.
+ *
+ *              Checks: the variables of a session are its own, "$name"
+ *              words take them, set refuses bad names, long values and a
+ *              full table; a line half typed on one session is not touched
+ *              by the lines of the other, the history of each holds its own
+ *              lines only; both run a slow command at the same time; each
+ *              has its own job table, `jobs` of one does not list the jobs
+ *              of the other; keys typed during `fg` are held and run after
+ *              it, ^C stops the job of its session only; `sessions` lists
+ *              both. Then both are fed the same number of tagged lines at
+ *              once, in chunks of random size, plus a pipeline each: every
+ *              reply arrives on its own transport, whole and in order.
+ *
+ *              Then measures tagged lines per second through one session
+ *              alone and through both at once (twice as many with two
+ *              cores or more), and prints the memory of a
+ *              session, part by part (host sizes, pointers are 8 bytes).
+ *
+ *              Exits non zero on a failed check.
+ *
+ * @author      MekLi
+ * @date        2025/9/20
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/Shell/shell-args.hpp"
+#include "../../Applications/Shell/shell-session.hpp"
+#include "../host-test.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t WAIT_MS = 3000U; // a reply not there by then is missing
+
+/**
+ * @brief the thread flags of a task
+ */
+struct Waiter
+{
+    std::mutex m;
+    std::condition_variable cv;
+    bool woken = false;
+};
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t lines = 20000;
+} opt;
+
+static thread_local Waiter t_waiter;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n lines]\n"
+            "  checks two shell sessions running side by side, times tagged lines through one and both\n",
+            argv0);
+}
+
+static double ms_since(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static void signal(Waiter &w)
+{
+    std::lock_guard<std::mutex> l(w.m);
+    w.woken = true;
+    w.cv.notify_one();
+}
+
+static void sleep_on(Waiter &w, uint32_t ms)
+{
+    std::unique_lock<std::mutex> l(w.m);
+    w.cv.wait_for(l, std::chrono::milliseconds(ms), [&w] { return w.woken; });
+    w.woken = false;
+}
+
+/**
+ * @brief the thread flags and the worker semaphore of one session
+ */
+class SessionPort : public ShellJobPort
+{
+  public:
+    void post() override
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _posts++;
+        _work.notify_one();
+    }
+
+    void *self() override
+    {
+        return &t_waiter;
+    }
+
+    void wake(void *task) override
+    {
+        signal(*static_cast<Waiter *>(task));
+    }
+
+    /**
+     * @brief the session thread reads its transport while it waits, like the task
+     */
+    bool wait(uint32_t ms) override
+    {
+        sleep_on(t_waiter, ms);
+        return &t_waiter == shell.load() and session->hold();
+    }
+
+    /**
+     * @brief bytes arrived: the receive interrupt
+     */
+    void rx()
+    {
+        Waiter *w = shell.load();
+        if (w != nullptr)
+        {
+            signal(*w);
+        }
+    }
+
+    /**
+     * @brief a worker sleeps until a post, false once stopped
+     */
+    bool acquire()
+    {
+        std::unique_lock<std::mutex> l(_m);
+        _work.wait(l, [this] { return _posts != 0U or _quit; });
+        if (_posts == 0U)
+        {
+            return false;
+        }
+        _posts--;
+        return true;
+    }
+
+    void quit()
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _quit = true;
+        _work.notify_all();
+    }
+
+    std::atomic<Waiter *> shell{nullptr};
+    ShellSession *session = nullptr;
+
+  private:
+    std::mutex _m;
+    std::condition_variable _work;
+    uint32_t _posts = 0;
+    bool _quit      = false;
+};
+
+/**
+ * @brief the link: what the far end typed, and what reached it
+ */
+class MemoryTransport : public ShellTransport
+{
+  public:
+    explicit MemoryTransport(SessionPort &port) : _port(port)
+    {
+    }
+
+    uint32_t read(uint8_t *buf, uint32_t len) override
+    {
+        std::lock_guard<std::mutex> l(_m);
+        const uint32_t n = std::min<uint32_t>(len, static_cast<uint32_t>(_in.size() - _pos));
+        memcpy(buf, _in.data() + _pos, n);
+        _pos += n;
+        if (_pos == _in.size())
+        {
+            _in.clear();
+            _pos = 0;
+        }
+        return n;
+    }
+
+    void write(const char *buf, uint32_t len) override
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _pending.append(buf, len);
+        writes++;
+    }
+
+    void flush() override
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _wire += _pending;
+        _pending.clear();
+        _seen.notify_all();
+    }
+
+    /**
+     * @brief the far end types keys
+     */
+    void send(std::string_view keys)
+    {
+        {
+            std::lock_guard<std::mutex> l(_m);
+            _in.append(keys.data(), keys.size());
+        }
+        _port.rx();
+    }
+
+    /**
+     * @brief what reached the far end, once it holds text; then cleared
+     * @return empty when text did not come within ms
+     */
+    std::string take(std::string_view text, uint32_t ms = WAIT_MS)
+    {
+        std::unique_lock<std::mutex> l(_m);
+        const bool got = _seen.wait_for(l, std::chrono::milliseconds(ms),
+                                        [&] { return _wire.find(text) != std::string::npos; });
+        std::string out;
+        out.swap(_wire);
+        return got ? out : std::string();
+    }
+
+    /**
+     * @brief the far end read everything sent so far
+     */
+    bool idle()
+    {
+        std::lock_guard<std::mutex> l(_m);
+        return _in.empty();
+    }
+
+    uint32_t writes = 0;
+
+  private:
+    SessionPort &_port;
+    std::mutex _m;
+    std::condition_variable _seen;
+    std::string _in;
+    size_t _pos = 0;
+    std::string _pending;
+    std::string _wire;
+};
+
+
+/* ------- commands --------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief sleep, looking at sh.cancelled() every millisecond
+ */
+static const char *cmd_nap(ShellEngine &sh, uint32_t ms)
+{
+    const Clock::time_point t0 = Clock::now();
+    while (ms_since(t0) < ms)
+    {
+        if (sh.cancelled())
+        {
+            return "stopped";
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return nullptr;
+}
+
+SHELL_COMMAND(nap, cmd_nap, "");
+
+/* nap, the built-ins (echo, jobs, fg, ...), set/unset, sessions/mode and the filters, as the linker gathered them */
+static const ShellIndex s_index = shell_registered_index();
+
+
+/* ------- sessions --------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief a session with its threads: the task and its workers
+ */
+struct HostSession
+{
+    explicit HostSession(std::string_view name) : link(port), session(name, s_index, link, port)
+    {
+        port.session = &session;
+    }
+
+    void start()
+    {
+        task = std::thread([this] {
+            port.shell.store(&t_waiter);
+            while (not stop.load())
+            {
+                if (not session.poll())
+                {
+                    sleep_on(t_waiter, 20);
+                }
+            }
+        });
+        for (uint32_t i = 0; i < SHELL_SESSION_WORKERS; i++)
+        {
+            workers[i] = std::thread([this, i] {
+                while (port.acquire())
+                {
+                    (void)session.worker_getter(i).run();
+                }
+            });
+        }
+    }
+
+    void join()
+    {
+        stop.store(true);
+        port.rx();
+        port.quit();
+        task.join();
+        for (std::thread &w : workers)
+        {
+            w.join();
+        }
+    }
+
+    /**
+     * @brief send lines, take what came back once it holds until
+     */
+    std::string ask(std::string_view lines, std::string_view until, uint32_t ms = WAIT_MS)
+    {
+        link.send(lines);
+        return link.take(until, ms);
+    }
+
+    SessionPort port;
+    MemoryTransport link;
+    ShellSession session;
+    std::thread task;
+    std::thread workers[SHELL_SESSION_WORKERS];
+    std::atomic<bool> stop{false};
+};
+
+static void expect(HostSession &s, std::string_view lines, std::string_view want)
+{
+    const std::string got = s.ask(lines, want);
+    if (got.find(want) == std::string::npos)
+    {
+        fail("%.*s: \"%.*s\" got no \"%.*s\"", static_cast<int>(s.session.name_getter().size()),
+             s.session.name_getter().data(), static_cast<int>(lines.size() - 1U), lines.data(),
+             static_cast<int>(want.size()), want.data());
+    }
+}
+
+/**
+ * @brief the replies of lines tagged first to first + n - 1: "!<i> echo <p><i>"
+ */
+static void tagged_lines(std::string &in, std::string &out, const char *p, uint32_t first, uint32_t n)
+{
+    for (uint32_t i = first; i < first + n; i++)
+    {
+        char buf[64];
+        in.append(buf, static_cast<size_t>(snprintf(buf, sizeof(buf), "!%u echo %s%u\n", i, p, i)));
+        out.append(buf, static_cast<size_t>(snprintf(buf, sizeof(buf), "!%u:%s%u\r\n!%u=ok\r\n", i, p, i, i)));
+    }
+}
+
+/**
+ * @brief send in in chunks of 1 to 300 bytes, as a link delivers it
+ */
+static void feed_chunks(HostSession &s, const std::string &in, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    for (size_t at = 0; at < in.size();)
+    {
+        const size_t n = std::min<size_t>(1U + rng() % 300U, in.size() - at);
+        s.link.send(std::string_view(in).substr(at, n));
+        at += n;
+        while (not s.link.idle())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static void check_variables(HostSession &a, HostSession &b)
+{
+    expect(a, "!1 set x alpha\n", "!1=ok\r\n");
+    expect(a, "!2 echo $x\n", "!2:alpha\r\n!2=ok\r\n");
+    expect(b, "!3 echo $x\n", "!3=err unknown variable\r\n");
+    expect(b, "!4 set x \"b e t a\"\n", "!4=ok\r\n");
+    expect(b, "!5 echo $x\n", "!5:b e t a\r\n!5=ok\r\n");
+    expect(a, "!6 set\n", "!6:x=alpha\r\n!6=ok\r\n");
+    expect(a, "!7 set y $x\n", "!7=ok\r\n");
+    expect(a, "!8 set y\n", "!8:alpha\r\n!8=ok\r\n");
+    expect(a, "!9 set 1y z\n", "!9=err bad variable name\r\n");
+    expect(a, "!10 set abcdefghijklm z\n", "!10=err name too long\r\n");
+    expect(a, "!11 set z " + std::string(SHELL_ENV_VALUE + 1U, 'v') + "\n", "!11=err value too long\r\n");
+    for (uint32_t i = 2; i < SHELL_ENV_VARS; i++)
+    {
+        expect(a, "!12 set v" + std::to_string(i) + " " + std::to_string(i) + "\n", "!12=ok\r\n");
+    }
+    expect(a, "!13 set full 1\n", "!13=err no room for variables\r\n");
+    expect(a, "!14 unset y\n", "!14=ok\r\n");
+    expect(a, "!15 echo $y\n", "!15=err unknown variable\r\n");
+    expect(a, "!16 unset y\n", "!16=err unknown variable\r\n");
+    expect(a, "!17 nap 1 &\n", "!17:[1]\r\n");
+    (void)a.ask("!18 fg\n", "!18=ok\r\n");
+    if (a.session.env_getter().count_getter() != SHELL_ENV_VARS - 1U or b.session.env_getter().count_getter() != 1U)
+    {
+        fail("variables a %u b %u", a.session.env_getter().count_getter(), b.session.env_getter().count_getter());
+    }
+}
+
+static void check_editors(HostSession &a, HostSession &b)
+{
+    a.link.send("ec");
+    std::string got = b.ask("echo bee\r", "bee\r\n");
+    if (got.find("bee\r\n") == std::string::npos)
+    {
+        fail("b: typed line got no reply");
+    }
+    got = a.ask("ho ay\r", "ay\r\n");
+    if (got.find("ho ay") == std::string::npos or got.find("ay\r\n") == std::string::npos)
+    {
+        fail("a: the half typed line was not kept");
+    }
+
+    char line[SHELL_LINE_MAX];
+    ShellHistory &ha = a.session.editor_getter().history_getter();
+    ShellHistory &hb = b.session.editor_getter().history_getter();
+    if (ha.count_getter() != 1U or std::string_view(line, ha.copy(ha.newest(), line)) != "echo ay")
+    {
+        fail("a: history holds %u lines", ha.count_getter());
+    }
+    if (hb.count_getter() != 1U or std::string_view(line, hb.copy(hb.newest(), line)) != "echo bee")
+    {
+        fail("b: history holds %u lines", hb.count_getter());
+    }
+}
+
+static void check_jobs(HostSession &a, HostSession &b)
+{
+    // both at once: no lock between the sessions
+    Clock::time_point t0 = Clock::now();
+    a.link.send("!20 nap 300\n");
+    b.link.send("!21 nap 300\n");
+    const bool done = not a.link.take("!20=ok").empty() and not b.link.take("!21=ok").empty();
+    const double ms = ms_since(t0);
+    if (not done or ms > 450.0)
+    {
+        fail("two naps of 300 ms took %.0f ms", ms);
+    }
+    printf("two sessions, a nap of 300 ms each: %.0f ms\n", ms);
+
+    expect(a, "!22 nap 400 &\n", "!22:[1]\r\n");
+    std::string got = b.ask("!23 jobs\n", "!23=");
+    if (got.find("nap") != std::string::npos or got.find("!23=ok") == std::string::npos)
+    {
+        fail("b lists the job of a");
+    }
+    expect(b, "!24 nap 10 &\n", "!24:[1]\r\n");
+    expect(b, "!25 fg\n", "!25=ok\r\n");
+    expect(a, "!26 jobs\n", "nap 400");
+    expect(a, "!27 fg\n", "!27=ok\r\n");
+
+    // keys typed during fg wait for it
+    t0 = Clock::now();
+    a.link.send("nap 200 &\rfg\r");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    got = a.ask("echo later\r", "later\r\n");
+    if (got.find("later\r\n") == std::string::npos or ms_since(t0) < 180.0)
+    {
+        fail("a: keys typed during fg ran at %.0f ms", ms_since(t0));
+    }
+
+    // ^C stops the job of its session
+    expect(a, "!28 nap 5000 &\n", "!28:[1]\r\n");
+    expect(b, "!29 nap 5000 &\n", "!29:[1]\r\n");
+    a.link.send("!30 fg\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    t0 = Clock::now();
+    got = a.ask("\x03", "!30=");
+    if (got.find("!30=err killed") == std::string::npos or ms_since(t0) > 1000.0)
+    {
+        fail("a: ^C in fg: \"%s\"", got.c_str());
+    }
+    expect(b, "!31 jobs\n", "running");
+    b.link.send("!32 fg\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    b.link.send("\x03");
+    (void)b.link.take("!32=");
+}
+
+static void check_sessions(HostSession &a, HostSession &b)
+{
+    const std::string got = a.ask("!40 sessions\n", "!40=");
+    if (got.find("!40:*a ") == std::string::npos or got.find("!40: b ") == std::string::npos)
+    {
+        fail("sessions: \"%s\"", got.c_str());
+    }
+    (void)b;
+}
+
+/**
+ * @brief n tagged lines through each session, the sessions fed at once
+ * @return lines per second, both sessions together
+ */
+static double stream(HostSession **s, uint32_t count, uint32_t n, uint32_t first)
+{
+    std::string in[2];
+    std::string want[2];
+    for (uint32_t k = 0; k < count; k++)
+    {
+        tagged_lines(in[k], want[k], k == 0U ? "a" : "b", first, n);
+    }
+    const Clock::time_point t0 = Clock::now();
+    std::thread feeders[2];
+    for (uint32_t k = 0; k < count; k++)
+    {
+        feeders[k] = std::thread([&, k] { feed_chunks(*s[k], in[k], 7U + k); });
+    }
+    std::string got[2];
+    for (uint32_t k = 0; k < count; k++)
+    {
+        feeders[k].join();
+    }
+    const std::string last = "!" + std::to_string(first + n - 1U) + "=ok\r\n";
+    for (uint32_t k = 0; k < count; k++)
+    {
+        got[k] = s[k]->link.take(last, 20000U);
+    }
+    const double ms = ms_since(t0);
+    for (uint32_t k = 0; k < count; k++)
+    {
+        if (got[k] != want[k])
+        {
+            size_t at = 0;
+            while (at < got[k].size() and at < want[k].size() and got[k][at] == want[k][at])
+            {
+                at++;
+            }
+            fail("%.*s: %zu bytes of %zu, first difference at %zu",
+                 static_cast<int>(s[k]->session.name_getter().size()), s[k]->session.name_getter().data(),
+                 got[k].size(), want[k].size(), at);
+        }
+    }
+    return count * n * 1000.0 / ms;
+}
+
+static void check_pipelines(HostSession &a, HostSession &b)
+{
+    uint32_t sevens = 0;
+    uint32_t bytes  = 0;
+    for (uint32_t i = 1; i <= 50000U; i++)
+    {
+        const std::string d = std::to_string(i);
+        if (d.find('7') != std::string::npos)
+        {
+            sevens++;
+            bytes += static_cast<uint32_t>(d.size());
+        }
+    }
+    a.link.send("!50 seq 50000 | count\n");
+    b.link.send("!51 seq 50000 | grep 7 | count\n");
+    const std::string ga = a.link.take("!50=");
+    const std::string gb = b.link.take("!51=");
+    if (ga.find("!50:50000 lines 238894 bytes\r\n!50=ok") == std::string::npos)
+    {
+        fail("a: pipeline \"%s\"", ga.c_str());
+    }
+    const std::string wb = "!51:" + std::to_string(sevens) + " lines " + std::to_string(bytes) + " bytes\r\n!51=ok";
+    if (gb.find(wb) == std::string::npos)
+    {
+        fail("b: pipeline \"%s\"", gb.c_str());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n': opt.lines = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.lines == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static HostSession a("a");
+    static HostSession b("b");
+    static ShellSession *const list[] = {&a.session, &b.session};
+    shell_sessions_bind(list, 2);
+    a.start();
+    b.start();
+
+    check_variables(a, b);
+    check_editors(a, b);
+    check_jobs(a, b);
+    check_sessions(a, b);
+    check_pipelines(a, b);
+
+    HostSession *both[2] = {&a, &b};
+    HostSession *one[1]  = {&a};
+    const double alone   = stream(one, 1, opt.lines, 1000U);
+    const double side    = stream(both, 2, opt.lines, 1000U + opt.lines);
+    a.join();
+    b.join();
+
+    printf("tagged lines   one session %8.0f/s   two at once %8.0f/s (x%.2f, %u cores)\n", alone, side,
+           side / alone, std::thread::hardware_concurrency());
+    printf("a session      %6zu B: engine %zu, editor %zu, variables %zu, jobs %zu, workers %u x %zu, "
+           "buffers %u, frame %u\n",
+           sizeof(ShellSession), sizeof(ShellEngine), sizeof(ShellEditor), sizeof(ShellEnv), sizeof(ShellJobs),
+           SHELL_SESSION_WORKERS, sizeof(ShellWorker), 2U * SHELL_SESSION_RX,
+           SHELL_FRAME_MAX);
+
+    return check_summary();
+}
@@ -0,0 +1,177 @@
+/**
+ * @file        sof-sim.cpp
+ * @brief       Host check of the SOF clock estimator against synthetic SOF sequences
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./sof-sim [-s seconds] [-p ppm] [-j jitter_us] [-r seed] [-v]
+ *
+ *              Generates the SOF stamps a device would see: a core clock
+ *              off by `ppm` and wandering slowly, an interrupt latency with
+ *              exponential jitter, rare long latencies (masked interrupts),
+ *              missing SOFs and one bus reset. Stamps are wrapped to 11-bit
+ *              frames and 32-bit cycles and go through SofUnwrap and
+ *              SofEstimator exactly like in Applications/Sync/sof-sync.cpp.
+ *
+ *              After each lock, device times are converted back to the host
+ *              frame clock and compared with the truth. Prints the error
+ *              distribution and exits non zero if the worst error exceeds
+ *              the 100 us budget, so it doubles as a CI check.
+ *
+ * @author      MekLi
+ * @date        2025/9/5
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "sof-estimator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+#define CORE_HZ         550e6
+#define BUDGET_US       100.0
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    int      seconds   = 120;
+    double   ppm       = 37.0;
+    double   jitter_us = 0.5;
+    unsigned seed      = 1;
+    bool     verbose   = false;
+} opt;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-s seconds] [-p ppm] [-j jitter_us] [-r seed] [-v]\n"
+            "  -s  simulated time (default %d s)\n"
+            "  -p  crystal error of the device (default %.1f ppm)\n"
+            "  -j  mean of the exponential interrupt latency jitter (default %.2f us)\n"
+            "  -r  random seed (default %u)\n"
+            "  -v  print the estimator state every second\n",
+            argv0, opt.seconds, opt.ppm, opt.jitter_us, opt.seed);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "s:p:j:r:vh")) != -1)
+    {
+        switch (c)
+        {
+        case 's': opt.seconds = atoi(optarg); break;
+        case 'p': opt.ppm = atof(optarg); break;
+        case 'j': opt.jitter_us = atof(optarg); break;
+        case 'r': opt.seed = (unsigned)strtoul(optarg, nullptr, 0); break;
+        case 'v': opt.verbose = true; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    std::mt19937_64 rng(opt.seed);
+    std::exponential_distribution<double> jitter(1.0 / (opt.jitter_us * 1e-6 * CORE_HZ));
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    const double base_latency = 0.3e-6 * CORE_HZ; // entry + stamping
+    SofEstimator::Config cfg  = SofEstimator::default_config(CORE_HZ);
+    SofEstimator est(cfg);
+    SofUnwrap unwrap;
+
+    const int64_t frames   = static_cast<int64_t>(opt.seconds) * 1000;
+    const int64_t reset_at = frames / 2; // bus reset: 30 ms silence, frame counter restarts
+    double device_cycles   = 12345.0; // true device time at the start of the current frame
+    uint32_t host_frame    = 0;       // 11-bit counter sent by the host
+    std::vector<double> errors_us;
+    uint64_t rejected = 0, missing = 0, long_latency = 0;
+
+    for (int64_t k = 0; k < frames; k++)
+    {
+        /* device clock: static error plus a slow +-2 ppm thermal wander */
+        const double ppm = opt.ppm + 2.0 * std::sin(2.0 * M_PI * static_cast<double>(k) / 60000.0);
+        const double period = CORE_HZ / 1000.0 * (1.0 + ppm * 1e-6);
+
+        if (k == reset_at)
+        {
+            device_cycles += 30.0 * period;
+            host_frame = 0x123;
+            est.reset(); // what the USB reset callback does on the device
+            unwrap.reset();
+        }
+
+        /* check the conversion before the sample is used: pure prediction */
+        if (est.locked())
+        {
+            const double at = device_cycles + unit(rng) * period; // anywhere in the frame
+            const int64_t at64 = unwrap.cycles_of(static_cast<uint32_t>(static_cast<uint64_t>(at)));
+            const double est_frame = est.cycles_to_frame(at64);
+            const double est_rel   = est_frame - static_cast<double>(unwrap.frame());
+            const double true_rel  = static_cast<double>((host_frame - (unwrap.frame() & 0x7FF)) & 0x7FF) +
+                                    (at - device_cycles) / period;
+            const double err_us = (est_rel - true_rel) * 1000.0;
+            errors_us.push_back(std::fabs(err_us));
+            if (opt.verbose and k % 1000 == 0)
+            {
+                printf("t=%6.1fs drift %+8.3f ppm (true %+8.3f) jitter %6.3f us err %+8.3f us\n", k / 1000.0,
+                       est.drift_ppm(), ppm, est.jitter_rms() / CORE_HZ * 1e6, err_us);
+            }
+        }
+
+        /* one SOF, unless lost */
+        if (unit(rng) < 0.001)
+        {
+            missing++;
+        }
+        else
+        {
+            double latency = base_latency + jitter(rng);
+            if (unit(rng) < 0.01)
+            {
+                latency += (5e-6 + 45e-6 * unit(rng)) * CORE_HZ; // masked interrupts
+                long_latency++;
+            }
+            const uint64_t stamp = static_cast<uint64_t>(device_cycles + latency);
+            unwrap.feed(host_frame, static_cast<uint32_t>(stamp));
+            if (not est.update(unwrap.frame(), unwrap.cycles()))
+            {
+                rejected++;
+            }
+        }
+
+        device_cycles += period;
+        host_frame = (host_frame + 1U) & 0x7FFU;
+    }
+
+    if (errors_us.empty())
+    {
+        printf("never locked\n");
+        return 1;
+    }
+    std::sort(errors_us.begin(), errors_us.end());
+    const double p50 = errors_us[errors_us.size() / 2];
+    const double p99 = errors_us[errors_us.size() * 99 / 100];
+    const double max = errors_us.back();
+
+    printf("frames %lld, missing %llu, long latency %llu, rejected %llu\n", static_cast<long long>(frames),
+           static_cast<unsigned long long>(missing), static_cast<unsigned long long>(long_latency),
+           static_cast<unsigned long long>(rejected));
+    printf("drift estimate %+.3f ppm, residual rms %.3f us\n", est.drift_ppm(), est.jitter_rms() / CORE_HZ * 1e6);
+    printf("|device -> host frame time| error us: p50 %.3f  p99 %.3f  max %.3f  (budget %.0f)\n", p50, p99, max,
+           BUDGET_US);
+    return max <= BUDGET_US ? 0 : 1;
+}
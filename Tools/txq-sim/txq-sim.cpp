@@ -0,0 +1,555 @@
+/**
+ * @file        txq-sim.cpp
+ * @brief       Host check of the transmit scheduler against synthetic traffic mixes
+ *
+ * @attention   Linux or any C++17 host compiler. Built by Tools/CMakeLists.txt, run:
+ *
+ *                  ./txq-sim [-s seconds] [-b link_bytes_per_s] [-i interactive_gap_us] [-r seed]
+ *
+ *              Models the shell port of Applications/TxSched/txq-cdc.cpp
+ *              with a 1 us clock: producers write into TxScheduler, the pump
+ *              tops the port ring up to TXQ_BURST pending after every write
+ *              and every transfer, and the link takes its bytes once per
+ *              125 us microframe. Each mix runs twice, once through the
+ *              scheduler and once through a plain FIFO of the same total
+ *              size (what a single ring gives):
+ *
+ *                  quiet        interactive replies only
+ *                  dump         interactive + a backlogged bulk dump
+ *                  mixed        interactive + backlogged telemetry and bulk
+ *
+ *              The bulk producer writes in place through reserve() and
+ *              commit() when the end of its ring allows, with enqueue()
+ *              when not, so both ways are checked.
+ *
+ *              Every class writes its own byte alphabet, a counter in
+ *              0x00-0x3F, 0x40-0x7F or 0x80-0xFF, so the bytes leaving the
+ *              link are sorted back per class and checked for loss and
+ *              reordering, and the class may only change on the wire at
+ *              the end of a message or every MAX_UNIT bytes of a long one,
+ *              so lines are never cut. The delay of an interactive reply is measured on
+ *              the wire, independently of the scheduler counters: from its
+ *              write to its first byte leaving the link.
+ *
+ *              Checks: byte streams intact; through the scheduler, every
+ *              interactive reply leaves within the bound of txq-intf.h
+ *              (what was pending in the port ring, the rest of the message
+ *              on the link and the interactive bytes queued before it,
+ *              plus two microframes); telemetry and
+ *              bulk share the link in the ratio of their quanta within 5 %;
+ *              the scheduler beats the FIFO on interactive delay whenever a
+ *              backlog exists. Exits non zero on a failed check, so it
+ *              doubles as a CI check.
+ *
+ *              closed       no host listens: every class writes
+ *                           CLOSED_BYTES in all, the pump empties the
+ *                           queues into a port ring that keeps its newest
+ *                           PORT_SIZE bytes, as usbd_cdc_if.c parks them;
+ *                           then the host opens. Checks: nothing refused
+ *                           by the scheduler, the ring full, and each
+ *                           class replays the newest bytes it wrote, in
+ *                           order, up to its last one.
+ *
+ * @author      MekLi
+ * @date        2025/9/8
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include "../../Applications/TxSched/tx-scheduler.hpp"
+#include "../host-test.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+/* the values of txq-intf.h */
+#define INTERACTIVE_SIZE    1024U
+#define TELEMETRY_SIZE      4096U
+#define BULK_SIZE           8192U
+#define TELEMETRY_QUANTUM   1024U
+#define BULK_QUANTUM        512U
+#define BURST               512U
+#define PORT_SIZE           2048U   // APP_TX_DATA_SIZE of usbd_cdc_if.h, the port ring
+#define MAX_UNIT            TxScheduler::MAX_UNIT
+
+#define MICROFRAME_US       125U
+#define TELEMETRY_MIN       40U     // log lines, bytes
+#define TELEMETRY_MAX       200U
+#define BULK_CHUNK          1536U   // a dump writes this much at a time, cut every MAX_UNIT
+#define CLOSED_BYTES        100000U // written while the host is closed
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    double seconds  = 2.0;
+    uint32_t bps    = 2000000;  // a terminal reading at 2 MB/s
+    uint32_t gapUs  = 3000;     // mean time between interactive replies
+    unsigned seed   = 1;
+} opt;
+
+static const uint8_t s_base[TxScheduler::CLASSES] = {0x00U, 0x40U, 0x80U};
+static const uint8_t s_span[TxScheduler::CLASSES] = {0x40U, 0x40U, 0x80U};
+static const char *const s_class_name[TxScheduler::CLASSES] = {"interactive", "telemetry", "bulk"};
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-s seconds] [-b link_bytes_per_s] [-i interactive_gap_us] [-r seed]\n"
+            "  runs the quiet, dump and mixed traffic mixes through the scheduler and a FIFO\n",
+            argv0);
+}
+
+static uint32_t class_of(uint8_t b)
+{
+    return b < 0x40U ? 0U : (b < 0x80U ? 1U : 2U);
+}
+
+/**
+ * @brief the queues under test: the scheduler, or one FIFO for every class
+ */
+class Queues
+{
+  public:
+    explicit Queues(bool fifo) : _fifo(fifo), _sched(config())
+    {
+    }
+
+    uint32_t free(uint32_t cls) const
+    {
+        return _fifo ? INTERACTIVE_SIZE + TELEMETRY_SIZE + BULK_SIZE - static_cast<uint32_t>(_one.size())
+                     : _sched.free_getter(cls);
+    }
+
+    uint32_t queued(uint32_t cls) const
+    {
+        return _fifo ? static_cast<uint32_t>(_one.size()) : _sched.queued_getter(cls);
+    }
+
+    uint32_t enqueue(uint32_t cls, const uint8_t *data, uint32_t len, uint32_t now)
+    {
+        if (not _fifo)
+        {
+            return _sched.enqueue(cls, data, len, now);
+        }
+        const uint32_t n = std::min(len, free(cls));
+        _one.insert(_one.end(), data, data + n);
+        return n;
+    }
+
+    /**
+     * @brief the same written in place, as `dump` does, where the end of the ring allows
+     */
+    uint32_t place(uint32_t cls, const uint8_t *data, uint32_t len, uint32_t now)
+    {
+        uint8_t *p = _fifo ? nullptr : _sched.reserve(cls, len);
+        if (p == nullptr)
+        {
+            return enqueue(cls, data, len, now);
+        }
+        std::copy(data, data + len, p);
+        _placed++;
+        return _sched.commit(cls, len, now);
+    }
+
+    uint32_t placed() const
+    {
+        return _placed;
+    }
+
+    uint32_t dequeue(uint8_t *out, uint32_t cap, uint32_t now)
+    {
+        if (not _fifo)
+        {
+            return _sched.dequeue(out, cap, now);
+        }
+        const uint32_t n = std::min(cap, static_cast<uint32_t>(_one.size()));
+        std::copy(_one.begin(), _one.begin() + n, out);
+        _one.erase(_one.begin(), _one.begin() + n);
+        return n;
+    }
+
+    const TxScheduler &sched() const
+    {
+        return _sched;
+    }
+
+  private:
+    static const TxScheduler::ClassConfig (&config())[TxScheduler::CLASSES]
+    {
+        static uint8_t r0[INTERACTIVE_SIZE], r1[TELEMETRY_SIZE], r2[BULK_SIZE];
+        static const TxScheduler::ClassConfig cfg[TxScheduler::CLASSES] = {
+            {r0, INTERACTIVE_SIZE, 1U},
+            {r1, TELEMETRY_SIZE, TELEMETRY_QUANTUM},
+            {r2, BULK_SIZE, BULK_QUANTUM},
+        };
+        return cfg;
+    }
+
+    bool _fifo;
+    uint32_t _placed = 0; // messages written through reserve()
+    TxScheduler _sched;
+    std::deque<uint8_t> _one;
+};
+
+/**
+ * @brief one interactive reply on its way
+ */
+struct Reply
+{
+    uint64_t start;     // index of its first byte in the interactive stream
+    uint32_t us;        // write time
+    uint32_t boundUs;   // latest acceptable first byte on the wire
+};
+
+/**
+ * @brief results of one run
+ */
+struct Result
+{
+    uint64_t wire[TxScheduler::CLASSES] = {};
+    uint32_t replies                    = 0;
+    uint32_t late                       = 0;
+    double delaySumUs                   = 0;
+    uint32_t delayMaxUs                 = 0;
+    uint32_t queuedMaxUs                = 0; // the scheduler's own count, to the dequeue
+    uint32_t placed                     = 0; // bulk messages written in place
+    uint32_t bulkMessages               = 0;
+    std::vector<uint32_t> delays;
+};
+
+/**
+ * @brief run one traffic mix through the scheduler or the FIFO
+ */
+static Result run(const char *mix, bool telemetry, bool bulk, bool fifo)
+{
+    // a fresh scheduler every run, the rings are reused
+    static Queues *q = nullptr;
+    delete q;
+    q = new Queues(fifo);
+
+    std::mt19937 rng(opt.seed);
+    std::mt19937 lineRng(opt.seed + 1U); // its own, the replies are the same in every mix
+    std::exponential_distribution<double> gap(1.0 / opt.gapUs);
+    std::uniform_int_distribution<uint32_t> size(16U, 160U);
+    std::uniform_int_distribution<uint32_t> line(TELEMETRY_MIN, TELEMETRY_MAX);
+
+    const uint32_t end       = static_cast<uint32_t>(opt.seconds * 1e6);
+    const uint32_t perFrame  = static_cast<uint32_t>(static_cast<uint64_t>(opt.bps) * MICROFRAME_US / 1000000U);
+    const double bytesPerUs  = opt.bps / 1e6;
+
+    Result r;
+    uint8_t counter[TxScheduler::CLASSES]  = {};  // next byte each producer writes
+    uint8_t expect[TxScheduler::CLASSES]   = {};  // next byte each class must show on the wire
+    uint64_t written[TxScheduler::CLASSES] = {};
+    std::deque<uint8_t> port;                     // the CDC transmit ring
+    std::deque<Reply> replies;
+    std::deque<uint64_t> starts[TxScheduler::CLASSES]; // stream index of each message not fully sent
+    uint32_t last = TxScheduler::CLASSES;             // class of the previous byte on the wire
+    uint8_t msg[BULK_CHUNK];
+    uint8_t burst[BURST];
+    double nextReply = gap(rng);
+
+    auto produce = [&](uint32_t cls, uint32_t len, uint32_t now) {
+        for (uint32_t i = 0; i < len; i++)
+        {
+            msg[i] = static_cast<uint8_t>(s_base[cls] + (counter[cls] + i) % s_span[cls]);
+        }
+        const uint32_t n = cls == 2U ? q->place(cls, msg, len, now) : q->enqueue(cls, msg, len, now);
+        if (n != 0U)
+        {
+            starts[cls].push_back(written[cls]);
+        }
+        counter[cls]     = static_cast<uint8_t>((counter[cls] + n) % s_span[cls]);
+        written[cls] += n;
+        return n;
+    };
+    auto pump = [&](uint32_t now) {
+        if (port.size() < BURST)
+        {
+            const uint32_t n = q->dequeue(burst, BURST, now);
+            port.insert(port.end(), burst, burst + n);
+        }
+    };
+
+    for (uint32_t now = 0; now < end; now++)
+    {
+        if (now >= nextReply)
+        {
+            nextReply += gap(rng);
+            const uint32_t len = size(rng);
+            if (q->free(0) >= len)
+            {
+                // ahead of it: the port ring and what its class queued, the FIFO has no bound
+                const uint32_t ahead = static_cast<uint32_t>(port.size()) + MAX_UNIT + q->queued(0);
+                const uint32_t bound = now + static_cast<uint32_t>(ahead / bytesPerUs) + 2U * MICROFRAME_US;
+                replies.push_back({written[0], now, bound});
+                produce(0, len, now);
+                pump(now);
+            }
+        }
+        if (telemetry and q->free(1) >= TELEMETRY_MAX)
+        {
+            produce(1, line(lineRng), now);
+            pump(now);
+        }
+        if (bulk and q->free(2) >= BULK_CHUNK)
+        {
+            produce(2, BULK_CHUNK, now);
+            pump(now);
+        }
+
+        if (now % MICROFRAME_US != MICROFRAME_US - 1U)
+        {
+            continue;
+        }
+
+        // one microframe on the link, every transfer complete pumps the next burst
+        uint32_t budget = perFrame;
+        while (budget != 0U and not port.empty())
+        {
+            const uint32_t n = std::min(budget, static_cast<uint32_t>(port.size()));
+            for (uint32_t i = 0; i < n; i++)
+            {
+                const uint8_t b     = port.front();
+                const uint32_t cls  = class_of(b);
+                port.pop_front();
+                if (b != s_base[cls] + expect[cls])
+                {
+                    fail("%s %s: %s byte %llu is 0x%02x, expected 0x%02x", mix, fifo ? "fifo" : "sched",
+                         s_class_name[cls], static_cast<unsigned long long>(r.wire[cls]), b, s_base[cls] + expect[cls]);
+                    expect[cls] = static_cast<uint8_t>(b - s_base[cls]);
+                }
+                expect[cls] = static_cast<uint8_t>((expect[cls] + 1U) % s_span[cls]);
+
+                // the previous class stopped at the end of a message, or of a unit of a long one
+                if (last != TxScheduler::CLASSES and last != cls)
+                {
+                    std::deque<uint64_t> &st = starts[last];
+                    while (st.size() > 1U and st[1] <= r.wire[last])
+                    {
+                        st.pop_front();
+                    }
+                    const bool ends = r.wire[last] == written[last] or (st.size() > 1U and st[1] == r.wire[last]);
+                    if (not ends and (st.empty() or (r.wire[last] - st.front()) % MAX_UNIT != 0U))
+                    {
+                        fail("%s %s: %s cut inside a message at byte %llu", mix, fifo ? "fifo" : "sched",
+                             s_class_name[last], static_cast<unsigned long long>(r.wire[last]));
+                    }
+                }
+                last = cls;
+
+                if (cls == 0U and not replies.empty() and replies.front().start == r.wire[0])
+                {
+                    const Reply rep = replies.front();
+                    replies.pop_front();
+                    const uint32_t d = now - rep.us;
+                    r.replies++;
+                    r.delaySumUs += d;
+                    r.delayMaxUs = std::max(r.delayMaxUs, d);
+                    r.delays.push_back(d);
+                    r.late += now > rep.boundUs ? 1U : 0U;
+                }
+                r.wire[cls]++;
+            }
+            budget -= n;
+            pump(now);
+        }
+    }
+    r.queuedMaxUs  = q->sched().stats_getter(0).delayMaxUs;
+    r.placed       = q->placed();
+    r.bulkMessages = q->sched().stats_getter(2).messages;
+    return r;
+}
+
+/**
+ * @brief no host listens while every class writes, then one opens the port
+ */
+static void run_closed()
+{
+    static Queues *q = nullptr;
+    delete q;
+    q = new Queues(false);
+
+    std::mt19937 rng(opt.seed);
+    std::uniform_int_distribution<uint32_t> pick(0U, TxScheduler::CLASSES - 1U);
+    std::uniform_int_distribution<uint32_t> size(16U, 160U);
+    std::uniform_int_distribution<uint32_t> line(TELEMETRY_MIN, TELEMETRY_MAX);
+
+    uint8_t counter[TxScheduler::CLASSES]  = {};
+    uint64_t written[TxScheduler::CLASSES] = {};
+    std::deque<uint8_t> port;
+    uint8_t msg[BULK_CHUNK];
+    uint8_t burst[BURST];
+    uint32_t total = 0;
+
+    for (uint32_t now = 0; total < CLOSED_BYTES; now += 10U)
+    {
+        const uint32_t cls = pick(rng);
+        const uint32_t len = cls == 0U ? size(rng) : (cls == 1U ? line(rng) : BULK_CHUNK);
+        for (uint32_t i = 0; i < len; i++)
+        {
+            msg[i] = static_cast<uint8_t>(s_base[cls] + (counter[cls] + i) % s_span[cls]);
+        }
+        const uint32_t n = q->enqueue(cls, msg, len, now);
+        counter[cls]     = static_cast<uint8_t>((counter[cls] + n) % s_span[cls]);
+        written[cls] += n;
+        total += n;
+
+        // txq_pump() with the host closed: every burst goes to the ring, the oldest bytes give way
+        for (uint32_t got = q->dequeue(burst, BURST, now); got != 0U; got = q->dequeue(burst, BURST, now))
+        {
+            port.insert(port.end(), burst, burst + got);
+            while (port.size() > PORT_SIZE)
+            {
+                port.pop_front();
+            }
+        }
+    }
+
+    // the host opens: the ring goes out first, then what the pump still finds
+    uint64_t replayed[TxScheduler::CLASSES] = {};
+    uint8_t expect[TxScheduler::CLASSES]    = {};
+    for (uint32_t got = q->dequeue(burst, BURST, 0U); got != 0U; got = q->dequeue(burst, BURST, 0U))
+    {
+        port.insert(port.end(), burst, burst + got);
+    }
+    for (const uint8_t b : port)
+    {
+        const uint32_t cls = class_of(b);
+        if (replayed[cls] == 0U)
+        {
+            expect[cls] = static_cast<uint8_t>(b - s_base[cls]);
+        }
+        if (b != s_base[cls] + expect[cls])
+        {
+            fail("closed: %s replays 0x%02x, expected 0x%02x", s_class_name[cls], b, s_base[cls] + expect[cls]);
+        }
+        expect[cls] = static_cast<uint8_t>((expect[cls] + 1U) % s_span[cls]);
+        replayed[cls]++;
+    }
+
+    printf("closed %u B written, %zu B replayed:", total, port.size());
+    for (uint32_t cls = 0; cls < TxScheduler::CLASSES; cls++)
+    {
+        printf(" %s %llu", s_class_name[cls], static_cast<unsigned long long>(replayed[cls]));
+        if (q->sched().stats_getter(cls).dropped != 0U)
+        {
+            fail("closed: %s refused %u bytes", s_class_name[cls], q->sched().stats_getter(cls).dropped);
+        }
+        // the newest: the last byte replayed is the last one written
+        if (replayed[cls] != 0U and expect[cls] != counter[cls])
+        {
+            fail("closed: %s replay ends at 0x%02x, the last written is 0x%02x", s_class_name[cls],
+                 s_base[cls] + (expect[cls] + s_span[cls] - 1U) % s_span[cls],
+                 s_base[cls] + (counter[cls] + s_span[cls] - 1U) % s_span[cls]);
+        }
+    }
+    printf("\n");
+    if (port.size() != PORT_SIZE)
+    {
+        fail("closed: %zu bytes replayed, the ring holds %u", port.size(), PORT_SIZE);
+    }
+}
+
+/**
+ * @brief print one run
+ */
+static void report(const char *mix, const char *mode, Result &r)
+{
+    std::sort(r.delays.begin(), r.delays.end());
+    const uint32_t p99 = r.delays.empty() ? 0U : r.delays[(r.delays.size() * 99U) / 100U];
+    const double secs  = opt.seconds;
+    printf("%-6s %-5s %7.3f %7.3f %7.3f %6u %8.1f %8u %8u\n", mix, mode, r.wire[0] / secs / 1e6, r.wire[1] / secs / 1e6,
+           r.wire[2] / secs / 1e6, r.replies, r.replies != 0U ? r.delaySumUs / r.replies : 0.0, p99, r.delayMaxUs);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "s:b:i:r:h")) != -1)
+    {
+        switch (c)
+        {
+        case 's': opt.seconds = atof(optarg); break;
+        case 'b': opt.bps = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'i': opt.gapUs = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'r': opt.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 0)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.seconds <= 0.0 or opt.bps < 1000000U / MICROFRAME_US or opt.gapUs == 0U)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("link %u B/s, %u B per microframe, interactive reply every %u us on average\n\n", opt.bps,
+           static_cast<uint32_t>(static_cast<uint64_t>(opt.bps) * MICROFRAME_US / 1000000U), opt.gapUs);
+    printf("%-6s %-5s %7s %7s %7s %6s %8s %8s %8s\n", "mix", "queue", "int MB/s", "tel", "bulk", "replies", "avg us",
+           "p99 us", "max us");
+
+    struct Mix
+    {
+        const char *name;
+        bool telemetry;
+        bool bulk;
+    };
+    static const Mix mixes[] = {{"quiet", false, false}, {"dump", false, true}, {"mixed", true, true}};
+
+    for (const Mix &m : mixes)
+    {
+        Result s = run(m.name, m.telemetry, m.bulk, false);
+        Result f = run(m.name, m.telemetry, m.bulk, true);
+        report(m.name, "sched", s);
+        report(m.name, "fifo", f);
+
+        if (s.replies == 0U)
+        {
+            fail("%s: no interactive reply went out", m.name);
+        }
+        if (s.late != 0U)
+        {
+            fail("%s: %u interactive replies left after their bound", m.name, s.late);
+        }
+        if (s.queuedMaxUs > s.delayMaxUs)
+        {
+            fail("%s: queueing delay %u us above the wire delay %u us", m.name, s.queuedMaxUs, s.delayMaxUs);
+        }
+        if (m.bulk and (s.placed == 0U or s.placed == s.bulkMessages))
+        {
+            fail("%s: %u bulk messages in place, both ways expected", m.name, s.placed);
+        }
+        if ((m.telemetry or m.bulk) and s.delayMaxUs >= f.delayMaxUs)
+        {
+            fail("%s: the scheduler (%u us) does not beat the FIFO (%u us)", m.name, s.delayMaxUs, f.delayMaxUs);
+        }
+        if (m.telemetry and m.bulk)
+        {
+            const double want  = static_cast<double>(TELEMETRY_QUANTUM) / BULK_QUANTUM;
+            const double ratio = static_cast<double>(s.wire[1]) / static_cast<double>(s.wire[2]);
+            printf("%-6s telemetry:bulk %.3f, quanta %.3f\n", m.name, ratio, want);
+            if (ratio < want * 0.95 or ratio > want * 1.05)
+            {
+                fail("%s: telemetry:bulk %.3f, not within 5 %% of %.3f", m.name, ratio, want);
+            }
+        }
+    }
+
+    run_closed();
+
+    return check_summary();
+}
@@ -0,0 +1,624 @@
+/**
+ * @file        cdc-bench.c
+ * @brief       Host side throughput and round trip benchmark of the data CDC port
+ *
+ * @attention   Linux, no dependency. Build and run:
+ *
+ *                  cc -O2 -Wall -o cdc-bench cdc-bench.c
+ *                  ./cdc-bench [-d tty] [-m tx|rx|echo|all] [-n bytes] [-c count] [-s size]
+ *                  ./cdc-bench -e          # self test against an emulated device
+ *
+ *              tx    device to host stream, the 32-bit counter is verified
+ *              rx    host to device sink
+ *              echo  `count` frames of `size` bytes sent one at a time, each
+ *                    starting with its sequence number; the round trip of
+ *                    every frame goes to a histogram (p50 / p99 / max)
+ *
+ *              -e runs a device emulator on a pseudo-terminal and benchmarks
+ *              it, which exercises the whole protocol without a board. The
+ *              exit status is non zero on any protocol or data error, so the
+ *              same binary works as a CI check.
+ *
+ *              The protocol is described in Applications/Bench/bench-intf.h.
+ *
+ * @author      MekLi
+ * @date        2025/9/4
+ * @version     1.0
+ */
+
+#define _GNU_SOURCE
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+/* keep in sync with Applications/Bench/bench-intf.h */
+#define BENCH_PROTO_VERSION 1
+#define BENCH_LINE_MAX      64
+
+#define IO_TIMEOUT_MS       3000
+#define CHUNK               4096
+#define HIST_BUCKETS        24      /* log2 of microseconds */
+
+
+/* ------- typedef ---------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief buffered reader, the device side keeps the same leftover logic
+ */
+typedef struct
+{
+    int     fd;
+    uint8_t buf[CHUNK];
+    size_t  len;
+    size_t  pos;
+} reader_t;
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    const char *tty;
+    const char *mode;
+    uint32_t    bytes;
+    uint32_t    count;
+    uint32_t    size;
+    int         emulate;
+} opt = { "/dev/ttyACM1", "all", 1u << 20, 1000, 64, 0 };
+
+static int errors;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void fail(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "error: ");
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+    errors++;
+}
+
+static int set_raw(int fd)
+{
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN]  = 1;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0)
+    {
+        return -1;
+    }
+    return tcflush(fd, TCIOFLUSH);
+}
+
+/**
+ * @brief make sure buffered bytes are available
+ * @return available bytes, 0 on timeout or end of file
+ */
+static size_t rd_fill(reader_t *r, int timeout_ms)
+{
+    if (r->pos < r->len)
+    {
+        return r->len - r->pos;
+    }
+    struct pollfd p = { r->fd, POLLIN, 0 };
+    int           n = poll(&p, 1, timeout_ms);
+    if (n <= 0)
+    {
+        return 0;
+    }
+    ssize_t got = read(r->fd, r->buf, sizeof(r->buf));
+    if (got <= 0)
+    {
+        return 0;
+    }
+    r->pos = 0;
+    r->len = (size_t)got;
+    return r->len;
+}
+
+static int rd_exact(reader_t *r, void *dst, size_t n, int timeout_ms)
+{
+    uint8_t *d = dst;
+    while (n != 0)
+    {
+        size_t avail = rd_fill(r, timeout_ms);
+        if (avail == 0)
+        {
+            return -1;
+        }
+        size_t take = avail < n ? avail : n;
+        if (d != NULL)
+        {
+            memcpy(d, &r->buf[r->pos], take);
+            d += take;
+        }
+        r->pos += take;
+        n -= take;
+    }
+    return 0;
+}
+
+/**
+ * @brief read one line, '\r' dropped
+ * @return line length, -1 on timeout
+ */
+static int rd_line(reader_t *r, char *line, size_t cap, int timeout_ms)
+{
+    size_t n = 0;
+    for (;;)
+    {
+        if (rd_fill(r, timeout_ms) == 0)
+        {
+            return -1;
+        }
+        while (r->pos < r->len)
+        {
+            char c = (char)r->buf[r->pos++];
+            if (c == '\n')
+            {
+                line[n] = '\0';
+                return (int)n;
+            }
+            if (c != '\r' && n + 1 < cap)
+            {
+                line[n++] = c;
+            }
+        }
+    }
+}
+
+static int write_all(int fd, const void *buf, size_t n)
+{
+    const uint8_t *p = buf;
+    while (n != 0)
+    {
+        ssize_t w = write(fd, p, n);
+        if (w < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+            {
+                continue;
+            }
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static int send_line(int fd, const char *fmt, ...)
+{
+    char    line[BENCH_LINE_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(line, sizeof(line) - 1, fmt, ap);
+    va_end(ap);
+    if (n < 0 || n > (int)sizeof(line) - 2)
+    {
+        return -1;
+    }
+    line[n++] = '\n';
+    return write_all(fd, line, (size_t)n);
+}
+
+
+/* ------- emulated device -------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief same behaviour as Applications/Bench/bench-cdc.cpp, on the pty master
+ */
+static void emulator(int fd)
+{
+    static reader_t r;
+    char            line[BENCH_LINE_MAX];
+    char            reply[BENCH_LINE_MAX];
+    uint32_t        words[CHUNK / 4];
+
+    r.fd = fd;
+    while (rd_line(&r, line, sizeof(line), -1) >= 0)
+    {
+        unsigned long a = 0, b = 0;
+        double        t0 = now_s();
+
+        if (strcmp(line, "hello") == 0)
+        {
+            snprintf(reply, sizeof(reply), "bench %d\r\n", BENCH_PROTO_VERSION);
+        }
+        else if (sscanf(line, "tx %lu", &a) == 1)
+        {
+            uint32_t seq = 0, left = (uint32_t)a & ~3u;
+            while (left != 0)
+            {
+                uint32_t n = left < sizeof(words) ? left : sizeof(words);
+                for (uint32_t i = 0; i < n / 4; i++)
+                {
+                    words[i] = seq++;
+                }
+                if (write_all(fd, words, n) != 0)
+                {
+                    _exit(1);
+                }
+                left -= n;
+            }
+            snprintf(reply, sizeof(reply), "ok tx %lu %lu\r\n", a & ~3ul, (unsigned long)((now_s() - t0) * 1e3));
+        }
+        else if (sscanf(line, "rx %lu", &a) == 1)
+        {
+            if (rd_exact(&r, NULL, a, 2000) != 0)
+            {
+                snprintf(reply, sizeof(reply), "err timeout rx\r\n");
+            }
+            else
+            {
+                snprintf(reply, sizeof(reply), "ok rx %lu %lu\r\n", a, (unsigned long)((now_s() - t0) * 1e3));
+            }
+        }
+        else if (sscanf(line, "echo %lu %lu", &a, &b) == 2 && a != 0 && b != 0)
+        {
+            uint64_t left = (uint64_t)a * b;
+            while (left != 0)
+            {
+                size_t avail = rd_fill(&r, 2000);
+                if (avail == 0)
+                {
+                    break;
+                }
+                size_t take = avail < left ? avail : (size_t)left;
+                write_all(fd, &r.buf[r.pos], take);
+                r.pos += take;
+                left -= take;
+            }
+            snprintf(reply, sizeof(reply), left == 0 ? "ok echo %lu\r\n" : "err timeout echo\r\n", a);
+        }
+        else if (line[0] == '\0')
+        {
+            continue;
+        }
+        else
+        {
+            snprintf(reply, sizeof(reply), "err unknown command\r\n");
+        }
+        write_all(fd, reply, strlen(reply));
+    }
+    _exit(0);
+}
+
+/**
+ * @brief spawn the emulator on a new pty
+ * @return open slave side, kept open so the master never sees a hang-up
+ */
+static int start_emulator(pid_t *child)
+{
+    char path[128];
+    int  master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ||
+        ptsname_r(master, path, sizeof(path)) != 0)
+    {
+        perror("pty");
+        exit(2);
+    }
+
+    /* raw before the child starts, so no byte goes through the line discipline */
+    int slave = open(path, O_RDWR | O_NOCTTY);
+    if (slave < 0 || set_raw(slave) != 0)
+    {
+        perror(path);
+        exit(2);
+    }
+
+    *child = fork();
+    if (*child < 0)
+    {
+        perror("fork");
+        exit(2);
+    }
+    if (*child == 0)
+    {
+        close(slave);
+        emulator(master);
+    }
+    close(master);
+    return slave;
+}
+
+
+/* ------- benchmarks ------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief read and check a status line "ok <verb> ..."
+ * @return device side milliseconds when present, -1 on error
+ */
+static long expect_ok(reader_t *r, const char *verb)
+{
+    char          line[BENCH_LINE_MAX];
+    char          got[16];
+    unsigned long a = 0, ms = 0;
+
+    if (rd_line(r, line, sizeof(line), IO_TIMEOUT_MS) < 0)
+    {
+        fail("%s: no status line", verb);
+        return -1;
+    }
+    int n = sscanf(line, "ok %15s %lu %lu", got, &a, &ms);
+    if (n < 2 || strcmp(got, verb) != 0)
+    {
+        fail("%s: device said \"%s\"", verb, line);
+        return -1;
+    }
+    return n == 3 ? (long)ms : 0;
+}
+
+static int sync_device(reader_t *r, int fd)
+{
+    char line[BENCH_LINE_MAX];
+    char want[16];
+
+    snprintf(want, sizeof(want), "bench %d", BENCH_PROTO_VERSION);
+    send_line(fd, "");
+    send_line(fd, "hello");
+    for (int i = 0; i < 16; i++)
+    {
+        if (rd_line(r, line, sizeof(line), IO_TIMEOUT_MS) < 0)
+        {
+            break;
+        }
+        if (strcmp(line, want) == 0)
+        {
+            return 0;
+        }
+    }
+    fail("no answer to hello, wrong port or protocol version?");
+    return -1;
+}
+
+static void bench_tx(reader_t *r, int fd)
+{
+    uint32_t bytes = opt.bytes & ~3u;
+    uint32_t seq = 0, bad = 0;
+    uint32_t word;
+    double   t0 = 0;
+
+    send_line(fd, "tx %u", bytes);
+    for (uint32_t done = 0; done < bytes; done += 4)
+    {
+        if (rd_exact(r, &word, 4, IO_TIMEOUT_MS) != 0)
+        {
+            fail("tx: stream stalled after %u bytes", done);
+            return;
+        }
+        if (done == 0)
+        {
+            t0 = now_s();
+        }
+        if (word != seq && bad++ < 4)
+        {
+            fail("tx: word %u is %u", seq, word);
+            seq = word;
+        }
+        seq++;
+    }
+    double dt = now_s() - t0;
+    long   ms = expect_ok(r, "tx");
+    printf("tx    %10u bytes  %8.3f MB/s  (device %ld ms)%s\n", bytes, bytes / dt / 1e6, ms,
+           bad != 0 ? "  DATA ERRORS" : "");
+}
+
+static void bench_rx(reader_t *r, int fd)
+{
+    static uint8_t buf[CHUNK];
+    for (size_t i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = (uint8_t)i;
+    }
+
+    double t0 = now_s();
+    send_line(fd, "rx %u", opt.bytes);
+    for (uint32_t left = opt.bytes; left != 0;)
+    {
+        uint32_t n = left < sizeof(buf) ? left : sizeof(buf);
+        if (write_all(fd, buf, n) != 0)
+        {
+            fail("rx: write failed: %s", strerror(errno));
+            return;
+        }
+        left -= n;
+    }
+    long   ms = expect_ok(r, "rx");
+    double dt = now_s() - t0;
+    printf("rx    %10u bytes  %8.3f MB/s  (device %ld ms)\n", opt.bytes, opt.bytes / dt / 1e6, ms);
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_echo(reader_t *r, int fd)
+{
+    uint32_t size = opt.size < 4 ? 4 : opt.size;
+    uint8_t *out  = calloc(1, size);
+    uint8_t *in   = calloc(1, size);
+    double  *rtt  = calloc(opt.count, sizeof(double));
+    unsigned hist[HIST_BUCKETS] = { 0 };
+    uint32_t done = 0;
+
+    send_line(fd, "echo %u %u", opt.count, size);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        out[i] = (uint8_t)(0xA5 ^ i);
+    }
+    for (; done < opt.count; done++)
+    {
+        memcpy(out, &done, 4);
+        double t0 = now_s();
+        if (write_all(fd, out, size) != 0 || rd_exact(r, in, size, IO_TIMEOUT_MS) != 0)
+        {
+            fail("echo: frame %u lost", done);
+            break;
+        }
+        rtt[done] = (now_s() - t0) * 1e6;
+        if (memcmp(in, out, size) != 0)
+        {
+            uint32_t seq;
+            memcpy(&seq, in, 4);
+            fail("echo: frame %u came back as %u or corrupted", done, seq);
+            break;
+        }
+    }
+    if (done == opt.count)
+    {
+        expect_ok(r, "echo");
+    }
+
+    if (done != 0)
+    {
+        double sum = 0;
+        for (uint32_t i = 0; i < done; i++)
+        {
+            sum += rtt[i];
+            int b = 0;
+            while (b < HIST_BUCKETS - 1 && (double)(1u << (b + 1)) <= rtt[i])
+            {
+                b++;
+            }
+            hist[b]++;
+        }
+        qsort(rtt, done, sizeof(double), cmp_double);
+        printf("echo  %10u frames of %u bytes  rtt us: min %.1f  mean %.1f  p50 %.1f  p99 %.1f  max %.1f\n", done,
+               size, rtt[0], sum / done, rtt[(done - 1) * 50 / 100], rtt[(done - 1) * 99 / 100], rtt[done - 1]);
+
+        unsigned peak = 0;
+        for (int b = 0; b < HIST_BUCKETS; b++)
+        {
+            peak = hist[b] > peak ? hist[b] : peak;
+        }
+        for (int b = 0; b < HIST_BUCKETS; b++)
+        {
+            if (hist[b] == 0)
+            {
+                continue;
+            }
+            printf("      [%7u, %7u) us %7u |", 1u << b, 1u << (b + 1), hist[b]);
+            for (unsigned k = 0; k < (hist[b] * 50 + peak - 1) / peak; k++)
+            {
+                putchar('#');
+            }
+            putchar('\n');
+        }
+    }
+    free(out);
+    free(in);
+    free(rtt);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-d tty] [-m tx|rx|echo|all] [-n bytes] [-c count] [-s size] [-e]\n"
+            "  -d  data CDC port of the board (default %s)\n"
+            "  -m  benchmark to run (default all)\n"
+            "  -n  bytes for tx / rx (default %u)\n"
+            "  -c  echo frames (default %u)\n"
+            "  -s  echo frame size, at least 4 (default %u)\n"
+            "  -e  run against an emulated device on a pseudo-terminal\n",
+            argv0, opt.tty, opt.bytes, opt.count, opt.size);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "d:m:n:c:s:eh")) != -1)
+    {
+        switch (c)
+        {
+        case 'd': opt.tty = optarg; break;
+        case 'm': opt.mode = optarg; break;
+        case 'n': opt.bytes = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'c': opt.count = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': opt.size = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'e': opt.emulate = 1; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (opt.count == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static reader_t r;
+    pid_t           child = -1;
+    if (opt.emulate)
+    {
+        r.fd = start_emulator(&child);
+    }
+    else
+    {
+        r.fd = open(opt.tty, O_RDWR | O_NOCTTY);
+        if (r.fd < 0 || set_raw(r.fd) != 0)
+        {
+            perror(opt.tty);
+            return 2;
+        }
+    }
+
+    int all = strcmp(opt.mode, "all") == 0;
+    if (sync_device(&r, r.fd) == 0)
+    {
+        if (all || strcmp(opt.mode, "tx") == 0)
+        {
+            bench_tx(&r, r.fd);
+        }
+        if (all || strcmp(opt.mode, "rx") == 0)
+        {
+            bench_rx(&r, r.fd);
+        }
+        if (all || strcmp(opt.mode, "echo") == 0)
+        {
+            bench_echo(&r, r.fd);
+        }
+    }
+
+    close(r.fd);
+    if (child > 0)
+    {
+        kill(child, SIGTERM);
+        waitpid(child, NULL, 0);
+    }
+    return errors != 0 ? 1 : 0;
+}
@@ -0,0 +1,307 @@
+/**
+ * @file        msc-bench.c
+ * @brief       Host side throughput benchmark for the mass storage function
+ *
+ * @attention   Linux. Build and run:
+ *
+ *                  cc -O2 -Wall -o msc-bench msc-bench.c
+ *                  ./msc-bench [-s mb] [-b kb] [-r kb] [-n ops] [-x seed] [-w] /dev/sdX
+ *
+ *              The block device is opened with O_DIRECT so every request
+ *              reaches the device instead of the page cache. A regular
+ *              file of the size of the device can stand in for it.
+ *
+ *              Always run:   sequential read of `mb` MB in `-b` KB requests,
+ *                            random read of `ops` requests of `-r` KB
+ *              With -w:      sequential write, random write, then
+ *                            SYNCHRONIZE CACHE (fdatasync) and a read back
+ *                            check of everything written. -w DESTROYS the
+ *                            content of the device.
+ *
+ *              Write rates are given twice: up to the last request (what the
+ *              write-back cache absorbs) and up to the end of the sync (what
+ *              the flash sustains).
+ *
+ * @author      MekLi
+ * @date        2025/9/6
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+#define ALIGN       4096
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint32_t mb;
+    uint32_t seqKb;
+    uint32_t rndKb;
+    uint32_t ops;
+    uint32_t seed;
+    int      write;
+    const char *dev;
+} s_opt = {4, 64, 4, 256, 1, 0, NULL};
+
+static int s_fd = -1;
+static uint64_t s_devSize;
+static uint8_t *s_gen;   // generation last written to each 512-byte block
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+/**
+ * @brief monotonic time in seconds
+ */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * @brief xorshift32, reproducible offsets and data
+ */
+static uint32_t rnd(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+
+/**
+ * @brief content of the bytes at offset `off`: the offset itself, so a
+ *        misplaced block is caught by the check, and the write generation,
+ *        so a rewrite really changes the data and costs the flash an erase
+ */
+static void fill(uint8_t *buf, uint64_t off, uint32_t len, uint8_t gen)
+{
+    for (uint32_t i = 0; i < len; i += 8)
+    {
+        uint64_t v = (off + i) ^ ((uint64_t)gen << 56) ^ 0x005A5A5A00000000ULL;
+        memcpy(buf + i, &v, 8);
+    }
+}
+
+
+/**
+ * @brief full pread / pwrite at an offset, exits on error
+ */
+static void io(int wr, uint8_t *buf, uint64_t off, uint32_t len)
+{
+    ssize_t n = wr ? pwrite(s_fd, buf, len, (off_t)off) : pread(s_fd, buf, len, (off_t)off);
+    if (n != (ssize_t)len)
+    {
+        fprintf(stderr, "%s at %llu: %s\n", wr ? "write" : "read", (unsigned long long)off,
+                n < 0 ? strerror(errno) : "short transfer");
+        exit(1);
+    }
+}
+
+
+/**
+ * @brief print one result line
+ */
+static void report(const char *name, uint64_t bytes, uint32_t reqs, double sec)
+{
+    printf("%-12s %8.1f KB in %4u req  %7.3f s  %7.3f MB/s  %7.1f IOPS\n", name, (double)bytes / 1024.0, reqs, sec,
+           (double)bytes / sec / 1e6, (double)reqs / sec);
+}
+
+
+/**
+ * @brief sequential pass over the first `mb` MB
+ */
+static void seq(int wr, uint8_t *buf)
+{
+    uint64_t total = (uint64_t)s_opt.mb << 20;
+    uint32_t chunk = s_opt.seqKb * 1024U;
+    uint32_t reqs  = 0;
+    double t0      = now();
+
+    for (uint64_t off = 0; off + chunk <= total; off += chunk, reqs++)
+    {
+        if (wr)
+        {
+            fill(buf, off, chunk, 1);
+            memset(s_gen + off / 512, 1, chunk / 512);
+        }
+        io(wr, buf, off, chunk);
+    }
+    report(wr ? "seq-write" : "seq-read", (uint64_t)reqs * chunk, reqs, now() - t0);
+}
+
+
+/**
+ * @brief random requests aligned on their size, inside the first `mb` MB
+ *        when writing (so the check covers them), anywhere when reading
+ */
+static void rand_io(int wr, uint8_t *buf)
+{
+    uint32_t chunk = s_opt.rndKb * 1024U;
+    uint64_t span  = wr ? ((uint64_t)s_opt.mb << 20) : s_devSize;
+    uint64_t slots = span / chunk;
+    uint32_t seed  = s_opt.seed;
+    double t0      = now();
+
+    for (uint32_t i = 0; i < s_opt.ops; i++)
+    {
+        uint64_t off = (rnd(&seed) % slots) * chunk;
+        if (wr)
+        {
+            uint8_t gen = (uint8_t)(s_gen[off / 512] + 1U);
+            fill(buf, off, chunk, gen);
+            memset(s_gen + off / 512, gen, chunk / 512);
+        }
+        io(wr, buf, off, chunk);
+    }
+    report(wr ? "rand-write" : "rand-read", (uint64_t)s_opt.ops * chunk, s_opt.ops, now() - t0);
+}
+
+
+/**
+ * @brief read back the first `mb` MB and compare with the written pattern
+ * @return number of bad blocks
+ */
+static uint32_t check(uint8_t *buf, uint8_t *ref)
+{
+    uint64_t total = (uint64_t)s_opt.mb << 20;
+    uint32_t chunk = s_opt.seqKb * 1024U;
+    uint32_t bad   = 0;
+
+    for (uint64_t off = 0; off + chunk <= total; off += chunk)
+    {
+        io(0, buf, off, chunk);
+        for (uint32_t b = 0; b < chunk; b += 512)
+        {
+            fill(ref + b, off + b, 512, s_gen[(off + b) / 512]);
+            if (memcmp(buf + b, ref + b, 512) != 0)
+            {
+                if (bad < 8)
+                {
+                    fprintf(stderr, "mismatch in block %llu\n", (unsigned long long)((off + b) / 512));
+                }
+                bad++;
+            }
+        }
+    }
+    return bad;
+}
+
+
+/**
+ * @brief print the usage and exit
+ */
+static void usage(void)
+{
+    fprintf(stderr, "usage: msc-bench [-s mb] [-b kb] [-r kb] [-n ops] [-x seed] [-w] /dev/sdX\n");
+    exit(2);
+}
+
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "s:b:r:n:x:w")) != -1)
+    {
+        switch (c)
+        {
+            case 's': s_opt.mb = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'b': s_opt.seqKb = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'r': s_opt.rndKb = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'n': s_opt.ops = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'x': s_opt.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'w': s_opt.write = 1; break;
+            default: usage();
+        }
+    }
+    if (optind != argc - 1 || s_opt.mb == 0 || s_opt.seqKb == 0 || s_opt.rndKb == 0 || s_opt.seed == 0 ||
+        (s_opt.seqKb * 1024U) % 512U != 0 || (s_opt.rndKb * 1024U) % 512U != 0)
+    {
+        usage();
+    }
+    s_opt.dev = argv[optind];
+
+    // an image file works too, to check the tool itself
+    struct stat st;
+    s_fd = open(s_opt.dev, (s_opt.write ? O_RDWR : O_RDONLY) | O_DIRECT);
+    if (s_fd < 0 || fstat(s_fd, &st) != 0 ||
+        (S_ISREG(st.st_mode) ? (s_devSize = (uint64_t)st.st_size, 0) : ioctl(s_fd, BLKGETSIZE64, &s_devSize)) != 0)
+    {
+        perror(s_opt.dev);
+        return 1;
+    }
+    if (((uint64_t)s_opt.mb << 20) > s_devSize)
+    {
+        fprintf(stderr, "%s holds %llu bytes only\n", s_opt.dev, (unsigned long long)s_devSize);
+        return 1;
+    }
+
+    s_gen = calloc(((size_t)s_opt.mb << 20) / 512, 1);
+    uint32_t size = (s_opt.seqKb > s_opt.rndKb ? s_opt.seqKb : s_opt.rndKb) * 1024U;
+    uint8_t *buf;
+    uint8_t *ref;
+    if (posix_memalign((void **)&buf, ALIGN, size) != 0 || posix_memalign((void **)&ref, ALIGN, size) != 0)
+    {
+        return 1;
+    }
+
+    printf("%s: %llu MB, %u MB sequential in %u KB, %u random of %u KB\n", s_opt.dev,
+           (unsigned long long)(s_devSize >> 20), s_opt.mb, s_opt.seqKb, s_opt.ops, s_opt.rndKb);
+
+    seq(0, buf);
+    rand_io(0, buf);
+
+    if (s_opt.write)
+    {
+        double t0 = now();
+        seq(1, buf);
+        rand_io(1, buf);
+        double t1 = now();
+        if (fdatasync(s_fd) != 0)
+        {
+            perror("fdatasync");
+            return 1;
+        }
+        double t2 = now();
+        uint64_t bytes = ((uint64_t)s_opt.mb << 20) + (uint64_t)s_opt.ops * s_opt.rndKb * 1024U;
+        printf("sync         %7.3f s, writes %7.3f MB/s to the cache, %7.3f MB/s to the flash\n", t2 - t1,
+               (double)bytes / (t1 - t0) / 1e6, (double)bytes / (t2 - t0) / 1e6);
+
+        uint32_t bad = check(buf, ref);
+        printf("check        %s (%u bad blocks)\n", bad == 0 ? "ok" : "FAILED", bad);
+        if (bad != 0)
+        {
+            return 1;
+        }
+    }
+
+    free(s_gen);
+    free(buf);
+    free(ref);
+    close(s_fd);
+    return 0;
+}
@@ -0,0 +1,376 @@
+/**
+ * @file        vendor-bench.c
+ * @brief       Host side throughput benchmark for the vendor bulk function
+ *
+ * @attention   Linux, libusb-1.0. Build and run:
+ *
+ *                  cc -O2 -Wall -o vendor-bench vendor-bench.c \
+ *                     $(pkg-config --cflags --libs libusb-1.0)
+ *                  ./vendor-bench [-d vid:pid] [-s size] [-q depth] [-t sec] [-o] [-p] [-c]
+ *
+ *              IN (default): asks the firmware to replay its test pattern
+ *              (VENDOR_REQ_SET_SOURCE) and keeps `depth` transfers of `size`
+ *              bytes queued on the bulk IN endpoint.
+ *              -p  do not enable the pattern, measure what the firmware
+ *                  producer (VENDOR_Write_HS) pushes instead
+ *              -c  check the pattern: the stream is one continuous byte counter
+ *              -o  OUT: saturate the bulk OUT sink instead
+ *
+ *              Prints the rate every second and the sustained MB/s at the end,
+ *              followed by the device side counters (VENDOR_REQ_GET_STATS).
+ *
+ * @author      MekLi
+ * @date        2025/6/1
+ * @version     1.0
+ */
+
+
+/* ------- include ---------------------------------------------------------------------------------------------------*/
+
+#include <libusb-1.0/libusb.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/* ------- define ----------------------------------------------------------------------------------------------------*/
+
+/* keep in sync with USB_DEVICE/App/usbd_vendor_if.h */
+#define VENDOR_REQ_SET_SOURCE   0x01
+#define VENDOR_REQ_GET_STATS    0x02
+#define VENDOR_REQ_RESET_STATS  0x03
+
+#define CTRL_OUT  (LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_INTERFACE)
+#define CTRL_IN   (LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_INTERFACE)
+
+#define MAX_DEPTH 64
+
+
+/* ------- variables -------------------------------------------------------------------------------------------------*/
+
+static struct
+{
+    uint16_t vid;
+    uint16_t pid;
+    int      size;
+    int      depth;
+    int      seconds;
+    int      out;
+    int      producer;
+    int      check;
+} opt = { 0x0483, 0x5740, 65536, 16, 10, 0, 0, 0 };
+
+static volatile sig_atomic_t stop_flag;
+static int                   in_flight;
+static uint64_t              total_bytes;
+static uint64_t              window_bytes;
+static uint64_t              check_offset;
+static int                   check_synced;
+static uint64_t              check_errors;
+static int                   xfer_failed;
+
+
+/* ------- function implement ----------------------------------------------------------------------------------------*/
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_flag = 1;
+}
+
+static void check_pattern(const uint8_t *buf, int len)
+{
+    if (!check_synced && len > 0)
+    {
+        check_offset = buf[0];
+        check_synced = 1;
+    }
+    for (int i = 0; i < len; i++)
+    {
+        if (buf[i] != (uint8_t)(check_offset + (uint64_t)i))
+        {
+            check_errors++;
+            /* resynchronise on the received byte */
+            check_offset = (uint64_t)buf[i] - (uint64_t)i;
+        }
+    }
+    check_offset += (uint64_t)len;
+}
+
+static void LIBUSB_CALL on_xfer(struct libusb_transfer *xfer)
+{
+    if (xfer->status == LIBUSB_TRANSFER_COMPLETED)
+    {
+        total_bytes += (uint64_t)xfer->actual_length;
+        window_bytes += (uint64_t)xfer->actual_length;
+        if (opt.check && !opt.out)
+        {
+            check_pattern(xfer->buffer, xfer->actual_length);
+        }
+    }
+    else if (xfer->status != LIBUSB_TRANSFER_CANCELLED && xfer->status != LIBUSB_TRANSFER_TIMED_OUT)
+    {
+        fprintf(stderr, "transfer failed: %s\n", libusb_error_name((int)xfer->status));
+        xfer_failed = 1;
+    }
+
+    if (!stop_flag && !xfer_failed && libusb_submit_transfer(xfer) == 0)
+    {
+        return;
+    }
+    in_flight--;
+}
+
+static int find_vendor_interface(libusb_device_handle *h, int *ifnum, uint8_t *ep_in, uint8_t *ep_out)
+{
+    struct libusb_config_descriptor *cfg;
+    int found = -1;
+
+    if (libusb_get_active_config_descriptor(libusb_get_device(h), &cfg) != 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < cfg->bNumInterfaces && found < 0; i++)
+    {
+        const struct libusb_interface_descriptor *alt = &cfg->interface[i].altsetting[0];
+        if (alt->bInterfaceClass != LIBUSB_CLASS_VENDOR_SPEC)
+        {
+            continue;
+        }
+        *ifnum = alt->bInterfaceNumber;
+        for (int e = 0; e < alt->bNumEndpoints; e++)
+        {
+            const struct libusb_endpoint_descriptor *ep = &alt->endpoint[e];
+            if ((ep->bmAttributes & LIBUSB_TRANSFER_TYPE_MASK) != LIBUSB_TRANSFER_TYPE_BULK)
+            {
+                continue;
+            }
+            if (ep->bEndpointAddress & LIBUSB_ENDPOINT_IN)
+            {
+                *ep_in = ep->bEndpointAddress;
+            }
+            else
+            {
+                *ep_out = ep->bEndpointAddress;
+            }
+        }
+        found = 0;
+    }
+    libusb_free_config_descriptor(cfg);
+    return found;
+}
+
+static void print_device_stats(libusb_device_handle *h, int ifnum)
+{
+    uint32_t st[5] = { 0 };
+    int r = libusb_control_transfer(h, CTRL_IN, VENDOR_REQ_GET_STATS, 0, (uint16_t)ifnum,
+                                    (unsigned char *)st, sizeof(st), 1000);
+    if (r < (int)sizeof(st))
+    {
+        fprintf(stderr, "stats request failed: %s\n", libusb_error_name(r));
+        return;
+    }
+    printf("device: tx %u bytes in %u transfers, %u dropped; rx %u bytes in %u packets\n",
+           st[0], st[1], st[2], st[3], st[4]);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-d vid:pid] [-s size] [-q depth] [-t sec] [-o] [-p] [-c]\n"
+            "  -d  device ids, default 0483:5740\n"
+            "  -s  bytes per transfer, default 65536\n"
+            "  -q  transfers kept in flight, default 16 (max %d)\n"
+            "  -t  duration in seconds, default 10\n"
+            "  -o  benchmark the OUT sink instead of IN\n"
+            "  -p  IN from the firmware producer ring, do not enable the pattern\n"
+            "  -c  verify the IN pattern\n", argv0, MAX_DEPTH);
+}
+
+static int parse_args(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(a, "-d") == 0 && v)
+        {
+            unsigned vid, pid;
+            if (sscanf(v, "%x:%x", &vid, &pid) != 2)
+            {
+                return -1;
+            }
+            opt.vid = (uint16_t)vid;
+            opt.pid = (uint16_t)pid;
+            i++;
+        }
+        else if (strcmp(a, "-s") == 0 && v) { opt.size = atoi(v); i++; }
+        else if (strcmp(a, "-q") == 0 && v) { opt.depth = atoi(v); i++; }
+        else if (strcmp(a, "-t") == 0 && v) { opt.seconds = atoi(v); i++; }
+        else if (strcmp(a, "-o") == 0) { opt.out = 1; }
+        else if (strcmp(a, "-p") == 0) { opt.producer = 1; }
+        else if (strcmp(a, "-c") == 0) { opt.check = 1; }
+        else
+        {
+            return -1;
+        }
+    }
+    if (opt.size <= 0 || opt.depth <= 0 || opt.depth > MAX_DEPTH || opt.seconds <= 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    libusb_context          *ctx = NULL;
+    libusb_device_handle    *h = NULL;
+    struct libusb_transfer  *xfers[MAX_DEPTH] = { 0 };
+    int                      ifnum = -1;
+    uint8_t                  ep_in = 0, ep_out = 0;
+    int                      rc = 1;
+
+    if (parse_args(argc, argv) != 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (libusb_init(&ctx) != 0)
+    {
+        fprintf(stderr, "libusb_init failed\n");
+        return 1;
+    }
+
+    h = libusb_open_device_with_vid_pid(ctx, opt.vid, opt.pid);
+    if (h == NULL)
+    {
+        fprintf(stderr, "device %04x:%04x not found (permissions?)\n", opt.vid, opt.pid);
+        goto out;
+    }
+    if (find_vendor_interface(h, &ifnum, &ep_in, &ep_out) != 0 || (opt.out ? ep_out : ep_in) == 0)
+    {
+        fprintf(stderr, "no vendor bulk interface on the device\n");
+        goto out;
+    }
+    libusb_set_auto_detach_kernel_driver(h, 1);
+    if (libusb_claim_interface(h, ifnum) != 0)
+    {
+        fprintf(stderr, "cannot claim interface %d\n", ifnum);
+        goto out;
+    }
+
+    (void)libusb_control_transfer(h, CTRL_OUT, VENDOR_REQ_RESET_STATS, 0, (uint16_t)ifnum, NULL, 0, 1000);
+    if (!opt.out && !opt.producer)
+    {
+        if (libusb_control_transfer(h, CTRL_OUT, VENDOR_REQ_SET_SOURCE, 1, (uint16_t)ifnum, NULL, 0, 1000) < 0)
+        {
+            fprintf(stderr, "cannot enable the test pattern\n");
+            goto release;
+        }
+    }
+
+    signal(SIGINT, on_signal);
+
+    for (int i = 0; i < opt.depth; i++)
+    {
+        uint8_t *buf = malloc((size_t)opt.size);
+        xfers[i] = libusb_alloc_transfer(0);
+        if (buf == NULL || xfers[i] == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            free(buf);
+            stop_flag = 1;
+            break;
+        }
+        memset(buf, 0xA5, (size_t)opt.size);
+        libusb_fill_bulk_transfer(xfers[i], h, opt.out ? ep_out : ep_in, buf, opt.size,
+                                  on_xfer, NULL, 2000);
+        xfers[i]->flags |= LIBUSB_TRANSFER_FREE_BUFFER;
+        if (libusb_submit_transfer(xfers[i]) != 0)
+        {
+            fprintf(stderr, "submit failed\n");
+            stop_flag = 1;
+            break;
+        }
+        in_flight++;
+    }
+
+    printf("%s ep 0x%02x, %d x %d bytes in flight, %d s\n",
+           opt.out ? "OUT" : "IN", opt.out ? ep_out : ep_in, opt.depth, opt.size, opt.seconds);
+
+    double t0 = now_s();
+    double tick = t0;
+    while (!stop_flag && !xfer_failed && (now_s() - t0) < (double)opt.seconds)
+    {
+        struct timeval tv = { 0, 100000 };
+        libusb_handle_events_timeout(ctx, &tv);
+
+        double t = now_s();
+        if (t - tick >= 1.0)
+        {
+            printf("  %6.2f MB/s\n", (double)window_bytes / (t - tick) / 1e6);
+            fflush(stdout);
+            window_bytes = 0;
+            tick = t;
+        }
+    }
+    double elapsed = now_s() - t0;
+
+    /* drain: completions stop resubmitting, cancel what is still queued */
+    stop_flag = 1;
+    for (int i = 0; i < opt.depth; i++)
+    {
+        if (xfers[i] != NULL)
+        {
+            (void)libusb_cancel_transfer(xfers[i]);
+        }
+    }
+    while (in_flight > 0)
+    {
+        libusb_handle_events(ctx);
+    }
+
+    printf("sustained %.3f MB/s (%llu bytes in %.2f s)\n",
+           (double)total_bytes / elapsed / 1e6, (unsigned long long)total_bytes, elapsed);
+    if (opt.check && !opt.out)
+    {
+        printf("pattern: %llu mismatched bytes\n", (unsigned long long)check_errors);
+    }
+
+    if (!opt.out && !opt.producer)
+    {
+        (void)libusb_control_transfer(h, CTRL_OUT, VENDOR_REQ_SET_SOURCE, 0, (uint16_t)ifnum, NULL, 0, 1000);
+    }
+    print_device_stats(h, ifnum);
+    rc = (xfer_failed || check_errors) ? 1 : 0;
+
+release:
+    for (int i = 0; i < opt.depth; i++)
+    {
+        if (xfers[i] != NULL)
+        {
+            libusb_free_transfer(xfers[i]);
+        }
+    }
+    libusb_release_interface(h, ifnum);
+out:
+    if (h != NULL)
+    {
+        libusb_close(h);
+    }
+    libusb_exit(ctx);
+    return rc;
+}
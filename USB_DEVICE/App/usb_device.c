@@ -25,6 +25,10 @@
 #include "usbd_desc.h"
 #include "usbd_cdc.h"
 #include "usbd_cdc_if.h"
+#include "usbd_composite_builder.h"
+#include "usbd_vendor_if.h"
+#include "usbd_msc.h"
+#include "usbd_storage_if.h"
 
 /* USER CODE BEGIN Includes */
 
@@ -54,7 +58,7 @@ USBD_HandleTypeDef hUsbDeviceHS;
  * -- Insert your external function declaration here --
  */
 /* USER CODE BEGIN 1 */
-
+USBD_StatusTypeDef USBD_LL_ConfigFifo(USBD_HandleTypeDef *pdev);
 /* USER CODE END 1 */
 
 /**
@@ -72,7 +76,28 @@ void MX_USB_DEVICE_Init(void)
   {
     Error_Handler();
   }
-  if (USBD_RegisterClass(&hUsbDeviceHS, &USBD_CDC) != USBD_OK)
+  /* Shell port, data port, vendor bulk, mass storage: class ids 0 to 3 */
+  if (USBD_RegisterClassComposite(&hUsbDeviceHS, &USBD_CDC, CLASS_TYPE_CDC,
+                                  CDC_EpAdd_HS[CDC_PORT_SHELL]) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_RegisterClassComposite(&hUsbDeviceHS, &USBD_CDC, CLASS_TYPE_CDC,
+                                  CDC_EpAdd_HS[CDC_PORT_DATA]) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_RegisterClassComposite(&hUsbDeviceHS, &USBD_VENDOR, CLASS_TYPE_VENDOR,
+                                  VENDOR_EpAdd_HS) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_RegisterClassComposite(&hUsbDeviceHS, &USBD_MSC, CLASS_TYPE_MSC,
+                                  MSC_EpAdd_HS) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_CMPSIT_SetClassID(&hUsbDeviceHS, CLASS_TYPE_CDC, CDC_PORT_SHELL) == 0xFFU)
   {
     Error_Handler();
   }
@@ -80,6 +105,35 @@ void MX_USB_DEVICE_Init(void)
   {
     Error_Handler();
   }
+  if (USBD_CMPSIT_SetClassID(&hUsbDeviceHS, CLASS_TYPE_CDC, CDC_PORT_DATA) == 0xFFU)
+  {
+    Error_Handler();
+  }
+  if (USBD_CDC_RegisterInterface(&hUsbDeviceHS, &USBD_Interface_fops_HS_Data) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_CMPSIT_SetClassID(&hUsbDeviceHS, CLASS_TYPE_VENDOR, 0U) == 0xFFU)
+  {
+    Error_Handler();
+  }
+  if (USBD_VENDOR_RegisterInterface(&hUsbDeviceHS, &USBD_Interface_fops_Vendor_HS) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_CMPSIT_SetClassID(&hUsbDeviceHS, CLASS_TYPE_MSC, 0U) == 0xFFU)
+  {
+    Error_Handler();
+  }
+  if (USBD_MSC_RegisterStorage(&hUsbDeviceHS, &USBD_Storage_Interface_fops_HS) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  /* FIFO split depends on the endpoints of every registered class */
+  if (USBD_LL_ConfigFifo(&hUsbDeviceHS) != USBD_OK)
+  {
+    Error_Handler();
+  }
   if (USBD_Start(&hUsbDeviceHS) != USBD_OK)
   {
     Error_Handler();
@@ -22,6 +22,9 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN INCLUDE */
+#if (USBD_FAST_PATH == 1U)
+#include "../../Applications/FastPath/fast-path.h"
+#endif /* USBD_FAST_PATH */
 
 /* USER CODE END INCLUDE */
 
@@ -49,7 +52,39 @@
   */
 
 /* USER CODE BEGIN PRIVATE_TYPES */
-
+/**
+  * @brief Receive/transmit pipeline of one CDC ACM port
+  *
+  * Both rings are single producer / single consumer with free running
+  * indices: the USB interrupt produces into RxRing and consumes TxRing, one
+  * task per port consumes RxRing and produces TxRing.
+  *
+  * While no host listens (port not configured, or DTR low because no
+  * terminal has the port open) TxRing is not sent: it parks the output as a
+  * backlog where a write overwrites the oldest bytes instead of failing. The
+  * backlog goes out when the host raises DTR again.
+  */
+typedef struct
+{
+  uint8_t           ClassId;      /* composite class id, valid after Init */
+  __IO uint8_t      Active;       /* port configured by the host */
+  __IO uint8_t      Dtr;          /* host side opened, DTR of SET_CONTROL_LINE_STATE */
+  __IO uint8_t      RxHeld;       /* OUT endpoint left NAKing, ring too full */
+  uint8_t           *RxRing;
+  uint32_t          RxSize;
+  __IO uint32_t     RxHead;
+  __IO uint32_t     RxTail;
+  uint8_t           *TxRing;
+  uint32_t          TxSize;
+  __IO uint32_t     TxHead;
+  __IO uint32_t     TxTail;
+  __IO uint32_t     TxInFlight;   /* bytes of TxRing owned by the IN endpoint */
+  USBD_CDC_LineCodingTypeDef LineCoding;
+  CDC_PortStatsTypeDef Stats;
+  CDC_RxNotifyTypeDef RxNotify;   /* reader wake-up, NULL when polled */
+  CDC_TxNotifyTypeDef TxNotify;   /* writer refill, NULL when none */
+  uint32_t          RxPacket[CDC_DATA_HS_MAX_PACKET_SIZE / 4U];
+} CDC_PortTypeDef;
 /* USER CODE END PRIVATE_TYPES */
 
 /**
@@ -62,6 +97,12 @@
   */
 
 /* USER CODE BEGIN PRIVATE_DEFINES */
+/* OUT packet size of the running speed */
+#define CDC_RX_PACKET_SIZE(pdev)  (((pdev)->dev_speed == USBD_SPEED_HIGH) ? \
+                                   CDC_DATA_HS_OUT_PACKET_SIZE : CDC_DATA_FS_OUT_PACKET_SIZE)
+
+/* wValue bits of SET_CONTROL_LINE_STATE */
+#define CDC_LINE_STATE_DTR        0x0001U
 /* USER CODE END PRIVATE_DEFINES */
 
 /**
@@ -74,7 +115,12 @@
   */
 
 /* USER CODE BEGIN PRIVATE_MACRO */
+/* Short critical section usable from tasks and from the USB interrupt */
+#define CDC_ENTER_CRITICAL()      uint32_t primask_ = __get_PRIMASK(); __disable_irq()
+#define CDC_EXIT_CRITICAL()       __set_PRIMASK(primask_)
 
+/* A host reads the port: transmit, otherwise park the output */
+#define CDC_LISTENING(p)          (((p)->Active != 0U) && ((p)->Dtr != 0U))
 /* USER CODE END PRIVATE_MACRO */
 
 /**
@@ -95,7 +141,22 @@ uint8_t UserRxBufferHS[APP_RX_DATA_SIZE];
 uint8_t UserTxBufferHS[APP_TX_DATA_SIZE];
 
 /* USER CODE BEGIN PRIVATE_VARIABLES */
+static uint8_t DataRxBufferHS[APP_DATA_RX_SIZE];
+static uint8_t DataTxBufferHS[APP_DATA_TX_SIZE];
 
+static CDC_PortTypeDef CDC_Port[CDC_PORT_NUM] =
+{
+  [CDC_PORT_SHELL] = {
+    .RxRing = UserRxBufferHS, .RxSize = APP_RX_DATA_SIZE,
+    .TxRing = UserTxBufferHS, .TxSize = APP_TX_DATA_SIZE,
+    .LineCoding = { 115200U, 0U, 0U, 8U },
+  },
+  [CDC_PORT_DATA] = {
+    .RxRing = DataRxBufferHS, .RxSize = APP_DATA_RX_SIZE,
+    .TxRing = DataTxBufferHS, .TxSize = APP_DATA_TX_SIZE,
+    .LineCoding = { 115200U, 0U, 0U, 8U },
+  },
+};
 /* USER CODE END PRIVATE_VARIABLES */
 
 /**
@@ -110,7 +171,11 @@ uint8_t UserTxBufferHS[APP_TX_DATA_SIZE];
 extern USBD_HandleTypeDef hUsbDeviceHS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
-
+uint8_t CDC_EpAdd_HS[CDC_PORT_NUM][3] =
+{
+  [CDC_PORT_SHELL] = { 0x81U, 0x01U, 0x82U },
+  [CDC_PORT_DATA]  = { 0x83U, 0x03U, 0x84U },
+};
 /* USER CODE END EXPORTED_VARIABLES */
 
 /**
@@ -129,7 +194,18 @@ static int8_t CDC_Receive_HS(uint8_t* pbuf, uint32_t *Len);
 static int8_t CDC_TransmitCplt_HS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
-
+static int8_t CDC_Init_HS_Data(void);
+static int8_t CDC_DeInit_HS_Data(void);
+static int8_t CDC_Control_HS_Data(uint8_t cmd, uint8_t* pbuf, uint16_t length);
+static int8_t CDC_Receive_HS_Data(uint8_t* pbuf, uint32_t *Len);
+static int8_t CDC_TransmitCplt_HS_Data(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
+
+static int8_t CDC_PortInit(uint8_t port);
+static int8_t CDC_PortDeInit(uint8_t port);
+static int8_t CDC_PortControl(uint8_t port, uint8_t cmd, uint8_t* pbuf, uint16_t length);
+static int8_t CDC_PortReceive(uint8_t port, uint8_t* Buf, uint32_t *Len);
+static int8_t CDC_PortTransmitCplt(uint8_t port);
+static void   CDC_TxKick(CDC_PortTypeDef *p);
 /* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
 
 /**
@@ -145,6 +221,17 @@ USBD_CDC_ItfTypeDef USBD_Interface_fops_HS =
   CDC_TransmitCplt_HS
 };
 
+/* USER CODE BEGIN FOPS */
+USBD_CDC_ItfTypeDef USBD_Interface_fops_HS_Data =
+{
+  CDC_Init_HS_Data,
+  CDC_DeInit_HS_Data,
+  CDC_Control_HS_Data,
+  CDC_Receive_HS_Data,
+  CDC_TransmitCplt_HS_Data
+};
+/* USER CODE END FOPS */
+
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -154,10 +241,7 @@ USBD_CDC_ItfTypeDef USBD_Interface_fops_HS =
 static int8_t CDC_Init_HS(void)
 {
   /* USER CODE BEGIN 8 */
-  /* Set Application Buffers */
-  USBD_CDC_SetTxBuffer(&hUsbDeviceHS, UserTxBufferHS, 0);
-  USBD_CDC_SetRxBuffer(&hUsbDeviceHS, UserRxBufferHS);
-  return (USBD_OK);
+  return CDC_PortInit(CDC_PORT_SHELL);
   /* USER CODE END 8 */
 }
 
@@ -169,7 +253,7 @@ static int8_t CDC_Init_HS(void)
 static int8_t CDC_DeInit_HS(void)
 {
   /* USER CODE BEGIN 9 */
-  return (USBD_OK);
+  return CDC_PortDeInit(CDC_PORT_SHELL);
   /* USER CODE END 9 */
 }
 
@@ -183,66 +267,7 @@ static int8_t CDC_DeInit_HS(void)
 static int8_t CDC_Control_HS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 {
   /* USER CODE BEGIN 10 */
-  switch(cmd)
-  {
-  case CDC_SEND_ENCAPSULATED_COMMAND:
-
-    break;
-
-  case CDC_GET_ENCAPSULATED_RESPONSE:
-
-    break;
-
-  case CDC_SET_COMM_FEATURE:
-
-    break;
-
-  case CDC_GET_COMM_FEATURE:
-
-    break;
-
-  case CDC_CLEAR_COMM_FEATURE:
-
-    break;
-
-  /*******************************************************************************/
-  /* Line Coding Structure                                                       */
-  /*-----------------------------------------------------------------------------*/
-  /* Offset | Field       | Size | Value  | Description                          */
-  /* 0      | dwDTERate   |   4  | Number |Data terminal rate, in bits per second*/
-  /* 4      | bCharFormat |   1  | Number | Stop bits                            */
-  /*                                        0 - 1 Stop bit                       */
-  /*                                        1 - 1.5 Stop bits                    */
-  /*                                        2 - 2 Stop bits                      */
-  /* 5      | bParityType |  1   | Number | Parity                               */
-  /*                                        0 - None                             */
-  /*                                        1 - Odd                              */
-  /*                                        2 - Even                             */
-  /*                                        3 - Mark                             */
-  /*                                        4 - Space                            */
-  /* 6      | bDataBits  |   1   | Number Data bits (5, 6, 7, 8 or 16).          */
-  /*******************************************************************************/
-  case CDC_SET_LINE_CODING:
-
-    break;
-
-  case CDC_GET_LINE_CODING:
-
-    break;
-
-  case CDC_SET_CONTROL_LINE_STATE:
-
-    break;
-
-  case CDC_SEND_BREAK:
-
-    break;
-
-  default:
-    break;
-  }
-
-  return (USBD_OK);
+  return CDC_PortControl(CDC_PORT_SHELL, cmd, pbuf, length);
   /* USER CODE END 10 */
 }
 
@@ -264,9 +289,12 @@ static int8_t CDC_Control_HS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 static int8_t CDC_Receive_HS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 11 */
-  USBD_CDC_SetRxBuffer(&hUsbDeviceHS, &Buf[0]);
-  USBD_CDC_ReceivePacket(&hUsbDeviceHS);
-  return (USBD_OK);
+  uint32_t len = *Len;
+#if (USBD_FAST_PATH == 1U)
+  /* real-time frames act here, the shell only sees the text around them */
+  len = fast_path_filter(Buf, len);
+#endif /* USBD_FAST_PATH */
+  return CDC_PortReceive(CDC_PORT_SHELL, Buf, &len);
   /* USER CODE END 11 */
 }
 
@@ -281,12 +309,7 @@ uint8_t CDC_Transmit_HS(uint8_t* Buf, uint16_t Len)
 {
   uint8_t result = USBD_OK;
   /* USER CODE BEGIN 12 */
-  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceHS.pClassData;
-  if (hcdc->TxState != 0){
-    return USBD_BUSY;
-  }
-  USBD_CDC_SetTxBuffer(&hUsbDeviceHS, Buf, Len);
-  result = USBD_CDC_TransmitPacket(&hUsbDeviceHS);
+  result = CDC_TransmitPort_HS(CDC_PORT_SHELL, Buf, Len);
   /* USER CODE END 12 */
   return result;
 }
@@ -310,12 +333,507 @@ static int8_t CDC_TransmitCplt_HS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
   UNUSED(Buf);
   UNUSED(Len);
   UNUSED(epnum);
+  result = CDC_PortTransmitCplt(CDC_PORT_SHELL);
   /* USER CODE END 14 */
   return result;
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
+/*---------------------------------------------------------------------------*/
+/* Data port callbacks                                                       */
+/*---------------------------------------------------------------------------*/
+
+static int8_t CDC_Init_HS_Data(void)
+{
+  return CDC_PortInit(CDC_PORT_DATA);
+}
+
+static int8_t CDC_DeInit_HS_Data(void)
+{
+  return CDC_PortDeInit(CDC_PORT_DATA);
+}
+
+static int8_t CDC_Control_HS_Data(uint8_t cmd, uint8_t* pbuf, uint16_t length)
+{
+  return CDC_PortControl(CDC_PORT_DATA, cmd, pbuf, length);
+}
+
+static int8_t CDC_Receive_HS_Data(uint8_t* Buf, uint32_t *Len)
+{
+  return CDC_PortReceive(CDC_PORT_DATA, Buf, Len);
+}
+
+static int8_t CDC_TransmitCplt_HS_Data(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+  UNUSED(Buf);
+  UNUSED(Len);
+  UNUSED(epnum);
+  return CDC_PortTransmitCplt(CDC_PORT_DATA);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Port pipeline                                                             */
+/*---------------------------------------------------------------------------*/
+
+/**
+  * @brief  Bind the port to its class instance and arm the OUT endpoint.
+  * @note   Called from USBD_CDC_Init() with pdev->classId set to this port.
+  * @param  port: CDC port index
+  * @retval USBD_OK
+  */
+static int8_t CDC_PortInit(uint8_t port)
+{
+  CDC_PortTypeDef *p = &CDC_Port[port];
+
+  p->ClassId = (uint8_t)hUsbDeviceHS.classId;
+  p->RxHead = 0U;
+  p->RxTail = 0U;
+  p->RxHeld = 0U;
+  p->Dtr = 0U;
+
+  /* The backlog survives a re-enumeration, only an aborted transfer is lost */
+  p->TxTail += p->TxInFlight;
+  p->Stats.TxOverwritten += p->TxInFlight;
+  p->TxInFlight = 0U;
+
+  USBD_CDC_SetTxBuffer(&hUsbDeviceHS, p->TxRing, 0U, p->ClassId);
+  USBD_CDC_SetRxBuffer(&hUsbDeviceHS, (uint8_t *)p->RxPacket);
+  p->Active = 1U;
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Detach the port when the host deconfigures the device.
+  * @param  port: CDC port index
+  * @retval USBD_OK
+  */
+static int8_t CDC_PortDeInit(uint8_t port)
+{
+  CDC_Port[port].Active = 0U;
+  CDC_Port[port].Dtr = 0U;
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Class requests of one port; line coding and DTR are stored per port.
+  * @note   A rising DTR sends the output parked while nobody listened.
+  * @param  port: CDC port index
+  * @param  cmd: Command code
+  * @param  pbuf: Buffer containing command data (request parameters)
+  * @param  length: Number of data to be sent (in bytes)
+  * @retval USBD_OK
+  */
+static int8_t CDC_PortControl(uint8_t port, uint8_t cmd, uint8_t* pbuf, uint16_t length)
+{
+  CDC_PortTypeDef *p = &CDC_Port[port];
+
+  switch(cmd)
+  {
+  case CDC_SET_LINE_CODING:
+    if (length >= 7U)
+    {
+      p->LineCoding.bitrate    = (uint32_t)pbuf[0] | ((uint32_t)pbuf[1] << 8) |
+                                 ((uint32_t)pbuf[2] << 16) | ((uint32_t)pbuf[3] << 24);
+      p->LineCoding.format     = pbuf[4];
+      p->LineCoding.paritytype = pbuf[5];
+      p->LineCoding.datatype   = pbuf[6];
+    }
+    break;
+
+  case CDC_GET_LINE_CODING:
+    pbuf[0] = (uint8_t)(p->LineCoding.bitrate);
+    pbuf[1] = (uint8_t)(p->LineCoding.bitrate >> 8);
+    pbuf[2] = (uint8_t)(p->LineCoding.bitrate >> 16);
+    pbuf[3] = (uint8_t)(p->LineCoding.bitrate >> 24);
+    pbuf[4] = p->LineCoding.format;
+    pbuf[5] = p->LineCoding.paritytype;
+    pbuf[6] = p->LineCoding.datatype;
+    break;
+
+  case CDC_SET_CONTROL_LINE_STATE:
+    /* no data stage: pbuf is the setup request itself */
+    if ((((USBD_SetupReqTypedef *)(void *)pbuf)->wValue & CDC_LINE_STATE_DTR) != 0U)
+    {
+      if (p->Dtr == 0U)
+      {
+        p->Dtr = 1U;
+        p->Stats.HostOpens++;
+        if (p->TxNotify != NULL)
+        {
+          p->TxNotify(port);
+        }
+        CDC_TxKick(p);
+      }
+    }
+    else
+    {
+      p->Dtr = 0U;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Move one OUT packet into the receive ring.
+  * @note   Runs in the USB interrupt. If the ring cannot hold another full
+  *         packet the endpoint is not re-armed: the host is NAKed until
+  *         CDC_Read_HS() frees space, so no byte is ever dropped.
+  * @param  port: CDC port index
+  * @param  Buf: received packet
+  * @param  Len: received length
+  * @retval USBD_OK
+  */
+static int8_t CDC_PortReceive(uint8_t port, uint8_t* Buf, uint32_t *Len)
+{
+  CDC_PortTypeDef *p = &CDC_Port[port];
+  uint32_t len = *Len;
+  uint32_t mask = p->RxSize - 1U;
+  uint32_t head = p->RxHead;
+
+  for (uint32_t i = 0U; i < len; i++)
+  {
+    p->RxRing[(head + i) & mask] = Buf[i];
+  }
+  p->RxHead = head + len;
+  p->Stats.RxBytes += len;
+  p->Stats.RxPackets++;
+
+  if ((p->RxSize - (p->RxHead - p->RxTail)) >= CDC_RX_PACKET_SIZE(&hUsbDeviceHS))
+  {
+    USBD_CDC_ReceivePacket(&hUsbDeviceHS);
+  }
+  else
+  {
+    p->RxHeld = 1U;
+    p->Stats.RxHeld++;
+  }
+
+  if (p->RxNotify != NULL)
+  {
+    p->RxNotify(port);
+  }
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Release the bytes of the completed IN transfer and chain the next.
+  * @note   Runs in the USB interrupt.
+  * @param  port: CDC port index
+  * @retval USBD_OK
+  */
+static int8_t CDC_PortTransmitCplt(uint8_t port)
+{
+  CDC_PortTypeDef *p = &CDC_Port[port];
+  uint32_t done = p->TxInFlight;
+
+  if (done != 0U)
+  {
+    p->TxTail += done;
+    p->TxInFlight = 0U;
+    p->Stats.TxBytes += done;
+    p->Stats.TxTransfers++;
+  }
+  if (p->TxNotify != NULL)
+  {
+    p->TxNotify(port);
+  }
+  CDC_TxKick(p);
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Start an IN transfer with the contiguous head of the ring.
+  * @note   Safe to call from a task or from the USB interrupt.
+  * @param  p: port
+  * @retval None
+  */
+static void CDC_TxKick(CDC_PortTypeDef *p)
+{
+  USBD_CDC_HandleTypeDef *hcdc;
+  uint32_t pending;
+  uint32_t offset;
+  uint32_t chunk;
+
+  CDC_ENTER_CRITICAL();
+  hcdc = (USBD_CDC_HandleTypeDef *)hUsbDeviceHS.pClassDataCmsit[p->ClassId];
+  pending = p->TxHead - p->TxTail;
+  if (CDC_LISTENING(p) && (hcdc != NULL) && (hcdc->TxState == 0U) &&
+      (p->TxInFlight == 0U) && (pending != 0U))
+  {
+    offset = p->TxTail & (p->TxSize - 1U);
+    chunk = p->TxSize - offset;
+    if (chunk > pending)
+    {
+      chunk = pending;
+    }
+    p->TxInFlight = chunk;
+    USBD_CDC_SetTxBuffer(&hUsbDeviceHS, &p->TxRing[offset], chunk, p->ClassId);
+    if (USBD_CDC_TransmitPacket(&hUsbDeviceHS, p->ClassId) != USBD_OK)
+    {
+      p->TxInFlight = 0U;
+    }
+  }
+  CDC_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  Send a caller owned buffer directly on the IN endpoint of a port.
+  * @note   The buffer must stay valid until the transfer completes. Returns
+  *         USBD_BUSY while the port still has a transfer in flight, and
+  *         USBD_FAIL while no host listens: nothing is parked on this path.
+  * @param  port: CDC port index
+  * @param  Buf: Buffer of data to be sent
+  * @param  Len: Number of data to be sent (in bytes)
+  * @retval USBD_OK, USBD_BUSY or USBD_FAIL
+  */
+uint8_t CDC_TransmitPort_HS(uint8_t port, uint8_t *Buf, uint16_t Len)
+{
+  USBD_CDC_HandleTypeDef *hcdc;
+  uint8_t result = USBD_BUSY;
+
+  if ((port >= CDC_PORT_NUM) || !CDC_LISTENING(&CDC_Port[port]))
+  {
+    return USBD_FAIL;
+  }
+
+  CDC_ENTER_CRITICAL();
+  hcdc = (USBD_CDC_HandleTypeDef *)hUsbDeviceHS.pClassDataCmsit[CDC_Port[port].ClassId];
+  if ((hcdc != NULL) && (hcdc->TxState == 0U) && (CDC_Port[port].TxInFlight == 0U))
+  {
+    USBD_CDC_SetTxBuffer(&hUsbDeviceHS, Buf, Len, CDC_Port[port].ClassId);
+    result = USBD_CDC_TransmitPacket(&hUsbDeviceHS, CDC_Port[port].ClassId);
+  }
+  CDC_EXIT_CRITICAL();
+  return result;
+}
+
+/**
+  * @brief  Queue bytes on the transmit ring of a port, never blocks.
+  * @note   While a host listens, bytes that do not fit are refused and
+  *         counted in TxDropped. While none does, the ring is a backlog: the
+  *         oldest bytes give way and are counted in TxOverwritten, so the
+  *         whole write is always taken.
+  * @param  port: CDC port index
+  * @param  Buf: data
+  * @param  Len: length
+  * @retval number of bytes queued
+  */
+uint32_t CDC_Write_HS(uint8_t port, const uint8_t *Buf, uint32_t Len)
+{
+  CDC_PortTypeDef *p;
+  uint32_t space;
+  uint32_t mask;
+  uint32_t head;
+  uint32_t n;
+  uint32_t drop;
+
+  if (port >= CDC_PORT_NUM)
+  {
+    return 0U;
+  }
+  p = &CDC_Port[port];
+  mask = p->TxSize - 1U;
+  head = p->TxHead;
+  space = p->TxSize - (head - p->TxTail);
+
+  if ((Len > space) && !CDC_LISTENING(p))
+  {
+    /* Forget the oldest parked bytes, never those of a transfer in flight;
+       the interrupt also moves TxTail, hence the critical section */
+    CDC_ENTER_CRITICAL();
+    space = p->TxSize - (head - p->TxTail);
+    drop = head - p->TxTail - p->TxInFlight;
+    drop = ((Len - space) < drop) ? (Len - space) : drop;
+    p->TxTail += drop;
+    p->Stats.TxOverwritten += drop;
+    space = p->TxSize - (head - p->TxTail);
+    CDC_EXIT_CRITICAL();
+
+    /* A write larger than the ring keeps its tail */
+    if (Len > space)
+    {
+      p->Stats.TxOverwritten += Len - space;
+      Buf += Len - space;
+      Len = space;
+    }
+  }
+  n = (Len < space) ? Len : space;
+
+  for (uint32_t i = 0U; i < n; i++)
+  {
+    p->TxRing[(head + i) & mask] = Buf[i];
+  }
+  __DMB();
+  p->TxHead = head + n;
+  p->Stats.TxDropped += Len - n;
+
+  CDC_TxKick(p);
+  return n;
+}
+
+/**
+  * @brief  Take bytes from the receive ring of a port, never blocks.
+  * @param  port: CDC port index
+  * @param  Buf: destination
+  * @param  Len: capacity of the destination
+  * @retval number of bytes copied
+  */
+uint32_t CDC_Read_HS(uint8_t port, uint8_t *Buf, uint32_t Len)
+{
+  CDC_PortTypeDef *p;
+  uint32_t avail;
+  uint32_t mask;
+  uint32_t tail;
+  uint32_t n;
+
+  if (port >= CDC_PORT_NUM)
+  {
+    return 0U;
+  }
+  p = &CDC_Port[port];
+  mask = p->RxSize - 1U;
+  tail = p->RxTail;
+  avail = p->RxHead - tail;
+  n = (Len < avail) ? Len : avail;
+
+  for (uint32_t i = 0U; i < n; i++)
+  {
+    Buf[i] = p->RxRing[(tail + i) & mask];
+  }
+  __DMB();
+  p->RxTail = tail + n;
+
+  /* Resume the host once a full packet fits again */
+  if ((p->RxHeld != 0U) &&
+      ((p->RxSize - (p->RxHead - p->RxTail)) >= CDC_RX_PACKET_SIZE(&hUsbDeviceHS)))
+  {
+    CDC_ENTER_CRITICAL();
+    if ((p->RxHeld != 0U) && (p->Active != 0U))
+    {
+      p->RxHeld = 0U;
+      (void)USBD_LL_PrepareReceive(&hUsbDeviceHS, CDC_EpAdd_HS[port][1],
+                                   (uint8_t *)p->RxPacket, CDC_RX_PACKET_SIZE(&hUsbDeviceHS));
+    }
+    CDC_EXIT_CRITICAL();
+  }
+  return n;
+}
+
+/**
+  * @brief  Bytes waiting in the receive ring of a port.
+  * @param  port: CDC port index
+  * @retval byte count
+  */
+uint32_t CDC_RxAvailable_HS(uint8_t port)
+{
+  if (port >= CDC_PORT_NUM)
+  {
+    return 0U;
+  }
+  return CDC_Port[port].RxHead - CDC_Port[port].RxTail;
+}
+
+/**
+  * @brief  Free space in the transmit ring of a port.
+  * @param  port: CDC port index
+  * @retval byte count
+  */
+uint32_t CDC_TxFree_HS(uint8_t port)
+{
+  if (port >= CDC_PORT_NUM)
+  {
+    return 0U;
+  }
+  return CDC_Port[port].TxSize - (CDC_Port[port].TxHead - CDC_Port[port].TxTail);
+}
+
+/**
+  * @brief  Tell whether the host has configured the port.
+  * @param  port: CDC port index
+  * @retval 1 when writes can reach the host, 0 otherwise
+  */
+uint8_t CDC_PortReady_HS(uint8_t port)
+{
+  if (port >= CDC_PORT_NUM)
+  {
+    return 0U;
+  }
+  return CDC_Port[port].Active;
+}
+
+/**
+  * @brief  Tell whether a host reads the port: configured and DTR raised.
+  * @note   While it returns 0 writes are parked, a writer waiting for room
+  *         in the transmit ring would wait for nothing.
+  * @param  port: CDC port index
+  * @retval 1 when a terminal has the port open, 0 otherwise
+  */
+uint8_t CDC_HostOpen_HS(uint8_t port)
+{
+  if (port >= CDC_PORT_NUM)
+  {
+    return 0U;
+  }
+  return CDC_LISTENING(&CDC_Port[port]) ? 1U : 0U;
+}
+
+/**
+  * @brief  Register the function waking up the reader of a port.
+  * @note   The callback runs in the USB interrupt: it may only use FromISR
+  *         services (osThreadFlagsSet, osSemaphoreRelease, ...).
+  * @param  port: CDC port index
+  * @param  notify: callback, NULL to go back to polling
+  * @retval None
+  */
+void CDC_SetRxNotify_HS(uint8_t port, CDC_RxNotifyTypeDef notify)
+{
+  if (port < CDC_PORT_NUM)
+  {
+    CDC_Port[port].RxNotify = notify;
+  }
+}
+
+/**
+  * @brief  Register the function refilling the transmit ring of a port.
+  * @note   Called in the USB interrupt when an IN transfer completes and when
+  *         the host opens the port, before the next transfer is chained: a
+  *         scheduler in front of the port can top the ring up just in time.
+  *         Same restrictions as the receive callback.
+  * @param  port: CDC port index
+  * @param  notify: callback, NULL for none
+  * @retval None
+  */
+void CDC_SetTxNotify_HS(uint8_t port, CDC_TxNotifyTypeDef notify)
+{
+  if (port < CDC_PORT_NUM)
+  {
+    CDC_Port[port].TxNotify = notify;
+  }
+}
+
+/**
+  * @brief  Snapshot of the counters of a port.
+  * @param  port: CDC port index
+  * @param  stats: destination
+  * @retval None
+  */
+void CDC_GetStats_HS(uint8_t port, CDC_PortStatsTypeDef *stats)
+{
+  if ((port >= CDC_PORT_NUM) || (stats == NULL))
+  {
+    return;
+  }
+  CDC_ENTER_CRITICAL();
+  *stats = CDC_Port[port].Stats;
+  CDC_EXIT_CRITICAL();
+}
+
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
 /**
@@ -52,7 +52,14 @@
 #define APP_RX_DATA_SIZE  2048
 #define APP_TX_DATA_SIZE  2048
 /* USER CODE BEGIN EXPORTED_DEFINES */
-
+/* CDC ACM ports of the composite device */
+#define CDC_PORT_SHELL    0U  /* interactive shell traffic */
+#define CDC_PORT_DATA     1U  /* bulk streaming / dumps */
+#define CDC_PORT_NUM      2U
+
+/* Ring sizes of the data port (must be powers of two) */
+#define APP_DATA_RX_SIZE  2048
+#define APP_DATA_TX_SIZE  8192
 /* USER CODE END EXPORTED_DEFINES */
 
 /**
@@ -65,7 +72,30 @@
   */
 
 /* USER CODE BEGIN EXPORTED_TYPES */
+/**
+  * @brief Per port traffic counters
+  */
+typedef struct
+{
+  uint32_t RxBytes;       /* bytes received from the host */
+  uint32_t RxPackets;     /* OUT packets received */
+  uint32_t RxHeld;        /* times the OUT endpoint was held (NAK) on a full ring */
+  uint32_t TxBytes;       /* bytes acknowledged by the host */
+  uint32_t TxTransfers;   /* IN transfers completed */
+  uint32_t TxDropped;     /* bytes refused because the transmit ring was full */
+  uint32_t TxOverwritten; /* parked bytes overwritten before a host came to read them */
+  uint32_t HostOpens;     /* DTR rising edges, a terminal opened the port */
+} CDC_PortStatsTypeDef;
 
+/**
+  * @brief Called from the USB interrupt after bytes were added to a port
+  */
+typedef void (*CDC_RxNotifyTypeDef)(uint8_t port);
+
+/**
+  * @brief Called from the USB interrupt when a port can take more bytes
+  */
+typedef void (*CDC_TxNotifyTypeDef)(uint8_t port);
 /* USER CODE END EXPORTED_TYPES */
 
 /**
@@ -94,7 +124,11 @@
 extern USBD_CDC_ItfTypeDef USBD_Interface_fops_HS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
+/** CDC Interface callback of the data port. */
+extern USBD_CDC_ItfTypeDef USBD_Interface_fops_HS_Data;
 
+/** Endpoints of every port: data IN, data OUT, notification IN. */
+extern uint8_t CDC_EpAdd_HS[CDC_PORT_NUM][3];
 /* USER CODE END EXPORTED_VARIABLES */
 
 /**
@@ -109,7 +143,16 @@ extern USBD_CDC_ItfTypeDef USBD_Interface_fops_HS;
 uint8_t CDC_Transmit_HS(uint8_t* Buf, uint16_t Len);
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
-
+uint8_t  CDC_TransmitPort_HS(uint8_t port, uint8_t *Buf, uint16_t Len);
+uint32_t CDC_Write_HS(uint8_t port, const uint8_t *Buf, uint32_t Len);
+uint32_t CDC_Read_HS(uint8_t port, uint8_t *Buf, uint32_t Len);
+uint32_t CDC_RxAvailable_HS(uint8_t port);
+uint32_t CDC_TxFree_HS(uint8_t port);
+uint8_t  CDC_PortReady_HS(uint8_t port);
+uint8_t  CDC_HostOpen_HS(uint8_t port);
+void     CDC_SetRxNotify_HS(uint8_t port, CDC_RxNotifyTypeDef notify);
+void     CDC_SetTxNotify_HS(uint8_t port, CDC_TxNotifyTypeDef notify);
+void     CDC_GetStats_HS(uint8_t port, CDC_PortStatsTypeDef *stats);
 /* USER CODE END EXPORTED_FUNCTIONS */
 
 /**
@@ -0,0 +1,216 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_storage_if.c
+  * @brief          : Memory management layer.
+  ******************************************************************************
+  * @attention
+  *
+  * Every hook but STORAGE_Init_HS() and STORAGE_Notify_HS() is called by
+  * USBD_MSC_Process() in the storage task, which also owns the flash and the
+  * sector cache; the hooks forward to it without locking.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_storage_if.h"
+#include "../../Applications/Storage/storage-intf.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define STORAGE_LUN_NBR                  1U
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device.
+  * @{
+  */
+
+/** @addtogroup USBD_STORAGE
+  * @{
+  */
+
+/** @defgroup USBD_STORAGE_Private_Variables USBD_STORAGE_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+
+/* Standard inquiry data, one per LUN */
+static const int8_t STORAGE_Inquirydata_HS[] = {
+  /* LUN 0 */
+  0x00,         /* direct access block device */
+  0x80,         /* removable */
+  0x02,         /* SPC-2 */
+  0x02,         /* response data format */
+  (STANDARD_INQUIRY_DATA_LEN - 5),
+  0x00,
+  0x00,
+  0x00,
+  'S', 'T', 'M', ' ', ' ', ' ', ' ', ' ', /* Manufacturer : 8 bytes */
+  'O', 'S', 'P', 'I', ' ', 'F', 'l', 'a', /* Product      : 16 Bytes */
+  's', 'h', ' ', ' ', ' ', ' ', ' ', ' ',
+  '1', '.', '0', ' '                      /* Version      : 4 Bytes */
+};
+
+/* Bulk IN, bulk OUT */
+uint8_t MSC_EpAdd_HS[2] = { MSC_IN_EP, MSC_OUT_EP };
+/**
+  * @}
+  */
+
+/** @defgroup USBD_STORAGE_Private_FunctionPrototypes USBD_STORAGE_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+static int8_t STORAGE_Init_HS(uint8_t lun);
+static int8_t STORAGE_GetCapacity_HS(uint8_t lun, uint32_t *block_num, uint16_t *block_size);
+static int8_t STORAGE_IsReady_HS(uint8_t lun);
+static int8_t STORAGE_IsWriteProtected_HS(uint8_t lun);
+static int8_t STORAGE_Read_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t STORAGE_Write_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t STORAGE_GetMaxLun_HS(void);
+static int8_t STORAGE_Sync_HS(uint8_t lun);
+static void   STORAGE_Notify_HS(void);
+/**
+  * @}
+  */
+
+USBD_StorageTypeDef USBD_Storage_Interface_fops_HS =
+{
+  STORAGE_Init_HS,
+  STORAGE_GetCapacity_HS,
+  STORAGE_IsReady_HS,
+  STORAGE_IsWriteProtected_HS,
+  STORAGE_Read_HS,
+  STORAGE_Write_HS,
+  STORAGE_GetMaxLun_HS,
+  (int8_t *)STORAGE_Inquirydata_HS,
+  STORAGE_Sync_HS,
+  STORAGE_Notify_HS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the storage unit (medium).
+  * @note   Called in the USB interrupt on SET_CONFIGURATION, the storage task
+  *         brings the flash up on its own.
+  * @param  lun: Logical unit number.
+  * @retval USBD_OK
+  */
+static int8_t STORAGE_Init_HS(uint8_t lun)
+{
+  UNUSED(lun);
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Returns the medium capacity.
+  * @param  lun: Logical unit number.
+  * @param  block_num: Number of total block number.
+  * @param  block_size: Block size.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STORAGE_GetCapacity_HS(uint8_t lun, uint32_t *block_num, uint16_t *block_size)
+{
+  UNUSED(lun);
+
+  if (storage_ready() == 0U)
+  {
+    return (USBD_FAIL);
+  }
+
+  *block_num  = storage_block_count();
+  *block_size = STORAGE_BLOCK_SIZE;
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Checks whether the medium is ready.
+  * @param  lun:  Logical unit number.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STORAGE_IsReady_HS(uint8_t lun)
+{
+  UNUSED(lun);
+  return (storage_ready() != 0U) ? (int8_t)USBD_OK : (int8_t)USBD_FAIL;
+}
+
+/**
+  * @brief  Checks whether the medium is write protected.
+  * @param  lun: Logical unit number.
+  * @retval USBD_OK (0), the medium is writable
+  */
+static int8_t STORAGE_IsWriteProtected_HS(uint8_t lun)
+{
+  UNUSED(lun);
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Reads data from the medium.
+  * @param  lun: Logical unit number.
+  * @param  buf: data buffer.
+  * @param  blk_addr: Logical block address.
+  * @param  blk_len: Blocks number.
+  * @retval 0 on success, -1 on a flash error
+  */
+static int8_t STORAGE_Read_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  UNUSED(lun);
+  return storage_read(buf, blk_addr, blk_len);
+}
+
+/**
+  * @brief  Writes data into the medium, through the write-back cache.
+  * @param  lun: Logical unit number.
+  * @param  buf: data buffer.
+  * @param  blk_addr: Logical block address.
+  * @param  blk_len: Blocks number.
+  * @retval 0 on success, -1 on a flash error
+  */
+static int8_t STORAGE_Write_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  UNUSED(lun);
+  return storage_write(buf, blk_addr, blk_len);
+}
+
+/**
+  * @brief  Returns the Max Supported LUNs.
+  * @param  None
+  * @retval Lun(s) number.
+  */
+static int8_t STORAGE_GetMaxLun_HS(void)
+{
+  return (int8_t)(STORAGE_LUN_NBR - 1U);
+}
+
+/**
+  * @brief  Writes the cache back, SYNCHRONIZE CACHE and eject.
+  * @param  lun: Logical unit number.
+  * @retval 0 on success, -1 on a flash error
+  */
+static int8_t STORAGE_Sync_HS(uint8_t lun)
+{
+  UNUSED(lun);
+  return storage_sync();
+}
+
+/**
+  * @brief  Wakes the storage task, an MSC event is pending.
+  * @note   Runs in the USB interrupt.
+  * @retval None
+  */
+static void STORAGE_Notify_HS(void)
+{
+  storage_notify();
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,57 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_storage_if.h
+  * @brief          : Header for usbd_storage_if.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * Storage interface of the mass storage function: one LUN backed by the
+  * OSPI flash through the storage task (Applications/Storage).
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_STORAGE_IF_H__
+#define __USBD_STORAGE_IF_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_msc.h"
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief For Usb device.
+  * @{
+  */
+
+/** @defgroup USBD_STORAGE USBD_STORAGE
+  * @brief Header file for the usb_storage.c file
+  * @{
+  */
+
+/** @defgroup USBD_STORAGE_Exported_Variables USBD_STORAGE_Exported_Variables
+  * @brief Public variables.
+  * @{
+  */
+extern USBD_StorageTypeDef USBD_Storage_Interface_fops_HS;
+extern uint8_t MSC_EpAdd_HS[2];
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_STORAGE_IF_H__ */
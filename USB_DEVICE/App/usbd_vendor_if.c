@@ -0,0 +1,305 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_vendor_if.c
+  * @brief          : Usb vendor bulk streaming interface.
+  ******************************************************************************
+  * @attention
+  *
+  * The producer ring is single producer / single consumer with free running
+  * indices: one task writes with VENDOR_Write_HS(), the USB interrupt drains
+  * it. Every IN transfer takes the whole contiguous pending region (up to
+  * VENDOR_MAX_XFER_SIZE) so the core moves many packets per interrupt and
+  * the next transfer is chained from the completion callback.
+  *
+  * In source mode the ring is bypassed and a static buffer holding the byte
+  * sequence 0, 1, ... 255, 0, ... is replayed back to back; since its size is
+  * a multiple of 256 the host sees one continuous counter and can verify the
+  * stream without any framing.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_vendor_if.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Short critical section usable from tasks and from the USB interrupt */
+#define VENDOR_ENTER_CRITICAL()   uint32_t primask_ = __get_PRIMASK(); __disable_irq()
+#define VENDOR_EXIT_CRITICAL()    __set_PRIMASK(primask_)
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t VendorTxRing[VENDOR_TX_RING_SIZE];
+static uint8_t VendorPattern[VENDOR_PATTERN_SIZE];
+static uint32_t VendorRxPacket[VENDOR_DATA_HS_MAX_PACKET_SIZE / 4U];
+
+static struct
+{
+  uint8_t           ClassId;      /* composite class id, valid after Init */
+  __IO uint8_t      Active;       /* function configured by the host */
+  __IO uint8_t      Source;       /* replaying VendorPattern */
+  __IO uint32_t     TxHead;
+  __IO uint32_t     TxTail;
+  __IO uint32_t     TxInFlight;   /* ring bytes owned by the IN endpoint */
+  VENDOR_StatsTypeDef Stats;
+} Vendor;
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_VENDOR_IF
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_Variables USBD_VENDOR_IF_Exported_Variables
+  * @brief Public variables.
+  * @{
+  */
+extern USBD_HandleTypeDef hUsbDeviceHS;
+
+/* Bulk IN, bulk OUT */
+uint8_t VENDOR_EpAdd_HS[2] = { VENDOR_IN_EP, VENDOR_OUT_EP };
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Private_FunctionPrototypes USBD_VENDOR_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+static int8_t VENDOR_Init_HS(void);
+static int8_t VENDOR_DeInit_HS(void);
+static int8_t VENDOR_Control_HS(uint8_t cmd, uint8_t* pbuf, uint16_t length);
+static int8_t VENDOR_Receive_HS(uint8_t* pbuf, uint32_t *Len);
+static int8_t VENDOR_TransmitCplt_HS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
+static void   VENDOR_TxKick(void);
+/**
+  * @}
+  */
+
+USBD_VENDOR_ItfTypeDef USBD_Interface_fops_Vendor_HS =
+{
+  VENDOR_Init_HS,
+  VENDOR_DeInit_HS,
+  VENDOR_Control_HS,
+  VENDOR_Receive_HS,
+  VENDOR_TransmitCplt_HS
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Bind to the class instance and hand over the OUT packet buffer.
+  * @note   Called from USBD_VENDOR_Init() with pdev->classId set to this class.
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_Init_HS(void)
+{
+  for (uint32_t i = 0U; i < VENDOR_PATTERN_SIZE; i++)
+  {
+    VendorPattern[i] = (uint8_t)i;
+  }
+
+  Vendor.ClassId = (uint8_t)hUsbDeviceHS.classId;
+  Vendor.TxHead = 0U;
+  Vendor.TxTail = 0U;
+  Vendor.TxInFlight = 0U;
+  Vendor.Source = 0U;
+
+  USBD_VENDOR_SetTxBuffer(&hUsbDeviceHS, VendorTxRing, 0U, Vendor.ClassId);
+  USBD_VENDOR_SetRxBuffer(&hUsbDeviceHS, (uint8_t *)VendorRxPacket);
+  Vendor.Active = 1U;
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Detach when the host deconfigures the device.
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_DeInit_HS(void)
+{
+  Vendor.Active = 0U;
+  Vendor.Source = 0U;
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Interface recipient vendor requests.
+  * @param  cmd: bRequest
+  * @param  pbuf: setup packet for requests without data stage, data otherwise
+  * @param  length: data stage length, 0 when pbuf is the setup packet
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_Control_HS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
+{
+  USBD_SetupReqTypedef *req = (USBD_SetupReqTypedef *)(void *)pbuf;
+  VENDOR_StatsTypeDef stats;
+
+  switch (cmd)
+  {
+  case VENDOR_REQ_SET_SOURCE:
+    if (length == 0U)
+    {
+      Vendor.Source = (req->wValue != 0U) ? 1U : 0U;
+      VENDOR_TxKick();
+    }
+    break;
+
+  case VENDOR_REQ_GET_STATS:
+    stats = Vendor.Stats;
+    (void)USBD_memset(pbuf, 0, length);
+    (void)USBD_memcpy(pbuf, &stats, MIN(length, sizeof(stats)));
+    break;
+
+  case VENDOR_REQ_RESET_STATS:
+    (void)USBD_memset(&Vendor.Stats, 0, sizeof(Vendor.Stats));
+    break;
+
+  default:
+    break;
+  }
+
+  return (USBD_OK);
+}
+
+/**
+  * @brief  OUT sink: count the packet and re-arm immediately.
+  * @param  Buf: received packet
+  * @param  Len: received length
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_Receive_HS(uint8_t* Buf, uint32_t *Len)
+{
+  UNUSED(Buf);
+  Vendor.Stats.RxBytes += *Len;
+  Vendor.Stats.RxPackets++;
+  USBD_VENDOR_ReceivePacket(&hUsbDeviceHS);
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Release the completed transfer and chain the next one.
+  * @note   Runs in the USB interrupt.
+  * @param  Buf: transferred buffer
+  * @param  Len: transferred length
+  * @param  epnum: endpoint number
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_TransmitCplt_HS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+  UNUSED(Buf);
+  UNUSED(epnum);
+
+  Vendor.Stats.TxBytes += *Len;
+  Vendor.Stats.TxTransfers++;
+  if (Vendor.TxInFlight != 0U)
+  {
+    Vendor.TxTail += Vendor.TxInFlight;
+    Vendor.TxInFlight = 0U;
+  }
+  VENDOR_TxKick();
+  return (USBD_OK);
+}
+
+/**
+  * @brief  Start the next IN transfer if the endpoint is idle.
+  * @note   Safe to call from a task or from the USB interrupt.
+  * @retval None
+  */
+static void VENDOR_TxKick(void)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor;
+  uint32_t pending;
+  uint32_t offset;
+  uint32_t chunk;
+
+  VENDOR_ENTER_CRITICAL();
+  hvendor = (USBD_VENDOR_HandleTypeDef *)hUsbDeviceHS.pClassDataCmsit[Vendor.ClassId];
+  if ((Vendor.Active != 0U) && (hvendor != NULL) && (hvendor->TxState == 0U))
+  {
+    if (Vendor.Source != 0U)
+    {
+      USBD_VENDOR_SetTxBuffer(&hUsbDeviceHS, VendorPattern, VENDOR_PATTERN_SIZE, Vendor.ClassId);
+      (void)USBD_VENDOR_TransmitPacket(&hUsbDeviceHS, Vendor.ClassId);
+    }
+    else
+    {
+      pending = Vendor.TxHead - Vendor.TxTail;
+      if (pending != 0U)
+      {
+        offset = Vendor.TxTail & (VENDOR_TX_RING_SIZE - 1U);
+        chunk = MIN(pending, VENDOR_TX_RING_SIZE - offset);
+        chunk = MIN(chunk, VENDOR_MAX_XFER_SIZE);
+        Vendor.TxInFlight = chunk;
+        USBD_VENDOR_SetTxBuffer(&hUsbDeviceHS, &VendorTxRing[offset], chunk, Vendor.ClassId);
+        if (USBD_VENDOR_TransmitPacket(&hUsbDeviceHS, Vendor.ClassId) != USBD_OK)
+        {
+          Vendor.TxInFlight = 0U;
+        }
+      }
+    }
+  }
+  VENDOR_EXIT_CRITICAL();
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+  * @brief  Queue bytes for the host, never blocks.
+  * @param  Buf: data
+  * @param  Len: length
+  * @retval number of bytes queued; the rest is counted in TxDropped
+  */
+uint32_t VENDOR_Write_HS(const uint8_t *Buf, uint32_t Len)
+{
+  uint32_t head = Vendor.TxHead;
+  uint32_t space = VENDOR_TX_RING_SIZE - (head - Vendor.TxTail);
+  uint32_t n = MIN(Len, space);
+  uint32_t offset = head & (VENDOR_TX_RING_SIZE - 1U);
+  uint32_t first = MIN(n, VENDOR_TX_RING_SIZE - offset);
+
+  (void)USBD_memcpy(&VendorTxRing[offset], Buf, first);
+  (void)USBD_memcpy(VendorTxRing, &Buf[first], n - first);
+  __DMB();
+  Vendor.TxHead = head + n;
+  Vendor.Stats.TxDropped += Len - n;
+
+  VENDOR_TxKick();
+  return n;
+}
+
+/**
+  * @brief  Free space in the producer ring.
+  * @retval byte count
+  */
+uint32_t VENDOR_TxFree_HS(void)
+{
+  return VENDOR_TX_RING_SIZE - (Vendor.TxHead - Vendor.TxTail);
+}
+
+/**
+  * @brief  Snapshot of the traffic counters.
+  * @param  stats: destination
+  * @retval None
+  */
+void VENDOR_GetStats_HS(VENDOR_StatsTypeDef *stats)
+{
+  if (stats == NULL)
+  {
+    return;
+  }
+  VENDOR_ENTER_CRITICAL();
+  *stats = Vendor.Stats;
+  VENDOR_EXIT_CRITICAL();
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,107 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_vendor_if.h
+  * @brief          : Header for usbd_vendor_if.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * Application side of the vendor bulk function: a producer ring drained by
+  * deep multi-packet IN transfers, an OUT sink, and a pattern source used by
+  * the host throughput benchmark (Tools/usb-bench/vendor-bench.c).
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_VENDOR_IF_H__
+#define __USBD_VENDOR_IF_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_vendor.h"
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief For Usb device.
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_IF USBD_VENDOR_IF
+  * @brief Usb vendor bulk streaming module
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_Defines USBD_VENDOR_IF_Exported_Defines
+  * @brief Defines.
+  * @{
+  */
+/* Producer ring (must be a power of two) */
+#define VENDOR_TX_RING_SIZE       16384U
+/* Upper bound of one IN transfer, in bytes (PKTCNT is 10 bits wide) */
+#define VENDOR_MAX_XFER_SIZE      16384U
+/* Pattern buffer replayed in source mode, multiple of 256 */
+#define VENDOR_PATTERN_SIZE       4096U
+
+/* Interface recipient vendor requests */
+#define VENDOR_REQ_SET_SOURCE     0x01U  /* wValue 1: stream the test pattern, 0: stop */
+#define VENDOR_REQ_GET_STATS      0x02U  /* IN: VENDOR_StatsTypeDef */
+#define VENDOR_REQ_RESET_STATS    0x03U
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_Types USBD_VENDOR_IF_Exported_Types
+  * @brief Types.
+  * @{
+  */
+/**
+  * @brief Traffic counters, sent little endian by VENDOR_REQ_GET_STATS
+  */
+typedef struct
+{
+  uint32_t TxBytes;       /* bytes acknowledged by the host */
+  uint32_t TxTransfers;   /* completed IN transfers */
+  uint32_t TxDropped;     /* producer bytes refused, ring full */
+  uint32_t RxBytes;       /* bytes received on the OUT sink */
+  uint32_t RxPackets;
+} VENDOR_StatsTypeDef;
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_Variables USBD_VENDOR_IF_Exported_Variables
+  * @brief Public variables.
+  * @{
+  */
+extern USBD_VENDOR_ItfTypeDef USBD_Interface_fops_Vendor_HS;
+extern uint8_t VENDOR_EpAdd_HS[2];
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_FunctionsPrototype USBD_VENDOR_IF_Exported_FunctionsPrototype
+  * @brief Public functions declaration.
+  * @{
+  */
+uint32_t VENDOR_Write_HS(const uint8_t *Buf, uint32_t Len);
+uint32_t VENDOR_TxFree_HS(void);
+void     VENDOR_GetStats_HS(VENDOR_StatsTypeDef *stats);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_VENDOR_IF_H__ */
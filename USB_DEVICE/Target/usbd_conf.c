@@ -24,9 +24,13 @@
 #include "usbd_def.h"
 #include "usbd_core.h"
 #include "usbd_cdc.h"
+#include "usbd_msc.h"
+#include "usbd_vendor.h"
 
 /* USER CODE BEGIN Includes */
-
+#if (USBD_SOF_SYNC == 1U)
+#include "../../Applications/Sync/sof-sync.h"
+#endif /* USBD_SOF_SYNC */
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -35,7 +39,50 @@
 
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
-
+/* Total FIFO RAM of the OTG_HS core, in 32-bit words */
+#define USBD_FIFO_TOTAL_WORDS      1024U
+/* Smallest TX FIFO the core accepts for a 64 byte packet */
+#define USBD_FIFO_MIN_TX_WORDS     16U
+/* Number of IN endpoints backed by a TX FIFO (EP0 included) */
+#define USBD_FIFO_NUM_IN           9U
+
+/* Class handles of USBD_static_malloc, typed so each keeps its own alignment */
+static USBD_CDC_HandleTypeDef     USBD_CdcHandle[USBD_POOL_CDC_NUM];
+static USBD_MSC_BOT_HandleTypeDef USBD_MscHandle[USBD_POOL_MSC_NUM];
+static USBD_VENDOR_HandleTypeDef  USBD_VendorHandle[USBD_POOL_VENDOR_NUM];
+
+/* One pool per class type: the classes ask for sizeof(their handle), the
+   size picks the pool, a bit per handle tells which are taken */
+typedef struct
+{
+  uint8_t  *Mem;
+  uint32_t Used;          /* bit i: handle i taken */
+  USBD_StaticPoolStatsTypeDef Stats;
+} USBD_StaticPoolTypeDef;
+
+#define USBD_POOL(name, handles) \
+  { (uint8_t *)(handles), 0U, { (name), sizeof((handles)[0]), \
+    (uint8_t)(sizeof(handles) / sizeof((handles)[0])), 0U, 0U, 0U } }
+
+static USBD_StaticPoolTypeDef USBD_StaticPool[] =
+{
+  USBD_POOL("cdc", USBD_CdcHandle),
+  USBD_POOL("msc", USBD_MscHandle),
+  USBD_POOL("vendor", USBD_VendorHandle),
+};
+
+#define USBD_POOL_NUM  (sizeof(USBD_StaticPool) / sizeof(USBD_StaticPool[0]))
+
+_Static_assert((USBD_POOL_CDC_NUM <= 32U) && (USBD_POOL_MSC_NUM <= 32U) && (USBD_POOL_VENDOR_NUM <= 32U),
+               "one Used bit per handle");
+_Static_assert((sizeof(USBD_CDC_HandleTypeDef) != sizeof(USBD_MSC_BOT_HandleTypeDef)) &&
+               (sizeof(USBD_CDC_HandleTypeDef) != sizeof(USBD_VENDOR_HandleTypeDef)) &&
+               (sizeof(USBD_MSC_BOT_HandleTypeDef) != sizeof(USBD_VENDOR_HandleTypeDef)),
+               "the size of a request must tell its class type");
+
+/* A request no pool can serve is a configuration error: stop here instead
+   of letting a class run without its handle */
+#define USBD_POOL_ASSERT(expr)  do { if (!(expr)) { Error_Handler(); } } while (0)
 /* USER CODE END PV */
 
 PCD_HandleTypeDef hpcd_USB_OTG_HS;
@@ -56,6 +103,100 @@ USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
 /* Private functions ---------------------------------------------------------*/
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief  Split the FIFO RAM between the endpoints of all registered classes.
+  * @note   Must run after the last USBD_RegisterClassComposite() and before
+  *         USBD_Start(). The RX FIFO holds four max size OUT packets plus the
+  *         setup/status overhead required by the core, EP0 and interrupt IN
+  *         endpoints get the minimum and the bulk IN endpoints share the rest.
+  * @param  pdev: Device handle
+  * @retval USBD status
+  */
+USBD_StatusTypeDef USBD_LL_ConfigFifo(USBD_HandleTypeDef *pdev)
+{
+  PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+  uint16_t tx[USBD_FIFO_NUM_IN] = { 0U };
+  uint8_t  bulk[USBD_FIFO_NUM_IN] = { 0U };
+  uint32_t nbulk = 0U;
+  uint32_t nout = 0U;
+  uint32_t out_mps = USB_MAX_EP0_SIZE;
+  uint32_t used;
+  uint32_t rx;
+
+  tx[0] = USBD_FIFO_MIN_TX_WORDS;
+
+  for (uint32_t cls = 0U; cls < pdev->NumClasses; cls++)
+  {
+    for (uint32_t i = 0U; i < pdev->tclasslist[cls].NumEps; i++)
+    {
+      USBD_EPTypeDef *ep = &pdev->tclasslist[cls].Eps[i];
+      uint32_t num = (uint32_t)ep->add & 0x0FU;
+
+      if ((ep->is_used == 0U) || (num >= USBD_FIFO_NUM_IN))
+      {
+        continue;
+      }
+      if ((ep->add & 0x80U) == 0U)
+      {
+        nout++;
+        out_mps = MAX(out_mps, ep->size);
+      }
+      else if (ep->type == USBD_EP_TYPE_BULK)
+      {
+        bulk[num] = 1U;
+        nbulk++;
+      }
+      else
+      {
+        tx[num] = (uint16_t)MAX(USBD_FIFO_MIN_TX_WORDS, ((uint32_t)ep->size + 3U) / 4U);
+      }
+    }
+  }
+
+  /* 5 * control + 8 setup words, packets with their status word, 2 per OUT, global NAK */
+  rx = 13U + (4U * ((out_mps / 4U) + 1U)) + (2U * (nout + 1U)) + 1U;
+
+  used = rx;
+  for (uint32_t num = 0U; num < USBD_FIFO_NUM_IN; num++)
+  {
+    used += tx[num];
+  }
+  if (used > USBD_FIFO_TOTAL_WORDS)
+  {
+    return USBD_FAIL;
+  }
+
+  if (nbulk != 0U)
+  {
+    uint32_t share = (USBD_FIFO_TOTAL_WORDS - used) / nbulk;
+
+    if (share < USBD_FIFO_MIN_TX_WORDS)
+    {
+      return USBD_FAIL;
+    }
+    for (uint32_t num = 0U; num < USBD_FIFO_NUM_IN; num++)
+    {
+      if (bulk[num] != 0U)
+      {
+        tx[num] = (uint16_t)share;
+      }
+    }
+  }
+
+  /* TX FIFO offsets are cumulative, so every FIFO is written in order */
+  if (HAL_PCDEx_SetRxFiFo(hpcd, (uint16_t)rx) != HAL_OK)
+  {
+    return USBD_FAIL;
+  }
+  for (uint32_t num = 0U; num < USBD_FIFO_NUM_IN; num++)
+  {
+    if (HAL_PCDEx_SetTxFiFo(hpcd, (uint8_t)num, tx[num]) != HAL_OK)
+    {
+      return USBD_FAIL;
+    }
+  }
+  return USBD_OK;
+}
 /* USER CODE END 1 */
 
 /*******************************************************************************
@@ -171,6 +312,9 @@ static void PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
 void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_SOF_SYNC == 1U)
+  sof_sync_on_sof(hpcd->FrameNumber);
+#endif /* USBD_SOF_SYNC */
   USBD_LL_SOF((USBD_HandleTypeDef*)hpcd->pData);
 }
 
@@ -204,6 +348,9 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
 
   /* Reset Device. */
   USBD_LL_Reset((USBD_HandleTypeDef*)hpcd->pData);
+#if (USBD_SOF_SYNC == 1U)
+  sof_sync_reset();
+#endif /* USBD_SOF_SYNC */
 }
 
 /**
@@ -221,6 +368,9 @@ void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
   /* Inform USB library that core enters in suspend Mode. */
   USBD_LL_Suspend((USBD_HandleTypeDef*)hpcd->pData);
   __HAL_PCD_GATE_PHYCLOCK(hpcd);
+#if (USBD_SOF_SYNC == 1U)
+  sof_sync_reset();
+#endif /* USBD_SOF_SYNC */
   /* Enter in STOP mode. */
   /* USER CODE BEGIN 2 */
   if (hpcd->Init.low_power_enable)
@@ -329,7 +479,7 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   hpcd_USB_OTG_HS.Init.speed = PCD_SPEED_FULL;
   hpcd_USB_OTG_HS.Init.dma_enable = DISABLE;
   hpcd_USB_OTG_HS.Init.phy_itface = USB_OTG_EMBEDDED_PHY;
-  hpcd_USB_OTG_HS.Init.Sof_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.Sof_enable = ENABLE;
   hpcd_USB_OTG_HS.Init.low_power_enable = DISABLE;
   hpcd_USB_OTG_HS.Init.lpm_enable = DISABLE;
   hpcd_USB_OTG_HS.Init.vbus_sensing_enable = DISABLE;
@@ -356,9 +506,7 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   HAL_PCD_RegisterIsoInIncpltCallback(&hpcd_USB_OTG_HS, PCD_ISOINIncompleteCallback);
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
   /* USER CODE BEGIN TxRx_HS_Configuration */
-  HAL_PCDEx_SetRxFiFo(&hpcd_USB_OTG_HS, 0x200);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_HS, 0, 0x80);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_HS, 1, 0x174);
+  /* FIFOs are sized by USBD_LL_ConfigFifo() once every class is registered */
   /* USER CODE END TxRx_HS_Configuration */
   }
   return USBD_OK;
@@ -612,25 +760,85 @@ USBD_StatusTypeDef USBD_LL_SetTestMode(USBD_HandleTypeDef *pdev, uint8_t testmod
 }
 #endif /* USBD_HS_TESTMODE_ENABLE */
 /**
-  * @brief  Static single allocation.
-  * @param  size: Size of allocated memory
-  * @retval None
+  * @brief  Static allocation of a class handle from the pool of its type.
+  * @note   Asserts (Error_Handler) when no pool has handles of this size or
+  *         when the pool is exhausted: raise USBD_POOL_xxx_NUM in usbd_conf.h.
+  * @param  size: Size of allocated memory, sizeof the class handle
+  * @retval Pointer to a free handle
   */
 void *USBD_static_malloc(uint32_t size)
 {
-  UNUSED(size);
-  static uint32_t mem[(sizeof(USBD_CDC_HandleTypeDef)/4)+1];/* On 32-bit boundary */
-  return mem;
+  for (uint32_t i = 0U; i < USBD_POOL_NUM; i++)
+  {
+    USBD_StaticPoolTypeDef *pool = &USBD_StaticPool[i];
+    if (pool->Stats.Size != size)
+    {
+      continue;
+    }
+    for (uint32_t h = 0U; h < pool->Stats.Capacity; h++)
+    {
+      if ((pool->Used & (1UL << h)) == 0U)
+      {
+        pool->Used |= 1UL << h;
+        pool->Stats.InUse++;
+        pool->Stats.Allocs++;
+        if (pool->Stats.InUse > pool->Stats.Peak)
+        {
+          pool->Stats.Peak = pool->Stats.InUse;
+        }
+        return &pool->Mem[h * size];
+      }
+    }
+    USBD_POOL_ASSERT(0);  /* more instances of this class than reserved */
+    return NULL;
+  }
+  USBD_POOL_ASSERT(0);    /* a class type without a pool */
+  return NULL;
 }
 
 /**
-  * @brief  Dummy memory free
-  * @param  p: Pointer to allocated  memory address
+  * @brief  Give a handle back to its pool.
+  * @param  p: Pointer returned by USBD_static_malloc, NULL is ignored
   * @retval None
   */
 void USBD_static_free(void *p)
 {
-  UNUSED(p);
+  if (p == NULL)
+  {
+    return;
+  }
+  for (uint32_t i = 0U; i < USBD_POOL_NUM; i++)
+  {
+    USBD_StaticPoolTypeDef *pool = &USBD_StaticPool[i];
+    uint8_t *mem = (uint8_t *)p;
+    if ((mem >= pool->Mem) && (mem < &pool->Mem[pool->Stats.Capacity * pool->Stats.Size]))
+    {
+      uint32_t h = (uint32_t)(mem - pool->Mem) / pool->Stats.Size;
+      USBD_POOL_ASSERT((pool->Used & (1UL << h)) != 0U);  /* double free */
+      pool->Used &= ~(1UL << h);
+      pool->Stats.InUse--;
+      return;
+    }
+  }
+  USBD_POOL_ASSERT(0);    /* not a class handle */
+}
+
+/**
+  * @brief  Accounting of the class handle pools.
+  * @param  stats: destination, one entry per pool
+  * @param  max: entries at stats
+  * @retval Number of pools, entries beyond max are not written
+  */
+uint32_t USBD_static_pool_stats(USBD_StaticPoolStatsTypeDef *stats, uint32_t max)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  for (uint32_t i = 0U; (i < USBD_POOL_NUM) && (i < max) && (stats != NULL); i++)
+  {
+    stats[i] = USBD_StaticPool[i].Stats;
+  }
+  __set_PRIMASK(primask);
+  return USBD_POOL_NUM;
 }
 
 /**
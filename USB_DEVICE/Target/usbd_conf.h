@@ -63,7 +63,7 @@
   */
 
 /*---------- -----------*/
-#define USBD_MAX_NUM_INTERFACES     1U
+#define USBD_MAX_NUM_INTERFACES     6U
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     1U
 /*---------- -----------*/
@@ -80,6 +80,28 @@
 #define DEVICE_FS 		0
 #define DEVICE_HS 		1
 
+/****************************************/
+/* Composite device: two CDC ACM functions (shell + bulk data), a vendor  */
+/* bulk function for raw streaming and a mass storage function            */
+#define USE_USBD_COMPOSITE
+#define USBD_MAX_SUPPORTED_CLASS       4U
+#define USBD_MAX_CLASS_ENDPOINTS       3U
+#define USBD_MAX_CLASS_INTERFACES      2U
+#define USBD_CMPSIT_ACTIVATE_CDC       1U
+#define USBD_CMPSIT_ACTIVATE_VENDOR    1U
+#define USBD_CMPSIT_ACTIVATE_MSC       1U
+
+/* Class handles USBD_static_malloc can serve, instances per class type */
+#define USBD_POOL_CDC_NUM              2U
+#define USBD_POOL_MSC_NUM              1U
+#define USBD_POOL_VENDOR_NUM           1U
+
+/* SOF interrupts feed the host clock synchronisation (Applications/Sync) */
+#define USBD_SOF_SYNC                  1U
+
+/* Binary fast frames are cut out of the shell port stream (Applications/FastPath) */
+#define USBD_FAST_PATH                 1U
+
 /**
   * @}
   */
@@ -140,6 +162,17 @@
   * @{
   */
 
+/* Accounting of one class handle pool of USBD_static_malloc */
+typedef struct
+{
+  const char *Name;       /* class type */
+  uint32_t   Size;        /* bytes of one handle */
+  uint8_t    Capacity;    /* handles reserved at compile time */
+  uint8_t    InUse;
+  uint8_t    Peak;
+  uint32_t   Allocs;
+} USBD_StaticPoolStatsTypeDef;
+
 /**
   * @}
   */
@@ -152,6 +185,7 @@
 /* Exported functions -------------------------------------------------------*/
 void *USBD_static_malloc(uint32_t size);
 void USBD_static_free(void *p);
+uint32_t USBD_static_pool_stats(USBD_StaticPoolStatsTypeDef *stats, uint32_t max);
 
 /**
   * @}